@@ -31,6 +31,9 @@
 #include "host/ble_hs.h"
 #include "services/gap/ble_svc_gap.h"
 #include "mesh/glue.h"
+#if MYNEWT_VAL(BLE_MESH_SETTINGS)
+#include "config/config.h"
+#endif
 
 #define BT_DBG_ENABLED (MYNEWT_VAL(BLE_MESH_DEBUG))
 
@@ -400,6 +403,11 @@ blemesh_on_sync(void)
         return;
     }
 
+#if MYNEWT_VAL(BLE_MESH_SETTINGS)
+    /* Restores a previously provisioned node */
+    conf_load();
+#endif
+
 #if (MYNEWT_VAL(BLE_MESH_SHELL))
     shell_register_default_module("mesh");
 #endif
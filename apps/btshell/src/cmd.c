@@ -27,6 +27,7 @@
 #include "nimble/ble.h"
 #include "nimble/nimble_opt.h"
 #include "nimble/hci_common.h"
+#include "nimble/ble_aes.h"
 #include "host/ble_gap.h"
 #include "host/ble_hs_adv.h"
 #include "host/ble_sm.h"
@@ -3045,6 +3046,155 @@ cmd_phy_read(int argc, char **argv)
     return 0;
 }
 
+/*****************************************************************************
+ * $adv-parse-bench                                                          *
+ *****************************************************************************/
+
+/* A typical advertisement: flags, 16-bit UUIDs, name and manufacturer data. */
+static uint8_t cmd_adv_parse_bench_data[] = {
+    0x02, BLE_HS_ADV_TYPE_FLAGS, BLE_HS_ADV_F_DISC_GEN,
+    0x05, BLE_HS_ADV_TYPE_COMP_UUIDS16, 0x0d, 0x18, 0x0f, 0x18,
+    0x08, BLE_HS_ADV_TYPE_COMP_NAME, 'n', 'i', 'm', 'b', 'l', 'e', '!',
+    0x07, BLE_HS_ADV_TYPE_MFG_DATA, 0x59, 0x00, 0x01, 0x02, 0x03, 0x04,
+};
+
+static int
+cmd_adv_parse_bench(int argc, char **argv)
+{
+    struct ble_hs_adv_fields fields;
+    struct ble_hs_adv_idx idx;
+    uint32_t fields_usecs;
+    uint32_t idx_usecs;
+    uint32_t start;
+    uint32_t count;
+    uint32_t i;
+    int matches;
+    int j;
+    int rc;
+
+    rc = parse_arg_all(argc - 1, argv + 1);
+    if (rc != 0) {
+        return rc;
+    }
+
+    count = parse_arg_uint32_dflt("count", 10000, &rc);
+    if (rc != 0 || count == 0) {
+        console_printf("invalid 'count' parameter\n");
+        return EINVAL;
+    }
+
+    /* Look for a service UUID and a company ID in each report. */
+    matches = 0;
+    start = os_cputime_get32();
+    for (i = 0; i < count; i++) {
+        rc = ble_hs_adv_parse_fields(&fields, cmd_adv_parse_bench_data,
+                                     sizeof cmd_adv_parse_bench_data);
+        if (rc != 0) {
+            continue;
+        }
+
+        for (j = 0; j < fields.num_uuids16; j++) {
+            if (fields.uuids16[j].value == 0x180f) {
+                matches++;
+                break;
+            }
+        }
+
+        if (fields.mfg_data_len >= 2 && get_le16(fields.mfg_data) == 0x0059) {
+            matches++;
+        }
+    }
+    fields_usecs = os_cputime_ticks_to_usecs(os_cputime_get32() - start);
+
+    start = os_cputime_get32();
+    for (i = 0; i < count; i++) {
+        rc = ble_hs_adv_idx_build(&idx, cmd_adv_parse_bench_data,
+                                  sizeof cmd_adv_parse_bench_data);
+        if (rc != 0) {
+            continue;
+        }
+
+        matches -= ble_hs_adv_idx_has_uuid(&idx, BLE_UUID16_DECLARE(0x180f));
+        matches -= ble_hs_adv_idx_mfg_match(&idx, 0x0059, NULL, 0);
+    }
+    idx_usecs = os_cputime_ticks_to_usecs(os_cputime_get32() - start);
+
+    console_printf("reports=%" PRIu32 " parse_fields=%" PRIu32 "us "
+                   "idx=%" PRIu32 "us%s\n", count, fields_usecs, idx_usecs,
+                   matches == 0 ? "" : " (results differ)");
+
+    return 0;
+}
+
+#if MYNEWT_VAL(BLE_AES)
+/*****************************************************************************
+ * $aes-bench                                                                *
+ *****************************************************************************/
+
+static int
+cmd_aes_bench(int argc, char **argv)
+{
+    struct ble_aes_cmac_key cmac_key;
+    struct ble_aes_cmac cmac;
+    struct ble_aes_key key;
+    uint8_t block[16] = { 0 };
+    uint8_t msg[64] = { 0 };
+    uint32_t enc_usecs;
+    uint32_t cmac_usecs;
+    uint32_t start;
+    uint32_t count;
+    uint32_t i;
+    int backend;
+    int prev;
+    int rc;
+
+    rc = parse_arg_all(argc - 1, argv + 1);
+    if (rc != 0) {
+        return rc;
+    }
+
+    count = parse_arg_uint32_dflt("count", 10000, &rc);
+    if (rc != 0 || count == 0) {
+        console_printf("invalid 'count' parameter\n");
+        return EINVAL;
+    }
+
+    /* Keys in use stay valid as long as the backend is restored. */
+    prev = ble_aes_backend();
+
+    for (backend = 0; backend < BLE_AES_BACKEND_CNT; backend++) {
+        if (ble_aes_backend_select(backend) != 0) {
+            continue;
+        }
+
+        ble_aes_set_key(&key, block);
+        start = os_cputime_get32();
+        for (i = 0; i < count; i++) {
+            ble_aes_encrypt(&key, block, block);
+        }
+        enc_usecs = os_cputime_ticks_to_usecs(os_cputime_get32() - start);
+
+        ble_aes_cmac_set_key(&cmac_key, block);
+        start = os_cputime_get32();
+        for (i = 0; i < count; i++) {
+            ble_aes_cmac_init(&cmac, &cmac_key);
+            ble_aes_cmac_update(&cmac, msg, sizeof msg);
+            ble_aes_cmac_final(&cmac, msg);
+        }
+        cmac_usecs = os_cputime_ticks_to_usecs(os_cputime_get32() - start);
+
+        console_printf("%s: blocks=%" PRIu32 " encrypt=%" PRIu32 "us "
+                       "cmac(64)=%" PRIu32 "us\n",
+                       ble_aes_backend_name(backend), count, enc_usecs,
+                       cmac_usecs);
+    }
+
+    ble_aes_backend_select(prev);
+
+    return 0;
+}
+#endif
+
 #if MYNEWT_VAL(SHELL_CMD_HELP)
 static const struct shell_param phy_read_params[] = {
     {"conn", "connection handle, usage: =<UINT16>"},
@@ -3057,6 +3207,31 @@ static const struct shell_cmd_help phy_read_help = {
     .params = phy_read_params,
 };
 
+static const struct shell_param adv_parse_bench_params[] = {
+    {"count", "number of reports to parse, usage: =[UINT32], default: 10000"},
+    {NULL, NULL}
+};
+
+static const struct shell_cmd_help adv_parse_bench_help = {
+    .summary = "compare advertising data parsers",
+    .usage = NULL,
+    .params = adv_parse_bench_params,
+};
+
+#if MYNEWT_VAL(BLE_AES)
+static const struct shell_param aes_bench_params[] = {
+    {"count", "number of blocks and MACs per backend, usage: =[UINT32], "
+              "default: 10000"},
+    {NULL, NULL}
+};
+
+static const struct shell_cmd_help aes_bench_help = {
+    .summary = "compare AES backends",
+    .usage = NULL,
+    .params = aes_bench_params,
+};
+#endif
+
 /*****************************************************************************
  * $gatt-discover                                                            *
  *****************************************************************************/
@@ -3752,6 +3927,22 @@ static const struct shell_cmd btshell_commands[] = {
         .help = &phy_read_help,
 #endif
     },
+    {
+        .sc_cmd = "adv-parse-bench",
+        .sc_cmd_func = cmd_adv_parse_bench,
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+        .help = &adv_parse_bench_help,
+#endif
+    },
+#if MYNEWT_VAL(BLE_AES)
+    {
+        .sc_cmd = "aes-bench",
+        .sc_cmd_func = cmd_aes_bench,
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+        .help = &aes_bench_help,
+#endif
+    },
+#endif
     { NULL, NULL, NULL },
 };
 
@@ -180,6 +180,7 @@ STATS_SECT_START(ble_ll_stats)
     STATS_SECT_ENTRY(adv_drop_event)
     STATS_SECT_ENTRY(sched_state_conn_errs)
     STATS_SECT_ENTRY(sched_state_adv_errs)
+    STATS_SECT_ENTRY(sched_state_sync_errs)
     STATS_SECT_ENTRY(scan_starts)
     STATS_SECT_ENTRY(scan_stops)
     STATS_SECT_ENTRY(scan_req_txf)
@@ -199,6 +200,7 @@ STATS_SECT_START(ble_ll_stats)
     STATS_SECT_ENTRY(adv_evt_dropped)
     STATS_SECT_ENTRY(scan_timer_stopped)
     STATS_SECT_ENTRY(scan_timer_restarted)
+    STATS_SECT_ENTRY(scan_rpt_filtered)
 STATS_SECT_END
 extern STATS_SECT_DECL(ble_ll_stats) ble_ll_stats;
 
@@ -209,6 +211,7 @@ extern STATS_SECT_DECL(ble_ll_stats) ble_ll_stats;
 #define BLE_LL_STATE_INITIATING     (3)
 #define BLE_LL_STATE_CONNECTION     (4)
 #define BLE_LL_STATE_DTM            (5)
+#define BLE_LL_STATE_SYNC           (6)
 
 /* LL Features */
 #define BLE_LL_FEAT_LE_ENCRYPTION    (0x00000001)
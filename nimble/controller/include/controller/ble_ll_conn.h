@@ -125,6 +125,7 @@ union ble_ll_conn_sm_flags {
         uint32_t aux_conn_req: 1;
         uint32_t rxd_features:1;
         uint32_t pending_hci_rd_features:1;
+        uint32_t ce_truncated:1;
     } cfbit;
     uint32_t conn_flags;
 } __attribute__((packed));
@@ -255,6 +256,11 @@ struct ble_ll_conn_sm
     uint16_t supervision_tmo;
     uint16_t min_ce_len;
     uint16_t max_ce_len;
+    uint16_t ce_len_slots;          /* Reserved connection event length */
+    uint8_t ce_short_cnt;           /* Consecutive short connection events */
+    uint32_t ce_last_end_time;      /* cputime at which last event ended */
+    uint32_t ce_truncated_cnt;      /* Events cut short with data pending */
+    uint32_t ce_extended_cnt;       /* Events that overran reserved length */
     uint16_t tx_win_off;
     uint32_t anchor_point;
     uint8_t anchor_point_usecs;     /* XXX: can this be uint8_t ?*/
@@ -164,6 +164,13 @@ int ble_ll_scan_set_enable(uint8_t *cmd, uint8_t ext);
 int ble_ll_set_ext_scan_params(uint8_t *cmd);
 #endif
 
+#if MYNEWT_VAL(BLE_LL_SCAN_ADV_FILT_NUM) > 0
+/* Advertising report content filters (vendor specific) */
+int ble_ll_scan_adv_filt_enable(uint8_t *cmd);
+int ble_ll_scan_adv_filt_add(uint8_t *cmd, uint8_t len);
+int ble_ll_scan_adv_filt_clear(void);
+#endif
+
 /*--- Controller Internal API ---*/
 /* Initialize the scanner */
 void ble_ll_scan_init(void);
@@ -74,6 +74,27 @@ extern uint8_t g_ble_ll_sched_offset_ticks;
 #define BLE_LL_SCHED_TYPE_CONN      (3)
 #define BLE_LL_SCHED_TYPE_AUX_SCAN  (4)
 #define BLE_LL_SCHED_TYPE_DTM       (5)
+#define BLE_LL_SCHED_TYPE_PERIODIC  (6)
+#define BLE_LL_SCHED_TYPE_SYNC      (7)
+
+#if MYNEWT_VAL(BLE_LL_SCHED_STATS)
+/*
+ * Schedule statistics, kept per schedule item type. Late starts are counted
+ * in a histogram; the upper bound of bucket n is 30 << n usecs and the last
+ * bucket counts everything later than that.
+ */
+#define BLE_LL_SCHED_STATS_TYPES                (BLE_LL_SCHED_TYPE_SYNC + 1)
+#define BLE_LL_SCHED_STATS_LATE_BUCKETS         (7)
+#define BLE_LL_SCHED_STATS_LATE_BUCKET_USECS    (30)
+
+struct ble_ll_sched_stats
+{
+    uint32_t executed;
+    uint32_t rescheduled;
+    uint32_t dropped;
+    uint32_t late[BLE_LL_SCHED_STATS_LATE_BUCKETS];
+};
+#endif
 
 /* Return values for schedule callback. */
 #define BLE_LL_SCHED_STATE_RUNNING  (0)
@@ -203,6 +224,21 @@ void ble_ll_sched_rfclk_chk_restart(void);
 int ble_ll_sched_dtm(struct ble_ll_sched_item *sch);
 #endif
 
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+/*
+ * Schedule a periodic advertising or periodic sync event. The event is not
+ * moved; if it overlaps anything already scheduled it is not inserted and
+ * -1 is returned.
+ */
+int ble_ll_sched_periodic(struct ble_ll_sched_item *sch);
+#endif
+
+#if MYNEWT_VAL(BLE_LL_SCHED_STATS)
+/* Read (and optionally reset) schedule statistics of an item type */
+int ble_ll_sched_stats_get(uint8_t sched_type, struct ble_ll_sched_stats *stats,
+                           int reset);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
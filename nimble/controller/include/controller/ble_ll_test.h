@@ -27,6 +27,8 @@ extern "C" {
 #endif
 
 int ble_ll_csa2_test_all(void);
+int ble_ll_conn_test_all(void);
+int ble_ll_sync_test_all(void);
 
 #ifdef __cplusplus
 }
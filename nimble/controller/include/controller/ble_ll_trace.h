@@ -20,6 +20,8 @@
 #ifndef H_BLE_LL_TRACE_
 #define H_BLE_LL_TRACE_
 
+#include <stdint.h>
+#include "syscfg/syscfg.h"
 #include "os/os_trace_api.h"
 
 #ifdef __cplusplus
@@ -38,29 +40,73 @@ extern "C" {
 #define BLE_LL_TRACE_ID_CONN_RX                 9
 #define BLE_LL_TRACE_ID_ADV_TXDONE              10
 #define BLE_LL_TRACE_ID_ADV_HALT                11
+#define BLE_LL_TRACE_ID_SCHED_EXEC              12
+#define BLE_LL_TRACE_ID_SCHED_RESCHED           13
+#define BLE_LL_TRACE_ID_SCHED_DROP              14
 
-#if MYNEWT_VAL(BLE_LL_SYSVIEW)
+#define BLE_LL_TRACE_ID_CNT                     15
+
+#define BLE_LL_TRACE_RING   (MYNEWT_VAL(BLE_LL_TRACE_RING_SIZE) > 0)
+
+/*
+ * Size of a trace ring record as read out over HCI: cputime (4 bytes),
+ * trace id (1 byte) and three parameters (4 bytes each), all little endian.
+ */
+#define BLE_LL_TRACE_RING_REC_LEN               (17)
 
+#if MYNEWT_VAL(BLE_LL_SYSVIEW)
 extern uint32_t ble_ll_trace_off;
+#endif
+
+#if BLE_LL_TRACE_RING
+void ble_ll_trace_ring_add(unsigned id, uint32_t p1, uint32_t p2, uint32_t p3);
+
+/*
+ * Reads (and removes) the oldest records from the trace ring. Up to max_recs
+ * records are written to dst in their HCI representation. The number of
+ * records which were overwritten before they could be read is returned in
+ * lost and reset.
+ *
+ * @return int The number of records written to dst.
+ */
+int ble_ll_trace_ring_read(uint8_t *dst, int max_recs, uint32_t *lost);
+#endif
+
+#if MYNEWT_VAL(BLE_LL_SYSVIEW) || BLE_LL_TRACE_RING
 
 void ble_ll_trace_init(void);
 
 static inline void
 ble_ll_trace_u32(unsigned id, uint32_t p1)
 {
+#if MYNEWT_VAL(BLE_LL_SYSVIEW)
     os_trace_api_u32(ble_ll_trace_off + id, p1);
+#endif
+#if BLE_LL_TRACE_RING
+    ble_ll_trace_ring_add(id, p1, 0, 0);
+#endif
 }
 
 static inline void
 ble_ll_trace_u32x2(unsigned id, uint32_t p1, uint32_t p2)
 {
+#if MYNEWT_VAL(BLE_LL_SYSVIEW)
     os_trace_api_u32x2(ble_ll_trace_off + id, p1, p2);
+#endif
+#if BLE_LL_TRACE_RING
+    ble_ll_trace_ring_add(id, p1, p2, 0);
+#endif
 }
 
 static inline void
 ble_ll_trace_u32x3(unsigned id, uint32_t p1, uint32_t p2, uint32_t p3)
 {
+#if MYNEWT_VAL(BLE_LL_SYSVIEW)
     os_trace_api_u32x3(ble_ll_trace_off + id, p1, p2, p3);
+#endif
+#if BLE_LL_TRACE_RING
+    ble_ll_trace_ring_add(id, p1, p2, p3);
+#endif
 }
 
 #else
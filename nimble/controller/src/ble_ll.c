@@ -48,6 +48,10 @@
 #include "ble_ll_dtm_priv.h"
 #endif
 
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+#include "ble_ll_sync_priv.h"
+#endif
+
 /* XXX:
  *
  * 1) use the sanity task!
@@ -185,6 +189,7 @@ STATS_NAME_START(ble_ll_stats)
     STATS_NAME(ble_ll_stats, adv_drop_event)
     STATS_NAME(ble_ll_stats, sched_state_conn_errs)
     STATS_NAME(ble_ll_stats, sched_state_adv_errs)
+    STATS_NAME(ble_ll_stats, sched_state_sync_errs)
     STATS_NAME(ble_ll_stats, scan_starts)
     STATS_NAME(ble_ll_stats, scan_stops)
     STATS_NAME(ble_ll_stats, scan_req_txf)
@@ -204,6 +209,7 @@ STATS_NAME_START(ble_ll_stats)
     STATS_NAME(ble_ll_stats, adv_evt_dropped)
     STATS_NAME(ble_ll_stats, scan_timer_stopped)
     STATS_NAME(ble_ll_stats, scan_timer_restarted)
+    STATS_NAME(ble_ll_stats, scan_rpt_filtered)
 STATS_NAME_END(ble_ll_stats)
 
 static void ble_ll_event_rx_pkt(struct ble_npl_event *ev);
@@ -564,6 +570,11 @@ ble_ll_wfr_timer_exp(void *arg)
         case BLE_LL_STATE_DTM:
             ble_ll_dtm_wfr_timer_exp();
             break;
+#endif
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+        case BLE_LL_STATE_SYNC:
+            ble_ll_sync_wfr_timer_exp();
+            break;
 #endif
         default:
             break;
@@ -736,6 +747,11 @@ ble_ll_rx_pkt_in(void)
         case BLE_LL_STATE_DTM:
             ble_ll_dtm_rx_pkt_in(m, ble_hdr);
             break;
+#endif
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+        case BLE_LL_STATE_SYNC:
+            ble_ll_sync_rx_pkt_in(m, ble_hdr);
+            break;
 #endif
         default:
             /* Any other state should never occur */
@@ -867,6 +883,11 @@ ble_ll_rx_start(uint8_t *rxbuf, uint8_t chan, struct ble_mbuf_hdr *rxhdr)
     case BLE_LL_STATE_DTM:
         rc = ble_ll_dtm_rx_isr_start(rxhdr, ble_phy_access_addr_get());
         break;
+#endif
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+    case BLE_LL_STATE_SYNC:
+        rc = ble_ll_sync_rx_isr_start(pdu_type, rxhdr);
+        break;
 #endif
     default:
         /* Should not be in this state! */
@@ -923,6 +944,13 @@ ble_ll_rx_end(uint8_t *rxbuf, struct ble_mbuf_hdr *rxhdr)
         return rc;
     }
 
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+    if (BLE_MBUF_HDR_RX_STATE(rxhdr) == BLE_LL_STATE_SYNC) {
+        rc = ble_ll_sync_rx_isr_end(rxbuf, rxhdr);
+        return rc;
+    }
+#endif
+
     /* If the CRC checks, make sure lengths check! */
     badpkt = 0;
     if (crcok) {
@@ -1251,6 +1279,11 @@ ble_ll_reset(void)
     ble_ll_dtm_reset();
 #endif
 
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+    /* Terminate all periodic advertising syncs */
+    ble_ll_sync_reset();
+#endif
+
     /* FLush all packets from Link layer queues */
     ble_ll_flush_pkt_queue(&g_ble_ll_data.ll_tx_pkt_q);
     ble_ll_flush_pkt_queue(&g_ble_ll_data.ll_rx_pkt_q);
@@ -1487,6 +1520,11 @@ ble_ll_init(void)
     /* Initialize a scanner */
     ble_ll_scan_init();
 
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+    /* Initialize periodic advertising sync */
+    ble_ll_sync_init();
+#endif
+
     /* Initialize the connection module */
     ble_ll_conn_module_init();
 
@@ -1519,6 +1557,10 @@ ble_ll_init(void)
     features |= BLE_LL_FEAT_EXT_ADV;
 #endif
 
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+    features |= BLE_LL_FEAT_PERIODIC_ADV;
+#endif
+
 #if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_CSA2) == 1)
     /* CSA2 */
     features |= BLE_LL_FEAT_CSA2;
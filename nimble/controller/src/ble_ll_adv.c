@@ -126,6 +126,30 @@ struct ble_ll_adv_sm
     uint8_t pri_phy;
     uint8_t sec_phy;
 #endif
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+    uint8_t periodic_adv_configured : 1;
+    uint8_t periodic_adv_enabled : 1;
+    uint8_t periodic_adv_active : 1;
+    uint8_t periodic_adv_data_incomplete : 1;
+    uint8_t periodic_chan;
+    uint8_t periodic_num_used_chans;
+    uint8_t periodic_chanmap[BLE_LL_CONN_CHMAP_LEN];
+    uint8_t periodic_adv_itvl_rem_usec;
+    uint8_t periodic_adv_event_start_time_remainder;
+    uint16_t periodic_adv_itvl_min;
+    uint16_t periodic_adv_itvl_max;
+    uint16_t periodic_adv_props;
+    uint16_t periodic_channel_id;
+    uint16_t periodic_event_cntr;
+    uint32_t periodic_access_addr;
+    uint32_t periodic_crcinit;
+    uint32_t periodic_adv_itvl_ticks;
+    uint32_t periodic_adv_event_start_time;
+    struct os_mbuf *periodic_adv_data;
+    struct os_mbuf *periodic_new_data;
+    struct ble_ll_sched_item periodic_sch;
+    struct ble_npl_event adv_periodic_txdone_ev;
+#endif
 };
 
 #define BLE_LL_ADV_SM_FLAG_TX_ADD               0x0001
@@ -181,6 +205,22 @@ ble_ll_adv_active_chanset_set_sec(struct ble_ll_adv_sm *advsm)
     advsm->flags |= 0x20;
 }
 
+static inline int
+ble_ll_adv_active_chanset_is_periodic(struct ble_ll_adv_sm *advsm)
+{
+    return (advsm->flags & BLE_LL_ADV_SM_FLAG_ACTIVE_CHANSET_MASK) == 0x30;
+}
+
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+static inline void
+ble_ll_adv_active_chanset_set_periodic(struct ble_ll_adv_sm *advsm)
+{
+    assert((advsm->flags & BLE_LL_ADV_SM_FLAG_ACTIVE_CHANSET_MASK) == 0);
+    advsm->flags &= ~BLE_LL_ADV_SM_FLAG_ACTIVE_CHANSET_MASK;
+    advsm->flags |= 0x30;
+}
+#endif
+
 /* The advertising state machine global object */
 struct ble_ll_adv_sm g_ble_ll_adv_sm[BLE_ADV_INSTANCES];
 struct ble_ll_adv_sm *g_ble_ll_cur_adv_sm;
@@ -414,6 +454,83 @@ ble_ll_adv_put_aux_ptr(struct ble_ll_adv_sm *advsm, uint32_t offset,
     dptr[2] = ((offset >> 8) & 0x0000001f) | (advsm->sec_phy - 1) << 5; //TODO;
 }
 
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+static void
+ble_ll_adv_periodic_advance(struct ble_ll_adv_sm *advsm, uint32_t *start,
+                            uint8_t *remainder, uint16_t *event_cntr)
+{
+    *start += advsm->periodic_adv_itvl_ticks;
+    *remainder += advsm->periodic_adv_itvl_rem_usec;
+    if (*remainder >= 31) {
+        *remainder -= 31;
+        *start += 1;
+    }
+    *event_cntr += 1;
+}
+
+/**
+ * Writes the SyncInfo field pointing at the first periodic advertising event
+ * which starts after the PDU transmitted at 'pdu_start'.
+ */
+static void
+ble_ll_adv_put_syncinfo(struct ble_ll_adv_sm *advsm, uint32_t pdu_start,
+                        uint8_t *dptr)
+{
+    uint32_t anchor;
+    uint32_t offset;
+    uint16_t event_cntr;
+    uint8_t remainder;
+    uint8_t units;
+    uint8_t adjust;
+
+    memset(dptr, 0, BLE_LL_EXT_ADV_SYNC_INFO_SIZE);
+
+    /* Offset of 0 means SyncInfo is not valid */
+    if (!advsm->periodic_adv_active) {
+        return;
+    }
+
+    anchor = advsm->periodic_adv_event_start_time;
+    remainder = advsm->periodic_adv_event_start_time_remainder;
+    event_cntr = advsm->periodic_event_cntr;
+
+    while ((int32_t)(anchor - pdu_start) <= 0) {
+        ble_ll_adv_periodic_advance(advsm, &anchor, &remainder, &event_cntr);
+    }
+
+    offset = os_cputime_ticks_to_usecs(anchor - pdu_start) + remainder;
+
+    adjust = 0;
+    if (offset >= 2457600) {
+        adjust = 1;
+        offset -= 2457600;
+    }
+
+    units = 0;
+    if (offset > 245700) {
+        units = 1;
+        offset = offset / 300;
+    } else {
+        offset = offset / 30;
+    }
+
+    if (offset > 0x1fff) {
+        /* Too far ahead to be represented, leave SyncInfo invalid */
+        return;
+    }
+
+    put_le16(&dptr[0], offset | (units << 13) | (adjust << 14));
+    put_le16(&dptr[2], advsm->periodic_adv_itvl_max);
+    memcpy(&dptr[4], advsm->periodic_chanmap, BLE_LL_CONN_CHMAP_LEN);
+    dptr[8] |= MYNEWT_VAL(BLE_LL_MASTER_SCA) << 5;
+    put_le32(&dptr[9], advsm->periodic_access_addr);
+    dptr[13] = advsm->periodic_crcinit & 0xff;
+    dptr[14] = (advsm->periodic_crcinit >> 8) & 0xff;
+    dptr[15] = (advsm->periodic_crcinit >> 16) & 0xff;
+    put_le16(&dptr[16], event_cntr);
+}
+#endif
+
 /**
  * Create the advertising PDU
  */
@@ -564,6 +681,13 @@ ble_ll_adv_aux_pdu_make(uint8_t *dptr, void *pducb_arg, uint8_t *hdr_byte)
         dptr += BLE_LL_EXT_ADV_AUX_PTR_SIZE;
     }
 
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+    if (aux->ext_hdr & (1 << BLE_LL_EXT_ADV_SYNC_INFO_BIT)) {
+        ble_ll_adv_put_syncinfo(advsm, aux->start_time, dptr);
+        dptr += BLE_LL_EXT_ADV_SYNC_INFO_SIZE;
+    }
+#endif
+
     if (aux->ext_hdr & (1 << BLE_LL_EXT_ADV_TX_POWER_BIT)) {
         dptr[0] = advsm->adv_txpwr;
         dptr += BLE_LL_EXT_ADV_TX_POWER_SIZE;
@@ -801,6 +925,11 @@ ble_ll_adv_tx_done(void *arg)
         ble_npl_eventq_put(&g_ble_ll_data.ll_evq, &advsm->adv_txdone_ev);
     } else if (ble_ll_adv_active_chanset_is_sec(advsm)) {
         ble_npl_eventq_put(&g_ble_ll_data.ll_evq, &advsm->adv_sec_txdone_ev);
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+    } else if (ble_ll_adv_active_chanset_is_periodic(advsm)) {
+        ble_npl_eventq_put(&g_ble_ll_data.ll_evq,
+                           &advsm->adv_periodic_txdone_ev);
+#endif
     } else {
         assert(0);
     }
@@ -1138,6 +1267,14 @@ ble_ll_adv_aux_calculate(struct ble_ll_adv_sm *advsm,
         hdr_len += BLE_LL_EXT_ADV_TARGETA_SIZE;
     }
 
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+    /* SyncInfo for 1st PDU in chain if periodic advertising is running */
+    if ((aux_data_offset == 0) && advsm->periodic_adv_active) {
+        aux->ext_hdr |= (1 << BLE_LL_EXT_ADV_SYNC_INFO_BIT);
+        hdr_len += BLE_LL_EXT_ADV_SYNC_INFO_SIZE;
+    }
+#endif
+
     /* TxPower if configured */
     if (advsm->props & BLE_HCI_LE_SET_EXT_ADV_PROP_INC_TX_PWR) {
         aux->ext_hdr |= (1 << BLE_LL_EXT_ADV_TX_POWER_BIT);
@@ -1359,6 +1496,301 @@ ble_ll_adv_aux_schedule(struct ble_ll_adv_sm *advsm)
 }
 #endif
 
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+static uint8_t
+ble_ll_adv_periodic_ext_hdr_len(struct ble_ll_adv_sm *advsm)
+{
+    /* AUX_SYNC_IND carries no extended header fields unless TxPower is set */
+    if (advsm->periodic_adv_props & BLE_HCI_LE_SET_PER_ADV_PROP_INC_TX_PWR) {
+        return BLE_LL_EXT_ADV_FLAGS_SIZE + BLE_LL_EXT_ADV_TX_POWER_SIZE;
+    }
+
+    return 0;
+}
+
+static uint16_t
+ble_ll_adv_periodic_data_max_len(struct ble_ll_adv_sm *advsm)
+{
+    return BLE_LL_MAX_PAYLOAD_LEN - BLE_LL_EXT_ADV_HDR_LEN -
+           ble_ll_adv_periodic_ext_hdr_len(advsm);
+}
+
+/**
+ * Create the AUX_SYNC_IND PDU
+ */
+static uint8_t
+ble_ll_adv_periodic_pdu_make(uint8_t *dptr, void *pducb_arg,
+                             uint8_t *hdr_byte)
+{
+    struct ble_ll_adv_sm *advsm;
+    uint8_t ext_hdr_len;
+    uint8_t data_len;
+
+    advsm = pducb_arg;
+
+    assert(ble_ll_adv_active_chanset_is_periodic(advsm));
+
+    ext_hdr_len = ble_ll_adv_periodic_ext_hdr_len(advsm);
+    data_len = advsm->periodic_adv_data ?
+               OS_MBUF_PKTLEN(advsm->periodic_adv_data) : 0;
+
+    /* ext hdr len and adv mode (00b) */
+    dptr[0] = ext_hdr_len;
+    dptr += 1;
+
+    if (ext_hdr_len) {
+        dptr[0] = (1 << BLE_LL_EXT_ADV_TX_POWER_BIT);
+        dptr[1] = advsm->adv_txpwr;
+        dptr += BLE_LL_EXT_ADV_FLAGS_SIZE + BLE_LL_EXT_ADV_TX_POWER_SIZE;
+    }
+
+    if (data_len) {
+        os_mbuf_copydata(advsm->periodic_adv_data, 0, data_len, dptr);
+    }
+
+    *hdr_byte = BLE_ADV_PDU_TYPE_AUX_SYNC_IND;
+
+    return BLE_LL_EXT_ADV_HDR_LEN + ext_hdr_len + data_len;
+}
+
+/**
+ * Scheduler callback which transmits a periodic advertising event.
+ *
+ * Context: Interrupt (scheduler)
+ */
+static int
+ble_ll_adv_periodic_tx_start_cb(struct ble_ll_sched_item *sch)
+{
+    int rc;
+    uint32_t txstart;
+    struct ble_ll_adv_sm *advsm;
+
+    advsm = (struct ble_ll_adv_sm *)sch->cb_arg;
+
+    /* Set the current advertiser */
+    g_ble_ll_cur_adv_sm = advsm;
+
+    ble_ll_adv_active_chanset_set_periodic(advsm);
+
+    /* Set the power */
+    ble_phy_txpwr_set(advsm->adv_txpwr);
+
+    /* Periodic advertising uses its own access address and CRC init */
+    rc = ble_phy_setchan(advsm->periodic_chan, advsm->periodic_access_addr,
+                         advsm->periodic_crcinit);
+    assert(rc == 0);
+
+#if (BLE_LL_BT5_PHY_SUPPORTED == 1)
+    ble_phy_mode_set(advsm->sec_phy, advsm->sec_phy);
+#endif
+
+    txstart = sch->start_time + g_ble_ll_sched_offset_ticks;
+    rc = ble_phy_tx_set_start_time(txstart, sch->remainder);
+    if (rc) {
+        STATS_INC(ble_ll_stats, adv_late_starts);
+        goto adv_tx_done;
+    }
+
+#if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_ENCRYPTION) == 1)
+    ble_phy_encrypt_disable();
+#endif
+
+#if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PRIVACY) == 1)
+    ble_phy_resolv_list_disable();
+#endif
+
+    ble_phy_set_txend_cb(ble_ll_adv_tx_done, advsm);
+
+    rc = ble_phy_tx(ble_ll_adv_periodic_pdu_make, advsm,
+                    BLE_PHY_TRANSITION_NONE);
+    if (rc) {
+        goto adv_tx_done;
+    }
+
+    /* Set link layer state to advertising */
+    ble_ll_state_set(BLE_LL_STATE_ADV);
+
+    /* Count # of adv. sent */
+    STATS_INC(ble_ll_stats, adv_txg);
+
+    return BLE_LL_SCHED_STATE_RUNNING;
+
+adv_tx_done:
+    ble_ll_adv_tx_done(advsm);
+    return BLE_LL_SCHED_STATE_DONE;
+}
+
+/**
+ * Puts the periodic advertising event at the current anchor on the
+ * scheduler. Events which already passed or which overlap other scheduled
+ * items are skipped; receivers simply miss them.
+ *
+ * Context: Link Layer task
+ */
+static void
+ble_ll_adv_periodic_schedule(struct ble_ll_adv_sm *advsm)
+{
+    struct ble_ll_sched_item *sch;
+    uint32_t max_usecs;
+    uint32_t earliest;
+    uint8_t pdu_len;
+
+    sch = &advsm->periodic_sch;
+    if (sch->enqueued) {
+        return;
+    }
+
+    pdu_len = BLE_LL_EXT_ADV_HDR_LEN + ble_ll_adv_periodic_ext_hdr_len(advsm);
+    if (advsm->periodic_adv_data) {
+        pdu_len += OS_MBUF_PKTLEN(advsm->periodic_adv_data);
+    }
+    max_usecs = ble_ll_pdu_tx_time_get(pdu_len, advsm->sec_phy);
+
+    earliest = os_cputime_get32() + g_ble_ll_sched_offset_ticks;
+
+    while (1) {
+        if ((int32_t)(advsm->periodic_adv_event_start_time - earliest) > 0) {
+            advsm->periodic_chan = ble_ll_conn_calc_dci_csa2_chan(
+                                            advsm->periodic_event_cntr,
+                                            advsm->periodic_channel_id,
+                                            advsm->periodic_num_used_chans,
+                                            advsm->periodic_chanmap);
+
+            sch->start_time = advsm->periodic_adv_event_start_time -
+                              g_ble_ll_sched_offset_ticks;
+            sch->remainder = advsm->periodic_adv_event_start_time_remainder;
+            sch->end_time = advsm->periodic_adv_event_start_time +
+                            ble_ll_usecs_to_ticks_round_up(max_usecs +
+                                                           sch->remainder);
+
+            if (ble_ll_sched_periodic(sch) == 0) {
+                break;
+            }
+        }
+
+        ble_ll_adv_periodic_advance(advsm,
+                                    &advsm->periodic_adv_event_start_time,
+                                    &advsm->periodic_adv_event_start_time_remainder,
+                                    &advsm->periodic_event_cntr);
+    }
+}
+
+static void
+ble_ll_adv_periodic_start(struct ble_ll_adv_sm *advsm)
+{
+    uint32_t usecs;
+    uint32_t ticks;
+
+    assert(!advsm->periodic_adv_active);
+
+    advsm->periodic_access_addr = ble_ll_conn_calc_access_addr();
+    advsm->periodic_channel_id = ((advsm->periodic_access_addr >> 16) ^
+                                  (advsm->periodic_access_addr & 0xffff));
+    advsm->periodic_crcinit = rand() & 0xffffff;
+    advsm->periodic_num_used_chans = g_ble_ll_conn_params.num_used_chans;
+    memcpy(advsm->periodic_chanmap, g_ble_ll_conn_params.master_chan_map,
+           BLE_LL_CONN_CHMAP_LEN);
+    advsm->periodic_event_cntr = 0;
+
+    usecs = (uint32_t)advsm->periodic_adv_itvl_max * BLE_LL_ADV_PERIODIC_ITVL;
+    ticks = os_cputime_usecs_to_ticks(usecs);
+    advsm->periodic_adv_itvl_rem_usec = (usecs -
+                                         os_cputime_ticks_to_usecs(ticks));
+    if (advsm->periodic_adv_itvl_rem_usec == 31) {
+        advsm->periodic_adv_itvl_rem_usec = 0;
+        ++ticks;
+    }
+    advsm->periodic_adv_itvl_ticks = ticks;
+
+    /* Same as for advertising: start some time in the future */
+    advsm->periodic_adv_event_start_time = os_cputime_get32() +
+                                           os_cputime_usecs_to_ticks(5000);
+    advsm->periodic_adv_event_start_time_remainder = 0;
+
+    advsm->periodic_adv_active = 1;
+
+    ble_ll_adv_periodic_schedule(advsm);
+}
+
+static void
+ble_ll_adv_periodic_stop(struct ble_ll_adv_sm *advsm)
+{
+    os_sr_t sr;
+
+    if (!advsm->periodic_adv_active) {
+        return;
+    }
+
+    ble_ll_sched_rmv_elem(&advsm->periodic_sch);
+
+    OS_ENTER_CRITICAL(sr);
+    if ((g_ble_ll_cur_adv_sm == advsm) &&
+        ble_ll_adv_active_chanset_is_periodic(advsm)) {
+        ble_phy_disable();
+        ble_ll_state_set(BLE_LL_STATE_STANDBY);
+        ble_ll_adv_active_chanset_clear(advsm);
+        g_ble_ll_cur_adv_sm = NULL;
+        ble_ll_scan_chk_resume();
+    }
+#ifdef BLE_XCVR_RFCLK
+    ble_ll_sched_rfclk_chk_restart();
+#endif
+    OS_EXIT_CRITICAL(sr);
+
+    ble_npl_eventq_remove(&g_ble_ll_data.ll_evq,
+                          &advsm->adv_periodic_txdone_ev);
+
+    advsm->periodic_adv_active = 0;
+}
+
+/**
+ * Called when a periodic advertising event is over or was removed from the
+ * scheduler. Schedules the next event of the train.
+ *
+ * Context: Link Layer task
+ */
+static void
+ble_ll_adv_periodic_event_done(struct ble_npl_event *ev)
+{
+    struct ble_ll_adv_sm *advsm;
+
+    advsm = (struct ble_ll_adv_sm *)ble_npl_event_get_arg(ev);
+
+    if (!advsm->periodic_adv_active) {
+        return;
+    }
+
+    /*
+     * Data set while the train is running is swapped in only between events
+     * so the PDU being transmitted and the scheduled event length always
+     * match the data in use.
+     */
+    if (advsm->periodic_new_data) {
+        os_mbuf_free_chain(advsm->periodic_adv_data);
+        advsm->periodic_adv_data = advsm->periodic_new_data;
+        advsm->periodic_new_data = NULL;
+    }
+
+    ble_ll_adv_periodic_advance(advsm, &advsm->periodic_adv_event_start_time,
+                                &advsm->periodic_adv_event_start_time_remainder,
+                                &advsm->periodic_event_cntr);
+
+    ble_ll_adv_periodic_schedule(advsm);
+
+    ble_ll_scan_chk_resume();
+}
+
+/*
+ * Called when a periodic advertising event has been removed from the
+ * scheduler without being run.
+ */
+void
+ble_ll_adv_periodic_rmvd_from_sched(struct ble_ll_adv_sm *advsm)
+{
+    ble_npl_eventq_put(&g_ble_ll_data.ll_evq, &advsm->adv_periodic_txdone_ev);
+}
+#endif
+
 /**
  * Called when advertising need to be halted. This normally should not be called
  * and is only called when a scheduled item executes but advertising is still
@@ -1378,12 +1810,21 @@ ble_ll_adv_halt(void)
 
         ble_phy_txpwr_set(MYNEWT_VAL(BLE_LL_TX_PWR_DBM));
 
-        ble_npl_eventq_put(&g_ble_ll_data.ll_evq, &advsm->adv_txdone_ev);
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+        if (ble_ll_adv_active_chanset_is_periodic(advsm)) {
+            ble_npl_eventq_put(&g_ble_ll_data.ll_evq,
+                               &advsm->adv_periodic_txdone_ev);
+        } else
+#endif
+        {
+            ble_npl_eventq_put(&g_ble_ll_data.ll_evq, &advsm->adv_txdone_ev);
 #if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_EXT_ADV)
-        if (!(advsm->props & BLE_HCI_LE_SET_EXT_ADV_PROP_LEGACY)) {
-            ble_npl_eventq_put(&g_ble_ll_data.ll_evq, &advsm->adv_sec_txdone_ev);
-        }
+            if (!(advsm->props & BLE_HCI_LE_SET_EXT_ADV_PROP_LEGACY)) {
+                ble_npl_eventq_put(&g_ble_ll_data.ll_evq,
+                                   &advsm->adv_sec_txdone_ev);
+            }
 #endif
+        }
 
         ble_ll_state_set(BLE_LL_STATE_STANDBY);
         ble_ll_adv_active_chanset_clear(g_ble_ll_cur_adv_sm);
@@ -1545,7 +1986,9 @@ ble_ll_adv_sm_stop(struct ble_ll_adv_sm *advsm)
         /* Set to standby if we are no longer advertising */
         OS_ENTER_CRITICAL(sr);
 #if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_EXT_ADV)
-        if (g_ble_ll_cur_adv_sm == advsm) {
+        /* Periodic advertising train keeps running on its own */
+        if ((g_ble_ll_cur_adv_sm == advsm) &&
+            !ble_ll_adv_active_chanset_is_periodic(advsm)) {
             ble_phy_disable();
             ble_ll_wfr_disable();
             ble_ll_state_set(BLE_LL_STATE_STANDBY);
@@ -1577,7 +2020,9 @@ ble_ll_adv_sm_stop(struct ble_ll_adv_sm *advsm)
             advsm->conn_comp_ev = NULL;
         }
 
-        ble_ll_adv_active_chanset_clear(advsm);
+        if (!ble_ll_adv_active_chanset_is_periodic(advsm)) {
+            ble_ll_adv_active_chanset_clear(advsm);
+        }
 
         /* Disable advertising */
         advsm->adv_enabled = 0;
@@ -1774,6 +2219,16 @@ ble_ll_adv_sm_start(struct ble_ll_adv_sm *advsm)
      * Schedule advertising. We set the initial schedule start and end
      * times to the earliest possible start/end.
      */
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+    /*
+     * Periodic advertising enabled earlier starts together with the
+     * advertising set so SyncInfo is available in the first AUX_ADV_IND.
+     */
+    if (advsm->periodic_adv_enabled && !advsm->periodic_adv_active) {
+        ble_ll_adv_periodic_start(advsm);
+    }
+#endif
+
     ble_ll_adv_set_sched(advsm);
     ble_ll_sched_adv_new(&advsm->adv_sch, ble_ll_adv_scheduled, NULL);
 
@@ -2202,6 +2657,18 @@ ble_ll_adv_ext_set_param(uint8_t *cmdbuf, uint8_t *rspbuf, uint8_t *rsplen)
         }
     }
 
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+    /* Periodic advertising requires non-connectable, non-scannable set */
+    if (advsm->periodic_adv_enabled &&
+        (props & (BLE_HCI_LE_SET_EXT_ADV_PROP_LEGACY |
+                  BLE_HCI_LE_SET_EXT_ADV_PROP_CONNECTABLE |
+                  BLE_HCI_LE_SET_EXT_ADV_PROP_SCANNABLE |
+                  BLE_HCI_LE_SET_EXT_ADV_PROP_ANON_ADV))) {
+        rc = BLE_ERR_INV_HCI_CMD_PARMS;
+        goto done;
+    }
+#endif
+
     /* High Duty Directed advertising is special */
     if (props & BLE_HCI_LE_SET_EXT_ADV_PROP_HD_DIRECTED) {
         if (ADV_DATA_LEN(advsm) || SCAN_RSP_DATA_LEN(advsm)) {
@@ -2492,6 +2959,221 @@ ble_ll_adv_set_random_addr(uint8_t *addr, uint8_t instance)
     return BLE_ERR_SUCCESS;
 }
 
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+/**
+ * HCI LE set periodic advertising parameters command
+ *
+ * @param cmdbuf Pointer to command data
+ *
+ * @return int BLE error code
+ */
+int
+ble_ll_adv_periodic_set_param(uint8_t *cmdbuf)
+{
+    struct ble_ll_adv_sm *advsm;
+    uint16_t itvl_min;
+    uint16_t itvl_max;
+    uint16_t props;
+
+    if (cmdbuf[0] >= BLE_ADV_INSTANCES) {
+        return BLE_ERR_INV_HCI_CMD_PARMS;
+    }
+
+    advsm = &g_ble_ll_adv_sm[cmdbuf[0]];
+    if (!instance_configured(advsm)) {
+        return BLE_ERR_UNK_ADV_INDENT;
+    }
+
+    if (advsm->periodic_adv_enabled) {
+        return BLE_ERR_CMD_DISALLOWED;
+    }
+
+    /* Periodic advertising requires non-connectable, non-scannable set */
+    if (advsm->props & (BLE_HCI_LE_SET_EXT_ADV_PROP_LEGACY |
+                        BLE_HCI_LE_SET_EXT_ADV_PROP_CONNECTABLE |
+                        BLE_HCI_LE_SET_EXT_ADV_PROP_SCANNABLE |
+                        BLE_HCI_LE_SET_EXT_ADV_PROP_ANON_ADV)) {
+        return BLE_ERR_INV_HCI_CMD_PARMS;
+    }
+
+    itvl_min = get_le16(&cmdbuf[1]);
+    itvl_max = get_le16(&cmdbuf[3]);
+    props = get_le16(&cmdbuf[5]);
+
+    if ((itvl_min < BLE_HCI_LE_SET_PER_ADV_ITVL_MIN) ||
+        (itvl_min > itvl_max)) {
+        return BLE_ERR_INV_HCI_CMD_PARMS;
+    }
+
+    if (props & ~BLE_HCI_LE_SET_PER_ADV_PROP_INC_TX_PWR) {
+        return BLE_ERR_INV_HCI_CMD_PARMS;
+    }
+
+    /* Data set earlier must still fit when TxPower gets included */
+    advsm->periodic_adv_props = props;
+    if (advsm->periodic_adv_data &&
+        (OS_MBUF_PKTLEN(advsm->periodic_adv_data) >
+         ble_ll_adv_periodic_data_max_len(advsm))) {
+        os_mbuf_free_chain(advsm->periodic_adv_data);
+        advsm->periodic_adv_data = NULL;
+    }
+
+    advsm->periodic_adv_itvl_min = itvl_min;
+    advsm->periodic_adv_itvl_max = itvl_max;
+    advsm->periodic_adv_configured = 1;
+
+    return BLE_ERR_SUCCESS;
+}
+
+/**
+ * HCI LE set periodic advertising data command
+ *
+ * Periodic advertising data is sent in a single AUX_SYNC_IND so it is limited
+ * to what fits in one PDU.
+ *
+ * @param cmdbuf Pointer to command data
+ * @param len    Command data length
+ *
+ * @return int BLE error code
+ */
+int
+ble_ll_adv_periodic_set_data(uint8_t *cmdbuf, uint8_t len)
+{
+    struct ble_ll_adv_sm *advsm;
+    uint8_t operation;
+    uint8_t datalen;
+    bool new_data;
+
+    if ((len < 3) || (len != 3 + cmdbuf[2])) {
+        return BLE_ERR_INV_HCI_CMD_PARMS;
+    }
+
+    if (cmdbuf[0] >= BLE_ADV_INSTANCES) {
+        return BLE_ERR_INV_HCI_CMD_PARMS;
+    }
+
+    advsm = &g_ble_ll_adv_sm[cmdbuf[0]];
+    operation = cmdbuf[1];
+    datalen = cmdbuf[2];
+
+    if (!instance_configured(advsm)) {
+        return BLE_ERR_UNK_ADV_INDENT;
+    }
+
+    if (!advsm->periodic_adv_configured) {
+        return BLE_ERR_CMD_DISALLOWED;
+    }
+
+    switch (operation) {
+    case BLE_HCI_LE_SET_EXT_ADV_DATA_OPER_COMPLETE:
+        advsm->periodic_adv_data_incomplete = 0;
+
+        if (advsm->periodic_adv_active) {
+            /* Applied by the train on the next event */
+            ble_ll_adv_update_data_mbuf(&advsm->periodic_new_data, true,
+                                        ble_ll_adv_periodic_data_max_len(advsm),
+                                        cmdbuf + 3, datalen);
+            if (!advsm->periodic_new_data) {
+                return BLE_ERR_MEM_CAPACITY;
+            }
+
+            return BLE_ERR_SUCCESS;
+        }
+        break;
+    case BLE_HCI_LE_SET_EXT_ADV_DATA_OPER_LAST:
+        if (advsm->periodic_adv_enabled) {
+            return BLE_ERR_CMD_DISALLOWED;
+        }
+
+        advsm->periodic_adv_data_incomplete = 0;
+        /* fall through */
+    case BLE_HCI_LE_SET_EXT_ADV_DATA_OPER_INT:
+        if (advsm->periodic_adv_enabled) {
+            return BLE_ERR_CMD_DISALLOWED;
+        }
+
+        if (!advsm->periodic_adv_data || !datalen) {
+            return BLE_ERR_INV_HCI_CMD_PARMS;
+        }
+        break;
+    case BLE_HCI_LE_SET_EXT_ADV_DATA_OPER_FIRST:
+        if (advsm->periodic_adv_enabled) {
+            return BLE_ERR_CMD_DISALLOWED;
+        }
+
+        if (!datalen) {
+            return BLE_ERR_INV_HCI_CMD_PARMS;
+        }
+
+        advsm->periodic_adv_data_incomplete = 1;
+        break;
+    default:
+        return BLE_ERR_INV_HCI_CMD_PARMS;
+    }
+
+    new_data = (operation == BLE_HCI_LE_SET_EXT_ADV_DATA_OPER_COMPLETE) ||
+               (operation == BLE_HCI_LE_SET_EXT_ADV_DATA_OPER_FIRST);
+
+    ble_ll_adv_update_data_mbuf(&advsm->periodic_adv_data, new_data,
+                                ble_ll_adv_periodic_data_max_len(advsm),
+                                cmdbuf + 3, datalen);
+    if (!advsm->periodic_adv_data) {
+        return BLE_ERR_MEM_CAPACITY;
+    }
+
+    return BLE_ERR_SUCCESS;
+}
+
+/**
+ * HCI LE set periodic advertising enable command
+ *
+ * The periodic advertising train starts once the advertising set itself is
+ * enabled and continues until it is explicitly disabled.
+ *
+ * @param cmdbuf Pointer to command data
+ *
+ * @return int BLE error code
+ */
+int
+ble_ll_adv_periodic_enable(uint8_t *cmdbuf)
+{
+    struct ble_ll_adv_sm *advsm;
+
+    if (cmdbuf[1] >= BLE_ADV_INSTANCES) {
+        return BLE_ERR_INV_HCI_CMD_PARMS;
+    }
+
+    advsm = &g_ble_ll_adv_sm[cmdbuf[1]];
+
+    if (!instance_configured(advsm)) {
+        return BLE_ERR_UNK_ADV_INDENT;
+    }
+
+    switch (cmdbuf[0]) {
+    case 0x01:
+        if (!advsm->periodic_adv_configured ||
+            advsm->periodic_adv_data_incomplete) {
+            return BLE_ERR_CMD_DISALLOWED;
+        }
+
+        advsm->periodic_adv_enabled = 1;
+
+        if (advsm->adv_enabled && !advsm->periodic_adv_active) {
+            ble_ll_adv_periodic_start(advsm);
+        }
+        break;
+    case 0x00:
+        ble_ll_adv_periodic_stop(advsm);
+        advsm->periodic_adv_enabled = 0;
+        break;
+    default:
+        return BLE_ERR_INV_HCI_CMD_PARMS;
+    }
+
+    return BLE_ERR_SUCCESS;
+}
+#endif
+
 /**
  * HCI LE extended advertising remove command
  *
@@ -2522,6 +3204,15 @@ ble_ll_adv_remove(uint8_t instance)
         return BLE_ERR_CMD_DISALLOWED;
     }
 
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+    if (advsm->periodic_adv_enabled) {
+        return BLE_ERR_CMD_DISALLOWED;
+    }
+
+    os_mbuf_free_chain(advsm->periodic_adv_data);
+    os_mbuf_free_chain(advsm->periodic_new_data);
+#endif
+
     if (advsm->adv_data) {
         os_mbuf_free_chain(advsm->adv_data);
     }
@@ -2548,6 +3239,11 @@ ble_ll_adv_clear_all(void)
         if (g_ble_ll_adv_sm[i].adv_enabled) {
             return BLE_ERR_CMD_DISALLOWED;
         }
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+        if (g_ble_ll_adv_sm[i].periodic_adv_enabled) {
+            return BLE_ERR_CMD_DISALLOWED;
+        }
+#endif
     }
 
     ble_ll_adv_reset();
@@ -3438,6 +4134,14 @@ ble_ll_adv_reset(void)
         /* Stop advertising state machine */
         ble_ll_adv_sm_stop(advsm);
 
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+        /* Stop periodic advertising train */
+        ble_ll_adv_periodic_stop(advsm);
+
+        os_mbuf_free_chain(advsm->periodic_adv_data);
+        os_mbuf_free_chain(advsm->periodic_new_data);
+#endif
+
         /* clear any data present */
         os_mbuf_free_chain(advsm->adv_data);
         os_mbuf_free_chain(advsm->scan_rsp_data);
@@ -3492,6 +4196,14 @@ ble_ll_adv_sm_init(struct ble_ll_adv_sm *advsm)
     advsm->aux[1].sch.sched_type = BLE_LL_SCHED_TYPE_ADV;
 #endif
 
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+    ble_npl_event_init(&advsm->adv_periodic_txdone_ev,
+                       ble_ll_adv_periodic_event_done, advsm);
+    advsm->periodic_sch.cb_arg = advsm;
+    advsm->periodic_sch.sched_cb = ble_ll_adv_periodic_tx_start_cb;
+    advsm->periodic_sch.sched_type = BLE_LL_SCHED_TYPE_PERIODIC;
+#endif
+
     /*XXX Configure instances to be legacy on start */
     advsm->props |= BLE_HCI_LE_SET_EXT_ADV_PROP_SCANNABLE;
     advsm->props |= BLE_HCI_LE_SET_EXT_ADV_PROP_LEGACY;
@@ -131,7 +131,7 @@ struct ble_ll_empty_pdu
 #endif
 
 /* Sleep clock accuracy table (in ppm) */
-static const uint16_t g_ble_sca_ppm_tbl[8] =
+const uint16_t g_ble_sca_ppm_tbl[8] =
 {
     500, 250, 150, 100, 75, 50, 30, 20
 };
@@ -184,6 +184,8 @@ STATS_SECT_START(ble_ll_conn_stats)
     STATS_SECT_ENTRY(tx_l2cap_bytes)
     STATS_SECT_ENTRY(tx_empty_pdus)
     STATS_SECT_ENTRY(mic_failures)
+    STATS_SECT_ENTRY(conn_ev_truncated)
+    STATS_SECT_ENTRY(conn_ev_extended)
 STATS_SECT_END
 STATS_SECT_DECL(ble_ll_conn_stats) ble_ll_conn_stats;
 
@@ -214,6 +216,8 @@ STATS_NAME_START(ble_ll_conn_stats)
     STATS_NAME(ble_ll_conn_stats, tx_l2cap_bytes)
     STATS_NAME(ble_ll_conn_stats, tx_empty_pdus)
     STATS_NAME(ble_ll_conn_stats, mic_failures)
+    STATS_NAME(ble_ll_conn_stats, conn_ev_truncated)
+    STATS_NAME(ble_ll_conn_stats, conn_ev_extended)
 STATS_NAME_END(ble_ll_conn_stats)
 
 static void ble_ll_conn_event_end(struct ble_npl_event *ev);
@@ -387,6 +391,7 @@ ble_ll_conn_current_sm_over(struct ble_ll_conn_sm *connsm)
      * need to post to the LL the connection event end event
      */
     if (connsm) {
+        connsm->ce_last_end_time = os_cputime_get32();
         ble_ll_event_send(&connsm->conn_ev_end);
     }
 }
@@ -498,7 +503,7 @@ ble_ll_conn_calc_used_chans(uint8_t *chmap)
     return used_channels;
 }
 
-static uint32_t
+uint32_t
 ble_ll_conn_calc_access_addr(void)
 {
     uint32_t aa;
@@ -645,7 +650,8 @@ ble_ll_conn_remapped_channel(uint8_t remap_index, const uint8_t *chanmap)
     return 0;
 }
 
-#if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_CSA2) == 1)
+#if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_CSA2) == 1) || \
+    MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
 static uint16_t
 ble_ll_conn_csa2_perm(uint16_t in)
 {
@@ -684,8 +690,20 @@ ble_ll_conn_csa2_prng(uint16_t counter, uint16_t ch_id)
     return prn_e;
 }
 
-static uint8_t
-ble_ll_conn_calc_dci_csa2(struct ble_ll_conn_sm *conn)
+/**
+ * Calculates the channel index using channel selection algorithm #2. This is
+ * shared by connections and periodic advertising trains.
+ *
+ * @param event_cntr        Event counter of the event
+ * @param channel_id        Channel identifier derived from access address
+ * @param num_used_chans    Number of used channels in the channel map
+ * @param chanmap           Channel map
+ *
+ * @return uint8_t Channel index
+ */
+uint8_t
+ble_ll_conn_calc_dci_csa2_chan(uint16_t event_cntr, uint16_t channel_id,
+                               uint8_t num_used_chans, const uint8_t *chanmap)
 {
     uint16_t channel_unmapped;
     uint8_t remap_index;
@@ -693,7 +711,7 @@ ble_ll_conn_calc_dci_csa2(struct ble_ll_conn_sm *conn)
     uint16_t prn_e;
     uint8_t bitpos;
 
-    prn_e = ble_ll_conn_csa2_prng(conn->event_cntr, conn->channel_id);
+    prn_e = ble_ll_conn_csa2_prng(event_cntr, channel_id);
 
     channel_unmapped = prn_e % 37;
 
@@ -702,13 +720,23 @@ ble_ll_conn_calc_dci_csa2(struct ble_ll_conn_sm *conn)
      * as channel index.
      */
     bitpos = 1 << (channel_unmapped & 0x07);
-    if (conn->chanmap[channel_unmapped >> 3] & bitpos) {
+    if (chanmap[channel_unmapped >> 3] & bitpos) {
         return channel_unmapped;
     }
 
-    remap_index = (conn->num_used_chans * prn_e) / 0x10000;
+    remap_index = (num_used_chans * prn_e) / 0x10000;
 
-    return ble_ll_conn_remapped_channel(remap_index, conn->chanmap);
+    return ble_ll_conn_remapped_channel(remap_index, chanmap);
+}
+#endif
+
+#if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_CSA2) == 1)
+static uint8_t
+ble_ll_conn_calc_dci_csa2(struct ble_ll_conn_sm *conn)
+{
+    return ble_ll_conn_calc_dci_csa2_chan(conn->event_cntr, conn->channel_id,
+                                          conn->num_used_chans,
+                                          conn->chanmap);
 }
 #endif
 
@@ -966,6 +994,190 @@ ble_ll_conn_get_next_sched_time(struct ble_ll_conn_sm *connsm)
     return ce_end;
 }
 
+/**
+ * Returns the time at which the current connection event has to end. This is
+ * the next scheduled item (or the next connection event) unless the host
+ * limited the connection event length, in which case the event may not
+ * extend past the maximum CE length from the anchor point.
+ *
+ * @param connsm
+ *
+ * @return uint32_t
+ */
+static uint32_t
+ble_ll_conn_ce_end_limit(struct ble_ll_conn_sm *connsm)
+{
+    uint32_t ce_end;
+    uint32_t max_end;
+
+    ce_end = ble_ll_conn_get_next_sched_time(connsm);
+
+    if (connsm->max_ce_len) {
+        max_end = connsm->anchor_point +
+            os_cputime_usecs_to_ticks((uint32_t)connsm->max_ce_len *
+                                      BLE_LL_CONN_CE_USECS);
+        if (CPUTIME_LT(max_end, ce_end)) {
+            ce_end = max_end;
+        }
+    }
+
+    return ce_end;
+}
+
+/**
+ * Called by a slave to determine if there is enough time left in the
+ * connection event to send a PDU with the given payload length, receive a
+ * maximum size frame from the master and reply to it.
+ *
+ * @param connsm
+ * @param txlen
+ *
+ * @return int 0: not enough time; 1: otherwise
+ */
+static int
+ble_ll_conn_slave_can_rx_next(struct ble_ll_conn_sm *connsm, uint8_t txlen)
+{
+    uint32_t usecs;
+    uint32_t ticks;
+    int tx_phy_mode;
+
+#if BLE_LL_BT5_PHY_SUPPORTED
+    tx_phy_mode = connsm->phy_data.tx_phy_mode;
+#else
+    tx_phy_mode = BLE_PHY_MODE_1M;
+#endif
+
+    usecs = (BLE_LL_IFS * 3) + connsm->eff_max_rx_time +
+            ble_ll_pdu_tx_time_get(txlen, tx_phy_mode) +
+            ble_ll_pdu_tx_time_get(0, tx_phy_mode);
+    ticks = os_cputime_usecs_to_ticks(usecs);
+
+    return CPUTIME_LT(os_cputime_get32() + ticks,
+                      ble_ll_conn_ce_end_limit(connsm));
+}
+
+#if !MYNEWT_VAL(BLE_LL_STRICT_CONN_SCHEDULING)
+/**
+ * Returns the range, in slots, that the reserved connection event length of
+ * a connection is allowed to adapt within. The host supplied minimum and
+ * maximum CE lengths are honoured if present; otherwise the reservation
+ * starts at BLE_LL_CONN_INIT_SLOTS and may grow up to half the connection
+ * interval. Note that a host minimum replaces BLE_LL_CONN_INIT_SLOTS, so it
+ * may reserve more than the default (the NimBLE host asks for 8 slots). The
+ * reservation never covers the whole connection interval.
+ *
+ * @param connsm
+ * @param lo
+ * @param hi
+ */
+static void
+ble_ll_conn_ce_len_bounds(struct ble_ll_conn_sm *connsm, uint16_t *lo,
+                          uint16_t *hi)
+{
+    uint16_t max_slots;
+
+    max_slots = connsm->conn_itvl - 1;
+
+    if (connsm->min_ce_len) {
+        *lo = min((connsm->min_ce_len + 1) / 2, max_slots);
+    } else {
+        *lo = MYNEWT_VAL(BLE_LL_CONN_INIT_SLOTS);
+    }
+
+    if (connsm->max_ce_len) {
+        *hi = min(connsm->max_ce_len / 2, max_slots);
+    } else {
+        *hi = connsm->conn_itvl / 2;
+    }
+
+    if (*hi < *lo) {
+        *hi = *lo;
+    }
+}
+#endif
+
+/**
+ * Called at the end of a connection event to account for its length and
+ * adapt the connection event length reserved for this connection. The
+ * reservation grows by a slot when the event had to be cut short while more
+ * data was pending or when it overran its reservation, and shrinks by a slot
+ * after BLE_LL_CONN_CE_SHRINK_EVENTS consecutive events that used less than
+ * half of it.
+ *
+ * @param connsm
+ */
+void
+ble_ll_conn_ce_len_update(struct ble_ll_conn_sm *connsm)
+{
+    int grow;
+#if !MYNEWT_VAL(BLE_LL_STRICT_CONN_SCHEDULING)
+    uint16_t lo;
+    uint16_t hi;
+    uint32_t used;
+    uint32_t reserved;
+#endif
+
+    grow = 0;
+    if (connsm->csmflags.cfbit.ce_truncated) {
+        connsm->csmflags.cfbit.ce_truncated = 0;
+        ++connsm->ce_truncated_cnt;
+        STATS_INC(ble_ll_conn_stats, conn_ev_truncated);
+        grow = 1;
+    }
+
+    if (CPUTIME_GT(connsm->ce_last_end_time, connsm->ce_end_time)) {
+        ++connsm->ce_extended_cnt;
+        STATS_INC(ble_ll_conn_stats, conn_ev_extended);
+        grow = 1;
+    }
+
+#if !MYNEWT_VAL(BLE_LL_STRICT_CONN_SCHEDULING)
+    ble_ll_conn_ce_len_bounds(connsm, &lo, &hi);
+
+    if (grow) {
+        connsm->ce_short_cnt = 0;
+        ++connsm->ce_len_slots;
+    } else {
+        used = connsm->ce_last_end_time - connsm->anchor_point;
+        reserved = connsm->ce_len_slots * BLE_LL_SCHED_32KHZ_TICKS_PER_SLOT;
+        if (used < (reserved / 2)) {
+            ++connsm->ce_short_cnt;
+            if (connsm->ce_short_cnt >= BLE_LL_CONN_CE_SHRINK_EVENTS) {
+                connsm->ce_short_cnt = 0;
+                --connsm->ce_len_slots;
+            }
+        } else {
+            connsm->ce_short_cnt = 0;
+        }
+    }
+
+    if (connsm->ce_len_slots < lo) {
+        connsm->ce_len_slots = lo;
+    } else if (connsm->ce_len_slots > hi) {
+        connsm->ce_len_slots = hi;
+    }
+#else
+    (void)grow;
+#endif
+}
+
+/**
+ * Called when the host provides new connection event length parameters for
+ * a connection. The parameters are in units of 0.625 msecs.
+ *
+ * @param connsm
+ * @param min_ce_len
+ * @param max_ce_len
+ */
+void
+ble_ll_conn_set_ce_len(struct ble_ll_conn_sm *connsm, uint16_t min_ce_len,
+                       uint16_t max_ce_len)
+{
+    connsm->min_ce_len = min_ce_len;
+    connsm->max_ce_len = max_ce_len;
+    connsm->ce_short_cnt = 0;
+}
+
 /**
  * Called to check if certain connection state machine flags have been
  * set.
@@ -1092,6 +1304,7 @@ ble_ll_conn_tx_data_pdu(struct ble_ll_conn_sm *connsm)
     pkthdr = STAILQ_FIRST(&connsm->conn_txq);
     if (!connsm->cur_tx_pdu && !CONN_F_EMPTY_PDU_TXD(connsm) && !pkthdr) {
         CONN_F_EMPTY_PDU_TXD(connsm) = 1;
+        cur_txlen = 0;
         goto conn_tx_pdu;
     }
 
@@ -1113,6 +1326,7 @@ ble_ll_conn_tx_data_pdu(struct ble_ll_conn_sm *connsm)
         if (connsm->enc_data.enc_state > CONN_ENC_S_ENCRYPTED) {
             if (!ble_ll_ctrl_enc_allowed_pdu(pkthdr)) {
                 CONN_F_EMPTY_PDU_TXD(connsm) = 1;
+                cur_txlen = 0;
                 goto conn_tx_pdu;
             }
 
@@ -1189,7 +1403,7 @@ ble_ll_conn_tx_data_pdu(struct ble_ll_conn_sm *connsm)
     if ((nextpkthdr || ((cur_offset + cur_txlen) < pktlen)) &&
          !connsm->csmflags.cfbit.terminate_ind_rxd) {
         /* Get next event time */
-        next_event_time = ble_ll_conn_get_next_sched_time(connsm);
+        next_event_time = ble_ll_conn_ce_end_limit(connsm);
 
         /* XXX: TODO: need to check this with phy update procedure. There are
            limitations if we have started update */
@@ -1239,6 +1453,9 @@ ble_ll_conn_tx_data_pdu(struct ble_ll_conn_sm *connsm)
         ticks = os_cputime_usecs_to_ticks(ticks);
         if ((int32_t)((os_cputime_get32() + ticks) - next_event_time) < 0) {
             md = 1;
+        } else {
+            /* Out of time while we still have data to send */
+            connsm->csmflags.cfbit.ce_truncated = 1;
         }
      }
 
@@ -1282,12 +1499,13 @@ conn_tx_pdu:
      * received a valid frame with the more data bit set to 0 and we dont
      * have more data.
      *
-     * XXX: for a slave, we dont check to see if we can:
-     *  -> wait IFS, rx frame from master (either big or small).
-     *  -> wait IFS, send empty pdu or next pdu.
+     * A slave also ends the connection event if it cannot do the following
+     * before the connection event has to end:
+     *  -> wait IFS, rx maximum size frame from master.
+     *  -> wait IFS, send empty pdu.
      *
-     *  We could do this. Now, we just keep going and hope that we dont
-     *  overrun next scheduled item.
+     * We never stop listening after sending a terminate ind though, as we
+     * need to know that it was acknowledged.
      */
     if ((connsm->csmflags.cfbit.terminate_ind_rxd) ||
         ((connsm->conn_role == BLE_LL_CONN_ROLE_SLAVE) && (md == 0) &&
@@ -1297,6 +1515,13 @@ conn_tx_pdu:
         /* We will end the connection event */
         end_transition = BLE_PHY_TRANSITION_NONE;
         txend_func = ble_ll_conn_wait_txend;
+    } else if ((connsm->conn_role == BLE_LL_CONN_ROLE_SLAVE) && (md == 0) &&
+               !ble_ll_ctrl_is_terminate_ind(hdr_byte, m->om_data[0]) &&
+               !ble_ll_conn_slave_can_rx_next(connsm, cur_txlen)) {
+        /* Master has more data but we are out of time; end the event */
+        connsm->csmflags.cfbit.ce_truncated = 1;
+        end_transition = BLE_PHY_TRANSITION_NONE;
+        txend_func = ble_ll_conn_wait_txend;
     } else {
         /* Wait for a response here */
         end_transition = BLE_PHY_TRANSITION_TX_RX;
@@ -1586,8 +1811,8 @@ ble_ll_conn_can_send_next_pdu(struct ble_ll_conn_sm *connsm, uint32_t begtime,
 
     rc = 1;
     if (connsm->conn_role == BLE_LL_CONN_ROLE_MASTER) {
-        /* Get next scheduled item time */
-        next_sched_time = ble_ll_conn_get_next_sched_time(connsm);
+        /* Get time at which connection event has to end */
+        next_sched_time = ble_ll_conn_ce_end_limit(connsm);
 
         txpdu = connsm->cur_tx_pdu;
         if (!txpdu) {
@@ -1617,6 +1842,7 @@ ble_ll_conn_can_send_next_pdu(struct ble_ll_conn_sm *connsm, uint32_t begtime,
         ticks = (uint32_t)(next_sched_time - begtime);
         allowed_usecs = os_cputime_ticks_to_usecs(ticks);
         if ((usecs + add_usecs) >= allowed_usecs) {
+            connsm->csmflags.cfbit.ce_truncated = 1;
             rc = 0;
         }
     }
@@ -1926,6 +2152,10 @@ ble_ll_conn_sm_new(struct ble_ll_conn_sm *connsm)
     connsm->reject_reason = BLE_ERR_SUCCESS;
     connsm->conn_rssi = BLE_LL_CONN_UNKNOWN_RSSI;
     connsm->rpa_index = -1;
+    connsm->ce_len_slots = MYNEWT_VAL(BLE_LL_CONN_INIT_SLOTS);
+    connsm->ce_short_cnt = 0;
+    connsm->ce_truncated_cnt = 0;
+    connsm->ce_extended_cnt = 0;
 
     /* XXX: TODO set these based on PHY that started connection */
 #if (BLE_LL_BT5_PHY_SUPPORTED == 1)
@@ -2353,7 +2583,7 @@ ble_ll_conn_next_event(struct ble_ll_conn_sm *connsm)
 #if MYNEWT_VAL(BLE_LL_STRICT_CONN_SCHEDULING)
     itvl = g_ble_ll_sched_data.sch_ticks_per_period;
 #else
-    itvl = MYNEWT_VAL(BLE_LL_CONN_INIT_SLOTS) * BLE_LL_SCHED_32KHZ_TICKS_PER_SLOT;
+    itvl = connsm->ce_len_slots * BLE_LL_SCHED_32KHZ_TICKS_PER_SLOT;
 #endif
     if (connsm->conn_role == BLE_LL_CONN_ROLE_SLAVE) {
         cur_ww = ble_ll_conn_calc_window_widening(connsm);
@@ -2590,6 +2820,9 @@ ble_ll_conn_event_end(struct ble_npl_event *ev)
      */
 #endif
 
+    /* Account for event length and adapt reserved length for next event */
+    ble_ll_conn_ce_len_update(connsm);
+
     /* Move to next connection event */
     if (ble_ll_conn_next_event(connsm)) {
         ble_ll_conn_end(connsm, BLE_ERR_CONN_TERM_LOCAL);
@@ -4108,6 +4341,8 @@ ble_ll_conn_slave_start(uint8_t *rxbuf, uint8_t pat, struct ble_mbuf_hdr *rxhdr,
     connsm->conn_itvl = get_le16(dptr + 10);
     connsm->slave_latency = get_le16(dptr + 12);
     connsm->supervision_tmo = get_le16(dptr + 14);
+    connsm->min_ce_len = 0;
+    connsm->max_ce_len = 0;
     memcpy(&connsm->chanmap, dptr + 16, BLE_LL_CONN_CHMAP_LEN);
     connsm->hop_inc = dptr[21] & 0x1F;
     connsm->master_sca = dptr[21] >> 5;
@@ -745,6 +745,9 @@ ble_ll_conn_process_conn_params(uint8_t *cmdbuf, struct ble_ll_conn_sm *connsm)
         hcu->handle = 0;
         return BLE_ERR_INV_HCI_CMD_PARMS;
     }
+
+    ble_ll_conn_set_ce_len(connsm, hcu->min_ce_len, hcu->max_ce_len);
+
     return rc;
 }
 
@@ -887,6 +890,8 @@ ble_ll_conn_hci_update(uint8_t *cmdbuf)
                                          hcu->conn_latency,
                                          hcu->supervision_timeout);
     if (!rc) {
+        ble_ll_conn_set_ce_len(connsm, hcu->min_ce_len, hcu->max_ce_len);
+
         /* Start the control procedure */
         ble_ll_ctrl_proc_start(connsm, ctrl_proc);
     }
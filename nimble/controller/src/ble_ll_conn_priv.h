@@ -48,6 +48,12 @@ extern "C" {
 #define BLE_LL_CONN_TX_WIN_MIN              (1)         /* in tx win units */
 #define BLE_LL_CONN_SLAVE_LATENCY_MAX       (499)
 
+/*
+ * Number of consecutive connection events using less than half of the
+ * reserved connection event length before the reservation is reduced.
+ */
+#define BLE_LL_CONN_CE_SHRINK_EVENTS        (8)
+
 /* Connection handle range */
 #define BLE_LL_CONN_MAX_CONN_HANDLE         (0x0EFF)
 
@@ -79,6 +85,9 @@ struct ble_ll_conn_global_params
 };
 extern struct ble_ll_conn_global_params g_ble_ll_conn_params;
 
+/* Sleep clock accuracy table (in ppm) */
+extern const uint16_t g_ble_sca_ppm_tbl[8];
+
 /* Some data structures used by other LL routines */
 SLIST_HEAD(ble_ll_conn_active_list, ble_ll_conn_sm);
 STAILQ_HEAD(ble_ll_conn_free_list, ble_ll_conn_sm);
@@ -137,6 +146,13 @@ int ble_ll_conn_is_lru(struct ble_ll_conn_sm *s1, struct ble_ll_conn_sm *s2);
 uint32_t ble_ll_conn_get_ce_end_time(void);
 void ble_ll_conn_event_halt(void);
 uint8_t ble_ll_conn_calc_used_chans(uint8_t *chmap);
+uint32_t ble_ll_conn_calc_access_addr(void);
+uint8_t ble_ll_conn_calc_dci_csa2_chan(uint16_t event_cntr, uint16_t channel_id,
+                                       uint8_t num_used_chans,
+                                       const uint8_t *chanmap);
+void ble_ll_conn_set_ce_len(struct ble_ll_conn_sm *connsm,
+                            uint16_t min_ce_len, uint16_t max_ce_len);
+void ble_ll_conn_ce_len_update(struct ble_ll_conn_sm *connsm);
 void ble_ll_conn_reset_pending_aux_conn_rsp(void);
 bool ble_ll_conn_init_pending_aux_conn_rsp(void);
 /* HCI */
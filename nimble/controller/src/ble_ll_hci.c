@@ -32,12 +32,18 @@
 #include "controller/ble_ll_hci.h"
 #include "controller/ble_ll_whitelist.h"
 #include "controller/ble_ll_resolv.h"
+#include "controller/ble_ll_sched.h"
+#include "controller/ble_ll_trace.h"
 #include "ble_ll_conn_priv.h"
 
 #if MYNEWT_VAL(BLE_LL_DIRECT_TEST_MODE) == 1
 #include "ble_ll_dtm_priv.h"
 #endif
 
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+#include "ble_ll_sync_priv.h"
+#endif
+
 static void ble_ll_hci_cmd_proc(struct ble_npl_event *ev);
 
 /* OS event to enqueue command */
@@ -589,6 +595,7 @@ ble_ll_hci_le_cmd_send_cmd_status(uint16_t ocf)
     case BLE_HCI_OCF_LE_RD_P256_PUBKEY:
     case BLE_HCI_OCF_LE_GEN_DHKEY:
     case BLE_HCI_OCF_LE_SET_PHY:
+    case BLE_HCI_OCF_LE_PER_ADV_CREATE_SYNC:
         rc = 1;
         break;
     default:
@@ -668,6 +675,14 @@ ble_ll_is_valid_adv_mode(uint8_t ocf)
     case BLE_HCI_OCF_LE_SET_EXT_SCAN_ENABLE:
     case BLE_HCI_OCF_LE_SET_EXT_SCAN_PARAM:
     case BLE_HCI_OCF_LE_SET_EXT_SCAN_RSP_DATA:
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+    case BLE_HCI_OCF_LE_SET_PER_ADV_PARAMS:
+    case BLE_HCI_OCF_LE_SET_PER_ADV_DATA:
+    case BLE_HCI_OCF_LE_SET_PER_ADV_ENABLE:
+    case BLE_HCI_OCF_LE_PER_ADV_CREATE_SYNC:
+    case BLE_HCI_OCF_LE_PER_ADV_CREATE_SYNC_CANCEL:
+    case BLE_HCI_OCF_LE_PER_ADV_TERM_SYNC:
+#endif
         if (hci_adv_mode == ADV_MODE_LEGACY) {
             return false;
         }
@@ -914,6 +929,26 @@ ble_ll_hci_le_cmd_proc(uint8_t *cmdbuf, uint16_t ocf, uint8_t *rsplen,
         rc =  ble_ll_adv_clear_all();
         break;
 #endif
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+    case BLE_HCI_OCF_LE_SET_PER_ADV_PARAMS:
+        rc = ble_ll_adv_periodic_set_param(cmdbuf);
+        break;
+    case BLE_HCI_OCF_LE_SET_PER_ADV_DATA:
+        rc = ble_ll_adv_periodic_set_data(cmdbuf, len);
+        break;
+    case BLE_HCI_OCF_LE_SET_PER_ADV_ENABLE:
+        rc = ble_ll_adv_periodic_enable(cmdbuf);
+        break;
+    case BLE_HCI_OCF_LE_PER_ADV_CREATE_SYNC:
+        rc = ble_ll_sync_create(cmdbuf);
+        break;
+    case BLE_HCI_OCF_LE_PER_ADV_CREATE_SYNC_CANCEL:
+        rc = ble_ll_sync_cancel(cb);
+        break;
+    case BLE_HCI_OCF_LE_PER_ADV_TERM_SYNC:
+        rc = ble_ll_sync_terminate(cmdbuf);
+        break;
+#endif
 #if (BLE_LL_BT5_PHY_SUPPORTED == 1)
     case BLE_HCI_OCF_LE_RD_PHY:
         rc = ble_ll_conn_hci_le_rd_phy(cmdbuf, rspbuf, rsplen);
@@ -1158,6 +1193,146 @@ ble_ll_hci_status_params_cmd_proc(uint8_t *cmdbuf, uint16_t ocf, uint8_t *rsplen
     return rc;
 }
 
+#if MYNEWT_VAL(BLE_LL_HCI_VS)
+#if MYNEWT_VAL(BLE_LL_SCHED_STATS)
+/**
+ * Vendor specific command: read schedule statistics of a schedule item type.
+ *
+ * Command parameters: schedule item type (1 byte), reset (1 byte).
+ * Return parameters: executed, rescheduled, dropped (4 bytes each), number of
+ * late start buckets (1 byte) followed by the bucket counts (4 bytes each).
+ *
+ * @param cmdbuf
+ * @param rspbuf
+ * @param rsplen
+ *
+ * @return int
+ */
+static int
+ble_ll_hci_vs_rd_sched_stats(uint8_t *cmdbuf, uint8_t *rspbuf, uint8_t *rsplen)
+{
+    int i;
+    struct ble_ll_sched_stats stats;
+
+    if (ble_ll_sched_stats_get(cmdbuf[0], &stats, cmdbuf[1])) {
+        return BLE_ERR_INV_HCI_CMD_PARMS;
+    }
+
+    put_le32(rspbuf, stats.executed);
+    put_le32(rspbuf + 4, stats.rescheduled);
+    put_le32(rspbuf + 8, stats.dropped);
+    rspbuf[12] = BLE_LL_SCHED_STATS_LATE_BUCKETS;
+    for (i = 0; i < BLE_LL_SCHED_STATS_LATE_BUCKETS; ++i) {
+        put_le32(rspbuf + 13 + (i * 4), stats.late[i]);
+    }
+
+    *rsplen = 13 + (BLE_LL_SCHED_STATS_LATE_BUCKETS * 4);
+    return BLE_ERR_SUCCESS;
+}
+#endif
+
+#if BLE_LL_TRACE_RING
+/**
+ * Vendor specific command: read (and remove) the oldest records from the LL
+ * trace ring.
+ *
+ * Return parameters: number of records lost since last read (4 bytes),
+ * number of records (1 byte) followed by the records.
+ *
+ * @param rspbuf
+ * @param rsplen
+ *
+ * @return int
+ */
+static int
+ble_ll_hci_vs_rd_trace(uint8_t *rspbuf, uint8_t *rsplen)
+{
+    int cnt;
+    uint32_t lost;
+
+    cnt = ble_ll_trace_ring_read(rspbuf + 5, BLE_HCI_VS_RD_TRACE_MAX_RECS,
+                                 &lost);
+    put_le32(rspbuf, lost);
+    rspbuf[4] = (uint8_t)cnt;
+
+    *rsplen = 5 + (cnt * BLE_LL_TRACE_RING_REC_LEN);
+    return BLE_ERR_SUCCESS;
+}
+#endif
+
+/**
+ * Process a vendor specific command sent from the host to the controller.
+ *
+ * @param cmdbuf Pointer to command buffer
+ * @param ocf    Opcode command field.
+ * @param *rsplen Pointer to length of response
+ *
+ * @return int This function returns a BLE error code. If a command status
+ *             event should be returned as opposed to command complete,
+ *             256 gets added to the return value.
+ */
+static int
+ble_ll_hci_vs_cmd_proc(uint8_t *cmdbuf, uint16_t ocf, uint8_t *rsplen)
+{
+    int rc;
+    uint8_t len;
+    uint8_t *rspbuf;
+
+    /* Assume error; if all pass rc gets set to 0 */
+    rc = BLE_ERR_INV_HCI_CMD_PARMS;
+
+    /* Get length from command */
+    len = cmdbuf[sizeof(uint16_t)];
+
+    /* The response points into the command buffer; see above */
+    rspbuf = cmdbuf + BLE_HCI_EVENT_CMD_COMPLETE_MIN_LEN;
+
+    /* Move past HCI command header */
+    cmdbuf += BLE_HCI_CMD_HDR_LEN;
+
+    switch (ocf) {
+#if MYNEWT_VAL(BLE_LL_SCHED_STATS)
+    case BLE_HCI_OCF_VS_RD_SCHED_STATS:
+        if (len == BLE_HCI_VS_RD_SCHED_STATS_LEN) {
+            rc = ble_ll_hci_vs_rd_sched_stats(cmdbuf, rspbuf, rsplen);
+        }
+        break;
+#endif
+#if BLE_LL_TRACE_RING
+    case BLE_HCI_OCF_VS_RD_TRACE:
+        if (len == BLE_HCI_VS_RD_TRACE_LEN) {
+            rc = ble_ll_hci_vs_rd_trace(rspbuf, rsplen);
+        }
+        break;
+#endif
+#if MYNEWT_VAL(BLE_LL_SCAN_ADV_FILT_NUM) > 0
+    case BLE_HCI_OCF_VS_SET_ADV_FILT_ENABLE:
+        if (len == BLE_HCI_VS_SET_ADV_FILT_ENABLE_LEN) {
+            rc = ble_ll_scan_adv_filt_enable(cmdbuf);
+        }
+        break;
+    case BLE_HCI_OCF_VS_ADD_ADV_FILT:
+        rc = ble_ll_scan_adv_filt_add(cmdbuf, len);
+        break;
+    case BLE_HCI_OCF_VS_CLEAR_ADV_FILT:
+        if (len == BLE_HCI_VS_CLEAR_ADV_FILT_LEN) {
+            rc = ble_ll_scan_adv_filt_clear();
+        }
+        break;
+#endif
+    default:
+        rc = BLE_ERR_UNKNOWN_HCI_CMD;
+        break;
+    }
+
+    (void)len;
+    (void)cmdbuf;
+    (void)rspbuf;
+
+    return rc;
+}
+#endif
+
 /**
  * Called to process an HCI command from the host.
  *
@@ -1202,6 +1377,11 @@ ble_ll_hci_cmd_proc(struct ble_npl_event *ev)
     case BLE_HCI_OGF_LE:
         rc = ble_ll_hci_le_cmd_proc(cmdbuf, ocf, &rsplen, &post_cb);
         break;
+#if MYNEWT_VAL(BLE_LL_HCI_VS)
+    case BLE_HCI_OGF_VENDOR:
+        rc = ble_ll_hci_vs_cmd_proc(cmdbuf, ocf, &rsplen);
+        break;
+#endif
     default:
         /* XXX: Need to support other OGF. For now, return unsupported */
         rc = BLE_ERR_UNKNOWN_HCI_CMD;
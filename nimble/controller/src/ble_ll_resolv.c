@@ -205,34 +205,6 @@ ble_ll_resolv_list_read_size(uint8_t *rspbuf, uint8_t *rsplen)
     return BLE_ERR_SUCCESS;
 }
 
-/**
- * Used to determine if the device is on the resolving list.
- *
- * @param addr
- * @param addr_type Public address (0) or random address (1)
- *
- * @return int 0: device is not on resolving list; otherwise the return value
- * is the 'position' of the device in the resolving list (the index of the
- * element plus 1).
- */
-static int
-ble_ll_is_on_resolv_list(uint8_t *addr, uint8_t addr_type)
-{
-    int i;
-    struct ble_ll_resolv_entry *rl;
-
-    rl = &g_ble_ll_resolv_list[0];
-    for (i = 0; i < g_ble_ll_resolv_data.rl_cnt; ++i) {
-        if ((rl->rl_addr_type == addr_type) &&
-            (!memcmp(&rl->rl_identity_addr[0], addr, BLE_DEV_ADDR_LEN))) {
-            return i + 1;
-        }
-        ++rl;
-    }
-
-    return 0;
-}
-
 /**
  * Used to determine if the device is on the resolving list.
  *
@@ -288,7 +260,7 @@ ble_ll_resolv_list_add(uint8_t *cmdbuf)
     /* spec is not clear on how to handle this but make sure host is aware
      * that new keys are not used in that case
      */
-    if (ble_ll_is_on_resolv_list(ident_addr, addr_type)) {
+    if (ble_ll_resolv_list_find(ident_addr, addr_type)) {
         return BLE_ERR_INV_HCI_CMD_PARMS;
     }
 
@@ -332,6 +304,7 @@ ble_ll_resolv_list_rmv(uint8_t *cmdbuf)
     int position;
     uint8_t addr_type;
     uint8_t *ident_addr;
+    struct ble_ll_resolv_entry *rl;
 
     /* Must be in proper state */
     if (!ble_ll_resolv_list_chg_allowed()) {
@@ -342,17 +315,17 @@ ble_ll_resolv_list_rmv(uint8_t *cmdbuf)
     ident_addr = cmdbuf + 1;
 
     /* Remove from IRK records */
-    position = ble_ll_is_on_resolv_list(ident_addr, addr_type);
-    if (position) {
-        BLE_LL_ASSERT(position <= g_ble_ll_resolv_data.rl_cnt);
+    rl = ble_ll_resolv_list_find(ident_addr, addr_type);
+    if (rl) {
+        position = rl - &g_ble_ll_resolv_list[0];
+        BLE_LL_ASSERT(position < g_ble_ll_resolv_data.rl_cnt);
 
-        memmove(&g_ble_ll_resolv_list[position - 1],
-                &g_ble_ll_resolv_list[position],
-                g_ble_ll_resolv_data.rl_cnt - position);
+        memmove(rl, rl + 1,
+                (g_ble_ll_resolv_data.rl_cnt - position - 1) * sizeof(*rl));
         --g_ble_ll_resolv_data.rl_cnt;
 
         /* Remove from HW list */
-        ble_hw_resolv_list_rmv(position - 1);
+        ble_hw_resolv_list_rmv(position);
         return BLE_ERR_SUCCESS;
     }
 
@@ -39,6 +39,9 @@
 #include "controller/ble_ll_resolv.h"
 #include "controller/ble_ll_xcvr.h"
 #include "ble_ll_conn_priv.h"
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+#include "ble_ll_sync_priv.h"
+#endif
 
 /*
  * XXX:
@@ -144,6 +147,45 @@ static uint8_t g_ble_ll_scan_num_dup_advs;
 struct ble_ll_scan_advertisers
 g_ble_ll_scan_dup_advs[MYNEWT_VAL(BLE_LL_NUM_SCAN_DUP_ADVS)];
 
+#if MYNEWT_VAL(BLE_LL_SCAN_RPT_BATCH_MS) > 0
+/*
+ * Advertising report event being filled with multiple reports. It is sent
+ * when full, when the batching timer expires or when scanning stops.
+ */
+#define BLE_LL_SCAN_RPT_BATCH_TICKS \
+    ble_npl_time_ms_to_ticks32(MYNEWT_VAL(BLE_LL_SCAN_RPT_BATCH_MS))
+
+static uint8_t *g_ble_ll_scan_rpt_evbuf;
+static struct ble_npl_callout g_ble_ll_scan_rpt_timer;
+#endif
+
+#if MYNEWT_VAL(BLE_LL_SCAN_ADV_FILT_NUM) > 255
+    #error "Cannot have more than 255 advertising report filters!"
+#endif
+
+#if MYNEWT_VAL(BLE_LL_SCAN_ADV_FILT_NUM) > 0
+/*
+ * Advertising report content filter. An AD filter matches if the PDU
+ * contains an AD structure of the given type whose data starts with the
+ * (masked) value; for UUID lists every UUID in the list is compared. An
+ * address filter matches the advertiser's identity address.
+ */
+struct ble_ll_scan_adv_filt
+{
+    uint8_t type;
+    uint8_t ad_type;
+    uint8_t len;
+    uint8_t value[BLE_HCI_VS_ADV_FILT_AD_MAX_LEN];
+    uint8_t mask[BLE_HCI_VS_ADV_FILT_AD_MAX_LEN];
+};
+
+static uint8_t g_ble_ll_scan_adv_filt_enabled;
+static int8_t g_ble_ll_scan_adv_filt_rssi;
+static uint8_t g_ble_ll_scan_num_adv_filts;
+static struct ble_ll_scan_adv_filt
+g_ble_ll_scan_adv_filts[MYNEWT_VAL(BLE_LL_SCAN_ADV_FILT_NUM)];
+#endif
+
 #if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_EXT_ADV)
 static os_membuf_t ext_adv_mem[ OS_MEMPOOL_SIZE(
                     MYNEWT_VAL(BLE_LL_EXT_ADV_AUX_PTR_CNT),
@@ -673,6 +715,94 @@ ble_ll_hci_send_legacy_ext_adv_report(uint8_t evtype,
 }
 #endif
 
+#if MYNEWT_VAL(BLE_LL_SCAN_RPT_BATCH_MS) > 0
+/**
+ * Send the pending batch of advertising reports, if any, to the host.
+ */
+static void
+ble_ll_scan_rpt_flush(void)
+{
+    uint8_t *evbuf;
+
+    ble_npl_callout_stop(&g_ble_ll_scan_rpt_timer);
+
+    evbuf = g_ble_ll_scan_rpt_evbuf;
+    if (evbuf) {
+        g_ble_ll_scan_rpt_evbuf = NULL;
+        ble_ll_hci_event_send(evbuf);
+    }
+}
+
+static void
+ble_ll_scan_rpt_timer_cb(struct ble_npl_event *ev)
+{
+    ble_ll_scan_rpt_flush();
+}
+
+/**
+ * Append an advertising report to the pending LE Advertising Report event,
+ * starting a new event if there is none or the report does not fit. Legacy
+ * reports carry a number of reports field, so several PDUs can share one
+ * event.
+ *
+ * @return int 0: report queued; -1 otherwise
+ */
+static int
+ble_ll_scan_rpt_batch(uint8_t evtype, uint8_t event_len, uint8_t addr_type,
+                      uint8_t *addr, uint8_t rssi, uint8_t adv_data_len,
+                      struct os_mbuf *adv_data)
+{
+    uint8_t *evbuf;
+    uint8_t *tmp;
+    uint8_t rpt_len;
+
+    /* Length of this report without the sub-event and number of reports */
+    rpt_len = event_len - 2;
+
+    evbuf = g_ble_ll_scan_rpt_evbuf;
+    if (evbuf && (evbuf[1] + 2 + rpt_len > MYNEWT_VAL(BLE_HCI_EVT_BUF_SIZE))) {
+        ble_ll_scan_rpt_flush();
+        evbuf = NULL;
+    }
+
+    if (!evbuf) {
+        evbuf = ble_hci_trans_buf_alloc(BLE_HCI_TRANS_BUF_EVT_LO);
+        if (!evbuf) {
+            return -1;
+        }
+
+        evbuf[0] = BLE_HCI_EVCODE_LE_META;
+        evbuf[1] = 2;
+        evbuf[2] = BLE_HCI_LE_SUBEV_ADV_RPT;
+        evbuf[3] = 0;   /* number of reports */
+
+        g_ble_ll_scan_rpt_evbuf = evbuf;
+        ble_npl_callout_reset(&g_ble_ll_scan_rpt_timer,
+                              BLE_LL_SCAN_RPT_BATCH_TICKS);
+    }
+
+    tmp = evbuf + 2 + evbuf[1];
+    tmp[0] = evtype;
+    tmp[1] = addr_type;
+    memcpy(&tmp[2], addr, BLE_DEV_ADDR_LEN);
+    tmp[8] = adv_data_len;
+    os_mbuf_copydata(adv_data, 0, adv_data_len, &tmp[9]);
+    tmp[9 + adv_data_len] = rssi;
+
+    evbuf[1] += rpt_len;
+    evbuf[3]++;
+
+    /* Send right away if not even an empty report would fit anymore */
+    if ((evbuf[3] == BLE_HCI_LE_ADV_RPT_NUM_RPTS_MAX) ||
+        (evbuf[1] + BLE_HCI_LE_ADV_RPT_MIN_LEN >
+         MYNEWT_VAL(BLE_HCI_EVT_BUF_SIZE))) {
+        ble_ll_scan_rpt_flush();
+    }
+
+    return 0;
+}
+#endif
+
 static int
 ble_ll_hci_send_adv_report(uint8_t subev, uint8_t evtype,uint8_t event_len,
                            uint8_t addr_type, uint8_t *addr, uint8_t rssi,
@@ -692,6 +822,16 @@ ble_ll_hci_send_adv_report(uint8_t subev, uint8_t evtype,uint8_t event_len,
         return -1;
     }
 
+#if MYNEWT_VAL(BLE_LL_SCAN_RPT_BATCH_MS) > 0
+    if (subev == BLE_HCI_LE_SUBEV_ADV_RPT) {
+        return ble_ll_scan_rpt_batch(evtype, event_len, addr_type, addr, rssi,
+                                     adv_data_len, adv_data);
+    }
+
+    /* Keep reports in order */
+    ble_ll_scan_rpt_flush();
+#endif
+
     evbuf = ble_hci_trans_buf_alloc(BLE_HCI_TRANS_BUF_EVT_LO);
     if (!evbuf) {
         return -1;
@@ -724,6 +864,221 @@ ble_ll_hci_send_adv_report(uint8_t subev, uint8_t evtype,uint8_t event_len,
 
     return ble_ll_hci_event_send(evbuf);
 }
+#if MYNEWT_VAL(BLE_LL_SCAN_ADV_FILT_NUM) > 0
+/**
+ * Enable or disable advertising report filtering.
+ *
+ * Command parameters: enable (1 byte), RSSI threshold (1 byte, signed).
+ *
+ * @param cmd
+ *
+ * @return int BLE error code
+ */
+int
+ble_ll_scan_adv_filt_enable(uint8_t *cmd)
+{
+    if (cmd[0] > 1) {
+        return BLE_ERR_INV_HCI_CMD_PARMS;
+    }
+
+    g_ble_ll_scan_adv_filt_enabled = cmd[0];
+    g_ble_ll_scan_adv_filt_rssi = (int8_t)cmd[1];
+
+    return BLE_ERR_SUCCESS;
+}
+
+/**
+ * Add an advertising report filter.
+ *
+ * Command parameters: filter type (1 byte), followed by either
+ * - AD type (1 byte), length (1 byte), value (length bytes) and mask
+ *   (length bytes), or
+ * - address type (1 byte) and address (6 bytes).
+ *
+ * @param cmd
+ * @param len
+ *
+ * @return int BLE error code
+ */
+int
+ble_ll_scan_adv_filt_add(uint8_t *cmd, uint8_t len)
+{
+    struct ble_ll_scan_adv_filt *filt;
+    uint8_t filt_len;
+
+    if (len < 1) {
+        return BLE_ERR_INV_HCI_CMD_PARMS;
+    }
+
+    switch (cmd[0]) {
+    case BLE_HCI_VS_ADV_FILT_TYPE_AD:
+        if (len < BLE_HCI_VS_ADD_ADV_FILT_AD_MIN_LEN) {
+            return BLE_ERR_INV_HCI_CMD_PARMS;
+        }
+        filt_len = cmd[2];
+        if ((filt_len > BLE_HCI_VS_ADV_FILT_AD_MAX_LEN) ||
+            (len != BLE_HCI_VS_ADD_ADV_FILT_AD_MIN_LEN + 2 * filt_len)) {
+            return BLE_ERR_INV_HCI_CMD_PARMS;
+        }
+        break;
+
+    case BLE_HCI_VS_ADV_FILT_TYPE_ADDR:
+        if ((len != BLE_HCI_VS_ADD_ADV_FILT_ADDR_LEN) || (cmd[1] > 1)) {
+            return BLE_ERR_INV_HCI_CMD_PARMS;
+        }
+        filt_len = BLE_DEV_ADDR_LEN;
+        break;
+
+    default:
+        return BLE_ERR_INV_HCI_CMD_PARMS;
+    }
+
+    if (g_ble_ll_scan_num_adv_filts == MYNEWT_VAL(BLE_LL_SCAN_ADV_FILT_NUM)) {
+        return BLE_ERR_MEM_CAPACITY;
+    }
+
+    filt = &g_ble_ll_scan_adv_filts[g_ble_ll_scan_num_adv_filts];
+    filt->type = cmd[0];
+    filt->ad_type = cmd[1];
+    filt->len = filt_len;
+
+    if (filt->type == BLE_HCI_VS_ADV_FILT_TYPE_AD) {
+        memcpy(filt->value, cmd + 3, filt_len);
+        memcpy(filt->mask, cmd + 3 + filt_len, filt_len);
+    } else {
+        memcpy(filt->value, cmd + 2, filt_len);
+    }
+
+    ++g_ble_ll_scan_num_adv_filts;
+
+    return BLE_ERR_SUCCESS;
+}
+
+/**
+ * Remove all advertising report filters. Filtering on RSSI, if enabled,
+ * remains in effect.
+ *
+ * @return int BLE error code
+ */
+int
+ble_ll_scan_adv_filt_clear(void)
+{
+    g_ble_ll_scan_num_adv_filts = 0;
+
+    return BLE_ERR_SUCCESS;
+}
+
+static int
+ble_ll_scan_adv_filt_ad_match(struct ble_ll_scan_adv_filt *filt,
+                              uint8_t *data, uint8_t len)
+{
+    uint8_t field_len;
+    uint8_t stride;
+    uint8_t *field;
+    int off;
+    int i;
+
+    while (len > 1) {
+        field_len = data[0];
+        if ((field_len == 0) || (field_len >= len)) {
+            break;
+        }
+
+        if (data[1] == filt->ad_type) {
+            field = data + 2;
+            field_len -= 1;
+
+            /*
+             * Lists of 16-bit, 32-bit and 128-bit service UUIDs (AD types
+             * 0x02 through 0x07) are searched element by element; any other
+             * AD structure is only compared from its start.
+             */
+            if ((filt->ad_type >= 0x02) && (filt->ad_type <= 0x07) &&
+                (filt->len > 0)) {
+                stride = filt->len;
+            } else {
+                stride = field_len + 1;
+            }
+
+            for (off = 0; off + filt->len <= field_len; off += stride) {
+                for (i = 0; i < filt->len; ++i) {
+                    if ((field[off + i] ^ filt->value[i]) & filt->mask[i]) {
+                        break;
+                    }
+                }
+                if (i == filt->len) {
+                    return 1;
+                }
+            }
+        }
+
+        len -= data[0] + 1;
+        data += data[0] + 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Checks a received legacy advertising PDU against the advertising report
+ * filters.
+ *
+ * @param ptype
+ * @param rxbuf
+ * @param hdr
+ * @param ident_addr
+ * @param ident_addr_type
+ *
+ * @return int 1: report allowed; 0: report should be dropped
+ */
+static int
+ble_ll_scan_adv_filt_match(uint8_t ptype, uint8_t *rxbuf,
+                           struct ble_mbuf_hdr *hdr, uint8_t *ident_addr,
+                           uint8_t ident_addr_type)
+{
+    struct ble_ll_scan_adv_filt *filt;
+    uint8_t *adv_data;
+    uint8_t adv_data_len;
+    int i;
+
+    if (!g_ble_ll_scan_adv_filt_enabled) {
+        return 1;
+    }
+
+    if (hdr->rxinfo.rssi < g_ble_ll_scan_adv_filt_rssi) {
+        return 0;
+    }
+
+    if (g_ble_ll_scan_num_adv_filts == 0) {
+        return 1;
+    }
+
+    if (ptype == BLE_ADV_PDU_TYPE_ADV_DIRECT_IND) {
+        adv_data = NULL;
+        adv_data_len = 0;
+    } else {
+        adv_data = rxbuf + BLE_LL_PDU_HDR_LEN + BLE_DEV_ADDR_LEN;
+        adv_data_len = rxbuf[1] - BLE_DEV_ADDR_LEN;
+    }
+
+    for (i = 0; i < g_ble_ll_scan_num_adv_filts; ++i) {
+        filt = &g_ble_ll_scan_adv_filts[i];
+
+        if (filt->type == BLE_HCI_VS_ADV_FILT_TYPE_ADDR) {
+            if ((filt->ad_type == ident_addr_type) &&
+                !memcmp(filt->value, ident_addr, BLE_DEV_ADDR_LEN)) {
+                return 1;
+            }
+        } else if (ble_ll_scan_adv_filt_ad_match(filt, adv_data,
+                                                 adv_data_len)) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+#endif
+
 /**
  * Send an advertising report to the host.
  *
@@ -1151,6 +1506,11 @@ ble_ll_scan_sm_stop(int chk_disable)
     OS_EXIT_CRITICAL(sr);
 #endif
 
+#if MYNEWT_VAL(BLE_LL_SCAN_RPT_BATCH_MS) > 0
+    /* Deliver reports still being batched */
+    ble_ll_scan_rpt_flush();
+#endif
+
     /* Count # of times stopped */
     STATS_INC(ble_ll_stats, scan_stops);
 
@@ -1828,7 +2188,15 @@ ble_ll_scan_parse_ext_hdr(struct os_mbuf *om, struct ble_mbuf_hdr *ble_hdr,
     }
 
     if (ext_hdr_flags & (1 << BLE_LL_EXT_ADV_SYNC_INFO_BIT)) {
-        /* TODO Handle periodic adv */
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+        out_evt->per_adv_itvl = get_le16(ext_hdr + i + 2);
+
+        ble_ll_sync_info_event(out_evt->addr_type, out_evt->addr,
+                               out_evt->sid,
+                               aux_data ? aux_data->aux_phy :
+                                          ble_hdr->rxinfo.phy,
+                               ble_hdr, ext_hdr + i);
+#endif
         i += BLE_LL_EXT_ADV_SYNC_INFO_SIZE;
     }
 
@@ -2524,6 +2892,15 @@ ble_ll_scan_rx_pkt_in(uint8_t ptype, struct os_mbuf *om, struct ble_mbuf_hdr *hd
     }
 #endif
 
+#if MYNEWT_VAL(BLE_LL_SCAN_ADV_FILT_NUM) > 0
+    /* Drop reports the host is not interested in */
+    if (!ble_ll_scan_adv_filt_match(ptype, rxbuf, hdr, ident_addr,
+                                    ident_addr_type)) {
+        STATS_INC(ble_ll_stats, scan_rpt_filtered);
+        goto scan_continue;
+    }
+#endif
+
     /* Send the advertising report */
     ble_ll_scan_send_adv_report(ptype, ident_addr_type, om, hdr, scansm);
 
@@ -3219,6 +3596,15 @@ ble_ll_scan_reset(void)
     /* Free the scan request pdu */
     os_mbuf_free_chain(scansm->scan_req_pdu);
 
+#if MYNEWT_VAL(BLE_LL_SCAN_RPT_BATCH_MS) > 0
+    /* Discard reports still being batched */
+    ble_npl_callout_stop(&g_ble_ll_scan_rpt_timer);
+    if (g_ble_ll_scan_rpt_evbuf) {
+        ble_hci_trans_buf_free(g_ble_ll_scan_rpt_evbuf);
+        g_ble_ll_scan_rpt_evbuf = NULL;
+    }
+#endif
+
     /* Reset duplicate advertisers and those from which we rxd a response */
     g_ble_ll_scan_num_rsp_advs = 0;
     memset(&g_ble_ll_scan_rsp_advs[0], 0, sizeof(g_ble_ll_scan_rsp_advs));
@@ -3226,6 +3612,12 @@ ble_ll_scan_reset(void)
     g_ble_ll_scan_num_dup_advs = 0;
     memset(&g_ble_ll_scan_dup_advs[0], 0, sizeof(g_ble_ll_scan_dup_advs));
 
+#if MYNEWT_VAL(BLE_LL_SCAN_ADV_FILT_NUM) > 0
+    /* Remove advertising report filters */
+    g_ble_ll_scan_adv_filt_enabled = 0;
+    g_ble_ll_scan_num_adv_filts = 0;
+#endif
+
 #if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_EXT_ADV)
     /* clear memory pool for AUX scan results */
     os_mempool_clear(&ext_adv_pool);
@@ -3255,5 +3647,10 @@ ble_ll_scan_init(void)
     BLE_LL_ASSERT(err == 0);
 #endif
 
+#if MYNEWT_VAL(BLE_LL_SCAN_RPT_BATCH_MS) > 0
+    ble_npl_callout_init(&g_ble_ll_scan_rpt_timer, &g_ble_ll_data.ll_evq,
+                         ble_ll_scan_rpt_timer_cb, NULL);
+#endif
+
     ble_ll_scan_common_init();
 }
@@ -31,6 +31,9 @@
 #include "controller/ble_ll_xcvr.h"
 #include "controller/ble_ll_trace.h"
 #include "ble_ll_conn_priv.h"
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+#include "ble_ll_sync_priv.h"
+#endif
 
 /* XXX: this is temporary. Not sure what I want to do here */
 struct hal_timer g_ble_ll_sched_timer;
@@ -51,6 +54,12 @@ int32_t g_ble_ll_sched_max_late;
 int32_t g_ble_ll_sched_max_early;
 #endif
 
+#if MYNEWT_VAL(BLE_LL_SCHED_STATS)
+/* Schedule statistics, indexed by schedule item type */
+static struct ble_ll_sched_stats
+    g_ble_ll_sched_stats[BLE_LL_SCHED_STATS_TYPES];
+#endif
+
 /* XXX: TODO:
  *  1) Add some accounting to the schedule code to see how late we are
  *  (min/max?)
@@ -70,6 +79,86 @@ TAILQ_HEAD(ll_sched_qhead, ble_ll_sched_item) g_ble_ll_sched_q;
 struct ble_ll_sched_obj g_ble_ll_sched_data;
 #endif
 
+/* Schedule events are only recorded when something consumes them */
+#define BLE_LL_SCHED_LOG    (MYNEWT_VAL(BLE_LL_SCHED_STATS) || \
+                             MYNEWT_VAL(BLE_LL_SYSVIEW) || BLE_LL_TRACE_RING)
+
+#if BLE_LL_SCHED_LOG
+/**
+ * Records the start of a schedule item and how late (in usecs) it was
+ * started compared to its scheduled start time. Early starts are counted as
+ * on time.
+ *
+ * Context: Interrupt
+ *
+ * @param sch Pointer to schedule item
+ * @param now Current cputime
+ */
+static void
+ble_ll_sched_log_exec(struct ble_ll_sched_item *sch, uint32_t now)
+{
+    int32_t dt;
+    int32_t late_usecs;
+#if MYNEWT_VAL(BLE_LL_SCHED_STATS)
+    int i;
+    struct ble_ll_sched_stats *stats;
+#endif
+
+    dt = (int32_t)(now - sch->start_time);
+    if (dt >= 0) {
+        late_usecs = (int32_t)os_cputime_ticks_to_usecs(dt);
+    } else {
+        late_usecs = -(int32_t)os_cputime_ticks_to_usecs(-dt);
+    }
+
+    ble_ll_trace_u32x2(BLE_LL_TRACE_ID_SCHED_EXEC, sch->sched_type,
+                       (uint32_t)late_usecs);
+
+#if MYNEWT_VAL(BLE_LL_SCHED_STATS)
+    stats = &g_ble_ll_sched_stats[sch->sched_type];
+    ++stats->executed;
+
+    for (i = 0; i < BLE_LL_SCHED_STATS_LATE_BUCKETS - 1; ++i) {
+        if (late_usecs <= (BLE_LL_SCHED_STATS_LATE_BUCKET_USECS << i)) {
+            break;
+        }
+    }
+    ++stats->late[i];
+#endif
+}
+#endif
+
+/**
+ * Records that a schedule item was moved to a new start time.
+ *
+ * @param sch Pointer to schedule item
+ */
+static void
+ble_ll_sched_log_resched(struct ble_ll_sched_item *sch)
+{
+    ble_ll_trace_u32x2(BLE_LL_TRACE_ID_SCHED_RESCHED, sch->sched_type,
+                       sch->start_time);
+#if MYNEWT_VAL(BLE_LL_SCHED_STATS)
+    ++g_ble_ll_sched_stats[sch->sched_type].rescheduled;
+#endif
+}
+
+/**
+ * Records that a schedule item was removed from the schedule, or could not be
+ * put on the schedule, because it overlaps other items.
+ *
+ * @param sch Pointer to schedule item
+ */
+static void
+ble_ll_sched_log_drop(struct ble_ll_sched_item *sch)
+{
+    ble_ll_trace_u32x2(BLE_LL_TRACE_ID_SCHED_DROP, sch->sched_type,
+                       sch->start_time);
+#if MYNEWT_VAL(BLE_LL_SCHED_STATS)
+    ++g_ble_ll_sched_stats[sch->sched_type].dropped;
+#endif
+}
+
 /**
  * Checks if two events in the schedule will overlap in time. NOTE: consecutive
  * schedule items can end and start at the same time.
@@ -133,6 +222,7 @@ ble_ll_sched_conn_overlap(struct ble_ll_sched_item *entry)
         entry->enqueued = 0;
         TAILQ_REMOVE(&g_ble_ll_sched_q, entry, link);
         ble_ll_event_send(&connsm->conn_ev_end);
+        ble_ll_sched_log_drop(entry);
         rc = 0;
     } else {
         rc = -1;
@@ -182,6 +272,7 @@ ble_ll_sched_conn_reschedule(struct ble_ll_conn_sm *connsm)
 
     /* Better be past current time or we just leave */
     if ((int32_t)(sch->start_time - os_cputime_get32()) < 0) {
+        ble_ll_sched_log_drop(sch);
         return -1;
     }
 
@@ -190,6 +281,7 @@ ble_ll_sched_conn_reschedule(struct ble_ll_conn_sm *connsm)
 
     if (ble_ll_sched_overlaps_current(sch)) {
         OS_EXIT_CRITICAL(sr);
+        ble_ll_sched_log_drop(sch);
         return -1;
     }
 
@@ -233,6 +325,9 @@ ble_ll_sched_conn_reschedule(struct ble_ll_conn_sm *connsm)
             TAILQ_INSERT_TAIL(&g_ble_ll_sched_q, sch, link);
         }
         sch->enqueued = 1;
+        ble_ll_sched_log_resched(sch);
+    } else {
+        ble_ll_sched_log_drop(sch);
     }
 
     /* Remove first to last scheduled elements */
@@ -253,6 +348,16 @@ ble_ll_sched_conn_reschedule(struct ble_ll_conn_sm *connsm)
                 ble_ll_scan_aux_data_free((struct ble_ll_aux_data *)
                                           entry->cb_arg);
                 break;
+#endif
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+            case BLE_LL_SCHED_TYPE_PERIODIC:
+                ble_ll_adv_periodic_rmvd_from_sched((struct ble_ll_adv_sm *)
+                                                    entry->cb_arg);
+                break;
+            case BLE_LL_SCHED_TYPE_SYNC:
+                ble_ll_sync_rmvd_from_sched((struct ble_ll_sync_sm *)
+                                            entry->cb_arg);
+                break;
 #endif
             default:
                 BLE_LL_ASSERT(0);
@@ -261,6 +366,7 @@ ble_ll_sched_conn_reschedule(struct ble_ll_conn_sm *connsm)
 
         TAILQ_REMOVE(&g_ble_ll_sched_q, entry, link);
         entry->enqueued = 0;
+        ble_ll_sched_log_drop(entry);
 
         if (entry == end_overlap) {
             break;
@@ -1012,6 +1118,7 @@ ble_ll_sched_adv_reschedule(struct ble_ll_sched_item *sch, uint32_t *start,
         }
         sch->end_time = sch->start_time + duration;
         *start = sch->start_time;
+        ble_ll_sched_log_resched(sch);
 
 #ifdef BLE_XCVR_RFCLK
         if (sch == TAILQ_FIRST(&g_ble_ll_sched_q)) {
@@ -1022,6 +1129,10 @@ ble_ll_sched_adv_reschedule(struct ble_ll_sched_item *sch, uint32_t *start,
 
     OS_EXIT_CRITICAL(sr);
 
+    if (rc) {
+        ble_ll_sched_log_drop(sch);
+    }
+
     sch = TAILQ_FIRST(&g_ble_ll_sched_q);
     os_cputime_timer_start(&g_ble_ll_sched_timer, sch->start_time);
 
@@ -1053,11 +1164,13 @@ ble_ll_sched_adv_resched_pdu(struct ble_ll_sched_item *sch)
     }
 
     OS_EXIT_CRITICAL(sr);
+    ble_ll_sched_log_resched(sch);
     os_cputime_timer_start(&g_ble_ll_sched_timer, sch->start_time);
     return 0;
 
 adv_resched_pdu_fail:
     OS_EXIT_CRITICAL(sr);
+    ble_ll_sched_log_drop(sch);
     return -1;
 }
 
@@ -1112,11 +1225,17 @@ ble_ll_sched_execute_item(struct ble_ll_sched_item *sch)
 {
     int rc;
     uint8_t lls;
+#if BLE_LL_SCHED_LOG
+    uint32_t now;
+#endif
 
     lls = ble_ll_state_get();
 
-    ble_ll_trace_u32x3(BLE_LL_TRACE_ID_SCHED, lls, os_cputime_get32(),
-                       sch->start_time);
+#if BLE_LL_SCHED_LOG
+    now = os_cputime_get32();
+    ble_ll_trace_u32x3(BLE_LL_TRACE_ID_SCHED, lls, now, sch->start_time);
+    ble_ll_sched_log_exec(sch, now);
+#endif
 
     if (lls == BLE_LL_STATE_STANDBY) {
         goto sched;
@@ -1156,6 +1275,11 @@ ble_ll_sched_execute_item(struct ble_ll_sched_item *sch)
     } else if (lls == BLE_LL_STATE_ADV) {
         STATS_INC(ble_ll_stats, sched_state_adv_errs);
         ble_ll_adv_halt();
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+    } else if (lls == BLE_LL_STATE_SYNC) {
+        STATS_INC(ble_ll_stats, sched_state_sync_errs);
+        ble_ll_sync_halt();
+#endif
     } else {
         STATS_INC(ble_ll_stats, sched_state_conn_errs);
         ble_ll_conn_event_halt();
@@ -1329,6 +1453,7 @@ ble_ll_sched_scan_req_over_aux_ptr(uint32_t chan, uint8_t phy_mode)
         ble_ll_scan_aux_data_free((struct ble_ll_aux_data *)sch->cb_arg);
         TAILQ_REMOVE(&g_ble_ll_sched_q, sch, link);
         sch->enqueued = 0;
+        ble_ll_sched_log_drop(sch);
         sch = TAILQ_FIRST(&g_ble_ll_sched_q);
     }
     return 0;
@@ -1414,6 +1539,7 @@ ble_ll_sched_aux_scan(struct ble_mbuf_hdr *ble_hdr,
          */
         if (ble_ll_sched_is_overlap(sch, entry)) {
             OS_EXIT_CRITICAL(sr);
+            ble_ll_sched_log_drop(sch);
             return -1;
         }
     }
@@ -1440,8 +1566,18 @@ done:
 }
 #endif
 
-#if MYNEWT_VAL(BLE_LL_DIRECT_TEST_MODE) == 1
-int ble_ll_sched_dtm(struct ble_ll_sched_item *sch)
+#if (MYNEWT_VAL(BLE_LL_DIRECT_TEST_MODE) == 1) || \
+    MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+/**
+ * Inserts an item at its requested time. The item is never moved; if it
+ * overlaps anything already on the schedule it is not inserted.
+ *
+ * @param sch Pointer to schedule item
+ *
+ * @return int 0: item was scheduled; -1 otherwise
+ */
+static int
+ble_ll_sched_insert_fixed(struct ble_ll_sched_item *sch)
 {
     int rc;
     os_sr_t sr;
@@ -1456,11 +1592,11 @@ int ble_ll_sched_dtm(struct ble_ll_sched_item *sch)
         goto done;
     }
 
-    /* Try to find slot for test. */
+    /* Try to find slot for the item. */
     os_cputime_timer_stop(&g_ble_ll_sched_timer);
     TAILQ_FOREACH(entry, &g_ble_ll_sched_q, link) {
         /* We can insert if before entry in list */
-        if (sch->end_time <= entry->start_time) {
+        if ((int32_t)(sch->end_time - entry->start_time) <= 0) {
             rc = 0;
             TAILQ_INSERT_BEFORE(entry, sch, link);
             sch->enqueued = 1;
@@ -1468,11 +1604,13 @@ int ble_ll_sched_dtm(struct ble_ll_sched_item *sch)
         }
 
         /* Check for overlapping events. For now drop if it overlaps with
-         * anything. We can make it smarter later on
+         * anything. We can make it smarter later on. The timer was stopped
+         * above so it still needs to be restarted.
          */
         if (ble_ll_sched_is_overlap(sch, entry)) {
-            OS_EXIT_CRITICAL(sr);
-            return -1;
+            ble_ll_sched_log_drop(sch);
+            rc = -1;
+            goto done;
         }
     }
 
@@ -1500,6 +1638,56 @@ done:
     return rc;
 }
 #endif
+
+#if MYNEWT_VAL(BLE_LL_DIRECT_TEST_MODE) == 1
+int ble_ll_sched_dtm(struct ble_ll_sched_item *sch)
+{
+    return ble_ll_sched_insert_fixed(sch);
+}
+#endif
+
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+int
+ble_ll_sched_periodic(struct ble_ll_sched_item *sch)
+{
+    return ble_ll_sched_insert_fixed(sch);
+}
+#endif
+
+#if MYNEWT_VAL(BLE_LL_SCHED_STATS)
+/**
+ * Reads the schedule statistics for a schedule item type.
+ *
+ * Context: Link Layer task
+ *
+ * @param sched_type The schedule item type (BLE_LL_SCHED_TYPE_xxx)
+ * @param stats Filled with the statistics of the item type
+ * @param reset If non-zero, statistics of the item type are cleared
+ *
+ * @return int 0: success; -1 if the type is not valid
+ */
+int
+ble_ll_sched_stats_get(uint8_t sched_type, struct ble_ll_sched_stats *stats,
+                       int reset)
+{
+    os_sr_t sr;
+
+    if ((sched_type == 0) || (sched_type >= BLE_LL_SCHED_STATS_TYPES)) {
+        return -1;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    *stats = g_ble_ll_sched_stats[sched_type];
+    if (reset) {
+        memset(&g_ble_ll_sched_stats[sched_type], 0,
+               sizeof(g_ble_ll_sched_stats[sched_type]));
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return 0;
+}
+#endif
+
 /**
  * Stop the scheduler
  *
@@ -1529,6 +1717,10 @@ ble_ll_sched_init(void)
     g_ble_ll_sched_max_early = -50000;
 #endif
 
+#if MYNEWT_VAL(BLE_LL_SCHED_STATS)
+    memset(g_ble_ll_sched_stats, 0, sizeof(g_ble_ll_sched_stats));
+#endif
+
     /*
      * This is the offset from the start of the scheduled item until the actual
      * tx/rx should occur, in ticks. We also "round up" to the nearest tick.
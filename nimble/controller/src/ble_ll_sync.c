@@ -0,0 +1,952 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+
+#include "os/os.h"
+#include "nimble/ble.h"
+#include "nimble/hci_common.h"
+#include "nimble/ble_hci_trans.h"
+#include "controller/ble_phy.h"
+#include "controller/ble_hw.h"
+#include "controller/ble_ll.h"
+#include "controller/ble_ll_adv.h"
+#include "controller/ble_ll_hci.h"
+#include "controller/ble_ll_sched.h"
+#include "controller/ble_ll_scan.h"
+#include "ble_ll_conn_priv.h"
+#include "ble_ll_sync_priv.h"
+
+/*
+ * Synchronization to periodic advertising trains.
+ *
+ * The periodic advertising train is located using the SyncInfo field of an
+ * AUX_ADV_IND received by the extended scanner, so a sync is only established
+ * while the host has extended scanning enabled. Only the AUX_SYNC_IND of each
+ * periodic advertising event is received; AUX_CHAIN_IND PDUs are not followed
+ * and data which would continue in them is reported as truncated.
+ */
+
+#define BLE_LL_SYNC_CNT MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV_SYNC_CNT)
+
+/* Number of events to wait for first PDU before giving up (Vol 6, Part B 4.3.5) */
+#define BLE_LL_SYNC_ESTABLISH_CNT       (6)
+
+#define BLE_LL_SYNC_SM_FLAG_RESERVED    (0x01)
+#define BLE_LL_SYNC_SM_FLAG_ESTABLISHING (0x02)
+#define BLE_LL_SYNC_SM_FLAG_ESTABLISHED (0x04)
+#define BLE_LL_SYNC_SM_FLAG_SYNC_INFO   (0x08)
+#define BLE_LL_SYNC_SM_FLAG_RX          (0x10)
+
+struct ble_ll_sync_sm {
+    uint8_t flags;
+
+    uint8_t adv_sid;
+    uint8_t adv_addr_type;
+    uint8_t adv_addr[BLE_DEV_ADDR_LEN];
+    uint16_t skip;
+    uint16_t timeout;
+
+    uint8_t phy;
+    uint8_t phy_mode;
+    uint8_t sca;
+    uint8_t chanmap[BLE_LL_CONN_CHMAP_LEN];
+    uint8_t num_used_chans;
+    uint8_t chan_index;
+    uint16_t channel_id;
+    uint32_t access_addr;
+    uint32_t crcinit;
+
+    uint16_t itvl;
+    uint8_t itvl_usecs;
+    uint32_t itvl_ticks;
+
+    uint16_t event_cntr;
+    uint16_t first_event_cntr;
+    uint32_t anchor_point;
+    uint8_t anchor_point_usecs;
+    uint32_t last_anchor_point;
+    uint32_t rx_cputime;
+    uint8_t rx_usecs;
+
+    /* Uncertainty of the anchor until the first PDU is received (usecs) */
+    uint16_t offset_window;
+    uint32_t window_widening;
+
+    struct ble_ll_sched_item sch;
+    struct ble_npl_event sync_ev_end;
+};
+
+static struct ble_ll_sync_sm g_ble_ll_sync_sm[BLE_LL_SYNC_CNT];
+
+/* Sync being established (set by create sync command) */
+static struct ble_ll_sync_sm *g_ble_ll_sync_create_sm;
+
+/* Sync whose event is currently running */
+static struct ble_ll_sync_sm *g_ble_ll_sync_sm_current;
+
+static uint16_t
+ble_ll_sync_get_handle(struct ble_ll_sync_sm *sm)
+{
+    return sm - g_ble_ll_sync_sm;
+}
+
+static void
+ble_ll_sync_sm_clear(struct ble_ll_sync_sm *sm)
+{
+    os_sr_t sr;
+
+    ble_ll_sched_rmv_elem(&sm->sch);
+
+    OS_ENTER_CRITICAL(sr);
+    if (g_ble_ll_sync_sm_current == sm) {
+        ble_phy_disable();
+        ble_ll_wfr_disable();
+        ble_ll_state_set(BLE_LL_STATE_STANDBY);
+        g_ble_ll_sync_sm_current = NULL;
+        ble_ll_scan_chk_resume();
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    ble_npl_eventq_remove(&g_ble_ll_data.ll_evq, &sm->sync_ev_end);
+
+    if (g_ble_ll_sync_create_sm == sm) {
+        g_ble_ll_sync_create_sm = NULL;
+    }
+
+    sm->flags = 0;
+}
+
+static void
+ble_ll_sync_est_event_send(struct ble_ll_sync_sm *sm, uint8_t status)
+{
+    uint8_t *evbuf;
+
+    if (!ble_ll_hci_is_le_event_enabled(BLE_HCI_LE_SUBEV_PER_ADV_SYNC_ESTAB)) {
+        return;
+    }
+
+    evbuf = ble_hci_trans_buf_alloc(BLE_HCI_TRANS_BUF_EVT_HI);
+    if (!evbuf) {
+        return;
+    }
+
+    memset(evbuf, 0, BLE_HCI_EVENT_HDR_LEN +
+                     BLE_HCI_LE_SUBEV_PER_ADV_SYNC_ESTAB_LEN);
+
+    evbuf[0] = BLE_HCI_EVCODE_LE_META;
+    evbuf[1] = BLE_HCI_LE_SUBEV_PER_ADV_SYNC_ESTAB_LEN;
+    evbuf[2] = BLE_HCI_LE_SUBEV_PER_ADV_SYNC_ESTAB;
+    evbuf[3] = status;
+
+    if (sm && (status == BLE_ERR_SUCCESS)) {
+        put_le16(evbuf + 4, ble_ll_sync_get_handle(sm));
+        evbuf[6] = sm->adv_sid;
+        evbuf[7] = sm->adv_addr_type;
+        memcpy(evbuf + 8, sm->adv_addr, BLE_DEV_ADDR_LEN);
+        evbuf[14] = sm->phy;
+        put_le16(evbuf + 15, sm->itvl);
+        evbuf[17] = sm->sca;
+    }
+
+    ble_ll_hci_event_send(evbuf);
+}
+
+static void
+ble_ll_sync_lost_event_send(struct ble_ll_sync_sm *sm)
+{
+    uint8_t *evbuf;
+
+    if (!ble_ll_hci_is_le_event_enabled(BLE_HCI_LE_SUBEV_PER_ADV_SYNC_LOST)) {
+        return;
+    }
+
+    evbuf = ble_hci_trans_buf_alloc(BLE_HCI_TRANS_BUF_EVT_HI);
+    if (evbuf) {
+        evbuf[0] = BLE_HCI_EVCODE_LE_META;
+        evbuf[1] = BLE_HCI_LE_SUBEV_PER_ADV_SYNC_LOST_LEN;
+        evbuf[2] = BLE_HCI_LE_SUBEV_PER_ADV_SYNC_LOST;
+        put_le16(evbuf + 3, ble_ll_sync_get_handle(sm));
+        ble_ll_hci_event_send(evbuf);
+    }
+}
+
+/**
+ * Marks the sync as established and informs the host.
+ *
+ * Context: Link Layer task
+ */
+static void
+ble_ll_sync_established(struct ble_ll_sync_sm *sm)
+{
+    BLE_LL_ASSERT(sm->flags & BLE_LL_SYNC_SM_FLAG_ESTABLISHING);
+
+    sm->flags &= ~BLE_LL_SYNC_SM_FLAG_ESTABLISHING;
+    sm->flags |= BLE_LL_SYNC_SM_FLAG_ESTABLISHED;
+
+    if (g_ble_ll_sync_create_sm == sm) {
+        g_ble_ll_sync_create_sm = NULL;
+    }
+
+    ble_ll_sync_est_event_send(sm, BLE_ERR_SUCCESS);
+}
+
+/**
+ * Sends periodic advertising report(s) for a received AUX_SYNC_IND. Data
+ * which does not fit in a single HCI event is fragmented.
+ */
+static void
+ble_ll_sync_send_per_adv_rpt(struct ble_ll_sync_sm *sm, struct os_mbuf *rxpdu,
+                             int8_t rssi)
+{
+    uint8_t *rxbuf;
+    uint8_t *evbuf;
+    uint8_t *next_evbuf;
+    uint8_t ext_hdr_flags;
+    uint8_t ext_hdr_len;
+    uint8_t pdu_len;
+    uint8_t data_status;
+    uint8_t tx_power;
+    uint8_t datalen;
+    uint8_t offset;
+    uint8_t len;
+    uint8_t *data;
+    int i;
+
+    if (!ble_ll_hci_is_le_event_enabled(BLE_HCI_LE_SUBEV_PER_ADV_RPT)) {
+        return;
+    }
+
+    rxbuf = rxpdu->om_data;
+    pdu_len = rxbuf[1];
+    ext_hdr_len = rxbuf[2] & 0x3F;
+
+    if (pdu_len < ext_hdr_len + 1) {
+        return;
+    }
+
+    tx_power = 0x7F;
+    data_status = BLE_HCI_PER_ADV_DATA_STATUS_COMPLETE;
+
+    if (ext_hdr_len) {
+        ext_hdr_flags = rxbuf[3];
+        i = 4;
+
+        if (ext_hdr_flags & (1 << BLE_LL_EXT_ADV_ADVA_BIT)) {
+            i += BLE_LL_EXT_ADV_ADVA_SIZE;
+        }
+
+        if (ext_hdr_flags & (1 << BLE_LL_EXT_ADV_TARGETA_BIT)) {
+            i += BLE_LL_EXT_ADV_TARGETA_SIZE;
+        }
+
+        if (ext_hdr_flags & (1 << BLE_LL_EXT_ADV_RFU_BIT)) {
+            i += 1;
+        }
+
+        if (ext_hdr_flags & (1 << BLE_LL_EXT_ADV_DATA_INFO_BIT)) {
+            i += BLE_LL_EXT_ADV_DATA_INFO_SIZE;
+        }
+
+        /* Chained PDUs are not received, so data continuing there is lost */
+        if (ext_hdr_flags & (1 << BLE_LL_EXT_ADV_AUX_PTR_BIT)) {
+            data_status = BLE_HCI_PER_ADV_DATA_STATUS_TRUNCATED;
+            i += BLE_LL_EXT_ADV_AUX_PTR_SIZE;
+        }
+
+        if (ext_hdr_flags & (1 << BLE_LL_EXT_ADV_SYNC_INFO_BIT)) {
+            i += BLE_LL_EXT_ADV_SYNC_INFO_SIZE;
+        }
+
+        if (ext_hdr_flags & (1 << BLE_LL_EXT_ADV_TX_POWER_BIT)) {
+            if (i < 3 + ext_hdr_len) {
+                tx_power = rxbuf[i];
+            }
+        }
+    }
+
+    data = rxbuf + 3 + ext_hdr_len;
+    datalen = pdu_len - ext_hdr_len - 1;
+    offset = 0;
+
+    evbuf = ble_hci_trans_buf_alloc(BLE_HCI_TRANS_BUF_EVT_LO);
+
+    while (evbuf) {
+        next_evbuf = NULL;
+
+        len = min(BLE_LL_MAX_EVT_LEN - BLE_HCI_EVENT_HDR_LEN -
+                  BLE_HCI_LE_SUBEV_PER_ADV_RPT_LEN, datalen - offset);
+
+        evbuf[0] = BLE_HCI_EVCODE_LE_META;
+        evbuf[1] = BLE_HCI_LE_SUBEV_PER_ADV_RPT_LEN + len;
+        evbuf[2] = BLE_HCI_LE_SUBEV_PER_ADV_RPT;
+        put_le16(evbuf + 3, ble_ll_sync_get_handle(sm));
+        evbuf[5] = tx_power;
+        evbuf[6] = rssi;
+        evbuf[7] = 0xFF; /* unused */
+        evbuf[9] = len;
+        memcpy(evbuf + 10, data + offset, len);
+
+        offset += len;
+
+        if (offset < datalen) {
+            next_evbuf = ble_hci_trans_buf_alloc(BLE_HCI_TRANS_BUF_EVT_LO);
+            if (next_evbuf) {
+                evbuf[8] = BLE_HCI_PER_ADV_DATA_STATUS_INCOMPLETE;
+            } else {
+                evbuf[8] = BLE_HCI_PER_ADV_DATA_STATUS_TRUNCATED;
+            }
+        } else {
+            evbuf[8] = data_status;
+        }
+
+        ble_ll_hci_event_send(evbuf);
+
+        evbuf = next_evbuf;
+    }
+}
+
+static void
+ble_ll_sync_advance(struct ble_ll_sync_sm *sm)
+{
+    sm->anchor_point += sm->itvl_ticks;
+    sm->anchor_point_usecs += sm->itvl_usecs;
+    if (sm->anchor_point_usecs >= 31) {
+        sm->anchor_point_usecs -= 31;
+        sm->anchor_point++;
+    }
+    sm->event_cntr++;
+}
+
+static uint32_t
+ble_ll_sync_calc_window_widening(struct ble_ll_sync_sm *sm)
+{
+    uint32_t total_sca_ppm;
+    uint32_t delta_msec;
+    int32_t time_since_last_anchor;
+
+    time_since_last_anchor = (int32_t)(sm->anchor_point -
+                                       sm->last_anchor_point);
+    if (time_since_last_anchor <= 0) {
+        return 0;
+    }
+
+    delta_msec = os_cputime_ticks_to_usecs(time_since_last_anchor) / 1000;
+    total_sca_ppm = g_ble_sca_ppm_tbl[sm->sca] + MYNEWT_VAL(BLE_LL_OUR_SCA);
+
+    return (total_sca_ppm * delta_msec) / 1000;
+}
+
+/**
+ * Scheduler callback which starts the receive window of a periodic
+ * advertising event.
+ *
+ * Context: Interrupt (scheduler)
+ */
+static int
+ble_ll_sync_event_start_cb(struct ble_ll_sched_item *sch)
+{
+    struct ble_ll_sync_sm *sm;
+    uint32_t start;
+    uint32_t usecs;
+    int rc;
+
+    sm = sch->cb_arg;
+
+    ble_ll_state_set(BLE_LL_STATE_SYNC);
+    g_ble_ll_sync_sm_current = sm;
+
+    rc = ble_phy_setchan(sm->chan_index, sm->access_addr, sm->crcinit);
+    BLE_LL_ASSERT(rc == 0);
+
+#if (BLE_LL_BT5_PHY_SUPPORTED == 1)
+    ble_phy_mode_set(sm->phy_mode, sm->phy_mode);
+#endif
+
+#if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_ENCRYPTION) == 1)
+    ble_phy_encrypt_disable();
+#endif
+
+#if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PRIVACY) == 1)
+    ble_phy_resolv_list_disable();
+#endif
+
+    start = sch->start_time + g_ble_ll_sched_offset_ticks;
+    rc = ble_phy_rx_set_start_time(start, sch->remainder);
+    if (rc) {
+        ble_phy_disable();
+        ble_ll_state_set(BLE_LL_STATE_STANDBY);
+        g_ble_ll_sync_sm_current = NULL;
+        ble_ll_event_send(&sm->sync_ev_end);
+        return BLE_LL_SCHED_STATE_DONE;
+    }
+
+    /*
+     * Receiver is enabled window widening before the anchor point. Wait for
+     * the widened window on both sides of the anchor point plus the anchor
+     * uncertainty left from SyncInfo. The 61 usecs account for the ticks
+     * lost in conversions, same as for slave connection events.
+     */
+    usecs = 61 + (2 * sm->window_widening) + sm->offset_window;
+    ble_phy_wfr_enable(BLE_PHY_WFR_ENABLE_RX, 0, usecs);
+
+    return BLE_LL_SCHED_STATE_RUNNING;
+}
+
+/**
+ * Puts the sync event at the current anchor point on the scheduler. Events
+ * which already passed or which overlap other scheduled items are skipped.
+ *
+ * Context: Link Layer task
+ *
+ * @return int BLE error code which terminates the sync; 0 on success
+ */
+static int
+ble_ll_sync_schedule(struct ble_ll_sync_sm *sm)
+{
+    struct ble_ll_sched_item *sch;
+    uint32_t since_last_usecs;
+    uint32_t max_ww;
+    uint32_t usecs;
+
+    sch = &sm->sch;
+    max_ww = (sm->itvl * (BLE_LL_ADV_PERIODIC_ITVL / 2)) - BLE_LL_IFS;
+
+    while (1) {
+        if ((sm->flags & BLE_LL_SYNC_SM_FLAG_ESTABLISHING) &&
+            ((uint16_t)(sm->event_cntr - sm->first_event_cntr) >=
+             BLE_LL_SYNC_ESTABLISH_CNT)) {
+            return BLE_ERR_CONN_ESTABLISHMENT;
+        }
+
+        since_last_usecs = os_cputime_ticks_to_usecs(sm->anchor_point -
+                                                     sm->last_anchor_point);
+        if (since_last_usecs > (uint32_t)sm->timeout * 10000) {
+            return BLE_ERR_CONN_SPVN_TMO;
+        }
+
+        sm->window_widening = ble_ll_sync_calc_window_widening(sm);
+        if (sm->window_widening >= max_ww) {
+            return BLE_ERR_CONN_SPVN_TMO;
+        }
+        sm->window_widening += BLE_LL_JITTER_USECS;
+
+        sm->chan_index = ble_ll_conn_calc_dci_csa2_chan(sm->event_cntr,
+                                                        sm->channel_id,
+                                                        sm->num_used_chans,
+                                                        sm->chanmap);
+
+        usecs = sm->window_widening + sm->anchor_point_usecs;
+        sch->start_time = sm->anchor_point - g_ble_ll_sched_offset_ticks -
+                          os_cputime_usecs_to_ticks(sm->window_widening) - 1;
+        sch->remainder = 0;
+
+        usecs += sm->window_widening + sm->offset_window +
+                 ble_ll_pdu_tx_time_get(BLE_LL_MAX_PAYLOAD_LEN, sm->phy_mode);
+        sch->end_time = sm->anchor_point +
+                        ble_ll_usecs_to_ticks_round_up(usecs);
+
+        if (((int32_t)(sch->start_time - os_cputime_get32()) > 0) &&
+            (ble_ll_sched_periodic(sch) == 0)) {
+            return 0;
+        }
+
+        ble_ll_sync_advance(sm);
+    }
+}
+
+/**
+ * Called when a sync event has ended or was removed from the scheduler.
+ * Moves to the next event, or terminates the sync if it was not established
+ * in time or was lost.
+ *
+ * Context: Link Layer task
+ */
+static void
+ble_ll_sync_event_end(struct ble_npl_event *ev)
+{
+    struct ble_ll_sync_sm *sm;
+    uint16_t skip;
+    os_sr_t sr;
+    int rc;
+
+    sm = ble_npl_event_get_arg(ev);
+
+    ble_ll_scan_chk_resume();
+
+    if (!(sm->flags & (BLE_LL_SYNC_SM_FLAG_ESTABLISHING |
+                       BLE_LL_SYNC_SM_FLAG_ESTABLISHED))) {
+        return;
+    }
+
+    skip = 0;
+
+    OS_ENTER_CRITICAL(sr);
+    if (sm->flags & BLE_LL_SYNC_SM_FLAG_RX) {
+        sm->flags &= ~BLE_LL_SYNC_SM_FLAG_RX;
+        sm->anchor_point = sm->rx_cputime;
+        sm->anchor_point_usecs = sm->rx_usecs;
+        sm->last_anchor_point = sm->anchor_point;
+        sm->offset_window = 0;
+        OS_EXIT_CRITICAL(sr);
+
+        /* Report may have been lost if no buffer was available for PDU */
+        if (sm->flags & BLE_LL_SYNC_SM_FLAG_ESTABLISHING) {
+            ble_ll_sync_established(sm);
+        }
+
+        skip = sm->skip;
+    } else {
+        OS_EXIT_CRITICAL(sr);
+    }
+
+    do {
+        ble_ll_sync_advance(sm);
+    } while (skip--);
+
+    rc = ble_ll_sync_schedule(sm);
+    if (rc) {
+        if (sm->flags & BLE_LL_SYNC_SM_FLAG_ESTABLISHING) {
+            ble_ll_sync_est_event_send(sm, rc);
+        } else {
+            ble_ll_sync_lost_event_send(sm);
+        }
+        ble_ll_sync_sm_clear(sm);
+    }
+}
+
+static void
+ble_ll_sync_current_sm_over(void)
+{
+    struct ble_ll_sync_sm *sm;
+
+    sm = g_ble_ll_sync_sm_current;
+
+    ble_phy_disable();
+    ble_ll_state_set(BLE_LL_STATE_STANDBY);
+    g_ble_ll_sync_sm_current = NULL;
+
+    if (sm) {
+        ble_ll_event_send(&sm->sync_ev_end);
+    }
+}
+
+/**
+ * Reads the channel map of a SyncInfo field. Its last octet also carries the
+ * advertiser's SCA, which is masked off.
+ *
+ * @return uint8_t Number of used channels
+ */
+uint8_t
+ble_ll_sync_info_chanmap(const uint8_t *syncinfo, uint8_t *chanmap)
+{
+    memcpy(chanmap, &syncinfo[4], BLE_LL_CONN_CHMAP_LEN);
+    chanmap[4] &= 0x1f;
+
+    return ble_ll_conn_calc_used_chans(chanmap);
+}
+
+/**
+ * Called by the scanner when SyncInfo was received in an AUX_ADV_IND. If it
+ * comes from the advertiser requested by create sync command the sync
+ * procedure is started.
+ *
+ * Context: Link Layer task
+ */
+void
+ble_ll_sync_info_event(uint8_t addr_type, const uint8_t *addr, uint8_t sid,
+                       uint8_t phy, struct ble_mbuf_hdr *rxhdr,
+                       const uint8_t *syncinfo)
+{
+    struct ble_ll_sync_sm *sm;
+    uint32_t offset_usecs;
+    uint32_t itvl_usecs;
+    uint32_t ticks;
+    uint16_t offset;
+    uint16_t itvl;
+    uint8_t units;
+    uint8_t chanmap[BLE_LL_CONN_CHMAP_LEN];
+    uint8_t num_used_chans;
+    int rc;
+
+    sm = g_ble_ll_sync_create_sm;
+    if (!sm || (sm->flags & BLE_LL_SYNC_SM_FLAG_SYNC_INFO)) {
+        return;
+    }
+
+    if ((sm->adv_sid != sid) || (sm->adv_addr_type != addr_type) ||
+        memcmp(sm->adv_addr, addr, BLE_DEV_ADDR_LEN)) {
+        return;
+    }
+
+    /* Offset of 0 means SyncInfo is not valid */
+    offset = get_le16(&syncinfo[0]) & 0x1fff;
+    if (offset == 0) {
+        return;
+    }
+
+    itvl = get_le16(&syncinfo[2]);
+    if (itvl < BLE_HCI_LE_SET_PER_ADV_ITVL_MIN) {
+        return;
+    }
+
+    num_used_chans = ble_ll_sync_info_chanmap(syncinfo, chanmap);
+    if (num_used_chans < 2) {
+        return;
+    }
+
+    units = (syncinfo[1] & 0x20) ? 1 : 0;
+    offset_usecs = offset * (units ? 300 : 30);
+    if (syncinfo[1] & 0x40) {
+        offset_usecs += 2457600;
+    }
+
+    sm->flags |= BLE_LL_SYNC_SM_FLAG_SYNC_INFO;
+
+    sm->phy = phy;
+    sm->phy_mode = ble_ll_phy_to_phy_mode(phy, BLE_HCI_LE_PHY_CODED_ANY);
+    memcpy(sm->chanmap, chanmap, BLE_LL_CONN_CHMAP_LEN);
+    sm->num_used_chans = num_used_chans;
+    sm->sca = syncinfo[8] >> 5;
+    sm->access_addr = get_le32(&syncinfo[9]);
+    sm->channel_id = ((sm->access_addr & 0xffff0000) >> 16) ^
+                     (sm->access_addr & 0x0000ffff);
+    sm->crcinit = syncinfo[13] | (syncinfo[14] << 8) |
+                  ((uint32_t)syncinfo[15] << 16);
+    sm->event_cntr = get_le16(&syncinfo[16]);
+    sm->first_event_cntr = sm->event_cntr;
+
+    sm->itvl = itvl;
+    itvl_usecs = (uint32_t)itvl * BLE_LL_ADV_PERIODIC_ITVL;
+    ticks = os_cputime_usecs_to_ticks(itvl_usecs);
+    sm->itvl_usecs = itvl_usecs - os_cputime_ticks_to_usecs(ticks);
+    if (sm->itvl_usecs == 31) {
+        sm->itvl_usecs = 0;
+        ticks++;
+    }
+    sm->itvl_ticks = ticks;
+
+    /* Anchor point is offset from the start of the AUX_ADV_IND */
+    offset_usecs += rxhdr->rem_usecs;
+    ticks = os_cputime_usecs_to_ticks(offset_usecs);
+    sm->anchor_point = rxhdr->beg_cputime + ticks;
+    sm->anchor_point_usecs = offset_usecs - os_cputime_ticks_to_usecs(ticks);
+    if (sm->anchor_point_usecs >= 31) {
+        sm->anchor_point++;
+        sm->anchor_point_usecs -= 31;
+    }
+    sm->last_anchor_point = sm->anchor_point;
+
+    /* Advertiser can start anywhere within one offset unit */
+    sm->offset_window = units ? 300 : 30;
+
+    rc = ble_ll_sync_schedule(sm);
+    if (rc) {
+        ble_ll_sync_est_event_send(sm, rc);
+        ble_ll_sync_sm_clear(sm);
+    }
+}
+
+int
+ble_ll_sync_rx_isr_start(uint8_t pdu_type, struct ble_mbuf_hdr *rxhdr)
+{
+    if (!g_ble_ll_sync_sm_current) {
+        STATS_INC(ble_ll_stats, bad_ll_state);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Called when a PDU reception has ended while in sync state. Only a single
+ * PDU is received per event so the event always ends here.
+ *
+ * Context: Interrupt
+ */
+int
+ble_ll_sync_rx_isr_end(uint8_t *rxbuf, struct ble_mbuf_hdr *rxhdr)
+{
+    struct ble_ll_sync_sm *sm;
+    struct os_mbuf *rxpdu;
+    uint8_t pdu_type;
+
+    sm = g_ble_ll_sync_sm_current;
+    if (!sm) {
+        return -1;
+    }
+
+    pdu_type = rxbuf[0] & BLE_ADV_PDU_HDR_TYPE_MASK;
+
+    if (BLE_MBUF_HDR_CRC_OK(rxhdr) &&
+        (pdu_type == BLE_ADV_PDU_TYPE_AUX_SYNC_IND)) {
+        sm->flags |= BLE_LL_SYNC_SM_FLAG_RX;
+        sm->rx_cputime = rxhdr->beg_cputime;
+        sm->rx_usecs = rxhdr->rem_usecs;
+
+        rxhdr->rxinfo.handle = ble_ll_sync_get_handle(sm);
+
+        rxpdu = ble_ll_rxpdu_alloc(rxbuf[1] + BLE_LL_PDU_HDR_LEN);
+        if (rxpdu) {
+            ble_phy_rxpdu_copy(rxbuf, rxpdu);
+            ble_ll_rx_pdu_in(rxpdu);
+        }
+    }
+
+    ble_ll_sync_current_sm_over();
+
+    return -1;
+}
+
+/**
+ * Process a PDU received in periodic advertising event.
+ *
+ * Context: Link Layer task
+ */
+void
+ble_ll_sync_rx_pkt_in(struct os_mbuf *rxpdu, struct ble_mbuf_hdr *hdr)
+{
+    struct ble_ll_sync_sm *sm;
+
+    if (!BLE_MBUF_HDR_CRC_OK(hdr) ||
+        (hdr->rxinfo.handle >= BLE_LL_SYNC_CNT)) {
+        return;
+    }
+
+    sm = &g_ble_ll_sync_sm[hdr->rxinfo.handle];
+    if (!(sm->flags & BLE_LL_SYNC_SM_FLAG_SYNC_INFO)) {
+        return;
+    }
+
+    if (sm->flags & BLE_LL_SYNC_SM_FLAG_ESTABLISHING) {
+        ble_ll_sync_established(sm);
+    }
+
+    if (!(sm->flags & BLE_LL_SYNC_SM_FLAG_ESTABLISHED)) {
+        return;
+    }
+
+    ble_ll_sync_send_per_adv_rpt(sm, rxpdu, hdr->rxinfo.rssi);
+}
+
+void
+ble_ll_sync_wfr_timer_exp(void)
+{
+    ble_ll_sync_current_sm_over();
+}
+
+/*
+ * Called when the scheduler needs the radio while sync event is running.
+ *
+ * Context: Interrupt
+ */
+void
+ble_ll_sync_halt(void)
+{
+    ble_ll_sync_current_sm_over();
+}
+
+/*
+ * Called when a sync event has been removed from the scheduler without
+ * being run.
+ */
+void
+ble_ll_sync_rmvd_from_sched(struct ble_ll_sync_sm *sm)
+{
+    ble_ll_event_send(&sm->sync_ev_end);
+}
+
+/**
+ * HCI LE periodic advertising create sync command
+ *
+ * Context: Link Layer task (HCI command parser)
+ *
+ * @return int BLE error code
+ */
+int
+ble_ll_sync_create(uint8_t *cmdbuf)
+{
+    struct ble_ll_sync_sm *sm;
+    uint16_t timeout;
+    uint16_t skip;
+    uint8_t options;
+    uint8_t sid;
+    uint8_t addr_type;
+    int i;
+
+    if (g_ble_ll_sync_create_sm) {
+        return BLE_ERR_CMD_DISALLOWED;
+    }
+
+    options = cmdbuf[0];
+    sid = cmdbuf[1];
+    addr_type = cmdbuf[2];
+    skip = get_le16(&cmdbuf[9]);
+    timeout = get_le16(&cmdbuf[11]);
+
+    /* Periodic advertiser list is not supported */
+    if (options & BLE_HCI_LE_PER_ADV_CREATE_SYNC_OPT_FILTER) {
+        return BLE_ERR_UNSUPPORTED;
+    }
+
+    if (options & ~BLE_HCI_LE_PER_ADV_CREATE_SYNC_OPT_FILTER) {
+        return BLE_ERR_INV_HCI_CMD_PARMS;
+    }
+
+    if ((sid > 0x0f) || (addr_type > BLE_HCI_ADV_PEER_ADDR_RANDOM) ||
+        (skip > BLE_HCI_LE_PER_ADV_SKIP_MAX) ||
+        (timeout < BLE_HCI_LE_PER_ADV_SYNC_TIMEOUT_MIN) ||
+        (timeout > BLE_HCI_LE_PER_ADV_SYNC_TIMEOUT_MAX)) {
+        return BLE_ERR_INV_HCI_CMD_PARMS;
+    }
+
+    sm = NULL;
+    for (i = 0; i < BLE_LL_SYNC_CNT; i++) {
+        if (!g_ble_ll_sync_sm[i].flags) {
+            if (!sm) {
+                sm = &g_ble_ll_sync_sm[i];
+            }
+            continue;
+        }
+
+        if ((g_ble_ll_sync_sm[i].adv_sid == sid) &&
+            (g_ble_ll_sync_sm[i].adv_addr_type == addr_type) &&
+            !memcmp(g_ble_ll_sync_sm[i].adv_addr, &cmdbuf[3],
+                    BLE_DEV_ADDR_LEN)) {
+            return BLE_ERR_ACL_CONN_EXISTS;
+        }
+    }
+
+    if (!sm) {
+        return BLE_ERR_MEM_CAPACITY;
+    }
+
+    sm->adv_sid = sid;
+    sm->adv_addr_type = addr_type;
+    memcpy(sm->adv_addr, &cmdbuf[3], BLE_DEV_ADDR_LEN);
+    sm->skip = skip;
+    sm->timeout = timeout;
+    sm->flags = BLE_LL_SYNC_SM_FLAG_RESERVED |
+                BLE_LL_SYNC_SM_FLAG_ESTABLISHING;
+
+    g_ble_ll_sync_create_sm = sm;
+
+    return BLE_ERR_SUCCESS;
+}
+
+static void
+ble_ll_sync_cancel_complete_event(void)
+{
+    ble_ll_sync_est_event_send(NULL, BLE_ERR_OPERATION_CANCELLED);
+}
+
+/**
+ * HCI LE periodic advertising create sync cancel command
+ *
+ * Context: Link Layer task (HCI command parser)
+ *
+ * @return int BLE error code
+ */
+int
+ble_ll_sync_cancel(ble_ll_hci_post_cmd_complete_cb *post_cmd_cb)
+{
+    if (!g_ble_ll_sync_create_sm) {
+        return BLE_ERR_CMD_DISALLOWED;
+    }
+
+    ble_ll_sync_sm_clear(g_ble_ll_sync_create_sm);
+
+    /* Sync established event is sent after command complete */
+    *post_cmd_cb = ble_ll_sync_cancel_complete_event;
+
+    return BLE_ERR_SUCCESS;
+}
+
+/**
+ * HCI LE periodic advertising terminate sync command
+ *
+ * Context: Link Layer task (HCI command parser)
+ *
+ * @return int BLE error code
+ */
+int
+ble_ll_sync_terminate(uint8_t *cmdbuf)
+{
+    struct ble_ll_sync_sm *sm;
+    uint16_t handle;
+
+    handle = get_le16(cmdbuf);
+    if (handle >= BLE_LL_SYNC_CNT) {
+        return BLE_ERR_UNK_ADV_INDENT;
+    }
+
+    sm = &g_ble_ll_sync_sm[handle];
+
+    if (sm->flags & BLE_LL_SYNC_SM_FLAG_ESTABLISHING) {
+        return BLE_ERR_CMD_DISALLOWED;
+    }
+
+    if (!(sm->flags & BLE_LL_SYNC_SM_FLAG_ESTABLISHED)) {
+        return BLE_ERR_UNK_ADV_INDENT;
+    }
+
+    ble_ll_sync_sm_clear(sm);
+
+    return BLE_ERR_SUCCESS;
+}
+
+void
+ble_ll_sync_reset(void)
+{
+    int i;
+
+    for (i = 0; i < BLE_LL_SYNC_CNT; i++) {
+        if (g_ble_ll_sync_sm[i].flags) {
+            ble_ll_sync_sm_clear(&g_ble_ll_sync_sm[i]);
+        }
+    }
+
+    g_ble_ll_sync_create_sm = NULL;
+    g_ble_ll_sync_sm_current = NULL;
+}
+
+void
+ble_ll_sync_init(void)
+{
+    struct ble_ll_sync_sm *sm;
+    int i;
+
+    for (i = 0; i < BLE_LL_SYNC_CNT; i++) {
+        sm = &g_ble_ll_sync_sm[i];
+
+        memset(sm, 0, sizeof(*sm));
+
+        ble_npl_event_init(&sm->sync_ev_end, ble_ll_sync_event_end, sm);
+
+        sm->sch.sched_type = BLE_LL_SCHED_TYPE_SYNC;
+        sm->sch.sched_cb = ble_ll_sync_event_start_cb;
+        sm->sch.cb_arg = sm;
+    }
+}
+#endif
@@ -19,7 +19,10 @@
 
 #include <stdint.h>
 #include "syscfg/syscfg.h"
+#include "os/os.h"
+#include "os/os_cputime.h"
 #include "os/os_trace_api.h"
+#include "controller/ble_ll_trace.h"
 
 #if MYNEWT_VAL(BLE_LL_SYSVIEW)
 
@@ -41,13 +44,120 @@ ble_ll_trace_module_send_desc(void)
     os_trace_module_desc(&g_ble_ll_trace_mod, "9 ll_conn_rx conn_sn=%u pdu_nesn=%u");
     os_trace_module_desc(&g_ble_ll_trace_mod, "10 ll_adv_txdone inst=%u chanset=%x");
     os_trace_module_desc(&g_ble_ll_trace_mod, "11 ll_adv_halt inst=%u");
+    os_trace_module_desc(&g_ble_ll_trace_mod, "12 ll_sched_exec type=%u late_usecs=%d");
+    os_trace_module_desc(&g_ble_ll_trace_mod, "13 ll_sched_resched type=%u start_time=%u");
+    os_trace_module_desc(&g_ble_ll_trace_mod, "14 ll_sched_drop type=%u start_time=%u");
 }
+#endif
+
+#if BLE_LL_TRACE_RING
+
+struct ble_ll_trace_rec
+{
+    uint32_t cputime;
+    uint32_t p1;
+    uint32_t p2;
+    uint32_t p3;
+    uint8_t id;
+};
+
+/*
+ * Binary trace ring. The ring always holds the most recent records; when it
+ * is full the oldest record is overwritten and counted as lost. Records are
+ * read out (and removed) using a vendor specific HCI command.
+ */
+static struct ble_ll_trace_rec g_ble_ll_trace_ring[MYNEWT_VAL(BLE_LL_TRACE_RING_SIZE)];
+static uint16_t g_ble_ll_trace_ring_head;
+static uint16_t g_ble_ll_trace_ring_cnt;
+static uint32_t g_ble_ll_trace_ring_lost;
 
+void
+ble_ll_trace_ring_add(unsigned id, uint32_t p1, uint32_t p2, uint32_t p3)
+{
+    os_sr_t sr;
+    uint16_t idx;
+    struct ble_ll_trace_rec *rec;
+
+    OS_ENTER_CRITICAL(sr);
+
+    idx = g_ble_ll_trace_ring_head + g_ble_ll_trace_ring_cnt;
+    if (idx >= MYNEWT_VAL(BLE_LL_TRACE_RING_SIZE)) {
+        idx -= MYNEWT_VAL(BLE_LL_TRACE_RING_SIZE);
+    }
+
+    if (g_ble_ll_trace_ring_cnt == MYNEWT_VAL(BLE_LL_TRACE_RING_SIZE)) {
+        /* Ring full; overwrite oldest record */
+        ++g_ble_ll_trace_ring_head;
+        if (g_ble_ll_trace_ring_head == MYNEWT_VAL(BLE_LL_TRACE_RING_SIZE)) {
+            g_ble_ll_trace_ring_head = 0;
+        }
+        ++g_ble_ll_trace_ring_lost;
+    } else {
+        ++g_ble_ll_trace_ring_cnt;
+    }
+
+    rec = &g_ble_ll_trace_ring[idx];
+    rec->cputime = os_cputime_get32();
+    rec->id = id;
+    rec->p1 = p1;
+    rec->p2 = p2;
+    rec->p3 = p3;
+
+    OS_EXIT_CRITICAL(sr);
+}
+
+int
+ble_ll_trace_ring_read(uint8_t *dst, int max_recs, uint32_t *lost)
+{
+    int cnt;
+    os_sr_t sr;
+    struct ble_ll_trace_rec *rec;
+
+    cnt = 0;
+
+    OS_ENTER_CRITICAL(sr);
+
+    *lost = g_ble_ll_trace_ring_lost;
+    g_ble_ll_trace_ring_lost = 0;
+
+    while ((cnt < max_recs) && (g_ble_ll_trace_ring_cnt > 0)) {
+        rec = &g_ble_ll_trace_ring[g_ble_ll_trace_ring_head];
+
+        put_le32(dst, rec->cputime);
+        dst[4] = rec->id;
+        put_le32(dst + 5, rec->p1);
+        put_le32(dst + 9, rec->p2);
+        put_le32(dst + 13, rec->p3);
+        dst += BLE_LL_TRACE_RING_REC_LEN;
+
+        ++g_ble_ll_trace_ring_head;
+        if (g_ble_ll_trace_ring_head == MYNEWT_VAL(BLE_LL_TRACE_RING_SIZE)) {
+            g_ble_ll_trace_ring_head = 0;
+        }
+        --g_ble_ll_trace_ring_cnt;
+        ++cnt;
+    }
+
+    OS_EXIT_CRITICAL(sr);
+
+    return cnt;
+}
+#endif
+
+#if MYNEWT_VAL(BLE_LL_SYSVIEW) || BLE_LL_TRACE_RING
 void
 ble_ll_trace_init(void)
 {
+#if MYNEWT_VAL(BLE_LL_SYSVIEW)
     ble_ll_trace_off =
-            os_trace_module_register(&g_ble_ll_trace_mod, "ble_ll", 12,
+            os_trace_module_register(&g_ble_ll_trace_mod, "ble_ll",
+                                     BLE_LL_TRACE_ID_CNT,
                                      ble_ll_trace_module_send_desc);
+#endif
+#if BLE_LL_TRACE_RING
+    g_ble_ll_trace_ring_head = 0;
+    g_ble_ll_trace_ring_cnt = 0;
+    g_ble_ll_trace_ring_lost = 0;
+#endif
 }
 #endif
@@ -185,34 +185,46 @@ ble_ll_whitelist_add(uint8_t *addr, uint8_t addr_type)
     int i;
     int rc;
     struct ble_ll_whitelist_entry *wl;
+    struct ble_ll_whitelist_entry *free_wl;
 
     /* Must be in proper state */
     if (!ble_ll_whitelist_chg_allowed()) {
         return BLE_ERR_CMD_DISALLOWED;
     }
 
-    /* Check if we have any open entries */
-    rc = BLE_ERR_SUCCESS;
-    if (!ble_ll_whitelist_search(addr, addr_type)) {
-        wl = &g_ble_ll_whitelist[0];
-        for (i = 0; i < BLE_LL_WHITELIST_SIZE; ++i) {
-            if (wl->wl_valid == 0) {
-                memcpy(&wl->wl_dev_addr[0], addr, BLE_DEV_ADDR_LEN);
-                wl->wl_addr_type = addr_type;
-                wl->wl_valid = 1;
-                break;
+    /*
+     * Look for a duplicate and the first open entry in a single pass over the
+     * whitelist. When the host loads many devices back to back this halves
+     * the number of entries visited per add.
+     */
+    free_wl = NULL;
+    wl = &g_ble_ll_whitelist[0];
+    for (i = 0; i < BLE_LL_WHITELIST_SIZE; ++i) {
+        if (wl->wl_valid) {
+            if ((wl->wl_addr_type == addr_type) &&
+                (!memcmp(&wl->wl_dev_addr[0], addr, BLE_DEV_ADDR_LEN))) {
+                /* Already on the whitelist */
+                return BLE_ERR_SUCCESS;
             }
-            ++wl;
+        } else if (free_wl == NULL) {
+            free_wl = wl;
         }
+        ++wl;
+    }
 
-        if (i == BLE_LL_WHITELIST_SIZE) {
-            rc = BLE_ERR_MEM_CAPACITY;
-        } else {
+    /* Check if we have any open entries */
+    if (free_wl == NULL) {
+        return BLE_ERR_MEM_CAPACITY;
+    }
+
+    memcpy(&free_wl->wl_dev_addr[0], addr, BLE_DEV_ADDR_LEN);
+    free_wl->wl_addr_type = addr_type;
+    free_wl->wl_valid = 1;
+
+    rc = BLE_ERR_SUCCESS;
 #if (BLE_USES_HW_WHITELIST == 1)
-            rc = ble_hw_whitelist_add(addr, addr_type);
+    rc = ble_hw_whitelist_add(addr, addr_type);
 #endif
-        }
-    }
 
     return rc;
 }
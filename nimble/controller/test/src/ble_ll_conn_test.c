@@ -0,0 +1,209 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "testutil/testutil.h"
+#include "controller/ble_ll_test.h"
+#include "controller/ble_ll.h"
+#include "controller/ble_ll_conn.h"
+#include "controller/ble_ll_sched.h"
+#include "ble_ll_conn_priv.h"
+
+#define BLE_LL_CONN_TEST_ANCHOR     (1000)
+
+static void
+ble_ll_conn_test_util_init(struct ble_ll_conn_sm *connsm, uint16_t itvl,
+                           uint16_t min_ce_len, uint16_t max_ce_len)
+{
+    memset(connsm, 0, sizeof *connsm);
+    connsm->conn_itvl = itvl;
+    connsm->ce_len_slots = MYNEWT_VAL(BLE_LL_CONN_INIT_SLOTS);
+    ble_ll_conn_set_ce_len(connsm, min_ce_len, max_ce_len);
+}
+
+/**
+ * Ends a connection event that lasted the given number of ticks from the
+ * anchor point and lets the connection adapt its reserved length.
+ */
+static void
+ble_ll_conn_test_util_event(struct ble_ll_conn_sm *connsm, uint32_t used,
+                            int truncated)
+{
+    connsm->anchor_point = BLE_LL_CONN_TEST_ANCHOR;
+    connsm->ce_end_time = connsm->anchor_point +
+        connsm->ce_len_slots * BLE_LL_SCHED_32KHZ_TICKS_PER_SLOT;
+    connsm->ce_last_end_time = connsm->anchor_point + used;
+    connsm->csmflags.cfbit.ce_truncated = truncated;
+
+    ble_ll_conn_ce_len_update(connsm);
+}
+
+/** Ends a connection event that used exactly its reservation. */
+static void
+ble_ll_conn_test_util_event_full(struct ble_ll_conn_sm *connsm)
+{
+    ble_ll_conn_test_util_event(connsm, connsm->ce_len_slots *
+                                        BLE_LL_SCHED_32KHZ_TICKS_PER_SLOT, 0);
+}
+
+TEST_CASE(ble_ll_conn_test_ce_len_grow)
+{
+    struct ble_ll_conn_sm conn;
+    int i;
+
+    /* No CE length from the host: adapt up to half the interval. */
+    ble_ll_conn_test_util_init(&conn, 40, 0, 0);
+
+    /* An event that fits its reservation changes nothing. */
+    ble_ll_conn_test_util_event_full(&conn);
+    TEST_ASSERT(conn.ce_len_slots == MYNEWT_VAL(BLE_LL_CONN_INIT_SLOTS));
+    TEST_ASSERT(conn.ce_truncated_cnt == 0);
+    TEST_ASSERT(conn.ce_extended_cnt == 0);
+
+    /* Cut short with data pending. */
+    ble_ll_conn_test_util_event(&conn, 0, 1);
+    TEST_ASSERT(conn.csmflags.cfbit.ce_truncated == 0);
+    TEST_ASSERT(conn.ce_truncated_cnt == 1);
+#if !MYNEWT_VAL(BLE_LL_STRICT_CONN_SCHEDULING)
+    TEST_ASSERT(conn.ce_len_slots == MYNEWT_VAL(BLE_LL_CONN_INIT_SLOTS) + 1);
+#endif
+
+    /* Overran the reservation. */
+    ble_ll_conn_test_util_event(&conn, (conn.ce_len_slots + 1) *
+                                       BLE_LL_SCHED_32KHZ_TICKS_PER_SLOT, 0);
+    TEST_ASSERT(conn.ce_extended_cnt == 1);
+#if !MYNEWT_VAL(BLE_LL_STRICT_CONN_SCHEDULING)
+    TEST_ASSERT(conn.ce_len_slots == MYNEWT_VAL(BLE_LL_CONN_INIT_SLOTS) + 2);
+
+    /* Never grows past half the interval. */
+    for (i = 0; i < 40; i++) {
+        ble_ll_conn_test_util_event(&conn, 0, 1);
+    }
+    TEST_ASSERT(conn.ce_len_slots == 20);
+#else
+    (void)i;
+
+    /* Strict scheduling keeps its fixed periods. */
+    TEST_ASSERT(conn.ce_len_slots == MYNEWT_VAL(BLE_LL_CONN_INIT_SLOTS));
+#endif
+}
+
+TEST_CASE(ble_ll_conn_test_ce_len_shrink)
+{
+    struct ble_ll_conn_sm conn;
+    uint32_t used;
+    int i;
+
+    ble_ll_conn_test_util_init(&conn, 40, 0, 0);
+    conn.ce_len_slots = 10;
+
+    /* One event short of the shrink threshold. */
+    used = BLE_LL_SCHED_32KHZ_TICKS_PER_SLOT;
+    for (i = 0; i < BLE_LL_CONN_CE_SHRINK_EVENTS - 1; i++) {
+        ble_ll_conn_test_util_event(&conn, used, 0);
+    }
+    TEST_ASSERT(conn.ce_len_slots == 10);
+
+    /* An event using at least half the reservation restarts the count. */
+    ble_ll_conn_test_util_event(&conn, 5 * BLE_LL_SCHED_32KHZ_TICKS_PER_SLOT,
+                                0);
+    TEST_ASSERT(conn.ce_short_cnt == 0);
+    for (i = 0; i < BLE_LL_CONN_CE_SHRINK_EVENTS - 1; i++) {
+        ble_ll_conn_test_util_event(&conn, used, 0);
+    }
+    TEST_ASSERT(conn.ce_len_slots == 10);
+
+    /* So does a truncated event, which also grows the reservation. */
+    ble_ll_conn_test_util_event(&conn, used, 1);
+    TEST_ASSERT(conn.ce_short_cnt == 0);
+#if !MYNEWT_VAL(BLE_LL_STRICT_CONN_SCHEDULING)
+    TEST_ASSERT(conn.ce_len_slots == 11);
+
+    for (i = 0; i < BLE_LL_CONN_CE_SHRINK_EVENTS - 1; i++) {
+        ble_ll_conn_test_util_event(&conn, used, 0);
+    }
+    TEST_ASSERT(conn.ce_len_slots == 11);
+    ble_ll_conn_test_util_event(&conn, used, 0);
+    TEST_ASSERT(conn.ce_len_slots == 10);
+    TEST_ASSERT(conn.ce_short_cnt == 0);
+
+    /* Never shrinks below the initial allocation. */
+    for (i = 0; i < 20 * BLE_LL_CONN_CE_SHRINK_EVENTS; i++) {
+        ble_ll_conn_test_util_event(&conn, 0, 0);
+    }
+    TEST_ASSERT(conn.ce_len_slots == MYNEWT_VAL(BLE_LL_CONN_INIT_SLOTS));
+#else
+    TEST_ASSERT(conn.ce_len_slots == 10);
+#endif
+}
+
+TEST_CASE(ble_ll_conn_test_ce_len_host_bounds)
+{
+    struct ble_ll_conn_sm conn;
+    int i;
+
+    /*
+     * The host asked for 10 to 20 msecs (0x10 to 0x20 in 0.625 msec units),
+     * i.e. 8 to 16 slots.
+     */
+    ble_ll_conn_test_util_init(&conn, 40, 0x10, 0x20);
+
+    ble_ll_conn_test_util_event_full(&conn);
+#if !MYNEWT_VAL(BLE_LL_STRICT_CONN_SCHEDULING)
+    TEST_ASSERT(conn.ce_len_slots == 8);
+
+    for (i = 0; i < 40; i++) {
+        ble_ll_conn_test_util_event(&conn, 0, 1);
+    }
+    TEST_ASSERT(conn.ce_len_slots == 16);
+
+    for (i = 0; i < 40 * BLE_LL_CONN_CE_SHRINK_EVENTS; i++) {
+        ble_ll_conn_test_util_event(&conn, 0, 0);
+    }
+    TEST_ASSERT(conn.ce_len_slots == 8);
+
+    /* The reservation never covers the whole interval. */
+    ble_ll_conn_test_util_init(&conn, 6, 0x20, 0x40);
+    ble_ll_conn_test_util_event_full(&conn);
+    TEST_ASSERT(conn.ce_len_slots == 5);
+    for (i = 0; i < 10; i++) {
+        ble_ll_conn_test_util_event(&conn, 0, 1);
+    }
+    TEST_ASSERT(conn.ce_len_slots == 5);
+#else
+    (void)i;
+    TEST_ASSERT(conn.ce_len_slots == MYNEWT_VAL(BLE_LL_CONN_INIT_SLOTS));
+#endif
+}
+
+TEST_SUITE(ble_ll_conn_test_suite)
+{
+    ble_ll_conn_test_ce_len_grow();
+    ble_ll_conn_test_ce_len_shrink();
+    ble_ll_conn_test_ce_len_host_bounds();
+}
+
+int
+ble_ll_conn_test_all(void)
+{
+    ble_ll_conn_test_suite();
+
+    return tu_any_failed;
+}
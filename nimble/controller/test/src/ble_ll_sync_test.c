@@ -0,0 +1,149 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#include <stddef.h>
+#include <string.h>
+#include "testutil/testutil.h"
+#include "controller/ble_ll_test.h"
+#include "controller/ble_ll.h"
+#include "controller/ble_ll_conn.h"
+#include "controller/ble_phy.h"
+#include "ble_ll_conn_priv.h"
+#include "ble_ll_sync_priv.h"
+
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+
+/* Access address used by the CSA #2 sample data (Vol 6, Part C 3) */
+#define BLE_LL_SYNC_TEST_AA         (0x8e89bed6)
+
+/**
+ * Picks the channel of a periodic advertising event the way the sync does:
+ * channel parameters are taken from the SyncInfo field sent by the
+ * advertiser.
+ */
+static uint8_t
+ble_ll_sync_test_util_chan(const uint8_t *syncinfo, uint16_t event_cntr)
+{
+    uint8_t chanmap[BLE_LL_CONN_CHMAP_LEN];
+    uint16_t channel_id;
+    uint8_t num_used_chans;
+    uint32_t aa;
+
+    num_used_chans = ble_ll_sync_info_chanmap(syncinfo, chanmap);
+
+    aa = get_le32(&syncinfo[9]);
+    channel_id = ((aa & 0xffff0000) >> 16) ^ (aa & 0x0000ffff);
+
+    return ble_ll_conn_calc_dci_csa2_chan(event_cntr, channel_id,
+                                          num_used_chans, chanmap);
+}
+
+static void
+ble_ll_sync_test_util_syncinfo(uint8_t *syncinfo, const uint8_t *chanmap,
+                               uint8_t sca)
+{
+    memset(syncinfo, 0, BLE_LL_EXT_ADV_SYNC_INFO_SIZE);
+    memcpy(&syncinfo[4], chanmap, BLE_LL_CONN_CHMAP_LEN);
+    syncinfo[8] |= sca << 5;
+    put_le32(&syncinfo[9], BLE_LL_SYNC_TEST_AA);
+}
+
+TEST_CASE(ble_ll_sync_test_chan_sample)
+{
+    const uint8_t all_chans[BLE_LL_CONN_CHMAP_LEN] = {
+        0xff, 0xff, 0xff, 0xff, 0x1f
+    };
+    const uint8_t nine_chans[BLE_LL_CONN_CHMAP_LEN] = {
+        0x00, 0x06, 0xe0, 0x00, 0x1e
+    };
+    uint8_t syncinfo[BLE_LL_EXT_ADV_SYNC_INFO_SIZE];
+    uint8_t sca;
+
+    /*
+     * Sample data from CoreSpec 5.0 Vol 6 Part C 3.1 and 3.2. The SCA shares
+     * the last channel map octet, so check with none and all of its bits set.
+     */
+    for (sca = 0; sca <= 7; sca += 7) {
+        ble_ll_sync_test_util_syncinfo(syncinfo, all_chans, sca);
+        TEST_ASSERT(ble_ll_sync_test_util_chan(syncinfo, 1) == 20);
+        TEST_ASSERT(ble_ll_sync_test_util_chan(syncinfo, 2) == 6);
+        TEST_ASSERT(ble_ll_sync_test_util_chan(syncinfo, 3) == 21);
+
+        ble_ll_sync_test_util_syncinfo(syncinfo, nine_chans, sca);
+        TEST_ASSERT(ble_ll_sync_test_util_chan(syncinfo, 6) == 23);
+        TEST_ASSERT(ble_ll_sync_test_util_chan(syncinfo, 7) == 9);
+        TEST_ASSERT(ble_ll_sync_test_util_chan(syncinfo, 8) == 34);
+    }
+}
+
+TEST_CASE(ble_ll_sync_test_chan_map)
+{
+    /* Channels 0 and 36 only: the smallest map a sync accepts */
+    const uint8_t two_chans[BLE_LL_CONN_CHMAP_LEN] = {
+        0x01, 0x00, 0x00, 0x00, 0x10
+    };
+    uint8_t syncinfo[BLE_LL_EXT_ADV_SYNC_INFO_SIZE];
+    uint8_t chanmap[BLE_LL_CONN_CHMAP_LEN];
+    uint32_t counts[BLE_PHY_NUM_DATA_CHANS];
+    uint32_t event_cntr;
+    uint8_t chan;
+
+    ble_ll_sync_test_util_syncinfo(syncinfo, two_chans, 7);
+    TEST_ASSERT(ble_ll_sync_info_chanmap(syncinfo, chanmap) == 2);
+    TEST_ASSERT(memcmp(chanmap, two_chans, sizeof chanmap) == 0);
+
+    /*
+     * Every event of the train, including the counter wrapping, lands on a
+     * used channel and both channels get their share of the events.
+     */
+    memset(counts, 0, sizeof counts);
+    for (event_cntr = 0; event_cntr <= UINT16_MAX; event_cntr++) {
+        chan = ble_ll_sync_test_util_chan(syncinfo, event_cntr);
+        TEST_ASSERT_FATAL(chan < BLE_PHY_NUM_DATA_CHANS);
+        counts[chan]++;
+    }
+
+    TEST_ASSERT(counts[0] + counts[36] == UINT16_MAX + 1);
+    TEST_ASSERT(counts[0] > (UINT16_MAX + 1) / 4);
+    TEST_ASSERT(counts[36] > (UINT16_MAX + 1) / 4);
+
+    /* A single used channel is not a valid periodic channel map. */
+    chanmap[0] = 0x00;
+    ble_ll_sync_test_util_syncinfo(syncinfo, chanmap, 7);
+    TEST_ASSERT(ble_ll_sync_info_chanmap(syncinfo, chanmap) == 1);
+}
+
+TEST_SUITE(ble_ll_sync_test_suite)
+{
+    ble_ll_sync_test_chan_sample();
+    ble_ll_sync_test_chan_map();
+}
+
+#endif
+
+int
+ble_ll_sync_test_all(void)
+{
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PERIODIC_ADV)
+    ble_ll_sync_test_suite();
+#endif
+
+    return tu_any_failed;
+}
@@ -31,6 +31,8 @@ main(int argc, char **argv)
     sysinit();
 
     ble_ll_csa2_test_all();
+    ble_ll_conn_test_all();
+    ble_ll_sync_test_all();
 
     return tu_any_failed;
 }
@@ -0,0 +1,253 @@
+#!/usr/bin/env python3
+#
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+#
+
+"""
+Reads the NimBLE controller trace ring and schedule statistics over HCI and
+converts trace records to a timeline in the Chrome trace event format, which
+can be viewed with chrome://tracing or https://ui.perfetto.dev.
+
+The controller must be built with BLE_LL_HCI_VS=1 and BLE_LL_TRACE_RING_SIZE
+(and/or BLE_LL_SCHED_STATS) set. Reading from a local HCI device requires
+Linux and sufficient privileges to open a raw HCI socket.
+
+Examples:
+    ble_ll_trace.py --dev 0 --poll 10 -o trace.json
+    ble_ll_trace.py --dev 0 --stats
+    ble_ll_trace.py --input records.bin -o trace.json
+"""
+
+import argparse
+import json
+import socket
+import struct
+import sys
+import time
+
+HCI_OGF_VENDOR = 0x3f
+HCI_OCF_VS_RD_SCHED_STATS = 0x0001
+HCI_OCF_VS_RD_TRACE = 0x0002
+
+HCI_COMMAND_PKT = 0x01
+HCI_EVENT_PKT = 0x04
+HCI_EV_CMD_COMPLETE = 0x0e
+
+SOL_HCI = 0
+HCI_FILTER = 2
+
+TRACE_REC = struct.Struct('<IBIII')
+
+TRACE_IDS = {
+    0: ('ll_sched', ('lls', 'cputime', 'start_time')),
+    1: ('ll_rx_start', ('lls', 'pdu_type')),
+    2: ('ll_rx_end', ('pdu_type', 'len', 'flags')),
+    3: ('ll_wfr_timer_exp', ('lls', 'xcvr', 'rx_start')),
+    4: ('ll_ctrl_rx', ('opcode', 'len')),
+    5: ('ll_conn_ev_start', ('conn_handle',)),
+    6: ('ll_conn_ev_end', ('conn_handle', 'event_cntr')),
+    7: ('ll_conn_end', ('conn_handle', 'event_cntr', 'err')),
+    8: ('ll_conn_tx', ('len', 'offset')),
+    9: ('ll_conn_rx', ('conn_sn', 'pdu_nesn')),
+    10: ('ll_adv_txdone', ('inst', 'chanset')),
+    11: ('ll_adv_halt', ('inst',)),
+    12: ('ll_sched_exec', ('type', 'late_usecs')),
+    13: ('ll_sched_resched', ('type', 'start_time')),
+    14: ('ll_sched_drop', ('type', 'start_time')),
+}
+
+SCHED_TYPES = {
+    1: 'adv',
+    2: 'scan',
+    3: 'conn',
+    4: 'aux_scan',
+    5: 'dtm',
+    6: 'periodic',
+    7: 'sync',
+}
+
+
+class Hci(object):
+    def __init__(self, dev):
+        self.sock = socket.socket(socket.AF_BLUETOOTH, socket.SOCK_RAW,
+                                  socket.BTPROTO_HCI)
+        self.sock.bind((dev,))
+
+        # Only pass command complete events
+        flt = struct.pack('<IQH', 1 << HCI_EVENT_PKT,
+                          1 << HCI_EV_CMD_COMPLETE, 0)
+        self.sock.setsockopt(SOL_HCI, HCI_FILTER, flt)
+        self.sock.settimeout(2.0)
+
+    def cmd(self, ogf, ocf, params=b''):
+        opcode = (ogf << 10) | ocf
+        self.sock.send(struct.pack('<BHB', HCI_COMMAND_PKT, opcode,
+                                   len(params)) + params)
+
+        while True:
+            pkt = self.sock.recv(260)
+            if len(pkt) < 7 or pkt[1] != HCI_EV_CMD_COMPLETE:
+                continue
+            if struct.unpack_from('<H', pkt, 4)[0] != opcode:
+                continue
+            status = pkt[6]
+            if status != 0:
+                raise IOError('HCI command 0x%04x failed: 0x%02x' %
+                              (opcode, status))
+            return pkt[7:]
+
+    def read_trace(self):
+        rsp = self.cmd(HCI_OGF_VENDOR, HCI_OCF_VS_RD_TRACE)
+        lost, cnt = struct.unpack_from('<IB', rsp, 0)
+        return lost, rsp[5:5 + cnt * TRACE_REC.size]
+
+    def read_sched_stats(self, sched_type, reset):
+        rsp = self.cmd(HCI_OGF_VENDOR, HCI_OCF_VS_RD_SCHED_STATS,
+                       struct.pack('<BB', sched_type, 1 if reset else 0))
+        executed, resched, dropped, nbuckets = struct.unpack_from('<IIIB',
+                                                                  rsp, 0)
+        late = struct.unpack_from('<%dI' % nbuckets, rsp, 13)
+        return executed, resched, dropped, late
+
+
+def parse_records(data):
+    for off in range(0, len(data) - TRACE_REC.size + 1, TRACE_REC.size):
+        yield TRACE_REC.unpack_from(data, off)
+
+
+def to_chrome_trace(records, cputime_freq):
+    """Converts trace records to a list of Chrome trace events.
+
+    Connection events are shown as slices on a per connection track; all
+    other records are shown as instant events on the LL track. The 32-bit
+    cputime is unwrapped so long captures stay monotonic.
+    """
+    events = []
+    last = None
+    base = 0
+
+    for cputime, tid, p1, p2, p3 in records:
+        if last is not None and cputime < last:
+            base += 1 << 32
+        last = cputime
+        ts = (base + cputime) * 1000000.0 / cputime_freq
+
+        name, argnames = TRACE_IDS.get(tid, ('id_%u' % tid, ()))
+        args = dict(zip(argnames, (p1, p2, p3)))
+        if 'type' in args:
+            args['type'] = SCHED_TYPES.get(args['type'], args['type'])
+        if tid == 12:
+            args['late_usecs'] = struct.unpack('<i', struct.pack('<I', p2))[0]
+
+        if tid == 5:
+            events.append({'name': 'conn_ev', 'ph': 'B', 'ts': ts, 'pid': 0,
+                           'tid': 'conn %u' % p1, 'args': args})
+        elif tid == 6:
+            events.append({'name': 'conn_ev', 'ph': 'E', 'ts': ts, 'pid': 0,
+                           'tid': 'conn %u' % p1, 'args': args})
+        else:
+            events.append({'name': name, 'ph': 'i', 's': 't', 'ts': ts,
+                           'pid': 0, 'tid': 'll', 'args': args})
+
+    return events
+
+
+def print_sched_stats(hci, reset):
+    print('%-10s %10s %10s %10s  late (usecs)' %
+          ('type', 'executed', 'resched', 'dropped'))
+    for sched_type in sorted(SCHED_TYPES):
+        try:
+            executed, resched, dropped, late = \
+                hci.read_sched_stats(sched_type, reset)
+        except IOError:
+            continue
+        buckets = []
+        for i, cnt in enumerate(late):
+            if i == len(late) - 1:
+                buckets.append('>%u:%u' % (30 << (i - 1), cnt))
+            else:
+                buckets.append('<=%u:%u' % (30 << i, cnt))
+        print('%-10s %10u %10u %10u  %s' %
+              (SCHED_TYPES[sched_type], executed, resched, dropped,
+               ' '.join(buckets)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n\n')[0])
+    parser.add_argument('--dev', type=int, default=0,
+                        help='HCI device index (default: 0)')
+    parser.add_argument('--input',
+                        help='read raw trace records from file instead of HCI')
+    parser.add_argument('--save',
+                        help='also save raw trace records to file')
+    parser.add_argument('--poll', type=float, default=0,
+                        help='keep reading the trace ring for this many '
+                             'seconds')
+    parser.add_argument('--stats', action='store_true',
+                        help='print schedule statistics and exit')
+    parser.add_argument('--reset', action='store_true',
+                        help='reset schedule statistics after reading')
+    parser.add_argument('--cputime-freq', type=int, default=32768,
+                        help='controller cputime frequency in Hz '
+                             '(default: 32768)')
+    parser.add_argument('-o', '--output', default='-',
+                        help='output file (default: stdout)')
+    args = parser.parse_args()
+
+    if args.input:
+        with open(args.input, 'rb') as f:
+            data = f.read()
+    else:
+        hci = Hci(args.dev)
+        if args.stats:
+            print_sched_stats(hci, args.reset)
+            return 0
+
+        data = b''
+        lost_total = 0
+        end = time.time() + args.poll
+        while True:
+            lost, recs = hci.read_trace()
+            lost_total += lost
+            data += recs
+            if not recs:
+                if time.time() >= end:
+                    break
+                time.sleep(0.05)
+        if lost_total:
+            sys.stderr.write('%u trace records lost\n' % lost_total)
+
+    if args.save:
+        with open(args.save, 'wb') as f:
+            f.write(data)
+
+    trace = {'traceEvents': to_chrome_trace(parse_records(data),
+                                            args.cputime_freq),
+             'displayTimeUnit': 'ns'}
+
+    if args.output == '-':
+        json.dump(trace, sys.stdout, indent=1)
+    else:
+        with open(args.output, 'w') as f:
+            json.dump(trace, f, indent=1)
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
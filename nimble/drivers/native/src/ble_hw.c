@@ -24,6 +24,7 @@
 #include "os/os.h"
 #include "nimble/ble.h"
 #include "nimble/nimble_opt.h"
+#include "nimble/ble_aes.h"
 #include "controller/ble_hw.h"
 
 /* Total number of white list elements supported by nrf52 */
@@ -125,11 +126,12 @@ ble_hw_whitelist_match(void)
     return 0;
 }
 
-/* Encrypt data */
+/* Encrypt data (in software, there is no crypto hardware to use) */
 int
 ble_hw_encrypt_block(struct ble_encryption_block *ecb)
 {
-    return -1;
+    ble_aes_encrypt_block(ecb->key, ecb->plain_text, ecb->cipher_text);
+    return 0;
 }
 
 /**
@@ -57,6 +57,9 @@ struct hci_conn_update;
 /** 60 ms; active scanning. */
 #define BLE_GAP_SCAN_FAST_INTERVAL_MAX      (60 * 1000 / BLE_HCI_ADV_ITVL)
 
+/** Periodic advertising interval in ms, converted to 1.25 ms units. */
+#define BLE_GAP_PERIODIC_ITVL_MS(t)         ((t) * 1000 / BLE_HCI_PERIODIC_ADV_ITVL)
+
 /** 11.25 ms; limited discovery interval. */
 #define BLE_GAP_LIM_DISC_SCAN_INT           (11.25 * 1000 / BLE_HCI_SCAN_ITVL)
 
@@ -124,6 +127,11 @@ struct hci_conn_update;
 #define BLE_GAP_EVENT_REPEAT_PAIRING        17
 #define BLE_GAP_EVENT_PHY_UPDATE_COMPLETE   18
 #define BLE_GAP_EVENT_EXT_DISC              19
+#define BLE_GAP_EVENT_PERIODIC_SYNC         20
+#define BLE_GAP_EVENT_PERIODIC_REPORT       21
+#define BLE_GAP_EVENT_PERIODIC_SYNC_LOST    22
+#define BLE_GAP_EVENT_TX_READY              23
+#define BLE_GAP_EVENT_DISC_BATCH            24
 
 /*** Reason codes for the subscribe GAP event. */
 
@@ -248,6 +256,13 @@ struct ble_gap_disc_params {
     uint8_t limited:1;
     uint8_t passive:1;
     uint8_t filter_duplicates:1;
+
+    /**
+     * Deliver the reports carried by one HCI event together in a single
+     * BLE_GAP_EVENT_DISC_BATCH event rather than one BLE_GAP_EVENT_DISC
+     * event each.
+     */
+    uint8_t batch:1;
 };
 
 struct ble_gap_upd_params {
@@ -383,6 +398,22 @@ struct ble_gap_event {
          */
         struct ble_gap_disc_desc disc;
 
+        /**
+         * Represents several advertising reports received during a discovery
+         * procedure started with the batch parameter set.  The descriptors,
+         * and the data they point to, are only valid during the callback.
+         *
+         * Valid for the following event types:
+         *     o BLE_GAP_EVENT_DISC_BATCH
+         */
+        struct {
+            /** The advertising reports. */
+            const struct ble_gap_disc_desc *descs;
+
+            /** The number of reports in descs. */
+            uint8_t num;
+        } disc_batch;
+
 #if MYNEWT_VAL(BLE_EXT_ADV)
         /**
          * Represents an extended advertising report received during a discovery
@@ -708,6 +739,103 @@ struct ble_gap_event {
             uint8_t tx_phy;
             uint8_t rx_phy;
         } phy_updated;
+
+        /**
+         * Indicates that a connection which refused a streamed write with
+         * BLE_HS_EBUSY can accept data again.
+         *
+         * Valid for the following event types:
+         *     o BLE_GAP_EVENT_TX_READY
+         */
+        struct {
+            /** The handle of the relevant connection. */
+            uint16_t conn_handle;
+        } tx_ready;
+
+#if MYNEWT_VAL(BLE_PERIODIC_ADV)
+        /**
+         * Represents a periodic advertising sync established during discovery
+         * procedure. Valid for the following event types:
+         *     o BLE_GAP_EVENT_PERIODIC_SYNC
+         */
+        struct {
+            /**
+             * The status of the synchronization attempt:
+             *     o 0: Sync established; all other fields are valid.
+             *     o BLE_HS_HCI_ERR(BLE_ERR_OPERATION_CANCELLED): Sync creation
+             *       was cancelled.
+             *     o Other nonzero: Sync failed.
+             */
+            int status;
+            /** Periodic sync handle */
+            uint16_t sync_handle;
+
+            /** Advertising Set ID */
+            uint8_t sid;
+
+            /** Advertiser address */
+            ble_addr_t adv_addr;
+
+            /** Advertising PHY, can be one of following constants:
+             *  - BLE_HCI_LE_PHY_1M
+             *  - BLE_HCI_LE_PHY_2M
+             *  - BLE_HCI_LE_PHY_CODED
+             */
+            uint8_t adv_phy;
+
+            /** Periodic advertising interval */
+            uint16_t per_adv_ival;
+
+            /** Advertiser clock accuracy */
+            uint8_t adv_clk_accuracy;
+        } periodic_sync;
+
+        /**
+         * Represents a periodic advertising report received on established
+         * sync. Valid for the following event types:
+         *     o BLE_GAP_EVENT_PERIODIC_REPORT
+         */
+        struct {
+            /** Periodic sync handle */
+            uint16_t sync_handle;
+
+            /** Advertiser transmit power in dBm (127 if unavailable) */
+            int8_t tx_power;
+
+            /** Received signal strength indication in dBm (127 if unavailable) */
+            int8_t rssi;
+
+            /** Advertising data status, can be one of following constants:
+             *  - BLE_HCI_PER_ADV_DATA_STATUS_COMPLETE
+             *  - BLE_HCI_PER_ADV_DATA_STATUS_INCOMPLETE
+             *  - BLE_HCI_PER_ADV_DATA_STATUS_TRUNCATED
+             */
+            uint8_t data_status;
+
+            /** Advertising Data length */
+            uint8_t data_length;
+
+            /** Advertising data */
+            const uint8_t *data;
+        } periodic_report;
+
+        /**
+         * Represents a periodic advertising sync lost of established sync.
+         * Sync lost reason can be BLE_HS_ETIMEOUT (sync timeout) or
+         * BLE_HS_EDONE (sync terminated locally).
+         * Valid for the following event types:
+         *     o BLE_GAP_EVENT_PERIODIC_SYNC_LOST
+         */
+        struct {
+            /** Periodic sync handle */
+            uint16_t sync_handle;
+
+            /** Reason for sync lost, can be BLE_HS_ETIMEOUT for timeout or
+             * BLE_HS_EDONE for locally terminated sync
+             */
+            int reason;
+        } periodic_sync_lost;
+#endif
     };
 };
 
@@ -887,6 +1015,119 @@ int ble_gap_ext_adv_rsp_set_data(uint8_t instance, struct os_mbuf *data);
 int ble_gap_ext_adv_remove(uint8_t instance);
 #endif
 
+#if MYNEWT_VAL(BLE_PERIODIC_ADV)
+/* Periodic Advertising */
+
+/** @brief Periodic advertising parameters  */
+struct ble_gap_periodic_adv_params {
+    /** If include TX power in advertising PDU */
+    unsigned int include_tx_power:1;
+
+    /** Minimum advertising interval in 1.25ms units, if 0 stack use sane
+     *  defaults
+     */
+    uint16_t itvl_min;
+
+    /** Maximum advertising interval in 1.25ms units, if 0 stack use sane
+     *  defaults
+     */
+    uint16_t itvl_max;
+};
+
+/** @brief Periodic sync parameters  */
+struct ble_gap_periodic_sync_params {
+    /** The maximum number of periodic advertising events that controller can
+     * skip after a successful receive.
+     * */
+    uint16_t skip;
+
+    /** Synchronization timeout for the periodic advertising train in 10ms
+     * units
+     */
+    uint16_t sync_timeout;
+};
+
+/**
+ * Configure periodic advertising for specified advertising instance
+ *
+ * This is allowed only for instances configured as non-anonymous,
+ * non-connectable and non-scannable.
+ *
+ * @param instance           Instance ID
+ * @param params             Additional arguments specifying the particulars
+ *                           of periodic advertising.
+ *
+ * @return                   0 on success; nonzero on failure.
+ */
+int ble_gap_periodic_adv_configure(uint8_t instance,
+                                   const struct ble_gap_periodic_adv_params *params);
+
+/**
+ * Start periodic advertising for specified advertising instance.
+ *
+ * @param instance           Instance ID
+ *
+ * @return                   0 on success, error code on failure.
+ */
+int ble_gap_periodic_adv_start(uint8_t instance);
+
+/**
+ * Stop periodic advertising for specified advertising instance.
+ *
+ * @param instance           Instance ID
+ *
+ * @return                   0 on success, error code on failure.
+ */
+int ble_gap_periodic_adv_stop(uint8_t instance);
+
+/**
+ * Configures the data to include in periodic advertisements for specified
+ * advertising instance.  The data is split into HCI fragments as needed.
+ *
+ * @param instance           Instance ID
+ * @param data               Chain containing the periodic advertising data.
+ *                           Ownership is always transferred to the stack.
+ *
+ * @return                   0 on success or error code on failure.
+ */
+int ble_gap_periodic_adv_set_data(uint8_t instance, struct os_mbuf *data);
+
+/**
+ * Performs the Synchronization procedure with periodic advertiser.
+ *
+ * @param addr               Peer address to synchronize with.
+ * @param adv_sid            Advertiser Set ID
+ * @param params             Additional arguments specifying the particulars
+ *                           of the synchronization procedure.
+ * @param cb                 The callback to associate with this synchronization
+ *                           procedure. BLE_GAP_EVENT_PERIODIC_REPORT events
+ *                           are reported only by this callback.
+ * @param cb_arg             The optional argument to pass to the callback
+ *                           function.
+ *
+ * @return                   0 on success; nonzero on failure.
+ */
+int ble_gap_periodic_adv_sync_create(const ble_addr_t *addr, uint8_t adv_sid,
+                                     const struct ble_gap_periodic_sync_params *params,
+                                     ble_gap_event_fn *cb, void *cb_arg);
+
+/**
+ * Cancel pending synchronization procedure.
+ *
+ * @return                   0 on success; nonzero on failure.
+ */
+int ble_gap_periodic_adv_sync_create_cancel(void);
+
+/**
+ * Terminate synchronization procedure.
+ *
+ * @param sync_handle        Handle identifying synchronization to terminate.
+ *
+ * @return                   0 on success; nonzero on failure.
+ */
+int ble_gap_periodic_adv_sync_terminate(uint16_t sync_handle);
+#endif
+
 /**
  * Performs the Limited or General Discovery Procedures.
  *
@@ -946,6 +1187,70 @@ int ble_gap_disc_cancel(void);
  */
 int ble_gap_disc_active(void);
 
+/**
+ * Enables or disables filtering of advertising reports in the controller.
+ * While enabled, the controller only reports legacy advertising PDUs whose
+ * RSSI is at least the given threshold and that match at least one filter
+ * added with ble_gap_disc_filt_add_ad() or ble_gap_disc_filt_add_addr().
+ * If no filters are installed, only the RSSI threshold applies.
+ *
+ * This uses vendor specific HCI commands supported by the NimBLE controller
+ * when built with BLE_LL_SCAN_ADV_FILT_NUM > 0.
+ *
+ * @param enable                1 to enable filtering; 0 to disable it.
+ * @param min_rssi              Reports with a lower RSSI are dropped.  Use
+ *                                  -127 to filter on content only.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_HCI_ERR(BLE_ERR_UNKNOWN_HCI_CMD) if the
+ *                                  controller does not support filtering;
+ *                              Other nonzero on error.
+ */
+int ble_gap_disc_filt_enable(int enable, int8_t min_rssi);
+
+/**
+ * Adds an advertising report filter matching on advertising data.  A PDU
+ * matches if it contains an AD structure of the given type whose data
+ * starts with the given value, compared under the mask.  For the service
+ * UUID list types every UUID in the list is compared.  A zero length
+ * matches any AD structure of the given type.
+ *
+ * @param ad_type               The AD type to look for
+ *                                  (BLE_HS_ADV_TYPE_[...]).
+ * @param value                 The value to compare against.
+ * @param mask                  Bits to compare; NULL to compare all bits.
+ * @param len                   The length of value and mask, at most 16.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_EINVAL if the length is too large;
+ *                              BLE_HS_HCI_ERR(BLE_ERR_MEM_CAPACITY) if the
+ *                                  controller's filter table is full;
+ *                              Other nonzero on error.
+ */
+int ble_gap_disc_filt_add_ad(uint8_t ad_type, const uint8_t *value,
+                             const uint8_t *mask, uint8_t len);
+
+/**
+ * Adds an advertising report filter matching on the advertiser's identity
+ * address.
+ *
+ * @param addr                  The address to match.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_HCI_ERR(BLE_ERR_MEM_CAPACITY) if the
+ *                                  controller's filter table is full;
+ *                              Other nonzero on error.
+ */
+int ble_gap_disc_filt_add_addr(const ble_addr_t *addr);
+
+/**
+ * Removes all advertising report filters from the controller.  The RSSI
+ * threshold stays in effect while filtering is enabled.
+ *
+ * @return                      0 on success; nonzero on error.
+ */
+int ble_gap_disc_filt_clear(void);
+
 /**
  * Initiates a connect procedure.
  *
@@ -1064,6 +1369,71 @@ int ble_gap_conn_cancel(void);
  */
 int ble_gap_conn_active(void);
 
+/**
+ * Adds a peer to the connection queue.  The connection queue allows
+ * connecting to several peers without waiting for each connect procedure to
+ * complete: the host programs the white list with all queued peers and runs
+ * a single white list connect procedure.  Whenever one of the peers
+ * connects, it is removed from the queue and the procedure is restarted for
+ * the remaining peers.
+ *
+ * While the queue is not empty, it owns the white list and the master
+ * connect procedure; the application should not modify either.  The
+ * own address type and connection parameters of the oldest queued peer are
+ * used for the connect procedure.
+ *
+ * @param own_addr_type         The type of address the stack should use for
+ *                                  itself during connection establishment.
+ *                                      - BLE_OWN_ADDR_PUBLIC
+ *                                      - BLE_OWN_ADDR_RANDOM
+ *                                      - BLE_OWN_ADDR_RPA_PUBLIC_DEFAULT
+ *                                      - BLE_OWN_ADDR_RPA_RANDOM_DEFAULT
+ * @param peer_addr             The identity address of the peer to connect
+ *                                  to.
+ * @param duration_ms           How long the peer stays queued.  On
+ *                                  expiration, the peer is removed and a
+ *                                  BLE_GAP_EVENT_CONNECT event with a status
+ *                                  of BLE_HS_ETIMEOUT is reported.  Units are
+ *                                  milliseconds.  Specify BLE_HS_FOREVER for
+ *                                  no expiration or 0 for the default
+ *                                  duration.
+ * @param conn_params           Additional arguments specifying the particulars
+ *                                  of the connect procedure.  Specify null for
+ *                                  default values.
+ * @param cb                    The callback to associate with this peer.  When
+ *                                  the peer connects or times out, the result
+ *                                  is reported through this callback.  If the
+ *                                  peer connects, the connection inherits this
+ *                                  callback as its event-reporting mechanism.
+ * @param cb_arg                The optional argument to pass to the callback
+ *                                  function.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_EALREADY if the peer is already queued;
+ *                              BLE_HS_ENOMEM if the queue is full;
+ *                              BLE_HS_EDONE if the specified peer is already
+ *                                  connected;
+ *                              BLE_HS_ENOTSUP if the connection queue is
+ *                                  disabled;
+ *                              Other nonzero on error.
+ */
+int ble_gap_connq_add(uint8_t own_addr_type, const ble_addr_t *peer_addr,
+                      int32_t duration_ms,
+                      const struct ble_gap_conn_params *conn_params,
+                      ble_gap_event_fn *cb, void *cb_arg);
+
+/**
+ * Removes a peer from the connection queue.  No event is reported for the
+ * removed peer.
+ *
+ * @param peer_addr             The address the peer was queued with.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_ENOENT if the peer is not queued;
+ *                              Other nonzero on error.
+ */
+int ble_gap_connq_cancel(const ble_addr_t *peer_addr);
+
 /**
  * Terminates an established connection.
  *
@@ -1089,6 +1459,23 @@ int ble_gap_terminate(uint16_t conn_handle, uint8_t hci_reason);
  */
 int ble_gap_wl_set(const ble_addr_t *addrs, uint8_t white_list_count);
 
+/**
+ * Makes the controller's white list contain exactly the specified entries.
+ * Unlike ble_gap_wl_set(), this function only sends the commands needed to
+ * get from the list the host last configured to the requested one: entries
+ * that are already present are left alone, stale entries are removed and
+ * missing ones are added.  If the host does not know the controller's
+ * current list (e.g., it exceeds BLE_GAP_WL_CACHE_SIZE entries), the list is
+ * rewritten in full.
+ *
+ * @param addrs                 The entries the white list should contain.
+ * @param white_list_count      The number of entries in the white list.  0
+ *                                  empties the white list.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int ble_gap_wl_update(const ble_addr_t *addrs, uint8_t white_list_count);
+
 /**
  * Initiates a connection parameter update procedure.
  *
@@ -44,6 +44,16 @@ struct ble_hs_cfg;
 
 #define BLE_GATT_SVC_UUID16                             0x1801
 #define BLE_GATT_DSC_CLT_CFG_UUID16                     0x2902
+#define BLE_GATT_CHR_CLT_SUP_FEAT_UUID16                0x2b29
+#define BLE_GATT_CHR_SRV_SUP_FEAT_UUID16                0x2b3a
+
+/** Bits of the Client Supported Features characteristic. */
+#define BLE_GATT_CLT_SUP_FEAT_ROBUST_CACHING            0x01
+#define BLE_GATT_CLT_SUP_FEAT_EATT                      0x02
+#define BLE_GATT_CLT_SUP_FEAT_MULT_NTF                  0x04
+
+/** Bits of the Server Supported Features characteristic. */
+#define BLE_GATT_SRV_SUP_FEAT_EATT                      0x01
 
 #define BLE_GATT_CHR_PROP_BROADCAST                     0x01
 #define BLE_GATT_CHR_PROP_READ                          0x02
@@ -374,6 +384,61 @@ int ble_gattc_write_no_rsp(uint16_t conn_handle, uint16_t attr_handle,
 int ble_gattc_write_no_rsp_flat(uint16_t conn_handle, uint16_t attr_handle,
                                 const void *data, uint16_t data_len);
 
+/**
+ * Initiates GATT procedure: Write Without Response, with back-pressure.  This
+ * is intended for streaming large amounts of data.  If the connection already
+ * has BLE_GATT_WRITE_NO_RSP_MAX_PENDING packets queued in the host or held by
+ * the controller, the write is refused with BLE_HS_EBUSY; a
+ * BLE_GAP_EVENT_TX_READY event is reported to the connection's GAP callback
+ * once there is room again.  This function consumes the supplied mbuf unless
+ * BLE_HS_EBUSY is returned.
+ *
+ * @param conn_handle           The connection over which to execute the
+ *                                  procedure.
+ * @param attr_handle           The handle of the characteristic value to write
+ *                                  to.
+ * @param txom                  The value to write to the characteristic.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_EBUSY if the connection's transmit
+ *                                  queue is full;
+ *                              Other nonzero on failure.
+ */
+int ble_gattc_write_no_rsp_stream(uint16_t conn_handle, uint16_t attr_handle,
+                                  struct os_mbuf *txom);
+
+/** Statistics of the streamed writes of a single connection. */
+struct ble_gattc_stream_stats {
+    /** Number of writes accepted by ble_gattc_write_no_rsp_stream(). */
+    uint32_t pdus;
+
+    /** Number of attribute value bytes accepted. */
+    uint32_t bytes;
+
+    /** Number of writes refused with BLE_HS_EBUSY. */
+    uint32_t busy;
+
+    /** Milliseconds since the first accepted write. */
+    uint32_t elapsed_ms;
+
+    /** Average throughput since the first accepted write. */
+    uint32_t bytes_per_sec;
+};
+
+/**
+ * Retrieves the statistics of the streamed writes of the specified
+ * connection.
+ *
+ * @param conn_handle           The connection to query.
+ * @param out_stats             On success, the statistics get written here.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_ENOTCONN if there is no such
+ *                                  connection.
+ */
+int ble_gattc_write_no_rsp_stream_stats(
+    uint16_t conn_handle, struct ble_gattc_stream_stats *out_stats);
+
 /**
  * Initiates GATT procedure: Write Characteristic Value.  This function
  * consumes the supplied mbuf regardless of the outcome.
@@ -517,6 +582,17 @@ int ble_gattc_indicate_custom(uint16_t conn_handle, uint16_t chr_val_handle,
  */
 int ble_gattc_indicate(uint16_t conn_handle, uint16_t chr_val_handle);
 
+/**
+ * Deletes all GATT client cache records of the specified peer.  The next
+ * discovery procedures with this peer go over the air and refill the cache.
+ * Only supported if BLE_GATT_CACHE is enabled.
+ *
+ * @param peer_id_addr          The identity address of the peer.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int ble_gattc_cache_clear(const ble_addr_t *peer_id_addr);
+
 int ble_gattc_init(void);
 
 /*** @server. */
@@ -793,6 +869,46 @@ int ble_gatts_count_cfg(const struct ble_gatt_svc_def *defs);
  */
 void ble_gatts_chr_updated(uint16_t chr_def_handle);
 
+/**
+ * Retrieves the value of the local Server Supported Features characteristic.
+ *
+ * @return                      The supported features
+ *                                  (BLE_GATT_SRV_SUP_FEAT_[...]).
+ */
+uint8_t ble_gatts_srv_sup_feat(void);
+
+/**
+ * Retrieves the Client Supported Features that the peer on the specified
+ * connection has written to the local GATT server.
+ *
+ * @param conn_handle           The connection to query.
+ * @param out_feat              On success, the features
+ *                                  (BLE_GATT_CLT_SUP_FEAT_[...]) get written
+ *                                  here.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_ENOTCONN if there is no such
+ *                                  connection.
+ */
+int ble_gatts_clt_sup_feat(uint16_t conn_handle, uint8_t *out_feat);
+
+/**
+ * Records the Client Supported Features written by the peer on the specified
+ * connection.  Unknown bits are ignored.  A client cannot disable a feature
+ * it has enabled during the connection.
+ *
+ * @param conn_handle           The connection the write came in on.
+ * @param feat                  The written features
+ *                                  (BLE_GATT_CLT_SUP_FEAT_[...]).
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_ENOTCONN if there is no such
+ *                                  connection;
+ *                              BLE_HS_EINVAL if the write would disable a
+ *                                  feature.
+ */
+int ble_gatts_clt_sup_feat_set(uint16_t conn_handle, uint8_t feat);
+
 /**
  * Retrieves the attribute handle associated with a local GATT service.
  *
@@ -267,6 +267,9 @@ struct ble_hs_cfg {
     /** Storage Delete callback handles deletion of security material */
     ble_store_delete_fn *store_delete_cb;
 
+    /** Optional storage callback which walks all objects matching a key */
+    ble_store_read_next_fn *store_read_next_cb;
+
     /** @brief Storage Status callback.
      *
      * This callback gets executed when a persistence operation cannot be
@@ -328,6 +331,14 @@ void ble_hs_sched_reset(int reason);
  */
 void ble_hs_evq_set(struct ble_npl_eventq *evq);
 
+/**
+ * Retrieves the event queue used for NimBLE host work.  Packages which share
+ * state with the host should process their events on this queue.
+ *
+ * @return The event queue used for host work.
+ */
+struct ble_npl_eventq *ble_hs_evq_get(void);
+
 /**
  * Initializes the NimBLE host. This function must be called before the OS is
  * started. The NimBLE stack requires an application task to function.  One
@@ -158,6 +158,59 @@ struct ble_hs_adv_fields {
 
 #define BLE_HS_ADV_SVC_DATA_UUID128_MIN_LEN     16
 
+/**
+ * Maximum number of AD structures a struct ble_hs_adv_idx can refer to.
+ * This covers any legacy advertising payload (BLE_HS_ADV_MAX_SZ bytes hold
+ * at most 15 structures); structures past this limit in longer extended
+ * advertising data are still validated but looked up with a linear walk.
+ */
+#define BLE_HS_ADV_IDX_MAX_FIELDS               16
+
+/**
+ * Number of AD types with a direct lookup slot in struct ble_hs_adv_idx:
+ * types 0x01 to 0x3f plus manufacturer specific data (0xff), which takes
+ * the unused slot 0.
+ */
+#define BLE_HS_ADV_IDX_NUM_SLOTS                0x40
+
+/**
+ * Index of the AD structures in a block of advertising data, built in a
+ * single pass by ble_hs_adv_idx_build().  Nothing is copied; the index
+ * refers to the original buffer, which must remain valid while the index is
+ * in use.
+ */
+struct ble_hs_adv_idx {
+    /** The indexed advertising data. */
+    const uint8_t *data;
+
+    /** The length of the significant part of data. */
+    uint16_t length;
+
+    /**
+     * Offset of the first AD structure that did not fit in the index;
+     * equal to length if all of them did.
+     */
+    uint16_t tail;
+
+    /** The number of AD structures indexed. */
+    uint8_t num_fields;
+
+    /** Offset of each AD structure in data, in order of appearance. */
+    uint16_t offs[BLE_HS_ADV_IDX_MAX_FIELDS];
+
+    /**
+     * For each AD structure, 1 + the position in offs of the next structure
+     * with the same lookup slot; 0 if it is the last one.
+     */
+    uint8_t next[BLE_HS_ADV_IDX_MAX_FIELDS];
+
+    /**
+     * For each lookup slot, 1 + the position in offs of the first AD
+     * structure of that type; 0 if there is none.
+     */
+    uint8_t first[BLE_HS_ADV_IDX_NUM_SLOTS];
+};
+
 int ble_hs_adv_set_fields_mbuf(const struct ble_hs_adv_fields *adv_fields,
                                struct os_mbuf *om);
 
@@ -170,6 +223,64 @@ int ble_hs_adv_parse_fields(struct ble_hs_adv_fields *adv_fields, uint8_t *src,
 int ble_hs_adv_parse(const uint8_t *data, uint8_t length,
                      ble_hs_adv_parse_func_t func, void *user_data);
 
+/**
+ * Builds an index of the AD structures in the specified advertising data.
+ * Parsing stops at the first zero-length AD structure, which marks the end
+ * of significant data.
+ *
+ * @param idx                   The index to fill.
+ * @param data                  The advertising data; not copied.
+ * @param length                The length of the advertising data.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_EBADDATA if an AD structure overruns
+ *                                  the data.
+ */
+int ble_hs_adv_idx_build(struct ble_hs_adv_idx *idx, const uint8_t *data,
+                         uint16_t length);
+
+/**
+ * Looks up the first AD structure of the specified type in an index.
+ *
+ * @param idx                   The index to search.
+ * @param type                  The AD type to look for
+ *                                  (BLE_HS_ADV_TYPE_[...]).
+ * @param out                   On success, points to the AD structure in the
+ *                                  indexed data.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_ENOENT if there is no such structure.
+ */
+int ble_hs_adv_idx_find(const struct ble_hs_adv_idx *idx, uint8_t type,
+                        const struct ble_hs_adv_field **out);
+
+/**
+ * Indicates whether the indexed advertising data lists the specified service
+ * UUID in any complete or incomplete list of service UUIDs of the matching
+ * size.
+ *
+ * @return                      1 if the UUID is listed; 0 otherwise.
+ */
+int ble_hs_adv_idx_has_uuid(const struct ble_hs_adv_idx *idx,
+                            const ble_uuid_t *uuid);
+
+/**
+ * Indicates whether any manufacturer specific data in the indexed
+ * advertising data comes from the specified company, optionally starting
+ * with the specified bytes after the company identifier.
+ *
+ * @param idx                   The index to search.
+ * @param company_id            The company identifier to match.
+ * @param prefix                Bytes the data must start with; may be NULL
+ *                                  if prefix_len is 0.
+ * @param prefix_len            The number of bytes in prefix.
+ *
+ * @return                      1 on match; 0 otherwise.
+ */
+int ble_hs_adv_idx_mfg_match(const struct ble_hs_adv_idx *idx,
+                             uint16_t company_id, const void *prefix,
+                             uint8_t prefix_len);
+
 #ifdef __cplusplus
 }
 #endif
@@ -27,9 +27,12 @@ extern "C" {
 
 struct os_mbuf;
 
+int ble_aes_test_all(void);
 int ble_att_clt_test_all(void);
 int ble_att_svr_test_all(void);
+int ble_eatt_test_all(void);
 int ble_gap_test_all(void);
+int ble_gatt_cache_test_all(void);
 int ble_gatt_conn_test_all(void);
 int ble_gatt_disc_c_test_all(void);
 int ble_gatt_disc_d_test_all(void);
@@ -75,6 +75,7 @@ struct ble_hs_conn;
 #define BLE_L2CAP_EVENT_COC_DISCONNECTED              1
 #define BLE_L2CAP_EVENT_COC_ACCEPT                    2
 #define BLE_L2CAP_EVENT_COC_DATA_RECEIVED             3
+#define BLE_L2CAP_EVENT_COC_TX_UNSTALLED              4
 
 typedef void ble_l2cap_sig_update_fn(uint16_t conn_handle, int status,
                                      void *arg);
@@ -173,6 +174,20 @@ struct ble_l2cap_event {
             /** The mbuf with received SDU. */
             struct os_mbuf *sdu_rx;
         } receive;
+
+        /**
+         * Represents a channel which is ready to accept the next SDU after
+         * ble_l2cap_send() returned BLE_HS_EBUSY. Valid for the following
+         * event types:
+         *     o BLE_L2CAP_EVENT_COC_TX_UNSTALLED
+         */
+        struct {
+            /** Connection handle of the relevant connection */
+            uint16_t conn_handle;
+
+            /** The L2CAP channel of the relevant L2CAP connection. */
+            struct ble_l2cap_chan *chan;
+        } tx_unstalled;
     };
 };
 
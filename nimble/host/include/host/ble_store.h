@@ -22,6 +22,7 @@
 
 #include <inttypes.h>
 #include "nimble/ble.h"
+#include "host/ble_uuid.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -30,6 +31,13 @@ extern "C" {
 #define BLE_STORE_OBJ_TYPE_OUR_SEC      1
 #define BLE_STORE_OBJ_TYPE_PEER_SEC     2
 #define BLE_STORE_OBJ_TYPE_CCCD         3
+#define BLE_STORE_OBJ_TYPE_GATT_CACHE   4
+
+/** GATT cache record types. */
+#define BLE_STORE_GATT_CACHE_DB         1
+#define BLE_STORE_GATT_CACHE_SVC        2
+#define BLE_STORE_GATT_CACHE_CHR        3
+#define BLE_STORE_GATT_CACHE_DSC        4
 
 /** Failed to persist record; insufficient storage capacity. */
 #define BLE_STORE_EVENT_OVERFLOW        1
@@ -120,6 +128,56 @@ struct ble_store_value_cccd {
     unsigned value_changed:1;
 };
 
+/**
+ * Used as a key for lookups of GATT client cache records.  This struct
+ * corresponds to the BLE_STORE_OBJ_TYPE_GATT_CACHE store object type.
+ */
+struct ble_store_key_gatt_cache {
+    /**
+     * Key by peer identity address;
+     * peer_addr=BLE_ADDR_NONE means don't key off peer.
+     */
+    ble_addr_t peer_addr;
+
+    /**
+     * Key by record type (BLE_STORE_GATT_CACHE_[...]);
+     * type=0 means don't key off type.
+     */
+    uint8_t type;
+
+    /** Key by attribute handle; handle=0 means don't key off handle. */
+    uint16_t handle;
+
+    /** Number of results to skip; 0 means retrieve the first match. */
+    uint8_t idx;
+};
+
+/**
+ * Represents a record of the GATT client attribute cache.  This struct
+ * corresponds to the BLE_STORE_OBJ_TYPE_GATT_CACHE store object type.  The
+ * meaning of the fields depends on the record type:
+ *     o BLE_STORE_GATT_CACHE_DB: handle is 0; complete is set once all
+ *       primary services of the peer are cached.
+ *     o BLE_STORE_GATT_CACHE_SVC: handle and end_handle are the service
+ *       handle range; complete is set once all its characteristics are
+ *       cached.
+ *     o BLE_STORE_GATT_CACHE_CHR: handle is the definition handle;
+ *       end_handle is the end of the discovered descriptor range; complete
+ *       is set once its descriptors are cached.
+ *     o BLE_STORE_GATT_CACHE_DSC: val_handle is the value handle of the
+ *       owning characteristic.
+ */
+struct ble_store_value_gatt_cache {
+    ble_addr_t peer_addr;
+    uint8_t type;
+    uint16_t handle;
+    uint16_t end_handle;
+    uint16_t val_handle;
+    uint8_t properties;
+    unsigned complete:1;
+    ble_uuid_any_t uuid;
+};
+
 /**
  * Used as a key for store lookups.  This union must be accompanied by an
  * object type code to indicate which field is valid.
@@ -127,6 +185,7 @@ struct ble_store_value_cccd {
 union ble_store_key {
     struct ble_store_key_sec sec;
     struct ble_store_key_cccd cccd;
+    struct ble_store_key_gatt_cache gatt_cache;
 };
 
 /**
@@ -136,6 +195,7 @@ union ble_store_key {
 union ble_store_value {
     struct ble_store_value_sec sec;
     struct ble_store_value_cccd cccd;
+    struct ble_store_value_gatt_cache gatt_cache;
 };
 
 struct ble_store_status_event {
@@ -228,6 +288,34 @@ typedef int ble_store_write_fn(int obj_type, const union ble_store_value *val);
  */
 typedef int ble_store_delete_fn(int obj_type, const union ble_store_key *key);
 
+/**
+ * Reads the next object matching the specified criteria, resuming a walk of
+ * the store.  The idx field of the key is ignored; instead, the walk's
+ * position is kept in the cursor.  This allows all matching objects to be
+ * enumerated in a single pass, rather than restarting the search for each
+ * value of idx.  Implementing this callback is optional.
+ *
+ * @param obj_type              The type of object to search for; one of the
+ *                                  BLE_STORE_OBJ_TYPE_[...] codes.
+ * @param key                   Specifies properties of the objects to
+ *                                  search for.
+ * @param cursor                The position to resume the walk from; 0 for
+ *                                  the first call.  On success, this is
+ *                                  updated to point past the retrieved
+ *                                  object.
+ * @param dst                   On success, this is populated with the
+ *                                  retrieved object.
+ *
+ * @return                      0 if an object was successfully retrieved;
+ *                              BLE_HS_ENOENT if no more objects match;
+ *                              BLE_HS_ENOTSUP if walks of this object type
+ *                                  are not supported;
+ *                              Other nonzero on error.
+ */
+typedef int ble_store_read_next_fn(int obj_type,
+                                   const union ble_store_key *key,
+                                   int *cursor, union ble_store_value *dst);
+
 /**
  * Indicates an inability to perform a store operation.  This callback should
  * do one of two things:
@@ -266,10 +354,18 @@ int ble_store_read_cccd(const struct ble_store_key_cccd *key,
 int ble_store_write_cccd(const struct ble_store_value_cccd *value);
 int ble_store_delete_cccd(const struct ble_store_key_cccd *key);
 
+int ble_store_read_gatt_cache(const struct ble_store_key_gatt_cache *key,
+                              struct ble_store_value_gatt_cache *out_value);
+int ble_store_write_gatt_cache(const struct ble_store_value_gatt_cache *value);
+int ble_store_delete_gatt_cache(const struct ble_store_key_gatt_cache *key);
+
 void ble_store_key_from_value_sec(struct ble_store_key_sec *out_key,
                                   const struct ble_store_value_sec *value);
 void ble_store_key_from_value_cccd(struct ble_store_key_cccd *out_key,
                                    const struct ble_store_value_cccd *value);
+void ble_store_key_from_value_gatt_cache(
+    struct ble_store_key_gatt_cache *out_key,
+    const struct ble_store_value_gatt_cache *value);
 
 void ble_store_key_from_value(int obj_type,
                               union ble_store_key *out_key,
@@ -282,6 +378,8 @@ typedef int ble_store_iterator_fn(int obj_type,
 int ble_store_iterate(int obj_type,
                       ble_store_iterator_fn *callback,
                       void *cookie);
+int ble_store_iterate_key(int obj_type, const union ble_store_key *key,
+                          ble_store_iterator_fn *callback, void *cookie);
 
 int ble_store_clear(void);
 
@@ -332,6 +332,9 @@ struct bt_mesh_model {
 	/* Subscription List (group or virtual addresses) */
 	u16_t groups[CONFIG_BT_MESH_MODEL_GROUP_COUNT];
 
+	/* Internal state flags. Initialized by the stack. */
+	u8_t flags;
+
 	const struct bt_mesh_model_op * const op;
 
 	/* Model-specific user data */
@@ -7,6 +7,7 @@
  */
 
 #include <errno.h>
+#include <string.h>
 
 #include <os/os_mbuf.h>
 #include "mesh/mesh.h"
@@ -29,6 +30,45 @@
 static const struct bt_mesh_comp *dev_comp;
 static u16_t dev_primary_addr;
 
+#define OP_TABLE_SIZE MYNEWT_VAL(BLE_MESH_ACCESS_OP_TABLE_SIZE)
+#define SUB_TABLE_SIZE MYNEWT_VAL(BLE_MESH_ACCESS_SUB_TABLE_SIZE)
+
+#if (OP_TABLE_SIZE & (OP_TABLE_SIZE - 1))
+#error "BLE_MESH_ACCESS_OP_TABLE_SIZE must be a power of two"
+#endif
+
+#if (SUB_TABLE_SIZE & (SUB_TABLE_SIZE - 1))
+#error "BLE_MESH_ACCESS_SUB_TABLE_SIZE must be a power of two"
+#endif
+
+#if OP_TABLE_SIZE > 0
+/* Operations of all models, hashed by element and opcode. Entries for the
+ * same element and opcode are met in model order when probing.
+ */
+static struct {
+	struct bt_mesh_model *mod;
+	const struct bt_mesh_model_op *op;
+} op_table[OP_TABLE_SIZE];
+
+/* Set if the models have more operations than the table can hold */
+static bool op_table_full;
+#endif
+
+#if SUB_TABLE_SIZE > 0
+/* Group and virtual addresses subscribed to by local models, along with a
+ * bitmap of the elements the subscribed models belong to.
+ */
+static struct {
+	u16_t addr;
+	u32_t elems;
+} sub_table[SUB_TABLE_SIZE];
+
+static u16_t sub_table_count;
+
+/* Set if the subscriptions cannot be represented by the table */
+static bool sub_table_full;
+#endif
+
 static const struct {
 	const u16_t id;
 	int (*const init)(struct bt_mesh_model *model, bool primary);
@@ -264,6 +304,164 @@ static void mod_init(struct bt_mesh_model *mod, struct bt_mesh_elem *elem,
 	}
 }
 
+#if OP_TABLE_SIZE > 0 || SUB_TABLE_SIZE > 0
+static u8_t elem_idx(struct bt_mesh_elem *elem)
+{
+	return elem - dev_comp->elem;
+}
+#endif
+
+#if OP_TABLE_SIZE > 0
+static u32_t op_hash(u8_t elem, u32_t opcode)
+{
+	return (((opcode ^ ((u32_t)elem << 24)) * 0x9e3779b1) >> 16) &
+	       (OP_TABLE_SIZE - 1);
+}
+
+static void op_table_add(struct bt_mesh_model *mod, struct bt_mesh_elem *elem,
+			 bool vnd, bool primary, void *user_data)
+{
+	const struct bt_mesh_model_op *op;
+	u16_t *count = user_data;
+	u32_t i;
+
+	for (op = mod->op; op->func; op++) {
+		/* Keep at least one slot free so that lookups terminate */
+		if (++(*count) >= OP_TABLE_SIZE) {
+			op_table_full = true;
+			return;
+		}
+
+		i = op_hash(elem_idx(elem), op->opcode);
+		while (op_table[i].op) {
+			i = (i + 1) & (OP_TABLE_SIZE - 1);
+		}
+
+		op_table[i].mod = mod;
+		op_table[i].op = op;
+	}
+}
+#endif
+
+static void op_table_build(void)
+{
+#if OP_TABLE_SIZE > 0
+	u16_t count = 0;
+
+	memset(op_table, 0, sizeof(op_table));
+	op_table_full = false;
+
+	bt_mesh_model_foreach(op_table_add, &count);
+
+	if (op_table_full) {
+		BT_WARN("Too many opcodes for the dispatch table (%u slots)",
+			OP_TABLE_SIZE);
+	}
+#endif
+}
+
+#if SUB_TABLE_SIZE > 0
+static u32_t sub_hash(u16_t addr)
+{
+	return ((addr * 0x9e3779b1) >> 16) & (SUB_TABLE_SIZE - 1);
+}
+
+static void sub_table_add(u8_t elem, u16_t addr)
+{
+	u32_t i;
+
+	if (sub_table_full) {
+		return;
+	}
+
+	if (elem >= 32) {
+		sub_table_full = true;
+		return;
+	}
+
+	for (i = sub_hash(addr); sub_table[i].addr != BT_MESH_ADDR_UNASSIGNED;
+	     i = (i + 1) & (SUB_TABLE_SIZE - 1)) {
+		if (sub_table[i].addr == addr) {
+			sub_table[i].elems |= BIT(elem);
+			return;
+		}
+	}
+
+	/* Keep at least one slot free so that lookups terminate */
+	if (sub_table_count + 1 >= SUB_TABLE_SIZE) {
+		sub_table_full = true;
+		return;
+	}
+
+	sub_table[i].addr = addr;
+	sub_table[i].elems = BIT(elem);
+	sub_table_count++;
+}
+
+static void sub_table_add_mod(struct bt_mesh_model *mod,
+			      struct bt_mesh_elem *elem, bool vnd,
+			      bool primary, void *user_data)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(mod->groups); i++) {
+		if (mod->groups[i] != BT_MESH_ADDR_UNASSIGNED) {
+			sub_table_add(elem_idx(elem), mod->groups[i]);
+		}
+	}
+}
+#endif
+
+void bt_mesh_sub_index_add(struct bt_mesh_model *mod, u16_t addr)
+{
+#if SUB_TABLE_SIZE > 0
+	sub_table_add(elem_idx(mod->elem), addr);
+#endif
+}
+
+void bt_mesh_sub_index_rebuild(void)
+{
+#if SUB_TABLE_SIZE > 0
+	memset(sub_table, 0, sizeof(sub_table));
+	sub_table_count = 0;
+	sub_table_full = false;
+
+	bt_mesh_model_foreach(sub_table_add_mod, NULL);
+
+	if (sub_table_full) {
+		BT_WARN("Too many subscriptions for the index (%u slots)",
+			SUB_TABLE_SIZE);
+	}
+#endif
+}
+
+/* Looks up the bitmap of the elements with models subscribed to the given
+ * group or virtual address. Returns false if the index cannot tell.
+ */
+static bool sub_index_lookup(u16_t addr, u32_t *elems)
+{
+#if SUB_TABLE_SIZE > 0
+	u32_t i;
+
+	if (sub_table_full) {
+		return false;
+	}
+
+	for (i = sub_hash(addr); sub_table[i].addr != BT_MESH_ADDR_UNASSIGNED;
+	     i = (i + 1) & (SUB_TABLE_SIZE - 1)) {
+		if (sub_table[i].addr == addr) {
+			*elems = sub_table[i].elems;
+			return true;
+		}
+	}
+
+	*elems = 0;
+	return true;
+#else
+	return false;
+#endif
+}
+
 int bt_mesh_comp_register(const struct bt_mesh_comp *comp)
 {
 	/* There must be at least one element */
@@ -275,6 +473,9 @@ int bt_mesh_comp_register(const struct bt_mesh_comp *comp)
 
 	bt_mesh_model_foreach(mod_init, NULL);
 
+	op_table_build();
+	bt_mesh_sub_index_rebuild();
+
 	return 0;
 }
 
@@ -353,8 +554,18 @@ static struct bt_mesh_model *bt_mesh_elem_find_group(struct bt_mesh_elem *elem,
 
 struct bt_mesh_elem *bt_mesh_elem_find(u16_t addr)
 {
+	u32_t elems;
 	int i;
 
+	if ((BT_MESH_ADDR_IS_GROUP(addr) || BT_MESH_ADDR_IS_VIRTUAL(addr)) &&
+	    sub_index_lookup(addr, &elems)) {
+		if (!elems) {
+			return NULL;
+		}
+
+		return &dev_comp->elem[find_lsb_set(elems) - 1];
+	}
+
 	for (i = 0; i < dev_comp->elem_count; i++) {
 		struct bt_mesh_elem *elem = &dev_comp->elem[i];
 
@@ -389,26 +600,65 @@ static bool model_has_key(struct bt_mesh_model *mod, u16_t key)
 	return false;
 }
 
-static const struct bt_mesh_model_op *find_op(struct bt_mesh_model *models,
-					      u8_t model_count, u16_t dst,
-					      u16_t app_idx, u32_t opcode,
-					      struct bt_mesh_model **model)
+static bool model_accepts(struct bt_mesh_model *mod, u16_t dst,
+			  u16_t app_idx)
 {
-	u8_t i;
-
-	for (i = 0; i < model_count; i++) {
-		const struct bt_mesh_model_op *op;
+	if (BT_MESH_ADDR_IS_GROUP(dst) || BT_MESH_ADDR_IS_VIRTUAL(dst)) {
+		if (!bt_mesh_model_find_group(mod, dst)) {
+			return false;
+		}
+	}
 
-		*model = &models[i];
+	return model_has_key(mod, app_idx);
+}
 
-		if (BT_MESH_ADDR_IS_GROUP(dst) ||
-		    BT_MESH_ADDR_IS_VIRTUAL(dst)) {
-			if (!bt_mesh_model_find_group(*model, dst)) {
+static const struct bt_mesh_model_op *find_op(struct bt_mesh_elem *elem,
+					      u16_t dst, u16_t app_idx,
+					      u32_t opcode,
+					      struct bt_mesh_model **model)
+{
+	struct bt_mesh_model *models;
+	u8_t count;
+	u32_t i;
+
+#if OP_TABLE_SIZE > 0
+	if (!op_table_full) {
+		for (i = op_hash(elem_idx(elem), opcode); op_table[i].op;
+		     i = (i + 1) & (OP_TABLE_SIZE - 1)) {
+			if (op_table[i].op->opcode != opcode ||
+			    op_table[i].mod->elem != elem) {
 				continue;
 			}
+
+			if (model_accepts(op_table[i].mod, dst, app_idx)) {
+				*model = op_table[i].mod;
+				return op_table[i].op;
+			}
 		}
 
-		if (!model_has_key(*model, app_idx)) {
+		*model = NULL;
+		return NULL;
+	}
+#endif
+
+	/* SIG models cannot contain 3-byte (vendor) OpCodes, and
+	 * vendor models cannot contain SIG (1- or 2-byte) OpCodes, so
+	 * we only need to do the lookup in one of the model lists.
+	 */
+	if (opcode < 0x10000) {
+		models = elem->models;
+		count = elem->model_count;
+	} else {
+		models = elem->vnd_models;
+		count = elem->vnd_model_count;
+	}
+
+	for (i = 0; i < count; i++) {
+		const struct bt_mesh_model_op *op;
+
+		*model = &models[i];
+
+		if (!model_accepts(*model, dst, app_idx)) {
 			continue;
 		}
 
@@ -477,10 +727,10 @@ bool bt_mesh_fixed_group_match(u16_t addr)
 
 void bt_mesh_model_recv(struct bt_mesh_net_rx *rx, struct os_mbuf *buf)
 {
-	struct bt_mesh_model *models, *model;
+	struct bt_mesh_model *model;
 	const struct bt_mesh_model_op *op;
+	u32_t sub_elems = 0;
 	u32_t opcode;
-	u8_t count;
 	int i;
 
 	BT_DBG("app_idx 0x%04x src 0x%04x dst 0x%04x", rx->ctx.app_idx,
@@ -494,6 +744,12 @@ void bt_mesh_model_recv(struct bt_mesh_net_rx *rx, struct os_mbuf *buf)
 
 	BT_DBG("OpCode 0x%08x", opcode);
 
+	if ((BT_MESH_ADDR_IS_GROUP(rx->dst) ||
+	     BT_MESH_ADDR_IS_VIRTUAL(rx->dst)) &&
+	    !sub_index_lookup(rx->dst, &sub_elems)) {
+		sub_elems = UINT32_MAX;
+	}
+
 	for (i = 0; i < dev_comp->elem_count; i++) {
 		struct bt_mesh_elem *elem = &dev_comp->elem[i];
 
@@ -504,23 +760,14 @@ void bt_mesh_model_recv(struct bt_mesh_net_rx *rx, struct os_mbuf *buf)
 		} else if (BT_MESH_ADDR_IS_GROUP(rx->dst) ||
 			   BT_MESH_ADDR_IS_VIRTUAL(rx->dst)) {
 			/* find_op will find the correct model for the group */
+			if (i < 32 && !(sub_elems & BIT(i))) {
+				continue;
+			}
 		} else if (i != 0 || !bt_mesh_fixed_group_match(rx->dst)) {
 			continue;
 		}
 
-		/* SIG models cannot contain 3-byte (vendor) OpCodes, and
-		 * vendor models cannot contain SIG (1- or 2-byte) OpCodes, so
-		 * we only need to do the lookup in one of the model lists.
-		 */
-		if (opcode < 0x10000) {
-			models = elem->models;
-			count = elem->model_count;
-		} else {
-			models = elem->vnd_models;
-			count = elem->vnd_model_count;
-		}
-
-		op = find_op(models, count, rx->dst, rx->ctx.app_idx, opcode, &model);
+		op = find_op(elem, rx->dst, rx->ctx.app_idx, opcode, &model);
 		if (op) {
 			struct net_buf_simple_state state;
 
@@ -25,6 +25,12 @@ struct bt_mesh_model * bt_mesh_model_find(struct bt_mesh_elem *elem,
 
 u16_t *bt_mesh_model_find_group(struct bt_mesh_model *mod, u16_t addr);
 
+/* Keep the subscription index in sync with the model subscription lists.
+ * Must be called after the addresses have been added or removed.
+ */
+void bt_mesh_sub_index_add(struct bt_mesh_model *mod, u16_t addr);
+void bt_mesh_sub_index_rebuild(void);
+
 bool bt_mesh_fixed_group_match(u16_t addr);
 
 void bt_mesh_model_foreach(void (*func)(struct bt_mesh_model *mod,
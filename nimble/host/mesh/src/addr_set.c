@@ -0,0 +1,80 @@
+/*  Bluetooth Mesh */
+
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "addr_set.h"
+
+void bt_mesh_addr_set_init(struct bt_mesh_addr_set *set, u16_t *addrs,
+			   u16_t size)
+{
+	set->addrs = addrs;
+	set->size = size;
+	set->count = 0;
+}
+
+/* Returns the index of the address, or of the first larger address if it
+ * is not in the set.
+ */
+static u16_t addr_set_find(const struct bt_mesh_addr_set *set, u16_t addr)
+{
+	u16_t lo = 0, hi = set->count;
+
+	while (lo < hi) {
+		u16_t mid = (lo + hi) / 2;
+
+		if (set->addrs[mid] < addr) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+int bt_mesh_addr_set_add(struct bt_mesh_addr_set *set, u16_t addr)
+{
+	u16_t i = addr_set_find(set, addr);
+
+	if (i < set->count && set->addrs[i] == addr) {
+		return 0;
+	}
+
+	if (set->count == set->size) {
+		return -ENOMEM;
+	}
+
+	memmove(&set->addrs[i + 1], &set->addrs[i],
+		(set->count - i) * sizeof(set->addrs[0]));
+	set->addrs[i] = addr;
+	set->count++;
+
+	return 0;
+}
+
+bool bt_mesh_addr_set_del(struct bt_mesh_addr_set *set, u16_t addr)
+{
+	u16_t i = addr_set_find(set, addr);
+
+	if (i == set->count || set->addrs[i] != addr) {
+		return false;
+	}
+
+	set->count--;
+	memmove(&set->addrs[i], &set->addrs[i + 1],
+		(set->count - i) * sizeof(set->addrs[0]));
+
+	return true;
+}
+
+bool bt_mesh_addr_set_has(const struct bt_mesh_addr_set *set, u16_t addr)
+{
+	u16_t i = addr_set_find(set, addr);
+
+	return i < set->count && set->addrs[i] == addr;
+}
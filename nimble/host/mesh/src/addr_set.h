@@ -0,0 +1,38 @@
+/*  Bluetooth Mesh */
+
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef __ADDR_SET_H__
+#define __ADDR_SET_H__
+
+#include "mesh/mesh.h"
+
+/* Set of mesh addresses kept as a sorted array, so that membership tests
+ * are a binary search. The storage is provided by the owner of the set.
+ */
+struct bt_mesh_addr_set {
+	u16_t *addrs;
+	u16_t size;
+	u16_t count;
+};
+
+void bt_mesh_addr_set_init(struct bt_mesh_addr_set *set, u16_t *addrs,
+			   u16_t size);
+
+static inline void bt_mesh_addr_set_clear(struct bt_mesh_addr_set *set)
+{
+	set->count = 0;
+}
+
+/* Returns 0 if the address was added or already present, -ENOMEM if the
+ * set is full.
+ */
+int bt_mesh_addr_set_add(struct bt_mesh_addr_set *set, u16_t addr);
+
+/* Returns true if the address was present */
+bool bt_mesh_addr_set_del(struct bt_mesh_addr_set *set, u16_t addr);
+
+bool bt_mesh_addr_set_has(const struct bt_mesh_addr_set *set, u16_t addr);
+
+#endif
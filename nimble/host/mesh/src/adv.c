@@ -76,6 +76,66 @@ static struct bt_mesh_adv *adv_alloc(int id)
 	return &adv_pool[id];
 }
 
+#if MYNEWT_VAL(BLE_MESH_RELAY_BUF_COUNT) > 0
+static os_membuf_t relay_buf_mem[OS_MEMPOOL_SIZE(
+		MYNEWT_VAL(BLE_MESH_RELAY_BUF_COUNT),
+		BT_MESH_ADV_DATA_SIZE + BT_MESH_MBUF_HEADER_SIZE)];
+
+static struct os_mbuf_pool relay_os_mbuf_pool;
+static struct os_mempool relay_buf_mempool;
+
+static struct bt_mesh_adv relay_adv_pool[MYNEWT_VAL(BLE_MESH_RELAY_BUF_COUNT)];
+
+static struct bt_mesh_adv *relay_adv_alloc(int id)
+{
+	return &relay_adv_pool[id];
+}
+#endif
+
+#if MYNEWT_VAL(BLE_MESH_RELAY_JITTER) > 0
+/* Getting random numbers from the controller for every relayed message
+ * would be too slow, so it only seeds a xorshift generator.
+ */
+static s32_t relay_jitter(void)
+{
+	static u32_t state;
+
+	while (!state) {
+		if (bt_rand(&state, sizeof(state))) {
+			/* Better some jitter than none */
+			state = k_uptime_get_32() | 1;
+		}
+	}
+
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+
+	return state % (MYNEWT_VAL(BLE_MESH_RELAY_JITTER) + 1);
+}
+
+static void relay_put(struct os_mbuf *buf)
+{
+	struct bt_mesh_adv *adv = BT_MESH_ADV(buf);
+	s32_t delay;
+
+	delay = relay_jitter();
+	if (!delay) {
+		net_buf_put(&adv_queue, net_buf_ref(buf));
+		return;
+	}
+
+	/* The expired callout posts its own event, carrying the buffer, to
+	 * the advertising queue, so neither this context nor the advertising
+	 * thread has to wait for it.
+	 */
+	ble_npl_callout_init(&adv->relay_delay, &adv_queue, NULL,
+			     net_buf_ref(buf));
+	ble_npl_callout_reset(&adv->relay_delay,
+			      ble_npl_time_ms_to_ticks32(delay));
+}
+#endif
+
 static inline void adv_send_start(u16_t duration, int err,
 				  const struct bt_mesh_send_cb *cb,
 				  void *cb_data)
@@ -230,6 +290,25 @@ struct os_mbuf *bt_mesh_adv_create(enum bt_mesh_adv_type type, u8_t xmit_count,
 					    xmit_count, xmit_int, timeout);
 }
 
+struct os_mbuf *bt_mesh_adv_relay_create(u8_t xmit_count, u8_t xmit_int)
+{
+	struct os_mbuf *buf;
+
+#if MYNEWT_VAL(BLE_MESH_RELAY_BUF_COUNT) > 0
+	buf = bt_mesh_adv_create_from_pool(&relay_os_mbuf_pool, relay_adv_alloc,
+					   BT_MESH_ADV_DATA, xmit_count,
+					   xmit_int, K_NO_WAIT);
+#else
+	buf = bt_mesh_adv_create(BT_MESH_ADV_DATA, xmit_count, xmit_int,
+				 K_NO_WAIT);
+#endif
+	if (buf) {
+		BT_MESH_ADV(buf)->relay = 1;
+	}
+
+	return buf;
+}
+
 void bt_mesh_adv_send(struct os_mbuf *buf, const struct bt_mesh_send_cb *cb,
 		      void *cb_data)
 {
@@ -240,6 +319,13 @@ void bt_mesh_adv_send(struct os_mbuf *buf, const struct bt_mesh_send_cb *cb,
 	BT_MESH_ADV(buf)->cb_data = cb_data;
 	BT_MESH_ADV(buf)->busy = 1;
 
+#if MYNEWT_VAL(BLE_MESH_RELAY_JITTER) > 0
+	if (BT_MESH_ADV(buf)->relay) {
+		relay_put(buf);
+		return;
+	}
+#endif
+
 	net_buf_put(&adv_queue, net_buf_ref(buf));
 }
 
@@ -308,6 +394,19 @@ void bt_mesh_adv_init(void)
 			       MYNEWT_VAL(BLE_MESH_ADV_BUF_COUNT));
 	assert(rc == 0);
 
+#if MYNEWT_VAL(BLE_MESH_RELAY_BUF_COUNT) > 0
+	rc = os_mempool_init(&relay_buf_mempool,
+			     MYNEWT_VAL(BLE_MESH_RELAY_BUF_COUNT),
+			     BT_MESH_ADV_DATA_SIZE + BT_MESH_MBUF_HEADER_SIZE,
+			     relay_buf_mem, "relay_buf_pool");
+	assert(rc == 0);
+
+	rc = os_mbuf_pool_init(&relay_os_mbuf_pool, &relay_buf_mempool,
+			       BT_MESH_ADV_DATA_SIZE + BT_MESH_MBUF_HEADER_SIZE,
+			       MYNEWT_VAL(BLE_MESH_RELAY_BUF_COUNT));
+	assert(rc == 0);
+#endif
+
 	ble_npl_eventq_init(&adv_queue);
 
 #if MYNEWT
@@ -339,7 +438,7 @@ ble_adv_gap_mesh_cb(struct ble_gap_event *event, void *arg)
 #if MYNEWT_VAL(BLE_EXT_ADV)
 	case BLE_GAP_EVENT_EXT_DISC:
 		ext_desc = &event->ext_disc;
-		buf = os_mbuf_get_pkthdr(&adv_os_mbuf_pool, 0);
+		buf = os_msys_get_pkthdr(ext_desc->length_data, 0);
 		if (!buf || os_mbuf_append(buf, ext_desc->data, ext_desc->length_data)) {
 			BT_ERR("Could not append data");
 			goto done;
@@ -350,7 +449,10 @@ ble_adv_gap_mesh_cb(struct ble_gap_event *event, void *arg)
 #endif
 	case BLE_GAP_EVENT_DISC:
 		desc = &event->disc;
-		buf = os_mbuf_get_pkthdr(&adv_os_mbuf_pool, 0);
+		/* Not from the advertising pool: segments waiting for their
+		 * ack may use it all up, and the ack has to get through.
+		 */
+		buf = os_msys_get_pkthdr(desc->length_data, 0);
 		if (!buf || os_mbuf_append(buf, desc->data, desc->length_data)) {
 			BT_ERR("Could not append data");
 			goto done;
@@ -16,8 +16,8 @@
 
 #define BT_MESH_ADV_DATA_SIZE 31
 
-/* The user data is a pointer (4 bytes) to struct bt_mesh_adv */
-#define BT_MESH_ADV_USER_DATA_SIZE 4
+/* The user data is a pointer to struct bt_mesh_adv */
+#define BT_MESH_ADV_USER_DATA_SIZE (sizeof(struct bt_mesh_adv *))
 
 #define BT_MESH_MBUF_HEADER_SIZE (sizeof(struct os_mbuf_pkthdr) + \
                                     BT_MESH_ADV_USER_DATA_SIZE +\
@@ -39,7 +39,8 @@ struct bt_mesh_adv {
 	void *cb_data;
 
 	u8_t      type:2,
-		  busy:1;
+		  busy:1,
+		  relay:1;
 	u8_t      count:3,
 		  adv_int:5;
 	union {
@@ -54,6 +55,10 @@ struct bt_mesh_adv {
 
 	int ref_cnt;
 	struct ble_npl_event ev;
+#if MYNEWT_VAL(BLE_MESH_RELAY_JITTER) > 0
+	/* Queues a relayed buffer once its random delay has passed */
+	struct ble_npl_callout relay_delay;
+#endif
 };
 
 typedef struct bt_mesh_adv *(*bt_mesh_adv_alloc_t)(int id);
@@ -68,6 +73,9 @@ struct os_mbuf *bt_mesh_adv_create_from_pool(struct os_mbuf_pool *pool,
 					     u8_t xmit_count, u8_t xmit_int,
 					     s32_t timeout);
 
+/* Allocates a buffer for relaying a Network PDU */
+struct os_mbuf *bt_mesh_adv_relay_create(u8_t xmit_count, u8_t xmit_int);
+
 void bt_mesh_adv_send(struct os_mbuf *buf, const struct bt_mesh_send_cb *cb,
 		      void *cb_data);
 
@@ -28,16 +28,13 @@
 #include "foundation.h"
 #include "friend.h"
 #include "testing.h"
+#include "settings.h"
 
 #define DEFAULT_TTL 7
 
 static struct bt_mesh_cfg_srv *conf;
 
-static struct label {
-	u16_t ref;
-	u16_t addr;
-	u8_t  uuid[16];
-} labels[MYNEWT_VAL(BLE_MESH_LABEL_COUNT)];
+static struct label labels[MYNEWT_VAL(BLE_MESH_LABEL_COUNT)];
 
 static void hb_send(struct bt_mesh_model *model)
 {
@@ -268,6 +265,8 @@ static u8_t _mod_pub_set(struct bt_mesh_model *model, u16_t pub_addr,
 			k_delayed_work_cancel(&model->pub->timer);
 		}
 
+		bt_mesh_store_mod(model);
+
 		return STATUS_SUCCESS;
 	}
 
@@ -295,6 +294,8 @@ static u8_t _mod_pub_set(struct bt_mesh_model *model, u16_t pub_addr,
 		}
 	}
 
+	bt_mesh_store_mod(model);
+
 	return STATUS_SUCCESS;
 }
 
@@ -318,6 +319,7 @@ u8_t mod_bind(struct bt_mesh_model *model, u16_t key_idx)
 	for (i = 0; i < ARRAY_SIZE(model->keys); i++) {
 		if (model->keys[i] == BT_MESH_KEY_UNUSED) {
 			model->keys[i] = key_idx;
+			bt_mesh_store_mod(model);
 			return STATUS_SUCCESS;
 		}
 	}
@@ -341,6 +343,7 @@ u8_t mod_unbind(struct bt_mesh_model *model, u16_t key_idx)
 		}
 
 		model->keys[i] = BT_MESH_KEY_UNUSED;
+		bt_mesh_store_mod(model);
 
 		if (model->pub && model->pub->key == key_idx) {
 			_mod_pub_set(model, BT_MESH_ADDR_UNASSIGNED,
@@ -446,6 +449,9 @@ static u8_t app_key_set(u16_t net_idx, u16_t app_idx, const u8_t val[16],
 	key->net_idx = net_idx;
 	key->app_idx = app_idx;
 	memcpy(keys->val, val, 16);
+	ble_aes_set_key(&keys->sched, val);
+
+	bt_mesh_store_app_key(key);
 
 	return STATUS_SUCCESS;
 }
@@ -518,6 +524,8 @@ static void _app_key_del(struct bt_mesh_app_key *key)
 
 	key->net_idx = BT_MESH_KEY_UNUSED;
 	memset(key->keys, 0, sizeof(key->keys));
+
+	bt_mesh_store_app_key(key);
 }
 
 static void app_key_del(struct bt_mesh_model *model,
@@ -672,6 +680,7 @@ static void beacon_set(struct bt_mesh_model *model,
 	} else if (buf->om_data[0] == 0x00 || buf->om_data[0] == 0x01) {
 		if (buf->om_data[0] != cfg->beacon) {
 			cfg->beacon = buf->om_data[0];
+			bt_mesh_store_cfg();
 
 			if (cfg->beacon) {
 				bt_mesh_beacon_enable();
@@ -732,7 +741,10 @@ static void default_ttl_set(struct bt_mesh_model *model,
 	if (!cfg) {
 		BT_WARN("No Configuration Server context available");
 	} else if (buf->om_data[0] <= BT_MESH_TTL_MAX && buf->om_data[0] != 0x01) {
-		cfg->default_ttl = buf->om_data[0];
+		if (cfg->default_ttl != buf->om_data[0]) {
+			cfg->default_ttl = buf->om_data[0];
+			bt_mesh_store_cfg();
+		}
 	} else {
 		BT_WARN("Prohibited Default TTL value 0x%02x", buf->om_data[0]);
 		goto done;
@@ -810,6 +822,8 @@ static void gatt_proxy_set(struct bt_mesh_model *model,
 	}
 
 	cfg->gatt_proxy = buf->om_data[0];
+	bt_mesh_store_cfg();
+
 	if (cfg->gatt_proxy == BT_MESH_GATT_PROXY_DISABLED) {
 		int i;
 
@@ -883,8 +897,9 @@ static void net_transmit_set(struct bt_mesh_model *model,
 
 	if (!cfg) {
 		BT_WARN("No Configuration Server context available");
-	} else {
+	} else if (cfg->net_transmit != buf->om_data[0]) {
 		cfg->net_transmit = buf->om_data[0];
+		bt_mesh_store_cfg();
 	}
 
 	bt_mesh_model_msg_init(msg, OP_NET_TRANSMIT_STATUS);
@@ -944,6 +959,7 @@ static void relay_set(struct bt_mesh_model *model,
 			change = (cfg->relay != buf->om_data[0]);
 			cfg->relay = buf->om_data[0];
 			cfg->relay_retransmit = buf->om_data[1];
+			bt_mesh_store_cfg();
 		}
 
 		BT_DBG("Relay 0x%02x (%s) xmit 0x%02x (count %u interval %u)",
@@ -1129,6 +1145,7 @@ static u8_t va_add(u8_t *label_uuid, u16_t *addr)
 		if (!memcmp(labels[i].uuid, label_uuid, 16)) {
 			*addr = labels[i].addr;
 			labels[i].ref++;
+			bt_mesh_store_label(i);
 			return STATUS_SUCCESS;
 		}
 	}
@@ -1144,6 +1161,7 @@ static u8_t va_add(u8_t *label_uuid, u16_t *addr)
 	free_slot->ref = 1;
 	free_slot->addr = *addr;
 	memcpy(free_slot->uuid, label_uuid, 16);
+	bt_mesh_store_label(free_slot - labels);
 
 	return STATUS_SUCCESS;
 }
@@ -1159,6 +1177,7 @@ static u8_t va_del(u8_t *label_uuid, u16_t *addr)
 			}
 
 			labels[i].ref--;
+			bt_mesh_store_label(i);
 			return STATUS_SUCCESS;
 		}
 	}
@@ -1192,6 +1211,8 @@ static void mod_sub_list_clear(struct bt_mesh_model *mod)
 
 	/* Clear all subscriptions (0x0000 is the unassigned address) */
 	memset(mod->groups, 0, sizeof(mod->groups));
+	bt_mesh_sub_index_rebuild();
+	bt_mesh_store_mod(mod);
 }
 
 static void mod_pub_va_set(struct bt_mesh_model *model,
@@ -1262,6 +1283,8 @@ static void mod_sub_list_clear(struct bt_mesh_model *mod)
 {
 	/* Clear all subscriptions (0x0000 is the unassigned address) */
 	memset(mod->groups, 0, sizeof(mod->groups));
+	bt_mesh_sub_index_rebuild();
+	bt_mesh_store_mod(mod);
 }
 
 static void mod_pub_va_set(struct bt_mesh_model *model,
@@ -1392,6 +1415,9 @@ static void mod_sub_add(struct bt_mesh_model *model,
 	if (i == ARRAY_SIZE(mod->groups)) {
 		status = STATUS_INSUFF_RESOURCES;
 	} else {
+		bt_mesh_sub_index_add(mod, sub_addr);
+		bt_mesh_store_mod(mod);
+
 		status = STATUS_SUCCESS;
 
 		if ((MYNEWT_VAL(BLE_MESH_LOW_POWER))) {
@@ -1454,6 +1480,8 @@ static void mod_sub_del(struct bt_mesh_model *model,
 	match = bt_mesh_model_find_group(mod, sub_addr);
 	if (match) {
 		*match = BT_MESH_ADDR_UNASSIGNED;
+		bt_mesh_sub_index_rebuild();
+		bt_mesh_store_mod(mod);
 	}
 
 send_status:
@@ -1506,6 +1534,8 @@ static void mod_sub_overwrite(struct bt_mesh_model *model,
 
 	if (ARRAY_SIZE(mod->groups) > 0) {
 		mod->groups[0] = sub_addr;
+		bt_mesh_sub_index_add(mod, sub_addr);
+		bt_mesh_store_mod(mod);
 		status = STATUS_SUCCESS;
 
 		if ((MYNEWT_VAL(BLE_MESH_LOW_POWER))) {
@@ -1737,6 +1767,9 @@ static void mod_sub_va_add(struct bt_mesh_model *model,
 	if (i == ARRAY_SIZE(mod->groups)) {
 		status = STATUS_INSUFF_RESOURCES;
 	} else {
+		bt_mesh_sub_index_add(mod, sub_addr);
+		bt_mesh_store_mod(mod);
+
 		if ((MYNEWT_VAL(BLE_MESH_LOW_POWER))) {
 			bt_mesh_lpn_group_add(sub_addr);
 		}
@@ -1798,6 +1831,8 @@ static void mod_sub_va_del(struct bt_mesh_model *model,
 	match = bt_mesh_model_find_group(mod, sub_addr);
 	if (match) {
 		*match = BT_MESH_ADDR_UNASSIGNED;
+		bt_mesh_sub_index_rebuild();
+		bt_mesh_store_mod(mod);
 		status = STATUS_SUCCESS;
 	} else {
 		status = STATUS_CANNOT_REMOVE;
@@ -1852,6 +1887,8 @@ static void mod_sub_va_overwrite(struct bt_mesh_model *model,
 		status = va_add(label_uuid, &sub_addr);
 		if (status == STATUS_SUCCESS) {
 			mod->groups[0] = sub_addr;
+			bt_mesh_sub_index_add(mod, sub_addr);
+			bt_mesh_store_mod(mod);
 
 			if ((MYNEWT_VAL(BLE_MESH_LOW_POWER))) {
 				bt_mesh_lpn_group_add(sub_addr);
@@ -2046,6 +2083,7 @@ static void net_key_add(struct bt_mesh_model *model,
 	}
 
 	sub->net_idx = idx;
+	bt_mesh_store_subnet(sub);
 
 	/* Make sure we have valid beacon data to be sent */
 	bt_mesh_net_beacon_update(sub);
@@ -2119,6 +2157,7 @@ static void net_key_update(struct bt_mesh_model *model,
 	}
 
 	sub->kr_phase = BT_MESH_KR_PHASE_1;
+	bt_mesh_store_subnet(sub);
 
 	bt_mesh_net_beacon_update(sub);
 
@@ -2190,6 +2229,7 @@ static void net_key_del(struct bt_mesh_model *model,
 
 	memset(sub, 0, sizeof(*sub));
 	sub->net_idx = BT_MESH_KEY_UNUSED;
+	bt_mesh_store_subnet(sub);
 
 	status = STATUS_SUCCESS;
 
@@ -2609,6 +2649,7 @@ static void friend_set(struct bt_mesh_model *model,
 
 	if (MYNEWT_VAL(BLE_MESH_FRIEND)) {
 		cfg->frnd = buf->om_data[0];
+		bt_mesh_store_cfg();
 
 		if (cfg->frnd == BT_MESH_FRIEND_DISABLED) {
 			bt_mesh_friend_clear_net_idx(BT_MESH_KEY_ANY);
@@ -2753,6 +2794,7 @@ static void krp_set(struct bt_mesh_model *model, struct bt_mesh_msg_ctx *ctx,
 	    phase == BT_MESH_KR_PHASE_2) {
 		sub->kr_phase = BT_MESH_KR_PHASE_2;
 		sub->kr_flag = 1;
+		bt_mesh_store_subnet(sub);
 		bt_mesh_net_beacon_update(sub);
 	} else if ((sub->kr_phase == BT_MESH_KR_PHASE_1 ||
 		    sub->kr_phase == BT_MESH_KR_PHASE_2) &&
@@ -3271,6 +3313,11 @@ void bt_mesh_heartbeat(u16_t src, u16_t dst, u8_t hops, u16_t feat)
 	}
 }
 
+struct bt_mesh_cfg_srv *bt_mesh_cfg_get(void)
+{
+	return conf;
+}
+
 u8_t bt_mesh_net_transmit_get(void)
 {
 	if (conf) {
@@ -3354,3 +3401,12 @@ u8_t *bt_mesh_label_uuid_get(u16_t addr)
 
 	return NULL;
 }
+
+struct label *bt_mesh_label_get(u16_t idx)
+{
+	if (idx >= ARRAY_SIZE(labels)) {
+		return NULL;
+	}
+
+	return &labels[idx];
+}
@@ -10,12 +10,6 @@
 #include <stdbool.h>
 #include <errno.h>
 
-#include <tinycrypt/constants.h>
-#include <tinycrypt/utils.h>
-#include <tinycrypt/aes.h>
-#include <tinycrypt/cmac_mode.h>
-#include <tinycrypt/ccm_mode.h>
-
 #include "syscfg/syscfg.h"
 #define BT_DBG_ENABLED (MYNEWT_VAL(BLE_MESH_DEBUG_CRYPTO))
 #include "host/ble_hs_log.h"
@@ -25,30 +19,32 @@
 #define NET_MIC_LEN(pdu) (((pdu)[1] & 0x80) ? 8 : 4)
 #define APP_MIC_LEN(aszmic) ((aszmic) ? 8 : 4)
 
-int bt_mesh_aes_cmac(const u8_t key[16], struct bt_mesh_sg *sg,
-		     size_t sg_len, u8_t mac[16])
+int bt_mesh_aes_cmac_key(const struct ble_aes_cmac_key *key,
+			 struct bt_mesh_sg *sg, size_t sg_len, u8_t mac[16])
 {
-	struct tc_aes_key_sched_struct sched;
-	struct tc_cmac_struct state;
+	struct ble_aes_cmac cmac;
 
-	if (tc_cmac_setup(&state, key, &sched) == TC_CRYPTO_FAIL) {
-		return -EIO;
-	}
+	ble_aes_cmac_init(&cmac, key);
 
 	for (; sg_len; sg_len--, sg++) {
-		if (tc_cmac_update(&state, sg->data,
-				   sg->len) == TC_CRYPTO_FAIL) {
-			return -EIO;
-		}
+		ble_aes_cmac_update(&cmac, sg->data, sg->len);
 	}
 
-	if (tc_cmac_final(mac, &state) == TC_CRYPTO_FAIL) {
-		return -EIO;
-	}
+	ble_aes_cmac_final(&cmac, mac);
 
 	return 0;
 }
 
+int bt_mesh_aes_cmac(const u8_t key[16], struct bt_mesh_sg *sg,
+		     size_t sg_len, u8_t mac[16])
+{
+	struct ble_aes_cmac_key cmac_key;
+
+	ble_aes_cmac_set_key(&cmac_key, key);
+
+	return bt_mesh_aes_cmac_key(&cmac_key, sg, sg_len, mac);
+}
+
 int bt_mesh_k1(const u8_t *ikm, size_t ikm_len, const u8_t salt[16],
 	       const char *info, u8_t okm[16])
 {
@@ -195,7 +191,8 @@ int bt_mesh_id128(const u8_t n[16], const char *s, u8_t out[16])
 	return bt_mesh_k1(n, 16, salt, id128, out);
 }
 
-static int bt_mesh_ccm_decrypt(const u8_t key[16], u8_t nonce[13],
+static int bt_mesh_ccm_decrypt(const struct ble_aes_key *sched,
+			       u8_t nonce[13],
 			       const u8_t *enc_msg, size_t msg_len,
 			       const u8_t *aad, size_t aad_len,
 			       u8_t *out_msg, size_t mic_size)
@@ -203,7 +200,6 @@ static int bt_mesh_ccm_decrypt(const u8_t key[16], u8_t nonce[13],
 	u8_t msg[16], pmsg[16], cmic[16], cmsg[16], Xn[16], mic[16];
 	u16_t last_blk, blk_cnt;
 	size_t i, j;
-	int err;
 
 	if (msg_len < 1 || aad_len >= 0xff00) {
 		return -EINVAL;
@@ -214,10 +210,7 @@ static int bt_mesh_ccm_decrypt(const u8_t key[16], u8_t nonce[13],
 	memcpy(pmsg + 1, nonce, 13);
 	sys_put_be16(0x0000, pmsg + 14);
 
-	err = bt_encrypt_be(key, pmsg, cmic);
-	if (err) {
-		return err;
-	}
+	ble_aes_encrypt(sched, pmsg, cmic);
 
 	/* X_0 = e(AppKey, 0x09 || nonce || length) */
 	if (mic_size == sizeof(u64_t)) {
@@ -229,10 +222,7 @@ static int bt_mesh_ccm_decrypt(const u8_t key[16], u8_t nonce[13],
 	memcpy(pmsg + 1, nonce, 13);
 	sys_put_be16(msg_len, pmsg + 14);
 
-	err = bt_encrypt_be(key, pmsg, Xn);
-	if (err) {
-		return err;
-	}
+	ble_aes_encrypt(sched, pmsg, Xn);
 
 	/* If AAD is being used to authenticate, include it here */
 	if (aad_len) {
@@ -253,10 +243,7 @@ static int bt_mesh_ccm_decrypt(const u8_t key[16], u8_t nonce[13],
 			aad_len -= 16;
 			i = 0;
 
-			err = bt_encrypt_be(key, pmsg, Xn);
-			if (err) {
-				return err;
-			}
+			ble_aes_encrypt(sched, pmsg, Xn);
 		}
 
 		for (i = 0; i < aad_len; i++, j++) {
@@ -267,10 +254,7 @@ static int bt_mesh_ccm_decrypt(const u8_t key[16], u8_t nonce[13],
 			pmsg[i] = Xn[i];
 		}
 
-		err = bt_encrypt_be(key, pmsg, Xn);
-		if (err) {
-			return err;
-		}
+		ble_aes_encrypt(sched, pmsg, Xn);
 	}
 
 	last_blk = msg_len % 16;
@@ -286,10 +270,7 @@ static int bt_mesh_ccm_decrypt(const u8_t key[16], u8_t nonce[13],
 			memcpy(pmsg + 1, nonce, 13);
 			sys_put_be16(j + 1, pmsg + 14);
 
-			err = bt_encrypt_be(key, pmsg, cmsg);
-			if (err) {
-				return err;
-			}
+			ble_aes_encrypt(sched, pmsg, cmsg);
 
 			/* Encrypted = Payload[0-15] ^ C_1 */
 			for (i = 0; i < last_blk; i++) {
@@ -307,10 +288,7 @@ static int bt_mesh_ccm_decrypt(const u8_t key[16], u8_t nonce[13],
 				pmsg[i] = Xn[i] ^ 0x00;
 			}
 
-			err = bt_encrypt_be(key, pmsg, Xn);
-			if (err) {
-				return err;
-			}
+			ble_aes_encrypt(sched, pmsg, Xn);
 
 			/* MIC = C_mic ^ X_1 */
 			for (i = 0; i < sizeof(mic); i++) {
@@ -322,10 +300,7 @@ static int bt_mesh_ccm_decrypt(const u8_t key[16], u8_t nonce[13],
 			memcpy(pmsg + 1, nonce, 13);
 			sys_put_be16(j + 1, pmsg + 14);
 
-			err = bt_encrypt_be(key, pmsg, cmsg);
-			if (err) {
-				return err;
-			}
+			ble_aes_encrypt(sched, pmsg, cmsg);
 
 			/* Encrypted = Payload[0-15] ^ C_1 */
 			for (i = 0; i < 16; i++) {
@@ -339,10 +314,7 @@ static int bt_mesh_ccm_decrypt(const u8_t key[16], u8_t nonce[13],
 				pmsg[i] = Xn[i] ^ msg[i];
 			}
 
-			err = bt_encrypt_be(key, pmsg, Xn);
-			if (err) {
-				return err;
-			}
+			ble_aes_encrypt(sched, pmsg, Xn);
 		}
 	}
 
@@ -353,7 +325,8 @@ static int bt_mesh_ccm_decrypt(const u8_t key[16], u8_t nonce[13],
 	return 0;
 }
 
-static int bt_mesh_ccm_encrypt(const u8_t key[16], u8_t nonce[13],
+static int bt_mesh_ccm_encrypt(const struct ble_aes_key *sched,
+			       u8_t nonce[13],
 			       const u8_t *msg, size_t msg_len,
 			       const u8_t *aad, size_t aad_len,
 			       u8_t *out_msg, size_t mic_size)
@@ -361,9 +334,7 @@ static int bt_mesh_ccm_encrypt(const u8_t key[16], u8_t nonce[13],
 	u8_t pmsg[16], cmic[16], cmsg[16], mic[16], Xn[16];
 	u16_t blk_cnt, last_blk;
 	size_t i, j;
-	int err;
 
-	BT_DBG("key %s", bt_hex(key, 16));
 	BT_DBG("nonce %s", bt_hex(nonce, 13));
 	BT_DBG("msg (len %zu) %s", msg_len, bt_hex(msg, msg_len));
 	BT_DBG("aad_len %zu mic_size %zu", aad_len, mic_size);
@@ -378,10 +349,7 @@ static int bt_mesh_ccm_encrypt(const u8_t key[16], u8_t nonce[13],
 	memcpy(pmsg + 1, nonce, 13);
 	sys_put_be16(0x0000, pmsg + 14);
 
-	err = bt_encrypt_be(key, pmsg, cmic);
-	if (err) {
-		return err;
-	}
+	ble_aes_encrypt(sched, pmsg, cmic);
 
 	/* X_0 = e(AppKey, 0x09 || nonce || length) */
 	if (mic_size == sizeof(u64_t)) {
@@ -393,10 +361,7 @@ static int bt_mesh_ccm_encrypt(const u8_t key[16], u8_t nonce[13],
 	memcpy(pmsg + 1, nonce, 13);
 	sys_put_be16(msg_len, pmsg + 14);
 
-	err = bt_encrypt_be(key, pmsg, Xn);
-	if (err) {
-		return err;
-	}
+	ble_aes_encrypt(sched, pmsg, Xn);
 
 	/* If AAD is being used to authenticate, include it here */
 	if (aad_len) {
@@ -417,10 +382,7 @@ static int bt_mesh_ccm_encrypt(const u8_t key[16], u8_t nonce[13],
 			aad_len -= 16;
 			i = 0;
 
-			err = bt_encrypt_be(key, pmsg, Xn);
-			if (err) {
-				return err;
-			}
+			ble_aes_encrypt(sched, pmsg, Xn);
 		}
 
 		for (i = 0; i < aad_len; i++, j++) {
@@ -431,10 +393,7 @@ static int bt_mesh_ccm_encrypt(const u8_t key[16], u8_t nonce[13],
 			pmsg[i] = Xn[i];
 		}
 
-		err = bt_encrypt_be(key, pmsg, Xn);
-		if (err) {
-			return err;
-		}
+		ble_aes_encrypt(sched, pmsg, Xn);
 	}
 
 	last_blk = msg_len % 16;
@@ -453,10 +412,7 @@ static int bt_mesh_ccm_encrypt(const u8_t key[16], u8_t nonce[13],
 				pmsg[i] = Xn[i] ^ 0x00;
 			}
 
-			err = bt_encrypt_be(key, pmsg, Xn);
-			if (err) {
-				return err;
-			}
+			ble_aes_encrypt(sched, pmsg, Xn);
 
 			/* MIC = C_mic ^ X_1 */
 			for (i = 0; i < sizeof(mic); i++) {
@@ -468,10 +424,7 @@ static int bt_mesh_ccm_encrypt(const u8_t key[16], u8_t nonce[13],
 			memcpy(pmsg + 1, nonce, 13);
 			sys_put_be16(j + 1, pmsg + 14);
 
-			err = bt_encrypt_be(key, pmsg, cmsg);
-			if (err) {
-				return err;
-			}
+			ble_aes_encrypt(sched, pmsg, cmsg);
 
 			/* Encrypted = Payload[0-15] ^ C_1 */
 			for (i = 0; i < last_blk; i++) {
@@ -484,20 +437,14 @@ static int bt_mesh_ccm_encrypt(const u8_t key[16], u8_t nonce[13],
 				pmsg[i] = Xn[i] ^ msg[(j * 16) + i];
 			}
 
-			err = bt_encrypt_be(key, pmsg, Xn);
-			if (err) {
-				return err;
-			}
+			ble_aes_encrypt(sched, pmsg, Xn);
 
 			/* C_1 = e(AppKey, 0x01 || nonce || 0x0001) */
 			pmsg[0] = 0x01;
 			memcpy(pmsg + 1, nonce, 13);
 			sys_put_be16(j + 1, pmsg + 14);
 
-			err = bt_encrypt_be(key, pmsg, cmsg);
-			if (err) {
-				return err;
-			}
+			ble_aes_encrypt(sched, pmsg, cmsg);
 
 			/* Encrypted = Payload[0-15] ^ C_N */
 			for (i = 0; i < 16; i++) {
@@ -568,23 +515,20 @@ static void create_net_nonce(u8_t nonce[13], const u8_t *pdu,
 }
 
 int bt_mesh_net_obfuscate(u8_t *pdu, u32_t iv_index,
-			  const u8_t privacy_key[16])
+			  const struct ble_aes_key *privacy)
 {
 	u8_t priv_rand[16] = { 0x00, 0x00, 0x00, 0x00, 0x00, };
 	u8_t tmp[16];
-	int err, i;
+	int i;
 
-	BT_DBG("IVIndex %u, PrivacyKey %s", iv_index, bt_hex(privacy_key, 16));
+	BT_DBG("IVIndex %u", iv_index);
 
 	sys_put_be32(iv_index, &priv_rand[5]);
 	memcpy(&priv_rand[9], &pdu[7], 7);
 
 	BT_DBG("PrivacyRandom %s", bt_hex(priv_rand, 16));
 
-	err = bt_encrypt_be(privacy_key, priv_rand, tmp);
-	if (err) {
-		return err;
-	}
+	ble_aes_encrypt(privacy, priv_rand, tmp);
 
 	for (i = 0; i < 6; i++) {
 		pdu[1 + i] ^= tmp[i];
@@ -593,15 +537,14 @@ int bt_mesh_net_obfuscate(u8_t *pdu, u32_t iv_index,
 	return 0;
 }
 
-int bt_mesh_net_encrypt(const u8_t key[16], struct os_mbuf *buf,
-			u32_t iv_index, bool proxy)
+int bt_mesh_net_encrypt(const struct ble_aes_key *enc,
+			struct os_mbuf *buf, u32_t iv_index, bool proxy)
 {
 	u8_t mic_len = NET_MIC_LEN(buf->om_data);
 	u8_t nonce[13];
 	int err;
 
-	BT_DBG("IVIndex %u EncKey %s mic_len %u", iv_index, bt_hex(key, 16),
-	       mic_len);
+	BT_DBG("IVIndex %u mic_len %u", iv_index, mic_len);
 	BT_DBG("PDU (len %u) %s", buf->om_len, bt_hex(buf->om_data, buf->om_len));
 
 #if (MYNEWT_VAL(BLE_MESH_PROXY))
@@ -616,7 +559,7 @@ int bt_mesh_net_encrypt(const u8_t key[16], struct os_mbuf *buf,
 
 	BT_DBG("Nonce %s", bt_hex(nonce, 13));
 
-	err = bt_mesh_ccm_encrypt(key, nonce, &buf->om_data[7], buf->om_len - 7,
+	err = bt_mesh_ccm_encrypt(enc, nonce, &buf->om_data[7], buf->om_len - 7,
 				  NULL, 0, &buf->om_data[7], mic_len);
 	if (!err) {
 		net_buf_simple_add(buf, mic_len);
@@ -625,15 +568,14 @@ int bt_mesh_net_encrypt(const u8_t key[16], struct os_mbuf *buf,
 	return err;
 }
 
-int bt_mesh_net_decrypt(const u8_t key[16], struct os_mbuf *buf,
-			u32_t iv_index, bool proxy)
+int bt_mesh_net_decrypt(const struct ble_aes_key *enc,
+			struct os_mbuf *buf, u32_t iv_index, bool proxy)
 {
 	u8_t mic_len = NET_MIC_LEN(buf->om_data);
 	u8_t nonce[13];
 
 	BT_DBG("PDU (%u bytes) %s", buf->om_len, bt_hex(buf->om_data, buf->om_len));
-	BT_DBG("iv_index %u, key %s mic_len %u", iv_index, bt_hex(key, 16),
-	       mic_len);
+	BT_DBG("iv_index %u, mic_len %u", iv_index, mic_len);
 
 #if (MYNEWT_VAL(BLE_MESH_PROXY))
 	if (proxy) {
@@ -649,7 +591,7 @@ int bt_mesh_net_decrypt(const u8_t key[16], struct os_mbuf *buf,
 
 	buf->om_len -= mic_len;
 
-	return bt_mesh_ccm_decrypt(key, nonce, &buf->om_data[7], buf->om_len - 7,
+	return bt_mesh_ccm_decrypt(enc, nonce, &buf->om_data[7], buf->om_len - 7,
 				   NULL, 0, &buf->om_data[7], mic_len);
 }
 
@@ -671,14 +613,14 @@ static void create_app_nonce(u8_t nonce[13], bool dev_key, u8_t aszmic,
 	sys_put_be32(iv_index, &nonce[9]);
 }
 
-int bt_mesh_app_encrypt(const u8_t key[16], bool dev_key, u8_t aszmic,
-			struct os_mbuf *buf, const u8_t *ad,
-			u16_t src, u16_t dst, u32_t seq_num, u32_t iv_index)
+int bt_mesh_app_encrypt(const struct ble_aes_key *key,
+			bool dev_key, u8_t aszmic, struct os_mbuf *buf,
+			const u8_t *ad, u16_t src, u16_t dst, u32_t seq_num,
+			u32_t iv_index)
 {
 	u8_t nonce[13];
 	int err;
 
-	BT_DBG("AppKey %s", bt_hex(key, 16));
 	BT_DBG("dev_key %u src 0x%04x dst 0x%04x", dev_key, src, dst);
 	BT_DBG("seq_num 0x%08x iv_index 0x%08x", seq_num, iv_index);
 	BT_DBG("Clear: %s", bt_hex(buf->om_data, buf->om_len));
@@ -697,8 +639,9 @@ int bt_mesh_app_encrypt(const u8_t key[16], bool dev_key, u8_t aszmic,
 	return err;
 }
 
-int bt_mesh_app_decrypt(const u8_t key[16], bool dev_key, u8_t aszmic,
-			struct os_mbuf *buf, struct os_mbuf *out,
+int bt_mesh_app_decrypt(const struct ble_aes_key *key,
+			bool dev_key, u8_t aszmic, struct os_mbuf *buf,
+			struct os_mbuf *out,
 			const u8_t *ad, u16_t src, u16_t dst, u32_t seq_num,
 			u32_t iv_index)
 {
@@ -709,7 +652,6 @@ int bt_mesh_app_decrypt(const u8_t key[16], bool dev_key, u8_t aszmic,
 
 	create_app_nonce(nonce, dev_key, aszmic, src, dst, seq_num, iv_index);
 
-	BT_DBG("AppKey %s", bt_hex(key, 16));
 	BT_DBG("Nonce  %s", bt_hex(nonce, 13));
 
 	err = bt_mesh_ccm_decrypt(key, nonce, buf->om_data, buf->om_len, ad,
@@ -839,17 +781,21 @@ int bt_mesh_prov_conf(const u8_t conf_key[16], const u8_t rand[16],
 int bt_mesh_prov_decrypt(const u8_t key[16], u8_t nonce[13],
 			 const u8_t data[25 + 8], u8_t out[25])
 {
-	return bt_mesh_ccm_decrypt(key, nonce, data, 25, NULL, 0, out, 8);
+	struct ble_aes_key sched;
+
+	ble_aes_set_key(&sched, key);
+
+	return bt_mesh_ccm_decrypt(&sched, nonce, data, 25, NULL, 0, out, 8);
 }
 
-int bt_mesh_beacon_auth(const u8_t beacon_key[16], u8_t flags,
-			const u8_t net_id[8], u32_t iv_index,
+int bt_mesh_beacon_auth(const struct ble_aes_cmac_key *beacon_key,
+			u8_t flags, const u8_t net_id[8], u32_t iv_index,
 			u8_t auth[8])
 {
+	struct bt_mesh_sg sg;
 	u8_t msg[13], tmp[16];
 	int err;
 
-	BT_DBG("BeaconKey %s", bt_hex(beacon_key, 16));
 	BT_DBG("NetId %s", bt_hex(net_id, 8));
 	BT_DBG("IV Index 0x%08x", iv_index);
 
@@ -859,7 +805,10 @@ int bt_mesh_beacon_auth(const u8_t beacon_key[16], u8_t flags,
 
 	BT_DBG("BeaconMsg %s", bt_hex(msg, sizeof(msg)));
 
-	err = bt_mesh_aes_cmac_one(beacon_key, msg, sizeof(msg), tmp);
+	sg.data = msg;
+	sg.len = sizeof(msg);
+
+	err = bt_mesh_aes_cmac_key(beacon_key, &sg, 1, tmp);
 	if (!err) {
 		memcpy(auth, tmp, 8);
 	}
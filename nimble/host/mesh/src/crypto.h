@@ -9,6 +9,7 @@
 #define __CRYPTO_H__
 
 #include "mesh/mesh.h"
+#include "nimble/ble_aes.h"
 
 struct bt_mesh_sg {
 	const void *data;
@@ -18,6 +19,9 @@ struct bt_mesh_sg {
 int bt_mesh_aes_cmac(const u8_t key[16], struct bt_mesh_sg *sg,
 		     size_t sg_len, u8_t mac[16]);
 
+int bt_mesh_aes_cmac_key(const struct ble_aes_cmac_key *key,
+			 struct bt_mesh_sg *sg, size_t sg_len, u8_t mac[16]);
+
 static inline int bt_mesh_aes_cmac_one(const u8_t key[16], const void *m,
 				       size_t len, u8_t mac[16])
 {
@@ -69,8 +73,8 @@ static inline int bt_mesh_beacon_key(const u8_t net_key[16],
 	return bt_mesh_id128(net_key, "nkbk", beacon_key);
 }
 
-int bt_mesh_beacon_auth(const u8_t beacon_key[16], u8_t flags,
-			const u8_t net_id[16], u32_t iv_index,
+int bt_mesh_beacon_auth(const struct ble_aes_cmac_key *beacon_key,
+			u8_t flags, const u8_t net_id[8], u32_t iv_index,
 			u8_t auth[8]);
 
 static inline int bt_mesh_app_id(const u8_t app_key[16], u8_t app_id[1])
@@ -123,23 +127,24 @@ static inline int bt_mesh_prov_salt(const u8_t conf_salt[16],
 }
 
 int bt_mesh_net_obfuscate(u8_t *pdu, u32_t iv_index,
-			  const u8_t privacy_key[16]);
-
-int bt_mesh_net_encrypt(const u8_t key[16], struct os_mbuf *buf,
-			u32_t iv_index, bool proxy);
+			  const struct ble_aes_key *privacy);
 
-int bt_mesh_net_decrypt(const u8_t key[16], struct os_mbuf *buf,
-			u32_t iv_index, bool proxy);
+int bt_mesh_net_encrypt(const struct ble_aes_key *enc,
+			struct os_mbuf *buf, u32_t iv_index, bool proxy);
 
-int bt_mesh_app_encrypt(const u8_t key[16], bool dev_key, u8_t aszmic,
-			struct os_mbuf*buf, const u8_t *ad,
-			u16_t src, u16_t dst, u32_t seq_num, u32_t iv_index);
+int bt_mesh_net_decrypt(const struct ble_aes_key *enc,
+			struct os_mbuf *buf, u32_t iv_index, bool proxy);
 
-int bt_mesh_app_decrypt(const u8_t key[16], bool dev_key, u8_t aszmic,
-			struct os_mbuf*buf, struct os_mbuf*out,
+int bt_mesh_app_encrypt(const struct ble_aes_key *key,
+			bool dev_key, u8_t aszmic, struct os_mbuf *buf,
 			const u8_t *ad, u16_t src, u16_t dst, u32_t seq_num,
 			u32_t iv_index);
 
+int bt_mesh_app_decrypt(const struct ble_aes_key *key,
+			bool dev_key, u8_t aszmic, struct os_mbuf *buf,
+			struct os_mbuf *out, const u8_t *ad, u16_t src,
+			u16_t dst, u32_t seq_num, u32_t iv_index);
+
 u8_t bt_mesh_fcs_calc(const u8_t *data, u8_t data_len);
 
 bool bt_mesh_fcs_check(struct os_mbuf *buf, u8_t received_fcs);
@@ -123,11 +123,21 @@ int bt_mesh_health_cli_init(struct bt_mesh_model *model, bool primary);
 
 void bt_mesh_cfg_reset(void);
 
+struct bt_mesh_cfg_srv *bt_mesh_cfg_get(void);
+
 void bt_mesh_heartbeat(u16_t src, u16_t dst, u8_t hops, u16_t feat);
 
 void bt_mesh_attention(struct bt_mesh_model *model, u8_t time);
 
+/* Label UUID of a virtual address, shared by all its users */
+struct label {
+	u16_t ref;
+	u16_t addr;
+	u8_t  uuid[16];
+};
+
 u8_t *bt_mesh_label_uuid_get(u16_t addr);
+struct label *bt_mesh_label_get(u16_t idx);
 
 u8_t bt_mesh_net_transmit_get(void);
 u8_t bt_mesh_relay_get(void);
@@ -28,10 +28,14 @@
 #include "foundation.h"
 #include "friend.h"
 
+#define FRIEND_QUEUE_SHARED MYNEWT_VAL(BLE_MESH_FRIEND_QUEUE_SHARED)
+
 /* We reserve one extra buffer for each friendship, since we need to be able
  * to resend the last sent PDU, which sits separately outside of the queue.
  */
-#define FRIEND_BUF_COUNT ((MYNEWT_VAL(BLE_MESH_FRIEND_QUEUE_SIZE) + 1) * MYNEWT_VAL(BLE_MESH_FRIEND_LPN_COUNT))
+#define FRIEND_BUF_COUNT (((MYNEWT_VAL(BLE_MESH_FRIEND_QUEUE_SIZE) + 1) * \
+			   MYNEWT_VAL(BLE_MESH_FRIEND_LPN_COUNT)) + \
+			  FRIEND_QUEUE_SHARED)
 
 static os_membuf_t friend_buf_mem[OS_MEMPOOL_SIZE(
 		FRIEND_BUF_COUNT,
@@ -65,27 +69,78 @@ struct friend_pdu_info {
 static struct friend_adv {
 	struct bt_mesh_adv adv;
 	u64_t seq_auth;
+	u8_t stale:1; /* Superseded Segment Ack, not to be sent */
 } adv_pool[FRIEND_BUF_COUNT];
 
+/* Largest Friend Queue of any LPN */
+static u32_t queue_hw;
+
+/* Shared buffers in use by LPNs beyond their own Friend Queue size */
+static u16_t shared_used;
+
+/* Union of the Subscription Lists of all LPNs, so that group addresses no
+ * LPN is subscribed to are rejected without looking at each LPN.
+ */
+static u16_t lpn_group_addrs[MYNEWT_VAL(BLE_MESH_FRIEND_LPN_COUNT) *
+			     FRIEND_SUB_LIST_SIZE];
+static struct bt_mesh_addr_set lpn_groups;
+
 static struct bt_mesh_adv *adv_alloc(int id)
 {
 	return &adv_pool[id].adv;
 }
 
+static void ack_forget(struct bt_mesh_friend *frnd, struct os_mbuf *buf)
+{
+	int i;
+
+	if (FRIEND_ADV(buf)->seq_auth == TRANS_SEQ_AUTH_NVAL) {
+		return;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(frnd->ack); i++) {
+		if (frnd->ack[i] == buf) {
+			frnd->ack[i] = NULL;
+			return;
+		}
+	}
+}
+
+static struct os_mbuf *queue_get(struct bt_mesh_friend *frnd)
+{
+	struct os_mbuf *buf;
+
+	buf = net_buf_slist_get(&frnd->queue);
+	if (!buf) {
+		return NULL;
+	}
+
+	if (frnd->queue_size-- > CONFIG_BT_MESH_FRIEND_QUEUE_SIZE) {
+		shared_used--;
+	}
+
+	ack_forget(frnd, buf);
+
+	return buf;
+}
+
 static void discard_buffer(void)
 {
 	struct bt_mesh_friend *frnd = &bt_mesh.frnd[0];
 	struct os_mbuf *buf;
 	int i;
 
-	/* Find the Friend context with the most queued buffers */
+	/* Find the Friend context furthest beyond its own queue size. Since
+	 * every LPN has the same quota this is the one with the most queued
+	 * buffers.
+	 */
 	for (i = 1; i < ARRAY_SIZE(bt_mesh.frnd); i++) {
 		if (bt_mesh.frnd[i].queue_size > frnd->queue_size) {
 			frnd = &bt_mesh.frnd[i];
 		}
 	}
 
-	buf = net_buf_slist_get(&frnd->queue);
+	buf = queue_get(frnd);
 	__ASSERT_NO_MSG(buf != NULL);
 	BT_WARN("Discarding buffer %p for LPN 0x%04x", buf, frnd->lpn);
 	net_buf_unref(buf);
@@ -107,6 +162,7 @@ static struct os_mbuf *friend_buf_alloc(u16_t src)
 
 	BT_MESH_ADV(buf)->addr = src;
 	FRIEND_ADV(buf)->seq_auth = TRANS_SEQ_AUTH_NVAL;
+	FRIEND_ADV(buf)->stale = 0;
 
 	BT_DBG("allocated buf %p", buf);
 
@@ -157,8 +213,27 @@ static s32_t recv_delay(struct bt_mesh_friend *frnd)
 #endif
 }
 
+static void friend_sub_rem(struct bt_mesh_friend *frnd, u16_t addr)
+{
+	int i;
+
+	if (!bt_mesh_addr_set_del(&frnd->sub, addr)) {
+		return;
+	}
+
+	/* Keep the address in the union if another LPN still has it */
+	for (i = 0; i < ARRAY_SIZE(bt_mesh.frnd); i++) {
+		if (bt_mesh_addr_set_has(&bt_mesh.frnd[i].sub, addr)) {
+			return;
+		}
+	}
+
+	bt_mesh_addr_set_del(&lpn_groups, addr);
+}
+
 static void friend_clear(struct bt_mesh_friend *frnd)
 {
+	struct os_mbuf *buf;
 	int i;
 
 	BT_DBG("LPN 0x%04x", frnd->lpn);
@@ -177,8 +252,8 @@ static void friend_clear(struct bt_mesh_friend *frnd)
 		frnd->last = NULL;
 	}
 
-	while (!net_buf_slist_is_empty(&frnd->queue)) {
-		net_buf_unref(net_buf_slist_get(&frnd->queue));
+	while ((buf = queue_get(frnd))) {
+		net_buf_unref(buf);
 	}
 
 	for (i = 0; i < ARRAY_SIZE(frnd->seg); i++) {
@@ -195,7 +270,10 @@ static void friend_clear(struct bt_mesh_friend *frnd)
 	frnd->fsn = 0;
 	frnd->queue_size = 0;
 	frnd->pending_req = 0;
-	memset(frnd->sub_list, 0, sizeof(frnd->sub_list));
+
+	while (frnd->sub.count) {
+		friend_sub_rem(frnd, frnd->sub_list[0]);
+	}
 }
 
 void bt_mesh_friend_clear_net_idx(u16_t net_idx)
@@ -292,36 +370,28 @@ int bt_mesh_friend_clear(struct bt_mesh_net_rx *rx, struct os_mbuf *buf)
 
 static void friend_sub_add(struct bt_mesh_friend *frnd, u16_t addr)
 {
-	int i;
-
-	for (i = 0; i < ARRAY_SIZE(frnd->sub_list); i++) {
-		if (frnd->sub_list[i] == BT_MESH_ADDR_UNASSIGNED) {
-			frnd->sub_list[i] = addr;
-			return;
-		}
+	/* Only group and virtual addresses can be matched against the list */
+	if (addr == BT_MESH_ADDR_UNASSIGNED || BT_MESH_ADDR_IS_UNICAST(addr)) {
+		BT_WARN("Ignoring subscription to 0x%04x", addr);
+		return;
 	}
 
-	BT_WARN("No space in friend subscription list");
-}
-
-static void friend_sub_rem(struct bt_mesh_friend *frnd, u16_t addr)
-{
-	int i;
-
-	for (i = 0; i < ARRAY_SIZE(frnd->sub_list); i++) {
-		if (frnd->sub_list[i] == addr) {
-			frnd->sub_list[i] = BT_MESH_ADDR_UNASSIGNED;
-			return;
-		}
+	if (bt_mesh_addr_set_add(&frnd->sub, addr)) {
+		BT_WARN("No space in friend subscription list");
+		return;
 	}
+
+	/* Can't fail, the union is large enough for all lists */
+	bt_mesh_addr_set_add(&lpn_groups, addr);
 }
 
 static struct os_mbuf *create_friend_pdu(struct bt_mesh_friend *frnd,
 					 struct friend_pdu_info *info,
 					 struct os_mbuf *sdu)
 {
+	const struct ble_aes_key *enc, *priv;
+	const struct friend_cred_keys *cred;
 	struct bt_mesh_subnet *sub;
-	const u8_t *enc, *priv;
 	struct os_mbuf *buf;
 	u8_t nid;
 
@@ -332,14 +402,18 @@ static struct os_mbuf *create_friend_pdu(struct bt_mesh_friend *frnd,
 
 	/* Friend Offer needs master security credentials */
 	if (info->ctl && TRANS_CTL_OP(sdu->om_data) == TRANS_CTL_OP_FRIEND_OFFER) {
-		enc = sub->keys[sub->kr_flag].enc;
-		priv = sub->keys[sub->kr_flag].privacy;
+		enc = &sub->keys[sub->kr_flag].enc_sched;
+		priv = &sub->keys[sub->kr_flag].privacy_sched;
 		nid = sub->keys[sub->kr_flag].nid;
 	} else {
-		if (friend_cred_get(sub, frnd->lpn, &nid, &enc, &priv)) {
+		if (friend_cred_get(sub, frnd->lpn, &cred)) {
 			BT_ERR("friend_cred_get failed");
 			goto failed;
 		}
+
+		enc = &cred->enc_sched;
+		priv = &cred->privacy_sched;
+		nid = cred->nid;
 	}
 
 	net_buf_add_u8(buf, (nid | (info->iv_index & 1) << 7));
@@ -383,6 +457,7 @@ static struct os_mbuf *encode_friend_ctl(struct bt_mesh_friend *frnd,
 					 struct os_mbuf *sdu)
 {
 	struct friend_pdu_info info;
+	u32_t seq;
 
 	BT_DBG("LPN 0x%04x", frnd->lpn);
 
@@ -394,9 +469,10 @@ static struct os_mbuf *encode_friend_ctl(struct bt_mesh_friend *frnd,
 	info.ctl = 1;
 	info.ttl = 0;
 
-	info.seq[0] = (bt_mesh.seq >> 16);
-	info.seq[1] = (bt_mesh.seq >> 8);
-	info.seq[2] = bt_mesh.seq++;
+	seq = bt_mesh_next_seq();
+	info.seq[0] = seq >> 16;
+	info.seq[1] = seq >> 8;
+	info.seq[2] = seq;
 
 	info.iv_index = BT_MESH_NET_IVI_TX;
 
@@ -530,8 +606,43 @@ int bt_mesh_friend_sub_rem(struct bt_mesh_net_rx *rx,
 
 static void enqueue_buf(struct bt_mesh_friend *frnd, struct os_mbuf *buf)
 {
+	/* Once both the LPN's own queue and the shared region are full the
+	 * LPN only gets to replace its own oldest messages, so that it can't
+	 * starve the other LPNs.
+	 */
+	if (frnd->queue_size >= CONFIG_BT_MESH_FRIEND_QUEUE_SIZE &&
+	    shared_used >= FRIEND_QUEUE_SHARED) {
+		struct os_mbuf *old = queue_get(frnd);
+
+		BT_WARN("Friend Queue full, discarding buffer %p for LPN "
+			"0x%04x", old, frnd->lpn);
+		net_buf_unref(old);
+	}
+
 	net_buf_slist_put(&frnd->queue, buf);
-	frnd->queue_size++;
+
+	if (frnd->queue_size++ >= CONFIG_BT_MESH_FRIEND_QUEUE_SIZE) {
+		shared_used++;
+	}
+
+	BT_MESH_STATS_HW(frnd_queue_hw, queue_hw, frnd->queue_size);
+}
+
+static void ack_track(struct bt_mesh_friend *frnd, struct os_mbuf *buf)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(frnd->ack); i++) {
+		if (!frnd->ack[i]) {
+			frnd->ack[i] = buf;
+			return;
+		}
+	}
+
+	/* Not being able to supersede this ack later only means that the
+	 * LPN gets an outdated ack as well.
+	 */
+	BT_DBG("No free ack slot for LPN 0x%04x", frnd->lpn);
 }
 
 static void enqueue_update(struct bt_mesh_friend *frnd, u8_t md)
@@ -926,6 +1037,11 @@ static void enqueue_friend_pdu(struct bt_mesh_friend *frnd,
 		}
 
 		enqueue_buf(frnd, buf);
+
+		if (FRIEND_ADV(buf)->seq_auth != TRANS_SEQ_AUTH_NVAL) {
+			ack_track(frnd, buf);
+		}
+
 		return;
 	}
 
@@ -949,15 +1065,10 @@ static void enqueue_friend_pdu(struct bt_mesh_friend *frnd,
 		 * (otherwise we can't easily detect them there), so clear
 		 * the SeqAuth information from the segments before merging.
 		 */
-		struct os_mbuf *m;
-		struct os_mbuf_pkthdr *pkthdr;
-		NET_BUF_SLIST_FOR_EACH_NODE(&seg->queue, pkthdr) {
-			m = OS_MBUF_PKTHDR_TO_MBUF(pkthdr);
-			FRIEND_ADV(m)->seq_auth = TRANS_SEQ_AUTH_NVAL;
-			frnd->queue_size++;
+		while ((buf = net_buf_slist_get(&seg->queue))) {
+			FRIEND_ADV(buf)->seq_auth = TRANS_SEQ_AUTH_NVAL;
+			enqueue_buf(frnd, buf);
 		}
-
-		net_buf_slist_merge_slist(&frnd->queue, &seg->queue);
 	}
 }
 
@@ -1022,7 +1133,14 @@ static void friend_timeout(struct ble_npl_event *work)
 		return;
 	}
 
-	frnd->last = net_buf_slist_get(&frnd->queue);
+	/* Superseded acks are never followed by an empty queue, since
+	 * the ack replacing them is always queued after them.
+	 */
+	while ((frnd->last = queue_get(frnd)) &&
+	       FRIEND_ADV(frnd->last)->stale) {
+		net_buf_unref(frnd->last);
+	}
+
 	if (!frnd->last) {
 		BT_WARN("Friendship not established with 0x%04x", frnd->lpn);
 		friend_clear(frnd);
@@ -1031,7 +1149,6 @@ static void friend_timeout(struct ble_npl_event *work)
 
 	BT_DBG("Sending buf %p from Friend Queue of LPN 0x%04x",
 	       frnd->last, frnd->lpn);
-	frnd->queue_size--;
 
 send_last:
 	frnd->pending_req = 0;
@@ -1054,6 +1171,9 @@ int bt_mesh_friend_init(void)
 			FRIEND_BUF_COUNT);
 	assert(rc == 0);
 
+	bt_mesh_addr_set_init(&lpn_groups, lpn_group_addrs,
+			      ARRAY_SIZE(lpn_group_addrs));
+
 	for (i = 0; i < ARRAY_SIZE(bt_mesh.frnd); i++) {
 		struct bt_mesh_friend *frnd = &bt_mesh.frnd[i];
 		int j;
@@ -1061,6 +1181,8 @@ int bt_mesh_friend_init(void)
 		frnd->net_idx = BT_MESH_KEY_UNUSED;
 
 		net_buf_slist_init(&frnd->queue);
+		bt_mesh_addr_set_init(&frnd->sub, frnd->sub_list,
+				      ARRAY_SIZE(frnd->sub_list));
 
 		k_delayed_work_init(&frnd->timer, friend_timeout);
 		k_delayed_work_add_arg(&frnd->timer, frnd);
@@ -1075,25 +1197,25 @@ int bt_mesh_friend_init(void)
 	return 0;
 }
 
+/* Removing an ack from the middle of the queue would need a scan, so it's
+ * only marked as stale and gets dropped once it reaches the queue head.
+ */
 static void friend_purge_old_ack(struct bt_mesh_friend *frnd, u64_t *seq_auth,
 				 u16_t src)
 {
-	struct os_mbuf *cur, *prev = NULL;
+	int i;
 
 	BT_DBG("SeqAuth %llx src 0x%04x", *seq_auth, src);
 
-	for (cur = net_buf_slist_peek_head(&frnd->queue);
-	     cur != NULL; prev = cur, cur = net_buf_slist_peek_next(cur)) {
-		struct os_mbuf *buf = (void *)cur;
+	for (i = 0; i < ARRAY_SIZE(frnd->ack); i++) {
+		struct os_mbuf *buf = frnd->ack[i];
 
-		if (BT_MESH_ADV(buf)->addr == src &&
+		if (buf && BT_MESH_ADV(buf)->addr == src &&
 		    FRIEND_ADV(buf)->seq_auth == *seq_auth) {
 			BT_DBG("Removing old ack from Friend Queue");
 
-			net_buf_slist_remove(&frnd->queue, prev, cur);
-			frnd->queue_size--;
-
-			net_buf_unref(buf);
+			FRIEND_ADV(buf)->stale = 1;
+			frnd->ack[i] = NULL;
 			break;
 		}
 	}
@@ -1109,10 +1231,6 @@ static void friend_lpn_enqueue_rx(struct bt_mesh_friend *frnd,
 
 	BT_DBG("LPN 0x%04x queue_size %u", frnd->lpn, frnd->queue_size);
 
-	if (type == BT_MESH_FRIEND_PDU_SINGLE && seq_auth) {
-		friend_purge_old_ack(frnd, seq_auth, rx->ctx.addr);
-	}
-
 	info.src = rx->ctx.addr;
 	info.dst = rx->dst;
 
@@ -1136,6 +1254,13 @@ static void friend_lpn_enqueue_rx(struct bt_mesh_friend *frnd,
 		return;
 	}
 
+	/* Only purge once the new ack is about to be queued, so that the old
+	 * one is always followed by its replacement.
+	 */
+	if (type == BT_MESH_FRIEND_PDU_SINGLE && seq_auth) {
+		friend_purge_old_ack(frnd, seq_auth, info.src);
+	}
+
 	if (seq_auth) {
 		FRIEND_ADV(buf)->seq_auth = *seq_auth;
 	}
@@ -1153,22 +1278,20 @@ static void friend_lpn_enqueue_tx(struct bt_mesh_friend *frnd,
 {
 	struct friend_pdu_info info;
 	struct os_mbuf *buf;
+	u32_t seq;
 
 	BT_DBG("LPN 0x%04x", frnd->lpn);
 
-	if (type == BT_MESH_FRIEND_PDU_SINGLE && seq_auth) {
-		friend_purge_old_ack(frnd, seq_auth, tx->src);
-	}
-
 	info.src = tx->src;
 	info.dst = tx->ctx->addr;
 
 	info.ttl = tx->ctx->send_ttl;
 	info.ctl = (tx->ctx->app_idx == BT_MESH_KEY_UNUSED);
 
-	info.seq[0] = (bt_mesh.seq >> 16);
-	info.seq[1] = (bt_mesh.seq >> 8);
-	info.seq[2] = bt_mesh.seq++;
+	seq = bt_mesh_next_seq();
+	info.seq[0] = seq >> 16;
+	info.seq[1] = seq >> 8;
+	info.seq[2] = seq;
 
 	info.iv_index = BT_MESH_NET_IVI_TX;
 
@@ -1178,6 +1301,10 @@ static void friend_lpn_enqueue_tx(struct bt_mesh_friend *frnd,
 		return;
 	}
 
+	if (type == BT_MESH_FRIEND_PDU_SINGLE && seq_auth) {
+		friend_purge_old_ack(frnd, seq_auth, info.src);
+	}
+
 	if (seq_auth) {
 		FRIEND_ADV(buf)->seq_auth = *seq_auth;
 	}
@@ -1190,8 +1317,6 @@ static void friend_lpn_enqueue_tx(struct bt_mesh_friend *frnd,
 static bool friend_lpn_matches(struct bt_mesh_friend *frnd, u16_t net_idx,
 			       u16_t addr)
 {
-	int i;
-
 	if (!frnd->established) {
 		return false;
 	}
@@ -1208,19 +1333,19 @@ static bool friend_lpn_matches(struct bt_mesh_friend *frnd, u16_t net_idx,
 		return false;
 	}
 
-	for (i = 0; i < ARRAY_SIZE(frnd->sub_list); i++) {
-		if (frnd->sub_list[i] == addr) {
-			return true;
-		}
-	}
-
-	return false;
+	return bt_mesh_addr_set_has(&frnd->sub, addr);
 }
 
 bool bt_mesh_friend_match(u16_t net_idx, u16_t addr)
 {
 	int i;
 
+	if (!BT_MESH_ADDR_IS_UNICAST(addr) &&
+	    !bt_mesh_addr_set_has(&lpn_groups, addr)) {
+		BT_DBG("No LPN subscribed to address 0x%04x", addr);
+		return false;
+	}
+
 	for (i = 0; i < ARRAY_SIZE(bt_mesh.frnd); i++) {
 		struct bt_mesh_friend *frnd = &bt_mesh.frnd[i];
 
@@ -18,6 +18,7 @@
  */
 
 #include "mesh/glue.h"
+#include "nimble/ble_aes.h"
 #include "adv.h"
 #ifndef MYNEWT
 #include "nimble/nimble_port.h"
@@ -124,16 +125,7 @@ free:
 int
 bt_encrypt_be(const uint8_t *key, const uint8_t *plaintext, uint8_t *enc_data)
 {
-    struct tc_aes_key_sched_struct s;
-
-    if (tc_aes128_set_encrypt_key(&s, key) == TC_CRYPTO_FAIL) {
-        return BLE_HS_EUNKNOWN;
-    }
-
-    if (tc_aes_encrypt(enc_data, plaintext, &s) == TC_CRYPTO_FAIL) {
-        return BLE_HS_EUNKNOWN;
-    }
-
+    ble_aes_encrypt_block(key, plaintext, enc_data);
     return 0;
 }
 
@@ -16,6 +16,7 @@
 #define BT_DBG_ENABLED (MYNEWT_VAL(BLE_MESH_DEBUG))
 #include "host/ble_hs_log.h"
 
+#include "crypto.h"
 #include "adv.h"
 #include "prov.h"
 #include "net.h"
@@ -28,10 +29,53 @@
 #include "proxy.h"
 #include "shell.h"
 #include "mesh_priv.h"
+#include "settings.h"
 
 u8_t g_mesh_addr_type;
 static bool provisioned;
 
+STATS_SECT_DECL(ble_mesh_stats) ble_mesh_stats;
+STATS_NAME_START(ble_mesh_stats)
+	STATS_NAME(ble_mesh_stats, net_rx)
+	STATS_NAME(ble_mesh_stats, net_tx)
+	STATS_NAME(ble_mesh_stats, net_cache_hit)
+	STATS_NAME(ble_mesh_stats, relay)
+	STATS_NAME(ble_mesh_stats, relay_fast)
+	STATS_NAME(ble_mesh_stats, relay_no_buf)
+	STATS_NAME(ble_mesh_stats, replay)
+	STATS_NAME(ble_mesh_stats, seg_retransmit)
+	STATS_NAME(ble_mesh_stats, seg_tx_fail)
+	STATS_NAME(ble_mesh_stats, rpl_hw)
+	STATS_NAME(ble_mesh_stats, seg_tx_hw)
+	STATS_NAME(ble_mesh_stats, seg_rx_hw)
+	STATS_NAME(ble_mesh_stats, frnd_queue_hw)
+STATS_NAME_END(ble_mesh_stats)
+
+static void mesh_start(void)
+{
+	if (bt_mesh_beacon_get() == BT_MESH_BEACON_ENABLED) {
+		bt_mesh_beacon_enable();
+	} else {
+		bt_mesh_beacon_disable();
+	}
+
+	if (MYNEWT_VAL(BLE_MESH_GATT_PROXY) &&
+	    bt_mesh_gatt_proxy_get() != BT_MESH_GATT_PROXY_NOT_SUPPORTED) {
+		bt_mesh_proxy_gatt_enable();
+		bt_mesh_adv_update();
+	}
+
+	if ((MYNEWT_VAL(BLE_MESH_LOW_POWER))) {
+		bt_mesh_lpn_init();
+	} else {
+		bt_mesh_scan_enable();
+	}
+
+	if ((MYNEWT_VAL(BLE_MESH_FRIEND))) {
+		bt_mesh_friend_init();
+	}
+}
+
 int bt_mesh_provision(const u8_t net_key[16], u16_t net_idx,
 		      u8_t flags, u32_t iv_index, u32_t seq,
 		      u16_t addr, const u8_t dev_key[16])
@@ -60,30 +104,15 @@ int bt_mesh_provision(const u8_t net_key[16], u16_t net_idx,
 	bt_mesh_comp_provision(addr);
 
 	memcpy(bt_mesh.dev_key, dev_key, 16);
+	ble_aes_set_key(&bt_mesh.dev_key_sched, dev_key);
 
 	provisioned = true;
 
-	if (bt_mesh_beacon_get() == BT_MESH_BEACON_ENABLED) {
-		bt_mesh_beacon_enable();
-	} else {
-		bt_mesh_beacon_disable();
-	}
-
-	if (MYNEWT_VAL(BLE_MESH_GATT_PROXY) &&
-	    bt_mesh_gatt_proxy_get() != BT_MESH_GATT_PROXY_NOT_SUPPORTED) {
-		bt_mesh_proxy_gatt_enable();
-		bt_mesh_adv_update();
-	}
-
-	if ((MYNEWT_VAL(BLE_MESH_LOW_POWER))) {
-		bt_mesh_lpn_init();
-	} else {
-		bt_mesh_scan_enable();
-	}
+	bt_mesh_store_net();
+	bt_mesh_store_subnet(&bt_mesh.sub[0]);
+	bt_mesh_store_iv();
 
-	if ((MYNEWT_VAL(BLE_MESH_FRIEND))) {
-		bt_mesh_friend_init();
-	}
+	mesh_start();
 
 	if (MYNEWT_VAL(BLE_MESH_PROV)) {
 		bt_mesh_prov_complete(net_idx, addr);
@@ -92,6 +121,21 @@ int bt_mesh_provision(const u8_t net_key[16], u16_t net_idx,
 	return 0;
 }
 
+void bt_mesh_restore(u16_t addr)
+{
+	BT_INFO("Primary Element: 0x%04x", addr);
+
+	if ((MYNEWT_VAL(BLE_MESH_PB_GATT))) {
+		bt_mesh_proxy_prov_disable();
+	}
+
+	bt_mesh_comp_provision(addr);
+
+	provisioned = true;
+
+	mesh_start();
+}
+
 void bt_mesh_reset(void)
 {
 	if (!provisioned) {
@@ -132,6 +176,7 @@ void bt_mesh_reset(void)
 	}
 
 	memset(bt_mesh.dev_key, 0, sizeof(bt_mesh.dev_key));
+	memset(&bt_mesh.dev_key_sched, 0, sizeof(bt_mesh.dev_key_sched));
 
 	memset(bt_mesh.rpl, 0, sizeof(bt_mesh.rpl));
 
@@ -140,6 +185,8 @@ void bt_mesh_reset(void)
 	bt_mesh_scan_disable();
 	bt_mesh_beacon_disable();
 
+	bt_mesh_clear_all();
+
 	if (IS_ENABLED(CONFIG_BT_MESH_PROV)) {
 		bt_mesh_prov_reset();
 	}
@@ -239,7 +286,17 @@ int bt_mesh_init(uint8_t own_addr_type, const struct bt_mesh_prov *prov,
 	bt_mesh_net_init();
 	bt_mesh_trans_init();
 	bt_mesh_beacon_init();
+	err = stats_init_and_reg(STATS_HDR(ble_mesh_stats),
+				 STATS_SIZE_INIT_PARMS(ble_mesh_stats,
+						       STATS_SIZE_32),
+				 STATS_NAME_INIT_PARMS(ble_mesh_stats),
+				 "ble_mesh");
+	if (err) {
+		return err;
+	}
+
 	bt_mesh_adv_init();
+	bt_mesh_settings_init();
 
 #if (MYNEWT_VAL(BLE_MESH_PB_ADV))
 	/* Make sure we're scanning for provisioning inviations */
@@ -8,6 +8,8 @@
 #ifndef __MESH_PRIV_H
 #define __MESH_PRIV_H
 
+#include "stats/stats.h"
+
 #define BT_MESH_KEY_PRIMARY 0x0000
 #define BT_MESH_KEY_ANY     0xffff
 
@@ -34,4 +36,35 @@
 
 bool bt_mesh_is_provisioned(void);
 
+/* Resumes operation of a node restored from persistent storage */
+void bt_mesh_restore(u16_t addr);
+
+STATS_SECT_START(ble_mesh_stats)
+	STATS_SECT_ENTRY(net_rx)
+	STATS_SECT_ENTRY(net_tx)
+	STATS_SECT_ENTRY(net_cache_hit)
+	STATS_SECT_ENTRY(relay)
+	STATS_SECT_ENTRY(relay_fast)
+	STATS_SECT_ENTRY(relay_no_buf)
+	STATS_SECT_ENTRY(replay)
+	STATS_SECT_ENTRY(seg_retransmit)
+	STATS_SECT_ENTRY(seg_tx_fail)
+	STATS_SECT_ENTRY(rpl_hw)
+	STATS_SECT_ENTRY(seg_tx_hw)
+	STATS_SECT_ENTRY(seg_rx_hw)
+	STATS_SECT_ENTRY(frnd_queue_hw)
+STATS_SECT_END
+extern STATS_SECT_DECL(ble_mesh_stats) ble_mesh_stats;
+
+/* Raises a high-water mark. The current mark is kept in hw, as stats can't
+ * be read back, and the statistic is advanced by the difference.
+ */
+#define BT_MESH_STATS_HW(var, hw, val)					\
+	do {								\
+		if ((val) > (hw)) {					\
+			STATS_INCN(ble_mesh_stats, var, (val) - (hw));	\
+			(hw) = (val);					\
+		}							\
+	} while (0)
+
 #endif
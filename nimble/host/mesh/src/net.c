@@ -28,6 +28,7 @@
 #include "access.h"
 #include "foundation.h"
 #include "beacon.h"
+#include "settings.h"
 
 /* Minimum valid Mesh Network PDU length. The Network headers
  * themselves take up 9 bytes. After that there is a minumum of 1 byte
@@ -101,6 +102,7 @@ static bool check_dup(struct os_mbuf *data)
 
 	for (i = 0; i < ARRAY_SIZE(dup_cache); i++) {
 		if (dup_cache[i] == val) {
+			STATS_INC(ble_mesh_stats, net_cache_hit);
 			return true;
 		}
 	}
@@ -132,6 +134,7 @@ static bool msg_cache_match(struct bt_mesh_net_rx *rx,
 
 	for (i = 0; i < ARRAY_SIZE(msg_cache); i++) {
 		if (msg_cache[i] == hash) {
+			STATS_INC(ble_mesh_stats, net_cache_hit);
 			return true;
 		}
 	}
@@ -180,6 +183,9 @@ int bt_mesh_net_keys_create(struct bt_mesh_subnet_keys *keys,
 	BT_DBG("NID 0x%02x EncKey %s", keys->nid, bt_hex(keys->enc, 16));
 	BT_DBG("PrivacyKey %s", bt_hex(keys->privacy, 16));
 
+	ble_aes_set_key(&keys->enc_sched, keys->enc);
+	ble_aes_set_key(&keys->privacy_sched, keys->privacy);
+
 	err = bt_mesh_k3(key, keys->net_id);
 	if (err) {
 		BT_ERR("Unable to generate Net ID");
@@ -206,6 +212,8 @@ int bt_mesh_net_keys_create(struct bt_mesh_subnet_keys *keys,
 
 	BT_DBG("BeaconKey %s", bt_hex(keys->beacon, 16));
 
+	ble_aes_cmac_set_key(&keys->beacon_key, keys->beacon);
+
 	return 0;
 }
 
@@ -251,6 +259,10 @@ int friend_cred_set(struct friend_cred *cred, u8_t idx, const u8_t net_key[16])
 	       bt_hex(cred->cred[idx].enc, 16));
 	BT_DBG("Friend PrivacyKey %s", bt_hex(cred->cred[idx].privacy, 16));
 
+	ble_aes_set_key(&cred->cred[idx].enc_sched, cred->cred[idx].enc);
+	ble_aes_set_key(&cred->cred[idx].privacy_sched,
+			cred->cred[idx].privacy);
+
 	return 0;
 }
 
@@ -361,8 +373,8 @@ int friend_cred_del(u16_t net_idx, u16_t addr)
 	return -ENOENT;
 }
 
-int friend_cred_get(struct bt_mesh_subnet *sub, u16_t addr, u8_t *nid,
-		    const u8_t **enc, const u8_t **priv)
+int friend_cred_get(struct bt_mesh_subnet *sub, u16_t addr,
+		    const struct friend_cred_keys **keys)
 {
 	int i;
 
@@ -379,17 +391,7 @@ int friend_cred_get(struct bt_mesh_subnet *sub, u16_t addr, u8_t *nid,
 			continue;
 		}
 
-		if (nid) {
-			*nid = cred->cred[sub->kr_flag].nid;
-		}
-
-		if (enc) {
-			*enc = cred->cred[sub->kr_flag].enc;
-		}
-
-		if (priv) {
-			*priv = cred->cred[sub->kr_flag].privacy;
-		}
+		*keys = &cred->cred[sub->kr_flag];
 
 		return 0;
 	}
@@ -397,8 +399,8 @@ int friend_cred_get(struct bt_mesh_subnet *sub, u16_t addr, u8_t *nid,
 	return -ENOENT;
 }
 #else
-int friend_cred_get(struct bt_mesh_subnet *sub, u16_t addr, u8_t *nid,
-		    const u8_t **enc, const u8_t **priv)
+int friend_cred_get(struct bt_mesh_subnet *sub, u16_t addr,
+		    const struct friend_cred_keys **keys)
 {
 	return -ENOENT;
 }
@@ -434,7 +436,7 @@ int bt_mesh_net_beacon_update(struct bt_mesh_subnet *sub)
 
 	BT_DBG("flags 0x%02x, IVI 0x%08x", flags, bt_mesh.iv_index);
 
-	return bt_mesh_beacon_auth(keys->beacon, flags, keys->net_id,
+	return bt_mesh_beacon_auth(&keys->beacon_key, flags, keys->net_id,
 				   bt_mesh.iv_index, sub->auth);
 }
 
@@ -493,6 +495,32 @@ int bt_mesh_net_create(u16_t idx, u8_t flags, const u8_t key[16],
 	return 0;
 }
 
+void bt_mesh_net_restore(void)
+{
+	int i;
+
+	memset(msg_cache, 0, sizeof(msg_cache));
+	msg_cache_next = 0;
+
+	bt_mesh.valid = 1;
+
+	/* The time spent in the current IV Update state before the reboot
+	 * is unknown; start counting over.
+	 */
+	bt_mesh.last_update = k_uptime_get();
+
+	if (bt_mesh.iv_update) {
+		k_delayed_work_submit(&bt_mesh.ivu_complete,
+				      IV_UPDATE_TIMEOUT);
+	}
+
+	for (i = 0; i < ARRAY_SIZE(bt_mesh.sub); i++) {
+		if (bt_mesh.sub[i].net_idx != BT_MESH_KEY_UNUSED) {
+			bt_mesh_net_beacon_update(&bt_mesh.sub[i]);
+		}
+	}
+}
+
 void bt_mesh_net_revoke_keys(struct bt_mesh_subnet *sub)
 {
 	int i;
@@ -510,7 +538,10 @@ void bt_mesh_net_revoke_keys(struct bt_mesh_subnet *sub)
 
 		memcpy(&key->keys[0], &key->keys[1], sizeof(key->keys[0]));
 		key->updated = false;
+		bt_mesh_store_app_key(key);
 	}
+
+	bt_mesh_store_subnet(sub);
 }
 
 bool bt_mesh_kr_update(struct bt_mesh_subnet *sub, u8_t new_kr, bool new_key)
@@ -526,6 +557,7 @@ bool bt_mesh_kr_update(struct bt_mesh_subnet *sub, u8_t new_kr, bool new_key)
 		if (sub->kr_phase == BT_MESH_KR_PHASE_1) {
 			BT_DBG("Phase 1 -> Phase 2");
 			sub->kr_phase = BT_MESH_KR_PHASE_2;
+			bt_mesh_store_subnet(sub);
 			return true;
 		}
 	} else {
@@ -575,6 +607,8 @@ void bt_mesh_rpl_reset(void)
 			}
 		}
 	}
+
+	bt_mesh_store_rpl_all();
 }
 
 #if MYNEWT_VAL(BLE_MESH_IV_UPDATE_TEST)
@@ -651,6 +685,7 @@ bool bt_mesh_net_iv_update(u32_t iv_index, bool iv_update)
 		if (iv_index > bt_mesh.iv_index + 1) {
 			BT_WARN("Performing IV Index Recovery");
 			memset(bt_mesh.rpl, 0, sizeof(bt_mesh.rpl));
+			bt_mesh_store_rpl_all();
 			bt_mesh.iv_index = iv_index;
 			bt_mesh.seq = 0;
 			goto do_update;
@@ -717,21 +752,33 @@ do_update:
 		}
 	}
 
+	bt_mesh_store_iv();
+
 	return true;
 }
 
+u32_t bt_mesh_next_seq(void)
+{
+	u32_t seq = bt_mesh.seq++;
+
+	bt_mesh_store_seq();
+
+	return seq;
+}
+
 int bt_mesh_net_resend(struct bt_mesh_subnet *sub, struct os_mbuf *buf,
 		       bool new_key, const struct bt_mesh_send_cb *cb,
 		       void *cb_data)
 {
-	const u8_t *enc, *priv;
+	const struct ble_aes_key *enc, *priv;
+	u32_t seq;
 	int err;
 
 	BT_DBG("net_idx 0x%04x new_key %u len %u", sub->net_idx, new_key,
 	       buf->om_len);
 
-	enc = sub->keys[new_key].enc;
-	priv = sub->keys[new_key].privacy;
+	enc = &sub->keys[new_key].enc_sched;
+	priv = &sub->keys[new_key].privacy_sched;
 
 	err = bt_mesh_net_obfuscate(buf->om_data, BT_MESH_NET_IVI_TX, priv);
 	if (err) {
@@ -746,9 +793,10 @@ int bt_mesh_net_resend(struct bt_mesh_subnet *sub, struct os_mbuf *buf,
 	}
 
 	/* Update with a new sequence number */
-	buf->om_data[2] = (bt_mesh.seq >> 16);
-	buf->om_data[3] = (bt_mesh.seq >> 8);
-	buf->om_data[4] = bt_mesh.seq++;
+	seq = bt_mesh_next_seq();
+	buf->om_data[2] = seq >> 16;
+	buf->om_data[3] = seq >> 8;
+	buf->om_data[4] = seq;
 
 	err = bt_mesh_net_encrypt(enc, buf, BT_MESH_NET_IVI_TX, false);
 	if (err) {
@@ -788,8 +836,10 @@ int bt_mesh_net_encode(struct bt_mesh_net_tx *tx, struct os_mbuf *buf,
 		       bool proxy)
 {
 	const bool ctl = (tx->ctx->app_idx == BT_MESH_KEY_UNUSED);
+	const struct ble_aes_key *enc, *priv;
+	const struct friend_cred_keys *cred;
+	u32_t seq_num;
 	u8_t nid;
-	const u8_t *enc, *priv;
 	u8_t *seq;
 	int err;
 
@@ -807,10 +857,11 @@ int bt_mesh_net_encode(struct bt_mesh_net_tx *tx, struct os_mbuf *buf,
 	net_buf_simple_push_be16(buf, tx->ctx->addr);
 	net_buf_simple_push_be16(buf, tx->src);
 
+	seq_num = bt_mesh_next_seq();
 	seq = net_buf_simple_push(buf, 3);
-	seq[0] = (bt_mesh.seq >> 16);
-	seq[1] = (bt_mesh.seq >> 8);
-	seq[2] = bt_mesh.seq++;
+	seq[0] = seq_num >> 16;
+	seq[1] = seq_num >> 8;
+	seq[2] = seq_num;
 
 	if (ctl) {
 		net_buf_simple_push_u8(buf, tx->ctx->send_ttl | 0x80);
@@ -819,21 +870,24 @@ int bt_mesh_net_encode(struct bt_mesh_net_tx *tx, struct os_mbuf *buf,
 	}
 
 	if (IS_ENABLED(CONFIG_BT_MESH_LOW_POWER) && tx->friend_cred) {
-		if (friend_cred_get(tx->sub, BT_MESH_ADDR_UNASSIGNED,
-				    &nid, &enc, &priv)) {
+		if (friend_cred_get(tx->sub, BT_MESH_ADDR_UNASSIGNED, &cred)) {
 			BT_WARN("Falling back to master credentials");
 
 			tx->friend_cred = 0;
 
 			nid = tx->sub->keys[tx->sub->kr_flag].nid;
-			enc = tx->sub->keys[tx->sub->kr_flag].enc;
-			priv = tx->sub->keys[tx->sub->kr_flag].privacy;
+			enc = &tx->sub->keys[tx->sub->kr_flag].enc_sched;
+			priv = &tx->sub->keys[tx->sub->kr_flag].privacy_sched;
+		} else {
+			nid = cred->nid;
+			enc = &cred->enc_sched;
+			priv = &cred->privacy_sched;
 		}
 	} else {
 		tx->friend_cred = 0;
 		nid = tx->sub->keys[tx->sub->kr_flag].nid;
-		enc = tx->sub->keys[tx->sub->kr_flag].enc;
-		priv = tx->sub->keys[tx->sub->kr_flag].privacy;
+		enc = &tx->sub->keys[tx->sub->kr_flag].enc_sched;
+		priv = &tx->sub->keys[tx->sub->kr_flag].privacy_sched;
 	}
 
 	net_buf_simple_push_u8(buf, (nid | (BT_MESH_NET_IVI_TX & 1) << 7));
@@ -869,6 +923,8 @@ int bt_mesh_net_send(struct bt_mesh_net_tx *tx, struct os_mbuf *buf,
 	BT_DBG("encoded %u bytes: %s", buf->om_len,
 		   bt_hex(buf->om_data, buf->om_len));
 
+	STATS_INC(ble_mesh_stats, net_tx);
+
 	/* Deliver to GATT Proxy Clients if necessary. Mesh spec 3.4.5.2:
 	 * "The output filter of the interface connected to advertising or
 	 * GATT bearers shall drop all messages with TTL value set to 1."
@@ -930,7 +986,7 @@ static bool auth_match(struct bt_mesh_subnet_keys *keys,
 		return false;
 	}
 
-	bt_mesh_beacon_auth(keys->beacon, flags, keys->net_id, iv_index,
+	bt_mesh_beacon_auth(&keys->beacon_key, flags, keys->net_id, iv_index,
 			    net_auth);
 
 	if (memcmp(auth, net_auth, 8)) {
@@ -973,10 +1029,11 @@ struct bt_mesh_subnet *bt_mesh_subnet_find(const u8_t net_id[8], u8_t flags,
 	return NULL;
 }
 
-static int net_decrypt(struct bt_mesh_subnet *sub, const u8_t *enc,
-		       const u8_t *priv, const u8_t *data,
-		       size_t data_len, struct bt_mesh_net_rx *rx,
-		       struct os_mbuf *buf)
+static int net_decrypt(struct bt_mesh_subnet *sub,
+		       const struct ble_aes_key *enc,
+		       const struct ble_aes_key *priv,
+		       const u8_t *data, size_t data_len,
+		       struct bt_mesh_net_rx *rx, struct os_mbuf *buf)
 {
 	BT_DBG("NID 0x%02x net_idx 0x%04x", NID(data), sub->net_idx);
 	BT_DBG("IVI %u net->iv_index 0x%08x", IVI(data), bt_mesh.iv_index);
@@ -1030,7 +1087,8 @@ static int friend_decrypt(struct bt_mesh_subnet *sub, const u8_t *data,
 		}
 
 		if (NID(data) == cred->cred[0].nid &&
-		    !net_decrypt(sub, cred->cred[0].enc, cred->cred[0].privacy,
+		    !net_decrypt(sub, &cred->cred[0].enc_sched,
+				 &cred->cred[0].privacy_sched,
 				 data, data_len, rx, buf)) {
 			return 0;
 		}
@@ -1040,7 +1098,8 @@ static int friend_decrypt(struct bt_mesh_subnet *sub, const u8_t *data,
 		}
 
 		if (NID(data) == cred->cred[1].nid &&
-		    !net_decrypt(sub, cred->cred[1].enc, cred->cred[1].privacy,
+		    !net_decrypt(sub, &cred->cred[1].enc_sched,
+				 &cred->cred[1].privacy_sched,
 				 data, data_len, rx, buf)) {
 			rx->new_key = 1;
 			return 0;
@@ -1077,7 +1136,8 @@ static bool net_find_and_decrypt(const u8_t *data, size_t data_len,
 #endif
 
 		if (NID(data) == sub->keys[0].nid &&
-		    !net_decrypt(sub, sub->keys[0].enc, sub->keys[0].privacy,
+		    !net_decrypt(sub, &sub->keys[0].enc_sched,
+				 &sub->keys[0].privacy_sched,
 				 data, data_len, rx, buf)) {
 			rx->ctx.net_idx = sub->net_idx;
 			rx->sub = sub;
@@ -1089,7 +1149,8 @@ static bool net_find_and_decrypt(const u8_t *data, size_t data_len,
 		}
 
 		if (NID(data) == sub->keys[1].nid &&
-		    !net_decrypt(sub, sub->keys[1].enc, sub->keys[1].privacy,
+		    !net_decrypt(sub, &sub->keys[1].enc_sched,
+				 &sub->keys[1].privacy_sched,
 				 data, data_len, rx, buf)) {
 			rx->new_key = 1;
 			rx->ctx.net_idx = sub->net_idx;
@@ -1120,12 +1181,69 @@ static bool relay_to_adv(enum bt_mesh_net_if net_if)
 	}
 }
 
-static void bt_mesh_net_relay(struct os_mbuf *sbuf,
+/* Locally originated packets keep their TTL, so unless they need to be
+ * relayed with different credentials the received PDU is already what we
+ * would send.
+ */
+static bool relay_verbatim(struct bt_mesh_net_rx *rx)
+{
+	return (rx->net_if == BT_MESH_NET_IF_LOCAL && !rx->friend_cred &&
+		rx->new_key == rx->sub->kr_flag);
+}
+
+static int relay_encode(struct os_mbuf *sbuf, struct bt_mesh_net_rx *rx,
+			struct os_mbuf *buf)
+{
+	const struct ble_aes_key *enc, *priv;
+	u8_t nid;
+
+	/* Only decrement TTL for non-locally originated packets */
+	if (rx->net_if != BT_MESH_NET_IF_LOCAL) {
+		/* Leave CTL bit intact */
+		sbuf->om_data[1] &= 0x80;
+		sbuf->om_data[1] |= rx->ctx.recv_ttl - 1;
+	}
+
+	net_buf_add_mem(buf, sbuf->om_data, sbuf->om_len);
+
+	enc = &rx->sub->keys[rx->sub->kr_flag].enc_sched;
+	priv = &rx->sub->keys[rx->sub->kr_flag].privacy_sched;
+	nid = rx->sub->keys[rx->sub->kr_flag].nid;
+
+	BT_DBG("Relaying packet. TTL is now %u", TTL(buf->om_data));
+
+	/* Update NID if RX or RX was with friend credentials */
+	if (rx->friend_cred) {
+		buf->om_data[0] &= 0x80; /* Clear everything except IVI */
+		buf->om_data[0] |= nid;
+	}
+
+	/* The TTL is part of the network nonce, so a packet with a
+	 * decremented TTL always has to be encrypted again.
+	 *
+	 * We re-encrypt and obfuscate using the received IVI rather than
+	 * the normal TX IVI (which may be different) since the transport
+	 * layer nonce includes the IVI.
+	 */
+	if (bt_mesh_net_encrypt(enc, buf, BT_MESH_NET_IVI_RX(rx), false)) {
+		BT_ERR("Re-encrypting failed");
+		return -EINVAL;
+	}
+
+	if (bt_mesh_net_obfuscate(buf->om_data, BT_MESH_NET_IVI_RX(rx), priv)) {
+		BT_ERR("Re-obfuscating failed");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static void bt_mesh_net_relay(struct os_mbuf *sbuf, struct os_mbuf *data,
 			      struct bt_mesh_net_rx *rx)
 {
-	const u8_t *enc, *priv;
 	struct os_mbuf *buf;
-	u8_t nid, transmit;
+	bool to_adv, to_proxy;
+	u8_t transmit;
 
 	if (rx->net_if == BT_MESH_NET_IF_LOCAL) {
 		/* Locally originated PDUs with TTL=1 will only be delivered
@@ -1143,9 +1261,17 @@ static void bt_mesh_net_relay(struct os_mbuf *sbuf,
 		}
 	}
 
-	if (rx->net_if == BT_MESH_NET_IF_ADV &&
-	    bt_mesh_relay_get() != BT_MESH_RELAY_ENABLED &&
-	    bt_mesh_gatt_proxy_get() != BT_MESH_GATT_PROXY_ENABLED) {
+	/* Sending to the GATT bearer should only happen if GATT Proxy
+	 * is enabled or the message originates from the local node.
+	 */
+	to_proxy = (IS_ENABLED(CONFIG_BT_MESH_GATT_PROXY) &&
+		    (bt_mesh_gatt_proxy_get() == BT_MESH_GATT_PROXY_ENABLED ||
+		     rx->net_if == BT_MESH_NET_IF_LOCAL) &&
+		    bt_mesh_proxy_filter_match(rx->dst));
+	to_adv = relay_to_adv(rx->net_if);
+
+	/* Don't bother encoding the packet if no bearer is going to take it */
+	if (!to_proxy && !to_adv) {
 		return;
 	}
 
@@ -1161,71 +1287,77 @@ static void bt_mesh_net_relay(struct os_mbuf *sbuf,
 		transmit = bt_mesh_net_transmit_get();
 	}
 
-	buf = bt_mesh_adv_create(BT_MESH_ADV_DATA,
-				 BT_MESH_TRANSMIT_COUNT(transmit),
-				 BT_MESH_TRANSMIT_INT(transmit), K_NO_WAIT);
+	buf = bt_mesh_adv_relay_create(BT_MESH_TRANSMIT_COUNT(transmit),
+				       BT_MESH_TRANSMIT_INT(transmit));
 	if (!buf) {
 		BT_ERR("Out of relay buffers");
+		STATS_INC(ble_mesh_stats, relay_no_buf);
 		return;
 	}
 
-	/* Only decrement TTL for non-locally originated packets */
-	if (rx->net_if != BT_MESH_NET_IF_LOCAL) {
-		/* Leave CTL bit intact */
-		sbuf->om_data[1] &= 0x80;
-		sbuf->om_data[1] |= rx->ctx.recv_ttl - 1;
+	if (relay_verbatim(rx)) {
+		net_buf_add_mem(buf, data->om_data, data->om_len);
+		STATS_INC(ble_mesh_stats, relay_fast);
+	} else if (relay_encode(sbuf, rx, buf)) {
+		goto done;
 	}
 
-	net_buf_add_mem(buf, sbuf->om_data, sbuf->om_len);
-
-	enc = rx->sub->keys[rx->sub->kr_flag].enc;
-	priv = rx->sub->keys[rx->sub->kr_flag].privacy;
-	nid = rx->sub->keys[rx->sub->kr_flag].nid;
-
-	BT_DBG("Relaying packet. TTL is now %u", TTL(buf->om_data));
+	BT_DBG("encoded %u bytes: %s", buf->om_len,
+	       bt_hex(buf->om_data, buf->om_len));
 
-	/* Update NID if RX or RX was with friend credentials */
-	if (rx->friend_cred) {
-		buf->om_data[0] &= 0x80; /* Clear everything except IVI */
-		buf->om_data[0] |= nid;
-	}
+	STATS_INC(ble_mesh_stats, relay);
 
-	/* We re-encrypt and obfuscate using the received IVI rather than
-	 * the normal TX IVI (which may be different) since the transport
-	 * layer nonce includes the IVI.
-	 */
-	if (bt_mesh_net_encrypt(enc, buf, BT_MESH_NET_IVI_RX(rx), false)) {
-		BT_ERR("Re-encrypting failed");
+	if (to_proxy && bt_mesh_proxy_relay(buf, rx->dst) &&
+	    BT_MESH_ADDR_IS_UNICAST(rx->dst)) {
 		goto done;
 	}
 
-	if (bt_mesh_net_obfuscate(buf->om_data, BT_MESH_NET_IVI_RX(rx), priv)) {
-		BT_ERR("Re-obfuscating failed");
-		goto done;
+	if (to_adv) {
+		bt_mesh_adv_send(buf, NULL, NULL);
 	}
 
-	BT_DBG("encoded %u bytes: %s", buf->om_len,
-	       bt_hex(buf->om_data, buf->om_len));
+done:
+	net_buf_unref(buf);
+}
 
-	/* Sending to the GATT bearer should only happen if GATT Proxy
-	 * is enabled or the message originates from the local node.
-	 */
-	if (IS_ENABLED(CONFIG_BT_MESH_GATT_PROXY) &&
-	    (bt_mesh_gatt_proxy_get() == BT_MESH_GATT_PROXY_ENABLED ||
-	     rx->net_if == BT_MESH_NET_IF_LOCAL)) {
-		if (bt_mesh_proxy_relay(buf, rx->dst) &&
-			    BT_MESH_ADDR_IS_UNICAST(rx->dst)) {
-			goto done;
+#if MYNEWT_VAL(BLE_MESH_SHELL)
+/* Runs the encoding half of bt_mesh_net_relay() count times: the relay
+ * buffer allocation and either the verbatim copy or the TTL update with
+ * re-encryption, depending on rx. Nothing is handed to the bearers.
+ */
+int bt_mesh_net_relay_bench(struct bt_mesh_net_rx *rx, struct os_mbuf *sbuf,
+			    struct os_mbuf *data, u32_t count, u32_t *elapsed)
+{
+	struct os_mbuf *buf;
+	u32_t start, i;
+	int err = 0;
+
+	start = k_uptime_get_32();
+
+	for (i = 0; i < count; i++) {
+		buf = bt_mesh_adv_relay_create(0, 0);
+		if (!buf) {
+			return -ENOBUFS;
 		}
-	}
 
-	if (relay_to_adv(rx->net_if)) {
-		bt_mesh_adv_send(buf, NULL, NULL);
+		if (relay_verbatim(rx)) {
+			net_buf_add_mem(buf, data->om_data, data->om_len);
+		} else {
+			err = relay_encode(sbuf, rx, buf);
+		}
+
+		net_buf_unref(buf);
+
+		if (err) {
+			return err;
+		}
 	}
 
-done:
-	net_buf_unref(buf);
+	*elapsed = k_uptime_get_32() - start;
+
+	return 0;
 }
+#endif
 
 int bt_mesh_net_decode(struct os_mbuf *data, enum bt_mesh_net_if net_if,
 		       struct bt_mesh_net_rx *rx, struct os_mbuf *buf)
@@ -1307,6 +1439,8 @@ void bt_mesh_net_recv(struct os_mbuf *data, s8_t rssi,
 		goto done;
 	}
 
+	STATS_INC(ble_mesh_stats, net_rx);
+
 	if (bt_mesh_net_decode(data, net_if, &rx, buf)) {
 		goto done;
 	}
@@ -1330,7 +1464,7 @@ void bt_mesh_net_recv(struct os_mbuf *data, s8_t rssi,
 	if (!BT_MESH_ADDR_IS_UNICAST(rx.dst) ||
 	    (!rx.local_match && !rx.friend_match)) {
 		net_buf_simple_restore(buf, &state);
-		bt_mesh_net_relay(buf, &rx);
+		bt_mesh_net_relay(buf, data, &rx);
 	}
 
 done:
@@ -24,6 +24,8 @@
 #include "atomic.h"
 #include "mesh/mesh.h"
 #include "mesh/glue.h"
+#include "crypto.h"
+#include "addr_set.h"
 
 struct bt_mesh_app_key {
 	u16_t net_idx;
@@ -32,6 +34,8 @@ struct bt_mesh_app_key {
 	struct bt_mesh_app_keys {
 		u8_t id;
 		u8_t val[16];
+		/* Expanded AppKey */
+		struct ble_aes_key sched;
 	} keys[2];
 };
 
@@ -66,6 +70,13 @@ struct bt_mesh_subnet {
 #endif
 		u8_t privacy[16];   /* PrivacyKey */
 		u8_t beacon[16];    /* BeaconKey */
+
+		/* Expanded EncKey, PrivacyKey and BeaconKey, used for every
+		 * network PDU and Secure Network Beacon.
+		 */
+		struct ble_aes_key enc_sched;
+		struct ble_aes_key privacy_sched;
+		struct ble_aes_cmac_key beacon_key;
 	} keys[2];
 };
 
@@ -99,6 +110,8 @@ struct bt_mesh_friend {
 
 	u16_t net_idx;
 
+	/* Subscription List, kept sorted in sub_list */
+	struct bt_mesh_addr_set sub;
 	u16_t sub_list[FRIEND_SUB_LIST_SIZE];
 
 	struct k_delayed_work timer;
@@ -112,6 +125,9 @@ struct bt_mesh_friend {
 	struct net_buf_slist_t queue;
 	u32_t queue_size;
 
+	/* Segment Acks in the queue, so that older ones can be superseded */
+	struct os_mbuf *ack[FRIEND_SEG_RX];
+
 	/* Friend Clear Procedure */
 	struct {
 		u32_t start;                  /* Clear Procedure start */
@@ -217,6 +233,7 @@ struct bt_mesh_net {
 	struct k_delayed_work ivu_complete;
 
 	u8_t dev_key[16];
+	struct ble_aes_key dev_key_sched;
 
 	struct bt_mesh_app_key app_keys[MYNEWT_VAL(BLE_MESH_APP_KEY_COUNT)];
 
@@ -273,6 +290,9 @@ int bt_mesh_net_keys_create(struct bt_mesh_subnet_keys *keys,
 int bt_mesh_net_create(u16_t idx, u8_t flags, const u8_t key[16],
 		       u32_t iv_index);
 
+/* Brings up the network state restored from persistent storage */
+void bt_mesh_net_restore(void);
+
 u8_t bt_mesh_net_flags(struct bt_mesh_subnet *sub);
 
 bool bt_mesh_kr_update(struct bt_mesh_subnet *sub, u8_t new_kr, bool new_key);
@@ -285,6 +305,9 @@ void bt_mesh_rpl_reset(void);
 
 bool bt_mesh_net_iv_update(u32_t iv_index, bool iv_update);
 
+/* Takes the next outgoing sequence number */
+u32_t bt_mesh_next_seq(void);
+
 void bt_mesh_net_sec_update(struct bt_mesh_subnet *sub);
 
 struct bt_mesh_subnet *bt_mesh_subnet_get(u16_t net_idx);
@@ -309,6 +332,9 @@ int bt_mesh_net_decode(struct os_mbuf *data, enum bt_mesh_net_if net_if,
 void bt_mesh_net_recv(struct os_mbuf *data, s8_t rssi,
 		      enum bt_mesh_net_if net_if);
 
+int bt_mesh_net_relay_bench(struct bt_mesh_net_rx *rx, struct os_mbuf *sbuf,
+			    struct os_mbuf *data, u32_t count, u32_t *elapsed);
+
 void bt_mesh_net_init(void);
 
 /* Friendship Credential Management */
@@ -319,15 +345,19 @@ struct friend_cred {
 	u16_t lpn_counter;
 	u16_t frnd_counter;
 
-	struct {
+	struct friend_cred_keys {
 		u8_t nid;         /* NID */
 		u8_t enc[16];     /* EncKey */
 		u8_t privacy[16]; /* PrivacyKey */
+
+		/* Expanded EncKey and PrivacyKey */
+		struct ble_aes_key enc_sched;
+		struct ble_aes_key privacy_sched;
 	} cred[2];
 };
 
-int friend_cred_get(struct bt_mesh_subnet *sub, u16_t addr, u8_t *nid,
-			    const u8_t **enc, const u8_t **priv);
+int friend_cred_get(struct bt_mesh_subnet *sub, u16_t addr,
+		    const struct friend_cred_keys **keys);
 int friend_cred_set(struct friend_cred *cred, u8_t idx, const u8_t net_key[16]);
 void friend_cred_refresh(u16_t net_idx);
 int friend_cred_update(struct bt_mesh_subnet *sub);
@@ -25,6 +25,7 @@
 #include "beacon.h"
 #include "foundation.h"
 #include "access.h"
+#include "addr_set.h"
 #include "proxy.h"
 
 #define PDU_TYPE(data)     (data[0] & BIT_MASK(6))
@@ -106,7 +107,8 @@ static bool prov_fast_adv;
 
 static struct bt_mesh_proxy_client {
 	uint16_t conn_handle;
-	u16_t filter[MYNEWT_VAL(BLE_MESH_PROXY_FILTER_SIZE)];
+	u16_t filter_addrs[MYNEWT_VAL(BLE_MESH_PROXY_FILTER_SIZE)];
+	struct bt_mesh_addr_set filter;
 	enum __packed {
 		NONE,
 		WHITELIST,
@@ -193,7 +195,7 @@ static struct bt_mesh_proxy_client *find_client(uint16_t conn_handle)
 static int next_idx;
 
 static int proxy_segment_and_send(uint16_t conn_handle, u8_t type,
-				  struct os_mbuf *msg);
+				  const u8_t *data, u16_t len);
 
 static int filter_set(struct bt_mesh_proxy_client *client,
 		      struct os_mbuf *buf)
@@ -210,11 +212,11 @@ static int filter_set(struct bt_mesh_proxy_client *client,
 
 	switch (type) {
 	case 0x00:
-		memset(client->filter, 0, sizeof(client->filter));
+		bt_mesh_addr_set_clear(&client->filter);
 		client->filter_type = WHITELIST;
 		break;
 	case 0x01:
-		memset(client->filter, 0, sizeof(client->filter));
+		bt_mesh_addr_set_clear(&client->filter);
 		client->filter_type = BLACKLIST;
 		break;
 	default:
@@ -227,44 +229,24 @@ static int filter_set(struct bt_mesh_proxy_client *client,
 
 static void filter_add(struct bt_mesh_proxy_client *client, u16_t addr)
 {
-	int i;
-
 	BT_DBG("addr 0x%04x", addr);
 
 	if (addr == BT_MESH_ADDR_UNASSIGNED) {
 		return;
 	}
 
-	for (i = 0; i < ARRAY_SIZE(client->filter); i++) {
-		if (client->filter[i] == addr) {
-			return;
-		}
-	}
-
-	for (i = 0; i < ARRAY_SIZE(client->filter); i++) {
-		if (client->filter[i] == BT_MESH_ADDR_UNASSIGNED) {
-			client->filter[i] = addr;
-			return;
-		}
-	}
+	bt_mesh_addr_set_add(&client->filter, addr);
 }
 
 static void filter_remove(struct bt_mesh_proxy_client *client, u16_t addr)
 {
-	int i;
-
 	BT_DBG("addr 0x%04x", addr);
 
 	if (addr == BT_MESH_ADDR_UNASSIGNED) {
 		return;
 	}
 
-	for (i = 0; i < ARRAY_SIZE(client->filter); i++) {
-		if (client->filter[i] == addr) {
-			client->filter[i] = BT_MESH_ADDR_UNASSIGNED;
-			return;
-		}
-	}
+	bt_mesh_addr_set_del(&client->filter, addr);
 }
 
 static void send_filter_status(struct bt_mesh_proxy_client *client,
@@ -276,8 +258,7 @@ static void send_filter_status(struct bt_mesh_proxy_client *client,
 		.ctx = &rx->ctx,
 		.src = bt_mesh_primary_addr(),
 	};
-	u16_t filter_size;
-	int i, err;
+	int err;
 
 	/* Configuration messages always have dst unassigned */
 	tx.ctx->addr = BT_MESH_ADDR_UNASSIGNED;
@@ -292,13 +273,7 @@ static void send_filter_status(struct bt_mesh_proxy_client *client,
 		net_buf_simple_add_u8(buf, 0x01);
 	}
 
-	for (filter_size = 0, i = 0; i < ARRAY_SIZE(client->filter); i++) {
-		if (client->filter[i] != BT_MESH_ADDR_UNASSIGNED) {
-			filter_size++;
-		}
-	}
-
-	net_buf_simple_add_be16(buf, filter_size);
+	net_buf_simple_add_be16(buf, client->filter.count);
 
 	BT_DBG("%u bytes: %s", buf->om_len, bt_hex(buf->om_data, buf->om_len));
 
@@ -308,7 +283,8 @@ static void send_filter_status(struct bt_mesh_proxy_client *client,
 		return;
 	}
 
-	err = proxy_segment_and_send(client->conn_handle, BT_MESH_PROXY_CONFIG, buf);
+	err = proxy_segment_and_send(client->conn_handle, BT_MESH_PROXY_CONFIG,
+				     buf->om_data, buf->om_len);
 	if (err) {
 		BT_ERR("Failed to send proxy cfg message (err %d)", err);
 	}
@@ -379,7 +355,8 @@ static int beacon_send(uint16_t conn_handle, struct bt_mesh_subnet *sub)
 	net_buf_simple_init(buf, 1);
 	bt_mesh_beacon_create(sub, buf);
 
-	rc = proxy_segment_and_send(conn_handle, BT_MESH_PROXY_BEACON, buf);
+	rc = proxy_segment_and_send(conn_handle, BT_MESH_PROXY_BEACON,
+				    buf->om_data, buf->om_len);
 	os_mbuf_free_chain(buf);
 	return rc;
 }
@@ -620,7 +597,7 @@ static void proxy_connected(uint16_t conn_handle)
 
 	client->conn_handle = conn_handle;
 	client->filter_type = NONE;
-	memset(client->filter, 0, sizeof(client->filter));
+	bt_mesh_addr_set_clear(&client->filter);
 	net_buf_simple_init(client->buf, 0);
 }
 
@@ -839,28 +816,30 @@ void bt_mesh_proxy_addr_add(struct os_mbuf *buf, u16_t addr)
 static bool client_filter_match(struct bt_mesh_proxy_client *client,
 				u16_t addr)
 {
-	int i;
-
 	BT_DBG("filter_type %u addr 0x%04x", client->filter_type, addr);
 
 	if (client->filter_type == WHITELIST) {
-		for (i = 0; i < ARRAY_SIZE(client->filter); i++) {
-			if (client->filter[i] == addr) {
-				return true;
-			}
-		}
-
-		return false;
+		return bt_mesh_addr_set_has(&client->filter, addr);
 	}
 
 	if (client->filter_type == BLACKLIST) {
-		for (i = 0; i < ARRAY_SIZE(client->filter); i++) {
-			if (client->filter[i] == addr) {
-				return false;
-			}
-		}
+		return !bt_mesh_addr_set_has(&client->filter, addr);
+	}
+
+	return false;
+}
 
-		return true;
+/* Tells whether bt_mesh_proxy_relay() would send to any client */
+bool bt_mesh_proxy_filter_match(u16_t dst)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(clients); i++) {
+		struct bt_mesh_proxy_client *client = &clients[i];
+
+		if (client->conn_handle && client_filter_match(client, dst)) {
+			return true;
+		}
 	}
 
 	return false;
@@ -875,7 +854,6 @@ bool bt_mesh_proxy_relay(struct os_mbuf *buf, u16_t dst)
 
 	for (i = 0; i < ARRAY_SIZE(clients); i++) {
 		struct bt_mesh_proxy_client *client = &clients[i];
-		struct os_mbuf *msg;
 
 		if (!client->conn_handle) {
 			continue;
@@ -885,15 +863,12 @@ bool bt_mesh_proxy_relay(struct os_mbuf *buf, u16_t dst)
 			continue;
 		}
 
-		/* Proxy PDU sending modifies the original buffer,
-		 * so we need to make a copy.
+		/* All clients are sent segments of the same PDU, each
+		 * segment being copied only into its notification.
 		 */
-		msg = NET_BUF_SIMPLE(32);
-		net_buf_simple_init(msg, 1);
-		net_buf_simple_add_mem(msg, buf->om_data, buf->om_len);
-
-		bt_mesh_proxy_send(client->conn_handle, BT_MESH_PROXY_NET_PDU, msg);
-		os_mbuf_free_chain(msg);
+		proxy_segment_and_send(client->conn_handle,
+				       BT_MESH_PROXY_NET_PDU, buf->om_data,
+				       buf->om_len);
 		relayed = true;
 	}
 
@@ -902,63 +877,85 @@ bool bt_mesh_proxy_relay(struct os_mbuf *buf, u16_t dst)
 
 #endif /* MYNEWT_VAL(BLE_MESH_GATT_PROXY) */
 
-static int proxy_send(uint16_t conn_handle, const void *data, u16_t len)
+static int proxy_send(uint16_t conn_handle, u8_t hdr, const u8_t *data,
+		      u16_t len)
 {
+	uint16_t attr_handle;
 	struct os_mbuf *om;
+	int rc;
 
-	BT_DBG("%u bytes: %s", len, bt_hex(data, len));
+	BT_DBG("hdr 0x%02x %u bytes: %s", hdr, len, bt_hex(data, len));
 
 #if (MYNEWT_VAL(BLE_MESH_GATT_PROXY))
 	if (gatt_svc == MESH_GATT_PROXY) {
-		om = ble_hs_mbuf_from_flat(data, len);
-		assert(om);
-		ble_gattc_notify_custom(conn_handle, svc_handles.proxy_data_out_h, om);
-	}
+		attr_handle = svc_handles.proxy_data_out_h;
+	} else
 #endif
-
 #if (MYNEWT_VAL(BLE_MESH_PB_GATT))
 	if (gatt_svc == MESH_GATT_PROV) {
-		om = ble_hs_mbuf_from_flat(data, len);
-		assert(om);
-		ble_gattc_notify_custom(conn_handle, svc_handles.prov_data_out_h, om);
-	}
+		attr_handle = svc_handles.prov_data_out_h;
+	} else
 #endif
+	{
+		return 0;
+	}
+
+	om = ble_hs_mbuf_att_pkt();
+	if (!om) {
+		return -ENOMEM;
+	}
+
+	rc = os_mbuf_append(om, &hdr, sizeof(hdr));
+	if (rc == 0) {
+		rc = os_mbuf_append(om, data, len);
+	}
+
+	if (rc) {
+		os_mbuf_free_chain(om);
+		return -ENOMEM;
+	}
+
+	rc = ble_gattc_notify_custom(conn_handle, attr_handle, om);
+	if (rc) {
+		return -EIO;
+	}
 
 	return 0;
 }
 
 static int proxy_segment_and_send(uint16_t conn_handle, u8_t type,
-				  struct os_mbuf *msg)
+				  const u8_t *data, u16_t len)
 {
 	u16_t mtu;
+	int err;
 
-	BT_DBG("conn_handle %d type 0x%02x len %u: %s", conn_handle, type, msg->om_len,
-	       bt_hex(msg->om_data, msg->om_len));
+	BT_DBG("conn_handle %d type 0x%02x len %u: %s", conn_handle, type, len,
+	       bt_hex(data, len));
 
-	/* ATT_MTU - OpCode (1 byte) - Handle (2 bytes) */
-	mtu = ble_att_mtu(conn_handle) - 3;
-	if (mtu > msg->om_len) {
-		net_buf_simple_push_u8(msg, PDU_HDR(SAR_COMPLETE, type));
-		return proxy_send(conn_handle, msg->om_data, msg->om_len);
+	/* ATT_MTU - OpCode (1 byte) - Handle (2 bytes) - SAR header */
+	mtu = ble_att_mtu(conn_handle) - 4;
+	if (mtu >= len) {
+		return proxy_send(conn_handle, PDU_HDR(SAR_COMPLETE, type),
+				  data, len);
 	}
 
-	net_buf_simple_push_u8(msg, PDU_HDR(SAR_FIRST, type));
-	proxy_send(conn_handle, msg->om_data, mtu);
-	net_buf_simple_pull(msg, mtu);
+	err = proxy_send(conn_handle, PDU_HDR(SAR_FIRST, type), data, mtu);
+	data += mtu;
+	len -= mtu;
 
-	while (msg->om_len) {
-		if (msg->om_len + 1 < mtu) {
-			net_buf_simple_push_u8(msg, PDU_HDR(SAR_LAST, type));
-			proxy_send(conn_handle, msg->om_data, msg->om_len);
-			break;
-		}
+	while (!err && len > mtu) {
+		err = proxy_send(conn_handle, PDU_HDR(SAR_CONT, type), data,
+				 mtu);
+		data += mtu;
+		len -= mtu;
+	}
 
-		net_buf_simple_push_u8(msg, PDU_HDR(SAR_CONT, type));
-		proxy_send(conn_handle, msg->om_data, mtu);
-		net_buf_simple_pull(msg, mtu);
+	if (!err) {
+		err = proxy_send(conn_handle, PDU_HDR(SAR_LAST, type), data,
+				 len);
 	}
 
-	return 0;
+	return err;
 }
 
 int bt_mesh_proxy_send(uint16_t conn_handle, u8_t type,
@@ -976,7 +973,8 @@ int bt_mesh_proxy_send(uint16_t conn_handle, u8_t type,
 		return -EINVAL;
 	}
 
-	return proxy_segment_and_send(conn_handle, type, msg);
+	return proxy_segment_and_send(conn_handle, type, msg->om_data,
+				      msg->om_len);
 }
 
 #if (MYNEWT_VAL(BLE_MESH_PB_GATT))
@@ -1336,6 +1334,8 @@ int bt_mesh_proxy_init(void)
 		k_work_init(&clients[i].send_beacons, proxy_send_beacons);
 #endif
 		clients[i].buf = NET_BUF_SIMPLE(CLIENT_BUF_SIZE);
+		bt_mesh_addr_set_init(&clients[i].filter, clients[i].filter_addrs,
+				      ARRAY_SIZE(clients[i].filter_addrs));
 	}
 
 #if (MYNEWT_VAL(BLE_MESH_PB_GATT))
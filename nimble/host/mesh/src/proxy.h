@@ -36,6 +36,7 @@ void bt_mesh_proxy_identity_start(struct bt_mesh_subnet *sub);
 void bt_mesh_proxy_identity_stop(struct bt_mesh_subnet *sub);
 
 bool bt_mesh_proxy_relay(struct os_mbuf *buf, u16_t dst);
+bool bt_mesh_proxy_filter_match(u16_t dst);
 void bt_mesh_proxy_addr_add(struct os_mbuf *buf, u16_t addr);
 
 int bt_mesh_proxy_init(void);
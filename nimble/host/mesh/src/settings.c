@@ -0,0 +1,1210 @@
+/*  Bluetooth Mesh */
+
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(BLE_MESH_SETTINGS)
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <stdbool.h>
+
+#include "mesh/mesh.h"
+#include "config/config.h"
+#include "base64/base64.h"
+
+#define BT_DBG_ENABLED (MYNEWT_VAL(BLE_MESH_DEBUG_SETTINGS))
+#include "host/ble_hs_log.h"
+
+#include "mesh_priv.h"
+#include "crypto.h"
+#include "net.h"
+#include "transport.h"
+#include "access.h"
+#include "foundation.h"
+#include "settings.h"
+
+#define SEQ_STORE_RATE    MYNEWT_VAL(BLE_MESH_SEQ_STORE_RATE)
+#define SEQ_MAX           0xffffff
+#define STORE_TIMEOUT     K_SECONDS(MYNEWT_VAL(BLE_MESH_STORE_TIMEOUT))
+#define RPL_STORE_TIMEOUT K_SECONDS(MYNEWT_VAL(BLE_MESH_RPL_STORE_TIMEOUT))
+
+#define CID_NVAL          0xffff
+
+/* bt_mesh_model.flags */
+#define MOD_STORE_PENDING BIT(0)
+#define MOD_STORED        BIT(1)
+
+/* Longest name is "bt_mesh/AppKey/<idx>" */
+#define NAME_MAX_LEN      24
+
+/* Net: primary element address and DevKey */
+struct net_val {
+	u16_t primary_addr;
+	u8_t  dev_key[16];
+} __packed;
+
+/* IV: IV Index and IV Update flag */
+struct iv_val {
+	u32_t iv_index;
+	u8_t  iv_update;
+} __packed;
+
+/* Seq: end of the reserved block of sequence numbers */
+struct seq_val {
+	u8_t val[3];
+} __packed;
+
+/* RPL/<idx>: replay protection list entry */
+struct rpl_val {
+	u16_t src;
+	u8_t  old_iv;
+	u8_t  seq[3];
+} __packed;
+
+/* NetKey/<idx>: subnet keys and Key Refresh state */
+struct net_key_val {
+	u16_t net_idx;
+	u8_t  kr_flag;
+	u8_t  kr_phase;
+	u8_t  val[2][16];
+} __packed;
+
+/* AppKey/<idx>: application keys */
+struct app_key_val {
+	u16_t net_idx;
+	u16_t app_idx;
+	u8_t  updated;
+	u8_t  val[2][16];
+} __packed;
+
+/* Label/<idx>: Label UUID of a virtual address in use */
+struct label_val {
+	u16_t ref;
+	u16_t addr;
+	u8_t  uuid[16];
+} __packed;
+
+/* Cfg: Configuration Server states */
+struct cfg_val {
+	u8_t net_transmit;
+	u8_t relay;
+	u8_t relay_retransmit;
+	u8_t beacon;
+	u8_t gatt_proxy;
+	u8_t frnd;
+	u8_t default_ttl;
+} __packed;
+
+/* Mod/<idx>: bindings, subscriptions and publication of the model at the
+ * given position in the composition.
+ */
+struct mod_val {
+	u16_t company;
+	u16_t id;
+	u16_t keys[CONFIG_BT_MESH_MODEL_KEY_COUNT];
+	u16_t groups[CONFIG_BT_MESH_MODEL_GROUP_COUNT];
+	u16_t pub_addr;
+	u16_t pub_key;
+	u8_t  pub_ttl;
+	u8_t  pub_retransmit;
+	u8_t  pub_period;
+	u8_t  pub_cred;
+} __packed;
+
+union settings_val {
+	struct net_val net;
+	struct iv_val iv;
+	struct seq_val seq;
+	struct rpl_val rpl;
+	struct net_key_val net_key;
+	struct app_key_val app_key;
+	struct label_val label;
+	struct cfg_val cfg;
+	struct mod_val mod;
+};
+
+/* Bits of the pending and stored maps. Models keep theirs in their flags. */
+enum {
+	NET_REC,
+	IV_REC,
+	SEQ_REC,
+	CFG_REC,
+	RPL_REC,
+	NET_KEY_REC = RPL_REC + MYNEWT_VAL(BLE_MESH_CRPL),
+	APP_KEY_REC = NET_KEY_REC + MYNEWT_VAL(BLE_MESH_SUBNET_COUNT),
+	LABEL_REC = APP_KEY_REC + MYNEWT_VAL(BLE_MESH_APP_KEY_COUNT),
+	MOD_REC = LABEL_REC + MYNEWT_VAL(BLE_MESH_LABEL_COUNT),
+	REC_NUM,
+};
+
+/* Records waiting to be written */
+static ATOMIC_DEFINE(pending, REC_NUM);
+
+/* Records present in storage; deleting any other record is a no-op */
+static ATOMIC_DEFINE(stored, REC_NUM);
+
+static struct k_delayed_work pending_store;
+
+/* Sequence numbers below this value are covered by the stored Seq record */
+static u32_t seq_reserved;
+
+/* State found by the last load, applied on commit */
+static struct {
+	bool  any;
+	bool  net;
+	bool  cfg;
+	u16_t primary_addr;
+	struct cfg_val cfg_val;
+} load;
+
+static int save_val(const char *name, const void *val, int len)
+{
+	char buf[BASE64_ENCODE_SIZE(sizeof(union settings_val)) + 1];
+	int err;
+
+	if (val) {
+		base64_encode(val, len, buf, 1);
+		err = conf_save_one(name, buf);
+	} else {
+		err = conf_save_one(name, NULL);
+	}
+
+	if (err) {
+		BT_ERR("Failed to store %s (err %d)", name, err);
+		return -EIO;
+	}
+
+	BT_DBG("%s %s", val ? "Stored" : "Deleted", name);
+
+	return 0;
+}
+
+/* Writes a record, or deletes it if val is NULL */
+static int store_rec(int rec, const char *name, const void *val, int len)
+{
+	int err;
+
+	if (!val && !atomic_test_bit(stored, rec)) {
+		return 0;
+	}
+
+	err = save_val(name, val, len);
+	if (err) {
+		return err;
+	}
+
+	if (val) {
+		atomic_set_bit(stored, rec);
+	} else {
+		atomic_clear_bit(stored, rec);
+	}
+
+	return 0;
+}
+
+static int load_val(const char *enc, void *val, int len)
+{
+	u8_t buf[sizeof(union settings_val) + 3];
+
+	if (strlen(enc) != BASE64_ENCODE_SIZE(len)) {
+		return -EINVAL;
+	}
+
+	if (base64_decode(enc, buf) != len) {
+		return -EINVAL;
+	}
+
+	memcpy(val, buf, len);
+
+	return 0;
+}
+
+struct mod_find {
+	int idx;
+	struct bt_mesh_model *mod;
+	bool vnd;
+};
+
+static void mod_find(struct bt_mesh_model *mod, struct bt_mesh_elem *elem,
+		     bool vnd, bool primary, void *user_data)
+{
+	struct mod_find *find = user_data;
+
+	if (find->idx-- == 0) {
+		find->mod = mod;
+		find->vnd = vnd;
+	}
+}
+
+static bool mod_is_default(struct bt_mesh_model *mod)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(mod->keys); i++) {
+		if (mod->keys[i] != BT_MESH_KEY_UNUSED) {
+			return false;
+		}
+	}
+
+	for (i = 0; i < ARRAY_SIZE(mod->groups); i++) {
+		if (mod->groups[i] != BT_MESH_ADDR_UNASSIGNED) {
+			return false;
+		}
+	}
+
+	return !mod->pub || mod->pub->addr == BT_MESH_ADDR_UNASSIGNED;
+}
+
+static void mod_reset(struct bt_mesh_model *mod, struct bt_mesh_elem *elem,
+		      bool vnd, bool primary, void *user_data)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(mod->keys); i++) {
+		mod->keys[i] = BT_MESH_KEY_UNUSED;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(mod->groups); i++) {
+		mod->groups[i] = BT_MESH_ADDR_UNASSIGNED;
+	}
+
+	if (mod->pub) {
+		mod->pub->addr = BT_MESH_ADDR_UNASSIGNED;
+		mod->pub->key = 0;
+		mod->pub->cred = 0;
+		mod->pub->ttl = 0;
+		mod->pub->period = 0;
+		mod->pub->retransmit = 0;
+		mod->pub->count = 0;
+	}
+}
+
+static int net_set(char *val)
+{
+	struct net_val net;
+	int err;
+
+	err = load_val(val, &net, sizeof(net));
+	if (err) {
+		return err;
+	}
+
+	memcpy(bt_mesh.dev_key, net.dev_key, 16);
+	ble_aes_set_key(&bt_mesh.dev_key_sched, bt_mesh.dev_key);
+	load.primary_addr = net.primary_addr;
+	load.net = true;
+
+	return 0;
+}
+
+static int iv_set(char *val)
+{
+	struct iv_val iv;
+	int err;
+
+	err = load_val(val, &iv, sizeof(iv));
+	if (err) {
+		return err;
+	}
+
+	bt_mesh.iv_index = iv.iv_index;
+	bt_mesh.iv_update = iv.iv_update;
+
+	return 0;
+}
+
+static int seq_set(char *val)
+{
+	struct seq_val seq;
+	int err;
+
+	err = load_val(val, &seq, sizeof(seq));
+	if (err) {
+		return err;
+	}
+
+	/* Continue after the reserved block; some of it may have been used
+	 * before the reset.
+	 */
+	seq_reserved = ((u32_t)seq.val[0] << 16 | (u32_t)seq.val[1] << 8 |
+			seq.val[2]);
+	bt_mesh.seq = seq_reserved;
+
+	BT_DBG("Seq 0x%06x", seq_reserved);
+
+	return 0;
+}
+
+static int rpl_set(int idx, char *val)
+{
+	struct bt_mesh_rpl *rpl = &bt_mesh.rpl[idx];
+	struct rpl_val rv;
+	int err;
+
+	err = load_val(val, &rv, sizeof(rv));
+	if (err) {
+		return err;
+	}
+
+	rpl->src = rv.src;
+	rpl->old_iv = rv.old_iv;
+	rpl->seq = ((u32_t)rv.seq[0] << 16 | (u32_t)rv.seq[1] << 8 |
+		    rv.seq[2]);
+
+	return 0;
+}
+
+static int net_key_set(int idx, char *val)
+{
+	struct bt_mesh_subnet *sub = &bt_mesh.sub[idx];
+	struct net_key_val key;
+	int err;
+
+	err = load_val(val, &key, sizeof(key));
+	if (err) {
+		return err;
+	}
+
+	/* The derived keys are generated on commit */
+	sub->net_idx = key.net_idx;
+	sub->kr_flag = key.kr_flag;
+	sub->kr_phase = key.kr_phase;
+	memcpy(sub->keys[0].net, key.val[0], 16);
+	memcpy(sub->keys[1].net, key.val[1], 16);
+
+	return 0;
+}
+
+static int app_key_set(int idx, char *val)
+{
+	struct bt_mesh_app_key *app = &bt_mesh.app_keys[idx];
+	struct app_key_val key;
+	int err;
+
+	err = load_val(val, &key, sizeof(key));
+	if (err) {
+		return err;
+	}
+
+	app->net_idx = key.net_idx;
+	app->app_idx = key.app_idx;
+	app->updated = key.updated;
+	memcpy(app->keys[0].val, key.val[0], 16);
+	memcpy(app->keys[1].val, key.val[1], 16);
+
+	return 0;
+}
+
+static int label_set(int idx, char *val)
+{
+	struct label *lbl = bt_mesh_label_get(idx);
+	struct label_val lv;
+	int err;
+
+	err = load_val(val, &lv, sizeof(lv));
+	if (err) {
+		return err;
+	}
+
+	lbl->ref = lv.ref;
+	lbl->addr = lv.addr;
+	memcpy(lbl->uuid, lv.uuid, 16);
+
+	return 0;
+}
+
+static int cfg_set(char *val)
+{
+	int err;
+
+	err = load_val(val, &load.cfg_val, sizeof(load.cfg_val));
+	if (err) {
+		return err;
+	}
+
+	load.cfg = true;
+
+	return 0;
+}
+
+static int mod_set(struct bt_mesh_model *mod, bool vnd, char *val)
+{
+	struct mod_val mv;
+	int err;
+
+	err = load_val(val, &mv, sizeof(mv));
+	if (err) {
+		return err;
+	}
+
+	/* The composition may have changed with a firmware update */
+	if (mv.company != (vnd ? mod->vnd.company : CID_NVAL) ||
+	    mv.id != (vnd ? mod->vnd.id : mod->id)) {
+		BT_WARN("Stored model 0x%04x:0x%04x does not match",
+			mv.company, mv.id);
+		return 0;
+	}
+
+	memcpy(mod->keys, mv.keys, sizeof(mod->keys));
+	memcpy(mod->groups, mv.groups, sizeof(mod->groups));
+
+	if (mod->pub) {
+		mod->pub->addr = mv.pub_addr;
+		mod->pub->key = mv.pub_key;
+		mod->pub->ttl = mv.pub_ttl;
+		mod->pub->retransmit = mv.pub_retransmit;
+		mod->pub->period = mv.pub_period;
+		mod->pub->cred = mv.pub_cred;
+		mod->pub->count = 0;
+	}
+
+	return 0;
+}
+
+static int rec_idx(int argc, char **argv, int count)
+{
+	char *endptr;
+	long idx;
+
+	if (argc != 2) {
+		return -ENOENT;
+	}
+
+	idx = strtol(argv[1], &endptr, 10);
+	if (*endptr != '\0' || idx < 0 || idx >= count) {
+		return -ENOENT;
+	}
+
+	return idx;
+}
+
+static int mesh_conf_set(int argc, char **argv, char *val)
+{
+	struct mod_find find;
+	bool empty;
+	int rec;
+	int idx;
+
+	if (argc < 1) {
+		return -ENOENT;
+	}
+
+	BT_DBG("name %s", argv[0]);
+
+	idx = 0;
+	find.mod = NULL;
+
+	if (!strcmp(argv[0], "Net") && argc == 1) {
+		rec = NET_REC;
+	} else if (!strcmp(argv[0], "IV") && argc == 1) {
+		rec = IV_REC;
+	} else if (!strcmp(argv[0], "Seq") && argc == 1) {
+		rec = SEQ_REC;
+	} else if (!strcmp(argv[0], "Cfg") && argc == 1) {
+		rec = CFG_REC;
+	} else if (!strcmp(argv[0], "RPL")) {
+		idx = rec_idx(argc, argv, ARRAY_SIZE(bt_mesh.rpl));
+		rec = RPL_REC + idx;
+	} else if (!strcmp(argv[0], "NetKey")) {
+		idx = rec_idx(argc, argv, ARRAY_SIZE(bt_mesh.sub));
+		rec = NET_KEY_REC + idx;
+	} else if (!strcmp(argv[0], "AppKey")) {
+		idx = rec_idx(argc, argv, ARRAY_SIZE(bt_mesh.app_keys));
+		rec = APP_KEY_REC + idx;
+	} else if (!strcmp(argv[0], "Label")) {
+		idx = rec_idx(argc, argv, MYNEWT_VAL(BLE_MESH_LABEL_COUNT));
+		rec = LABEL_REC + idx;
+	} else if (!strcmp(argv[0], "Mod")) {
+		find.idx = rec_idx(argc, argv, 0xffff);
+		idx = find.idx;
+		if (idx >= 0) {
+			bt_mesh_model_foreach(mod_find, &find);
+			if (!find.mod) {
+				BT_WARN("No model %d in the composition", idx);
+				return 0;
+			}
+		}
+		rec = MOD_REC;
+	} else {
+		return -ENOENT;
+	}
+
+	if (idx < 0) {
+		return idx;
+	}
+
+	/* Deleted records are reported with an empty value */
+	empty = (val == NULL || val[0] == '\0');
+
+	if (find.mod) {
+		if (empty) {
+			find.mod->flags &= ~MOD_STORED;
+		} else {
+			find.mod->flags |= MOD_STORED;
+		}
+	} else if (empty) {
+		atomic_clear_bit(stored, rec);
+	} else {
+		atomic_set_bit(stored, rec);
+	}
+
+	/* Never overwrite the state of a running node */
+	if (bt_mesh_is_provisioned()) {
+		return 0;
+	}
+
+	if (empty) {
+		if (rec == NET_REC) {
+			memset(bt_mesh.dev_key, 0, sizeof(bt_mesh.dev_key));
+			memset(&bt_mesh.dev_key_sched, 0,
+			       sizeof(bt_mesh.dev_key_sched));
+			load.net = false;
+		}
+
+		return 0;
+	}
+
+	load.any = true;
+
+	switch (rec) {
+	case NET_REC:
+		return net_set(val);
+	case IV_REC:
+		return iv_set(val);
+	case SEQ_REC:
+		return seq_set(val);
+	case CFG_REC:
+		return cfg_set(val);
+	case MOD_REC:
+		return mod_set(find.mod, find.vnd, val);
+	}
+
+	if (rec < NET_KEY_REC) {
+		return rpl_set(idx, val);
+	} else if (rec < APP_KEY_REC) {
+		return net_key_set(idx, val);
+	} else if (rec < LABEL_REC) {
+		return app_key_set(idx, val);
+	} else {
+		return label_set(idx, val);
+	}
+}
+
+static int subnet_restore(struct bt_mesh_subnet *sub)
+{
+	u8_t key[16];
+	int err;
+
+	memcpy(key, sub->keys[0].net, 16);
+	err = bt_mesh_net_keys_create(&sub->keys[0], key);
+	if (err) {
+		return err;
+	}
+
+	if (sub->kr_phase != BT_MESH_KR_NORMAL) {
+		memcpy(key, sub->keys[1].net, 16);
+		err = bt_mesh_net_keys_create(&sub->keys[1], key);
+		if (err) {
+			return err;
+		}
+	}
+
+	if ((MYNEWT_VAL(BLE_MESH_GATT_PROXY))) {
+		sub->node_id = BT_MESH_NODE_IDENTITY_STOPPED;
+	} else {
+		sub->node_id = BT_MESH_NODE_IDENTITY_NOT_SUPPORTED;
+	}
+
+	return 0;
+}
+
+static int app_key_restore(struct bt_mesh_app_key *key)
+{
+	int i;
+
+	for (i = 0; i < (key->updated ? 2 : 1); i++) {
+		struct bt_mesh_app_keys *keys = &key->keys[i];
+
+		if (bt_mesh_app_id(keys->val, &keys->id)) {
+			return -EIO;
+		}
+
+		ble_aes_set_key(&keys->sched, keys->val);
+	}
+
+	return 0;
+}
+
+static void mod_pub_start(struct bt_mesh_model *mod,
+			  struct bt_mesh_elem *elem, bool vnd, bool primary,
+			  void *user_data)
+{
+	s32_t period_ms;
+
+	if (!mod->pub || !mod->pub->update ||
+	    mod->pub->addr == BT_MESH_ADDR_UNASSIGNED) {
+		return;
+	}
+
+	period_ms = bt_mesh_model_pub_period_get(mod);
+	if (period_ms) {
+		k_delayed_work_submit(&mod->pub->timer, period_ms);
+	}
+}
+
+/* Drops whatever was loaded from a partially stored or deleted node */
+static void discard(void)
+{
+	int i;
+
+	BT_WARN("Discarding incomplete mesh state");
+
+	bt_mesh.iv_index = 0;
+	bt_mesh.iv_update = 0;
+	bt_mesh.seq = 0;
+	memset(bt_mesh.dev_key, 0, sizeof(bt_mesh.dev_key));
+	memset(&bt_mesh.dev_key_sched, 0, sizeof(bt_mesh.dev_key_sched));
+	memset(bt_mesh.rpl, 0, sizeof(bt_mesh.rpl));
+
+	for (i = 0; i < ARRAY_SIZE(bt_mesh.sub); i++) {
+		memset(&bt_mesh.sub[i], 0, sizeof(bt_mesh.sub[i]));
+		bt_mesh.sub[i].net_idx = BT_MESH_KEY_UNUSED;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(bt_mesh.app_keys); i++) {
+		memset(&bt_mesh.app_keys[i], 0, sizeof(bt_mesh.app_keys[i]));
+		bt_mesh.app_keys[i].net_idx = BT_MESH_KEY_UNUSED;
+	}
+
+	for (i = 0; i < MYNEWT_VAL(BLE_MESH_LABEL_COUNT); i++) {
+		memset(bt_mesh_label_get(i), 0, sizeof(struct label));
+	}
+
+	bt_mesh_model_foreach(mod_reset, NULL);
+	bt_mesh_sub_index_rebuild();
+
+	bt_mesh_clear_all();
+}
+
+static int mesh_conf_commit(void)
+{
+	struct bt_mesh_cfg_srv *cfg;
+	bool subnet = false;
+	int i;
+
+	if (!load.any) {
+		return 0;
+	}
+
+	load.any = false;
+
+	BT_DBG("");
+
+	if (!load.net) {
+		discard();
+		return 0;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(bt_mesh.sub); i++) {
+		struct bt_mesh_subnet *sub = &bt_mesh.sub[i];
+
+		if (sub->net_idx == BT_MESH_KEY_UNUSED) {
+			continue;
+		}
+
+		if (subnet_restore(sub)) {
+			BT_ERR("Failed to restore NetKey 0x%03x", sub->net_idx);
+			memset(sub, 0, sizeof(*sub));
+			sub->net_idx = BT_MESH_KEY_UNUSED;
+			continue;
+		}
+
+		subnet = true;
+	}
+
+	if (!subnet) {
+		discard();
+		return 0;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(bt_mesh.app_keys); i++) {
+		struct bt_mesh_app_key *key = &bt_mesh.app_keys[i];
+
+		if (key->net_idx == BT_MESH_KEY_UNUSED) {
+			continue;
+		}
+
+		if (app_key_restore(key)) {
+			BT_ERR("Failed to restore AppKey 0x%03x", key->app_idx);
+			memset(key, 0, sizeof(*key));
+			key->net_idx = BT_MESH_KEY_UNUSED;
+		}
+	}
+
+	cfg = bt_mesh_cfg_get();
+	if (load.cfg && cfg) {
+		cfg->net_transmit = load.cfg_val.net_transmit;
+		cfg->relay = load.cfg_val.relay;
+		cfg->relay_retransmit = load.cfg_val.relay_retransmit;
+		cfg->beacon = load.cfg_val.beacon;
+		cfg->gatt_proxy = load.cfg_val.gatt_proxy;
+		cfg->frnd = load.cfg_val.frnd;
+		cfg->default_ttl = load.cfg_val.default_ttl;
+	}
+
+	bt_mesh_sub_index_rebuild();
+
+	BT_INFO("Restored node 0x%04x IV Index 0x%08x Seq 0x%06x",
+		load.primary_addr, bt_mesh.iv_index, bt_mesh.seq);
+
+	bt_mesh_net_restore();
+	bt_mesh_restore(load.primary_addr);
+
+	bt_mesh_model_foreach(mod_pub_start, NULL);
+
+	return 0;
+}
+
+static struct conf_handler bt_mesh_conf_handler = {
+	.ch_name = "bt_mesh",
+	.ch_get = NULL,
+	.ch_set = mesh_conf_set,
+	.ch_commit = mesh_conf_commit,
+	.ch_export = NULL,
+};
+
+static int store_net(void)
+{
+	struct net_val net;
+
+	if (!bt_mesh_is_provisioned()) {
+		return store_rec(NET_REC, "bt_mesh/Net", NULL, 0);
+	}
+
+	net.primary_addr = bt_mesh_primary_addr();
+	memcpy(net.dev_key, bt_mesh.dev_key, 16);
+
+	return store_rec(NET_REC, "bt_mesh/Net", &net, sizeof(net));
+}
+
+static int store_iv(void)
+{
+	struct iv_val iv;
+
+	if (!bt_mesh_is_provisioned()) {
+		return store_rec(IV_REC, "bt_mesh/IV", NULL, 0);
+	}
+
+	iv.iv_index = bt_mesh.iv_index;
+	iv.iv_update = bt_mesh.iv_update;
+
+	return store_rec(IV_REC, "bt_mesh/IV", &iv, sizeof(iv));
+}
+
+/* Reserves the next SEQ_STORE_RATE sequence numbers */
+static int store_seq(void)
+{
+	struct seq_val seq;
+	u32_t end;
+	int err;
+
+	if (!bt_mesh_is_provisioned()) {
+		seq_reserved = 0;
+		return store_rec(SEQ_REC, "bt_mesh/Seq", NULL, 0);
+	}
+
+	end = min(bt_mesh.seq + SEQ_STORE_RATE, SEQ_MAX);
+
+	seq.val[0] = end >> 16;
+	seq.val[1] = end >> 8;
+	seq.val[2] = end;
+
+	err = store_rec(SEQ_REC, "bt_mesh/Seq", &seq, sizeof(seq));
+	if (err) {
+		return err;
+	}
+
+	seq_reserved = end;
+
+	return 0;
+}
+
+static int store_cfg(void)
+{
+	struct bt_mesh_cfg_srv *cfg = bt_mesh_cfg_get();
+	struct cfg_val val;
+
+	if (!bt_mesh_is_provisioned() || !cfg) {
+		return store_rec(CFG_REC, "bt_mesh/Cfg", NULL, 0);
+	}
+
+	val.net_transmit = cfg->net_transmit;
+	val.relay = cfg->relay;
+	val.relay_retransmit = cfg->relay_retransmit;
+	val.beacon = cfg->beacon;
+	val.gatt_proxy = cfg->gatt_proxy;
+	val.frnd = cfg->frnd;
+	val.default_ttl = cfg->default_ttl;
+
+	return store_rec(CFG_REC, "bt_mesh/Cfg", &val, sizeof(val));
+}
+
+static int store_rpl(int idx)
+{
+	struct bt_mesh_rpl *rpl = &bt_mesh.rpl[idx];
+	char name[NAME_MAX_LEN];
+	struct rpl_val val;
+
+	snprintf(name, sizeof(name), "bt_mesh/RPL/%d", idx);
+
+	if (!bt_mesh_is_provisioned() || !rpl->src) {
+		return store_rec(RPL_REC + idx, name, NULL, 0);
+	}
+
+	val.src = rpl->src;
+	val.old_iv = rpl->old_iv;
+	val.seq[0] = rpl->seq >> 16;
+	val.seq[1] = rpl->seq >> 8;
+	val.seq[2] = rpl->seq;
+
+	return store_rec(RPL_REC + idx, name, &val, sizeof(val));
+}
+
+static int store_net_key(int idx)
+{
+	struct bt_mesh_subnet *sub = &bt_mesh.sub[idx];
+	char name[NAME_MAX_LEN];
+	struct net_key_val val;
+
+	snprintf(name, sizeof(name), "bt_mesh/NetKey/%d", idx);
+
+	if (!bt_mesh_is_provisioned() || sub->net_idx == BT_MESH_KEY_UNUSED) {
+		return store_rec(NET_KEY_REC + idx, name, NULL, 0);
+	}
+
+	val.net_idx = sub->net_idx;
+	val.kr_flag = sub->kr_flag;
+	val.kr_phase = sub->kr_phase;
+	memcpy(val.val[0], sub->keys[0].net, 16);
+	memcpy(val.val[1], sub->keys[1].net, 16);
+
+	return store_rec(NET_KEY_REC + idx, name, &val, sizeof(val));
+}
+
+static int store_app_key(int idx)
+{
+	struct bt_mesh_app_key *key = &bt_mesh.app_keys[idx];
+	char name[NAME_MAX_LEN];
+	struct app_key_val val;
+
+	snprintf(name, sizeof(name), "bt_mesh/AppKey/%d", idx);
+
+	if (!bt_mesh_is_provisioned() || key->net_idx == BT_MESH_KEY_UNUSED) {
+		return store_rec(APP_KEY_REC + idx, name, NULL, 0);
+	}
+
+	val.net_idx = key->net_idx;
+	val.app_idx = key->app_idx;
+	val.updated = key->updated;
+	memcpy(val.val[0], key->keys[0].val, 16);
+	memcpy(val.val[1], key->keys[1].val, 16);
+
+	return store_rec(APP_KEY_REC + idx, name, &val, sizeof(val));
+}
+
+static int store_label(int idx)
+{
+	struct label *lbl = bt_mesh_label_get(idx);
+	char name[NAME_MAX_LEN];
+	struct label_val val;
+
+	snprintf(name, sizeof(name), "bt_mesh/Label/%d", idx);
+
+	if (!bt_mesh_is_provisioned() || !lbl->ref) {
+		return store_rec(LABEL_REC + idx, name, NULL, 0);
+	}
+
+	val.ref = lbl->ref;
+	val.addr = lbl->addr;
+	memcpy(val.uuid, lbl->uuid, 16);
+
+	return store_rec(LABEL_REC + idx, name, &val, sizeof(val));
+}
+
+struct mod_store {
+	int idx;
+	int err;
+};
+
+static void store_mod(struct bt_mesh_model *mod, struct bt_mesh_elem *elem,
+		      bool vnd, bool primary, void *user_data)
+{
+	struct mod_store *store = user_data;
+	char name[NAME_MAX_LEN];
+	struct mod_val val;
+	int idx = store->idx++;
+	int err;
+
+	if (!(mod->flags & MOD_STORE_PENDING) || store->err) {
+		return;
+	}
+
+	snprintf(name, sizeof(name), "bt_mesh/Mod/%d", idx);
+
+	if (!bt_mesh_is_provisioned() || mod_is_default(mod)) {
+		if (!(mod->flags & MOD_STORED)) {
+			mod->flags &= ~MOD_STORE_PENDING;
+			return;
+		}
+
+		err = save_val(name, NULL, 0);
+		if (!err) {
+			mod->flags &= ~MOD_STORED;
+		}
+	} else {
+		memset(&val, 0, sizeof(val));
+		val.company = vnd ? mod->vnd.company : CID_NVAL;
+		val.id = vnd ? mod->vnd.id : mod->id;
+		memcpy(val.keys, mod->keys, sizeof(val.keys));
+		memcpy(val.groups, mod->groups, sizeof(val.groups));
+
+		if (mod->pub) {
+			val.pub_addr = mod->pub->addr;
+			val.pub_key = mod->pub->key;
+			val.pub_ttl = mod->pub->ttl;
+			val.pub_retransmit = mod->pub->retransmit;
+			val.pub_period = mod->pub->period;
+			val.pub_cred = mod->pub->cred;
+		} else {
+			val.pub_addr = BT_MESH_ADDR_UNASSIGNED;
+		}
+
+		err = save_val(name, &val, sizeof(val));
+		if (!err) {
+			mod->flags |= MOD_STORED;
+		}
+	}
+
+	if (err) {
+		store->err = err;
+	} else {
+		mod->flags &= ~MOD_STORE_PENDING;
+	}
+}
+
+/* Writes all pending records. Records which fail to be written remain
+ * pending.
+ */
+static int store_flush(void)
+{
+	struct mod_store mod_store;
+	int (*store)(void);
+	int err;
+	int i;
+
+	for (i = 0; i < REC_NUM; i++) {
+		if (!atomic_test_and_clear_bit(pending, i)) {
+			continue;
+		}
+
+		switch (i) {
+		case NET_REC:
+			store = store_net;
+			break;
+		case IV_REC:
+			store = store_iv;
+			break;
+		case SEQ_REC:
+			store = store_seq;
+			break;
+		case CFG_REC:
+			store = store_cfg;
+			break;
+		case MOD_REC:
+			mod_store.idx = 0;
+			mod_store.err = 0;
+			bt_mesh_model_foreach(store_mod, &mod_store);
+			err = mod_store.err;
+			goto check;
+		default:
+			store = NULL;
+			break;
+		}
+
+		if (store) {
+			err = store();
+		} else if (i < NET_KEY_REC) {
+			err = store_rpl(i - RPL_REC);
+		} else if (i < APP_KEY_REC) {
+			err = store_net_key(i - NET_KEY_REC);
+		} else if (i < LABEL_REC) {
+			err = store_app_key(i - APP_KEY_REC);
+		} else {
+			err = store_label(i - LABEL_REC);
+		}
+
+check:
+		if (err) {
+			atomic_set_bit(pending, i);
+			return err;
+		}
+	}
+
+	return 0;
+}
+
+static void store_pending(struct ble_npl_event *work)
+{
+	BT_DBG("");
+
+	if (store_flush()) {
+		/* Try again later; the records remain pending */
+		k_delayed_work_submit(&pending_store, STORE_TIMEOUT);
+	}
+}
+
+static void schedule_store(int rec, u32_t timeout)
+{
+	atomic_set_bit(pending, rec);
+
+	/* Don't push back a pending store; this bounds the time a change can
+	 * remain unsaved.
+	 */
+	if (ble_npl_callout_is_active(&pending_store.work) &&
+	    k_delayed_work_remaining_get(&pending_store) <= timeout) {
+		return;
+	}
+
+	k_delayed_work_submit(&pending_store, timeout);
+}
+
+void bt_mesh_store_net(void)
+{
+	schedule_store(NET_REC, STORE_TIMEOUT);
+}
+
+void bt_mesh_store_iv(void)
+{
+	/* The sequence number starts over with a new IV Index. The IV Index
+	 * goes first, so that it can never be restored with a stale sequence
+	 * number.
+	 */
+	atomic_set_bit(pending, IV_REC);
+	atomic_set_bit(pending, SEQ_REC);
+
+	k_delayed_work_cancel(&pending_store);
+	store_pending(NULL);
+}
+
+void bt_mesh_store_seq(void)
+{
+	if (bt_mesh.seq > seq_reserved) {
+		/* The number just taken is not covered by storage yet; it
+		 * has to be before the message goes out.
+		 */
+		atomic_clear_bit(pending, SEQ_REC);
+		if (store_seq()) {
+			atomic_set_bit(pending, SEQ_REC);
+		}
+
+		return;
+	}
+
+	/* Reserve the next block well before it is needed */
+	if (seq_reserved - bt_mesh.seq < SEQ_STORE_RATE / 2 &&
+	    !atomic_test_bit(pending, SEQ_REC)) {
+		schedule_store(SEQ_REC, STORE_TIMEOUT);
+	}
+}
+
+void bt_mesh_store_rpl(struct bt_mesh_rpl *rpl)
+{
+	schedule_store(RPL_REC + (rpl - bt_mesh.rpl), RPL_STORE_TIMEOUT);
+}
+
+void bt_mesh_store_rpl_all(void)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(bt_mesh.rpl); i++) {
+		atomic_set_bit(pending, RPL_REC + i);
+	}
+
+	schedule_store(RPL_REC, RPL_STORE_TIMEOUT);
+}
+
+void bt_mesh_store_subnet(struct bt_mesh_subnet *sub)
+{
+	schedule_store(NET_KEY_REC + (sub - bt_mesh.sub), STORE_TIMEOUT);
+}
+
+void bt_mesh_store_app_key(struct bt_mesh_app_key *key)
+{
+	schedule_store(APP_KEY_REC + (key - bt_mesh.app_keys), STORE_TIMEOUT);
+}
+
+void bt_mesh_store_label(u16_t idx)
+{
+	schedule_store(LABEL_REC + idx, STORE_TIMEOUT);
+}
+
+void bt_mesh_store_cfg(void)
+{
+	schedule_store(CFG_REC, STORE_TIMEOUT);
+}
+
+void bt_mesh_store_mod(struct bt_mesh_model *mod)
+{
+	mod->flags |= MOD_STORE_PENDING;
+	schedule_store(MOD_REC, STORE_TIMEOUT);
+}
+
+static void mod_clear(struct bt_mesh_model *mod, struct bt_mesh_elem *elem,
+		      bool vnd, bool primary, void *user_data)
+{
+	if (mod->flags & MOD_STORED) {
+		mod->flags |= MOD_STORE_PENDING;
+	}
+}
+
+void bt_mesh_clear_all(void)
+{
+	int i;
+
+	BT_DBG("");
+
+	/* With the node unprovisioned, writing out a record deletes it */
+	for (i = 0; i < REC_NUM; i++) {
+		if (atomic_test_bit(stored, i)) {
+			atomic_set_bit(pending, i);
+		}
+	}
+
+	bt_mesh_model_foreach(mod_clear, NULL);
+	atomic_set_bit(pending, MOD_REC);
+
+	seq_reserved = 0;
+
+	k_delayed_work_cancel(&pending_store);
+	store_pending(NULL);
+}
+
+void bt_mesh_settings_init(void)
+{
+	int err;
+
+	k_delayed_work_init(&pending_store, store_pending);
+
+	err = conf_register(&bt_mesh_conf_handler);
+	if (err) {
+		BT_ERR("Failed to register settings handler (err %d)", err);
+	}
+}
+
+#endif /* MYNEWT_VAL(BLE_MESH_SETTINGS) */
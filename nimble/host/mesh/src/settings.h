@@ -0,0 +1,48 @@
+/*  Bluetooth Mesh */
+
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef __SETTINGS_H__
+#define __SETTINGS_H__
+
+#include "mesh/mesh.h"
+#include "net.h"
+
+#if MYNEWT_VAL(BLE_MESH_SETTINGS)
+/* Records are written out after BLE_MESH_STORE_TIMEOUT (or, for the RPL,
+ * BLE_MESH_RPL_STORE_TIMEOUT) so that bursts of changes end up in a single
+ * write. The IV Index is written through immediately and takes all other
+ * pending records with it.
+ */
+void bt_mesh_store_net(void);
+void bt_mesh_store_iv(void);
+void bt_mesh_store_seq(void);
+void bt_mesh_store_rpl(struct bt_mesh_rpl *rpl);
+void bt_mesh_store_rpl_all(void);
+void bt_mesh_store_subnet(struct bt_mesh_subnet *sub);
+void bt_mesh_store_app_key(struct bt_mesh_app_key *key);
+void bt_mesh_store_label(u16_t idx);
+void bt_mesh_store_cfg(void);
+void bt_mesh_store_mod(struct bt_mesh_model *mod);
+
+/* Removes the whole node state from storage */
+void bt_mesh_clear_all(void);
+
+void bt_mesh_settings_init(void);
+#else
+static inline void bt_mesh_store_net(void) {}
+static inline void bt_mesh_store_iv(void) {}
+static inline void bt_mesh_store_seq(void) {}
+static inline void bt_mesh_store_rpl(struct bt_mesh_rpl *rpl) {}
+static inline void bt_mesh_store_rpl_all(void) {}
+static inline void bt_mesh_store_subnet(struct bt_mesh_subnet *sub) {}
+static inline void bt_mesh_store_app_key(struct bt_mesh_app_key *key) {}
+static inline void bt_mesh_store_label(u16_t idx) {}
+static inline void bt_mesh_store_cfg(void) {}
+static inline void bt_mesh_store_mod(struct bt_mesh_model *mod) {}
+static inline void bt_mesh_clear_all(void) {}
+static inline void bt_mesh_settings_init(void) {}
+#endif
+
+#endif
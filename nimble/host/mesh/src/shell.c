@@ -25,6 +25,7 @@
 
 /* Private includes for raw Network & Transport layer access */
 #include "net.h"
+#include "crypto.h"
 #include "access.h"
 #include "mesh_priv.h"
 #if MYNEWT_VAL(BLE_MESH_SHELL_MODELS)
@@ -798,6 +799,175 @@ static int cmd_rpl_clear(int argc, char *argv[])
 	return 0;
 }
 
+/* Unsegmented Access message with a 32-bit NetMIC */
+static void bench_pdu_init(struct os_mbuf *pdu, u8_t nid)
+{
+	static const u8_t payload[11] = { 0 };
+
+	net_buf_simple_init(pdu, 0);
+	net_buf_simple_add_u8(pdu, nid);
+	net_buf_simple_add_u8(pdu, BT_MESH_TTL_DEFAULT);
+	net_buf_simple_add_u8(pdu, 0x00);
+	net_buf_simple_add_be16(pdu, 0x0001);
+	net_buf_simple_add_be16(pdu, 0x0001);
+	net_buf_simple_add_be16(pdu, 0xc000);
+	net_buf_simple_add_mem(pdu, payload, sizeof(payload));
+}
+
+static int cmd_crypto_bench(int argc, char *argv[])
+{
+	struct ble_aes_key enc, priv;
+	struct os_mbuf *pdu = NET_BUF_SIMPLE(29);
+	struct os_mbuf *buf = NET_BUF_SIMPLE(29);
+	u8_t enc_key[16], priv_key[16];
+	u8_t p[] = { 0 };
+	u32_t count = 1000;
+	u32_t start, elapsed, i;
+	u8_t nid;
+	int err;
+
+	if (argc > 1) {
+		count = strtoul(argv[1], NULL, 0);
+	}
+
+	err = bt_mesh_k2(default_key, p, sizeof(p), &nid, enc_key, priv_key);
+	if (err) {
+		printk("Unable to derive keys (err %d)\n", err);
+		goto done;
+	}
+
+	ble_aes_set_key(&enc, enc_key);
+	ble_aes_set_key(&priv, priv_key);
+
+	bench_pdu_init(pdu, nid);
+
+	err = bt_mesh_net_encrypt(&enc, pdu, 0, false);
+	if (!err) {
+		err = bt_mesh_net_obfuscate(pdu->om_data, 0, &priv);
+	}
+
+	if (err) {
+		printk("Unable to encrypt PDU (err %d)\n", err);
+		goto done;
+	}
+
+	start = k_uptime_get_32();
+
+	for (i = 0; i < count; i++) {
+		net_buf_simple_init(buf, 0);
+		net_buf_simple_add_mem(buf, pdu->om_data, pdu->om_len);
+
+		err = bt_mesh_net_obfuscate(buf->om_data, 0, &priv);
+		if (!err) {
+			err = bt_mesh_net_decrypt(&enc, buf, 0, false);
+		}
+
+		if (err) {
+			printk("Decrypt failed (err %d)\n", err);
+			goto done;
+		}
+	}
+
+	elapsed = k_uptime_get_32() - start;
+
+	printk("AES backend: %s\n", ble_aes_backend_name(ble_aes_backend()));
+	printk("%lu network PDUs decrypted in %lu ms\n",
+	       (unsigned long)count, (unsigned long)elapsed);
+	if (elapsed) {
+		printk("%lu decrypts/s\n",
+		       (unsigned long)((u64_t)count * 1000 / elapsed));
+	}
+
+done:
+	os_mbuf_free_chain(buf);
+	os_mbuf_free_chain(pdu);
+	return 0;
+}
+
+struct shell_cmd_help cmd_crypto_bench_help = {
+	NULL, "[count]", NULL
+};
+
+static void relay_bench_print(const char *path, u32_t count, u32_t elapsed)
+{
+	printk("%lu PDUs relayed %s in %lu ms\n", (unsigned long)count, path,
+	       (unsigned long)elapsed);
+	if (elapsed) {
+		printk("%lu relays/s\n",
+		       (unsigned long)((u64_t)count * 1000 / elapsed));
+	}
+}
+
+static int cmd_relay_bench(int argc, char *argv[])
+{
+	static struct bt_mesh_subnet sub;
+	struct os_mbuf *sbuf = NET_BUF_SIMPLE(29);
+	struct os_mbuf *data = NET_BUF_SIMPLE(29);
+	struct bt_mesh_net_rx rx = { .sub = &sub };
+	u32_t count = 1000;
+	u32_t elapsed;
+	int err;
+
+	if (argc > 1) {
+		count = strtoul(argv[1], NULL, 0);
+	}
+
+	err = bt_mesh_net_keys_create(&sub.keys[0], default_key);
+	if (err) {
+		printk("Unable to derive keys (err %d)\n", err);
+		goto done;
+	}
+
+	/* The decrypted PDU as kept for relaying, and the one received */
+	bench_pdu_init(sbuf, sub.keys[0].nid);
+	net_buf_simple_init(data, 0);
+	net_buf_simple_add_mem(data, sbuf->om_data, sbuf->om_len);
+
+	err = bt_mesh_net_encrypt(&sub.keys[0].enc_sched, data, 0, false);
+	if (!err) {
+		err = bt_mesh_net_obfuscate(data->om_data, 0,
+					    &sub.keys[0].privacy_sched);
+	}
+
+	if (err) {
+		printk("Unable to encrypt PDU (err %d)\n", err);
+		goto done;
+	}
+
+	rx.ctx.recv_ttl = BT_MESH_TTL_DEFAULT;
+
+	printk("AES backend: %s\n", ble_aes_backend_name(ble_aes_backend()));
+
+	/* Received over advertising: TTL decremented, so re-encrypted */
+	rx.net_if = BT_MESH_NET_IF_ADV;
+	err = bt_mesh_net_relay_bench(&rx, sbuf, data, count, &elapsed);
+	if (err) {
+		printk("Relay failed (err %d)\n", err);
+		goto done;
+	}
+
+	relay_bench_print("re-encrypted", count, elapsed);
+
+	/* Locally originated: sent out as received */
+	rx.net_if = BT_MESH_NET_IF_LOCAL;
+	err = bt_mesh_net_relay_bench(&rx, sbuf, data, count, &elapsed);
+	if (err) {
+		printk("Relay failed (err %d)\n", err);
+		goto done;
+	}
+
+	relay_bench_print("verbatim", count, elapsed);
+
+done:
+	os_mbuf_free_chain(data);
+	os_mbuf_free_chain(sbuf);
+	return 0;
+}
+
+struct shell_cmd_help cmd_relay_bench_help = {
+	NULL, "[count]", NULL
+};
+
 #if MYNEWT_VAL(BLE_MESH_LOW_POWER)
 static int cmd_lpn_subscribe(int argc, char *argv[])
 {
@@ -2403,6 +2573,8 @@ static const struct shell_cmd mesh_commands[] = {
 	{ "iv-update", cmd_iv_update, NULL },
 	{ "iv-update-test", cmd_iv_update_test, &cmd_iv_update_test_help },
 	{ "rpl-clear", cmd_rpl_clear, NULL },
+	{ "crypto-bench", cmd_crypto_bench, &cmd_crypto_bench_help },
+	{ "relay-bench", cmd_relay_bench, &cmd_relay_bench_help },
 #if MYNEWT_VAL(BLE_MESH_LOW_POWER)
 	{ "lpn-subscribe", cmd_lpn_subscribe, &cmd_lpn_subscribe_help },
 	{ "lpn-unsubscribe", cmd_lpn_unsubscribe, &cmd_lpn_unsubscribe_help },
@@ -91,9 +91,7 @@ void bt_test_mesh_trans_incomp_timer_exp(void)
 void bt_test_print_credentials(void)
 {
 	int i;
-	u8_t nid;
-	const u8_t *enc;
-	const u8_t *priv;
+	const struct friend_cred_keys *cred;
 	struct bt_mesh_subnet *sub;
 	struct bt_mesh_app_key *app_key;
 
@@ -140,18 +138,18 @@ void bt_test_print_credentials(void)
 		}
 
 		if (friend_cred_get(&bt_mesh.sub[i], BT_MESH_ADDR_UNASSIGNED,
-				&nid, &enc, &priv)) {
+				&cred)) {
 			return;
 		}
 
 		console_printf("Friend cred: %d\n", i);
 		console_printf("\tNetKeyIdx: %04x\n",
 			       bt_mesh.sub[i].net_idx);
-		console_printf("\tNID: %02x\n", nid);
+		console_printf("\tNID: %02x\n", cred->nid);
 		console_printf("\tEncKey: %s\n",
-			       bt_hex(enc, 16));
+			       bt_hex(cred->enc, 16));
 		console_printf("\tPrivKey: %s\n",
-			       bt_hex(priv, 16));
+			       bt_hex(cred->privacy, 16));
 	}
 }
 
@@ -26,6 +26,7 @@
 #include "foundation.h"
 #include "transport.h"
 #include "testing.h"
+#include "settings.h"
 
 #define AID_MASK                    ((u8_t)(BIT_MASK(6)))
 
@@ -44,7 +45,7 @@
 #define SEQ_AUTH(iv_index, seq)     (((u64_t)iv_index) << 24 | (u64_t)seq)
 
 /* Number of retransmit attempts (after the initial transmit) per segment */
-#define SEG_RETRANSMIT_ATTEMPTS     4
+#define SEG_RETRANSMIT_ATTEMPTS     MYNEWT_VAL(BLE_MESH_SEG_RETRANSMIT_ATTEMPTS)
 
 /* "This timer shall be set to a minimum of 200 + 50 * TTL milliseconds.".
  * We use 400 since 300 is a common send duration for standard HCI, and we
@@ -52,6 +53,14 @@
  */
 #define SEG_RETRANSMIT_TIMEOUT(tx) (K_MSEC(400) + 50 * (tx)->ttl)
 
+/* Bounds of the retransmit timeout once it is derived from the measured
+ * round-trip times of a destination, and of its back-off.
+ */
+#define SEG_RETRANSMIT_MIN(tx)     (K_MSEC(200) + 50 * (tx)->ttl)
+#define SEG_RETRANSMIT_MAX(tx)     (4 * SEG_RETRANSMIT_TIMEOUT(tx))
+
+#define SEG_RTT_COUNT               MYNEWT_VAL(BLE_MESH_SEG_RTT_COUNT)
+
 /* How long to wait for available buffers before giving up */
 #define BUF_TIMEOUT                 K_NO_WAIT
 
@@ -61,14 +70,44 @@ static struct seg_tx {
 	u64_t                    seq_auth;
 	u16_t                    dst;
 	u8_t                     seg_n:5,       /* Last segment index */
-				 new_key:1;     /* New/old key */
+				 new_key:1,     /* New/old key */
+				 blocked:1,     /* Waiting for an earlier SDU */
+				 resent:1;      /* Segments were resent */
 	u8_t                     nack_count;    /* Number of unacked segs */
 	u8_t                     ttl;
+	u8_t                     in_flight;     /* Segments being sent */
+	u32_t                    sent;          /* Last time a seg was sent */
+	s32_t                    timeout;       /* Retransmit timeout */
+	struct bt_mesh_msg_ctx   ctx;
+	struct bt_mesh_net_tx    net_tx;
 	const struct bt_mesh_send_cb *cb;
 	void                    *cb_data;
+	struct seg_tx           *next;          /* Next in the hash bucket */
 	struct k_delayed_work    retransmit; /* Retransmit timer */
 } seg_tx[MYNEWT_VAL(BLE_MESH_TX_SEG_MSG_COUNT)];
 
+/* Outgoing SDUs in progress, hashed by SeqZero */
+static struct seg_tx *seg_tx_hash[ARRAY_SIZE(seg_tx)];
+
+static u8_t seg_tx_count;
+
+/* High-water marks of the RPL and of the segmentation contexts in use */
+static u16_t rpl_hw;
+static u8_t seg_tx_hw;
+static u8_t seg_rx_hw;
+
+#if SEG_RTT_COUNT > 0
+/* Smoothed round-trip times between sending segments and receiving their
+ * acknowledgment, per destination.
+ */
+static struct seg_rtt {
+	u16_t addr;
+	u16_t srtt;
+	u16_t rttvar;
+	u32_t used;
+} seg_rtt[SEG_RTT_COUNT];
+#endif
+
 static struct seg_rx {
 	struct bt_mesh_subnet   *sub;
 	u64_t                    seq_auth;
@@ -82,12 +121,18 @@ static struct seg_rx {
 	u16_t                    dst;
 	u32_t                    block;
 	u32_t                    last;
+	struct seg_rx           *next;
 	struct k_delayed_work    ack;
 	struct os_mbuf    *buf;
 } seg_rx[MYNEWT_VAL(BLE_MESH_RX_SEG_MSG_COUNT)] = {
 	[0 ... (MYNEWT_VAL(BLE_MESH_RX_SEG_MSG_COUNT) - 1)] = { 0 },
 };
 
+/* Incoming SDUs, hashed by source address and SeqZero. Contexts stay in the
+ * table after the SDU is complete, so that late segments can be acked.
+ */
+static struct seg_rx *seg_rx_hash[ARRAY_SIZE(seg_rx)];
+
 static u16_t hb_sub_dst = BT_MESH_ADDR_UNASSIGNED;
 
 void bt_mesh_set_hb_sub_dst(u16_t addr)
@@ -137,11 +182,39 @@ static int send_unseg(struct bt_mesh_net_tx *tx, struct os_mbuf *sdu,
 }
 
 bool bt_mesh_tx_in_progress(void)
+{
+	return seg_tx_count > 0;
+}
+
+static struct seg_tx **seg_tx_bucket(u16_t seq_zero)
+{
+	return &seg_tx_hash[seq_zero % ARRAY_SIZE(seg_tx_hash)];
+}
+
+static void seg_tx_unlink(struct seg_tx *tx)
+{
+	struct seg_tx **p;
+
+	for (p = seg_tx_bucket(tx->seq_auth & 0x1fff); *p; p = &(*p)->next) {
+		if (*p == tx) {
+			*p = tx->next;
+			break;
+		}
+	}
+
+	tx->next = NULL;
+}
+
+/* Checks if an SDU from src to dst is in progress, in which case a new one
+ * has to wait: the receiver only tracks one SDU per source and destination.
+ */
+static bool seg_tx_busy(u16_t src, u16_t dst)
 {
 	int i;
 
 	for (i = 0; i < ARRAY_SIZE(seg_tx); i++) {
-		if (seg_tx[i].nack_count) {
+		if (seg_tx[i].nack_count && seg_tx[i].net_tx.src == src &&
+		    seg_tx[i].ctx.addr == dst) {
 			return true;
 		}
 	}
@@ -149,21 +222,107 @@ bool bt_mesh_tx_in_progress(void)
 	return false;
 }
 
+#if SEG_RTT_COUNT > 0
+static struct seg_rtt *seg_rtt_find(u16_t addr)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(seg_rtt); i++) {
+		if (seg_rtt[i].addr == addr) {
+			return &seg_rtt[i];
+		}
+	}
+
+	return NULL;
+}
+#endif
+
+static s32_t seg_tx_timeout(struct seg_tx *tx)
+{
+#if SEG_RTT_COUNT > 0
+	struct seg_rtt *rtt;
+	s32_t to;
+
+	rtt = seg_rtt_find(tx->ctx.addr);
+	if (rtt) {
+		rtt->used = k_uptime_get_32();
+
+		to = K_MSEC(rtt->srtt + 4 * rtt->rttvar);
+		to = min(to, SEG_RETRANSMIT_MAX(tx));
+
+		return max(to, SEG_RETRANSMIT_MIN(tx));
+	}
+#endif
+
+	return SEG_RETRANSMIT_TIMEOUT(tx);
+}
+
+/* Updates the round-trip time estimate of the destination as in RFC 6298.
+ * No samples are taken once segments have been retransmitted, as it's not
+ * known which copy is being acknowledged.
+ */
+static void seg_tx_rtt_update(struct seg_tx *tx)
+{
+#if SEG_RTT_COUNT > 0
+	struct seg_rtt *rtt;
+	u32_t now = k_uptime_get_32();
+	u32_t r, delta;
+	int i;
+
+	if (tx->resent || tx->in_flight || !tx->sent ||
+	    !BT_MESH_ADDR_IS_UNICAST(tx->ctx.addr)) {
+		return;
+	}
+
+	r = min(now - tx->sent, UINT16_MAX);
+
+	rtt = seg_rtt_find(tx->ctx.addr);
+	if (!rtt) {
+		/* Replace the least recently used estimate */
+		rtt = &seg_rtt[0];
+		for (i = 1; i < ARRAY_SIZE(seg_rtt); i++) {
+			if ((s32_t)(seg_rtt[i].used - rtt->used) < 0) {
+				rtt = &seg_rtt[i];
+			}
+		}
+
+		rtt->addr = tx->ctx.addr;
+		rtt->srtt = r;
+		rtt->rttvar = r / 2;
+	} else {
+		delta = (r > rtt->srtt) ? r - rtt->srtt : rtt->srtt - r;
+		rtt->rttvar = (3 * rtt->rttvar + delta) / 4;
+		rtt->srtt = (7 * rtt->srtt + r) / 8;
+	}
+
+	rtt->used = now;
+
+	BT_DBG("dst 0x%04x rtt %u srtt %u rttvar %u", rtt->addr, r,
+	       rtt->srtt, rtt->rttvar);
+#endif
+}
+
 static void seg_tx_reset(struct seg_tx *tx)
 {
 	int i;
 
 	k_delayed_work_cancel(&tx->retransmit);
 
+	/* Not nack_count, which is zero once all segments are acked */
+	if (!tx->sub) {
+		return;
+	}
+
+	seg_tx_unlink(tx);
+	seg_tx_count--;
+
 	tx->cb = NULL;
 	tx->cb_data = NULL;
 	tx->seq_auth = 0;
 	tx->sub = NULL;
 	tx->dst = BT_MESH_ADDR_UNASSIGNED;
-
-	if (!tx->nack_count) {
-		return;
-	}
+	tx->blocked = 0;
+	tx->in_flight = 0;
 
 	for (i = 0; i <= tx->seg_n; i++) {
 		if (!tx->seg[i]) {
@@ -188,13 +347,23 @@ static void seg_tx_reset(struct seg_tx *tx)
 	}
 }
 
+static void seg_tx_unblock(u16_t src, u16_t dst);
+
 static inline void seg_tx_complete(struct seg_tx *tx, int err)
 {
+	u16_t src = tx->net_tx.src;
+	u16_t dst = tx->ctx.addr;
+
+	if (err) {
+		STATS_INC(ble_mesh_stats, seg_tx_fail);
+	}
+
 	if (tx->cb && tx->cb->end) {
 		tx->cb->end(err, tx->cb_data);
 	}
 
 	seg_tx_reset(tx);
+	seg_tx_unblock(src, dst);
 }
 
 static void seg_first_send_start(u16_t duration, int err, void *user_data)
@@ -215,8 +384,11 @@ static void seg_send_start(u16_t duration, int err, void *user_data)
 	 * case since otherwise we risk the transmission of becoming stale.
 	 */
 	if (err) {
-		k_delayed_work_submit(&tx->retransmit,
-				      SEG_RETRANSMIT_TIMEOUT(tx));
+		if (tx->in_flight) {
+			tx->in_flight--;
+		}
+
+		k_delayed_work_submit(&tx->retransmit, tx->timeout);
 	}
 }
 
@@ -224,8 +396,17 @@ static void seg_sent(int err, void *user_data)
 {
 	struct seg_tx *tx = user_data;
 
-	k_delayed_work_submit(&tx->retransmit,
-			      SEG_RETRANSMIT_TIMEOUT(tx));
+	if (!tx->nack_count) {
+		return;
+	}
+
+	if (tx->in_flight) {
+		tx->in_flight--;
+	}
+
+	tx->sent = k_uptime_get_32();
+
+	k_delayed_work_submit(&tx->retransmit, tx->timeout);
 }
 
 static const struct bt_mesh_send_cb first_sent_cb = {
@@ -262,6 +443,10 @@ static void seg_tx_send_unacked(struct seg_tx *tx)
 
 		BT_DBG("resending %u/%u", i, tx->seg_n);
 
+		tx->resent = 1;
+		tx->in_flight++;
+		STATS_INC(ble_mesh_stats, seg_retransmit);
+
 		err = bt_mesh_net_resend(tx->sub, seg, tx->new_key,
 					 &seg_sent_cb, tx);
 		if (err) {
@@ -275,16 +460,113 @@ static void seg_tx_send_unacked(struct seg_tx *tx)
 static void seg_retransmit(struct ble_npl_event *work)
 {
 	struct seg_tx *tx = ble_npl_event_get_arg(work);
+
+	/* Back off, the segments or the acks may be getting lost to
+	 * congestion.
+	 */
+	tx->timeout = min(2 * tx->timeout, SEG_RETRANSMIT_MAX(tx));
+
 	seg_tx_send_unacked(tx);
 }
 
+/* Sends all segments of the SDU for the first time */
+static int seg_tx_send(struct seg_tx *tx)
+{
+	bool friend_only = false;
+	int i, err;
+
+	tx->timeout = seg_tx_timeout(tx);
+
+	for (i = 0; i <= tx->seg_n; i++) {
+		struct os_mbuf *seg = tx->seg[i];
+
+		if (IS_ENABLED(CONFIG_BT_MESH_FRIEND)) {
+			enum bt_mesh_friend_pdu_type type;
+
+			if (i == tx->seg_n) {
+				type = BT_MESH_FRIEND_PDU_COMPLETE;
+			} else {
+				type = BT_MESH_FRIEND_PDU_PARTIAL;
+			}
+
+			if (bt_mesh_friend_enqueue_tx(&tx->net_tx, type,
+						      &tx->seq_auth, seg) &&
+			    BT_MESH_ADDR_IS_UNICAST(tx->ctx.addr)) {
+				/* PDUs for a specific Friend should only go
+				 * out through the Friend Queue.
+				 */
+				friend_only = true;
+				continue;
+			}
+		}
+
+		BT_DBG("Sending %u/%u", i, tx->seg_n);
+
+		tx->in_flight++;
+
+		err = bt_mesh_net_send(&tx->net_tx, net_buf_ref(seg),
+				       i ? &seg_sent_cb : &first_sent_cb, tx);
+		if (err) {
+			BT_ERR("Sending segment failed");
+			return err;
+		}
+	}
+
+	if (friend_only) {
+		/* The Friend Queue takes over, and Low Power nodes don't
+		 * send acks.
+		 */
+		seg_tx_complete(tx, 0);
+		return 0;
+	}
+
+	if (bt_mesh_lpn_established()) {
+		bt_mesh_lpn_poll();
+	}
+
+	return 0;
+}
+
+/* Starts the oldest SDU waiting for an earlier one from src to dst */
+static void seg_tx_unblock(u16_t src, u16_t dst)
+{
+	struct seg_tx *tx = NULL;
+	int i, err;
+
+	for (i = 0; i < ARRAY_SIZE(seg_tx); i++) {
+		if (!seg_tx[i].blocked || seg_tx[i].net_tx.src != src ||
+		    seg_tx[i].ctx.addr != dst) {
+			continue;
+		}
+
+		if (!tx || seg_tx[i].seq_auth < tx->seq_auth) {
+			tx = &seg_tx[i];
+		}
+	}
+
+	if (!tx) {
+		return;
+	}
+
+	BT_DBG("Unblocked SeqZero 0x%04x", (u16_t)(tx->seq_auth & 0x1fff));
+
+	tx->blocked = 0;
+
+	err = seg_tx_send(tx);
+	if (err) {
+		seg_tx_complete(tx, err);
+	}
+}
+
 static int send_seg(struct bt_mesh_net_tx *net_tx, struct os_mbuf *sdu,
 		    const struct bt_mesh_send_cb *cb, void *cb_data)
 {
+	struct seg_tx **bucket;
 	u8_t seg_hdr, seg_o;
 	u16_t seq_zero;
 	struct seg_tx *tx;
-	int i;
+	bool blocked;
+	int i, err;
 
 	BT_DBG("src 0x%04x dst 0x%04x app_idx 0x%04x aszmic %u sdu_len %u",
 	       net_tx->src, net_tx->ctx->addr, net_tx->ctx->app_idx,
@@ -301,7 +583,7 @@ static int send_seg(struct bt_mesh_net_tx *net_tx, struct os_mbuf *sdu,
 	}
 
 	for (tx = NULL, i = 0; i < ARRAY_SIZE(seg_tx); i++) {
-		if (!seg_tx[i].nack_count) {
+		if (!seg_tx[i].sub) {
 			tx = &seg_tx[i];
 			break;
 		}
@@ -318,13 +600,21 @@ static int send_seg(struct bt_mesh_net_tx *net_tx, struct os_mbuf *sdu,
 		seg_hdr = SEG_HDR(1, net_tx->aid);
 	}
 
-	seg_o = 0;
+	blocked = seg_tx_busy(net_tx->src, net_tx->ctx->addr);
+
+	tx->ctx = *net_tx->ctx;
+	tx->net_tx = *net_tx;
+	tx->net_tx.ctx = &tx->ctx;
 	tx->dst = net_tx->ctx->addr;
 	tx->seg_n = (sdu->om_len - 1) / 12;
 	tx->nack_count = tx->seg_n + 1;
 	tx->seq_auth = SEQ_AUTH(BT_MESH_NET_IVI_TX, bt_mesh.seq);
 	tx->sub = net_tx->sub;
 	tx->new_key = net_tx->sub->kr_flag;
+	tx->blocked = blocked;
+	tx->resent = 0;
+	tx->in_flight = 0;
+	tx->sent = 0;
 	tx->cb = cb;
 	tx->cb_data = cb_data;
 
@@ -336,12 +626,17 @@ static int send_seg(struct bt_mesh_net_tx *net_tx, struct os_mbuf *sdu,
 
 	seq_zero = tx->seq_auth & 0x1fff;
 
+	bucket = seg_tx_bucket(seq_zero);
+	tx->next = *bucket;
+	*bucket = tx;
+	seg_tx_count++;
+	BT_MESH_STATS_HW(seg_tx_hw, seg_tx_hw, seg_tx_count);
+
 	BT_DBG("SeqZero 0x%04x", seq_zero);
 
 	for (seg_o = 0; sdu->om_len; seg_o++) {
 		struct os_mbuf *seg;
 		u16_t len;
-		int err;
 
 		seg = bt_mesh_adv_create(BT_MESH_ADV_DATA,
 					 BT_MESH_TRANSMIT_COUNT(net_tx->xmit),
@@ -367,43 +662,22 @@ static int send_seg(struct bt_mesh_net_tx *net_tx, struct os_mbuf *sdu,
 		net_buf_add_mem(seg, sdu->om_data, len);
 		net_buf_simple_pull(sdu, len);
 
-		tx->seg[seg_o] = net_buf_ref(seg);
-
-		if (IS_ENABLED(CONFIG_BT_MESH_FRIEND)) {
-			enum bt_mesh_friend_pdu_type type;
-
-			if (seg_o == tx->seg_n) {
-				type = BT_MESH_FRIEND_PDU_COMPLETE;
-			} else {
-				type = BT_MESH_FRIEND_PDU_PARTIAL;
-			}
-
-			if (bt_mesh_friend_enqueue_tx(net_tx, type,
-						      &tx->seq_auth,
-						      seg) &&
-			    BT_MESH_ADDR_IS_UNICAST(net_tx->ctx->addr)) {
-				/* PDUs for a specific Friend should only go
-				 * out through the Friend Queue.
-				 */
-				net_buf_unref(seg);
-				return 0;
-			}
-		}
-
-		BT_DBG("Sending %u/%u", seg_o, tx->seg_n);
+		tx->seg[seg_o] = seg;
+	}
 
-		err = bt_mesh_net_send(net_tx, seg,
-				       seg_o ? &seg_sent_cb : &first_sent_cb,
-				       tx);
-		if (err) {
-			BT_ERR("Sending segment failed");
-			seg_tx_reset(tx);
-			return err;
-		}
+	if (blocked) {
+		/* The SDU was encrypted with the current sequence number, so
+		 * it must not be used by anything else while waiting.
+		 */
+		BT_DBG("Waiting for the previous SDU to 0x%04x", tx->dst);
+		bt_mesh_next_seq();
+		return 0;
 	}
 
-	if (bt_mesh_lpn_established()) {
-		bt_mesh_lpn_poll();
+	err = seg_tx_send(tx);
+	if (err) {
+		seg_tx_reset(tx);
+		return err;
 	}
 
 	return 0;
@@ -428,7 +702,7 @@ struct bt_mesh_app_key *bt_mesh_app_key_find(u16_t app_idx)
 int bt_mesh_trans_send(struct bt_mesh_net_tx *tx, struct os_mbuf *msg,
 		       const struct bt_mesh_send_cb *cb, void *cb_data)
 {
-	const u8_t *key;
+	const struct ble_aes_key *key;
 	u8_t *ad;
 	int err;
 
@@ -446,7 +720,7 @@ int bt_mesh_trans_send(struct bt_mesh_net_tx *tx, struct os_mbuf *msg,
 	BT_DBG("len %u: %s", msg->om_len, bt_hex(msg->om_data, msg->om_len));
 
 	if (tx->ctx->app_idx == BT_MESH_KEY_DEV) {
-		key = bt_mesh.dev_key;
+		key = &bt_mesh.dev_key_sched;
 		tx->aid = 0;
 	} else {
 		struct bt_mesh_app_key *app_key;
@@ -458,10 +732,10 @@ int bt_mesh_trans_send(struct bt_mesh_net_tx *tx, struct os_mbuf *msg,
 
 		if (tx->sub->kr_phase == BT_MESH_KR_PHASE_2 &&
 		    app_key->updated) {
-			key = app_key->keys[1].val;
+			key = &app_key->keys[1].sched;
 			tx->aid = app_key->keys[1].id;
 		} else {
-			key = app_key->keys[0].val;
+			key = &app_key->keys[0].sched;
 			tx->aid = app_key->keys[0].id;
 		}
 	}
@@ -526,12 +800,15 @@ static bool is_replay(struct bt_mesh_net_rx *rx)
 			rpl->src = rx->ctx.addr;
 			rpl->seq = rx->seq;
 			rpl->old_iv = rx->old_iv;
+			bt_mesh_store_rpl(rpl);
+			BT_MESH_STATS_HW(rpl_hw, rpl_hw, i + 1);
 			return false;
 		}
 
 		/* Existing slot for given address */
 		if (rpl->src == rx->ctx.addr) {
 			if (rx->old_iv && !rpl->old_iv) {
+				STATS_INC(ble_mesh_stats, replay);
 				return true;
 			}
 
@@ -539,8 +816,10 @@ static bool is_replay(struct bt_mesh_net_rx *rx)
 			    rpl->seq < rx->seq) {
 				rpl->seq = rx->seq;
 				rpl->old_iv = rx->old_iv;
+				bt_mesh_store_rpl(rpl);
 				return false;
 			} else {
+				STATS_INC(ble_mesh_stats, replay);
 				return true;
 			}
 		}
@@ -584,7 +863,7 @@ static int sdu_recv(struct bt_mesh_net_rx *rx, u8_t hdr, u8_t aszmic,
 
 	if (!AKF(&hdr)) {
 		net_buf_simple_init(sdu, 0);
-		err = bt_mesh_app_decrypt(bt_mesh.dev_key, true, aszmic, buf,
+		err = bt_mesh_app_decrypt(&bt_mesh.dev_key_sched, true, aszmic, buf,
 					  sdu, ad, rx->ctx.addr, rx->dst,
 					  rx->seq, BT_MESH_NET_IVI_RX(rx));
 		if (err) {
@@ -619,7 +898,7 @@ static int sdu_recv(struct bt_mesh_net_rx *rx, u8_t hdr, u8_t aszmic,
 		}
 
 		net_buf_simple_init(sdu, 0);
-		err = bt_mesh_app_decrypt(keys->val, false, aszmic, buf,
+		err = bt_mesh_app_decrypt(&keys->sched, false, aszmic, buf,
 					  sdu, ad, rx->ctx.addr, rx->dst,
 					  rx->seq, BT_MESH_NET_IVI_RX(rx));
 		if (err) {
@@ -645,12 +924,9 @@ done:
 static struct seg_tx *seg_tx_lookup(u16_t seq_zero, u8_t obo, u16_t addr)
 {
 	struct seg_tx *tx;
-	int i;
 
-	for (i = 0; i < ARRAY_SIZE(seg_tx); i++) {
-		tx = &seg_tx[i];
-
-		if ((tx->seq_auth & 0x1fff) != seq_zero) {
+	for (tx = *seg_tx_bucket(seq_zero); tx; tx = tx->next) {
+		if ((tx->seq_auth & 0x1fff) != seq_zero || tx->blocked) {
 			continue;
 		}
 
@@ -722,6 +998,8 @@ static int trans_ack(struct bt_mesh_net_rx *rx, u8_t hdr,
 
 	k_delayed_work_cancel(&tx->retransmit);
 
+	seg_tx_rtt_update(tx);
+
 	while ((bit = find_lsb_set(ack))) {
 		if (tx->seg[bit - 1]) {
 			BT_DBG("seg %u/%u acked", bit - 1, tx->seg_n);
@@ -974,6 +1252,29 @@ static int send_ack(struct bt_mesh_subnet *sub, u16_t src, u16_t dst,
 				NULL, NULL, NULL);
 }
 
+static struct seg_rx **seg_rx_bucket(u16_t src, u16_t seq_zero)
+{
+	u32_t key = (u32_t)src << 13 | seq_zero;
+
+	return &seg_rx_hash[((key * 0x9e3779b1) >> 16) %
+			    ARRAY_SIZE(seg_rx_hash)];
+}
+
+static void seg_rx_unlink(struct seg_rx *rx)
+{
+	struct seg_rx **p;
+
+	for (p = seg_rx_bucket(rx->src, rx->seq_auth & 0x1fff); *p;
+	     p = &(*p)->next) {
+		if (*p == rx) {
+			*p = rx->next;
+			break;
+		}
+	}
+
+	rx->next = NULL;
+}
+
 static void seg_rx_reset(struct seg_rx *rx, bool full_reset)
 {
 	BT_DBG("rx %p", rx);
@@ -994,6 +1295,10 @@ static void seg_rx_reset(struct seg_rx *rx, bool full_reset)
 	 * the full SDU.
 	 */
 	if (full_reset) {
+		if (rx->src != BT_MESH_ADDR_UNASSIGNED) {
+			seg_rx_unlink(rx);
+		}
+
 		rx->seq_auth = 0;
 		rx->sub = NULL;
 		rx->src = BT_MESH_ADDR_UNASSIGNED;
@@ -1041,10 +1346,22 @@ static inline bool sdu_len_is_ok(bool ctl, u8_t seg_n)
 static struct seg_rx *seg_rx_find(struct bt_mesh_net_rx *net_rx,
 				  const u64_t *seq_auth)
 {
+	struct seg_rx *rx;
 	int i;
 
+	for (rx = *seg_rx_bucket(net_rx->ctx.addr, *seq_auth & 0x1fff); rx;
+	     rx = rx->next) {
+		if (rx->src == net_rx->ctx.addr && rx->dst == net_rx->dst &&
+		    rx->seq_auth == *seq_auth) {
+			return rx;
+		}
+	}
+
+	/* Not a segment of a known SDU, look for other SDUs between the same
+	 * addresses.
+	 */
 	for (i = 0; i < ARRAY_SIZE(seg_rx); i++) {
-		struct seg_rx *rx = &seg_rx[i];
+		rx = &seg_rx[i];
 
 		if (rx->src != net_rx->ctx.addr || rx->dst != net_rx->dst) {
 			continue;
@@ -1095,10 +1412,23 @@ static bool seg_rx_is_valid(struct seg_rx *rx, struct bt_mesh_net_rx *net_rx,
 	return true;
 }
 
+static u8_t seg_rx_in_use(void)
+{
+	u8_t count = 0;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(seg_rx); i++) {
+		count += seg_rx[i].in_use;
+	}
+
+	return count;
+}
+
 static struct seg_rx *seg_rx_alloc(struct bt_mesh_net_rx *net_rx,
 				   const u8_t *hdr, const u64_t *seq_auth,
 				   u8_t seg_n)
 {
+	struct seg_rx **bucket;
 	int i;
 
 	for (i = 0; i < ARRAY_SIZE(seg_rx); i++) {
@@ -1108,6 +1438,10 @@ static struct seg_rx *seg_rx_alloc(struct bt_mesh_net_rx *net_rx,
 			continue;
 		}
 
+		if (rx->src != BT_MESH_ADDR_UNASSIGNED) {
+			seg_rx_unlink(rx);
+		}
+
 		rx->in_use = 1;
 		net_buf_simple_init(rx->buf, 0);
 		rx->sub = net_rx->sub;
@@ -1120,6 +1454,12 @@ static struct seg_rx *seg_rx_alloc(struct bt_mesh_net_rx *net_rx,
 		rx->dst = net_rx->dst;
 		rx->block = 0;
 
+		bucket = seg_rx_bucket(rx->src, *seq_auth & 0x1fff);
+		rx->next = *bucket;
+		*bucket = rx;
+
+		BT_MESH_STATS_HW(seg_rx_hw, seg_rx_hw, seg_rx_in_use());
+
 		BT_DBG("New RX context. Block Complete 0x%08x",
 		       BLOCK_COMPLETE(seg_n));
 
@@ -1408,6 +1748,10 @@ void bt_mesh_tx_reset(void)
 	for (i = 0; i < ARRAY_SIZE(seg_tx); i++) {
 		seg_tx_reset(&seg_tx[i]);
 	}
+
+#if SEG_RTT_COUNT > 0
+	memset(seg_rtt, 0, sizeof(seg_rtt));
+#endif
 }
 
 void bt_mesh_trans_init(void)
@@ -1433,4 +1777,5 @@ void bt_mesh_rpl_clear(void)
 {
 	BT_DBG("");
 	memset(bt_mesh.rpl, 0, sizeof(bt_mesh.rpl));
+	bt_mesh_store_rpl_all();
 }
@@ -41,6 +41,14 @@ static const struct ble_gatt_svc_def ble_svc_gatt_defs[] = {
             .access_cb = ble_svc_gatt_access,
             .val_handle = &ble_svc_gatt_changed_val_handle,
             .flags = BLE_GATT_CHR_F_INDICATE,
+        }, {
+            .uuid = BLE_UUID16_DECLARE(BLE_GATT_CHR_CLT_SUP_FEAT_UUID16),
+            .access_cb = ble_svc_gatt_access,
+            .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE,
+        }, {
+            .uuid = BLE_UUID16_DECLARE(BLE_GATT_CHR_SRV_SUP_FEAT_UUID16),
+            .access_cb = ble_svc_gatt_access,
+            .flags = BLE_GATT_CHR_F_READ,
         }, {
             0, /* No more characteristics in this service. */
         } },
@@ -52,8 +60,7 @@ static const struct ble_gatt_svc_def ble_svc_gatt_defs[] = {
 };
 
 static int
-ble_svc_gatt_access(uint16_t conn_handle, uint16_t attr_handle,
-                    struct ble_gatt_access_ctxt *ctxt, void *arg)
+ble_svc_gatt_changed_access(struct ble_gatt_access_ctxt *ctxt)
 {
     uint8_t *u8p;
 
@@ -64,7 +71,6 @@ ble_svc_gatt_access(uint16_t conn_handle, uint16_t attr_handle,
      * read the characteristic.
      */
     assert(ctxt->op == BLE_GATT_ACCESS_OP_READ_CHR);
-    assert(ctxt->chr == &ble_svc_gatt_defs[0].characteristics[0]);
 
     u8p = os_mbuf_extend(ctxt->om, 4);
     if (u8p == NULL) {
@@ -77,6 +83,78 @@ ble_svc_gatt_access(uint16_t conn_handle, uint16_t attr_handle,
     return 0;
 }
 
+static int
+ble_svc_gatt_clt_sup_feat_access(uint16_t conn_handle,
+                                 struct ble_gatt_access_ctxt *ctxt)
+{
+    uint8_t feat;
+    int rc;
+
+    switch (ctxt->op) {
+    case BLE_GATT_ACCESS_OP_READ_CHR:
+        rc = ble_gatts_clt_sup_feat(conn_handle, &feat);
+        if (rc != 0) {
+            return BLE_ATT_ERR_UNLIKELY;
+        }
+
+        rc = os_mbuf_append(ctxt->om, &feat, sizeof feat);
+        return rc == 0 ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+
+    case BLE_GATT_ACCESS_OP_WRITE_CHR:
+        /* Only the first octet holds defined features. */
+        if (os_mbuf_copydata(ctxt->om, 0, sizeof feat, &feat) != 0) {
+            return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+        }
+
+        rc = ble_gatts_clt_sup_feat_set(conn_handle, feat);
+        switch (rc) {
+        case 0:
+            return 0;
+        case BLE_HS_EINVAL:
+            return BLE_ATT_ERR_VALUE_NOT_ALLOWED;
+        default:
+            return BLE_ATT_ERR_UNLIKELY;
+        }
+
+    default:
+        assert(0);
+        return BLE_ATT_ERR_UNLIKELY;
+    }
+}
+
+static int
+ble_svc_gatt_srv_sup_feat_access(struct ble_gatt_access_ctxt *ctxt)
+{
+    uint8_t feat;
+    int rc;
+
+    assert(ctxt->op == BLE_GATT_ACCESS_OP_READ_CHR);
+
+    feat = ble_gatts_srv_sup_feat();
+    rc = os_mbuf_append(ctxt->om, &feat, sizeof feat);
+    return rc == 0 ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+}
+
+static int
+ble_svc_gatt_access(uint16_t conn_handle, uint16_t attr_handle,
+                    struct ble_gatt_access_ctxt *ctxt, void *arg)
+{
+    switch (ble_uuid_u16(ctxt->chr->uuid)) {
+    case BLE_SVC_GATT_CHR_SERVICE_CHANGED_UUID16:
+        return ble_svc_gatt_changed_access(ctxt);
+
+    case BLE_GATT_CHR_CLT_SUP_FEAT_UUID16:
+        return ble_svc_gatt_clt_sup_feat_access(conn_handle, ctxt);
+
+    case BLE_GATT_CHR_SRV_SUP_FEAT_UUID16:
+        return ble_svc_gatt_srv_sup_feat_access(ctxt);
+
+    default:
+        assert(0);
+        return BLE_ATT_ERR_UNLIKELY;
+    }
+}
+
 /**
  * Indicates a change in attribute assignment to all subscribed peers.
  * Unconnected bonded peers receive an indication when they next connect.
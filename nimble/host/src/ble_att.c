@@ -24,7 +24,8 @@
 static uint16_t ble_att_preferred_mtu_val;
 
 /** Dispatch table for incoming ATT requests.  Sorted by op code. */
-typedef int ble_att_rx_fn(uint16_t conn_handle, struct os_mbuf **om);
+typedef int ble_att_rx_fn(uint16_t conn_handle, uint16_t cid,
+                          struct os_mbuf **om);
 struct ble_att_rx_dispatch_entry {
     uint8_t bde_op;
     ble_att_rx_fn *bde_fn;
@@ -142,12 +143,17 @@ ble_att_rx_dispatch_entry_find(uint8_t op)
     return NULL;
 }
 
+/**
+ * Looks up the channel of the specified ATT bearer.  The cid is
+ * BLE_L2CAP_CID_ATT for the unenhanced bearer, or the source CID of an
+ * enhanced (EATT) bearer.
+ */
 int
-ble_att_conn_chan_find(uint16_t conn_handle, struct ble_hs_conn **out_conn,
+ble_att_conn_chan_find(uint16_t conn_handle, uint16_t cid,
+                       struct ble_hs_conn **out_conn,
                        struct ble_l2cap_chan **out_chan)
 {
-    return ble_hs_misc_conn_chan_find(conn_handle, BLE_L2CAP_CID_ATT,
-                                      out_conn, out_chan);
+    return ble_hs_misc_conn_chan_find(conn_handle, cid, out_conn, out_chan);
 }
 
 void
@@ -400,6 +406,12 @@ ble_att_truncate_to_mtu(const struct ble_l2cap_chan *att_chan,
 
 uint16_t
 ble_att_mtu(uint16_t conn_handle)
+{
+    return ble_att_mtu_by_cid(conn_handle, BLE_L2CAP_CID_ATT);
+}
+
+uint16_t
+ble_att_mtu_by_cid(uint16_t conn_handle, uint16_t cid)
 {
     struct ble_l2cap_chan *chan;
     struct ble_hs_conn *conn;
@@ -408,7 +420,7 @@ ble_att_mtu(uint16_t conn_handle)
 
     ble_hs_lock();
 
-    rc = ble_att_conn_chan_find(conn_handle, &conn, &chan);
+    rc = ble_att_conn_chan_find(conn_handle, cid, &conn, &chan);
     if (rc == 0) {
         mtu = ble_att_chan_mtu(chan);
     } else {
@@ -435,6 +447,15 @@ ble_att_chan_mtu(const struct ble_l2cap_chan *chan)
 {
     uint16_t mtu;
 
+#if MYNEWT_VAL(BLE_EATT_CHAN_NUM) > 0
+    /* The MTU of an enhanced bearer is the lesser of the SDU sizes configured
+     * on channel establishment; there is no MTU exchange.
+     */
+    if (chan->scid != BLE_L2CAP_CID_ATT) {
+        return min(chan->coc_rx.mtu, chan->coc_tx.mtu);
+    }
+#endif
+
     /* If either side has not exchanged MTU size, use the default.  Otherwise,
      * use the lesser of the two exchanged values.
      */
@@ -453,7 +474,7 @@ ble_att_chan_mtu(const struct ble_l2cap_chan *chan)
 
 static void
 ble_att_rx_handle_unknown_request(uint8_t op, uint16_t conn_handle,
-                                  struct os_mbuf **om)
+                                  uint16_t cid, struct os_mbuf **om)
 {
     /* If this is command (bit6 is set to 1), do nothing */
     if (op & 0x40) {
@@ -461,27 +482,23 @@ ble_att_rx_handle_unknown_request(uint8_t op, uint16_t conn_handle,
     }
 
     os_mbuf_adj(*om, OS_MBUF_PKTLEN(*om));
-    ble_att_svr_tx_error_rsp(conn_handle, *om, op, 0,
+    ble_att_svr_tx_error_rsp(conn_handle, cid, *om, op, 0,
                              BLE_ATT_ERR_REQ_NOT_SUPPORTED);
 
     *om = NULL;
 }
 
-static int
-ble_att_rx(struct ble_l2cap_chan *chan)
+/**
+ * Processes an ATT PDU received on the specified bearer.  The mbuf may be
+ * consumed; any remainder is freed by the caller.
+ */
+int
+ble_att_rx_pdu(uint16_t conn_handle, uint16_t cid, struct os_mbuf **om)
 {
     const struct ble_att_rx_dispatch_entry *entry;
     uint8_t op;
-    uint16_t conn_handle;
-    struct os_mbuf **om;
     int rc;
 
-    conn_handle = ble_l2cap_get_conn_handle(chan);
-    if (conn_handle == BLE_HS_CONN_HANDLE_NONE) {
-        return BLE_HS_ENOTCONN;
-    }
-
-    om = &chan->rx_buf;
     BLE_HS_DBG_ASSERT(*om != NULL);
 
     rc = os_mbuf_copydata(*om, 0, 1, &op);
@@ -491,7 +508,7 @@ ble_att_rx(struct ble_l2cap_chan *chan)
 
     entry = ble_att_rx_dispatch_entry_find(op);
     if (entry == NULL) {
-        ble_att_rx_handle_unknown_request(op, conn_handle, om);
+        ble_att_rx_handle_unknown_request(op, conn_handle, cid, om);
         return BLE_HS_ENOTSUP;
     }
 
@@ -500,10 +517,10 @@ ble_att_rx(struct ble_l2cap_chan *chan)
     /* Strip L2CAP ATT header from the front of the mbuf. */
     os_mbuf_adj(*om, 1);
 
-    rc = entry->bde_fn(conn_handle, om);
+    rc = entry->bde_fn(conn_handle, cid, om);
     if (rc != 0) {
         if (rc == BLE_HS_ENOTSUP) {
-            ble_att_rx_handle_unknown_request(op, conn_handle, om);
+            ble_att_rx_handle_unknown_request(op, conn_handle, cid, om);
         }
         return rc;
     }
@@ -511,6 +528,19 @@ ble_att_rx(struct ble_l2cap_chan *chan)
     return 0;
 }
 
+static int
+ble_att_rx(struct ble_l2cap_chan *chan)
+{
+    uint16_t conn_handle;
+
+    conn_handle = ble_l2cap_get_conn_handle(chan);
+    if (conn_handle == BLE_HS_CONN_HANDLE_NONE) {
+        return BLE_HS_ENOTCONN;
+    }
+
+    return ble_att_rx_pdu(conn_handle, BLE_L2CAP_CID_ATT, &chan->rx_buf);
+}
+
 uint16_t
 ble_att_preferred_mtu(void)
 {
@@ -31,7 +31,7 @@
  *****************************************************************************/
 
 int
-ble_att_clt_rx_error(uint16_t conn_handle, struct os_mbuf **rxom)
+ble_att_clt_rx_error(uint16_t conn_handle, uint16_t cid, struct os_mbuf **rxom)
 {
     struct ble_att_error_rsp *rsp;
     int rc;
@@ -45,7 +45,7 @@ ble_att_clt_rx_error(uint16_t conn_handle, struct os_mbuf **rxom)
 
     BLE_ATT_LOG_CMD(0, "error rsp", conn_handle, ble_att_error_rsp_log, rsp);
 
-    ble_gattc_rx_err(conn_handle, le16toh(rsp->baep_handle),
+    ble_gattc_rx_err(conn_handle, cid, le16toh(rsp->baep_handle),
                      le16toh(rsp->baep_error_code));
 
     return 0;
@@ -70,7 +70,7 @@ ble_att_clt_tx_mtu(uint16_t conn_handle, uint16_t mtu)
 
     ble_hs_lock();
 
-    rc = ble_att_conn_chan_find(conn_handle, &conn, &chan);
+    rc = ble_att_conn_chan_find(conn_handle, BLE_L2CAP_CID_ATT, &conn, &chan);
     if (rc != 0) {
         rc = BLE_HS_ENOTCONN;
     } else if (chan->flags & BLE_L2CAP_CHAN_F_TXED_MTU) {
@@ -91,7 +91,7 @@ ble_att_clt_tx_mtu(uint16_t conn_handle, uint16_t mtu)
 
     req->bamc_mtu = htole16(mtu);
 
-    rc = ble_att_tx(conn_handle, txom);
+    rc = ble_att_tx(conn_handle, BLE_L2CAP_CID_ATT, txom);
     if (rc != 0) {
         return rc;
     }
@@ -100,7 +100,7 @@ ble_att_clt_tx_mtu(uint16_t conn_handle, uint16_t mtu)
 
     ble_hs_lock();
 
-    rc = ble_att_conn_chan_find(conn_handle, &conn, &chan);
+    rc = ble_att_conn_chan_find(conn_handle, BLE_L2CAP_CID_ATT, &conn, &chan);
     if (rc == 0) {
         chan->flags |= BLE_L2CAP_CHAN_F_TXED_MTU;
     }
@@ -111,13 +111,18 @@ ble_att_clt_tx_mtu(uint16_t conn_handle, uint16_t mtu)
 }
 
 int
-ble_att_clt_rx_mtu(uint16_t conn_handle, struct os_mbuf **rxom)
+ble_att_clt_rx_mtu(uint16_t conn_handle, uint16_t cid, struct os_mbuf **rxom)
 {
     struct ble_att_mtu_cmd *cmd;
     struct ble_l2cap_chan *chan;
     uint16_t mtu;
     int rc;
 
+    /* MTU exchange is only allowed on the unenhanced ATT bearer. */
+    if (cid != BLE_L2CAP_CID_ATT) {
+        return BLE_HS_EINVAL;
+    }
+
     mtu = 0;
 
     rc = ble_hs_mbuf_pullup_base(rxom, sizeof(*cmd));
@@ -128,7 +133,8 @@ ble_att_clt_rx_mtu(uint16_t conn_handle, struct os_mbuf **rxom)
 
         ble_hs_lock();
 
-        rc = ble_att_conn_chan_find(conn_handle, NULL, &chan);
+        rc = ble_att_conn_chan_find(conn_handle, BLE_L2CAP_CID_ATT, NULL,
+                                    &chan);
         if (rc == 0) {
             ble_att_set_peer_mtu(chan, le16toh(cmd->bamc_mtu));
             mtu = ble_att_chan_mtu(chan);
@@ -141,7 +147,7 @@ ble_att_clt_rx_mtu(uint16_t conn_handle, struct os_mbuf **rxom)
         }
     }
 
-    ble_gattc_rx_mtu(conn_handle, rc, mtu);
+    ble_gattc_rx_mtu(conn_handle, cid, rc, mtu);
     return rc;
 }
 
@@ -150,8 +156,8 @@ ble_att_clt_rx_mtu(uint16_t conn_handle, struct os_mbuf **rxom)
  *****************************************************************************/
 
 int
-ble_att_clt_tx_find_info(uint16_t conn_handle, uint16_t start_handle,
-                         uint16_t end_handle)
+ble_att_clt_tx_find_info(uint16_t conn_handle, uint16_t cid,
+                         uint16_t start_handle, uint16_t end_handle)
 {
 #if !NIMBLE_BLE_ATT_CLT_FIND_INFO
     return BLE_HS_ENOTSUP;
@@ -175,7 +181,7 @@ ble_att_clt_tx_find_info(uint16_t conn_handle, uint16_t start_handle,
     BLE_ATT_LOG_CMD(1, "find info req", conn_handle,
                     ble_att_find_info_req_log, req);
 
-    return ble_att_tx(conn_handle, txom);
+    return ble_att_tx(conn_handle, cid, txom);
 }
 
 static int
@@ -230,7 +236,8 @@ ble_att_clt_parse_find_info_entry(struct os_mbuf **rxom, uint8_t rsp_format,
 }
 
 int
-ble_att_clt_rx_find_info(uint16_t conn_handle, struct os_mbuf **om)
+ble_att_clt_rx_find_info(uint16_t conn_handle, uint16_t cid,
+                         struct os_mbuf **om)
 {
 #if !NIMBLE_BLE_ATT_CLT_FIND_INFO
     return BLE_HS_ENOTSUP;
@@ -260,14 +267,14 @@ ble_att_clt_rx_find_info(uint16_t conn_handle, struct os_mbuf **om)
         }
 
         /* Hand find-info entry to GATT. */
-        ble_gattc_rx_find_info_idata(conn_handle, &idata);
+        ble_gattc_rx_find_info_idata(conn_handle, cid, &idata);
     }
 
     rc = 0;
 
 done:
     /* Notify GATT that response processing is done. */
-    ble_gattc_rx_find_info_complete(conn_handle, rc);
+    ble_gattc_rx_find_info_complete(conn_handle, cid, rc);
     return rc;
 }
 
@@ -280,8 +287,9 @@ done:
  * anyway
  */
 int
-ble_att_clt_tx_find_type_value(uint16_t conn_handle, uint16_t start_handle,
-                               uint16_t end_handle, uint16_t attribute_type,
+ble_att_clt_tx_find_type_value(uint16_t conn_handle, uint16_t cid,
+                               uint16_t start_handle, uint16_t end_handle,
+                               uint16_t attribute_type,
                                const void *attribute_value, int value_len)
 {
 #if !NIMBLE_BLE_ATT_CLT_FIND_TYPE
@@ -309,7 +317,7 @@ ble_att_clt_tx_find_type_value(uint16_t conn_handle, uint16_t start_handle,
     BLE_ATT_LOG_CMD(1, "find type value req", conn_handle,
                     ble_att_find_type_value_req_log, req);
 
-    return ble_att_tx(conn_handle, txom);
+    return ble_att_tx(conn_handle, cid, txom);
 }
 
 static int
@@ -335,7 +343,8 @@ ble_att_clt_parse_find_type_value_hinfo(
 }
 
 int
-ble_att_clt_rx_find_type_value(uint16_t conn_handle, struct os_mbuf **rxom)
+ble_att_clt_rx_find_type_value(uint16_t conn_handle, uint16_t cid,
+                               struct os_mbuf **rxom)
 {
 #if !NIMBLE_BLE_ATT_CLT_FIND_TYPE
     return BLE_HS_ENOTSUP;
@@ -354,11 +363,11 @@ ble_att_clt_rx_find_type_value(uint16_t conn_handle, struct os_mbuf **rxom)
             break;
         }
 
-        ble_gattc_rx_find_type_value_hinfo(conn_handle, &hinfo);
+        ble_gattc_rx_find_type_value_hinfo(conn_handle, cid, &hinfo);
     }
 
     /* Notify GATT client that the full response has been parsed. */
-    ble_gattc_rx_find_type_value_complete(conn_handle, rc);
+    ble_gattc_rx_find_type_value_complete(conn_handle, cid, rc);
 
     return 0;
 }
@@ -368,8 +377,9 @@ ble_att_clt_rx_find_type_value(uint16_t conn_handle, struct os_mbuf **rxom)
  *****************************************************************************/
 
 int
-ble_att_clt_tx_read_type(uint16_t conn_handle, uint16_t start_handle,
-                         uint16_t end_handle, const ble_uuid_t *uuid)
+ble_att_clt_tx_read_type(uint16_t conn_handle, uint16_t cid,
+                         uint16_t start_handle, uint16_t end_handle,
+                         const ble_uuid_t *uuid)
 {
 #if !NIMBLE_BLE_ATT_CLT_READ_TYPE
     return BLE_HS_ENOTSUP;
@@ -396,11 +406,12 @@ ble_att_clt_tx_read_type(uint16_t conn_handle, uint16_t start_handle,
     BLE_ATT_LOG_CMD(1, "read type req", conn_handle,
                     ble_att_read_type_req_log, req);
 
-    return ble_att_tx(conn_handle, txom);
+    return ble_att_tx(conn_handle, cid, txom);
 }
 
 int
-ble_att_clt_rx_read_type(uint16_t conn_handle, struct os_mbuf **rxom)
+ble_att_clt_rx_read_type(uint16_t conn_handle, uint16_t cid,
+                         struct os_mbuf **rxom)
 {
 #if !NIMBLE_BLE_ATT_CLT_READ_TYPE
     return BLE_HS_ENOTSUP;
@@ -445,13 +456,13 @@ ble_att_clt_rx_read_type(uint16_t conn_handle, struct os_mbuf **rxom)
         adata.value_len = data_len - sizeof(*data);
         adata.value = data->value;
 
-        ble_gattc_rx_read_type_adata(conn_handle, &adata);
+        ble_gattc_rx_read_type_adata(conn_handle, cid, &adata);
         os_mbuf_adj(*rxom, data_len);
     }
 
 done:
     /* Notify GATT that the response is done being parsed. */
-    ble_gattc_rx_read_type_complete(conn_handle, rc);
+    ble_gattc_rx_read_type_complete(conn_handle, cid, rc);
     return rc;
 
 }
@@ -461,7 +472,7 @@ done:
  *****************************************************************************/
 
 int
-ble_att_clt_tx_read(uint16_t conn_handle, uint16_t handle)
+ble_att_clt_tx_read(uint16_t conn_handle, uint16_t cid, uint16_t handle)
 {
 #if !NIMBLE_BLE_ATT_CLT_READ
     return BLE_HS_ENOTSUP;
@@ -482,7 +493,7 @@ ble_att_clt_tx_read(uint16_t conn_handle, uint16_t handle)
 
     req->barq_handle = htole16(handle);
 
-    rc = ble_att_tx(conn_handle, txom);
+    rc = ble_att_tx(conn_handle, cid, txom);
     if (rc != 0) {
         return rc;
     }
@@ -493,7 +504,7 @@ ble_att_clt_tx_read(uint16_t conn_handle, uint16_t handle)
 }
 
 int
-ble_att_clt_rx_read(uint16_t conn_handle, struct os_mbuf **rxom)
+ble_att_clt_rx_read(uint16_t conn_handle, uint16_t cid, struct os_mbuf **rxom)
 {
 #if !NIMBLE_BLE_ATT_CLT_READ
     return BLE_HS_ENOTSUP;
@@ -502,7 +513,7 @@ ble_att_clt_rx_read(uint16_t conn_handle, struct os_mbuf **rxom)
     BLE_ATT_LOG_EMPTY_CMD(0, "read rsp", conn_handle);
 
     /* Pass the Attribute Value field to GATT. */
-    ble_gattc_rx_read_rsp(conn_handle, 0, rxom);
+    ble_gattc_rx_read_rsp(conn_handle, cid, 0, rxom);
     return 0;
 }
 
@@ -511,7 +522,8 @@ ble_att_clt_rx_read(uint16_t conn_handle, struct os_mbuf **rxom)
  *****************************************************************************/
 
 int
-ble_att_clt_tx_read_blob(uint16_t conn_handle, uint16_t handle, uint16_t offset)
+ble_att_clt_tx_read_blob(uint16_t conn_handle, uint16_t cid, uint16_t handle,
+                         uint16_t offset)
 {
 #if !NIMBLE_BLE_ATT_CLT_READ_BLOB
     return BLE_HS_ENOTSUP;
@@ -533,7 +545,7 @@ ble_att_clt_tx_read_blob(uint16_t conn_handle, uint16_t handle, uint16_t offset)
     req->babq_handle = htole16(handle);
     req->babq_offset = htole16(offset);
 
-    rc = ble_att_tx(conn_handle, txom);
+    rc = ble_att_tx(conn_handle, cid, txom);
     if (rc != 0) {
         return rc;
     }
@@ -545,7 +557,8 @@ ble_att_clt_tx_read_blob(uint16_t conn_handle, uint16_t handle, uint16_t offset)
 }
 
 int
-ble_att_clt_rx_read_blob(uint16_t conn_handle, struct os_mbuf **rxom)
+ble_att_clt_rx_read_blob(uint16_t conn_handle, uint16_t cid,
+                         struct os_mbuf **rxom)
 {
 #if !NIMBLE_BLE_ATT_CLT_READ_BLOB
     return BLE_HS_ENOTSUP;
@@ -554,7 +567,7 @@ ble_att_clt_rx_read_blob(uint16_t conn_handle, struct os_mbuf **rxom)
     BLE_ATT_LOG_EMPTY_CMD(0, "read blob rsp", conn_handle);
 
     /* Pass the Attribute Value field to GATT. */
-    ble_gattc_rx_read_blob_rsp(conn_handle, 0, rxom);
+    ble_gattc_rx_read_blob_rsp(conn_handle, cid, 0, rxom);
     return 0;
 }
 
@@ -562,8 +575,8 @@ ble_att_clt_rx_read_blob(uint16_t conn_handle, struct os_mbuf **rxom)
  * $read multiple                                                            *
  *****************************************************************************/
 int
-ble_att_clt_tx_read_mult(uint16_t conn_handle, const uint16_t *handles,
-                         int num_handles)
+ble_att_clt_tx_read_mult(uint16_t conn_handle, uint16_t cid,
+                         const uint16_t *handles, int num_handles)
 {
 #if !NIMBLE_BLE_ATT_CLT_READ_MULT
     return BLE_HS_ENOTSUP;
@@ -590,11 +603,12 @@ ble_att_clt_tx_read_mult(uint16_t conn_handle, const uint16_t *handles,
         req->handles[i] = htole16(handles[i]);
     }
 
-    return ble_att_tx(conn_handle, txom);
+    return ble_att_tx(conn_handle, cid, txom);
 }
 
 int
-ble_att_clt_rx_read_mult(uint16_t conn_handle, struct os_mbuf **rxom)
+ble_att_clt_rx_read_mult(uint16_t conn_handle, uint16_t cid,
+                         struct os_mbuf **rxom)
 {
 #if !NIMBLE_BLE_ATT_CLT_READ_MULT
     return BLE_HS_ENOTSUP;
@@ -603,7 +617,7 @@ ble_att_clt_rx_read_mult(uint16_t conn_handle, struct os_mbuf **rxom)
     BLE_ATT_LOG_EMPTY_CMD(0, "read mult rsp", conn_handle);
 
     /* Pass the Attribute Value field to GATT. */
-    ble_gattc_rx_read_mult_rsp(conn_handle, 0, rxom);
+    ble_gattc_rx_read_mult_rsp(conn_handle, cid, 0, rxom);
     return 0;
 }
 
@@ -612,7 +626,7 @@ ble_att_clt_rx_read_mult(uint16_t conn_handle, struct os_mbuf **rxom)
  *****************************************************************************/
 
 int
-ble_att_clt_tx_read_group_type(uint16_t conn_handle,
+ble_att_clt_tx_read_group_type(uint16_t conn_handle, uint16_t cid,
                                uint16_t start_handle, uint16_t end_handle,
                                const ble_uuid_t *uuid)
 {
@@ -640,7 +654,7 @@ ble_att_clt_tx_read_group_type(uint16_t conn_handle,
     BLE_ATT_LOG_CMD(1, "read group type req", conn_handle,
                     ble_att_read_group_type_req_log, req);
 
-    return ble_att_tx(conn_handle, txom);
+    return ble_att_tx(conn_handle, cid, txom);
 }
 
 static int
@@ -668,7 +682,8 @@ ble_att_clt_parse_read_group_type_adata(
 }
 
 int
-ble_att_clt_rx_read_group_type(uint16_t conn_handle, struct os_mbuf **rxom)
+ble_att_clt_rx_read_group_type(uint16_t conn_handle, uint16_t cid,
+                               struct os_mbuf **rxom)
 {
 #if !NIMBLE_BLE_ATT_CLT_READ_GROUP_TYPE
     return BLE_HS_ENOTSUP;
@@ -701,13 +716,13 @@ ble_att_clt_rx_read_group_type(uint16_t conn_handle, struct os_mbuf **rxom)
             goto done;
         }
 
-        ble_gattc_rx_read_group_type_adata(conn_handle, &adata);
+        ble_gattc_rx_read_group_type_adata(conn_handle, cid, &adata);
         os_mbuf_adj(*rxom, len);
     }
 
 done:
     /* Notify GATT that the response is done being parsed. */
-    ble_gattc_rx_read_group_type_complete(conn_handle, rc);
+    ble_gattc_rx_read_group_type_complete(conn_handle, cid, rc);
     return rc;
 }
 
@@ -716,7 +731,7 @@ done:
  *****************************************************************************/
 
 int
-ble_att_clt_tx_write_req(uint16_t conn_handle, uint16_t handle,
+ble_att_clt_tx_write_req(uint16_t conn_handle, uint16_t cid, uint16_t handle,
                          struct os_mbuf *txom)
 {
 #if !NIMBLE_BLE_ATT_CLT_WRITE
@@ -737,7 +752,7 @@ ble_att_clt_tx_write_req(uint16_t conn_handle, uint16_t handle,
 
     BLE_ATT_LOG_CMD(1, "write req", conn_handle, ble_att_write_req_log, req);
 
-    return ble_att_tx(conn_handle, txom2);
+    return ble_att_tx(conn_handle, cid, txom2);
 }
 
 int
@@ -776,11 +791,11 @@ ble_att_clt_tx_write_cmd(uint16_t conn_handle, uint16_t handle,
 
     BLE_ATT_LOG_CMD(1, "write cmd", conn_handle, ble_att_write_cmd_log, cmd);
 
-    return ble_att_tx(conn_handle, txom2);
+    return ble_att_tx(conn_handle, BLE_L2CAP_CID_ATT, txom2);
 }
 
 int
-ble_att_clt_rx_write(uint16_t conn_handle, struct os_mbuf **rxom)
+ble_att_clt_rx_write(uint16_t conn_handle, uint16_t cid, struct os_mbuf **rxom)
 {
 #if !NIMBLE_BLE_ATT_CLT_WRITE
     return BLE_HS_ENOTSUP;
@@ -789,7 +804,7 @@ ble_att_clt_rx_write(uint16_t conn_handle, struct os_mbuf **rxom)
     BLE_ATT_LOG_EMPTY_CMD(0, "write rsp", conn_handle);
 
     /* No payload. */
-    ble_gattc_rx_write_rsp(conn_handle);
+    ble_gattc_rx_write_rsp(conn_handle, cid);
     return 0;
 }
 
@@ -798,7 +813,7 @@ ble_att_clt_rx_write(uint16_t conn_handle, struct os_mbuf **rxom)
  *****************************************************************************/
 
 int
-ble_att_clt_tx_prep_write(uint16_t conn_handle, uint16_t handle,
+ble_att_clt_tx_prep_write(uint16_t conn_handle, uint16_t cid, uint16_t handle,
                           uint16_t offset, struct os_mbuf *txom)
 {
 #if !NIMBLE_BLE_ATT_CLT_PREP_WRITE
@@ -838,7 +853,7 @@ ble_att_clt_tx_prep_write(uint16_t conn_handle, uint16_t handle,
     BLE_ATT_LOG_CMD(1, "prep write req", conn_handle,
                     ble_att_prep_write_cmd_log, req);
 
-    return ble_att_tx(conn_handle, txom2);
+    return ble_att_tx(conn_handle, cid, txom2);
 
 err:
     os_mbuf_free_chain(txom);
@@ -846,7 +861,8 @@ err:
 }
 
 int
-ble_att_clt_rx_prep_write(uint16_t conn_handle, struct os_mbuf **rxom)
+ble_att_clt_rx_prep_write(uint16_t conn_handle, uint16_t cid,
+                          struct os_mbuf **rxom)
 {
 #if !NIMBLE_BLE_ATT_CLT_PREP_WRITE
     return BLE_HS_ENOTSUP;
@@ -877,7 +893,7 @@ ble_att_clt_rx_prep_write(uint16_t conn_handle, struct os_mbuf **rxom)
 
 done:
     /* Notify GATT client that the full response has been parsed. */
-    ble_gattc_rx_prep_write_rsp(conn_handle, rc, handle, offset, rxom);
+    ble_gattc_rx_prep_write_rsp(conn_handle, cid, rc, handle, offset, rxom);
     return rc;
 }
 
@@ -886,7 +902,7 @@ done:
  *****************************************************************************/
 
 int
-ble_att_clt_tx_exec_write(uint16_t conn_handle, uint8_t flags)
+ble_att_clt_tx_exec_write(uint16_t conn_handle, uint16_t cid, uint8_t flags)
 {
 #if !NIMBLE_BLE_ATT_CLT_EXEC_WRITE
     return BLE_HS_ENOTSUP;
@@ -903,7 +919,7 @@ ble_att_clt_tx_exec_write(uint16_t conn_handle, uint8_t flags)
 
     req->baeq_flags = flags;
 
-    rc = ble_att_tx(conn_handle, txom);
+    rc = ble_att_tx(conn_handle, cid, txom);
     if (rc != 0) {
         return rc;
     }
@@ -915,7 +931,8 @@ ble_att_clt_tx_exec_write(uint16_t conn_handle, uint8_t flags)
 }
 
 int
-ble_att_clt_rx_exec_write(uint16_t conn_handle, struct os_mbuf **rxom)
+ble_att_clt_rx_exec_write(uint16_t conn_handle, uint16_t cid,
+                          struct os_mbuf **rxom)
 {
 #if !NIMBLE_BLE_ATT_CLT_EXEC_WRITE
     return BLE_HS_ENOTSUP;
@@ -923,7 +940,7 @@ ble_att_clt_rx_exec_write(uint16_t conn_handle, struct os_mbuf **rxom)
 
     BLE_ATT_LOG_EMPTY_CMD(0, "exec write rsp", conn_handle);
 
-    ble_gattc_rx_exec_write_rsp(conn_handle, 0);
+    ble_gattc_rx_exec_write_rsp(conn_handle, cid, 0);
     return 0;
 }
 
@@ -959,7 +976,7 @@ ble_att_clt_tx_notify(uint16_t conn_handle, uint16_t handle,
 
     BLE_ATT_LOG_CMD(1, "notify req", conn_handle, ble_att_notify_req_log, req);
 
-    return ble_att_tx(conn_handle, txom2);
+    return ble_att_tx(conn_handle, BLE_L2CAP_CID_ATT, txom2);
 
 err:
     os_mbuf_free_chain(txom);
@@ -999,7 +1016,7 @@ ble_att_clt_tx_indicate(uint16_t conn_handle, uint16_t handle,
     BLE_ATT_LOG_CMD(1, "indicate req", conn_handle, ble_att_indicate_req_log,
                     req);
 
-    return ble_att_tx(conn_handle, txom2);
+    return ble_att_tx(conn_handle, BLE_L2CAP_CID_ATT, txom2);
 
 err:
     os_mbuf_free_chain(txom);
@@ -1007,7 +1024,8 @@ err:
 }
 
 int
-ble_att_clt_rx_indicate(uint16_t conn_handle, struct os_mbuf **rxom)
+ble_att_clt_rx_indicate(uint16_t conn_handle, uint16_t cid,
+                        struct os_mbuf **rxom)
 {
 #if !NIMBLE_BLE_ATT_CLT_INDICATE
     return BLE_HS_ENOTSUP;
@@ -1016,6 +1034,6 @@ ble_att_clt_rx_indicate(uint16_t conn_handle, struct os_mbuf **rxom)
     BLE_ATT_LOG_EMPTY_CMD(0, "indicate rsp", conn_handle);
 
     /* No payload. */
-    ble_gattc_rx_indicate_rsp(conn_handle);
+    ble_gattc_rx_indicate_rsp(conn_handle, cid);
     return 0;
 }
@@ -54,8 +54,17 @@ ble_att_cmd_get(uint8_t opcode, size_t len, struct os_mbuf **txom)
     return ble_att_cmd_prepare(opcode, len, *txom);
 }
 
+/**
+ * Transmits an ATT PDU over the specified bearer.  The PDU is truncated to the
+ * MTU of the bearer.  The supplied mbuf is always consumed.
+ *
+ * @param conn_handle           The connection to send over.
+ * @param cid                   BLE_L2CAP_CID_ATT for the unenhanced bearer, or
+ *                                  the source CID of an enhanced bearer.
+ * @param txom                  The PDU to send, starting with the op code.
+ */
 int
-ble_att_tx(uint16_t conn_handle, struct os_mbuf *txom)
+ble_att_tx(uint16_t conn_handle, uint16_t cid, struct os_mbuf *txom)
 {
     struct ble_l2cap_chan *chan;
     struct ble_hs_conn *conn;
@@ -66,17 +75,30 @@ ble_att_tx(uint16_t conn_handle, struct os_mbuf *txom)
 
     ble_hs_lock();
 
-    ble_hs_misc_conn_chan_find_reqd(conn_handle, BLE_L2CAP_CID_ATT, &conn,
-                                    &chan);
+    if (cid == BLE_L2CAP_CID_ATT) {
+        ble_hs_misc_conn_chan_find_reqd(conn_handle, BLE_L2CAP_CID_ATT, &conn,
+                                        &chan);
+    } else {
+        ble_att_conn_chan_find(conn_handle, cid, &conn, &chan);
+    }
     if (chan == NULL) {
+        ble_hs_unlock();
         os_mbuf_free_chain(txom);
-        rc = BLE_HS_ENOTCONN;
-    } else {
-        ble_att_truncate_to_mtu(chan, txom);
-        rc = ble_l2cap_tx(conn, chan, txom);
+        return BLE_HS_ENOTCONN;
     }
 
-    ble_hs_unlock();
+    ble_att_truncate_to_mtu(chan, txom);
+
+    if (cid == BLE_L2CAP_CID_ATT) {
+        rc = ble_l2cap_tx(conn, chan, txom);
+        ble_hs_unlock();
+    } else {
+        /* Enhanced bearers are credit based channels; segmentation takes the
+         * lock itself.
+         */
+        ble_hs_unlock();
+        rc = ble_eatt_tx(chan, txom);
+    }
 
     return rc;
 }
@@ -460,7 +460,7 @@ void ble_att_indicate_req_log(const struct ble_att_indicate_req *cmd);
 
 void *ble_att_cmd_prepare(uint8_t opcode, size_t len, struct os_mbuf *txom);
 void *ble_att_cmd_get(uint8_t opcode, size_t len, struct os_mbuf **txom);
-int ble_att_tx(uint16_t conn_handle, struct os_mbuf *txom);
+int ble_att_tx(uint16_t conn_handle, uint16_t cid, struct os_mbuf *txom);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,567 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * Enhanced ATT bearers.
+ *
+ * Each bearer is an LE credit based channel on the EATT PSM, carrying ATT
+ * PDUs as SDUs.  Once the link is encrypted, the central reads the Server
+ * Supported Features of the peer and, if the peer supports EATT, opens
+ * BLE_EATT_CHAN_NUM bearers, one at a time; the peripheral accepts up to the
+ * same number.
+ * The GATT client spreads its procedures over the bearers; the unenhanced
+ * bearer keeps carrying the MTU exchange, notifications and indications.
+ *
+ * L2CAP may report a channel as disconnected while the host lock is held, so
+ * a closed bearer is only flagged in the callback; it is released, and the
+ * GATT client procedures waiting on it are failed, from the host task.
+ */
+
+#include <string.h>
+#include "nimble/ble.h"
+#include "ble_hs_priv.h"
+
+#if MYNEWT_VAL(BLE_EATT_CHAN_NUM) > 0
+
+#if MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM) == 0
+#error "BLE_EATT_CHAN_NUM requires BLE_L2CAP_COC_MAX_NUM"
+#endif
+
+#if MYNEWT_VAL(BLE_EATT_MTU) < 64
+#error "BLE_EATT_MTU must be at least 64"
+#endif
+
+struct ble_eatt {
+    SLIST_ENTRY(ble_eatt) next;
+    uint16_t conn_handle;
+
+    /** Source CID of the channel; 0 until the channel is connected. */
+    uint16_t cid;
+    uint8_t closed;
+    struct ble_l2cap_chan *chan;
+
+    /** PDUs waiting for the channel to finish sending the previous one. */
+    STAILQ_HEAD(, os_mbuf_pkthdr) tx_q;
+};
+
+SLIST_HEAD(ble_eatt_list, ble_eatt);
+
+static struct ble_eatt_list ble_eatt_bearer_list;
+
+static os_membuf_t ble_eatt_mem[
+    OS_MEMPOOL_SIZE(MYNEWT_VAL(BLE_MAX_CONNECTIONS) *
+                    MYNEWT_VAL(BLE_EATT_CHAN_NUM),
+                    sizeof (struct ble_eatt))
+];
+
+static struct os_mempool ble_eatt_pool;
+
+static ble_npl_event_fn ble_eatt_closed_event_cb;
+
+static struct ble_npl_event ble_eatt_ev_closed;
+
+static ble_l2cap_event_fn ble_eatt_l2cap_event;
+
+/**
+ * Lock restrictions:
+ *     o Caller must lock ble_hs_mutex.
+ */
+static struct ble_eatt *
+ble_eatt_alloc(uint16_t conn_handle)
+{
+    struct ble_eatt *eatt;
+
+    eatt = os_memblock_get(&ble_eatt_pool);
+    if (eatt == NULL) {
+        return NULL;
+    }
+
+    memset(eatt, 0, sizeof *eatt);
+    eatt->conn_handle = conn_handle;
+    STAILQ_INIT(&eatt->tx_q);
+
+    SLIST_INSERT_HEAD(&ble_eatt_bearer_list, eatt, next);
+
+    return eatt;
+}
+
+/**
+ * Lock restrictions:
+ *     o Caller must lock ble_hs_mutex.
+ */
+static void
+ble_eatt_free(struct ble_eatt *eatt)
+{
+    struct os_mbuf_pkthdr *omp;
+    int rc;
+
+    SLIST_REMOVE(&ble_eatt_bearer_list, eatt, ble_eatt, next);
+
+    while ((omp = STAILQ_FIRST(&eatt->tx_q)) != NULL) {
+        STAILQ_REMOVE_HEAD(&eatt->tx_q, omp_next);
+        os_mbuf_free_chain(OS_MBUF_PKTHDR_TO_MBUF(omp));
+    }
+
+    rc = os_memblock_put(&ble_eatt_pool, eatt);
+    BLE_HS_DBG_ASSERT_EVAL(rc == 0);
+}
+
+/**
+ * Counts the bearers of the specified connection which are connected or
+ * being connected.
+ *
+ * Lock restrictions:
+ *     o Caller must lock ble_hs_mutex.
+ */
+static int
+ble_eatt_num(uint16_t conn_handle)
+{
+    struct ble_eatt *eatt;
+    int num;
+
+    num = 0;
+    SLIST_FOREACH(eatt, &ble_eatt_bearer_list, next) {
+        if (eatt->conn_handle == conn_handle && !eatt->closed) {
+            num++;
+        }
+    }
+
+    return num;
+}
+
+/**
+ * Flags the bearer as closed and schedules its release.  May be called with
+ * or without the host lock held.
+ */
+static void
+ble_eatt_close(struct ble_eatt *eatt)
+{
+    eatt->closed = 1;
+    ble_npl_eventq_put(ble_hs_evq_get(), &ble_eatt_ev_closed);
+}
+
+static void
+ble_eatt_closed_event_cb(struct ble_npl_event *ev)
+{
+    struct ble_eatt *eatt;
+    uint16_t conn_handle;
+    uint16_t cid;
+
+    while (1) {
+        ble_hs_lock();
+
+        SLIST_FOREACH(eatt, &ble_eatt_bearer_list, next) {
+            if (eatt->closed) {
+                break;
+            }
+        }
+
+        if (eatt != NULL) {
+            conn_handle = eatt->conn_handle;
+            cid = eatt->cid;
+            ble_eatt_free(eatt);
+        }
+
+        ble_hs_unlock();
+
+        if (eatt == NULL) {
+            return;
+        }
+
+        /* Requests sent over the bearer will never get a response. */
+        if (cid != 0) {
+            ble_gattc_bearer_closed(conn_handle, cid);
+        }
+    }
+}
+
+/**
+ * Initiates a single bearer to the peer.  Called by the central; further
+ * bearers are initiated as each one connects.
+ */
+static void
+ble_eatt_open(uint16_t conn_handle)
+{
+    struct ble_eatt *eatt;
+    struct os_mbuf *sdu;
+    int rc;
+
+    sdu = ble_hs_mbuf_bare_pkt();
+    if (sdu == NULL) {
+        return;
+    }
+
+    ble_hs_lock();
+    eatt = ble_eatt_alloc(conn_handle);
+    ble_hs_unlock();
+
+    if (eatt == NULL) {
+        os_mbuf_free_chain(sdu);
+        return;
+    }
+
+    rc = ble_l2cap_sig_coc_connect(conn_handle, BLE_EATT_PSM,
+                                   MYNEWT_VAL(BLE_EATT_MTU), sdu,
+                                   ble_eatt_l2cap_event, eatt);
+    if (rc != 0) {
+        BLE_HS_LOG(DEBUG, "eatt: connect failed; rc=%d\n", rc);
+
+        /* If the channel got allocated, it took the SDU with it. */
+        if (!eatt->closed) {
+            os_mbuf_free_chain(sdu);
+        }
+        ble_eatt_close(eatt);
+    }
+}
+
+static void
+ble_eatt_tx_drain(struct ble_eatt *eatt)
+{
+    struct os_mbuf_pkthdr *omp;
+    struct os_mbuf *om;
+    int rc;
+
+    while (1) {
+        ble_hs_lock();
+        omp = STAILQ_FIRST(&eatt->tx_q);
+        if (omp != NULL) {
+            STAILQ_REMOVE_HEAD(&eatt->tx_q, omp_next);
+        }
+        ble_hs_unlock();
+
+        if (omp == NULL) {
+            return;
+        }
+
+        om = OS_MBUF_PKTHDR_TO_MBUF(omp);
+        rc = ble_l2cap_coc_send(eatt->chan, om);
+        switch (rc) {
+        case 0:
+            break;
+
+        case BLE_HS_EBUSY:
+            ble_hs_lock();
+            STAILQ_INSERT_HEAD(&eatt->tx_q, omp, omp_next);
+            ble_hs_unlock();
+            return;
+
+        case BLE_HS_EBADDATA:
+            os_mbuf_free_chain(om);
+            break;
+
+        default:
+            /* Mbuf consumed by the channel. */
+            break;
+        }
+    }
+}
+
+static int
+ble_eatt_accept(uint16_t conn_handle, struct ble_l2cap_chan *chan)
+{
+    struct ble_hs_conn *conn;
+    struct ble_eatt *eatt;
+    struct os_mbuf *sdu;
+    int rc;
+
+    sdu = ble_hs_mbuf_bare_pkt();
+    if (sdu == NULL) {
+        return BLE_HS_ENOMEM;
+    }
+
+    ble_hs_lock();
+
+    conn = ble_hs_conn_find(conn_handle);
+    if (conn == NULL) {
+        rc = BLE_HS_ENOTCONN;
+    } else if (!conn->bhc_sec_state.encrypted) {
+        rc = BLE_HS_EENCRYPT;
+    } else if (ble_eatt_num(conn_handle) >= MYNEWT_VAL(BLE_EATT_CHAN_NUM)) {
+        rc = BLE_HS_ENOMEM;
+    } else {
+        eatt = ble_eatt_alloc(conn_handle);
+        if (eatt == NULL) {
+            rc = BLE_HS_ENOMEM;
+        } else {
+            eatt->chan = chan;
+            chan->cb_arg = eatt;
+            rc = 0;
+        }
+    }
+
+    ble_hs_unlock();
+
+    if (rc != 0) {
+        os_mbuf_free_chain(sdu);
+        return rc;
+    }
+
+    ble_l2cap_recv_ready(chan, sdu);
+
+    return 0;
+}
+
+static void
+ble_eatt_connected(struct ble_eatt *eatt, struct ble_l2cap_chan *chan)
+{
+    struct ble_hs_conn *conn;
+    int open_next;
+
+    ble_hs_lock();
+
+    eatt->chan = chan;
+    eatt->cid = chan->scid;
+
+    conn = ble_hs_conn_find(eatt->conn_handle);
+    open_next = conn != NULL && (conn->bhc_flags & BLE_HS_CONN_F_MASTER) &&
+                ble_eatt_num(eatt->conn_handle) <
+                MYNEWT_VAL(BLE_EATT_CHAN_NUM);
+
+    ble_hs_unlock();
+
+    if (open_next) {
+        ble_eatt_open(eatt->conn_handle);
+    }
+}
+
+static void
+ble_eatt_rx(struct ble_eatt *eatt, struct ble_l2cap_chan *chan,
+            struct os_mbuf *om)
+{
+    struct os_mbuf *sdu;
+
+    ble_att_rx_pdu(eatt->conn_handle, chan->scid, &om);
+    os_mbuf_free_chain(om);
+
+    /* The channel needs a fresh buffer before the peer can send again. */
+    sdu = ble_hs_mbuf_bare_pkt();
+    if (sdu == NULL) {
+        BLE_HS_LOG(ERROR, "eatt: no buffer for rx; disconnecting\n");
+        ble_l2cap_sig_disconnect(chan);
+        return;
+    }
+
+    ble_l2cap_recv_ready(chan, sdu);
+}
+
+static int
+ble_eatt_l2cap_event(struct ble_l2cap_event *event, void *arg)
+{
+    struct ble_eatt *eatt;
+
+    eatt = arg;
+
+    switch (event->type) {
+    case BLE_L2CAP_EVENT_COC_ACCEPT:
+        return ble_eatt_accept(event->accept.conn_handle, event->accept.chan);
+
+    case BLE_L2CAP_EVENT_COC_CONNECTED:
+        if (event->connect.status != 0) {
+            ble_eatt_close(eatt);
+        } else {
+            ble_eatt_connected(eatt, event->connect.chan);
+        }
+        return 0;
+
+    case BLE_L2CAP_EVENT_COC_DISCONNECTED:
+        if (eatt != NULL) {
+            ble_eatt_close(eatt);
+        }
+        return 0;
+
+    case BLE_L2CAP_EVENT_COC_DATA_RECEIVED:
+        ble_eatt_rx(eatt, event->receive.chan, event->receive.sdu_rx);
+        return 0;
+
+    case BLE_L2CAP_EVENT_COC_TX_UNSTALLED:
+        ble_eatt_tx_drain(eatt);
+        return 0;
+
+    default:
+        return 0;
+    }
+}
+
+/**
+ * Transmits an ATT PDU over an enhanced bearer.  If the bearer is still busy
+ * sending the previous PDU, the PDU is queued.  The supplied mbuf is always
+ * consumed.
+ */
+int
+ble_eatt_tx(struct ble_l2cap_chan *chan, struct os_mbuf *txom)
+{
+    struct ble_eatt *eatt;
+    int queued;
+    int rc;
+
+    eatt = chan->cb_arg;
+
+    ble_hs_lock();
+    queued = !STAILQ_EMPTY(&eatt->tx_q);
+    if (queued) {
+        STAILQ_INSERT_TAIL(&eatt->tx_q, OS_MBUF_PKTHDR(txom), omp_next);
+    }
+    ble_hs_unlock();
+
+    if (queued) {
+        return 0;
+    }
+
+    rc = ble_l2cap_coc_send(chan, txom);
+    switch (rc) {
+    case BLE_HS_EBUSY:
+        ble_hs_lock();
+        STAILQ_INSERT_TAIL(&eatt->tx_q, OS_MBUF_PKTHDR(txom), omp_next);
+        ble_hs_unlock();
+        return 0;
+
+    case BLE_HS_EBADDATA:
+        os_mbuf_free_chain(txom);
+        return rc;
+
+    default:
+        return rc;
+    }
+}
+
+/**
+ * Retrieves the source CIDs of the connected enhanced bearers of the specified
+ * connection.
+ *
+ * @param conn_handle           The connection to query.
+ * @param cids                  On success, the CIDs get written here.
+ * @param max_cids              The capacity of the cids array.
+ *
+ * @return                      The number of CIDs written.
+ */
+int
+ble_eatt_bearers(uint16_t conn_handle, uint16_t *cids, int max_cids)
+{
+    struct ble_eatt *eatt;
+    int num;
+
+    num = 0;
+
+    ble_hs_lock();
+
+    SLIST_FOREACH(eatt, &ble_eatt_bearer_list, next) {
+        if (num >= max_cids) {
+            break;
+        }
+        if (eatt->conn_handle == conn_handle && eatt->cid != 0 &&
+            !eatt->closed) {
+
+            cids[num++] = eatt->cid;
+        }
+    }
+
+    ble_hs_unlock();
+
+    return num;
+}
+
+/**
+ * Indicates whether we are the central of the specified connection and no
+ * bearers exist for it yet.
+ */
+static int
+ble_eatt_should_open(uint16_t conn_handle)
+{
+    struct ble_hs_conn *conn;
+    int open;
+
+    ble_hs_lock();
+    conn = ble_hs_conn_find(conn_handle);
+    open = conn != NULL && (conn->bhc_flags & BLE_HS_CONN_F_MASTER) &&
+           ble_eatt_num(conn_handle) == 0;
+    ble_hs_unlock();
+
+    return open;
+}
+
+static int
+ble_eatt_srv_sup_feat_cb(uint16_t conn_handle,
+                         const struct ble_gatt_error *error,
+                         struct ble_gatt_attr *attr, void *arg)
+{
+    uint8_t feat;
+
+    /* A peer without the characteristic does not support EATT. */
+    if (error->status != 0 || attr == NULL) {
+        return 0;
+    }
+
+    if (os_mbuf_copydata(attr->om, 0, sizeof feat, &feat) != 0) {
+        return 0;
+    }
+
+    if ((feat & BLE_GATT_SRV_SUP_FEAT_EATT) &&
+        ble_eatt_should_open(conn_handle)) {
+
+        ble_eatt_open(conn_handle);
+    }
+
+    return 0;
+}
+
+/**
+ * Called when the specified connection becomes encrypted.  If we are the
+ * central and no bearers exist yet, reads the Server Supported Features of
+ * the peer; bearers are opened only if the peer supports EATT.
+ */
+void
+ble_eatt_connect(uint16_t conn_handle)
+{
+    if (!ble_eatt_should_open(conn_handle)) {
+        return;
+    }
+
+    ble_gattc_read_by_uuid(conn_handle, 1, 0xffff,
+                           BLE_UUID16_DECLARE(BLE_GATT_CHR_SRV_SUP_FEAT_UUID16),
+                           ble_eatt_srv_sup_feat_cb, NULL);
+}
+
+int
+ble_eatt_init(void)
+{
+    int rc;
+
+    SLIST_INIT(&ble_eatt_bearer_list);
+
+    ble_npl_event_init(&ble_eatt_ev_closed, ble_eatt_closed_event_cb, NULL);
+
+    rc = os_mempool_init(&ble_eatt_pool,
+                         MYNEWT_VAL(BLE_MAX_CONNECTIONS) *
+                         MYNEWT_VAL(BLE_EATT_CHAN_NUM),
+                         sizeof (struct ble_eatt),
+                         ble_eatt_mem, "ble_eatt_pool");
+    if (rc != 0) {
+        return BLE_HS_EOS;
+    }
+
+    rc = ble_l2cap_coc_create_server(BLE_EATT_PSM, MYNEWT_VAL(BLE_EATT_MTU),
+                                     ble_eatt_l2cap_event, NULL);
+    if (rc != 0) {
+        return rc;
+    }
+
+    return 0;
+}
+
+#endif
@@ -0,0 +1,52 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_BLE_EATT_PRIV_
+#define H_BLE_EATT_PRIV_
+
+#include <inttypes.h>
+#include "syscfg/syscfg.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** LE PSM of the Enhanced ATT service. */
+#define BLE_EATT_PSM                            0x0027
+
+struct ble_l2cap_chan;
+struct os_mbuf;
+
+#if MYNEWT_VAL(BLE_EATT_CHAN_NUM) > 0
+int ble_eatt_init(void);
+void ble_eatt_connect(uint16_t conn_handle);
+int ble_eatt_bearers(uint16_t conn_handle, uint16_t *cids, int max_cids);
+int ble_eatt_tx(struct ble_l2cap_chan *chan, struct os_mbuf *txom);
+#else
+#define ble_eatt_init()                                     0
+#define ble_eatt_connect(conn_handle)
+#define ble_eatt_bearers(conn_handle, cids, max_cids)       0
+#define ble_eatt_tx(chan, txom) \
+    (os_mbuf_free_chain(txom), BLE_HS_ENOTSUP)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -79,6 +79,8 @@
 #define BLE_GAP_OP_M_CONN                       2
 #define BLE_GAP_OP_S_ADV                        1
 
+#define BLE_GAP_OP_SYNC                         1
+
 /**
  * If an attempt to cancel an active procedure fails, the attempt is retried
  * at this rate (ms).
@@ -129,6 +131,7 @@ struct ble_gap_master_state {
         struct {
             uint8_t limited:1;
             uint8_t extended:1;
+            uint8_t batch:1;
         } disc;
     };
 };
@@ -158,6 +161,11 @@ struct ble_gap_slave_state {
     unsigned int directed:1;
     unsigned int legacy_pdu:1;
     unsigned int rnd_addr_set:1;
+#if MYNEWT_VAL(BLE_PERIODIC_ADV)
+    unsigned int anonymous:1;
+    unsigned int periodic_configured:1;
+    unsigned int periodic_enabled:1;
+#endif
     uint8_t rnd_addr[6];
 #else
 /* timer is used only with legacy advertising */
@@ -171,6 +179,85 @@ struct ble_gap_slave_state {
 
 static bssnz_t struct ble_gap_slave_state ble_gap_slave[BLE_ADV_INSTANCES];
 
+#if MYNEWT_VAL(BLE_PERIODIC_ADV)
+/** The pending periodic advertising sync creation procedure. */
+struct ble_gap_sync_state {
+    uint8_t op;
+    ble_gap_event_fn *cb;
+    void *cb_arg;
+};
+
+static bssnz_t struct ble_gap_sync_state ble_gap_sync;
+
+/** An established periodic advertising sync. */
+struct ble_gap_periodic_sync {
+    unsigned int used:1;
+    uint16_t sync_handle;
+    ble_gap_event_fn *cb;
+    void *cb_arg;
+};
+
+static bssnz_t struct ble_gap_periodic_sync
+    ble_gap_periodic_syncs[MYNEWT_VAL(BLE_MAX_PERIODIC_SYNCS)];
+#endif
+
+#define BLE_GAP_WL_CACHE_SIZE   MYNEWT_VAL(BLE_GAP_WL_CACHE_SIZE)
+
+/**
+ * The host's record of the controller's white list contents.  This allows
+ * ble_gap_wl_update() to only send the add and remove commands needed to
+ * reach the requested list.  The cache is invalid if the controller's list
+ * is not known, e.g., it did not fit in the cache.
+ */
+struct ble_gap_wl_cache {
+    uint8_t count;
+    uint8_t valid;
+    ble_addr_t addrs[BLE_GAP_WL_CACHE_SIZE];
+};
+
+static bssnz_t struct ble_gap_wl_cache ble_gap_wl_cache;
+
+#define BLE_GAP_CONNQ_MAX       MYNEWT_VAL(BLE_GAP_CONNQ_MAX)
+
+/* The connection queue runs a white list connect procedure. */
+#define BLE_GAP_CONNQ           (MYNEWT_VAL(BLE_ROLE_CENTRAL) &&    \
+                                 MYNEWT_VAL(BLE_WHITELIST) &&       \
+                                 BLE_GAP_CONNQ_MAX > 0)
+
+#if BLE_GAP_CONNQ
+/** A peer that the connection queue is trying to connect to. */
+struct ble_gap_connq_entry {
+    ble_addr_t peer_addr;
+    uint8_t own_addr_type;
+
+    uint8_t exp_set:1;
+    ble_npl_time_t exp_os_ticks;
+
+    struct ble_gap_conn_params conn_params;
+    ble_gap_event_fn *cb;
+    void *cb_arg;
+};
+
+/**
+ * The state of the connection queue.  While the queue is not empty, a white
+ * list connect procedure covering every queued peer is kept running.  Entries
+ * are kept in the order they were added.
+ */
+struct ble_gap_connq_state {
+    uint8_t count;
+
+    /** Set while a cancel issued to re-arm the connect procedure is pending. */
+    uint8_t cancelling:1;
+
+    /** Set if the connect procedure could not be started; retried later. */
+    uint8_t pending:1;
+
+    struct ble_gap_connq_entry entries[BLE_GAP_CONNQ_MAX];
+};
+
+static bssnz_t struct ble_gap_connq_state ble_gap_connq;
+#endif
+
 struct ble_gap_update_entry {
     SLIST_ENTRY(ble_gap_update_entry) next;
     struct ble_gap_upd_params params;
@@ -202,11 +289,16 @@ ble_gap_update_l2cap_cb(uint16_t conn_handle, int status, void *arg);
 
 static int ble_gap_adv_enable_tx(int enable);
 static int ble_gap_conn_cancel_tx(void);
+static int ble_gap_conn_cancel_no_lock(void);
 
 #if NIMBLE_BLE_SCAN
 static int ble_gap_disc_enable_tx(int enable, int filter_duplicates);
 #endif
 
+#if BLE_GAP_CONNQ
+static int32_t ble_gap_connq_timer(void);
+#endif
+
 STATS_SECT_DECL(ble_gap_stats) ble_gap_stats;
 STATS_NAME_START(ble_gap_stats)
     STATS_NAME(ble_gap_stats, wl_set)
@@ -235,6 +327,7 @@ STATS_NAME_START(ble_gap_stats)
     STATS_NAME(ble_gap_stats, rx_disconnect)
     STATS_NAME(ble_gap_stats, rx_update_complete)
     STATS_NAME(ble_gap_stats, rx_adv_report)
+    STATS_NAME(ble_gap_stats, rx_adv_report_batch)
     STATS_NAME(ble_gap_stats, rx_conn_complete)
     STATS_NAME(ble_gap_stats, discover_cancel)
     STATS_NAME(ble_gap_stats, discover_cancel_fail)
@@ -1251,6 +1344,69 @@ ble_gap_rx_adv_report(struct ble_gap_disc_desc *desc)
     ble_gap_disc_report(desc);
 }
 
+/**
+ * Processes the advertising reports carried by a single HCI event.  If the
+ * discovery procedure was started in batch mode, the reports that pass the
+ * sanity check are delivered to the application in one event; otherwise, and
+ * for mesh, each report is delivered separately.
+ */
+void
+ble_gap_rx_adv_reports(struct ble_gap_disc_desc *descs, int num)
+{
+#if !NIMBLE_BLE_SCAN
+    return;
+#endif
+
+    struct ble_gap_master_state state;
+    struct ble_gap_event event;
+    int num_valid;
+    int i;
+
+    if (!ble_gap_master.disc.batch) {
+        for (i = 0; i < num; i++) {
+            ble_gap_rx_adv_report(descs + i);
+        }
+        return;
+    }
+
+    num_valid = 0;
+    for (i = 0; i < num; i++) {
+        if (ble_gap_rx_adv_report_sanity_check(descs[i].data,
+                                               descs[i].length_data)) {
+            continue;
+        }
+
+        descs[num_valid++] = descs[i];
+    }
+
+    if (num_valid == 0) {
+        return;
+    }
+
+    STATS_INC(ble_gap_stats, rx_adv_report_batch);
+
+    memset(&event, 0, sizeof event);
+    event.type = BLE_GAP_EVENT_DISC_BATCH;
+    event.disc_batch.descs = descs;
+    event.disc_batch.num = num_valid;
+
+    ble_gap_master_extract_state(&state, 0);
+    if (ble_gap_has_client(&state)) {
+        state.cb(&event, state.cb_arg);
+    }
+
+#if MYNEWT_VAL(BLE_MESH)
+    if (ble_gap_mesh.cb) {
+        memset(&event, 0, sizeof event);
+        event.type = BLE_GAP_EVENT_DISC;
+        for (i = 0; i < num_valid; i++) {
+            event.disc = descs[i];
+            ble_gap_mesh.cb(&event, ble_gap_mesh.cb_arg);
+        }
+    }
+#endif
+}
+
 #if MYNEWT_VAL(BLE_EXT_ADV) && NIMBLE_BLE_SCAN
 void
 ble_gap_rx_le_scan_timeout(void)
@@ -1661,6 +1817,10 @@ ble_gap_timer(void)
     min_ticks = min(min_ticks, ble_gap_slave_timer());
 #endif
 
+#if BLE_GAP_CONNQ
+    min_ticks = min(min_ticks, ble_gap_connq_timer());
+#endif
+
     return min_ticks;
 }
 
@@ -1704,6 +1864,28 @@ ble_gap_wl_tx_add(const ble_addr_t *addr)
     return 0;
 }
 
+static int
+ble_gap_wl_tx_rmv(const ble_addr_t *addr)
+{
+    uint8_t buf[BLE_HCI_CHG_WHITE_LIST_LEN];
+    int rc;
+
+    rc = ble_hs_hci_cmd_build_le_rmv_from_whitelist(addr->val, addr->type,
+                                                    buf, sizeof buf);
+    if (rc != 0) {
+        return rc;
+    }
+
+    rc = ble_hs_hci_cmd_tx_empty_ack(BLE_HCI_OP(BLE_HCI_OGF_LE,
+                                                BLE_HCI_OCF_LE_RMV_WHITE_LIST),
+                                     buf, sizeof(buf));
+    if (rc != 0) {
+        return rc;
+    }
+
+    return 0;
+}
+
 static int
 ble_gap_wl_tx_clear(void)
 {
@@ -1719,6 +1901,120 @@ ble_gap_wl_tx_clear(void)
     return 0;
 }
 
+static int
+ble_gap_wl_cache_find(const ble_addr_t *addr)
+{
+    int i;
+
+    for (i = 0; i < ble_gap_wl_cache.count; i++) {
+        if (ble_addr_cmp(&ble_gap_wl_cache.addrs[i], addr) == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static int
+ble_gap_wl_addrs_contain(const ble_addr_t *addrs, uint8_t count,
+                         const ble_addr_t *addr)
+{
+    int i;
+
+    for (i = 0; i < count; i++) {
+        if (ble_addr_cmp(addrs + i, addr) == 0) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Records a successful addition to the controller's white list.  If the cache
+ * is full, it is marked invalid; the next update will then fall back to
+ * rewriting the entire list.
+ */
+static void
+ble_gap_wl_cache_add(const ble_addr_t *addr)
+{
+    if (!ble_gap_wl_cache.valid || ble_gap_wl_cache_find(addr) != -1) {
+        return;
+    }
+
+    if (ble_gap_wl_cache.count >= BLE_GAP_WL_CACHE_SIZE) {
+        ble_gap_wl_cache.valid = 0;
+        return;
+    }
+
+    ble_gap_wl_cache.addrs[ble_gap_wl_cache.count++] = *addr;
+}
+
+static void
+ble_gap_wl_cache_rmv(int idx)
+{
+    ble_gap_wl_cache.count--;
+    ble_gap_wl_cache.addrs[idx] = ble_gap_wl_cache.addrs[ble_gap_wl_cache.count];
+}
+
+/**
+ * Called when the controller is reset; the controller's white list is empty
+ * after a reset.
+ */
+void
+ble_gap_wl_reset(void)
+{
+    ble_gap_wl_cache.count = 0;
+    ble_gap_wl_cache.valid = 1;
+}
+
+static int
+ble_gap_wl_check_args(const ble_addr_t *addrs, uint8_t white_list_count)
+{
+    int i;
+
+    for (i = 0; i < white_list_count; i++) {
+        if (addrs[i].type != BLE_ADDR_PUBLIC &&
+            addrs[i].type != BLE_ADDR_RANDOM) {
+
+            return BLE_HS_EINVAL;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Clears the controller's white list and writes each of the specified
+ * entries.  Keeps the white list cache in sync with every command that
+ * succeeds.
+ */
+static int
+ble_gap_wl_write_all(const ble_addr_t *addrs, uint8_t white_list_count)
+{
+    int rc;
+    int i;
+
+    ble_gap_wl_cache.valid = 0;
+
+    rc = ble_gap_wl_tx_clear();
+    if (rc != 0) {
+        return rc;
+    }
+
+    ble_gap_wl_reset();
+
+    for (i = 0; i < white_list_count; i++) {
+        rc = ble_gap_wl_tx_add(addrs + i);
+        if (rc != 0) {
+            return rc;
+        }
+        ble_gap_wl_cache_add(addrs + i);
+    }
+
+    return 0;
+}
+
 int
 ble_gap_wl_set(const ble_addr_t *addrs, uint8_t white_list_count)
 {
@@ -1727,7 +2023,6 @@ ble_gap_wl_set(const ble_addr_t *addrs, uint8_t white_list_count)
 #endif
 
     int rc;
-    int i;
 
     STATS_INC(ble_gap_stats, wl_set);
 
@@ -1738,13 +2033,9 @@ ble_gap_wl_set(const ble_addr_t *addrs, uint8_t white_list_count)
         goto done;
     }
 
-    for (i = 0; i < white_list_count; i++) {
-        if (addrs[i].type != BLE_ADDR_PUBLIC &&
-            addrs[i].type != BLE_ADDR_RANDOM) {
-
-            rc = BLE_HS_EINVAL;
-            goto done;
-        }
+    rc = ble_gap_wl_check_args(addrs, white_list_count);
+    if (rc != 0) {
+        goto done;
     }
 
     if (ble_gap_wl_busy()) {
@@ -1756,16 +2047,81 @@ ble_gap_wl_set(const ble_addr_t *addrs, uint8_t white_list_count)
     ble_gap_log_wl(addrs, white_list_count);
     BLE_HS_LOG(INFO, "\n");
 
-    rc = ble_gap_wl_tx_clear();
+    rc = ble_gap_wl_write_all(addrs, white_list_count);
+
+done:
+    ble_hs_unlock();
+
+    if (rc != 0) {
+        STATS_INC(ble_gap_stats, wl_set_fail);
+    }
+    return rc;
+}
+
+int
+ble_gap_wl_update(const ble_addr_t *addrs, uint8_t white_list_count)
+{
+#if !MYNEWT_VAL(BLE_WHITELIST)
+    return BLE_HS_ENOTSUP;
+#endif
+
+    int rc;
+    int i;
+
+    STATS_INC(ble_gap_stats, wl_set);
+
+    ble_hs_lock();
+
+    rc = ble_gap_wl_check_args(addrs, white_list_count);
     if (rc != 0) {
         goto done;
     }
 
+    if (ble_gap_wl_busy()) {
+        rc = BLE_HS_EBUSY;
+        goto done;
+    }
+
+    BLE_HS_LOG(INFO, "GAP procedure initiated: update whitelist; ");
+    ble_gap_log_wl(addrs, white_list_count);
+    BLE_HS_LOG(INFO, "\n");
+
+    /* If we don't know what the controller's white list contains, or the
+     * requested list does not fit in the cache, rewrite the whole list.
+     */
+    if (!ble_gap_wl_cache.valid ||
+        white_list_count > BLE_GAP_WL_CACHE_SIZE) {
+
+        rc = ble_gap_wl_write_all(addrs, white_list_count);
+        goto done;
+    }
+
+    /* Remove stale entries first to make room for the new ones. */
+    i = 0;
+    while (i < ble_gap_wl_cache.count) {
+        if (ble_gap_wl_addrs_contain(addrs, white_list_count,
+                                     &ble_gap_wl_cache.addrs[i])) {
+            i++;
+            continue;
+        }
+
+        rc = ble_gap_wl_tx_rmv(&ble_gap_wl_cache.addrs[i]);
+        if (rc != 0) {
+            goto done;
+        }
+        ble_gap_wl_cache_rmv(i);
+    }
+
     for (i = 0; i < white_list_count; i++) {
+        if (ble_gap_wl_cache_find(addrs + i) != -1) {
+            continue;
+        }
+
         rc = ble_gap_wl_tx_add(addrs + i);
         if (rc != 0) {
             goto done;
         }
+        ble_gap_wl_cache_add(addrs + i);
     }
 
     rc = 0;
@@ -2420,6 +2776,9 @@ ble_gap_ext_adv_configure(uint8_t instance,
     ble_gap_slave[instance].scannable = params->scannable;
     ble_gap_slave[instance].directed = params->directed;
     ble_gap_slave[instance].legacy_pdu = params->legacy_pdu;
+#if MYNEWT_VAL(BLE_PERIODIC_ADV)
+    ble_gap_slave[instance].anonymous = params->anonymous;
+#endif
 
     ble_hs_unlock();
     return 0;
@@ -2857,6 +3216,13 @@ ble_gap_ext_adv_remove(uint8_t instance)
         return BLE_HS_EBUSY;
     }
 
+#if MYNEWT_VAL(BLE_PERIODIC_ADV)
+    if (ble_gap_slave[instance].periodic_enabled) {
+        ble_hs_unlock();
+        return BLE_HS_EBUSY;
+    }
+#endif
+
     opcode = BLE_HCI_OP(BLE_HCI_OGF_LE, BLE_HCI_OCF_LE_REMOVE_ADV_SET);
 
     rc = ble_hs_hci_cmd_build_le_ext_adv_remove(instance, buf, sizeof(buf));
@@ -2877,22 +3243,575 @@ ble_gap_ext_adv_remove(uint8_t instance)
     return 0;
 }
 
-#endif
-
-/*****************************************************************************
- * $discovery procedures                                                     *
- *****************************************************************************/
 
-#if MYNEWT_VAL(BLE_EXT_ADV) && NIMBLE_BLE_SCAN
+#if MYNEWT_VAL(BLE_PERIODIC_ADV)
 static int
-ble_gap_ext_disc_tx_params(uint8_t own_addr_type, uint8_t filter_policy,
-                       const struct ble_hs_hci_ext_scan_param *uncoded_params,
-                       const struct ble_hs_hci_ext_scan_param *coded_params)
+ble_gap_periodic_adv_params_tx(uint8_t instance,
+                               const struct ble_gap_periodic_adv_params *params)
 {
-    uint8_t buf[BLE_HCI_LE_EXT_SCAN_BASE_LEN +
-                2 * BLE_HCI_LE_EXT_SCAN_SINGLE_PARAM_LEN];
-    uint8_t phy_mask = 0;
-    struct ble_hs_hci_ext_scan_param param[2] = {{0}};
+    uint8_t buf[BLE_HCI_LE_SET_PER_ADV_PARAMS_LEN];
+    uint16_t itvl_min;
+    uint16_t itvl_max;
+    uint16_t props;
+    int rc;
+
+    /* Fill optional fields if application did not specify them. */
+    if (params->itvl_min == 0 && params->itvl_max == 0) {
+        itvl_min = BLE_GAP_PERIODIC_ITVL_MS(30);
+        itvl_max = BLE_GAP_PERIODIC_ITVL_MS(60);
+    } else {
+        itvl_min = params->itvl_min;
+        itvl_max = params->itvl_max;
+    }
+
+    props = 0;
+    if (params->include_tx_power) {
+        props |= BLE_HCI_LE_SET_PER_ADV_PROP_INC_TX_PWR;
+    }
+
+    rc = ble_hs_hci_cmd_build_le_periodic_adv_params(instance, itvl_min,
+                                                     itvl_max, props,
+                                                     buf, sizeof(buf));
+    if (rc != 0) {
+        return rc;
+    }
+
+    return ble_hs_hci_cmd_tx_empty_ack(
+        BLE_HCI_OP(BLE_HCI_OGF_LE, BLE_HCI_OCF_LE_SET_PER_ADV_PARAMS),
+        buf, sizeof(buf));
+}
+
+static int
+ble_gap_periodic_adv_params_validate(
+    const struct ble_gap_periodic_adv_params *params)
+{
+    if (!params) {
+        return BLE_HS_EINVAL;
+    }
+
+    if (params->itvl_min == 0 && params->itvl_max == 0) {
+        return 0;
+    }
+
+    if (params->itvl_min < BLE_HCI_LE_SET_PER_ADV_ITVL_MIN ||
+        params->itvl_min > params->itvl_max) {
+        return BLE_HS_EINVAL;
+    }
+
+    return 0;
+}
+
+int
+ble_gap_periodic_adv_configure(uint8_t instance,
+                               const struct ble_gap_periodic_adv_params *params)
+{
+    int rc;
+
+    if (instance >= BLE_ADV_INSTANCES) {
+        return BLE_HS_EINVAL;
+    }
+
+    rc = ble_gap_periodic_adv_params_validate(params);
+    if (rc != 0) {
+        return rc;
+    }
+
+    ble_hs_lock();
+
+    /* Periodic advertising is only allowed on a non-anonymous,
+     * non-connectable, non-scannable extended advertising instance.
+     */
+    if (!ble_gap_slave[instance].configured ||
+        ble_gap_slave[instance].legacy_pdu ||
+        ble_gap_slave[instance].anonymous ||
+        ble_gap_slave[instance].connectable ||
+        ble_gap_slave[instance].scannable) {
+        ble_hs_unlock();
+        return BLE_HS_EINVAL;
+    }
+
+    /* Parameters cannot be changed while periodic advertising is enabled. */
+    if (ble_gap_slave[instance].periodic_enabled) {
+        ble_hs_unlock();
+        return BLE_HS_EBUSY;
+    }
+
+    rc = ble_gap_periodic_adv_params_tx(instance, params);
+    if (rc != 0) {
+        ble_hs_unlock();
+        return rc;
+    }
+
+    ble_gap_slave[instance].periodic_configured = 1;
+
+    ble_hs_unlock();
+
+    return 0;
+}
+
+static int
+ble_gap_periodic_adv_enable_tx(uint8_t instance, uint8_t enable)
+{
+    uint8_t buf[BLE_HCI_LE_SET_PER_ADV_ENABLE_LEN];
+    int rc;
+
+    rc = ble_hs_hci_cmd_build_le_periodic_adv_enable(enable, instance,
+                                                     buf, sizeof(buf));
+    if (rc != 0) {
+        return rc;
+    }
+
+    return ble_hs_hci_cmd_tx_empty_ack(
+        BLE_HCI_OP(BLE_HCI_OGF_LE, BLE_HCI_OCF_LE_SET_PER_ADV_ENABLE),
+        buf, sizeof(buf));
+}
+
+int
+ble_gap_periodic_adv_start(uint8_t instance)
+{
+    int rc;
+
+    if (instance >= BLE_ADV_INSTANCES) {
+        return BLE_HS_EINVAL;
+    }
+
+    ble_hs_lock();
+
+    if (!ble_gap_slave[instance].periodic_configured) {
+        ble_hs_unlock();
+        return BLE_HS_EINVAL;
+    }
+
+    if (ble_gap_slave[instance].periodic_enabled) {
+        ble_hs_unlock();
+        return BLE_HS_EALREADY;
+    }
+
+    rc = ble_gap_periodic_adv_enable_tx(instance, 1);
+    if (rc != 0) {
+        ble_hs_unlock();
+        return rc;
+    }
+
+    ble_gap_slave[instance].periodic_enabled = 1;
+
+    ble_hs_unlock();
+
+    return 0;
+}
+
+int
+ble_gap_periodic_adv_stop(uint8_t instance)
+{
+    int rc;
+
+    if (instance >= BLE_ADV_INSTANCES) {
+        return BLE_HS_EINVAL;
+    }
+
+    ble_hs_lock();
+
+    if (!ble_gap_slave[instance].periodic_enabled) {
+        ble_hs_unlock();
+        return BLE_HS_EALREADY;
+    }
+
+    rc = ble_gap_periodic_adv_enable_tx(instance, 0);
+    if (rc != 0) {
+        ble_hs_unlock();
+        return rc;
+    }
+
+    ble_gap_slave[instance].periodic_enabled = 0;
+
+    ble_hs_unlock();
+
+    return 0;
+}
+
+static int
+ble_gap_periodic_adv_set(uint8_t instance, struct os_mbuf *data)
+{
+    static uint8_t buf[3 + BLE_HCI_LE_SET_PER_ADV_DATA_MAX_LEN];
+    uint16_t opcode;
+    uint16_t len;
+    uint16_t off;
+    uint8_t frag;
+    uint8_t op;
+    int rc;
+
+    opcode = BLE_HCI_OP(BLE_HCI_OGF_LE, BLE_HCI_OCF_LE_SET_PER_ADV_DATA);
+    len = OS_MBUF_PKTLEN(data);
+    off = 0;
+
+    do {
+        frag = min(len - off, BLE_HCI_LE_SET_PER_ADV_DATA_MAX_LEN);
+
+        if (off == 0 && frag == len) {
+            op = BLE_HCI_LE_SET_EXT_ADV_DATA_OPER_COMPLETE;
+        } else if (off == 0) {
+            op = BLE_HCI_LE_SET_EXT_ADV_DATA_OPER_FIRST;
+        } else if (off + frag == len) {
+            op = BLE_HCI_LE_SET_EXT_ADV_DATA_OPER_LAST;
+        } else {
+            op = BLE_HCI_LE_SET_EXT_ADV_DATA_OPER_INT;
+        }
+
+        rc = ble_hs_hci_cmd_build_le_periodic_adv_data(instance, op, data,
+                                                       off, frag,
+                                                       buf, sizeof(buf));
+        if (rc != 0) {
+            return rc;
+        }
+
+        rc = ble_hs_hci_cmd_tx_empty_ack(opcode, buf, 3 + frag);
+        if (rc != 0) {
+            return rc;
+        }
+
+        off += frag;
+    } while (off < len);
+
+    return 0;
+}
+
+int
+ble_gap_periodic_adv_set_data(uint8_t instance, struct os_mbuf *data)
+{
+    uint16_t len;
+    int rc;
+
+    if (instance >= BLE_ADV_INSTANCES) {
+        rc = BLE_HS_EINVAL;
+        goto done;
+    }
+
+    len = OS_MBUF_PKTLEN(data);
+    if (len > MYNEWT_VAL(BLE_EXT_ADV_MAX_SIZE)) {
+        rc = BLE_HS_EINVAL;
+        goto done;
+    }
+
+    ble_hs_lock();
+
+    if (!ble_gap_slave[instance].periodic_configured) {
+        ble_hs_unlock();
+        rc = BLE_HS_EINVAL;
+        goto done;
+    }
+
+    /* If already advertising, data must fit in single HCI command. */
+    if (ble_gap_slave[instance].periodic_enabled &&
+        len > BLE_HCI_LE_SET_PER_ADV_DATA_MAX_LEN) {
+        ble_hs_unlock();
+        rc = BLE_HS_EINVAL;
+        goto done;
+    }
+
+    rc = ble_gap_periodic_adv_set(instance, data);
+
+    ble_hs_unlock();
+
+done:
+    os_mbuf_free_chain(data);
+    return rc;
+}
+
+static struct ble_gap_periodic_sync *
+ble_gap_periodic_sync_find(uint16_t sync_handle)
+{
+    int i;
+
+    for (i = 0; i < MYNEWT_VAL(BLE_MAX_PERIODIC_SYNCS); i++) {
+        if (ble_gap_periodic_syncs[i].used &&
+            ble_gap_periodic_syncs[i].sync_handle == sync_handle) {
+            return &ble_gap_periodic_syncs[i];
+        }
+    }
+
+    return NULL;
+}
+
+static struct ble_gap_periodic_sync *
+ble_gap_periodic_sync_alloc(void)
+{
+    int i;
+
+    for (i = 0; i < MYNEWT_VAL(BLE_MAX_PERIODIC_SYNCS); i++) {
+        if (!ble_gap_periodic_syncs[i].used) {
+            return &ble_gap_periodic_syncs[i];
+        }
+    }
+
+    return NULL;
+}
+
+void
+ble_gap_rx_periodic_adv_sync_estab(
+    struct hci_le_subev_periodic_adv_sync_estab *evt)
+{
+    struct ble_gap_periodic_sync *psync;
+    struct ble_gap_event event;
+    ble_gap_event_fn *cb;
+    void *cb_arg;
+
+    memset(&event, 0, sizeof event);
+
+    ble_hs_lock();
+
+    if (ble_gap_sync.op != BLE_GAP_OP_SYNC) {
+        /* Not expecting a sync; ignore the event. */
+        ble_hs_unlock();
+        return;
+    }
+
+    cb = ble_gap_sync.cb;
+    cb_arg = ble_gap_sync.cb_arg;
+    memset(&ble_gap_sync, 0, sizeof ble_gap_sync);
+
+    if (evt->status == BLE_ERR_SUCCESS) {
+        psync = ble_gap_periodic_sync_alloc();
+        if (psync == NULL) {
+            /* Space was reserved when the procedure was started. */
+            BLE_HS_DBG_ASSERT(0);
+        } else {
+            psync->used = 1;
+            psync->sync_handle = evt->sync_handle;
+            psync->cb = cb;
+            psync->cb_arg = cb_arg;
+        }
+    }
+
+    ble_hs_unlock();
+
+    event.type = BLE_GAP_EVENT_PERIODIC_SYNC;
+    if (evt->status != BLE_ERR_SUCCESS) {
+        event.periodic_sync.status = BLE_HS_HCI_ERR(evt->status);
+    } else {
+        event.periodic_sync.status = 0;
+        event.periodic_sync.sync_handle = evt->sync_handle;
+        event.periodic_sync.sid = evt->sid;
+        event.periodic_sync.adv_addr.type = evt->adv_addr_type;
+        memcpy(event.periodic_sync.adv_addr.val, evt->adv_addr,
+               BLE_DEV_ADDR_LEN);
+        event.periodic_sync.adv_phy = evt->adv_phy;
+        event.periodic_sync.per_adv_ival = evt->per_adv_ival;
+        event.periodic_sync.adv_clk_accuracy = evt->adv_clk_accuracy;
+    }
+
+    ble_gap_call_event_cb(&event, cb, cb_arg);
+}
+
+void
+ble_gap_rx_periodic_adv_rpt(struct hci_le_subev_periodic_adv_rpt *evt)
+{
+    struct ble_gap_periodic_sync *psync;
+    struct ble_gap_event event;
+    ble_gap_event_fn *cb = NULL;
+    void *cb_arg = NULL;
+
+    ble_hs_lock();
+    psync = ble_gap_periodic_sync_find(evt->sync_handle);
+    if (psync != NULL) {
+        cb = psync->cb;
+        cb_arg = psync->cb_arg;
+    }
+    ble_hs_unlock();
+
+    if (psync == NULL) {
+        return;
+    }
+
+    memset(&event, 0, sizeof event);
+    event.type = BLE_GAP_EVENT_PERIODIC_REPORT;
+    event.periodic_report.sync_handle = evt->sync_handle;
+    event.periodic_report.tx_power = evt->tx_power;
+    event.periodic_report.rssi = evt->rssi;
+    event.periodic_report.data_status = evt->data_status;
+    event.periodic_report.data_length = evt->data_length;
+    event.periodic_report.data = evt->data;
+
+    ble_gap_call_event_cb(&event, cb, cb_arg);
+}
+
+static void
+ble_gap_periodic_sync_lost_report(uint16_t sync_handle, int reason,
+                                  ble_gap_event_fn *cb, void *cb_arg)
+{
+    struct ble_gap_event event;
+
+    memset(&event, 0, sizeof event);
+    event.type = BLE_GAP_EVENT_PERIODIC_SYNC_LOST;
+    event.periodic_sync_lost.sync_handle = sync_handle;
+    event.periodic_sync_lost.reason = reason;
+
+    ble_gap_call_event_cb(&event, cb, cb_arg);
+}
+
+void
+ble_gap_rx_periodic_adv_sync_lost(
+    struct hci_le_subev_periodic_adv_sync_lost *evt)
+{
+    struct ble_gap_periodic_sync *psync;
+    ble_gap_event_fn *cb = NULL;
+    void *cb_arg = NULL;
+
+    ble_hs_lock();
+    psync = ble_gap_periodic_sync_find(evt->sync_handle);
+    if (psync != NULL) {
+        cb = psync->cb;
+        cb_arg = psync->cb_arg;
+        memset(psync, 0, sizeof *psync);
+    }
+    ble_hs_unlock();
+
+    if (psync == NULL) {
+        return;
+    }
+
+    ble_gap_periodic_sync_lost_report(evt->sync_handle, BLE_HS_ETIMEOUT,
+                                      cb, cb_arg);
+}
+
+int
+ble_gap_periodic_adv_sync_create(const ble_addr_t *addr, uint8_t adv_sid,
+                                 const struct ble_gap_periodic_sync_params *params,
+                                 ble_gap_event_fn *cb, void *cb_arg)
+{
+    uint8_t buf[BLE_HCI_LE_PER_ADV_CREATE_SYNC_LEN];
+    int rc;
+
+    if (addr == NULL || params == NULL ||
+        (addr->type != BLE_ADDR_PUBLIC && addr->type != BLE_ADDR_RANDOM)) {
+        return BLE_HS_EINVAL;
+    }
+
+    if (adv_sid > 0x0f) {
+        return BLE_HS_EINVAL;
+    }
+
+    if (params->skip > BLE_HCI_LE_PER_ADV_SKIP_MAX ||
+        params->sync_timeout < BLE_HCI_LE_PER_ADV_SYNC_TIMEOUT_MIN ||
+        params->sync_timeout > BLE_HCI_LE_PER_ADV_SYNC_TIMEOUT_MAX) {
+        return BLE_HS_EINVAL;
+    }
+
+    ble_hs_lock();
+
+    /* Only one sync can be pending at a time. */
+    if (ble_gap_sync.op == BLE_GAP_OP_SYNC) {
+        ble_hs_unlock();
+        return BLE_HS_EBUSY;
+    }
+
+    if (ble_gap_periodic_sync_alloc() == NULL) {
+        ble_hs_unlock();
+        return BLE_HS_ENOMEM;
+    }
+
+    rc = ble_hs_hci_cmd_build_le_periodic_adv_create_sync(0, adv_sid, addr,
+                                                          params->skip,
+                                                          params->sync_timeout,
+                                                          buf, sizeof(buf));
+    if (rc == 0) {
+        rc = ble_hs_hci_cmd_tx_empty_ack(
+            BLE_HCI_OP(BLE_HCI_OGF_LE, BLE_HCI_OCF_LE_PER_ADV_CREATE_SYNC),
+            buf, sizeof(buf));
+    }
+
+    if (rc == 0) {
+        ble_gap_sync.op = BLE_GAP_OP_SYNC;
+        ble_gap_sync.cb = cb;
+        ble_gap_sync.cb_arg = cb_arg;
+    }
+
+    ble_hs_unlock();
+
+    return rc;
+}
+
+int
+ble_gap_periodic_adv_sync_create_cancel(void)
+{
+    int rc;
+
+    ble_hs_lock();
+
+    if (ble_gap_sync.op != BLE_GAP_OP_SYNC) {
+        ble_hs_unlock();
+        return BLE_HS_EBUSY;
+    }
+
+    /* The procedure completes with a sync established event carrying the
+     * "operation cancelled" status.
+     */
+    rc = ble_hs_hci_cmd_tx_empty_ack(
+        BLE_HCI_OP(BLE_HCI_OGF_LE, BLE_HCI_OCF_LE_PER_ADV_CREATE_SYNC_CANCEL),
+        NULL, 0);
+
+    ble_hs_unlock();
+
+    return rc;
+}
+
+int
+ble_gap_periodic_adv_sync_terminate(uint16_t sync_handle)
+{
+    uint8_t buf[BLE_HCI_LE_PER_ADV_TERM_SYNC_LEN];
+    struct ble_gap_periodic_sync *psync;
+    ble_gap_event_fn *cb = NULL;
+    void *cb_arg = NULL;
+    int rc;
+
+    ble_hs_lock();
+
+    psync = ble_gap_periodic_sync_find(sync_handle);
+    if (psync == NULL) {
+        ble_hs_unlock();
+        return BLE_HS_ENOTCONN;
+    }
+
+    rc = ble_hs_hci_cmd_build_le_periodic_adv_terminate_sync(sync_handle, buf,
+                                                             sizeof(buf));
+    if (rc == 0) {
+        rc = ble_hs_hci_cmd_tx_empty_ack(
+            BLE_HCI_OP(BLE_HCI_OGF_LE, BLE_HCI_OCF_LE_PER_ADV_TERM_SYNC),
+            buf, sizeof(buf));
+    }
+
+    if (rc == 0) {
+        cb = psync->cb;
+        cb_arg = psync->cb_arg;
+        memset(psync, 0, sizeof *psync);
+    }
+
+    ble_hs_unlock();
+
+    if (rc == 0) {
+        ble_gap_periodic_sync_lost_report(sync_handle, BLE_HS_EDONE,
+                                          cb, cb_arg);
+    }
+
+    return rc;
+}
+#endif
+
+#endif
+
+/*****************************************************************************
+ * $discovery procedures                                                     *
+ *****************************************************************************/
+
+#if MYNEWT_VAL(BLE_EXT_ADV) && NIMBLE_BLE_SCAN
+static int
+ble_gap_ext_disc_tx_params(uint8_t own_addr_type, uint8_t filter_policy,
+                       const struct ble_hs_hci_ext_scan_param *uncoded_params,
+                       const struct ble_hs_hci_ext_scan_param *coded_params)
+{
+    uint8_t buf[BLE_HCI_LE_EXT_SCAN_BASE_LEN +
+                2 * BLE_HCI_LE_EXT_SCAN_SINGLE_PARAM_LEN];
+    uint8_t phy_mask = 0;
+    struct ble_hs_hci_ext_scan_param param[2] = {{0}};
     struct ble_hs_hci_ext_scan_param *p = param;
     int phy_count = 0;
     uint8_t len;
@@ -3183,6 +4102,7 @@ ble_gap_ext_disc(uint8_t own_addr_type, uint16_t duration, uint16_t period,
 
     ble_gap_master.disc.limited = limited;
     ble_gap_master.disc.extended = 1;
+    ble_gap_master.disc.batch = 0;
     ble_gap_master.cb = cb;
     ble_gap_master.cb_arg = cb_arg;
 
@@ -3297,6 +4217,7 @@ ble_gap_disc(uint8_t own_addr_type, int32_t duration_ms,
     ble_gap_master.disc.limited = params.limited;
     ble_gap_master.cb = cb;
     ble_gap_master.disc.extended = 0;
+    ble_gap_master.disc.batch = params.batch;
     ble_gap_master.cb_arg = cb_arg;
 
     BLE_HS_LOG(INFO, "GAP procedure initiated: discovery; ");
@@ -3339,6 +4260,87 @@ ble_gap_disc_active(void)
     return ble_gap_master.op == BLE_GAP_OP_M_DISC;
 }
 
+int
+ble_gap_disc_filt_enable(int enable, int8_t min_rssi)
+{
+#if !NIMBLE_BLE_SCAN
+    return BLE_HS_ENOTSUP;
+#else
+    uint8_t buf[BLE_HCI_VS_SET_ADV_FILT_ENABLE_LEN];
+
+    buf[0] = !!enable;
+    buf[1] = (uint8_t)min_rssi;
+
+    return ble_hs_hci_cmd_tx_empty_ack(
+        BLE_HCI_OP(BLE_HCI_OGF_VENDOR, BLE_HCI_OCF_VS_SET_ADV_FILT_ENABLE),
+        buf, sizeof(buf));
+#endif
+}
+
+int
+ble_gap_disc_filt_add_ad(uint8_t ad_type, const uint8_t *value,
+                         const uint8_t *mask, uint8_t len)
+{
+#if !NIMBLE_BLE_SCAN
+    return BLE_HS_ENOTSUP;
+#else
+    uint8_t buf[BLE_HCI_VS_ADD_ADV_FILT_AD_MIN_LEN +
+                2 * BLE_HCI_VS_ADV_FILT_AD_MAX_LEN];
+
+    if (len > BLE_HCI_VS_ADV_FILT_AD_MAX_LEN) {
+        return BLE_HS_EINVAL;
+    }
+
+    buf[0] = BLE_HCI_VS_ADV_FILT_TYPE_AD;
+    buf[1] = ad_type;
+    buf[2] = len;
+    memcpy(buf + 3, value, len);
+    if (mask != NULL) {
+        memcpy(buf + 3 + len, mask, len);
+    } else {
+        memset(buf + 3 + len, 0xff, len);
+    }
+
+    return ble_hs_hci_cmd_tx_empty_ack(
+        BLE_HCI_OP(BLE_HCI_OGF_VENDOR, BLE_HCI_OCF_VS_ADD_ADV_FILT),
+        buf, BLE_HCI_VS_ADD_ADV_FILT_AD_MIN_LEN + 2 * len);
+#endif
+}
+
+int
+ble_gap_disc_filt_add_addr(const ble_addr_t *addr)
+{
+#if !NIMBLE_BLE_SCAN
+    return BLE_HS_ENOTSUP;
+#else
+    uint8_t buf[BLE_HCI_VS_ADD_ADV_FILT_ADDR_LEN];
+
+    if (addr->type > BLE_ADDR_RANDOM) {
+        return BLE_HS_EINVAL;
+    }
+
+    buf[0] = BLE_HCI_VS_ADV_FILT_TYPE_ADDR;
+    buf[1] = addr->type;
+    memcpy(buf + 2, addr->val, BLE_DEV_ADDR_LEN);
+
+    return ble_hs_hci_cmd_tx_empty_ack(
+        BLE_HCI_OP(BLE_HCI_OGF_VENDOR, BLE_HCI_OCF_VS_ADD_ADV_FILT),
+        buf, sizeof(buf));
+#endif
+}
+
+int
+ble_gap_disc_filt_clear(void)
+{
+#if !NIMBLE_BLE_SCAN
+    return BLE_HS_ENOTSUP;
+#else
+    return ble_hs_hci_cmd_tx_empty_ack(
+        BLE_HCI_OP(BLE_HCI_OGF_VENDOR, BLE_HCI_OCF_VS_CLEAR_ADV_FILT),
+        NULL, 0);
+#endif
+}
+
 /*****************************************************************************
  * $connection establishment procedures                                      *
  *****************************************************************************/
@@ -3753,6 +4755,385 @@ ble_gap_conn_active(void)
     return ble_gap_master.op == BLE_GAP_OP_M_CONN;
 }
 
+/*****************************************************************************
+ * $connection queue                                                         *
+ *****************************************************************************/
+
+#if BLE_GAP_CONNQ
+static int ble_gap_connq_event(struct ble_gap_event *event, void *arg);
+
+static int
+ble_gap_connq_find(const ble_addr_t *peer_addr)
+{
+    int i;
+
+    for (i = 0; i < ble_gap_connq.count; i++) {
+        if (ble_addr_cmp(&ble_gap_connq.entries[i].peer_addr,
+                         peer_addr) == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static void
+ble_gap_connq_remove(int idx, struct ble_gap_connq_entry *out_entry)
+{
+    if (out_entry != NULL) {
+        *out_entry = ble_gap_connq.entries[idx];
+    }
+
+    ble_gap_connq.count--;
+    memmove(ble_gap_connq.entries + idx, ble_gap_connq.entries + idx + 1,
+            (ble_gap_connq.count - idx) * sizeof ble_gap_connq.entries[0]);
+}
+
+/**
+ * Indicates whether the active connect procedure was started by the
+ * connection queue.
+ */
+static int
+ble_gap_connq_owns_master(void)
+{
+    return ble_gap_master.op == BLE_GAP_OP_M_CONN &&
+           ble_gap_master.cb == ble_gap_connq_event;
+}
+
+static void
+ble_gap_connq_report(const struct ble_gap_connq_entry *entry, int status,
+                     uint16_t conn_handle)
+{
+    struct ble_gap_event event;
+
+    memset(&event, 0, sizeof event);
+    event.type = BLE_GAP_EVENT_CONNECT;
+    event.connect.status = status;
+    event.connect.conn_handle = conn_handle;
+    ble_gap_call_event_cb(&event, entry->cb, entry->cb_arg);
+}
+
+/**
+ * Programs the white list with every queued peer and starts a white list
+ * connect procedure.  The own address type and connection parameters of the
+ * oldest entry apply to the whole procedure.
+ */
+static int
+ble_gap_connq_start(void)
+{
+    ble_addr_t addrs[BLE_GAP_CONNQ_MAX];
+    struct ble_gap_connq_entry head;
+    uint8_t count;
+    int rc;
+    int i;
+
+    ble_hs_lock();
+
+    count = ble_gap_connq.count;
+    for (i = 0; i < count; i++) {
+        addrs[i] = ble_gap_connq.entries[i].peer_addr;
+    }
+    if (count > 0) {
+        head = ble_gap_connq.entries[0];
+    }
+
+    ble_hs_unlock();
+
+    if (count == 0) {
+        return 0;
+    }
+
+    rc = ble_gap_wl_update(addrs, count);
+    if (rc != 0) {
+        return rc;
+    }
+
+    return ble_gap_connect(head.own_addr_type, NULL, BLE_HS_FOREVER,
+                           &head.conn_params, ble_gap_connq_event, NULL);
+}
+
+/**
+ * Brings the connect procedure in line with the queue contents.  A running
+ * queue procedure is cancelled first, as the white list cannot be modified
+ * while it is in use; the procedure is restarted once the cancellation is
+ * reported.  If the procedure cannot be started (e.g., another master
+ * procedure is active), the attempt is retried by the GAP timer.
+ */
+static void
+ble_gap_connq_rearm(void)
+{
+    int rc;
+
+    ble_hs_lock();
+
+    if (ble_gap_connq.cancelling) {
+        ble_hs_unlock();
+        return;
+    }
+
+    if (ble_gap_connq_owns_master()) {
+        rc = ble_gap_conn_cancel_no_lock();
+        if (rc == 0) {
+            ble_gap_connq.cancelling = 1;
+        }
+        ble_gap_connq.pending = rc != 0;
+
+        ble_hs_unlock();
+        return;
+    }
+
+    ble_hs_unlock();
+
+    rc = ble_gap_connq_start();
+
+    ble_hs_lock();
+    ble_gap_connq.pending = rc != 0;
+    ble_hs_unlock();
+
+    if (rc != 0) {
+        ble_hs_timer_resched();
+    }
+}
+
+/**
+ * Master procedure callback of the connection queue.  Hands a new connection
+ * over to the callback of the matching target and re-arms the procedure for
+ * the remaining targets.
+ */
+static int
+ble_gap_connq_event(struct ble_gap_event *event, void *arg)
+{
+    struct ble_gap_connq_entry entry;
+    struct ble_gap_conn_desc desc;
+    int idx;
+    int rc;
+
+    if (event->type != BLE_GAP_EVENT_CONNECT) {
+        return 0;
+    }
+
+    ble_hs_lock();
+    ble_gap_connq.cancelling = 0;
+    ble_hs_unlock();
+
+    if (event->connect.status == 0) {
+        rc = ble_gap_conn_find(event->connect.conn_handle, &desc);
+        if (rc == 0) {
+            ble_hs_lock();
+
+            idx = ble_gap_connq_find(&desc.peer_id_addr);
+            if (idx == -1) {
+                idx = ble_gap_connq_find(&desc.peer_ota_addr);
+            }
+            if (idx != -1) {
+                ble_gap_connq_remove(idx, &entry);
+            }
+
+            ble_hs_unlock();
+
+            if (idx == -1) {
+                /* The target was removed while the connection was being
+                 * established.
+                 */
+                ble_gap_terminate(event->connect.conn_handle,
+                                  BLE_ERR_REM_USER_CONN_TERM);
+            } else {
+                ble_gap_set_event_cb(event->connect.conn_handle,
+                                     entry.cb, entry.cb_arg);
+                ble_gap_connq_report(&entry, 0, event->connect.conn_handle);
+            }
+        }
+    }
+
+    ble_gap_connq_rearm();
+
+    return 0;
+}
+
+static int32_t
+ble_gap_connq_timer(void)
+{
+    struct ble_gap_connq_entry entry;
+    ble_npl_stime_t ticks;
+    ble_npl_time_t now;
+    int32_t min_ticks;
+    int expired;
+    int rearm;
+    int i;
+
+    /* Report and remove expired targets. */
+    rearm = 0;
+    do {
+        now = ble_npl_time_get();
+        expired = 0;
+
+        ble_hs_lock();
+
+        for (i = 0; i < ble_gap_connq.count; i++) {
+            if (ble_gap_connq.entries[i].exp_set &&
+                (ble_npl_stime_t)(ble_gap_connq.entries[i].exp_os_ticks -
+                                  now) <= 0) {
+
+                ble_gap_connq_remove(i, &entry);
+                expired = 1;
+                break;
+            }
+        }
+
+        ble_hs_unlock();
+
+        if (expired) {
+            ble_gap_connq_report(&entry, BLE_HS_ETIMEOUT,
+                                 BLE_HS_CONN_HANDLE_NONE);
+            rearm = 1;
+        }
+    } while (expired);
+
+    if (rearm || ble_gap_connq.pending) {
+        ble_gap_connq_rearm();
+    }
+
+    /* Determine when this function needs to run again. */
+    min_ticks = BLE_HS_FOREVER;
+    now = ble_npl_time_get();
+
+    ble_hs_lock();
+
+    if (ble_gap_connq.pending) {
+        min_ticks =
+            ble_npl_time_ms_to_ticks32(BLE_GAP_CANCEL_RETRY_TIMEOUT_MS);
+    }
+
+    for (i = 0; i < ble_gap_connq.count; i++) {
+        if (ble_gap_connq.entries[i].exp_set) {
+            ticks = ble_gap_connq.entries[i].exp_os_ticks - now;
+            min_ticks = min(min_ticks, max(ticks, 0));
+        }
+    }
+
+    ble_hs_unlock();
+
+    return min_ticks;
+}
+#endif
+
+int
+ble_gap_connq_add(uint8_t own_addr_type, const ble_addr_t *peer_addr,
+                  int32_t duration_ms,
+                  const struct ble_gap_conn_params *conn_params,
+                  ble_gap_event_fn *cb, void *cb_arg)
+{
+#if !BLE_GAP_CONNQ
+    return BLE_HS_ENOTSUP;
+#else
+
+    struct ble_gap_connq_entry *entry;
+    uint32_t duration_ticks = 0;
+    int rc;
+
+    if (peer_addr == NULL ||
+        (peer_addr->type != BLE_ADDR_PUBLIC &&
+         peer_addr->type != BLE_ADDR_RANDOM)) {
+
+        return BLE_HS_EINVAL;
+    }
+
+    if (conn_params == NULL) {
+        conn_params = &ble_gap_conn_params_dflt;
+    }
+
+    if (duration_ms == 0) {
+        duration_ms = BLE_GAP_CONN_DUR_DFLT;
+    }
+
+    if (duration_ms != BLE_HS_FOREVER) {
+        rc = ble_npl_time_ms_to_ticks(duration_ms, &duration_ticks);
+        if (rc != 0) {
+            /* Duration too great. */
+            return BLE_HS_EINVAL;
+        }
+    }
+
+    ble_hs_lock();
+
+    if (ble_gap_connq_find(peer_addr) != -1) {
+        rc = BLE_HS_EALREADY;
+        goto done;
+    }
+
+    if (ble_gap_connq.count >= BLE_GAP_CONNQ_MAX) {
+        rc = BLE_HS_ENOMEM;
+        goto done;
+    }
+
+    /* Verify peer not already connected. */
+    if (ble_hs_conn_find_by_addr(peer_addr) != NULL) {
+        rc = BLE_HS_EDONE;
+        goto done;
+    }
+
+    rc = ble_hs_id_use_addr(own_addr_type);
+    if (rc != 0) {
+        goto done;
+    }
+
+    entry = ble_gap_connq.entries + ble_gap_connq.count++;
+    memset(entry, 0, sizeof *entry);
+    entry->peer_addr = *peer_addr;
+    entry->own_addr_type = own_addr_type;
+    entry->conn_params = *conn_params;
+    entry->cb = cb;
+    entry->cb_arg = cb_arg;
+
+    if (duration_ms != BLE_HS_FOREVER) {
+        entry->exp_os_ticks = ble_npl_time_get() + duration_ticks;
+        entry->exp_set = 1;
+    }
+
+    rc = 0;
+
+done:
+    ble_hs_unlock();
+
+    if (rc != 0) {
+        return rc;
+    }
+
+    ble_gap_connq_rearm();
+    ble_hs_timer_resched();
+
+    return 0;
+#endif
+}
+
+int
+ble_gap_connq_cancel(const ble_addr_t *peer_addr)
+{
+#if !BLE_GAP_CONNQ
+    return BLE_HS_ENOTSUP;
+#else
+
+    int idx;
+
+    ble_hs_lock();
+
+    idx = ble_gap_connq_find(peer_addr);
+    if (idx != -1) {
+        ble_gap_connq_remove(idx, NULL);
+    }
+
+    ble_hs_unlock();
+
+    if (idx == -1) {
+        return BLE_HS_ENOENT;
+    }
+
+    ble_gap_connq_rearm();
+
+    return 0;
+#endif
+}
+
 /*****************************************************************************
  * $terminate connection procedure                                           *
  *****************************************************************************/
@@ -4365,6 +5746,10 @@ ble_gap_enc_event(uint16_t conn_handle, int status, int security_restored)
     if (status == 0 && security_restored) {
         ble_gatts_bonding_restored(conn_handle);
     }
+
+    if (status == 0) {
+        ble_eatt_connect(conn_handle);
+    }
 }
 
 void
@@ -4511,6 +5896,17 @@ ble_gap_mtu_event(uint16_t conn_handle, uint16_t cid, uint16_t mtu)
     ble_gap_call_conn_event_cb(&event, conn_handle);
 }
 
+void
+ble_gap_tx_ready_event(uint16_t conn_handle)
+{
+    struct ble_gap_event event;
+
+    memset(&event, 0, sizeof event);
+    event.type = BLE_GAP_EVENT_TX_READY;
+    event.tx_ready.conn_handle = conn_handle;
+    ble_gap_call_conn_event_cb(&event, conn_handle);
+}
+
 /*****************************************************************************
  * $preempt                                                                  *
  *****************************************************************************/
@@ -4649,6 +6045,14 @@ ble_gap_init(void)
 
     memset(&ble_gap_master, 0, sizeof ble_gap_master);
     memset(ble_gap_slave, 0, sizeof ble_gap_slave);
+    memset(&ble_gap_wl_cache, 0, sizeof ble_gap_wl_cache);
+#if MYNEWT_VAL(BLE_PERIODIC_ADV)
+    memset(&ble_gap_sync, 0, sizeof ble_gap_sync);
+    memset(ble_gap_periodic_syncs, 0, sizeof ble_gap_periodic_syncs);
+#endif
+#if BLE_GAP_CONNQ
+    memset(&ble_gap_connq, 0, sizeof ble_gap_connq);
+#endif
 
     ble_npl_mutex_init(&preempt_done_mutex);
 
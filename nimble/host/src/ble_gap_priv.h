@@ -63,6 +63,7 @@ STATS_SECT_START(ble_gap_stats)
     STATS_SECT_ENTRY(rx_disconnect)
     STATS_SECT_ENTRY(rx_update_complete)
     STATS_SECT_ENTRY(rx_adv_report)
+    STATS_SECT_ENTRY(rx_adv_report_batch)
     STATS_SECT_ENTRY(rx_conn_complete)
     STATS_SECT_ENTRY(discover_cancel)
     STATS_SECT_ENTRY(discover_cancel_fail)
@@ -83,7 +84,15 @@ void ble_gap_rx_le_scan_timeout(void);
 void ble_gap_rx_ext_adv_report(struct ble_gap_ext_disc_desc *desc);
 void ble_gap_rx_adv_set_terminated(struct hci_le_adv_set_terminated *evt);
 #endif
+#if MYNEWT_VAL(BLE_PERIODIC_ADV)
+void ble_gap_rx_periodic_adv_sync_estab(
+    struct hci_le_subev_periodic_adv_sync_estab *evt);
+void ble_gap_rx_periodic_adv_rpt(struct hci_le_subev_periodic_adv_rpt *evt);
+void ble_gap_rx_periodic_adv_sync_lost(
+    struct hci_le_subev_periodic_adv_sync_lost *evt);
+#endif
 void ble_gap_rx_adv_report(struct ble_gap_disc_desc *desc);
+void ble_gap_rx_adv_reports(struct ble_gap_disc_desc *descs, int num);
 void ble_gap_rx_rd_rem_sup_feat_complete(struct hci_le_rd_rem_supp_feat_complete *evt);
 int ble_gap_rx_conn_complete(struct hci_le_conn_complete *evt, uint8_t instance);
 void ble_gap_rx_disconn_complete(struct hci_disconn_complete *evt);
@@ -105,6 +114,7 @@ void ble_gap_subscribe_event(uint16_t conn_handle, uint16_t attr_handle,
                              uint8_t prev_notify, uint8_t cur_notify,
                              uint8_t prev_indicate, uint8_t cur_indicate);
 void ble_gap_mtu_event(uint16_t conn_handle, uint16_t cid, uint16_t mtu);
+void ble_gap_tx_ready_event(uint16_t conn_handle);
 void ble_gap_identity_event(uint16_t conn_handle);
 int ble_gap_repeat_pairing_event(const struct ble_gap_repeat_pairing *rp);
 int ble_gap_master_in_progress(void);
@@ -112,6 +122,8 @@ int ble_gap_master_in_progress(void);
 void ble_gap_preempt(void);
 void ble_gap_preempt_done(void);
 
+void ble_gap_wl_reset(void);
+
 void ble_gap_conn_broken(uint16_t conn_handle, int reason);
 int32_t ble_gap_timer(void);
 
@@ -23,6 +23,7 @@
 #include "syscfg/syscfg.h"
 #include "stats/stats.h"
 #include "host/ble_gatt.h"
+#include "nimble/nimble_npl.h"
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -58,6 +59,9 @@ STATS_SECT_START(ble_gattc_stats)
     STATS_SECT_ENTRY(read_mult_fail)
     STATS_SECT_ENTRY(write_no_rsp)
     STATS_SECT_ENTRY(write_no_rsp_fail)
+    STATS_SECT_ENTRY(write_no_rsp_stream)
+    STATS_SECT_ENTRY(write_no_rsp_stream_busy)
+    STATS_SECT_ENTRY(write_no_rsp_stream_bytes)
     STATS_SECT_ENTRY(write)
     STATS_SECT_ENTRY(write_fail)
     STATS_SECT_ENTRY(write_long)
@@ -69,6 +73,8 @@ STATS_SECT_START(ble_gattc_stats)
     STATS_SECT_ENTRY(indicate)
     STATS_SECT_ENTRY(indicate_fail)
     STATS_SECT_ENTRY(proc_timeout)
+    STATS_SECT_ENTRY(cache_hit)
+    STATS_SECT_ENTRY(cache_miss)
 STATS_SECT_END
 extern STATS_SECT_DECL(ble_gattc_stats) ble_gattc_stats;
 
@@ -96,46 +102,95 @@ struct ble_gatts_conn {
     int num_clt_cfgs;
 
     uint16_t indicate_val_handle;
+
+    /** Client Supported Features written by the peer. */
+    uint8_t clt_sup_feat;
 };
 
 /*** @client. */
 
+/** Write Without Response streaming state of a connection. */
+struct ble_gattc_stream {
+    /** Time of the first streamed write. */
+    ble_npl_time_t start;
+
+    uint32_t pdus;
+    uint32_t bytes;
+    uint32_t busy;
+};
+
 int ble_gattc_locked_by_cur_task(void);
 void ble_gatts_indicate_fail_notconn(uint16_t conn_handle);
 
-void ble_gattc_rx_err(uint16_t conn_handle, uint16_t handle, uint16_t status);
-void ble_gattc_rx_mtu(uint16_t conn_handle, int status, uint16_t chan_mtu);
-void ble_gattc_rx_read_type_adata(uint16_t conn_handle,
+void ble_gattc_rx_err(uint16_t conn_handle, uint16_t cid, uint16_t handle,
+                      uint16_t status);
+void ble_gattc_rx_mtu(uint16_t conn_handle, uint16_t cid, int status,
+                      uint16_t chan_mtu);
+void ble_gattc_rx_read_type_adata(uint16_t conn_handle, uint16_t cid,
                                   struct ble_att_read_type_adata *adata);
-void ble_gattc_rx_read_type_complete(uint16_t conn_handle, int status);
-void ble_gattc_rx_read_rsp(uint16_t conn_handle, int status,
+void ble_gattc_rx_read_type_complete(uint16_t conn_handle, uint16_t cid,
+                                     int status);
+void ble_gattc_rx_read_rsp(uint16_t conn_handle, uint16_t cid, int status,
                            struct os_mbuf **rxom);
-void ble_gattc_rx_read_blob_rsp(uint16_t conn_handle, int status,
-                                struct os_mbuf **rxom);
-void ble_gattc_rx_read_mult_rsp(uint16_t conn_handle, int status,
-                                struct os_mbuf **rxom);
+void ble_gattc_rx_read_blob_rsp(uint16_t conn_handle, uint16_t cid,
+                                int status, struct os_mbuf **rxom);
+void ble_gattc_rx_read_mult_rsp(uint16_t conn_handle, uint16_t cid,
+                                int status, struct os_mbuf **rxom);
 void ble_gattc_rx_read_group_type_adata(
-    uint16_t conn_handle, struct ble_att_read_group_type_adata *adata);
-void ble_gattc_rx_read_group_type_complete(uint16_t conn_handle, int rc);
+    uint16_t conn_handle, uint16_t cid,
+    struct ble_att_read_group_type_adata *adata);
+void ble_gattc_rx_read_group_type_complete(uint16_t conn_handle, uint16_t cid,
+                                           int rc);
 void ble_gattc_rx_find_type_value_hinfo(
-    uint16_t conn_handle, struct ble_att_find_type_value_hinfo *hinfo);
-void ble_gattc_rx_find_type_value_complete(uint16_t conn_handle, int status);
-void ble_gattc_rx_write_rsp(uint16_t conn_handle);
-void ble_gattc_rx_prep_write_rsp(uint16_t conn_handle, int status,
-                                 uint16_t handle, uint16_t offset,
+    uint16_t conn_handle, uint16_t cid,
+    struct ble_att_find_type_value_hinfo *hinfo);
+void ble_gattc_rx_find_type_value_complete(uint16_t conn_handle, uint16_t cid,
+                                           int status);
+void ble_gattc_rx_write_rsp(uint16_t conn_handle, uint16_t cid);
+void ble_gattc_rx_prep_write_rsp(uint16_t conn_handle, uint16_t cid,
+                                 int status, uint16_t handle, uint16_t offset,
                                  struct os_mbuf **rxom);
-void ble_gattc_rx_exec_write_rsp(uint16_t conn_handle, int status);
-void ble_gattc_rx_indicate_rsp(uint16_t conn_handle);
-void ble_gattc_rx_find_info_idata(uint16_t conn_handle,
+void ble_gattc_rx_exec_write_rsp(uint16_t conn_handle, uint16_t cid,
+                                 int status);
+void ble_gattc_rx_indicate_rsp(uint16_t conn_handle, uint16_t cid);
+void ble_gattc_rx_find_info_idata(uint16_t conn_handle, uint16_t cid,
                                   struct ble_att_find_info_idata *idata);
-void ble_gattc_rx_find_info_complete(uint16_t conn_handle, int status);
+void ble_gattc_rx_find_info_complete(uint16_t conn_handle, uint16_t cid,
+                                     int status);
 void ble_gattc_connection_txable(uint16_t conn_handle);
 void ble_gattc_connection_broken(uint16_t conn_handle);
+void ble_gattc_bearer_closed(uint16_t conn_handle, uint16_t cid);
 int32_t ble_gattc_timer(void);
 
 int ble_gattc_any_jobs(void);
 int ble_gattc_init(void);
 
+/*** @client cache. */
+int ble_gattc_cache_svcs_cached(uint16_t conn_handle);
+int ble_gattc_cache_chrs_cached(uint16_t conn_handle, uint16_t start_handle,
+                                uint16_t end_handle);
+int ble_gattc_cache_dscs_cached(uint16_t conn_handle, uint16_t chr_val_handle,
+                                uint16_t end_handle);
+int ble_gattc_cache_next_svc(uint16_t conn_handle, uint16_t prev_handle,
+                             struct ble_gatt_svc *out_svc);
+int ble_gattc_cache_next_chr(uint16_t conn_handle, uint16_t prev_handle,
+                             uint16_t end_handle, struct ble_gatt_chr *out_chr);
+int ble_gattc_cache_next_dsc(uint16_t conn_handle, uint16_t chr_val_handle,
+                             uint16_t prev_handle, uint16_t end_handle,
+                             struct ble_gatt_dsc *out_dsc);
+int ble_gattc_cache_add_svc(uint16_t conn_handle,
+                            const struct ble_gatt_svc *svc);
+int ble_gattc_cache_add_chr(uint16_t conn_handle,
+                            const struct ble_gatt_chr *chr);
+int ble_gattc_cache_add_dsc(uint16_t conn_handle, uint16_t chr_val_handle,
+                            const struct ble_gatt_dsc *dsc);
+int ble_gattc_cache_svcs_done(uint16_t conn_handle);
+int ble_gattc_cache_chrs_done(uint16_t conn_handle, uint16_t start_handle,
+                              uint16_t end_handle);
+int ble_gattc_cache_dscs_done(uint16_t conn_handle, uint16_t chr_val_handle,
+                              uint16_t end_handle);
+void ble_gattc_cache_rx_indicate(uint16_t conn_handle, uint16_t attr_handle);
+
 /*** @server. */
 #define BLE_GATTS_CLT_CFG_F_NOTIFY              0x0001
 #define BLE_GATTS_CLT_CFG_F_INDICATE            0x0002
@@ -36,9 +36,10 @@
  * Notes on thread-safety:
  * 1. The ble_hs mutex must never be locked when an application callback is
  *    executed.  A callback is free to initiate additional host procedures.
- * 2. The only resource protected by the mutex is the list of active procedures
- *    (ble_gattc_procs).  Thread-safety is achieved by locking the mutex during
- *    removal and insertion operations.  Procedure objects are only modified
+ * 2. The only resources protected by the mutex are the lists of active
+ *    procedures (ble_gattc_procs, ble_gattc_stalled_procs and
+ *    ble_gattc_exp_procs).  Thread-safety is achieved by locking the mutex
+ *    during removal and insertion operations.  Procedure objects are only modified
  *    while they are not in the list.  This is sufficient, as the host parent
  *    task is the only task which inspects or modifies individual procedure
  *    entries.  Tasks have the following permissions regarding procedure
@@ -91,12 +92,26 @@
 /** Procedure stalled due to resource exhaustion. */
 #define BLE_GATTC_PROC_F_STALLED                0x01
 
+/** Procedure is answered from the GATT cache. */
+#define BLE_GATTC_PROC_F_CACHED                 0x02
+
+/** Procedure results are added to the GATT cache. */
+#define BLE_GATTC_PROC_F_CACHE_FILL             0x04
+
 /** Represents an in-progress GATT procedure. */
 struct ble_gattc_proc {
+    /* Connection list or stalled list membership. */
     STAILQ_ENTRY(ble_gattc_proc) next;
 
+    /* Expiration list membership. */
+    TAILQ_ENTRY(ble_gattc_proc) exp_next;
+
     uint32_t exp_os_ticks;
     uint16_t conn_handle;
+
+    /* ATT bearer the requests are sent over; 0 until the first request. */
+    uint16_t cid;
+
     uint8_t op;
     uint8_t flags;
 
@@ -131,6 +146,7 @@ struct ble_gattc_proc {
         } find_inc_svcs;
 
         struct {
+            uint16_t start_handle;
             uint16_t prev_handle;
             uint16_t end_handle;
             ble_gatt_chr_fn *cb;
@@ -210,6 +226,15 @@ struct ble_gattc_proc {
 };
 
 STAILQ_HEAD(ble_gattc_proc_list, ble_gattc_proc);
+TAILQ_HEAD(ble_gattc_proc_exp_list, ble_gattc_proc);
+
+/**
+ * Number of per-connection procedure lists.  Procedures are hashed into these
+ * lists by connection handle, so that response processing only needs to look
+ * at the procedures of the receiving connection.
+ */
+#define BLE_GATTC_PROC_BUCKETS                                              \
+    max(MYNEWT_VAL(BLE_MAX_CONNECTIONS), 1)
 
 /**
  * Error functions - these handle an incoming ATT error response and apply it
@@ -412,8 +437,16 @@ static os_membuf_t ble_gattc_proc_mem[
 
 static struct os_mempool ble_gattc_proc_pool;
 
-/* The list of active GATT client procedures. */
-static struct ble_gattc_proc_list ble_gattc_procs;
+/* Active GATT client procedures waiting for a response, hashed by connection
+ * handle.
+ */
+static struct ble_gattc_proc_list ble_gattc_procs[BLE_GATTC_PROC_BUCKETS];
+
+/* Procedures waiting to be resumed; these do not expect any response. */
+static struct ble_gattc_proc_list ble_gattc_stalled_procs;
+
+/* All inserted procedures, sorted by expiration time. */
+static struct ble_gattc_proc_exp_list ble_gattc_exp_procs;
 
 /* The time when we should attempt to resume stalled procedures, in OS ticks.
  * A value of 0 indicates no stalled procedures.
@@ -447,6 +480,9 @@ STATS_NAME_START(ble_gattc_stats)
     STATS_NAME(ble_gattc_stats, read_mult_fail)
     STATS_NAME(ble_gattc_stats, write_no_rsp)
     STATS_NAME(ble_gattc_stats, write_no_rsp_fail)
+    STATS_NAME(ble_gattc_stats, write_no_rsp_stream)
+    STATS_NAME(ble_gattc_stats, write_no_rsp_stream_busy)
+    STATS_NAME(ble_gattc_stats, write_no_rsp_stream_bytes)
     STATS_NAME(ble_gattc_stats, write)
     STATS_NAME(ble_gattc_stats, write_fail)
     STATS_NAME(ble_gattc_stats, write_long)
@@ -458,6 +494,8 @@ STATS_NAME_START(ble_gattc_stats)
     STATS_NAME(ble_gattc_stats, indicate)
     STATS_NAME(ble_gattc_stats, indicate_fail)
     STATS_NAME(ble_gattc_stats, proc_timeout)
+    STATS_NAME(ble_gattc_stats, cache_hit)
+    STATS_NAME(ble_gattc_stats, cache_miss)
 STATS_NAME_END(ble_gattc_stats)
 
 /*****************************************************************************
@@ -472,7 +510,7 @@ ble_gattc_dbg_assert_proc_not_inserted(struct ble_gattc_proc *proc)
 
     ble_hs_lock();
 
-    STAILQ_FOREACH(cur, &ble_gattc_procs, next) {
+    TAILQ_FOREACH(cur, &ble_gattc_exp_procs, exp_next) {
         BLE_HS_DBG_ASSERT(cur != proc);
     }
 
@@ -718,16 +756,145 @@ ble_gattc_proc_free(struct ble_gattc_proc *proc)
     }
 }
 
+static struct ble_gattc_proc_list *
+ble_gattc_conn_procs(uint16_t conn_handle)
+{
+    return &ble_gattc_procs[conn_handle % BLE_GATTC_PROC_BUCKETS];
+}
+
+/**
+ * Retrieves the list the specified proc belongs to while it is inserted.
+ */
+static struct ble_gattc_proc_list *
+ble_gattc_proc_list_get(const struct ble_gattc_proc *proc)
+{
+    if (proc->flags & BLE_GATTC_PROC_F_STALLED) {
+        return &ble_gattc_stalled_procs;
+    } else {
+        return ble_gattc_conn_procs(proc->conn_handle);
+    }
+}
+
+#if MYNEWT_VAL(BLE_EATT_CHAN_NUM) > 0
+/**
+ * Selects the ATT bearer for a new procedure.  The bearer with the fewest
+ * requests in flight is used; ties are resolved in favor of the enhanced
+ * bearers, as the unenhanced bearer also carries MTU exchanges and
+ * indications.
+ */
+static uint16_t
+ble_gattc_bearer_pick(uint16_t conn_handle)
+{
+    uint16_t cids[MYNEWT_VAL(BLE_EATT_CHAN_NUM) + 1];
+    int load[MYNEWT_VAL(BLE_EATT_CHAN_NUM) + 1];
+    struct ble_gattc_proc *proc;
+    int num_cids;
+    int best;
+    int i;
+
+    num_cids = ble_eatt_bearers(conn_handle, cids,
+                                MYNEWT_VAL(BLE_EATT_CHAN_NUM));
+    if (num_cids == 0) {
+        return BLE_L2CAP_CID_ATT;
+    }
+    cids[num_cids++] = BLE_L2CAP_CID_ATT;
+
+    memset(load, 0, sizeof load);
+
+    ble_hs_lock();
+
+    STAILQ_FOREACH(proc, ble_gattc_conn_procs(conn_handle), next) {
+        if (proc->conn_handle != conn_handle) {
+            continue;
+        }
+        for (i = 0; i < num_cids; i++) {
+            if (proc->cid == cids[i]) {
+                load[i]++;
+                break;
+            }
+        }
+    }
+
+    ble_hs_unlock();
+
+    best = 0;
+    for (i = 1; i < num_cids; i++) {
+        if (load[i] < load[best]) {
+            best = i;
+        }
+    }
+
+    return cids[best];
+}
+#else
+#define ble_gattc_bearer_pick(conn_handle) BLE_L2CAP_CID_ATT
+#endif
+
+/**
+ * Retrieves the ATT bearer the specified proc sends its requests over.  The
+ * bearer is selected when the first request is sent and kept for the
+ * lifetime of the proc.
+ */
+static uint16_t
+ble_gattc_proc_bearer(struct ble_gattc_proc *proc)
+{
+    if (proc->cid == 0) {
+        proc->cid = ble_gattc_bearer_pick(proc->conn_handle);
+    }
+
+    return proc->cid;
+}
+
 static void
 ble_gattc_proc_insert(struct ble_gattc_proc *proc)
 {
+    struct ble_gattc_proc *prev;
+
     ble_gattc_dbg_assert_proc_not_inserted(proc);
 
     ble_hs_lock();
-    STAILQ_INSERT_TAIL(&ble_gattc_procs, proc, next);
+
+    STAILQ_INSERT_TAIL(ble_gattc_proc_list_get(proc), proc, next);
+
+    /* Keep the expiration list sorted.  All procedures use the same timeout,
+     * so a freshly armed timer always belongs at the tail; only a stalled
+     * procedure, which keeps its original timer, needs to walk back.
+     */
+    TAILQ_FOREACH_REVERSE(prev, &ble_gattc_exp_procs,
+                          ble_gattc_proc_exp_list, exp_next) {
+        if ((int32_t)(proc->exp_os_ticks - prev->exp_os_ticks) >= 0) {
+            break;
+        }
+    }
+    if (prev == NULL) {
+        TAILQ_INSERT_HEAD(&ble_gattc_exp_procs, proc, exp_next);
+    } else {
+        TAILQ_INSERT_AFTER(&ble_gattc_exp_procs, prev, proc, exp_next);
+    }
+
     ble_hs_unlock();
 }
 
+/**
+ * Removes the specified proc from the list it belongs to and from the
+ * expiration list.  The lock must be held.
+ */
+static void
+ble_gattc_proc_remove(struct ble_gattc_proc *proc,
+                      struct ble_gattc_proc *prev)
+{
+    struct ble_gattc_proc_list *list;
+
+    list = ble_gattc_proc_list_get(proc);
+    if (prev == NULL) {
+        STAILQ_REMOVE(list, proc, ble_gattc_proc, next);
+    } else {
+        STAILQ_REMOVE_AFTER(list, prev, next);
+    }
+
+    TAILQ_REMOVE(&ble_gattc_exp_procs, proc, exp_next);
+}
+
 static void
 ble_gattc_proc_set_exp_timer(struct ble_gattc_proc *proc)
 {
@@ -795,6 +962,45 @@ ble_gattc_process_resume_status(struct ble_gattc_proc *proc, int status)
     }
 }
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+/**
+ * Applies the result of a GATT cache lookup to a new discovery proc.  On a
+ * hit, the proc is marked as stalled so that it gets answered from the cache
+ * by the next resume pass, which is scheduled immediately.  This keeps the
+ * application callbacks asynchronous, as they are for procedures that go
+ * over the air.  On a miss, the procedure results are added to the cache as
+ * they arrive.
+ *
+ * @return                      1 if the proc is answered from the cache;
+ *                              0 if it needs to go over the air.
+ */
+static int
+ble_gattc_cache_lookup(struct ble_gattc_proc *proc, int cache_status)
+{
+    switch (cache_status) {
+    case 0:
+        STATS_INC(ble_gattc_stats, cache_hit);
+
+        ble_gattc_proc_set_exp_timer(proc);
+        proc->flags |= BLE_GATTC_PROC_F_CACHED | BLE_GATTC_PROC_F_STALLED;
+
+        ble_gattc_resume_at = ble_npl_time_get();
+        if (ble_gattc_resume_at == 0) {
+            ble_gattc_resume_at++;
+        }
+        return 1;
+
+    case BLE_HS_ENOENT:
+        STATS_INC(ble_gattc_stats, cache_miss);
+        proc->flags |= BLE_GATTC_PROC_F_CACHE_FILL;
+        return 0;
+
+    default:
+        return 0;
+    }
+}
+#endif
+
 /*****************************************************************************
  * $util                                                                     *
  *****************************************************************************/
@@ -830,6 +1036,7 @@ typedef int ble_gattc_match_fn(struct ble_gattc_proc *proc, void *arg);
 
 struct ble_gattc_criteria_conn_op {
     uint16_t conn_handle;
+    uint16_t cid;
     uint8_t op;
 };
 
@@ -838,6 +1045,8 @@ struct ble_gattc_criteria_conn_op {
  *
  * @param proc                  The procedure to test.
  * @param conn_handle           The connection handle to match against.
+ * @param cid                   The ATT bearer to match against, or 0 to
+ *                                  ignore this criterion.
  * @param op                    The op code to match against, or
  *                                  BLE_GATT_OP_NONE to ignore this criterion.
  *
@@ -854,42 +1063,20 @@ ble_gattc_proc_matches_conn_op(struct ble_gattc_proc *proc, void *arg)
         return 0;
     }
 
-    if (criteria->op != proc->op && criteria->op != BLE_GATT_OP_NONE) {
+    if (criteria->cid != 0 && criteria->cid != proc->cid) {
         return 0;
     }
 
-    return 1;
-}
-
-struct ble_gattc_criteria_exp {
-    ble_npl_time_t now;
-    int32_t next_exp_in;
-};
-
-static int
-ble_gattc_proc_matches_expired(struct ble_gattc_proc *proc, void *arg)
-{
-    struct ble_gattc_criteria_exp *criteria;
-    int32_t time_diff;
-
-    criteria = arg;
-
-    time_diff = proc->exp_os_ticks - criteria->now;
-
-    if (time_diff <= 0) {
-        /* Procedure is expired. */
-        return 1;
+    if (criteria->op != proc->op && criteria->op != BLE_GATT_OP_NONE) {
+        return 0;
     }
 
-    /* Procedure isn't expired; determine if it is the next to expire. */
-    if (time_diff < criteria->next_exp_in) {
-        criteria->next_exp_in = time_diff;
-    }
-    return 0;
+    return 1;
 }
 
 struct ble_gattc_criteria_conn_rx_entry {
     uint16_t conn_handle;
+    uint16_t cid;
     const void *rx_entries;
     int num_rx_entries;
     const void *matching_rx_entry;
@@ -902,8 +1089,8 @@ ble_gattc_proc_matches_conn_rx_entry(struct ble_gattc_proc *proc, void *arg)
 
     criteria = arg;
 
-    if (criteria->conn_handle != BLE_HS_CONN_HANDLE_NONE &&
-        criteria->conn_handle != proc->conn_handle) {
+    if (criteria->conn_handle != proc->conn_handle ||
+        criteria->cid != proc->cid) {
 
         return 0;
     }
@@ -915,8 +1102,15 @@ ble_gattc_proc_matches_conn_rx_entry(struct ble_gattc_proc *proc, void *arg)
     return 1;
 }
 
-static void
-ble_gattc_extract(ble_gattc_match_fn *cb, void *arg, int max_procs,
+/**
+ * Removes procs matching the specified criteria from the specified list and
+ * appends them to the destination list.
+ *
+ * @return                      The number of extracted procs.
+ */
+static int
+ble_gattc_extract(struct ble_gattc_proc_list *list, ble_gattc_match_fn *cb,
+                  void *arg, int max_procs,
                   struct ble_gattc_proc_list *dst_list)
 {
     struct ble_gattc_proc *proc;
@@ -927,29 +1121,22 @@ ble_gattc_extract(ble_gattc_match_fn *cb, void *arg, int max_procs,
     /* Only the parent task is allowed to remove entries from the list. */
     BLE_HS_DBG_ASSERT(ble_hs_is_parent_task());
 
-    STAILQ_INIT(dst_list);
     num_extracted = 0;
 
     ble_hs_lock();
 
     prev = NULL;
-    proc = STAILQ_FIRST(&ble_gattc_procs);
+    proc = STAILQ_FIRST(list);
     while (proc != NULL) {
         next = STAILQ_NEXT(proc, next);
 
         if (cb(proc, arg)) {
-            if (prev == NULL) {
-                STAILQ_REMOVE_HEAD(&ble_gattc_procs, next);
-            } else {
-                STAILQ_REMOVE_AFTER(&ble_gattc_procs, prev, next);
-            }
+            ble_gattc_proc_remove(proc, prev);
             STAILQ_INSERT_TAIL(dst_list, proc, next);
 
-            if (max_procs > 0) {
-                num_extracted++;
-                if (num_extracted >= max_procs) {
-                    break;
-                }
+            num_extracted++;
+            if (max_procs > 0 && num_extracted >= max_procs) {
+                break;
             }
         } else {
             prev = proc;
@@ -959,94 +1146,141 @@ ble_gattc_extract(ble_gattc_match_fn *cb, void *arg, int max_procs,
     }
 
     ble_hs_unlock();
-}
-
-static struct ble_gattc_proc *
-ble_gattc_extract_one(ble_gattc_match_fn *cb, void *arg)
-{
-    struct ble_gattc_proc_list dst_list;
 
-    ble_gattc_extract(cb, arg, 1, &dst_list);
-    return STAILQ_FIRST(&dst_list);
+    return num_extracted;
 }
 
+/**
+ * Extracts the procs of the specified connection and ATT bearer (0 for all
+ * bearers) with the specified op code, including stalled procs.
+ */
 static void
-ble_gattc_extract_by_conn_op(uint16_t conn_handle, uint8_t op,
+ble_gattc_extract_by_conn_op(uint16_t conn_handle, uint16_t cid, uint8_t op,
                              struct ble_gattc_proc_list *dst_list)
 {
     struct ble_gattc_criteria_conn_op criteria;
 
     criteria.conn_handle = conn_handle;
+    criteria.cid = cid;
     criteria.op = op;
 
-    ble_gattc_extract(ble_gattc_proc_matches_conn_op, &criteria, 0, dst_list);
+    STAILQ_INIT(dst_list);
+    ble_gattc_extract(ble_gattc_conn_procs(conn_handle),
+                      ble_gattc_proc_matches_conn_op, &criteria, 0, dst_list);
+    ble_gattc_extract(&ble_gattc_stalled_procs,
+                      ble_gattc_proc_matches_conn_op, &criteria, 0, dst_list);
 }
 
+/**
+ * Extracts the first proc of the specified connection with the specified op
+ * code that is waiting for a response on the specified ATT bearer.  Stalled
+ * procs have no request in flight, so they never match.
+ */
 static struct ble_gattc_proc *
-ble_gattc_extract_first_by_conn_op(uint16_t conn_handle, uint8_t op)
+ble_gattc_extract_first_by_conn_op(uint16_t conn_handle, uint16_t cid,
+                                   uint8_t op)
 {
+    struct ble_gattc_criteria_conn_op criteria;
     struct ble_gattc_proc_list dst_list;
 
-    ble_gattc_extract_by_conn_op(conn_handle, op, &dst_list);
-    return STAILQ_FIRST(&dst_list);
-}
+    criteria.conn_handle = conn_handle;
+    criteria.cid = cid;
+    criteria.op = op;
 
-static int
-ble_gattc_proc_matches_stalled(struct ble_gattc_proc *proc, void *unused)
-{
-    return proc->flags & BLE_GATTC_PROC_F_STALLED;
+    STAILQ_INIT(&dst_list);
+    ble_gattc_extract(ble_gattc_conn_procs(conn_handle),
+                      ble_gattc_proc_matches_conn_op, &criteria, 1, &dst_list);
+
+    return STAILQ_FIRST(&dst_list);
 }
 
 static void
 ble_gattc_extract_stalled(struct ble_gattc_proc_list *dst_list)
 {
-    ble_gattc_extract(ble_gattc_proc_matches_stalled, NULL, 0, dst_list);
+    struct ble_gattc_proc *proc;
+
+    STAILQ_INIT(dst_list);
+
+    ble_hs_lock();
+
+    while ((proc = STAILQ_FIRST(&ble_gattc_stalled_procs)) != NULL) {
+        ble_gattc_proc_remove(proc, NULL);
+        STAILQ_INSERT_TAIL(dst_list, proc, next);
+    }
+
+    ble_hs_unlock();
 }
 
 /**
+ * Extracts expired procs.  As the expiration list is sorted, only the expired
+ * procs and the one that expires next are inspected.
+ *
  * @return                      The number of ticks until the next expiration
  *                                  occurs.
  */
 static int32_t
 ble_gattc_extract_expired(struct ble_gattc_proc_list *dst_list)
 {
-    struct ble_gattc_criteria_exp criteria;
+    struct ble_gattc_proc *proc;
+    ble_npl_time_t now;
+    int32_t next_exp_in;
+    int32_t time_diff;
 
-    criteria.now = ble_npl_time_get();
-    criteria.next_exp_in = BLE_HS_FOREVER;
+    BLE_HS_DBG_ASSERT(ble_hs_is_parent_task());
+
+    now = ble_npl_time_get();
+    next_exp_in = BLE_HS_FOREVER;
 
     STAILQ_INIT(dst_list);
-    ble_gattc_extract(ble_gattc_proc_matches_expired, &criteria, 0, dst_list);
 
-    return criteria.next_exp_in;
+    ble_hs_lock();
+
+    while ((proc = TAILQ_FIRST(&ble_gattc_exp_procs)) != NULL) {
+        time_diff = proc->exp_os_ticks - now;
+        if (time_diff > 0) {
+            next_exp_in = time_diff;
+            break;
+        }
+
+        ble_gattc_proc_remove(proc, NULL);
+        STAILQ_INSERT_TAIL(dst_list, proc, next);
+    }
+
+    ble_hs_unlock();
+
+    return next_exp_in;
 }
 
 static struct ble_gattc_proc *
-ble_gattc_extract_with_rx_entry(uint16_t conn_handle,
+ble_gattc_extract_with_rx_entry(uint16_t conn_handle, uint16_t cid,
                                 const void *rx_entries, int num_rx_entries,
                                 const void **out_rx_entry)
 {
     struct ble_gattc_criteria_conn_rx_entry criteria;
-    struct ble_gattc_proc *proc;
+    struct ble_gattc_proc_list dst_list;
 
     criteria.conn_handle = conn_handle;
+    criteria.cid = cid;
     criteria.rx_entries = rx_entries;
     criteria.num_rx_entries = num_rx_entries;
     criteria.matching_rx_entry = NULL;
 
-    proc = ble_gattc_extract_one(ble_gattc_proc_matches_conn_rx_entry,
-                                 &criteria);
+    STAILQ_INIT(&dst_list);
+    ble_gattc_extract(ble_gattc_conn_procs(conn_handle),
+                      ble_gattc_proc_matches_conn_rx_entry, &criteria, 1,
+                      &dst_list);
     *out_rx_entry = criteria.matching_rx_entry;
 
-    return proc;
+    return STAILQ_FIRST(&dst_list);
 }
 
 /**
- * Searches the main proc list for an entry whose connection handle and op code
- * match those specified.  If a matching entry is found, it is removed from the
+ * Searches the proc list of the connection for an entry whose op code matches
+ * the incoming response.  If a matching entry is found, it is removed from the
  * list and returned.
  *
  * @param conn_handle           The connection handle to match against.
+ * @param cid                   The ATT bearer the response was received on.
  * @param rx_entries            The array of rx entries corresponding to the
  *                                  op code of the incoming response.
  * @param out_rx_entry          On success, the address of the matching rx
@@ -1055,9 +1289,10 @@ ble_gattc_extract_with_rx_entry(uint16_t conn_handle,
  * @return                      The matching proc entry on success;
  *                                  null on failure.
  */
-#define BLE_GATTC_RX_EXTRACT_RX_ENTRY(conn_handle, rx_entries, out_rx_entry)  \
+#define BLE_GATTC_RX_EXTRACT_RX_ENTRY(conn_handle, cid, rx_entries,          \
+                                      out_rx_entry)                           \
     ble_gattc_extract_with_rx_entry(                                          \
-        (conn_handle), (rx_entries),                                          \
+        (conn_handle), (cid), (rx_entries),                                   \
         sizeof (rx_entries) / sizeof (rx_entries)[0],                         \
         (const void **)(out_rx_entry))
 
@@ -1067,7 +1302,8 @@ ble_gattc_extract_with_rx_entry(uint16_t conn_handle,
  * specified status code.
  */
 static void
-ble_gattc_fail_procs(uint16_t conn_handle, uint8_t op, int status)
+ble_gattc_fail_procs(uint16_t conn_handle, uint16_t cid, uint8_t op,
+                     int status)
 {
     struct ble_gattc_proc_list temp_list;
     struct ble_gattc_proc *proc;
@@ -1076,7 +1312,7 @@ ble_gattc_fail_procs(uint16_t conn_handle, uint8_t op, int status)
     /* Remove all procs with the specified conn handle-op-pair and insert them
      * into the temporary list.
      */
-    ble_gattc_extract_by_conn_op(conn_handle, op, &temp_list);
+    ble_gattc_extract_by_conn_op(conn_handle, cid, op, &temp_list);
 
     /* Notify application of failed procedures and free the corresponding proc
      * entries.
@@ -1103,7 +1339,12 @@ ble_gattc_resume_procs(void)
 
     ble_gattc_extract_stalled(&stall_list);
 
-    STAILQ_FOREACH(proc, &stall_list, next) {
+    /* Each proc is unlinked before it is resumed, as resuming may free it or
+     * reinsert it into the main list.
+     */
+    while ((proc = STAILQ_FIRST(&stall_list)) != NULL) {
+        STAILQ_REMOVE_HEAD(&stall_list, next);
+
         resume_cb = ble_gattc_resume_dispatch_get(proc->op);
         BLE_HS_DBG_ASSERT(resume_cb != NULL);
 
@@ -1274,8 +1515,12 @@ ble_gattc_mtu_tx(struct ble_gattc_proc *proc)
     uint16_t mtu;
     int rc;
 
+    /* MTU exchange is only allowed on the unenhanced ATT bearer. */
+    proc->cid = BLE_L2CAP_CID_ATT;
+
     ble_hs_lock();
-    rc = ble_att_conn_chan_find(proc->conn_handle, &conn, &chan);
+    rc = ble_att_conn_chan_find(proc->conn_handle, BLE_L2CAP_CID_ATT, &conn,
+                                &chan);
     if (rc == 0) {
         mtu = chan->my_mtu;
     }
@@ -1349,6 +1594,14 @@ ble_gattc_disc_all_svcs_cb(struct ble_gattc_proc *proc,
         STATS_INC(ble_gattc_stats, disc_all_svcs_fail);
     }
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    if (status == BLE_HS_EDONE &&
+        proc->flags & BLE_GATTC_PROC_F_CACHE_FILL) {
+
+        ble_gattc_cache_svcs_done(proc->conn_handle);
+    }
+#endif
+
     if (proc->disc_all_svcs.cb == NULL) {
         rc = 0;
     } else {
@@ -1381,6 +1634,7 @@ ble_gattc_disc_all_svcs_tx(struct ble_gattc_proc *proc)
     ble_gattc_dbg_assert_proc_not_inserted(proc);
 
     rc = ble_att_clt_tx_read_group_type(proc->conn_handle,
+                                        ble_gattc_proc_bearer(proc),
                                         proc->disc_all_svcs.prev_handle + 1,
                                         0xffff, &uuid.u);
     if (rc != 0) {
@@ -1390,12 +1644,50 @@ ble_gattc_disc_all_svcs_tx(struct ble_gattc_proc *proc)
     return 0;
 }
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+/**
+ * Reports the cached services of the peer for the specified
+ * discover-all-services proc.
+ */
+static int
+ble_gattc_disc_all_svcs_cache_tx(struct ble_gattc_proc *proc)
+{
+    struct ble_gatt_svc service;
+    int rc;
+
+    while (1) {
+        rc = ble_gattc_cache_next_svc(proc->conn_handle,
+                                      proc->disc_all_svcs.prev_handle,
+                                      &service);
+        if (rc != 0) {
+            break;
+        }
+        proc->disc_all_svcs.prev_handle = service.start_handle;
+
+        rc = ble_gattc_disc_all_svcs_cb(proc, 0, 0, &service);
+        if (rc != 0) {
+            return BLE_HS_EDONE;
+        }
+    }
+
+    /* rc is BLE_HS_EDONE once all services were reported. */
+    ble_gattc_disc_all_svcs_cb(proc, rc, 0, NULL);
+    return BLE_HS_EDONE;
+}
+#endif
+
 static int
 ble_gattc_disc_all_svcs_resume(struct ble_gattc_proc *proc)
 {
     int status;
     int rc;
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    if (proc->flags & BLE_GATTC_PROC_F_CACHED) {
+        return ble_gattc_disc_all_svcs_cache_tx(proc);
+    }
+#endif
+
     status = ble_gattc_disc_all_svcs_tx(proc);
     rc = ble_gattc_process_resume_status(proc, status);
     if (rc != 0) {
@@ -1466,6 +1758,14 @@ ble_gattc_disc_all_svcs_rx_adata(struct ble_gattc_proc *proc,
 
     rc = 0;
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    if (proc->flags & BLE_GATTC_PROC_F_CACHE_FILL &&
+        ble_gattc_cache_add_svc(proc->conn_handle, &service) != 0) {
+
+        proc->flags &= ~BLE_GATTC_PROC_F_CACHE_FILL;
+    }
+#endif
+
 done:
     cbrc = ble_gattc_disc_all_svcs_cb(proc, rc, 0, &service);
     if (rc != 0 || cbrc != 0) {
@@ -1533,6 +1833,14 @@ ble_gattc_disc_all_svcs(uint16_t conn_handle, ble_gatt_disc_svc_fn *cb,
 
     ble_gattc_log_proc_init("discover all services\n");
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    if (ble_gattc_cache_lookup(proc,
+                               ble_gattc_cache_svcs_cached(conn_handle))) {
+        rc = 0;
+        goto done;
+    }
+#endif
+
     rc = ble_gattc_disc_all_svcs_tx(proc);
     if (rc != 0) {
         goto done;
@@ -1606,6 +1914,7 @@ ble_gattc_disc_svc_uuid_tx(struct ble_gattc_proc *proc)
 
     ble_uuid_flat(&proc->disc_svc_uuid.service_uuid.u, val);
     rc = ble_att_clt_tx_find_type_value(proc->conn_handle,
+                                        ble_gattc_proc_bearer(proc),
                                         proc->disc_svc_uuid.prev_handle + 1,
                                         0xffff, BLE_ATT_UUID_PRIMARY_SERVICE,
                                         val,
@@ -1821,6 +2130,7 @@ ble_gattc_find_inc_svcs_tx(struct ble_gattc_proc *proc)
     if (proc->find_inc_svcs.cur_start == 0) {
         /* Find the next included service. */
         rc = ble_att_clt_tx_read_type(proc->conn_handle,
+                                      ble_gattc_proc_bearer(proc),
                                       proc->find_inc_svcs.prev_handle + 1,
                                       proc->find_inc_svcs.end_handle, &uuid.u);
         if (rc != 0) {
@@ -1828,7 +2138,7 @@ ble_gattc_find_inc_svcs_tx(struct ble_gattc_proc *proc)
         }
     } else {
         /* Read the UUID of the previously found service. */
-        rc = ble_att_clt_tx_read(proc->conn_handle,
+        rc = ble_att_clt_tx_read(proc->conn_handle, ble_gattc_proc_bearer(proc),
                                  proc->find_inc_svcs.cur_start);
         if (rc != 0) {
             return rc;
@@ -2099,6 +2409,16 @@ ble_gattc_disc_all_chrs_cb(struct ble_gattc_proc *proc, int status,
         STATS_INC(ble_gattc_stats, disc_all_chrs_fail);
     }
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    if (status == BLE_HS_EDONE &&
+        proc->flags & BLE_GATTC_PROC_F_CACHE_FILL) {
+
+        ble_gattc_cache_chrs_done(proc->conn_handle,
+                                  proc->disc_all_chrs.start_handle,
+                                  proc->disc_all_chrs.end_handle);
+    }
+#endif
+
     if (proc->disc_all_chrs.cb == NULL) {
         rc = 0;
     } else {
@@ -2132,6 +2452,7 @@ ble_gattc_disc_all_chrs_tx(struct ble_gattc_proc *proc)
     ble_gattc_dbg_assert_proc_not_inserted(proc);
 
     rc = ble_att_clt_tx_read_type(proc->conn_handle,
+                                  ble_gattc_proc_bearer(proc),
                                   proc->disc_all_chrs.prev_handle + 1,
                                   proc->disc_all_chrs.end_handle, &uuid.u);
     if (rc != 0) {
@@ -2141,12 +2462,50 @@ ble_gattc_disc_all_chrs_tx(struct ble_gattc_proc *proc)
     return 0;
 }
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+/**
+ * Reports the cached characteristics of the service for the specified
+ * discover-all-characteristics proc.
+ */
+static int
+ble_gattc_disc_all_chrs_cache_tx(struct ble_gattc_proc *proc)
+{
+    struct ble_gatt_chr chr;
+    int rc;
+
+    while (1) {
+        rc = ble_gattc_cache_next_chr(proc->conn_handle,
+                                      proc->disc_all_chrs.prev_handle,
+                                      proc->disc_all_chrs.end_handle, &chr);
+        if (rc != 0) {
+            break;
+        }
+        proc->disc_all_chrs.prev_handle = chr.def_handle;
+
+        rc = ble_gattc_disc_all_chrs_cb(proc, 0, 0, &chr);
+        if (rc != 0) {
+            return BLE_HS_EDONE;
+        }
+    }
+
+    /* rc is BLE_HS_EDONE once all characteristics were reported. */
+    ble_gattc_disc_all_chrs_cb(proc, rc, 0, NULL);
+    return BLE_HS_EDONE;
+}
+#endif
+
 static int
 ble_gattc_disc_all_chrs_resume(struct ble_gattc_proc *proc)
 {
     int status;
     int rc;
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    if (proc->flags & BLE_GATTC_PROC_F_CACHED) {
+        return ble_gattc_disc_all_chrs_cache_tx(proc);
+    }
+#endif
+
     status = ble_gattc_disc_all_chrs_tx(proc);
     rc = ble_gattc_process_resume_status(proc, status);
     if (rc != 0) {
@@ -2220,6 +2579,14 @@ ble_gattc_disc_all_chrs_rx_adata(struct ble_gattc_proc *proc,
 
     rc = 0;
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    if (proc->flags & BLE_GATTC_PROC_F_CACHE_FILL &&
+        ble_gattc_cache_add_chr(proc->conn_handle, &chr) != 0) {
+
+        proc->flags &= ~BLE_GATTC_PROC_F_CACHE_FILL;
+    }
+#endif
+
 done:
     cbrc = ble_gattc_disc_all_chrs_cb(proc, rc, 0, &chr);
     if (rc != 0 || cbrc != 0) {
@@ -2281,6 +2648,7 @@ ble_gattc_disc_all_chrs(uint16_t conn_handle, uint16_t start_handle,
 
     proc->op = BLE_GATT_OP_DISC_ALL_CHRS;
     proc->conn_handle = conn_handle;
+    proc->disc_all_chrs.start_handle = start_handle;
     proc->disc_all_chrs.prev_handle = start_handle - 1;
     proc->disc_all_chrs.end_handle = end_handle;
     proc->disc_all_chrs.cb = cb;
@@ -2288,6 +2656,16 @@ ble_gattc_disc_all_chrs(uint16_t conn_handle, uint16_t start_handle,
 
     ble_gattc_log_disc_all_chrs(proc);
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    if (ble_gattc_cache_lookup(proc,
+                               ble_gattc_cache_chrs_cached(conn_handle,
+                                                           start_handle,
+                                                           end_handle))) {
+        rc = 0;
+        goto done;
+    }
+#endif
+
     rc = ble_gattc_disc_all_chrs_tx(proc);
     if (rc != 0) {
         goto done;
@@ -2360,6 +2738,7 @@ ble_gattc_disc_chr_uuid_tx(struct ble_gattc_proc *proc)
     ble_gattc_dbg_assert_proc_not_inserted(proc);
 
     rc = ble_att_clt_tx_read_type(proc->conn_handle,
+                                  ble_gattc_proc_bearer(proc),
                                   proc->disc_chr_uuid.prev_handle + 1,
                                   proc->disc_chr_uuid.end_handle, &uuid.u);
     if (rc != 0) {
@@ -2567,6 +2946,16 @@ ble_gattc_disc_all_dscs_cb(struct ble_gattc_proc *proc, int status,
         STATS_INC(ble_gattc_stats, disc_all_dscs_fail);
     }
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    if (status == BLE_HS_EDONE &&
+        proc->flags & BLE_GATTC_PROC_F_CACHE_FILL) {
+
+        ble_gattc_cache_dscs_done(proc->conn_handle,
+                                  proc->disc_all_dscs.chr_val_handle,
+                                  proc->disc_all_dscs.end_handle);
+    }
+#endif
+
     if (proc->disc_all_dscs.cb == NULL) {
         rc = 0;
     } else {
@@ -2599,6 +2988,7 @@ ble_gattc_disc_all_dscs_tx(struct ble_gattc_proc *proc)
     ble_gattc_dbg_assert_proc_not_inserted(proc);
 
     rc = ble_att_clt_tx_find_info(proc->conn_handle,
+                                  ble_gattc_proc_bearer(proc),
                                   proc->disc_all_dscs.prev_handle + 1,
                                   proc->disc_all_dscs.end_handle);
     if (rc != 0) {
@@ -2608,12 +2998,51 @@ ble_gattc_disc_all_dscs_tx(struct ble_gattc_proc *proc)
     return 0;
 }
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+/**
+ * Reports the cached descriptors of the characteristic for the specified
+ * discover-all-descriptors proc.
+ */
+static int
+ble_gattc_disc_all_dscs_cache_tx(struct ble_gattc_proc *proc)
+{
+    struct ble_gatt_dsc dsc;
+    int rc;
+
+    while (1) {
+        rc = ble_gattc_cache_next_dsc(proc->conn_handle,
+                                      proc->disc_all_dscs.chr_val_handle,
+                                      proc->disc_all_dscs.prev_handle,
+                                      proc->disc_all_dscs.end_handle, &dsc);
+        if (rc != 0) {
+            break;
+        }
+        proc->disc_all_dscs.prev_handle = dsc.handle;
+
+        rc = ble_gattc_disc_all_dscs_cb(proc, 0, 0, &dsc);
+        if (rc != 0) {
+            return BLE_HS_EDONE;
+        }
+    }
+
+    /* rc is BLE_HS_EDONE once all descriptors were reported. */
+    ble_gattc_disc_all_dscs_cb(proc, rc, 0, NULL);
+    return BLE_HS_EDONE;
+}
+#endif
+
 static int
 ble_gattc_disc_all_dscs_resume(struct ble_gattc_proc *proc)
 {
     int status;
     int rc;
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    if (proc->flags & BLE_GATTC_PROC_F_CACHED) {
+        return ble_gattc_disc_all_dscs_cache_tx(proc);
+    }
+#endif
+
     status = ble_gattc_disc_all_dscs_tx(proc);
     rc = ble_gattc_process_resume_status(proc, status);
     if (rc != 0) {
@@ -2669,6 +3098,16 @@ done:
     dsc.handle = idata->attr_handle;
     dsc.uuid = idata->uuid;
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    if (rc == 0 && proc->flags & BLE_GATTC_PROC_F_CACHE_FILL &&
+        ble_gattc_cache_add_dsc(proc->conn_handle,
+                                proc->disc_all_dscs.chr_val_handle,
+                                &dsc) != 0) {
+
+        proc->flags &= ~BLE_GATTC_PROC_F_CACHE_FILL;
+    }
+#endif
+
     cbrc = ble_gattc_disc_all_dscs_cb(proc, rc, 0, &dsc);
     if (rc != 0 || cbrc != 0) {
         return BLE_HS_EDONE;
@@ -2738,6 +3177,16 @@ ble_gattc_disc_all_dscs(uint16_t conn_handle, uint16_t start_handle,
 
     ble_gattc_log_disc_all_dscs(proc);
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    if (ble_gattc_cache_lookup(proc,
+                               ble_gattc_cache_dscs_cached(conn_handle,
+                                                           start_handle,
+                                                           end_handle))) {
+        rc = 0;
+        goto done;
+    }
+#endif
+
     rc = ble_gattc_disc_all_dscs_tx(proc);
     if (rc != 0) {
         goto done;
@@ -2839,7 +3288,8 @@ ble_gattc_read_tx(struct ble_gattc_proc *proc)
 {
     int rc;
 
-    rc = ble_att_clt_tx_read(proc->conn_handle, proc->read.handle);
+    rc = ble_att_clt_tx_read(proc->conn_handle, ble_gattc_proc_bearer(proc),
+                             proc->read.handle);
     if (rc != 0) {
         return rc;
     }
@@ -3003,6 +3453,7 @@ static int
 ble_gattc_read_uuid_tx(struct ble_gattc_proc *proc)
 {
     return ble_att_clt_tx_read_type(proc->conn_handle,
+                                    ble_gattc_proc_bearer(proc),
                                     proc->read_uuid.start_handle,
                                     proc->read_uuid.end_handle,
                                     &proc->read_uuid.chr_uuid.u);
@@ -3107,12 +3558,14 @@ ble_gattc_read_long_tx(struct ble_gattc_proc *proc)
     ble_gattc_dbg_assert_proc_not_inserted(proc);
 
     if (proc->read_long.offset == 0) {
-        rc = ble_att_clt_tx_read(proc->conn_handle, proc->read_long.handle);
+        rc = ble_att_clt_tx_read(proc->conn_handle, ble_gattc_proc_bearer(proc),
+                                 proc->read_long.handle);
         if (rc != 0) {
             return rc;
         }
     } else {
         rc = ble_att_clt_tx_read_blob(proc->conn_handle,
+                                      ble_gattc_proc_bearer(proc),
                                       proc->read_long.handle,
                                       proc->read_long.offset);
         if (rc != 0) {
@@ -3323,7 +3776,9 @@ ble_gattc_read_mult_tx(struct ble_gattc_proc *proc)
 {
     int rc;
 
-    rc = ble_att_clt_tx_read_mult(proc->conn_handle, proc->read_mult.handles,
+    rc = ble_att_clt_tx_read_mult(proc->conn_handle,
+                                  ble_gattc_proc_bearer(proc),
+                                  proc->read_mult.handles,
                                   proc->read_mult.num_handles);
     if (rc != 0) {
         return rc;
@@ -3402,7 +3857,7 @@ ble_gattc_write_no_rsp(uint16_t conn_handle, uint16_t attr_handle,
 
     rc = ble_att_clt_tx_write_cmd(conn_handle, attr_handle, txom);
     if (rc != 0) {
-        STATS_INC(ble_gattc_stats, write);
+        STATS_INC(ble_gattc_stats, write_no_rsp_fail);
     }
 
     return rc;
@@ -3428,6 +3883,118 @@ ble_gattc_write_no_rsp_flat(uint16_t conn_handle, uint16_t attr_handle,
     return 0;
 }
 
+int
+ble_gattc_write_no_rsp_stream(uint16_t conn_handle, uint16_t attr_handle,
+                              struct os_mbuf *txom)
+{
+#if !MYNEWT_VAL(BLE_GATT_WRITE_NO_RSP)
+    return BLE_HS_ENOTSUP;
+#else
+
+    struct ble_gattc_stream *stream;
+    struct ble_hs_conn *conn;
+    uint16_t len;
+    int rc;
+
+    len = OS_MBUF_PKTLEN(txom);
+
+    ble_hs_lock();
+
+    conn = ble_hs_conn_find(conn_handle);
+    if (conn == NULL) {
+        rc = BLE_HS_ENOTCONN;
+    } else {
+        stream = &conn->bhc_gattc_stream;
+
+        if (ble_hs_conn_tx_backlog(conn) >=
+            MYNEWT_VAL(BLE_GATT_WRITE_NO_RSP_MAX_PENDING)) {
+
+            /* Report a TX ready event once the backlog drains. */
+            conn->bhc_flags |= BLE_HS_CONN_F_TX_BLOCKED;
+            stream->busy++;
+            rc = BLE_HS_EBUSY;
+        } else {
+            if (stream->pdus == 0) {
+                stream->start = ble_npl_time_get();
+            }
+            stream->pdus++;
+            stream->bytes += len;
+            rc = 0;
+        }
+    }
+
+    ble_hs_unlock();
+
+    switch (rc) {
+    case 0:
+        break;
+
+    case BLE_HS_EBUSY:
+        /* The caller keeps the data and retries on BLE_GAP_EVENT_TX_READY. */
+        STATS_INC(ble_gattc_stats, write_no_rsp_stream_busy);
+        return rc;
+
+    default:
+        os_mbuf_free_chain(txom);
+        return rc;
+    }
+
+    STATS_INC(ble_gattc_stats, write_no_rsp_stream);
+    STATS_INCN(ble_gattc_stats, write_no_rsp_stream_bytes, len);
+
+    return ble_gattc_write_no_rsp(conn_handle, attr_handle, txom);
+#endif
+}
+
+int
+ble_gattc_write_no_rsp_stream_stats(uint16_t conn_handle,
+                                    struct ble_gattc_stream_stats *out_stats)
+{
+#if !MYNEWT_VAL(BLE_GATT_WRITE_NO_RSP)
+    return BLE_HS_ENOTSUP;
+#else
+
+    const struct ble_gattc_stream *stream;
+    struct ble_hs_conn *conn;
+    uint32_t elapsed_ms;
+    int rc;
+
+    memset(out_stats, 0, sizeof *out_stats);
+
+    ble_hs_lock();
+
+    conn = ble_hs_conn_find(conn_handle);
+    if (conn == NULL) {
+        rc = BLE_HS_ENOTCONN;
+    } else {
+        stream = &conn->bhc_gattc_stream;
+
+        out_stats->pdus = stream->pdus;
+        out_stats->bytes = stream->bytes;
+        out_stats->busy = stream->busy;
+        if (stream->pdus != 0) {
+            out_stats->elapsed_ms =
+                ble_npl_time_ticks_to_ms32(ble_npl_time_get() - stream->start);
+        }
+        rc = 0;
+    }
+
+    ble_hs_unlock();
+
+    if (rc != 0) {
+        return rc;
+    }
+
+    elapsed_ms = out_stats->elapsed_ms;
+    if (elapsed_ms != 0) {
+        out_stats->bytes_per_sec =
+            (uint32_t)((uint64_t)out_stats->bytes * 1000 / elapsed_ms);
+    }
+
+    return 0;
+#endif
+}
+
 /*****************************************************************************
  * $write                                                                    *
  *****************************************************************************/
@@ -3514,7 +4081,8 @@ ble_gattc_write(uint16_t conn_handle, uint16_t attr_handle,
 
     ble_gattc_log_write(attr_handle, OS_MBUF_PKTLEN(txom), 1);
 
-    rc = ble_att_clt_tx_write_req(conn_handle, attr_handle, txom);
+    rc = ble_att_clt_tx_write_req(conn_handle, ble_gattc_proc_bearer(proc),
+                                  attr_handle, txom);
     txom = NULL;
     if (rc != 0) {
         goto done;
@@ -3627,6 +4195,7 @@ ble_gattc_write_long_tx(struct ble_gattc_proc *proc)
 
     if (write_len <= 0) {
         rc = ble_att_clt_tx_exec_write(proc->conn_handle,
+                                       ble_gattc_proc_bearer(proc),
                                        BLE_ATT_EXEC_WRITE_F_EXECUTE);
         goto done;
     }
@@ -3647,6 +4216,7 @@ ble_gattc_write_long_tx(struct ble_gattc_proc *proc)
     }
 
     rc = ble_att_clt_tx_prep_write(proc->conn_handle,
+                                   ble_gattc_proc_bearer(proc),
                                    proc->write_long.attr.handle,
                                    proc->write_long.attr.offset, om);
     om = NULL;
@@ -3693,6 +4263,7 @@ ble_gattc_write_long_err(struct ble_gattc_proc *proc, int status,
             OS_MBUF_PKTLEN(proc->write_long.attr.om)) {
 
         ble_att_clt_tx_exec_write(proc->conn_handle,
+                                  ble_gattc_proc_bearer(proc),
                                   BLE_ATT_EXEC_WRITE_F_CANCEL);
     }
 
@@ -3913,6 +4484,7 @@ ble_gattc_write_reliable_tx(struct ble_gattc_proc *proc)
 
     if (attr_idx >= proc->write_reliable.num_attrs) {
         rc = ble_att_clt_tx_exec_write(proc->conn_handle,
+                                       ble_gattc_proc_bearer(proc),
                                        BLE_ATT_EXEC_WRITE_F_EXECUTE);
         goto done;
     }
@@ -3942,7 +4514,8 @@ ble_gattc_write_reliable_tx(struct ble_gattc_proc *proc)
         goto done;
     }
 
-    rc = ble_att_clt_tx_prep_write(proc->conn_handle, attr->handle,
+    rc = ble_att_clt_tx_prep_write(proc->conn_handle,
+                                   ble_gattc_proc_bearer(proc), attr->handle,
                                    attr->offset, om);
     om = NULL;
     if (rc != 0) {
@@ -3987,6 +4560,7 @@ ble_gattc_write_reliable_err(struct ble_gattc_proc *proc, int status,
     if (proc->write_reliable.cur_attr < proc->write_reliable.num_attrs) {
 
         ble_att_clt_tx_exec_write(proc->conn_handle,
+                                  ble_gattc_proc_bearer(proc),
                                   BLE_ATT_EXEC_WRITE_F_CANCEL);
     }
 }
@@ -4280,7 +4854,8 @@ ble_gattc_indicate_rx_rsp(struct ble_gattc_proc *proc)
 void
 ble_gatts_indicate_fail_notconn(uint16_t conn_handle)
 {
-    ble_gattc_fail_procs(conn_handle, BLE_GATT_OP_INDICATE, BLE_HS_ENOTCONN);
+    ble_gattc_fail_procs(conn_handle, 0, BLE_GATT_OP_INDICATE,
+                         BLE_HS_ENOTCONN);
 }
 
 int
@@ -4305,6 +4880,7 @@ ble_gattc_indicate_custom(uint16_t conn_handle, uint16_t chr_val_handle,
 
     proc->op = BLE_GATT_OP_INDICATE;
     proc->conn_handle = conn_handle;
+    proc->cid = BLE_L2CAP_CID_ATT;
     proc->indicate.chr_val_handle = chr_val_handle;
 
     ble_gattc_log_indicate(chr_val_handle);
@@ -4371,12 +4947,14 @@ ble_gattc_indicate(uint16_t conn_handle, uint16_t chr_val_handle)
  * procedure.
  */
 void
-ble_gattc_rx_err(uint16_t conn_handle, uint16_t handle, uint16_t status)
+ble_gattc_rx_err(uint16_t conn_handle, uint16_t cid, uint16_t handle,
+                 uint16_t status)
 {
     struct ble_gattc_proc *proc;
     ble_gattc_err_fn *err_cb;
 
-    proc = ble_gattc_extract_first_by_conn_op(conn_handle, BLE_GATT_OP_NONE);
+    proc = ble_gattc_extract_first_by_conn_op(conn_handle, cid,
+                                              BLE_GATT_OP_NONE);
     if (proc != NULL) {
         err_cb = ble_gattc_err_dispatch_get(proc->op);
         if (err_cb != NULL) {
@@ -4391,11 +4969,13 @@ ble_gattc_rx_err(uint16_t conn_handle, uint16_t handle, uint16_t status)
  * GATT procedure.
  */
 void
-ble_gattc_rx_mtu(uint16_t conn_handle, int status, uint16_t chan_mtu)
+ble_gattc_rx_mtu(uint16_t conn_handle, uint16_t cid, int status,
+                 uint16_t chan_mtu)
 {
     struct ble_gattc_proc *proc;
 
-    proc = ble_gattc_extract_first_by_conn_op(conn_handle, BLE_GATT_OP_MTU);
+    proc = ble_gattc_extract_first_by_conn_op(conn_handle, cid,
+                                              BLE_GATT_OP_MTU);
     if (proc != NULL) {
         ble_gattc_mtu_cb(proc, status, 0, chan_mtu);
         ble_gattc_process_status(proc, BLE_HS_EDONE);
@@ -4407,7 +4987,7 @@ ble_gattc_rx_mtu(uint16_t conn_handle, int status, uint16_t chan_mtu)
  * find-information-response to the appropriate active GATT procedure.
  */
 void
-ble_gattc_rx_find_info_idata(uint16_t conn_handle,
+ble_gattc_rx_find_info_idata(uint16_t conn_handle, uint16_t cid,
                              struct ble_att_find_info_idata *idata)
 {
 #if !NIMBLE_BLE_ATT_CLT_FIND_INFO
@@ -4417,7 +4997,7 @@ ble_gattc_rx_find_info_idata(uint16_t conn_handle,
     struct ble_gattc_proc *proc;
     int rc;
 
-    proc = ble_gattc_extract_first_by_conn_op(conn_handle,
+    proc = ble_gattc_extract_first_by_conn_op(conn_handle, cid,
                                               BLE_GATT_OP_DISC_ALL_DSCS);
     if (proc != NULL) {
         rc = ble_gattc_disc_all_dscs_rx_idata(proc, idata);
@@ -4430,7 +5010,7 @@ ble_gattc_rx_find_info_idata(uint16_t conn_handle,
  * find-information-response to the appropriate active GATT procedure.
  */
 void
-ble_gattc_rx_find_info_complete(uint16_t conn_handle, int status)
+ble_gattc_rx_find_info_complete(uint16_t conn_handle, uint16_t cid, int status)
 {
 #if !NIMBLE_BLE_ATT_CLT_FIND_INFO
     return;
@@ -4439,7 +5019,7 @@ ble_gattc_rx_find_info_complete(uint16_t conn_handle, int status)
     struct ble_gattc_proc *proc;
     int rc;
 
-    proc = ble_gattc_extract_first_by_conn_op(conn_handle,
+    proc = ble_gattc_extract_first_by_conn_op(conn_handle, cid,
                                               BLE_GATT_OP_DISC_ALL_DSCS);
     if (proc != NULL) {
         rc = ble_gattc_disc_all_dscs_rx_complete(proc, status);
@@ -4452,7 +5032,7 @@ ble_gattc_rx_find_info_complete(uint16_t conn_handle, int status)
  * find-by-type-value-response to the appropriate active GATT procedure.
  */
 void
-ble_gattc_rx_find_type_value_hinfo(uint16_t conn_handle,
+ble_gattc_rx_find_type_value_hinfo(uint16_t conn_handle, uint16_t cid,
                                    struct ble_att_find_type_value_hinfo *hinfo)
 {
 #if !NIMBLE_BLE_ATT_CLT_FIND_TYPE
@@ -4462,7 +5042,7 @@ ble_gattc_rx_find_type_value_hinfo(uint16_t conn_handle,
     struct ble_gattc_proc *proc;
     int rc;
 
-    proc = ble_gattc_extract_first_by_conn_op(conn_handle,
+    proc = ble_gattc_extract_first_by_conn_op(conn_handle, cid,
                                               BLE_GATT_OP_DISC_SVC_UUID);
     if (proc != NULL) {
         rc = ble_gattc_disc_svc_uuid_rx_hinfo(proc, hinfo);
@@ -4475,7 +5055,8 @@ ble_gattc_rx_find_type_value_hinfo(uint16_t conn_handle,
  * find-by-type-value-response to the appropriate active GATT procedure.
  */
 void
-ble_gattc_rx_find_type_value_complete(uint16_t conn_handle, int status)
+ble_gattc_rx_find_type_value_complete(uint16_t conn_handle, uint16_t cid,
+                                      int status)
 {
 #if !NIMBLE_BLE_ATT_CLT_FIND_TYPE
     return;
@@ -4484,7 +5065,7 @@ ble_gattc_rx_find_type_value_complete(uint16_t conn_handle, int status)
     struct ble_gattc_proc *proc;
     int rc;
 
-    proc = ble_gattc_extract_first_by_conn_op(conn_handle,
+    proc = ble_gattc_extract_first_by_conn_op(conn_handle, cid,
                                               BLE_GATT_OP_DISC_SVC_UUID);
     if (proc != NULL) {
         rc = ble_gattc_disc_svc_uuid_rx_complete(proc, status);
@@ -4497,7 +5078,7 @@ ble_gattc_rx_find_type_value_complete(uint16_t conn_handle, int status)
  * to the appropriate active GATT procedure.
  */
 void
-ble_gattc_rx_read_type_adata(uint16_t conn_handle,
+ble_gattc_rx_read_type_adata(uint16_t conn_handle, uint16_t cid,
                              struct ble_att_read_type_adata *adata)
 {
 #if !NIMBLE_BLE_ATT_CLT_READ_TYPE
@@ -4508,7 +5089,7 @@ ble_gattc_rx_read_type_adata(uint16_t conn_handle,
     struct ble_gattc_proc *proc;
     int rc;
 
-    proc = BLE_GATTC_RX_EXTRACT_RX_ENTRY(conn_handle,
+    proc = BLE_GATTC_RX_EXTRACT_RX_ENTRY(conn_handle, cid,
                                          ble_gattc_rx_read_type_elem_entries,
                                          &rx_entry);
     if (proc != NULL) {
@@ -4522,7 +5103,7 @@ ble_gattc_rx_read_type_adata(uint16_t conn_handle,
  * the appropriate active GATT procedure.
  */
 void
-ble_gattc_rx_read_type_complete(uint16_t conn_handle, int status)
+ble_gattc_rx_read_type_complete(uint16_t conn_handle, uint16_t cid, int status)
 {
 #if !NIMBLE_BLE_ATT_CLT_READ_TYPE
     return;
@@ -4533,7 +5114,7 @@ ble_gattc_rx_read_type_complete(uint16_t conn_handle, int status)
     int rc;
 
     proc = BLE_GATTC_RX_EXTRACT_RX_ENTRY(
-        conn_handle, ble_gattc_rx_read_type_complete_entries,
+        conn_handle, cid, ble_gattc_rx_read_type_complete_entries,
         &rx_entry);
     if (proc != NULL) {
         rc = rx_entry->cb(proc, status);
@@ -4546,7 +5127,7 @@ ble_gattc_rx_read_type_complete(uint16_t conn_handle, int status)
  * read-by-group-type-response to the appropriate active GATT procedure.
  */
 void
-ble_gattc_rx_read_group_type_adata(uint16_t conn_handle,
+ble_gattc_rx_read_group_type_adata(uint16_t conn_handle, uint16_t cid,
                                    struct ble_att_read_group_type_adata *adata)
 {
 #if !NIMBLE_BLE_ATT_CLT_READ_GROUP_TYPE
@@ -4556,7 +5137,7 @@ ble_gattc_rx_read_group_type_adata(uint16_t conn_handle,
     struct ble_gattc_proc *proc;
     int rc;
 
-    proc = ble_gattc_extract_first_by_conn_op(conn_handle,
+    proc = ble_gattc_extract_first_by_conn_op(conn_handle, cid,
                                               BLE_GATT_OP_DISC_ALL_SVCS);
     if (proc != NULL) {
         rc = ble_gattc_disc_all_svcs_rx_adata(proc, adata);
@@ -4569,7 +5150,8 @@ ble_gattc_rx_read_group_type_adata(uint16_t conn_handle,
  * read-by-group-type-response to the appropriate active GATT procedure.
  */
 void
-ble_gattc_rx_read_group_type_complete(uint16_t conn_handle, int status)
+ble_gattc_rx_read_group_type_complete(uint16_t conn_handle, uint16_t cid,
+                                      int status)
 {
 #if !NIMBLE_BLE_ATT_CLT_READ_GROUP_TYPE
     return;
@@ -4578,7 +5160,7 @@ ble_gattc_rx_read_group_type_complete(uint16_t conn_handle, int status)
     struct ble_gattc_proc *proc;
     int rc;
 
-    proc = ble_gattc_extract_first_by_conn_op(conn_handle,
+    proc = ble_gattc_extract_first_by_conn_op(conn_handle, cid,
                                               BLE_GATT_OP_DISC_ALL_SVCS);
     if (proc != NULL) {
         rc = ble_gattc_disc_all_svcs_rx_complete(proc, status);
@@ -4591,7 +5173,8 @@ ble_gattc_rx_read_group_type_complete(uint16_t conn_handle, int status)
  * procedure.
  */
 void
-ble_gattc_rx_read_rsp(uint16_t conn_handle, int status, struct os_mbuf **om)
+ble_gattc_rx_read_rsp(uint16_t conn_handle, uint16_t cid, int status,
+                      struct os_mbuf **om)
 {
 #if !NIMBLE_BLE_ATT_CLT_READ
     return;
@@ -4601,7 +5184,7 @@ ble_gattc_rx_read_rsp(uint16_t conn_handle, int status, struct os_mbuf **om)
     struct ble_gattc_proc *proc;
     int rc;
 
-    proc = BLE_GATTC_RX_EXTRACT_RX_ENTRY(conn_handle,
+    proc = BLE_GATTC_RX_EXTRACT_RX_ENTRY(conn_handle, cid,
                                          ble_gattc_rx_read_rsp_entries,
                                          &rx_entry);
     if (proc != NULL) {
@@ -4615,7 +5198,7 @@ ble_gattc_rx_read_rsp(uint16_t conn_handle, int status, struct os_mbuf **om)
  * procedure.
  */
 void
-ble_gattc_rx_read_blob_rsp(uint16_t conn_handle, int status,
+ble_gattc_rx_read_blob_rsp(uint16_t conn_handle, uint16_t cid, int status,
                            struct os_mbuf **om)
 {
 #if !NIMBLE_BLE_ATT_CLT_READ_BLOB
@@ -4625,7 +5208,7 @@ ble_gattc_rx_read_blob_rsp(uint16_t conn_handle, int status,
     struct ble_gattc_proc *proc;
     int rc;
 
-    proc = ble_gattc_extract_first_by_conn_op(conn_handle,
+    proc = ble_gattc_extract_first_by_conn_op(conn_handle, cid,
                                               BLE_GATT_OP_READ_LONG);
     if (proc != NULL) {
         rc = ble_gattc_read_long_rx_read_rsp(proc, status, om);
@@ -4638,7 +5221,7 @@ ble_gattc_rx_read_blob_rsp(uint16_t conn_handle, int status,
  * GATT procedure.
  */
 void
-ble_gattc_rx_read_mult_rsp(uint16_t conn_handle, int status,
+ble_gattc_rx_read_mult_rsp(uint16_t conn_handle, uint16_t cid, int status,
                            struct os_mbuf **om)
 {
 #if !NIMBLE_BLE_ATT_CLT_READ_MULT
@@ -4647,7 +5230,7 @@ ble_gattc_rx_read_mult_rsp(uint16_t conn_handle, int status,
 
     struct ble_gattc_proc *proc;
 
-    proc = ble_gattc_extract_first_by_conn_op(conn_handle,
+    proc = ble_gattc_extract_first_by_conn_op(conn_handle, cid,
                                               BLE_GATT_OP_READ_MULT);
     if (proc != NULL) {
         ble_gattc_read_mult_cb(proc, status, 0, om);
@@ -4660,7 +5243,7 @@ ble_gattc_rx_read_mult_rsp(uint16_t conn_handle, int status,
  * procedure.
  */
 void
-ble_gattc_rx_write_rsp(uint16_t conn_handle)
+ble_gattc_rx_write_rsp(uint16_t conn_handle, uint16_t cid)
 {
 #if !NIMBLE_BLE_ATT_CLT_WRITE
     return;
@@ -4668,7 +5251,7 @@ ble_gattc_rx_write_rsp(uint16_t conn_handle)
 
     struct ble_gattc_proc *proc;
 
-    proc = ble_gattc_extract_first_by_conn_op(conn_handle,
+    proc = ble_gattc_extract_first_by_conn_op(conn_handle, cid,
                                               BLE_GATT_OP_WRITE);
     if (proc != NULL) {
         ble_gattc_write_cb(proc, 0, 0);
@@ -4681,7 +5264,7 @@ ble_gattc_rx_write_rsp(uint16_t conn_handle)
  * GATT procedure.
  */
 void
-ble_gattc_rx_prep_write_rsp(uint16_t conn_handle, int status,
+ble_gattc_rx_prep_write_rsp(uint16_t conn_handle, uint16_t cid, int status,
                             uint16_t handle, uint16_t offset,
                             struct os_mbuf **om)
 {
@@ -4693,7 +5276,7 @@ ble_gattc_rx_prep_write_rsp(uint16_t conn_handle, int status,
     struct ble_gattc_proc *proc;
     int rc;
 
-    proc = BLE_GATTC_RX_EXTRACT_RX_ENTRY(conn_handle,
+    proc = BLE_GATTC_RX_EXTRACT_RX_ENTRY(conn_handle, cid,
                                          ble_gattc_rx_prep_entries,
                                          &rx_entry);
     if (proc != NULL) {
@@ -4707,7 +5290,7 @@ ble_gattc_rx_prep_write_rsp(uint16_t conn_handle, int status,
  * GATT procedure.
  */
 void
-ble_gattc_rx_exec_write_rsp(uint16_t conn_handle, int status)
+ble_gattc_rx_exec_write_rsp(uint16_t conn_handle, uint16_t cid, int status)
 {
 #if !NIMBLE_BLE_ATT_CLT_EXEC_WRITE
     return;
@@ -4717,7 +5300,7 @@ ble_gattc_rx_exec_write_rsp(uint16_t conn_handle, int status)
     struct ble_gattc_proc *proc;
     int rc;
 
-    proc = BLE_GATTC_RX_EXTRACT_RX_ENTRY(conn_handle,
+    proc = BLE_GATTC_RX_EXTRACT_RX_ENTRY(conn_handle, cid,
                                          ble_gattc_rx_exec_entries, &rx_entry);
     if (proc != NULL) {
         rc = rx_entry->cb(proc, status);
@@ -4730,7 +5313,7 @@ ble_gattc_rx_exec_write_rsp(uint16_t conn_handle, int status)
  * active GATT procedure.
  */
 void
-ble_gattc_rx_indicate_rsp(uint16_t conn_handle)
+ble_gattc_rx_indicate_rsp(uint16_t conn_handle, uint16_t cid)
 {
 #if !NIMBLE_BLE_ATT_CLT_INDICATE
     return;
@@ -4738,7 +5321,7 @@ ble_gattc_rx_indicate_rsp(uint16_t conn_handle)
 
     struct ble_gattc_proc *proc;
 
-    proc = ble_gattc_extract_first_by_conn_op(conn_handle,
+    proc = ble_gattc_extract_first_by_conn_op(conn_handle, cid,
                                               BLE_GATT_OP_INDICATE);
     if (proc != NULL) {
         ble_gattc_indicate_rx_rsp(proc);
@@ -4761,7 +5344,20 @@ ble_gattc_rx_indicate_rsp(uint16_t conn_handle)
 void
 ble_gattc_connection_broken(uint16_t conn_handle)
 {
-    ble_gattc_fail_procs(conn_handle, BLE_GATT_OP_NONE, BLE_HS_ENOTCONN);
+    ble_gattc_fail_procs(conn_handle, 0, BLE_GATT_OP_NONE, BLE_HS_ENOTCONN);
+}
+
+/**
+ * Called when an enhanced ATT bearer is released.  Procedures waiting for a
+ * response on that bearer are failed.
+ *
+ * @param conn_handle           The connection the bearer belonged to.
+ * @param cid                   The source CID of the released bearer.
+ */
+void
+ble_gattc_bearer_closed(uint16_t conn_handle, uint16_t cid)
+{
+    ble_gattc_fail_procs(conn_handle, cid, BLE_GATT_OP_NONE, BLE_HS_ENOTCONN);
 }
 
 /**
@@ -4770,15 +5366,20 @@ ble_gattc_connection_broken(uint16_t conn_handle)
 int
 ble_gattc_any_jobs(void)
 {
-    return !STAILQ_EMPTY(&ble_gattc_procs);
+    return !TAILQ_EMPTY(&ble_gattc_exp_procs);
 }
 
 int
 ble_gattc_init(void)
 {
     int rc;
+    int i;
 
-    STAILQ_INIT(&ble_gattc_procs);
+    for (i = 0; i < BLE_GATTC_PROC_BUCKETS; i++) {
+        STAILQ_INIT(&ble_gattc_procs[i]);
+    }
+    STAILQ_INIT(&ble_gattc_stalled_procs);
+    TAILQ_INIT(&ble_gattc_exp_procs);
 
     if (MYNEWT_VAL(BLE_GATT_MAX_PROCS) > 0) {
         rc = os_mempool_init(&ble_gattc_proc_pool,
@@ -0,0 +1,619 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * GATT client attribute cache.
+ *
+ * Discovery results of bonded peers are kept in the host store as
+ * BLE_STORE_OBJ_TYPE_GATT_CACHE records.  The cache is filled in three
+ * levels, each of which carries its own completion marker:
+ *     o The DB record of a peer is complete once all primary services were
+ *       discovered.
+ *     o A SVC record is complete once all characteristics of the service
+ *       were discovered.
+ *     o A CHR record is complete once all descriptors of the characteristic
+ *       were discovered.
+ *
+ * A discovery procedure is answered from the cache only if the relevant
+ * marker is set; otherwise the procedure goes over the air and its results
+ * are added to the cache.  All records of a peer are deleted when a Service
+ * Changed indication is received from it.
+ *
+ * The cache is only used on links encrypted with the stored bond.  A server
+ * sends pending Service Changed indications to a bonded client only once the
+ * link is encrypted again, so until then the cache may be stale.  Unbonded
+ * peers are not cached at all; their clients have to rely on Service Changed
+ * indications for the lifetime of the connection.
+ */
+
+#include <string.h>
+#include "host/ble_store.h"
+#include "ble_hs_priv.h"
+
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+
+/** Service Changed characteristic. */
+#define BLE_GATTC_CACHE_UUID_SVC_CHANGED    0x2a05
+
+/**
+ * Retrieves the identity address of the peer connected via the specified
+ * connection, if the peer is bonded.
+ *
+ * @param conn_handle           The connection to the peer.
+ * @param secured               Whether the link must also be encrypted with
+ *                                  the stored bond.
+ * @param out_peer_addr         On success, the identity address of the peer.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_ENOTCONN if there is no such
+ *                                  connection;
+ *                              BLE_HS_ENOTSUP if the peer is not bonded, or
+ *                                  if the link is not secured as required.
+ */
+static int
+ble_gattc_cache_peer(uint16_t conn_handle, int secured,
+                     ble_addr_t *out_peer_addr)
+{
+    struct ble_store_value_sec value_sec;
+    struct ble_store_key_sec key_sec;
+    struct ble_hs_conn_addrs addrs;
+    struct ble_gap_sec_state sec_state;
+    struct ble_hs_conn *conn;
+    int rc;
+
+    ble_hs_lock();
+
+    conn = ble_hs_conn_find(conn_handle);
+    if (conn != NULL) {
+        ble_hs_conn_addrs(conn, &addrs);
+        sec_state = conn->bhc_sec_state;
+    }
+
+    ble_hs_unlock();
+
+    if (conn == NULL) {
+        return BLE_HS_ENOTCONN;
+    }
+
+    if (secured && !(sec_state.encrypted && sec_state.bonded)) {
+        return BLE_HS_ENOTSUP;
+    }
+
+    if (addrs.peer_id_addr.type != BLE_ADDR_PUBLIC &&
+        addrs.peer_id_addr.type != BLE_ADDR_RANDOM) {
+
+        return BLE_HS_ENOTSUP;
+    }
+
+    memset(&key_sec, 0, sizeof key_sec);
+    key_sec.peer_addr = addrs.peer_id_addr;
+    rc = ble_store_read_peer_sec(&key_sec, &value_sec);
+    if (rc != 0) {
+        return BLE_HS_ENOTSUP;
+    }
+
+    *out_peer_addr = addrs.peer_id_addr;
+    return 0;
+}
+
+static int
+ble_gattc_cache_read(const ble_addr_t *peer_addr, uint8_t type,
+                     uint16_t handle, uint8_t idx,
+                     struct ble_store_value_gatt_cache *out_value)
+{
+    struct ble_store_key_gatt_cache key;
+
+    key.peer_addr = *peer_addr;
+    key.type = type;
+    key.handle = handle;
+    key.idx = idx;
+
+    return ble_store_read_gatt_cache(&key, out_value);
+}
+
+/** Selects a record during a walk of the peer's cache records. */
+struct ble_gattc_cache_next_arg {
+    uint16_t val_handle;
+    uint16_t prev_handle;
+    uint16_t end_handle;
+    int found;
+    struct ble_store_value_gatt_cache *out_value;
+};
+
+static int
+ble_gattc_cache_next_iter(int obj_type, union ble_store_value *val,
+                          void *cookie)
+{
+    struct ble_store_value_gatt_cache *value;
+    struct ble_gattc_cache_next_arg *arg;
+
+    value = &val->gatt_cache;
+    arg = cookie;
+
+    if (value->handle <= arg->prev_handle || value->handle > arg->end_handle) {
+        return 0;
+    }
+    if (arg->val_handle != 0 && value->val_handle != arg->val_handle) {
+        return 0;
+    }
+
+    if (!arg->found || value->handle < arg->out_value->handle) {
+        *arg->out_value = *value;
+        arg->found = 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Finds the record of the specified type with the lowest handle in the range
+ * (prev_handle, end_handle].  If val_handle is nonzero, only records with a
+ * matching value handle are considered.  The records of the peer are visited
+ * in a single walk of the store.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_EDONE if there are no more records;
+ *                              Other nonzero on error.
+ */
+static int
+ble_gattc_cache_next(uint16_t conn_handle, uint8_t type, uint16_t val_handle,
+                     uint16_t prev_handle, uint16_t end_handle,
+                     struct ble_store_value_gatt_cache *out_value)
+{
+    struct ble_gattc_cache_next_arg arg;
+    struct ble_store_key_gatt_cache key;
+    int rc;
+
+    memset(&key, 0, sizeof key);
+    rc = ble_gattc_cache_peer(conn_handle, 1, &key.peer_addr);
+    if (rc != 0) {
+        return rc;
+    }
+    key.type = type;
+
+    arg.val_handle = val_handle;
+    arg.prev_handle = prev_handle;
+    arg.end_handle = end_handle;
+    arg.found = 0;
+    arg.out_value = out_value;
+
+    rc = ble_store_iterate_key(BLE_STORE_OBJ_TYPE_GATT_CACHE,
+                               (union ble_store_key *)&key,
+                               ble_gattc_cache_next_iter, &arg);
+    if (rc != 0) {
+        return rc;
+    }
+
+    if (!arg.found) {
+        return BLE_HS_EDONE;
+    }
+
+    return 0;
+}
+
+static int
+ble_gattc_cache_find_chr_iter(int obj_type, union ble_store_value *val,
+                              void *cookie)
+{
+    struct ble_gattc_cache_next_arg *arg;
+
+    arg = cookie;
+
+    if (val->gatt_cache.val_handle != arg->val_handle) {
+        return 0;
+    }
+
+    *arg->out_value = val->gatt_cache;
+    arg->found = 1;
+    return 1;
+}
+
+/**
+ * Finds the characteristic record with the specified value handle.
+ */
+static int
+ble_gattc_cache_find_chr(const ble_addr_t *peer_addr, uint16_t chr_val_handle,
+                         struct ble_store_value_gatt_cache *out_value)
+{
+    struct ble_gattc_cache_next_arg arg;
+    struct ble_store_key_gatt_cache key;
+    int rc;
+
+    memset(&key, 0, sizeof key);
+    key.peer_addr = *peer_addr;
+    key.type = BLE_STORE_GATT_CACHE_CHR;
+
+    memset(&arg, 0, sizeof arg);
+    arg.val_handle = chr_val_handle;
+    arg.out_value = out_value;
+
+    rc = ble_store_iterate_key(BLE_STORE_OBJ_TYPE_GATT_CACHE,
+                               (union ble_store_key *)&key,
+                               ble_gattc_cache_find_chr_iter, &arg);
+    if (rc != 0) {
+        return rc;
+    }
+
+    if (!arg.found) {
+        return BLE_HS_ENOENT;
+    }
+
+    return 0;
+}
+
+static int
+ble_gattc_cache_write(const ble_addr_t *peer_addr,
+                      struct ble_store_value_gatt_cache *value)
+{
+    value->peer_addr = *peer_addr;
+    return ble_store_write_gatt_cache(value);
+}
+
+/**
+ * Indicates whether the full list of primary services of the peer is cached.
+ *
+ * @return                      0 if the list is cached;
+ *                              BLE_HS_ENOENT if the list is not cached but
+ *                                  can be filled by the procedure;
+ *                              BLE_HS_ENOTSUP if the peer is not cacheable.
+ */
+int
+ble_gattc_cache_svcs_cached(uint16_t conn_handle)
+{
+    struct ble_store_value_gatt_cache value;
+    ble_addr_t peer_addr;
+    int rc;
+
+    rc = ble_gattc_cache_peer(conn_handle, 1, &peer_addr);
+    if (rc != 0) {
+        return BLE_HS_ENOTSUP;
+    }
+
+    rc = ble_gattc_cache_read(&peer_addr, BLE_STORE_GATT_CACHE_DB, 0, 0,
+                              &value);
+    if (rc != 0 || !value.complete) {
+        return BLE_HS_ENOENT;
+    }
+
+    return 0;
+}
+
+/**
+ * Indicates whether all characteristics of the specified service are cached.
+ * Characteristics can only be cached for a service that is itself in the
+ * cache.
+ *
+ * @return                      0 if the characteristics are cached;
+ *                              BLE_HS_ENOENT if they are not cached but can
+ *                                  be filled by the procedure;
+ *                              BLE_HS_ENOTSUP if the range is not cacheable.
+ */
+int
+ble_gattc_cache_chrs_cached(uint16_t conn_handle, uint16_t start_handle,
+                            uint16_t end_handle)
+{
+    struct ble_store_value_gatt_cache value;
+    ble_addr_t peer_addr;
+    int rc;
+
+    rc = ble_gattc_cache_peer(conn_handle, 1, &peer_addr);
+    if (rc != 0) {
+        return BLE_HS_ENOTSUP;
+    }
+
+    rc = ble_gattc_cache_read(&peer_addr, BLE_STORE_GATT_CACHE_SVC,
+                              start_handle, 0, &value);
+    if (rc != 0 || value.end_handle != end_handle) {
+        return BLE_HS_ENOTSUP;
+    }
+
+    if (!value.complete) {
+        return BLE_HS_ENOENT;
+    }
+
+    return 0;
+}
+
+/**
+ * Indicates whether all descriptors of the specified characteristic are
+ * cached.  Descriptors can only be cached for a characteristic that is itself
+ * in the cache.
+ *
+ * @return                      0 if the descriptors are cached;
+ *                              BLE_HS_ENOENT if they are not cached but can
+ *                                  be filled by the procedure;
+ *                              BLE_HS_ENOTSUP if the range is not cacheable.
+ */
+int
+ble_gattc_cache_dscs_cached(uint16_t conn_handle, uint16_t chr_val_handle,
+                            uint16_t end_handle)
+{
+    struct ble_store_value_gatt_cache value;
+    ble_addr_t peer_addr;
+    int rc;
+
+    rc = ble_gattc_cache_peer(conn_handle, 1, &peer_addr);
+    if (rc != 0) {
+        return BLE_HS_ENOTSUP;
+    }
+
+    rc = ble_gattc_cache_find_chr(&peer_addr, chr_val_handle, &value);
+    if (rc != 0) {
+        return BLE_HS_ENOTSUP;
+    }
+
+    if (!value.complete || value.end_handle != end_handle) {
+        return BLE_HS_ENOENT;
+    }
+
+    return 0;
+}
+
+int
+ble_gattc_cache_next_svc(uint16_t conn_handle, uint16_t prev_handle,
+                         struct ble_gatt_svc *out_svc)
+{
+    struct ble_store_value_gatt_cache value;
+    int rc;
+
+    rc = ble_gattc_cache_next(conn_handle, BLE_STORE_GATT_CACHE_SVC, 0,
+                              prev_handle, 0xffff, &value);
+    if (rc != 0) {
+        return rc;
+    }
+
+    out_svc->start_handle = value.handle;
+    out_svc->end_handle = value.end_handle;
+    out_svc->uuid = value.uuid;
+
+    return 0;
+}
+
+int
+ble_gattc_cache_next_chr(uint16_t conn_handle, uint16_t prev_handle,
+                         uint16_t end_handle, struct ble_gatt_chr *out_chr)
+{
+    struct ble_store_value_gatt_cache value;
+    int rc;
+
+    rc = ble_gattc_cache_next(conn_handle, BLE_STORE_GATT_CACHE_CHR, 0,
+                              prev_handle, end_handle, &value);
+    if (rc != 0) {
+        return rc;
+    }
+
+    out_chr->def_handle = value.handle;
+    out_chr->val_handle = value.val_handle;
+    out_chr->properties = value.properties;
+    out_chr->uuid = value.uuid;
+
+    return 0;
+}
+
+int
+ble_gattc_cache_next_dsc(uint16_t conn_handle, uint16_t chr_val_handle,
+                         uint16_t prev_handle, uint16_t end_handle,
+                         struct ble_gatt_dsc *out_dsc)
+{
+    struct ble_store_value_gatt_cache value;
+    int rc;
+
+    rc = ble_gattc_cache_next(conn_handle, BLE_STORE_GATT_CACHE_DSC,
+                              chr_val_handle, prev_handle, end_handle,
+                              &value);
+    if (rc != 0) {
+        return rc;
+    }
+
+    out_dsc->handle = value.handle;
+    out_dsc->uuid = value.uuid;
+
+    return 0;
+}
+
+int
+ble_gattc_cache_add_svc(uint16_t conn_handle, const struct ble_gatt_svc *svc)
+{
+    struct ble_store_value_gatt_cache value;
+    ble_addr_t peer_addr;
+    int rc;
+
+    rc = ble_gattc_cache_peer(conn_handle, 1, &peer_addr);
+    if (rc != 0) {
+        return rc;
+    }
+
+    memset(&value, 0, sizeof value);
+    value.type = BLE_STORE_GATT_CACHE_SVC;
+    value.handle = svc->start_handle;
+    value.end_handle = svc->end_handle;
+    value.uuid = svc->uuid;
+
+    return ble_gattc_cache_write(&peer_addr, &value);
+}
+
+int
+ble_gattc_cache_add_chr(uint16_t conn_handle, const struct ble_gatt_chr *chr)
+{
+    struct ble_store_value_gatt_cache value;
+    ble_addr_t peer_addr;
+    int rc;
+
+    rc = ble_gattc_cache_peer(conn_handle, 1, &peer_addr);
+    if (rc != 0) {
+        return rc;
+    }
+
+    memset(&value, 0, sizeof value);
+    value.type = BLE_STORE_GATT_CACHE_CHR;
+    value.handle = chr->def_handle;
+    value.val_handle = chr->val_handle;
+    value.properties = chr->properties;
+    value.uuid = chr->uuid;
+
+    return ble_gattc_cache_write(&peer_addr, &value);
+}
+
+int
+ble_gattc_cache_add_dsc(uint16_t conn_handle, uint16_t chr_val_handle,
+                        const struct ble_gatt_dsc *dsc)
+{
+    struct ble_store_value_gatt_cache value;
+    ble_addr_t peer_addr;
+    int rc;
+
+    rc = ble_gattc_cache_peer(conn_handle, 1, &peer_addr);
+    if (rc != 0) {
+        return rc;
+    }
+
+    memset(&value, 0, sizeof value);
+    value.type = BLE_STORE_GATT_CACHE_DSC;
+    value.handle = dsc->handle;
+    value.val_handle = chr_val_handle;
+    value.uuid = dsc->uuid;
+
+    return ble_gattc_cache_write(&peer_addr, &value);
+}
+
+/**
+ * Marks the list of primary services of the peer as complete.
+ */
+int
+ble_gattc_cache_svcs_done(uint16_t conn_handle)
+{
+    struct ble_store_value_gatt_cache value;
+    ble_addr_t peer_addr;
+    int rc;
+
+    rc = ble_gattc_cache_peer(conn_handle, 1, &peer_addr);
+    if (rc != 0) {
+        return rc;
+    }
+
+    memset(&value, 0, sizeof value);
+    value.type = BLE_STORE_GATT_CACHE_DB;
+    value.complete = 1;
+
+    return ble_gattc_cache_write(&peer_addr, &value);
+}
+
+/**
+ * Marks the characteristics of the specified service as complete.
+ */
+int
+ble_gattc_cache_chrs_done(uint16_t conn_handle, uint16_t start_handle,
+                          uint16_t end_handle)
+{
+    struct ble_store_value_gatt_cache value;
+    ble_addr_t peer_addr;
+    int rc;
+
+    rc = ble_gattc_cache_peer(conn_handle, 1, &peer_addr);
+    if (rc != 0) {
+        return rc;
+    }
+
+    rc = ble_gattc_cache_read(&peer_addr, BLE_STORE_GATT_CACHE_SVC,
+                              start_handle, 0, &value);
+    if (rc != 0) {
+        return rc;
+    }
+
+    if (value.end_handle != end_handle) {
+        return BLE_HS_ENOENT;
+    }
+
+    value.complete = 1;
+    return ble_gattc_cache_write(&peer_addr, &value);
+}
+
+/**
+ * Marks the descriptors of the specified characteristic as complete.
+ */
+int
+ble_gattc_cache_dscs_done(uint16_t conn_handle, uint16_t chr_val_handle,
+                          uint16_t end_handle)
+{
+    struct ble_store_value_gatt_cache value;
+    ble_addr_t peer_addr;
+    int rc;
+
+    rc = ble_gattc_cache_peer(conn_handle, 1, &peer_addr);
+    if (rc != 0) {
+        return rc;
+    }
+
+    rc = ble_gattc_cache_find_chr(&peer_addr, chr_val_handle, &value);
+    if (rc != 0) {
+        return rc;
+    }
+
+    value.end_handle = end_handle;
+    value.complete = 1;
+    return ble_gattc_cache_write(&peer_addr, &value);
+}
+
+/**
+ * Invalidates the cache of the peer if the received indication is a Service
+ * Changed indication.
+ */
+void
+ble_gattc_cache_rx_indicate(uint16_t conn_handle, uint16_t attr_handle)
+{
+    struct ble_store_value_gatt_cache value;
+    ble_addr_t peer_addr;
+    int rc;
+
+    /* Invalidate even before the link is encrypted again. */
+    rc = ble_gattc_cache_peer(conn_handle, 0, &peer_addr);
+    if (rc != 0) {
+        return;
+    }
+
+    rc = ble_gattc_cache_find_chr(&peer_addr, attr_handle, &value);
+    if (rc != 0) {
+        return;
+    }
+
+    if (ble_uuid_cmp(&value.uuid.u,
+                     BLE_UUID16_DECLARE(BLE_GATTC_CACHE_UUID_SVC_CHANGED)) ==
+        0) {
+
+        ble_gattc_cache_clear(&peer_addr);
+    }
+}
+
+#endif
+
+int
+ble_gattc_cache_clear(const ble_addr_t *peer_id_addr)
+{
+#if !MYNEWT_VAL(BLE_GATT_CACHE)
+    return BLE_HS_ENOTSUP;
+#else
+    struct ble_store_key_gatt_cache key;
+
+    memset(&key, 0, sizeof key);
+    key.peer_addr = *peer_id_addr;
+
+    return ble_store_util_delete_all(BLE_STORE_OBJ_TYPE_GATT_CACHE,
+                                     (union ble_store_key *)&key);
+#endif
+}
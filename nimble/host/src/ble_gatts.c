@@ -1298,6 +1298,8 @@ ble_gatts_conn_init(struct ble_gatts_conn *gatts_conn)
         gatts_conn->num_clt_cfgs = 0;
     }
 
+    gatts_conn->clt_sup_feat = 0;
+
     return 0;
 }
 
@@ -1476,17 +1478,62 @@ ble_gatts_rx_indicate_ack(uint16_t conn_handle, uint16_t chr_val_handle)
     return 0;
 }
 
+/**
+ * Store iterator callback; marks a CCCD record as changed if the update will
+ * not reach the peer on its current connection.
+ */
+static int
+ble_gatts_chr_updated_store_cb(int obj_type, union ble_store_value *val,
+                               void *cookie)
+{
+    struct ble_store_value_cccd *cccd_value;
+    struct ble_hs_conn *conn;
+    int persist;
+
+    cccd_value = &val->cccd;
+
+    /* Determine if this record needs to be rewritten. */
+    ble_hs_lock();
+    conn = ble_hs_conn_find_by_addr(&cccd_value->peer_addr);
+
+    if (conn == NULL) {
+        /* Device isn't connected; persist the changed flag so that an
+         * update can be sent when the device reconnects and rebonds.
+         */
+        persist = 1;
+    } else if (cccd_value->flags & BLE_GATTS_CLT_CFG_F_INDICATE) {
+        /* Indication for a connected device; record that the
+         * characteristic has changed until we receive the ack.
+         */
+        persist = 1;
+    } else {
+        /* Notification for a connected device; we already sent it so there
+         * is no need to persist.
+         */
+        persist = 0;
+    }
+
+    ble_hs_unlock();
+
+    /* Only persist if the value changed flag wasn't already sent (i.e.,
+     * don't overwrite with identical data).
+     */
+    if (persist && !cccd_value->value_changed) {
+        cccd_value->value_changed = 1;
+        ble_store_write_cccd(cccd_value);
+    }
+
+    return 0;
+}
+
 void
 ble_gatts_chr_updated(uint16_t chr_val_handle)
 {
-    struct ble_store_value_cccd cccd_value;
-    struct ble_store_key_cccd cccd_key;
+    union ble_store_key cccd_key;
     struct ble_gatts_clt_cfg *clt_cfg;
     struct ble_hs_conn *conn;
     int new_notifications = 0;
     int clt_cfg_idx;
-    int persist;
-    int rc;
     int i;
 
     /* Determine if notifications or indications are allowed for this
@@ -1527,52 +1574,13 @@ ble_gatts_chr_updated(uint16_t chr_val_handle)
 
     /*** Persist updated flag for unconnected and not-yet-bonded devices. */
 
-    /* Retrieve each record corresponding to the modified characteristic. */
-    cccd_key.peer_addr = *BLE_ADDR_ANY;
-    cccd_key.chr_val_handle = chr_val_handle;
-    cccd_key.idx = 0;
-
-    while (1) {
-        rc = ble_store_read_cccd(&cccd_key, &cccd_value);
-        if (rc != 0) {
-            /* Read error or no more CCCD records. */
-            break;
-        }
-
-        /* Determine if this record needs to be rewritten. */
-        ble_hs_lock();
-        conn = ble_hs_conn_find_by_addr(&cccd_key.peer_addr);
-
-        if (conn == NULL) {
-            /* Device isn't connected; persist the changed flag so that an
-             * update can be sent when the device reconnects and rebonds.
-             */
-            persist = 1;
-        } else if (cccd_value.flags & BLE_GATTS_CLT_CFG_F_INDICATE) {
-            /* Indication for a connected device; record that the
-             * characteristic has changed until we receive the ack.
-             */
-            persist = 1;
-        } else {
-            /* Notification for a connected device; we already sent it so there
-             * is no need to persist.
-             */
-            persist = 0;
-        }
-
-        ble_hs_unlock();
+    /* Visit each record corresponding to the modified characteristic. */
+    memset(&cccd_key, 0, sizeof cccd_key);
+    cccd_key.cccd.peer_addr = *BLE_ADDR_ANY;
+    cccd_key.cccd.chr_val_handle = chr_val_handle;
 
-        /* Only persist if the value changed flag wasn't already sent (i.e.,
-         * don't overwrite with identical data).
-         */
-        if (persist && !cccd_value.value_changed) {
-            cccd_value.value_changed = 1;
-            ble_store_write_cccd(&cccd_value);
-        }
-
-        /* Read the next matching record. */
-        cccd_key.idx++;
-    }
+    ble_store_iterate_key(BLE_STORE_OBJ_TYPE_CCCD, &cccd_key,
+                          ble_gatts_chr_updated_store_cb, NULL);
 }
 
 /**
@@ -1661,6 +1669,80 @@ ble_gatts_tx_notifications(void)
     }
 }
 
+/**
+ * Store iterator callback; restores one persisted CCCD record of a peer whose
+ * bonding was just restored.
+ */
+static int
+ble_gatts_bonding_restored_store_cb(int obj_type, union ble_store_value *val,
+                                    void *cookie)
+{
+    struct ble_store_value_cccd *cccd_value;
+    struct ble_gatts_clt_cfg *clt_cfg;
+    struct ble_hs_conn *conn;
+    uint16_t conn_handle;
+    uint8_t att_op;
+    int rc;
+
+    cccd_value = &val->cccd;
+    conn_handle = *(uint16_t *)cookie;
+
+    /* Assume no notification or indication will get sent. */
+    att_op = 0;
+
+    ble_hs_lock();
+
+    conn = ble_hs_conn_find(conn_handle);
+    BLE_HS_DBG_ASSERT(conn != NULL);
+
+    clt_cfg = ble_gatts_clt_cfg_find(conn->bhc_gatt_svr.clt_cfgs,
+                                     cccd_value->chr_val_handle);
+    if (clt_cfg != NULL) {
+        clt_cfg->flags = cccd_value->flags;
+
+        if (cccd_value->value_changed) {
+            /* The characteristic's value changed while the device was
+             * disconnected or unbonded.  Schedule the notification or
+             * indication now.
+             */
+            clt_cfg->flags |= BLE_GATTS_CLT_CFG_F_MODIFIED;
+            att_op = ble_gatts_schedule_update(conn, clt_cfg);
+        }
+    }
+
+    ble_hs_unlock();
+
+    /* Tell the application if the peer changed its subscription state
+     * when it was restored from persistence.
+     */
+    ble_gatts_subscribe_event(conn_handle, cccd_value->chr_val_handle,
+                              BLE_GAP_SUBSCRIBE_REASON_RESTORE,
+                              0, cccd_value->flags);
+
+    switch (att_op) {
+    case 0:
+        break;
+
+    case BLE_ATT_OP_NOTIFY_REQ:
+        rc = ble_gattc_notify(conn_handle, cccd_value->chr_val_handle);
+        if (rc == 0) {
+            cccd_value->value_changed = 0;
+            ble_store_write_cccd(cccd_value);
+        }
+        break;
+
+    case BLE_ATT_OP_INDICATE_REQ:
+        ble_gattc_indicate(conn_handle, cccd_value->chr_val_handle);
+        break;
+
+    default:
+        BLE_HS_DBG_ASSERT(0);
+        break;
+    }
+
+    return 0;
+}
+
 /**
  * Called when bonding has been restored via the encryption procedure.  This
  * function:
@@ -1672,12 +1754,8 @@ ble_gatts_tx_notifications(void)
 void
 ble_gatts_bonding_restored(uint16_t conn_handle)
 {
-    struct ble_store_value_cccd cccd_value;
-    struct ble_store_key_cccd cccd_key;
-    struct ble_gatts_clt_cfg *clt_cfg;
+    union ble_store_key cccd_key;
     struct ble_hs_conn *conn;
-    uint8_t att_op;
-    int rc;
 
     ble_hs_lock();
 
@@ -1685,73 +1763,72 @@ ble_gatts_bonding_restored(uint16_t conn_handle)
     BLE_HS_DBG_ASSERT(conn != NULL);
     BLE_HS_DBG_ASSERT(conn->bhc_sec_state.bonded);
 
-    cccd_key.peer_addr = conn->bhc_peer_addr;
-    cccd_key.chr_val_handle = 0;
-    cccd_key.idx = 0;
+    memset(&cccd_key, 0, sizeof cccd_key);
+    cccd_key.cccd.peer_addr = conn->bhc_peer_addr;
 
     ble_hs_unlock();
 
-    while (1) {
-        rc = ble_store_read_cccd(&cccd_key, &cccd_value);
-        if (rc != 0) {
-            break;
-        }
+    ble_store_iterate_key(BLE_STORE_OBJ_TYPE_CCCD, &cccd_key,
+                          ble_gatts_bonding_restored_store_cb, &conn_handle);
+}
 
-        /* Assume no notification or indication will get sent. */
-        att_op = 0;
+uint8_t
+ble_gatts_srv_sup_feat(void)
+{
+#if MYNEWT_VAL(BLE_EATT_CHAN_NUM) > 0
+    return BLE_GATT_SRV_SUP_FEAT_EATT;
+#else
+    return 0;
+#endif
+}
 
-        ble_hs_lock();
+int
+ble_gatts_clt_sup_feat(uint16_t conn_handle, uint8_t *out_feat)
+{
+    struct ble_hs_conn *conn;
+    int rc;
 
-        conn = ble_hs_conn_find(conn_handle);
-        BLE_HS_DBG_ASSERT(conn != NULL);
+    ble_hs_lock();
 
-        clt_cfg = ble_gatts_clt_cfg_find(conn->bhc_gatt_svr.clt_cfgs,
-                                         cccd_value.chr_val_handle);
-        if (clt_cfg != NULL) {
-            clt_cfg->flags = cccd_value.flags;
+    conn = ble_hs_conn_find(conn_handle);
+    if (conn == NULL) {
+        rc = BLE_HS_ENOTCONN;
+    } else {
+        *out_feat = conn->bhc_gatt_svr.clt_sup_feat;
+        rc = 0;
+    }
 
-            if (cccd_value.value_changed) {
-                /* The characteristic's value changed while the device was
-                 * disconnected or unbonded.  Schedule the notification or
-                 * indication now.
-                 */
-                clt_cfg->flags |= BLE_GATTS_CLT_CFG_F_MODIFIED;
-                att_op = ble_gatts_schedule_update(conn, clt_cfg);
-            }
-        }
+    ble_hs_unlock();
 
-        ble_hs_unlock();
+    return rc;
+}
 
-        /* Tell the application if the peer changed its subscription state
-         * when it was restored from persistence.
-         */
-        ble_gatts_subscribe_event(conn_handle, cccd_value.chr_val_handle,
-                                  BLE_GAP_SUBSCRIBE_REASON_RESTORE,
-                                  0, cccd_value.flags);
+int
+ble_gatts_clt_sup_feat_set(uint16_t conn_handle, uint8_t feat)
+{
+    struct ble_hs_conn *conn;
+    int rc;
 
-        switch (att_op) {
-        case 0:
-            break;
+    feat &= BLE_GATT_CLT_SUP_FEAT_ROBUST_CACHING |
+            BLE_GATT_CLT_SUP_FEAT_EATT |
+            BLE_GATT_CLT_SUP_FEAT_MULT_NTF;
 
-        case BLE_ATT_OP_NOTIFY_REQ:
-            rc = ble_gattc_notify(conn_handle, cccd_value.chr_val_handle);
-            if (rc == 0) {
-                cccd_value.value_changed = 0;
-                ble_store_write_cccd(&cccd_value);
-            }
-            break;
+    ble_hs_lock();
 
-        case BLE_ATT_OP_INDICATE_REQ:
-            ble_gattc_indicate(conn_handle, cccd_value.chr_val_handle);
-            break;
+    conn = ble_hs_conn_find(conn_handle);
+    if (conn == NULL) {
+        rc = BLE_HS_ENOTCONN;
+    } else if (conn->bhc_gatt_svr.clt_sup_feat & ~feat) {
+        /* Features cannot be disabled once enabled. */
+        rc = BLE_HS_EINVAL;
+    } else {
+        conn->bhc_gatt_svr.clt_sup_feat = feat;
+        rc = 0;
+    }
 
-        default:
-            BLE_HS_DBG_ASSERT(0);
-            break;
-        }
+    ble_hs_unlock();
 
-        cccd_key.idx++;
-    }
+    return rc;
 }
 
 static struct ble_gatts_svc_entry *
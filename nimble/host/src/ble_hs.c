@@ -583,6 +583,7 @@ ble_hs_rx_data(struct os_mbuf *om, void *arg)
      * connection handle.
      */
     ble_hs_flow_fill_acl_usrhdr(om);
+    om = ble_hs_flow_rx_acl(om);
 
     rc = ble_mqueue_put(&ble_hs_rx_q, ble_hs_evq, om);
     if (rc != 0) {
@@ -655,6 +656,9 @@ ble_hs_init(void)
     rc = ble_att_svr_init();
     SYSINIT_PANIC_ASSERT(rc == 0);
 
+    rc = ble_eatt_init();
+    SYSINIT_PANIC_ASSERT(rc == 0);
+
     rc = ble_gap_init();
     SYSINIT_PANIC_ASSERT(rc == 0);
 
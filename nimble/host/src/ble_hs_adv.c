@@ -797,3 +797,249 @@ ble_hs_adv_find_field(uint8_t type, const uint8_t *data, uint8_t length,
 
     return 0;
 }
+
+static int
+ble_hs_adv_idx_slot(uint8_t type)
+{
+    if (type == BLE_HS_ADV_TYPE_MFG_DATA) {
+        return 0;
+    }
+
+    if (type > 0 && type < BLE_HS_ADV_IDX_NUM_SLOTS) {
+        return type;
+    }
+
+    return -1;
+}
+
+int
+ble_hs_adv_idx_build(struct ble_hs_adv_idx *idx, const uint8_t *data,
+                     uint16_t length)
+{
+    uint8_t last[BLE_HS_ADV_IDX_NUM_SLOTS];
+    uint16_t off;
+    uint8_t field_len;
+    int slot;
+
+    memset(idx, 0, sizeof *idx);
+    memset(last, 0, sizeof last);
+    idx->data = data;
+
+    off = 0;
+    while (off < length) {
+        field_len = data[off];
+        if (field_len == 0) {
+            break;
+        }
+
+        if (field_len >= length - off) {
+            return BLE_HS_EBADDATA;
+        }
+
+        if (idx->num_fields < BLE_HS_ADV_IDX_MAX_FIELDS) {
+            slot = ble_hs_adv_idx_slot(data[off + 1]);
+            if (slot >= 0) {
+                if (last[slot] == 0) {
+                    idx->first[slot] = idx->num_fields + 1;
+                } else {
+                    idx->next[last[slot] - 1] = idx->num_fields + 1;
+                }
+                last[slot] = idx->num_fields + 1;
+            }
+
+            idx->offs[idx->num_fields++] = off;
+            idx->tail = off + 1 + field_len;
+        }
+
+        off += 1 + field_len;
+    }
+
+    idx->length = off;
+
+    return 0;
+}
+
+/**
+ * Calls func for each AD structure of the specified type, in order of
+ * appearance, until it returns nonzero.
+ *
+ * @return                      The nonzero value returned by func; 0 if func
+ *                                  never returned nonzero.
+ */
+static int
+ble_hs_adv_idx_foreach(const struct ble_hs_adv_idx *idx, uint8_t type,
+                       int (*func)(const struct ble_hs_adv_field *field,
+                                   void *arg),
+                       void *arg)
+{
+    const struct ble_hs_adv_field *field;
+    uint16_t off;
+    int slot;
+    int rc;
+    int i;
+
+    slot = ble_hs_adv_idx_slot(type);
+    if (slot >= 0) {
+        for (i = idx->first[slot]; i != 0; i = idx->next[i - 1]) {
+            field = (const void *)(idx->data + idx->offs[i - 1]);
+            rc = func(field, arg);
+            if (rc != 0) {
+                return rc;
+            }
+        }
+    } else {
+        /* No slot for unassigned types; fall back to a scan of the index. */
+        for (i = 0; i < idx->num_fields; i++) {
+            field = (const void *)(idx->data + idx->offs[i]);
+            if (field->type == type) {
+                rc = func(field, arg);
+                if (rc != 0) {
+                    return rc;
+                }
+            }
+        }
+    }
+
+    /* Structures which did not fit in the index; already validated. */
+    off = idx->tail;
+    while (off < idx->length) {
+        field = (const void *)(idx->data + off);
+        if (field->type == type) {
+            rc = func(field, arg);
+            if (rc != 0) {
+                return rc;
+            }
+        }
+
+        off += 1 + field->length;
+    }
+
+    return 0;
+}
+
+static int
+ble_hs_adv_idx_find_func(const struct ble_hs_adv_field *field, void *arg)
+{
+    const struct ble_hs_adv_field **out = arg;
+
+    *out = field;
+
+    return 1;
+}
+
+int
+ble_hs_adv_idx_find(const struct ble_hs_adv_idx *idx, uint8_t type,
+                    const struct ble_hs_adv_field **out)
+{
+    if (!ble_hs_adv_idx_foreach(idx, type, ble_hs_adv_idx_find_func, out)) {
+        return BLE_HS_ENOENT;
+    }
+
+    return 0;
+}
+
+static int
+ble_hs_adv_idx_uuid_func(const struct ble_hs_adv_field *field, void *arg)
+{
+    const ble_uuid_t *uuid = arg;
+    uint8_t elem_len;
+    int i;
+
+    elem_len = uuid->type / 8;
+
+    /* Compare raw little-endian elements; nothing is converted. */
+    for (i = 0; i + elem_len <= field->length - 1; i += elem_len) {
+        switch (uuid->type) {
+        case BLE_UUID_TYPE_16:
+            if (get_le16(field->value + i) == BLE_UUID16(uuid)->value) {
+                return 1;
+            }
+            break;
+
+        case BLE_UUID_TYPE_32:
+            if (get_le32(field->value + i) == BLE_UUID32(uuid)->value) {
+                return 1;
+            }
+            break;
+
+        case BLE_UUID_TYPE_128:
+            if (memcmp(field->value + i, BLE_UUID128(uuid)->value, 16) == 0) {
+                return 1;
+            }
+            break;
+
+        default:
+            return 0;
+        }
+    }
+
+    return 0;
+}
+
+int
+ble_hs_adv_idx_has_uuid(const struct ble_hs_adv_idx *idx,
+                        const ble_uuid_t *uuid)
+{
+    uint8_t incomp_type;
+
+    switch (uuid->type) {
+    case BLE_UUID_TYPE_16:
+        incomp_type = BLE_HS_ADV_TYPE_INCOMP_UUIDS16;
+        break;
+
+    case BLE_UUID_TYPE_32:
+        incomp_type = BLE_HS_ADV_TYPE_INCOMP_UUIDS32;
+        break;
+
+    case BLE_UUID_TYPE_128:
+        incomp_type = BLE_HS_ADV_TYPE_INCOMP_UUIDS128;
+        break;
+
+    default:
+        return 0;
+    }
+
+    /* The complete list type immediately follows the incomplete one. */
+    return ble_hs_adv_idx_foreach(idx, incomp_type, ble_hs_adv_idx_uuid_func,
+                                  (void *)uuid) ||
+           ble_hs_adv_idx_foreach(idx, incomp_type + 1,
+                                  ble_hs_adv_idx_uuid_func, (void *)uuid);
+}
+
+struct ble_hs_adv_idx_mfg_arg {
+    uint16_t company_id;
+    const void *prefix;
+    uint8_t prefix_len;
+};
+
+static int
+ble_hs_adv_idx_mfg_func(const struct ble_hs_adv_field *field, void *arg)
+{
+    const struct ble_hs_adv_idx_mfg_arg *mfg = arg;
+
+    if (field->length < 1 + 2 + mfg->prefix_len) {
+        return 0;
+    }
+
+    if (get_le16(field->value) != mfg->company_id) {
+        return 0;
+    }
+
+    return mfg->prefix_len == 0 ||
+           memcmp(field->value + 2, mfg->prefix, mfg->prefix_len) == 0;
+}
+
+int
+ble_hs_adv_idx_mfg_match(const struct ble_hs_adv_idx *idx,
+                         uint16_t company_id, const void *prefix,
+                         uint8_t prefix_len)
+{
+    struct ble_hs_adv_idx_mfg_arg mfg = {
+        .company_id = company_id,
+        .prefix = prefix,
+        .prefix_len = prefix_len,
+    };
+
+    return ble_hs_adv_idx_foreach(idx, BLE_HS_ADV_TYPE_MFG_DATA,
+                                  ble_hs_adv_idx_mfg_func, &mfg);
+}
@@ -206,6 +206,7 @@ ble_hs_conn_free(struct ble_hs_conn *conn)
     return;
 #endif
 
+    struct os_mbuf_pkthdr *omp;
     struct ble_l2cap_chan *chan;
     int rc;
 
@@ -219,6 +220,12 @@ ble_hs_conn_free(struct ble_hs_conn *conn)
         ble_hs_conn_delete_chan(conn, chan);
     }
 
+    /* Drop any data that never made it to the controller. */
+    while ((omp = STAILQ_FIRST(&conn->bhc_tx_q)) != NULL) {
+        STAILQ_REMOVE_HEAD(&conn->bhc_tx_q, omp_next);
+        os_mbuf_free_chain(OS_MBUF_PKTHDR_TO_MBUF(omp));
+    }
+
 #if MYNEWT_VAL(BLE_HS_DEBUG)
     memset(conn, 0xff, sizeof *conn);
 #endif
@@ -355,6 +362,28 @@ ble_hs_conn_first(void)
     return SLIST_FIRST(&ble_hs_conns);
 }
 
+/**
+ * Retrieves the number of outgoing ACL data packets of the specified
+ * connection that are either held by the controller or queued in the host.
+ *
+ * Lock restrictions: Caller must lock ble_hs_mutex.
+ */
+int
+ble_hs_conn_tx_backlog(const struct ble_hs_conn *conn)
+{
+    const struct os_mbuf_pkthdr *omp;
+    int backlog;
+
+    BLE_HS_DBG_ASSERT(ble_hs_locked_by_cur_task());
+
+    backlog = conn->bhc_outstanding_pkts;
+    STAILQ_FOREACH(omp, &conn->bhc_tx_q, omp_next) {
+        backlog++;
+    }
+
+    return backlog;
+}
+
 void
 ble_hs_conn_addrs(const struct ble_hs_conn *conn,
                   struct ble_hs_conn_addrs *addrs)
@@ -37,6 +37,7 @@ typedef uint8_t ble_hs_conn_flags_t;
 #define BLE_HS_CONN_F_MASTER        0x01
 #define BLE_HS_CONN_F_TERMINATING   0x02
 #define BLE_HS_CONN_F_TX_FRAG       0x04 /* Cur ACL packet partially txed. */
+#define BLE_HS_CONN_F_TX_BLOCKED    0x08 /* Streamed write refused; notify. */
 
 struct ble_hs_conn {
     SLIST_ENTRY(ble_hs_conn) bhc_next;
@@ -74,11 +75,21 @@ struct ble_hs_conn {
      * and freed.
      */
     uint16_t bhc_completed_pkts;
+
+    /**
+     * Count of ACL buffers holding data received over this connection that
+     * have not been freed yet.
+     */
+    uint16_t bhc_rx_bufs;
 #endif
 
     /** Queue of outgoing packets that could not be sent. */
     STAILQ_HEAD(, os_mbuf_pkthdr) bhc_tx_q;
 
+#if MYNEWT_VAL(BLE_GATT_WRITE_NO_RSP)
+    struct ble_gattc_stream bhc_gattc_stream;
+#endif
+
     struct ble_att_svr_conn bhc_att_svr;
     struct ble_gatts_conn bhc_gatt_svr;
 
@@ -117,6 +128,7 @@ ble_hs_conn_delete_chan(struct ble_hs_conn *conn, struct ble_l2cap_chan *chan);
 
 void ble_hs_conn_addrs(const struct ble_hs_conn *conn,
                        struct ble_hs_conn_addrs *addrs);
+int ble_hs_conn_tx_backlog(const struct ble_hs_conn *conn);
 int32_t ble_hs_conn_timer(void);
 
 int ble_hs_conn_init(void);
@@ -23,9 +23,25 @@
 
 #if MYNEWT_VAL(BLE_HS_FLOW_CTRL)
 
-#define BLE_HS_FLOW_ITVL_TICKS  \
+#define BLE_HS_FLOW_ITVL_MAX_TICKS  \
     ble_npl_time_ms_to_ticks32(MYNEWT_VAL(BLE_HS_FLOW_CTRL_ITVL))
 
+#if MYNEWT_VAL(BLE_HS_FLOW_CTRL_ITVL_MIN) < MYNEWT_VAL(BLE_HS_FLOW_CTRL_ITVL)
+#define BLE_HS_FLOW_ITVL_MIN_TICKS  \
+    ble_npl_time_ms_to_ticks32(MYNEWT_VAL(BLE_HS_FLOW_CTRL_ITVL_MIN))
+#else
+#define BLE_HS_FLOW_ITVL_MIN_TICKS  BLE_HS_FLOW_ITVL_MAX_TICKS
+#endif
+
+/**
+ * The maximum number of entries in a single host-number-of-completed-packets
+ * command; limited by the 255-byte HCI command parameter length.
+ */
+#define BLE_HS_FLOW_MAX_ENTRIES                                         \
+    min(MYNEWT_VAL(BLE_MAX_CONNECTIONS),                                \
+        (255 - BLE_HCI_HOST_NUM_COMP_PKTS_HDR_LEN) /                    \
+            BLE_HCI_HOST_NUM_COMP_PKTS_ENT_LEN)
+
 /**
  * The number of freed buffers since the most-recent
  * number-of-completed-packets event was sent.  This is used to determine if an
@@ -33,6 +49,13 @@
  */
 static uint16_t ble_hs_flow_num_completed_pkts;
 
+/**
+ * The current reporting interval.  This shrinks towards
+ * BLE_HS_FLOW_CTRL_ITVL_MIN while the controller keeps running low on buffers
+ * and grows back to BLE_HS_FLOW_CTRL_ITVL as the load drops.
+ */
+static ble_npl_time_t ble_hs_flow_itvl_ticks;
+
 /** Periodically sends number-of-completed-packets events.  */
 static struct ble_npl_callout ble_hs_flow_timer;
 
@@ -45,36 +68,41 @@ ble_hs_flow_tx_num_comp_pkts(void)
 {
     uint8_t buf[
         BLE_HCI_HOST_NUM_COMP_PKTS_HDR_LEN +
-        BLE_HCI_HOST_NUM_COMP_PKTS_ENT_LEN
+        BLE_HS_FLOW_MAX_ENTRIES * BLE_HCI_HOST_NUM_COMP_PKTS_ENT_LEN
     ];
     struct hci_host_num_comp_pkts_entry entry;
     struct ble_hs_conn *conn;
+    int off;
     int rc;
 
     BLE_HS_DBG_ASSERT(ble_hs_locked_by_cur_task());
 
-    /* For each connection with completed packets, send a separate
-     * host-number-of-completed-packets command.
+    /* Report all connections with completed packets in as few
+     * host-number-of-completed-packets commands as possible.
      */
+    buf[0] = 0;
+    off = BLE_HCI_HOST_NUM_COMP_PKTS_HDR_LEN;
+
     for (conn = ble_hs_conn_first();
          conn != NULL;
          conn = SLIST_NEXT(conn, bhc_next)) {
 
-        if (conn->bhc_completed_pkts > 0) {
-            /* Only specify one connection per command. */
-            buf[0] = 1;
+        if (conn->bhc_completed_pkts == 0) {
+            continue;
+        }
 
-            /* Append entry for this connection. */
-            entry.conn_handle = conn->bhc_handle;
-            entry.num_pkts = conn->bhc_completed_pkts;
-            rc = ble_hs_hci_cmd_build_host_num_comp_pkts_entry(
-                &entry,
-                buf + BLE_HCI_HOST_NUM_COMP_PKTS_HDR_LEN,
-                sizeof buf - BLE_HCI_HOST_NUM_COMP_PKTS_HDR_LEN);
-            BLE_HS_DBG_ASSERT(rc == 0);
+        /* Append entry for this connection. */
+        entry.conn_handle = conn->bhc_handle;
+        entry.num_pkts = conn->bhc_completed_pkts;
+        rc = ble_hs_hci_cmd_build_host_num_comp_pkts_entry(
+            &entry, buf + off, sizeof buf - off);
+        BLE_HS_DBG_ASSERT(rc == 0);
 
-            conn->bhc_completed_pkts = 0;
+        conn->bhc_completed_pkts = 0;
+        off += BLE_HCI_HOST_NUM_COMP_PKTS_ENT_LEN;
+        buf[0]++;
 
+        if (buf[0] == BLE_HS_FLOW_MAX_ENTRIES) {
             /* The host-number-of-completed-packets command does not elicit a
              * response from the controller, so don't use the normal blocking
              * HCI API when sending it.
@@ -82,16 +110,50 @@ ble_hs_flow_tx_num_comp_pkts(void)
             rc = ble_hs_hci_cmd_send_buf(
                 BLE_HCI_OP(BLE_HCI_OGF_CTLR_BASEBAND,
                            BLE_HCI_OCF_CB_HOST_NUM_COMP_PKTS),
-                buf, sizeof(buf));
+                buf, off);
             if (rc != 0) {
                 return rc;
             }
+
+            buf[0] = 0;
+            off = BLE_HCI_HOST_NUM_COMP_PKTS_HDR_LEN;
+        }
+    }
+
+    if (buf[0] > 0) {
+        rc = ble_hs_hci_cmd_send_buf(
+            BLE_HCI_OP(BLE_HCI_OGF_CTLR_BASEBAND,
+                       BLE_HCI_OCF_CB_HOST_NUM_COMP_PKTS),
+            buf, off);
+        if (rc != 0) {
+            return rc;
         }
     }
 
     return 0;
 }
 
+/**
+ * Adjusts the reporting interval according to the number of buffers that
+ * were freed since the previous report.  If the controller ran down to half
+ * its buffers, report twice as often; if it barely used any, half as often.
+ */
+static void
+ble_hs_flow_adapt_itvl(uint16_t num_pkts)
+{
+    if (num_pkts * 2 >= MYNEWT_VAL(BLE_ACL_BUF_COUNT)) {
+        ble_hs_flow_itvl_ticks /= 2;
+        if (ble_hs_flow_itvl_ticks < BLE_HS_FLOW_ITVL_MIN_TICKS) {
+            ble_hs_flow_itvl_ticks = BLE_HS_FLOW_ITVL_MIN_TICKS;
+        }
+    } else if (num_pkts * 4 <= MYNEWT_VAL(BLE_ACL_BUF_COUNT)) {
+        ble_hs_flow_itvl_ticks *= 2;
+        if (ble_hs_flow_itvl_ticks > BLE_HS_FLOW_ITVL_MAX_TICKS) {
+            ble_hs_flow_itvl_ticks = BLE_HS_FLOW_ITVL_MAX_TICKS;
+        }
+    }
+}
+
 static void
 ble_hs_flow_event_cb(struct ble_npl_event *ev)
 {
@@ -105,6 +167,7 @@ ble_hs_flow_event_cb(struct ble_npl_event *ev)
             ble_hs_sched_reset(rc);
         }
 
+        ble_hs_flow_adapt_itvl(ble_hs_flow_num_completed_pkts);
         ble_hs_flow_num_completed_pkts = 0;
     }
 
@@ -123,6 +186,10 @@ ble_hs_flow_inc_completed_pkts(struct ble_hs_conn *conn)
     conn->bhc_completed_pkts++;
     ble_hs_flow_num_completed_pkts++;
 
+    if (conn->bhc_rx_bufs > 0) {
+        conn->bhc_rx_bufs--;
+    }
+
     if (ble_hs_flow_num_completed_pkts > MYNEWT_VAL(BLE_ACL_BUF_COUNT)) {
         ble_hs_sched_reset(BLE_HS_ECONTROLLER);
         return;
@@ -136,7 +203,7 @@ ble_hs_flow_inc_completed_pkts(struct ble_hs_conn *conn)
         ble_npl_eventq_put(ble_hs_evq_get(), &ble_hs_flow_ev);
         ble_npl_callout_stop(&ble_hs_flow_timer);
     } else if (ble_hs_flow_num_completed_pkts == 1) {
-        rc = ble_npl_callout_reset(&ble_hs_flow_timer, BLE_HS_FLOW_ITVL_TICKS);
+        rc = ble_npl_callout_reset(&ble_hs_flow_timer, ble_hs_flow_itvl_ticks);
         BLE_HS_DBG_ASSERT_EVAL(rc == 0);
     }
 }
@@ -214,6 +281,75 @@ ble_hs_flow_fill_acl_usrhdr(struct os_mbuf *om)
 #endif
 }
 
+/**
+ * Accounts for an incoming data packet against its connection's share of the
+ * ACL buffer pool.  If the connection already holds
+ * BLE_HS_FLOW_CTRL_CONN_BUF_MAX buffers, the packet is copied into an msys
+ * mbuf and its ACL buffer is released right away.  This returns the buffer
+ * to the controller so that a single busy peer cannot starve the others.
+ *
+ * If flow control is disabled, this function is a no-op.
+ *
+ * @param om                    The incoming data packet, with its user header
+ *                                  already filled.
+ *
+ * @return                      The packet to process; either the original
+ *                                  one or its copy.
+ */
+struct os_mbuf *
+ble_hs_flow_rx_acl(struct os_mbuf *om)
+{
+#if MYNEWT_VAL(BLE_HS_FLOW_CTRL)
+    struct ble_hs_conn *conn;
+    struct os_mbuf *copy;
+    uint16_t conn_handle;
+    int over_quota;
+    int rc;
+
+    memcpy(&conn_handle, OS_MBUF_USRHDR(om), sizeof conn_handle);
+
+    over_quota = 0;
+
+    ble_hs_lock_nested();
+
+    conn = ble_hs_conn_find(conn_handle);
+    if (conn != NULL) {
+        if (MYNEWT_VAL(BLE_HS_FLOW_CTRL_CONN_BUF_MAX) > 0 &&
+            conn->bhc_rx_bufs >= MYNEWT_VAL(BLE_HS_FLOW_CTRL_CONN_BUF_MAX)) {
+
+            over_quota = 1;
+        }
+
+        /* Released by ble_hs_flow_acl_free() when the buffer is freed. */
+        conn->bhc_rx_bufs++;
+    }
+
+    ble_hs_unlock_nested();
+
+    if (!over_quota) {
+        return om;
+    }
+
+    copy = os_msys_get_pkthdr(OS_MBUF_PKTLEN(om), sizeof conn_handle);
+    if (copy == NULL) {
+        /* Keep the ACL buffer rather than drop the data. */
+        return om;
+    }
+
+    memcpy(OS_MBUF_USRHDR(copy), &conn_handle, sizeof conn_handle);
+    rc = os_mbuf_appendfrom(copy, om, 0, OS_MBUF_PKTLEN(om));
+    if (rc != 0) {
+        os_mbuf_free_chain(copy);
+        return om;
+    }
+
+    os_mbuf_free_chain(om);
+    return copy;
+#else
+    return om;
+#endif
+}
+
 /**
  * Sends the HCI commands to the controller required for enabling host flow
  * control.
@@ -250,6 +386,7 @@ ble_hs_flow_startup(void)
 
     /* Flow control successfully enabled. */
     ble_hs_flow_num_completed_pkts = 0;
+    ble_hs_flow_itvl_ticks = BLE_HS_FLOW_ITVL_MAX_TICKS;
     ble_hci_trans_set_acl_free_cb(ble_hs_flow_acl_free, NULL);
     ble_npl_callout_init(&ble_hs_flow_timer, ble_hs_evq_get(),
                          ble_hs_flow_event_cb, NULL);
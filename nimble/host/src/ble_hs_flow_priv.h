@@ -27,6 +27,7 @@ extern "C" {
 
 void ble_hs_flow_connection_broken(uint16_t conn_handle);
 void ble_hs_flow_fill_acl_usrhdr(struct os_mbuf *om);
+struct os_mbuf *ble_hs_flow_rx_acl(struct os_mbuf *om);
 int ble_hs_flow_startup(void);
 
 #ifdef __cplusplus
@@ -526,6 +526,16 @@ ble_hs_hci_cmd_build_le_add_to_whitelist(const uint8_t *addr,
     return ble_hs_hci_cmd_body_le_whitelist_chg(addr, addr_type, dst);
 }
 
+int
+ble_hs_hci_cmd_build_le_rmv_from_whitelist(const uint8_t *addr,
+                                           uint8_t addr_type,
+                                           uint8_t *dst, int dst_len)
+{
+    BLE_HS_DBG_ASSERT(dst_len >= BLE_HCI_CHG_WHITE_LIST_LEN);
+
+    return ble_hs_hci_cmd_body_le_whitelist_chg(addr, addr_type, dst);
+}
+
 /**
  * Reset the controller and link manager.
  *
@@ -1605,6 +1615,88 @@ ble_hs_hci_cmd_build_le_ext_adv_remove(uint8_t handle,
 
     return 0;
 }
+
+#if MYNEWT_VAL(BLE_PERIODIC_ADV)
+int
+ble_hs_hci_cmd_build_le_periodic_adv_params(uint8_t handle,
+                                            uint16_t itvl_min,
+                                            uint16_t itvl_max,
+                                            uint16_t props,
+                                            uint8_t *cmd, int cmd_len)
+{
+    BLE_HS_DBG_ASSERT(cmd_len >= BLE_HCI_LE_SET_PER_ADV_PARAMS_LEN);
+
+    cmd[0] = handle;
+    put_le16(&cmd[1], itvl_min);
+    put_le16(&cmd[3], itvl_max);
+    put_le16(&cmd[5], props);
+
+    return 0;
+}
+
+int
+ble_hs_hci_cmd_build_le_periodic_adv_data(uint8_t handle, uint8_t operation,
+                                          struct os_mbuf *data, int offset,
+                                          uint8_t data_len,
+                                          uint8_t *cmd, int cmd_len)
+{
+    BLE_HS_DBG_ASSERT(cmd_len >= 3 + data_len);
+
+    cmd[0] = handle;
+    cmd[1] = operation;
+    cmd[2] = data_len;
+    if (data_len > 0) {
+        os_mbuf_copydata(data, offset, data_len, cmd + 3);
+    }
+
+    return 0;
+}
+
+int
+ble_hs_hci_cmd_build_le_periodic_adv_enable(uint8_t enable, uint8_t handle,
+                                            uint8_t *cmd, int cmd_len)
+{
+    BLE_HS_DBG_ASSERT(cmd_len >= BLE_HCI_LE_SET_PER_ADV_ENABLE_LEN);
+
+    cmd[0] = enable;
+    cmd[1] = handle;
+
+    return 0;
+}
+
+int
+ble_hs_hci_cmd_build_le_periodic_adv_create_sync(uint8_t options,
+                                                 uint8_t sid,
+                                                 const ble_addr_t *addr,
+                                                 uint16_t skip,
+                                                 uint16_t sync_timeout,
+                                                 uint8_t *cmd, int cmd_len)
+{
+    BLE_HS_DBG_ASSERT(cmd_len >= BLE_HCI_LE_PER_ADV_CREATE_SYNC_LEN);
+
+    cmd[0] = options;
+    cmd[1] = sid;
+    cmd[2] = addr->type;
+    memcpy(&cmd[3], addr->val, BLE_DEV_ADDR_LEN);
+    put_le16(&cmd[9], skip);
+    put_le16(&cmd[11], sync_timeout);
+    /* Sync CTE type; no constant tone extension restrictions. */
+    cmd[13] = 0;
+
+    return 0;
+}
+
+int
+ble_hs_hci_cmd_build_le_periodic_adv_terminate_sync(uint16_t sync_handle,
+                                                    uint8_t *cmd, int cmd_len)
+{
+    BLE_HS_DBG_ASSERT(cmd_len >= BLE_HCI_LE_PER_ADV_TERM_SYNC_LEN);
+
+    put_le16(cmd, sync_handle);
+
+    return 0;
+}
+#endif
 #endif
 
 static int
@@ -48,6 +48,9 @@ static ble_hs_hci_evt_le_fn ble_hs_hci_evt_le_conn_parm_req;
 static ble_hs_hci_evt_le_fn ble_hs_hci_evt_le_dir_adv_rpt;
 static ble_hs_hci_evt_le_fn ble_hs_hci_evt_le_phy_update_complete;
 static ble_hs_hci_evt_le_fn ble_hs_hci_evt_le_ext_adv_rpt;
+static ble_hs_hci_evt_le_fn ble_hs_hci_evt_le_periodic_adv_sync_estab;
+static ble_hs_hci_evt_le_fn ble_hs_hci_evt_le_periodic_adv_rpt;
+static ble_hs_hci_evt_le_fn ble_hs_hci_evt_le_periodic_adv_sync_lost;
 static ble_hs_hci_evt_le_fn ble_hs_hci_evt_le_rd_rem_used_feat_complete;
 static ble_hs_hci_evt_le_fn ble_hs_hci_evt_le_scan_timeout;
 static ble_hs_hci_evt_le_fn ble_hs_hci_evt_le_adv_set_terminated;
@@ -100,6 +103,11 @@ static const struct ble_hs_hci_evt_le_dispatch_entry
     { BLE_HCI_LE_SUBEV_PHY_UPDATE_COMPLETE,
         ble_hs_hci_evt_le_phy_update_complete },
     { BLE_HCI_LE_SUBEV_EXT_ADV_RPT, ble_hs_hci_evt_le_ext_adv_rpt },
+    { BLE_HCI_LE_SUBEV_PER_ADV_SYNC_ESTAB,
+            ble_hs_hci_evt_le_periodic_adv_sync_estab },
+    { BLE_HCI_LE_SUBEV_PER_ADV_RPT, ble_hs_hci_evt_le_periodic_adv_rpt },
+    { BLE_HCI_LE_SUBEV_PER_ADV_SYNC_LOST,
+            ble_hs_hci_evt_le_periodic_adv_sync_lost },
     { BLE_HCI_LE_SUBEV_RD_REM_USED_FEAT,
             ble_hs_hci_evt_le_rd_rem_used_feat_complete },
     { BLE_HCI_LE_SUBEV_SCAN_TIMEOUT,
@@ -219,6 +227,38 @@ ble_hs_hci_evt_enc_key_refresh(uint8_t event_code, uint8_t *data, int len)
     return 0;
 }
 
+#if MYNEWT_VAL(BLE_GATT_WRITE_NO_RSP)
+/**
+ * Clears the blocked state of the specified connection if its transmit
+ * backlog has dropped below the streaming limit.
+ *
+ * @return                      1 if the connection got unblocked; 0 otherwise.
+ */
+static int
+ble_hs_hci_evt_tx_unblock(uint16_t conn_handle)
+{
+    struct ble_hs_conn *conn;
+    int unblocked;
+
+    unblocked = 0;
+
+    ble_hs_lock();
+
+    conn = ble_hs_conn_find(conn_handle);
+    if (conn != NULL && (conn->bhc_flags & BLE_HS_CONN_F_TX_BLOCKED) &&
+        ble_hs_conn_tx_backlog(conn) <
+        MYNEWT_VAL(BLE_GATT_WRITE_NO_RSP_MAX_PENDING)) {
+
+        conn->bhc_flags &= ~BLE_HS_CONN_F_TX_BLOCKED;
+        unblocked = 1;
+    }
+
+    ble_hs_unlock();
+
+    return unblocked;
+}
+#endif
+
 static int
 ble_hs_hci_evt_num_completed_pkts(uint8_t event_code, uint8_t *data, int len)
 {
@@ -278,6 +318,19 @@ ble_hs_hci_evt_num_completed_pkts(uint8_t event_code, uint8_t *data, int len)
         ble_hs_wakeup_tx();
     }
 
+#if MYNEWT_VAL(BLE_GATT_WRITE_NO_RSP)
+    /* Let streaming writers that were refused know they can continue. */
+    off = BLE_HCI_EVENT_HDR_LEN + 1;
+    for (i = 0; i < num_handles; i++) {
+        handle = get_le16(data + off);
+        off += (2 * sizeof(uint16_t));
+
+        if (ble_hs_hci_evt_tx_unblock(handle)) {
+            ble_gap_tx_ready_event(handle);
+        }
+    }
+#endif
+
     return 0;
 }
 
@@ -408,11 +461,19 @@ ble_hs_hci_evt_le_adv_rpt_first_pass(uint8_t *data, int len)
     return 0;
 }
 
+/**
+ * The number of advertising reports from one HCI event that are decoded and
+ * passed to GAP together.
+ */
+#define BLE_HS_HCI_EVT_ADV_RPT_CHUNK    8
+
 static int
 ble_hs_hci_evt_le_adv_rpt(uint8_t subevent, uint8_t *data, int len)
 {
-    struct ble_gap_disc_desc desc = {0};
+    struct ble_gap_disc_desc descs[BLE_HS_HCI_EVT_ADV_RPT_CHUNK];
+    struct ble_gap_disc_desc *desc;
     uint8_t num_reports;
+    int num_descs;
     int off;
     int rc;
     int i;
@@ -423,30 +484,41 @@ ble_hs_hci_evt_le_adv_rpt(uint8_t subevent, uint8_t *data, int len)
         return rc;
     }
 
-    desc.direct_addr = *BLE_ADDR_ANY;
-
+    num_descs = 0;
     off = 2; /* skip sub-event and num reports */
     num_reports = data[1];
     for (i = 0; i < num_reports; i++) {
-        desc.event_type = data[off];
+        desc = descs + num_descs;
+        memset(desc, 0, sizeof *desc);
+        desc->direct_addr = *BLE_ADDR_ANY;
+
+        desc->event_type = data[off];
         ++off;
 
-        desc.addr.type = data[off];
+        desc->addr.type = data[off];
         ++off;
 
-        memcpy(desc.addr.val, data + off, 6);
+        memcpy(desc->addr.val, data + off, 6);
         off += 6;
 
-        desc.length_data = data[off];
+        desc->length_data = data[off];
         ++off;
 
-        desc.data = data + off;
-        off += desc.length_data;
+        desc->data = data + off;
+        off += desc->length_data;
 
-        desc.rssi = data[off];
+        desc->rssi = data[off];
         ++off;
 
-        ble_gap_rx_adv_report(&desc);
+        num_descs++;
+        if (num_descs == BLE_HS_HCI_EVT_ADV_RPT_CHUNK) {
+            ble_gap_rx_adv_reports(descs, num_descs);
+            num_descs = 0;
+        }
+    }
+
+    if (num_descs > 0) {
+        ble_gap_rx_adv_reports(descs, num_descs);
     }
 
     return 0;
@@ -621,6 +693,82 @@ ble_hs_hci_evt_le_ext_adv_rpt(uint8_t subevent, uint8_t *data, int len)
     return 0;
 }
 
+static int
+ble_hs_hci_evt_le_periodic_adv_sync_estab(uint8_t subevent, uint8_t *data,
+                                          int len)
+{
+#if MYNEWT_VAL(BLE_PERIODIC_ADV)
+    struct hci_le_subev_periodic_adv_sync_estab evt;
+
+    if (len < BLE_HCI_LE_SUBEV_PER_ADV_SYNC_ESTAB_LEN) {
+        return BLE_HS_ECONTROLLER;
+    }
+
+    evt.subevent_code = data[0];
+    evt.status = data[1];
+    evt.sync_handle = get_le16(data + 2);
+    evt.sid = data[4];
+    evt.adv_addr_type = data[5];
+    memcpy(evt.adv_addr, data + 6, BLE_DEV_ADDR_LEN);
+    evt.adv_phy = data[12];
+    evt.per_adv_ival = get_le16(data + 13);
+    evt.adv_clk_accuracy = data[15];
+
+    ble_gap_rx_periodic_adv_sync_estab(&evt);
+#endif
+
+    return 0;
+}
+
+static int
+ble_hs_hci_evt_le_periodic_adv_rpt(uint8_t subevent, uint8_t *data, int len)
+{
+#if MYNEWT_VAL(BLE_PERIODIC_ADV)
+    struct hci_le_subev_periodic_adv_rpt evt;
+
+    if (len < BLE_HCI_LE_SUBEV_PER_ADV_RPT_LEN) {
+        return BLE_HS_ECONTROLLER;
+    }
+
+    evt.subevent_code = data[0];
+    evt.sync_handle = get_le16(data + 1);
+    evt.tx_power = data[3];
+    evt.rssi = data[4];
+    evt.unused = data[5];
+    evt.data_status = data[6];
+    evt.data_length = data[7];
+    evt.data = data + 8;
+
+    if (len < BLE_HCI_LE_SUBEV_PER_ADV_RPT_LEN + evt.data_length) {
+        return BLE_HS_ECONTROLLER;
+    }
+
+    ble_gap_rx_periodic_adv_rpt(&evt);
+#endif
+
+    return 0;
+}
+
+static int
+ble_hs_hci_evt_le_periodic_adv_sync_lost(uint8_t subevent, uint8_t *data,
+                                         int len)
+{
+#if MYNEWT_VAL(BLE_PERIODIC_ADV)
+    struct hci_le_subev_periodic_adv_sync_lost evt;
+
+    if (len < BLE_HCI_LE_SUBEV_PER_ADV_SYNC_LOST_LEN) {
+        return BLE_HS_ECONTROLLER;
+    }
+
+    evt.subevent_code = data[0];
+    evt.sync_handle = get_le16(data + 1);
+
+    ble_gap_rx_periodic_adv_sync_lost(&evt);
+#endif
+
+    return 0;
+}
+
 static int
 ble_hs_hci_evt_le_scan_timeout(uint8_t subevent, uint8_t *data, int len)
 {
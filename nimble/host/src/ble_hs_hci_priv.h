@@ -140,6 +140,9 @@ int ble_hs_hci_cmd_build_le_create_connection(
 int ble_hs_hci_cmd_build_le_add_to_whitelist(const uint8_t *addr,
                                              uint8_t addr_type,
                                              uint8_t *dst, int dst_len);
+int ble_hs_hci_cmd_build_le_rmv_from_whitelist(const uint8_t *addr,
+                                               uint8_t addr_type,
+                                               uint8_t *dst, int dst_len);
 int ble_hs_hci_cmd_reset(void);
 int ble_hs_hci_cmd_tx_set_ctlr_to_host_fc(uint8_t fc_enable);
 int ble_hs_hci_cmd_tx_host_buf_size(const struct hci_host_buf_size *cmd);
@@ -235,6 +238,37 @@ ble_hs_hci_cmd_build_le_ext_adv_params(uint8_t handle,
 int
 ble_hs_hci_cmd_build_le_ext_adv_remove(uint8_t handle,
                                        uint8_t *cmd, int cmd_len);
+
+#if MYNEWT_VAL(BLE_PERIODIC_ADV)
+int
+ble_hs_hci_cmd_build_le_periodic_adv_params(uint8_t handle,
+                                            uint16_t itvl_min,
+                                            uint16_t itvl_max,
+                                            uint16_t props,
+                                            uint8_t *cmd, int cmd_len);
+
+int
+ble_hs_hci_cmd_build_le_periodic_adv_data(uint8_t handle, uint8_t operation,
+                                          struct os_mbuf *data, int offset,
+                                          uint8_t data_len,
+                                          uint8_t *cmd, int cmd_len);
+
+int
+ble_hs_hci_cmd_build_le_periodic_adv_enable(uint8_t enable, uint8_t handle,
+                                            uint8_t *cmd, int cmd_len);
+
+int
+ble_hs_hci_cmd_build_le_periodic_adv_create_sync(uint8_t options,
+                                                 uint8_t sid,
+                                                 const ble_addr_t *addr,
+                                                 uint16_t skip,
+                                                 uint16_t sync_timeout,
+                                                 uint8_t *cmd, int cmd_len);
+
+int
+ble_hs_hci_cmd_build_le_periodic_adv_terminate_sync(uint16_t sync_handle,
+                                                    uint8_t *cmd, int cmd_len);
+#endif
 #endif
 
 int ble_hs_hci_cmd_build_le_enh_recv_test(uint8_t rx_chan, uint8_t phy,
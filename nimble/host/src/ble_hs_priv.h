@@ -24,6 +24,7 @@
 #include <inttypes.h>
 #include "ble_att_cmd_priv.h"
 #include "ble_att_priv.h"
+#include "ble_eatt_priv.h"
 #include "ble_gap_priv.h"
 #include "ble_gatt_priv.h"
 #include "ble_hs_dbg_priv.h"
@@ -124,7 +125,6 @@ void ble_hs_unlock(void);
 void ble_hs_hw_error(uint8_t hw_code);
 void ble_hs_timer_resched(void);
 void ble_hs_notifications_sched(void);
-struct ble_npl_eventq *ble_hs_evq_get(void);
 
 struct ble_mqueue {
     STAILQ_HEAD(, os_mbuf_pkthdr) head;
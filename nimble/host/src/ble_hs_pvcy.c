@@ -25,6 +25,24 @@
 static uint8_t ble_hs_pvcy_started;
 static uint8_t ble_hs_pvcy_irk[16];
 
+/* One entry per bonded peer, plus the local all-zero entry. */
+#define BLE_HS_PVCY_MAX_ENTRIES     (MYNEWT_VAL(BLE_STORE_MAX_BONDS) + 1)
+
+/**
+ * The host's record of the controller's resolving list.  This allows the host
+ * to skip entries the controller already has, and to replace or remove stale
+ * ones, rather than blindly re-adding every bonded peer.  Entries that don't
+ * fit are not recorded; they are simply re-sent if added again.
+ */
+struct ble_hs_pvcy_entry {
+    ble_addr_t peer_addr;
+    uint8_t peer_irk[16];
+    uint8_t seen;
+};
+
+static struct ble_hs_pvcy_entry ble_hs_pvcy_entries[BLE_HS_PVCY_MAX_ENTRIES];
+static uint8_t ble_hs_pvcy_num_entries;
+
 /** Use this as a default IRK if none gets set. */
 const uint8_t ble_hs_pvcy_default_irk[16] = {
     0xef, 0x8d, 0xe2, 0x16, 0x4f, 0xec, 0x43, 0x0d,
@@ -69,10 +87,69 @@ ble_hs_pvcy_set_resolve_enabled(int enable)
     return 0;
 }
 
+static int
+ble_hs_pvcy_entry_find(uint8_t addr_type, const uint8_t *addr)
+{
+    const struct ble_hs_pvcy_entry *entry;
+    int i;
+
+    for (i = 0; i < ble_hs_pvcy_num_entries; i++) {
+        entry = ble_hs_pvcy_entries + i;
+        if (entry->peer_addr.type == addr_type &&
+            memcmp(entry->peer_addr.val, addr, 6) == 0) {
+
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static void
+ble_hs_pvcy_entry_record(uint8_t addr_type, const uint8_t *addr,
+                         const uint8_t *irk)
+{
+    struct ble_hs_pvcy_entry *entry;
+    int idx;
+
+    idx = ble_hs_pvcy_entry_find(addr_type, addr);
+    if (idx != -1) {
+        entry = ble_hs_pvcy_entries + idx;
+    } else {
+        if (ble_hs_pvcy_num_entries >= BLE_HS_PVCY_MAX_ENTRIES) {
+            return;
+        }
+        entry = ble_hs_pvcy_entries + ble_hs_pvcy_num_entries++;
+    }
+
+    entry->peer_addr.type = addr_type;
+    memcpy(entry->peer_addr.val, addr, 6);
+    memcpy(entry->peer_irk, irk, 16);
+    entry->seen = 1;
+}
+
+static void
+ble_hs_pvcy_entry_forget(int idx)
+{
+    ble_hs_pvcy_num_entries--;
+    ble_hs_pvcy_entries[idx] = ble_hs_pvcy_entries[ble_hs_pvcy_num_entries];
+}
+
+/**
+ * Called when the controller is reset; the controller's resolving list is
+ * empty after a reset.
+ */
+void
+ble_hs_pvcy_reset(void)
+{
+    ble_hs_pvcy_num_entries = 0;
+}
+
 int
 ble_hs_pvcy_remove_entry(uint8_t addr_type, const uint8_t *addr)
 {
     uint8_t buf[BLE_HCI_RMV_FROM_RESOLV_LIST_LEN];
+    int idx;
     int rc;
 
     rc = ble_hs_hci_cmd_build_remove_from_resolv_list(addr_type, addr,
@@ -88,6 +165,11 @@ ble_hs_pvcy_remove_entry(uint8_t addr_type, const uint8_t *addr)
         return rc;
     }
 
+    idx = ble_hs_pvcy_entry_find(addr_type, addr);
+    if (idx != -1) {
+        ble_hs_pvcy_entry_forget(idx);
+    }
+
     return 0;
 }
 
@@ -103,6 +185,8 @@ ble_hs_pvcy_clear_entries(void)
         return rc;
     }
 
+    ble_hs_pvcy_num_entries = 0;
+
     return 0;
 }
 
@@ -132,6 +216,7 @@ ble_hs_pvcy_add_entry_hci(const uint8_t *addr, uint8_t addr_type,
         return rc;
     }
 
+    ble_hs_pvcy_entry_record(addr_type, addr, irk);
 
     /* FIXME Controller is BT5.0 and default privacy mode is network which
      * can cause problems for apps which are not aware of it. We need to
@@ -148,14 +233,54 @@ ble_hs_pvcy_add_entry_hci(const uint8_t *addr, uint8_t addr_type,
     return 0;
 }
 
+/**
+ * Adds an entry to the resolving list.  If skip_same is set and the controller
+ * already has an identical entry, nothing is sent.  An existing entry for the
+ * same peer with a different IRK is replaced.  GAP procedures must already be
+ * preempted.
+ */
+static int
+ble_hs_pvcy_add_entry_no_preempt(const uint8_t *addr, uint8_t addr_type,
+                                 const uint8_t *irk, int skip_same)
+{
+    struct ble_hs_pvcy_entry *entry;
+    int idx;
+    int rc;
+
+    STATS_INC(ble_hs_stats, pvcy_add_entry);
+
+    idx = ble_hs_pvcy_entry_find(addr_type, addr);
+    if (idx != -1) {
+        entry = ble_hs_pvcy_entries + idx;
+        if (memcmp(entry->peer_irk, irk, 16) == 0) {
+            if (skip_same) {
+                entry->seen = 1;
+                return 0;
+            }
+        } else {
+            rc = ble_hs_pvcy_remove_entry(addr_type, addr);
+            if (rc != 0) {
+                goto done;
+            }
+        }
+    }
+
+    rc = ble_hs_pvcy_add_entry_hci(addr, addr_type, irk);
+
+done:
+    if (rc != 0) {
+        STATS_INC(ble_hs_stats, pvcy_add_entry_fail);
+    }
+
+    return rc;
+}
+
 int
 ble_hs_pvcy_add_entry(const uint8_t *addr, uint8_t addr_type,
                       const uint8_t *irk)
 {
     int rc;
 
-    STATS_INC(ble_hs_stats, pvcy_add_entry);
-
     /* No GAP procedures can be active when adding an entry to the resolving
      * list (Vol 2, Part E, 7.8.38).  Stop all GAP procedures and temporarily
      * prevent any new ones from being started.
@@ -163,15 +288,82 @@ ble_hs_pvcy_add_entry(const uint8_t *addr, uint8_t addr_type,
     ble_gap_preempt();
 
     /* Try to add the entry now that GAP is halted. */
-    rc = ble_hs_pvcy_add_entry_hci(addr, addr_type, irk);
+    rc = ble_hs_pvcy_add_entry_no_preempt(addr, addr_type, irk, 0);
 
     /* Allow GAP procedures to be started again. */
     ble_gap_preempt_done();
 
+    return rc;
+}
+
+static int
+ble_hs_pvcy_restore_one(int obj_type, union ble_store_value *val,
+                        void *cookie)
+{
+    const struct ble_store_value_sec *sec;
+    int rc;
+
+    BLE_HS_DBG_ASSERT(obj_type == BLE_STORE_OBJ_TYPE_PEER_SEC);
+
+    sec = &val->sec;
+    if (sec->irk_present) {
+        rc = ble_hs_pvcy_add_entry_no_preempt(sec->peer_addr.val,
+                                              sec->peer_addr.type,
+                                              sec->irk, 1);
+        if (rc != 0) {
+            BLE_HS_LOG(ERROR, "failed to configure restored IRK\n");
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Makes the controller's resolving list match the IRKs of the bonded peers in
+ * the store.  Only the differences are sent to the controller: entries it
+ * already has are skipped, changed IRKs are replaced and entries of peers that
+ * are no longer bonded are removed.  GAP procedures are preempted once for the
+ * whole batch rather than once per entry.
+ */
+int
+ble_hs_pvcy_restore_entries(void)
+{
+    struct ble_hs_pvcy_entry *entry;
+    int rc;
+    int i;
+
+    for (i = 0; i < ble_hs_pvcy_num_entries; i++) {
+        ble_hs_pvcy_entries[i].seen = 0;
+    }
+
+    ble_gap_preempt();
+
+    rc = ble_store_iterate(BLE_STORE_OBJ_TYPE_PEER_SEC,
+                           ble_hs_pvcy_restore_one, NULL);
     if (rc != 0) {
-        STATS_INC(ble_hs_stats, pvcy_add_entry_fail);
+        goto done;
+    }
+
+    /* Remove entries of peers that are no longer bonded.  The local entry
+     * (all-zero peer address) is not tied to a bond.
+     */
+    i = 0;
+    while (i < ble_hs_pvcy_num_entries) {
+        entry = ble_hs_pvcy_entries + i;
+        if (entry->seen || ble_addr_cmp(&entry->peer_addr, BLE_ADDR_ANY) == 0) {
+            i++;
+            continue;
+        }
+
+        rc = ble_hs_pvcy_remove_entry(entry->peer_addr.type,
+                                      entry->peer_addr.val);
+        if (rc != 0) {
+            goto done;
+        }
     }
 
+done:
+    ble_gap_preempt_done();
     return rc;
 }
 
@@ -262,6 +262,16 @@ ble_hs_startup_le_set_evmask_tx(void)
          *   0x0000000000080000 LE Channel Selection Algorithm Event
          */
         mask |= 0x00000000000f1800;
+
+#if MYNEWT_VAL(BLE_PERIODIC_ADV)
+        /**
+         * Enable the following LE events:
+         *   0x0000000000002000 LE Periodic Advertising Sync Established Event
+         *   0x0000000000004000 LE Periodic Advertising Report Event
+         *   0x0000000000008000 LE Periodic Advertising Sync Lost Event
+         */
+        mask |= 0x000000000000e000;
+#endif
     }
 
     ble_hs_hci_cmd_build_le_set_event_mask(mask, buf, sizeof buf);
@@ -343,6 +353,10 @@ ble_hs_startup_go(void)
         return rc;
     }
 
+    /* The reset emptied the controller's white list and resolving list. */
+    ble_gap_wl_reset();
+    ble_hs_pvcy_reset();
+
     rc = ble_hs_startup_read_local_ver_tx();
     if (rc != 0) {
         return rc;
@@ -312,6 +312,22 @@ ble_l2cap_coc_cleanup_chan(struct ble_l2cap_chan *chan)
     os_mbuf_free_chain(chan->coc_tx.sdu);
 }
 
+static void
+ble_l2cap_event_coc_tx_unstalled(struct ble_l2cap_chan *chan)
+{
+    struct ble_l2cap_event event = { };
+
+    if (!chan->cb) {
+        return;
+    }
+
+    event.type = BLE_L2CAP_EVENT_COC_TX_UNSTALLED;
+    event.tx_unstalled.conn_handle = chan->conn_handle;
+    event.tx_unstalled.chan = chan;
+
+    chan->cb(&event, chan->cb_arg);
+}
+
 static int
 ble_l2cap_coc_continue_tx(struct ble_l2cap_chan *chan)
 {
@@ -418,6 +434,7 @@ ble_l2cap_coc_le_credits_update(uint16_t conn_handle, uint16_t dcid,
 {
     struct ble_hs_conn *conn;
     struct ble_l2cap_chan *chan;
+    int stalled;
 
     /* remote updated its credits */
     ble_hs_lock();
@@ -441,8 +458,14 @@ ble_l2cap_coc_le_credits_update(uint16_t conn_handle, uint16_t dcid,
     }
 
     chan->coc_tx.credits += credits;
+    stalled = chan->coc_tx.sdu != NULL;
     ble_hs_unlock();
     ble_l2cap_coc_continue_tx(chan);
+
+    /* Let the user know the pending SDU is gone and the next can be sent */
+    if (stalled && chan->coc_tx.sdu == NULL) {
+        ble_l2cap_event_coc_tx_unstalled(chan);
+    }
 }
 
 void
@@ -26,14 +26,13 @@
 #if NIMBLE_BLE_SM
 
 #include "nimble/ble.h"
+#include "nimble/ble_aes.h"
 #include "nimble/nimble_opt.h"
 #include "ble_hs_priv.h"
-#include "tinycrypt/aes.h"
 #include "tinycrypt/constants.h"
 #include "tinycrypt/utils.h"
 
 #if MYNEWT_VAL(BLE_SM_SC)
-#include "tinycrypt/cmac_mode.h"
 #include "tinycrypt/ecc_dh.h"
 #if MYNEWT_VAL(TRNG)
 #include "trng/trng.h"
@@ -57,22 +56,13 @@ ble_sm_alg_xor_128(uint8_t *p, uint8_t *q, uint8_t *r)
 static int
 ble_sm_alg_encrypt(uint8_t *key, uint8_t *plaintext, uint8_t *enc_data)
 {
-    struct tc_aes_key_sched_struct s;
+    uint8_t tmp_key[16];
     uint8_t tmp[16];
 
-    swap_buf(tmp, key, 16);
-
-    if (tc_aes128_set_encrypt_key(&s, tmp) == TC_CRYPTO_FAIL) {
-        return BLE_HS_EUNKNOWN;
-    }
-
+    swap_buf(tmp_key, key, 16);
     swap_buf(tmp, plaintext, 16);
 
-
-
-    if (tc_aes_encrypt(enc_data, tmp, &s) == TC_CRYPTO_FAIL) {
-        return BLE_HS_EUNKNOWN;
-    }
+    ble_aes_encrypt_block(tmp_key, tmp, enc_data);
 
     swap_in_place(enc_data, 16);
 
@@ -206,21 +196,7 @@ static int
 ble_sm_alg_aes_cmac(const uint8_t *key, const uint8_t *in, size_t len,
                     uint8_t *out)
 {
-    struct tc_aes_key_sched_struct sched;
-    struct tc_cmac_struct state;
-
-    if (tc_cmac_setup(&state, key, &sched) == TC_CRYPTO_FAIL) {
-        return BLE_HS_EUNKNOWN;
-    }
-
-    if (tc_cmac_update(&state, in, len) == TC_CRYPTO_FAIL) {
-        return BLE_HS_EUNKNOWN;
-    }
-
-    if (tc_cmac_final(out, &state) == TC_CRYPTO_FAIL) {
-        return BLE_HS_EUNKNOWN;
-    }
-
+    ble_aes_cmac(key, in, len, out);
     return 0;
 }
 
@@ -94,6 +94,25 @@ ble_store_delete(int obj_type, const union ble_store_key *key)
     return rc;
 }
 
+static int
+ble_store_read_next(int obj_type, const union ble_store_key *key, int *cursor,
+                    union ble_store_value *val)
+{
+    int rc;
+
+    ble_hs_lock();
+
+    if (ble_hs_cfg.store_read_next_cb == NULL) {
+        rc = BLE_HS_ENOTSUP;
+    } else {
+        rc = ble_hs_cfg.store_read_next_cb(obj_type, key, cursor, val);
+    }
+
+    ble_hs_unlock();
+
+    return rc;
+}
+
 static int
 ble_store_status(struct ble_store_status_event *event)
 {
@@ -285,6 +304,42 @@ ble_store_delete_cccd(const struct ble_store_key_cccd *key)
     return rc;
 }
 
+int
+ble_store_read_gatt_cache(const struct ble_store_key_gatt_cache *key,
+                          struct ble_store_value_gatt_cache *out_value)
+{
+    union ble_store_value *store_value;
+    union ble_store_key *store_key;
+    int rc;
+
+    store_key = (void *)key;
+    store_value = (void *)out_value;
+    rc = ble_store_read(BLE_STORE_OBJ_TYPE_GATT_CACHE, store_key, store_value);
+    return rc;
+}
+
+int
+ble_store_write_gatt_cache(const struct ble_store_value_gatt_cache *value)
+{
+    union ble_store_value *store_value;
+    int rc;
+
+    store_value = (void *)value;
+    rc = ble_store_write(BLE_STORE_OBJ_TYPE_GATT_CACHE, store_value);
+    return rc;
+}
+
+int
+ble_store_delete_gatt_cache(const struct ble_store_key_gatt_cache *key)
+{
+    union ble_store_key *store_key;
+    int rc;
+
+    store_key = (void *)key;
+    rc = ble_store_delete(BLE_STORE_OBJ_TYPE_GATT_CACHE, store_key);
+    return rc;
+}
+
 void
 ble_store_key_from_value_cccd(struct ble_store_key_cccd *out_key,
                               const struct ble_store_value_cccd *value)
@@ -294,6 +349,17 @@ ble_store_key_from_value_cccd(struct ble_store_key_cccd *out_key,
     out_key->idx = 0;
 }
 
+void
+ble_store_key_from_value_gatt_cache(
+    struct ble_store_key_gatt_cache *out_key,
+    const struct ble_store_value_gatt_cache *value)
+{
+    out_key->peer_addr = value->peer_addr;
+    out_key->type = value->type;
+    out_key->handle = value->handle;
+    out_key->idx = 0;
+}
+
 void
 ble_store_key_from_value_sec(struct ble_store_key_sec *out_key,
                              const struct ble_store_value_sec *value)
@@ -321,34 +387,81 @@ ble_store_key_from_value(int obj_type,
         ble_store_key_from_value_cccd(&out_key->cccd, &value->cccd);
         break;
 
+    case BLE_STORE_OBJ_TYPE_GATT_CACHE:
+        ble_store_key_from_value_gatt_cache(&out_key->gatt_cache,
+                                            &value->gatt_cache);
+        break;
+
     default:
         BLE_HS_DBG_ASSERT(0);
         break;
     }
 }
 
+/**
+ * Invokes a callback for each object in the store which matches the
+ * specified key.  The idx field of the key is ignored.  The callback may
+ * rewrite the object it is passed, but must not add or delete objects of the
+ * type being iterated.
+ *
+ * @param obj_type              The type of object to iterate; one of the
+ *                                  BLE_STORE_OBJ_TYPE_[...] codes.
+ * @param key                   Specifies properties of the objects to
+ *                                  visit.
+ * @param callback              Called for each matching object; returning
+ *                                  nonzero stops the iteration.
+ * @param cookie                Optional argument passed to the callback.
+ *
+ * @return                      0 on success; nonzero on read error.
+ */
 int
-ble_store_iterate(int obj_type,
-                  ble_store_iterator_fn *callback,
-                  void *cookie)
+ble_store_iterate_key(int obj_type, const union ble_store_key *key,
+                      ble_store_iterator_fn *callback, void *cookie)
 {
-    union ble_store_key key;
+    union ble_store_key idx_key;
     union ble_store_value value;
+    int cursor;
     int idx = 0;
     uint8_t *pidx;
     int rc;
 
-    /* a magic value to retrieve anything */
-    memset(&key, 0, sizeof(key));
+    /* Walk the store in a single pass if the backend supports it. */
+    cursor = 0;
+    rc = ble_store_read_next(obj_type, key, &cursor, &value);
+    if (rc != BLE_HS_ENOTSUP) {
+        while (rc == 0) {
+            if (callback != NULL) {
+                rc = callback(obj_type, &value, cookie);
+                if (rc != 0) {
+                    /* User function indicates to stop iterating. */
+                    return 0;
+                }
+            }
+
+            rc = ble_store_read_next(obj_type, key, &cursor, &value);
+        }
+
+        if (rc == BLE_HS_ENOENT) {
+            /* No more entries. */
+            return 0;
+        }
+
+        /* Read error. */
+        return rc;
+    }
+
+    /* Otherwise, read the nth matching object until there are no more. */
+    idx_key = *key;
     switch(obj_type) {
         case BLE_STORE_OBJ_TYPE_PEER_SEC:
         case BLE_STORE_OBJ_TYPE_OUR_SEC:
-            key.sec.peer_addr = *BLE_ADDR_ANY;
-            pidx = &key.sec.idx;
+            pidx = &idx_key.sec.idx;
             break;
         case BLE_STORE_OBJ_TYPE_CCCD:
-            key.cccd.peer_addr = *BLE_ADDR_ANY;
-            pidx = &key.cccd.idx;
+            pidx = &idx_key.cccd.idx;
+            break;
+        case BLE_STORE_OBJ_TYPE_GATT_CACHE:
+            pidx = &idx_key.gatt_cache.idx;
             break;
         default:
             BLE_HS_DBG_ASSERT(0);
@@ -357,7 +470,7 @@ ble_store_iterate(int obj_type,
 
     while (1) {
         *pidx = idx;
-        rc = ble_store_read(obj_type, &key, &value);
+        rc = ble_store_read(obj_type, &idx_key, &value);
         switch (rc) {
         case 0:
             if (callback != NULL) {
@@ -382,6 +495,34 @@ ble_store_iterate(int obj_type,
     }
 }
 
+int
+ble_store_iterate(int obj_type,
+                  ble_store_iterator_fn *callback,
+                  void *cookie)
+{
+    union ble_store_key key;
+
+    /* a magic value to retrieve anything */
+    memset(&key, 0, sizeof(key));
+    switch(obj_type) {
+        case BLE_STORE_OBJ_TYPE_PEER_SEC:
+        case BLE_STORE_OBJ_TYPE_OUR_SEC:
+            key.sec.peer_addr = *BLE_ADDR_ANY;
+            break;
+        case BLE_STORE_OBJ_TYPE_CCCD:
+            key.cccd.peer_addr = *BLE_ADDR_ANY;
+            break;
+        case BLE_STORE_OBJ_TYPE_GATT_CACHE:
+            key.gatt_cache.peer_addr = *BLE_ADDR_ANY;
+            break;
+        default:
+            BLE_HS_DBG_ASSERT(0);
+            return BLE_HS_EINVAL;
+    }
+
+    return ble_store_iterate_key(obj_type, &key, callback, cookie);
+}
+
 /**
  * Deletes all objects from the BLE host store.
  *
@@ -394,6 +535,9 @@ ble_store_clear(void)
         BLE_STORE_OBJ_TYPE_OUR_SEC,
         BLE_STORE_OBJ_TYPE_PEER_SEC,
         BLE_STORE_OBJ_TYPE_CCCD,
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+        BLE_STORE_OBJ_TYPE_GATT_CACHE,
+#endif
     };
     union ble_store_key key;
     int obj_type;
@@ -101,7 +101,8 @@ ble_store_util_bonded_peers(ble_addr_t *out_peer_id_addrs, int *out_num_peers,
 
 /**
  * Deletes all entries from the store that are attached to the specified peer
- * address.  This function deletes security entries and CCCD records.
+ * address.  This function deletes security entries, CCCD records and GATT
+ * client cache records.
  *
  * @param peer_id_addr          Entries with this peer address get deleted.
  *
@@ -135,6 +136,16 @@ ble_store_util_delete_peer(const ble_addr_t *peer_id_addr)
         return rc;
     }
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    memset(&key, 0, sizeof key);
+    key.gatt_cache.peer_addr = *peer_id_addr;
+
+    rc = ble_store_util_delete_all(BLE_STORE_OBJ_TYPE_GATT_CACHE, &key);
+    if (rc != 0) {
+        return rc;
+    }
+#endif
+
     return 0;
 }
 
@@ -31,6 +31,17 @@ int ble_store_config_read(int obj_type, const union ble_store_key *key,
                           union ble_store_value *value);
 int ble_store_config_write(int obj_type, const union ble_store_value *val);
 int ble_store_config_delete(int obj_type, const union ble_store_key *key);
+int ble_store_config_read_next(int obj_type, const union ble_store_key *key,
+                               int *cursor, union ble_store_value *value);
+
+/**
+ * Saves any changes which are still waiting for their deferred write to
+ * persistent storage.  Call this before a planned reset.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_ESTORE_FAIL on failure.
+ */
+int ble_store_config_flush(void);
 
 #ifdef __cplusplus
 }
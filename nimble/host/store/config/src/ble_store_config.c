@@ -40,6 +40,195 @@ struct ble_store_value_cccd
     ble_store_config_cccds[MYNEWT_VAL(BLE_STORE_MAX_CCCDS)];
 int ble_store_config_num_cccds;
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+struct ble_store_value_gatt_cache
+    ble_store_config_gatt_cache[MYNEWT_VAL(BLE_STORE_MAX_GATT_CACHE)];
+int ble_store_config_num_gatt_cache;
+#endif
+
+/*****************************************************************************
+ * $index                                                                    *
+ *****************************************************************************/
+
+typedef int ble_store_config_idx_cmp_fn(const void *key, const void *obj);
+
+/**
+ * Lists the slots of a record array sorted by key, so that the records of a
+ * specific peer can be found with a binary search.  The array itself is kept
+ * in insertion order; this preserves the age ordering of bonds and the slot
+ * numbers used for persistence.
+ */
+struct ble_store_config_idx {
+    uint16_t *slots;
+    const void *objs;
+    int obj_sz;
+    const int *num_objs;
+    ble_store_config_idx_cmp_fn *cmp;
+};
+
+static uint16_t
+    ble_store_config_our_sec_slots[MYNEWT_VAL(BLE_STORE_MAX_BONDS)];
+static uint16_t
+    ble_store_config_peer_sec_slots[MYNEWT_VAL(BLE_STORE_MAX_BONDS)];
+static uint16_t
+    ble_store_config_cccd_slots[MYNEWT_VAL(BLE_STORE_MAX_CCCDS)];
+
+/** Sec records are ordered by peer address. */
+static int
+ble_store_config_idx_cmp_sec(const void *key, const void *obj)
+{
+    const struct ble_store_value_sec *sec;
+
+    sec = obj;
+    return ble_addr_cmp(key, &sec->peer_addr);
+}
+
+/** CCCD records are ordered by peer address, then characteristic handle. */
+static int
+ble_store_config_idx_cmp_cccd(const void *key, const void *obj)
+{
+    const struct ble_store_value_cccd *cccd;
+    const struct ble_store_key_cccd *key_cccd;
+    int rc;
+
+    key_cccd = key;
+    cccd = obj;
+
+    rc = ble_addr_cmp(&key_cccd->peer_addr, &cccd->peer_addr);
+    if (rc != 0) {
+        return rc;
+    }
+
+    return (int)key_cccd->chr_val_handle - (int)cccd->chr_val_handle;
+}
+
+static const struct ble_store_config_idx ble_store_config_our_sec_idx = {
+    .slots = ble_store_config_our_sec_slots,
+    .objs = ble_store_config_our_secs,
+    .obj_sz = sizeof *ble_store_config_our_secs,
+    .num_objs = &ble_store_config_num_our_secs,
+    .cmp = ble_store_config_idx_cmp_sec,
+};
+
+static const struct ble_store_config_idx ble_store_config_peer_sec_idx = {
+    .slots = ble_store_config_peer_sec_slots,
+    .objs = ble_store_config_peer_secs,
+    .obj_sz = sizeof *ble_store_config_peer_secs,
+    .num_objs = &ble_store_config_num_peer_secs,
+    .cmp = ble_store_config_idx_cmp_sec,
+};
+
+static const struct ble_store_config_idx ble_store_config_cccd_idx = {
+    .slots = ble_store_config_cccd_slots,
+    .objs = ble_store_config_cccds,
+    .obj_sz = sizeof *ble_store_config_cccds,
+    .num_objs = &ble_store_config_num_cccds,
+    .cmp = ble_store_config_idx_cmp_cccd,
+};
+
+static const void *
+ble_store_config_idx_obj(const struct ble_store_config_idx *idx, int pos)
+{
+    return (const uint8_t *)idx->objs + idx->slots[pos] * idx->obj_sz;
+}
+
+/**
+ * Finds the position in the index of the first record which is not less
+ * than the specified key.
+ */
+static int
+ble_store_config_idx_lower_bound(const struct ble_store_config_idx *idx,
+                                 const void *key, int num)
+{
+    int lo;
+    int hi;
+    int mid;
+
+    lo = 0;
+    hi = num;
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (idx->cmp(key, ble_store_config_idx_obj(idx, mid)) > 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+/**
+ * Adds a slot to an index which currently lists num records.  The record must
+ * already be written to the array.
+ */
+static void
+ble_store_config_idx_insert(const struct ble_store_config_idx *idx,
+                            const void *key, int slot, int num)
+{
+    int pos;
+
+    pos = ble_store_config_idx_lower_bound(idx, key, num);
+    memmove(idx->slots + pos + 1, idx->slots + pos,
+            (num - pos) * sizeof *idx->slots);
+    idx->slots[pos] = slot;
+}
+
+/**
+ * Removes a slot from the index, ahead of the record being deleted from the
+ * array.  The records which follow it move down one slot.
+ */
+static void
+ble_store_config_idx_remove(const struct ble_store_config_idx *idx, int slot)
+{
+    int num;
+    int i;
+    int j;
+
+    num = *idx->num_objs;
+    j = 0;
+    for (i = 0; i < num; i++) {
+        if (idx->slots[i] == slot) {
+            continue;
+        }
+
+        if (idx->slots[i] > slot) {
+            idx->slots[j] = idx->slots[i] - 1;
+        } else {
+            idx->slots[j] = idx->slots[i];
+        }
+        j++;
+    }
+}
+
+/**
+ * Rebuilds the indices after the record arrays have been loaded.
+ */
+void
+ble_store_config_idx_build(void)
+{
+    struct ble_store_key_cccd key_cccd;
+    int i;
+
+    for (i = 0; i < ble_store_config_num_our_secs; i++) {
+        ble_store_config_idx_insert(&ble_store_config_our_sec_idx,
+                                    &ble_store_config_our_secs[i].peer_addr,
+                                    i, i);
+    }
+
+    for (i = 0; i < ble_store_config_num_peer_secs; i++) {
+        ble_store_config_idx_insert(&ble_store_config_peer_sec_idx,
+                                    &ble_store_config_peer_secs[i].peer_addr,
+                                    i, i);
+    }
+
+    for (i = 0; i < ble_store_config_num_cccds; i++) {
+        ble_store_key_from_value_cccd(&key_cccd, ble_store_config_cccds + i);
+        ble_store_config_idx_insert(&ble_store_config_cccd_idx, &key_cccd,
+                                    i, i);
+    }
+}
+
 /*****************************************************************************
  * $sec                                                                      *
  *****************************************************************************/
@@ -82,24 +271,50 @@ ble_store_config_print_key_sec(const struct ble_store_key_sec *key_sec)
     }
 }
 
+/**
+ * Finds the next sec record matching the key, starting at the specified
+ * position of the walk.  Records of a specific peer are looked up through the
+ * index; otherwise, the array is scanned.
+ *
+ * @param skip                  The number of matching records to skip.
+ * @param pos                   On input, the position to start at; on
+ *                                  success, the position of the match.
+ *
+ * @return                      The slot of the matching record; -1 if there
+ *                                  is none.
+ */
 static int
 ble_store_config_find_sec(const struct ble_store_key_sec *key_sec,
-                          const struct ble_store_value_sec *value_secs,
-                          int num_value_secs)
+                          const struct ble_store_config_idx *idx,
+                          int skip, int *pos)
 {
+    const struct ble_store_value_sec *value_secs;
     const struct ble_store_value_sec *cur;
-    int skipped;
+    int by_addr;
     int i;
 
-    skipped = 0;
+    value_secs = idx->objs;
 
-    for (i = 0; i < num_value_secs; i++) {
-        cur = value_secs + i;
+    by_addr = ble_addr_cmp(&key_sec->peer_addr, BLE_ADDR_ANY) != 0;
+    if (by_addr) {
+        i = ble_store_config_idx_lower_bound(idx, &key_sec->peer_addr,
+                                             *idx->num_objs);
+        if (*pos < i) {
+            *pos = i;
+        }
+    }
 
-        if (ble_addr_cmp(&key_sec->peer_addr, BLE_ADDR_ANY)) {
+    for (; *pos < *idx->num_objs; (*pos)++) {
+        if (by_addr) {
+            i = idx->slots[*pos];
+            cur = value_secs + i;
             if (ble_addr_cmp(&cur->peer_addr, &key_sec->peer_addr)) {
-                continue;
+                /* No more records of this peer. */
+                break;
             }
+        } else {
+            i = *pos;
+            cur = value_secs + i;
         }
 
         if (key_sec->ediv_rand_present) {
@@ -112,8 +327,8 @@ ble_store_config_find_sec(const struct ble_store_key_sec *key_sec,
             }
         }
 
-        if (key_sec->idx > skipped) {
-            skipped++;
+        if (skip > 0) {
+            skip--;
             continue;
         }
 
@@ -128,9 +343,11 @@ ble_store_config_read_our_sec(const struct ble_store_key_sec *key_sec,
                               struct ble_store_value_sec *value_sec)
 {
     int idx;
+    int pos;
 
-    idx = ble_store_config_find_sec(key_sec, ble_store_config_our_secs,
-                                    ble_store_config_num_our_secs);
+    pos = 0;
+    idx = ble_store_config_find_sec(key_sec, &ble_store_config_our_sec_idx,
+                                    key_sec->idx, &pos);
     if (idx == -1) {
         return BLE_HS_ENOENT;
     }
@@ -145,14 +362,16 @@ ble_store_config_write_our_sec(const struct ble_store_value_sec *value_sec)
 {
     struct ble_store_key_sec key_sec;
     int idx;
+    int pos;
     int rc;
 
     BLE_HS_LOG(DEBUG, "persisting our sec; ");
     ble_store_config_print_value_sec(value_sec);
 
     ble_store_key_from_value_sec(&key_sec, value_sec);
-    idx = ble_store_config_find_sec(&key_sec, ble_store_config_our_secs,
-                                    ble_store_config_num_our_secs);
+    pos = 0;
+    idx = ble_store_config_find_sec(&key_sec, &ble_store_config_our_sec_idx,
+                                    0, &pos);
     if (idx == -1) {
         if (ble_store_config_num_our_secs >= MYNEWT_VAL(BLE_STORE_MAX_BONDS)) {
             BLE_HS_LOG(DEBUG, "error persisting our sec; too many entries "
@@ -161,12 +380,15 @@ ble_store_config_write_our_sec(const struct ble_store_value_sec *value_sec)
         }
 
         idx = ble_store_config_num_our_secs;
+        ble_store_config_our_secs[idx] = *value_sec;
+        ble_store_config_idx_insert(&ble_store_config_our_sec_idx,
+                                    &value_sec->peer_addr, idx, idx);
         ble_store_config_num_our_secs++;
     }
 
     ble_store_config_our_secs[idx] = *value_sec;
 
-    rc = ble_store_config_persist_our_secs();
+    rc = ble_store_config_persist_our_secs(idx, idx);
     if (rc != 0) {
         return rc;
     }
@@ -198,16 +420,22 @@ ble_store_config_delete_obj(void *values, int value_size, int idx,
 static int
 ble_store_config_delete_sec(const struct ble_store_key_sec *key_sec,
                             struct ble_store_value_sec *value_secs,
-                            int *num_value_secs)
+                            int *num_value_secs,
+                            const struct ble_store_config_idx *sec_idx,
+                            int *out_idx)
 {
     int idx;
+    int pos;
     int rc;
 
-    idx = ble_store_config_find_sec(key_sec, value_secs, *num_value_secs);
+    pos = 0;
+    idx = ble_store_config_find_sec(key_sec, sec_idx, key_sec->idx, &pos);
     if (idx == -1) {
         return BLE_HS_ENOENT;
     }
+    *out_idx = idx;
 
+    ble_store_config_idx_remove(sec_idx, idx);
     rc = ble_store_config_delete_obj(value_secs, sizeof *value_secs, idx,
                                   num_value_secs);
     if (rc != 0) {
@@ -220,15 +448,19 @@ ble_store_config_delete_sec(const struct ble_store_key_sec *key_sec,
 static int
 ble_store_config_delete_our_sec(const struct ble_store_key_sec *key_sec)
 {
+    int idx;
     int rc;
 
     rc = ble_store_config_delete_sec(key_sec, ble_store_config_our_secs,
-                                     &ble_store_config_num_our_secs);
+                                     &ble_store_config_num_our_secs,
+                                     &ble_store_config_our_sec_idx, &idx);
     if (rc != 0) {
         return rc;
     }
 
-    rc = ble_store_config_persist_our_secs();
+    /* The following records moved down one slot. */
+    rc = ble_store_config_persist_our_secs(idx,
+                                           ble_store_config_num_our_secs);
     if (rc != 0) {
         return rc;
     }
@@ -239,15 +471,18 @@ ble_store_config_delete_our_sec(const struct ble_store_key_sec *key_sec)
 static int
 ble_store_config_delete_peer_sec(const struct ble_store_key_sec *key_sec)
 {
+    int idx;
     int rc;
 
     rc = ble_store_config_delete_sec(key_sec, ble_store_config_peer_secs,
-                                  &ble_store_config_num_peer_secs);
+                                  &ble_store_config_num_peer_secs,
+                                  &ble_store_config_peer_sec_idx, &idx);
     if (rc != 0) {
         return rc;
     }
 
-    rc = ble_store_config_persist_peer_secs();
+    rc = ble_store_config_persist_peer_secs(idx,
+                                            ble_store_config_num_peer_secs);
     if (rc != 0) {
         return rc;
     }
@@ -260,9 +495,11 @@ ble_store_config_read_peer_sec(const struct ble_store_key_sec *key_sec,
                                struct ble_store_value_sec *value_sec)
 {
     int idx;
+    int pos;
 
-    idx = ble_store_config_find_sec(key_sec, ble_store_config_peer_secs,
-                             ble_store_config_num_peer_secs);
+    pos = 0;
+    idx = ble_store_config_find_sec(key_sec, &ble_store_config_peer_sec_idx,
+                                    key_sec->idx, &pos);
     if (idx == -1) {
         return BLE_HS_ENOENT;
     }
@@ -276,14 +513,16 @@ ble_store_config_write_peer_sec(const struct ble_store_value_sec *value_sec)
 {
     struct ble_store_key_sec key_sec;
     int idx;
+    int pos;
     int rc;
 
     BLE_HS_LOG(DEBUG, "persisting peer sec; ");
     ble_store_config_print_value_sec(value_sec);
 
     ble_store_key_from_value_sec(&key_sec, value_sec);
-    idx = ble_store_config_find_sec(&key_sec, ble_store_config_peer_secs,
-                                 ble_store_config_num_peer_secs);
+    pos = 0;
+    idx = ble_store_config_find_sec(&key_sec, &ble_store_config_peer_sec_idx,
+                                    0, &pos);
     if (idx == -1) {
         if (ble_store_config_num_peer_secs >= MYNEWT_VAL(BLE_STORE_MAX_BONDS)) {
             BLE_HS_LOG(DEBUG, "error persisting peer sec; too many entries "
@@ -292,12 +531,15 @@ ble_store_config_write_peer_sec(const struct ble_store_value_sec *value_sec)
         }
 
         idx = ble_store_config_num_peer_secs;
+        ble_store_config_peer_secs[idx] = *value_sec;
+        ble_store_config_idx_insert(&ble_store_config_peer_sec_idx,
+                                    &value_sec->peer_addr, idx, idx);
         ble_store_config_num_peer_secs++;
     }
 
     ble_store_config_peer_secs[idx] = *value_sec;
 
-    rc = ble_store_config_persist_peer_secs();
+    rc = ble_store_config_persist_peer_secs(idx, idx);
     if (rc != 0) {
         return rc;
     }
@@ -309,31 +551,56 @@ ble_store_config_write_peer_sec(const struct ble_store_value_sec *value_sec)
  * $cccd                                                                     *
  *****************************************************************************/
 
+/**
+ * Finds the next CCCD record matching the key; see
+ * ble_store_config_find_sec().
+ */
 static int
-ble_store_config_find_cccd(const struct ble_store_key_cccd *key)
+ble_store_config_find_cccd(const struct ble_store_key_cccd *key, int skip,
+                           int *pos)
 {
     struct ble_store_value_cccd *cccd;
-    int skipped;
+    int by_addr;
     int i;
 
-    skipped = 0;
-    for (i = 0; i < ble_store_config_num_cccds; i++) {
-        cccd = ble_store_config_cccds + i;
+    by_addr = ble_addr_cmp(&key->peer_addr, BLE_ADDR_ANY) != 0;
+    if (by_addr) {
+        i = ble_store_config_idx_lower_bound(&ble_store_config_cccd_idx, key,
+                                             ble_store_config_num_cccds);
+        if (*pos < i) {
+            *pos = i;
+        }
+    }
 
-        if (ble_addr_cmp(&key->peer_addr, BLE_ADDR_ANY)) {
+    for (; *pos < ble_store_config_num_cccds; (*pos)++) {
+        if (by_addr) {
+            i = ble_store_config_cccd_slots[*pos];
+            cccd = ble_store_config_cccds + i;
+
+            /* Records of a peer are sorted by handle, so the walk is over as
+             * soon as either differs.
+             */
             if (ble_addr_cmp(&cccd->peer_addr, &key->peer_addr)) {
-                continue;
+                break;
             }
-        }
+            if (key->chr_val_handle != 0 &&
+                cccd->chr_val_handle != key->chr_val_handle) {
+
+                break;
+            }
+        } else {
+            i = *pos;
+            cccd = ble_store_config_cccds + i;
+
+            if (key->chr_val_handle != 0 &&
+                cccd->chr_val_handle != key->chr_val_handle) {
 
-        if (key->chr_val_handle != 0) {
-            if (cccd->chr_val_handle != key->chr_val_handle) {
                 continue;
             }
         }
 
-        if (key->idx > skipped) {
-            skipped++;
+        if (skip > 0) {
+            skip--;
             continue;
         }
 
@@ -347,13 +614,16 @@ static int
 ble_store_config_delete_cccd(const struct ble_store_key_cccd *key_cccd)
 {
     int idx;
+    int pos;
     int rc;
 
-    idx = ble_store_config_find_cccd(key_cccd);
+    pos = 0;
+    idx = ble_store_config_find_cccd(key_cccd, key_cccd->idx, &pos);
     if (idx == -1) {
         return BLE_HS_ENOENT;
     }
 
+    ble_store_config_idx_remove(&ble_store_config_cccd_idx, idx);
     rc = ble_store_config_delete_obj(ble_store_config_cccds,
                                      sizeof *ble_store_config_cccds,
                                      idx,
@@ -362,7 +632,7 @@ ble_store_config_delete_cccd(const struct ble_store_key_cccd *key_cccd)
         return rc;
     }
 
-    rc = ble_store_config_persist_cccds();
+    rc = ble_store_config_persist_cccds(idx, ble_store_config_num_cccds);
     if (rc != 0) {
         return rc;
     }
@@ -375,8 +645,10 @@ ble_store_config_read_cccd(const struct ble_store_key_cccd *key_cccd,
                            struct ble_store_value_cccd *value_cccd)
 {
     int idx;
+    int pos;
 
-    idx = ble_store_config_find_cccd(key_cccd);
+    pos = 0;
+    idx = ble_store_config_find_cccd(key_cccd, key_cccd->idx, &pos);
     if (idx == -1) {
         return BLE_HS_ENOENT;
     }
@@ -390,10 +662,12 @@ ble_store_config_write_cccd(const struct ble_store_value_cccd *value_cccd)
 {
     struct ble_store_key_cccd key_cccd;
     int idx;
+    int pos;
     int rc;
 
     ble_store_key_from_value_cccd(&key_cccd, value_cccd);
-    idx = ble_store_config_find_cccd(&key_cccd);
+    pos = 0;
+    idx = ble_store_config_find_cccd(&key_cccd, 0, &pos);
     if (idx == -1) {
         if (ble_store_config_num_cccds >= MYNEWT_VAL(BLE_STORE_MAX_CCCDS)) {
             BLE_HS_LOG(DEBUG, "error persisting cccd; too many entries (%d)\n",
@@ -402,18 +676,149 @@ ble_store_config_write_cccd(const struct ble_store_value_cccd *value_cccd)
         }
 
         idx = ble_store_config_num_cccds;
+        ble_store_config_cccds[idx] = *value_cccd;
+        ble_store_config_idx_insert(&ble_store_config_cccd_idx, &key_cccd,
+                                    idx, idx);
         ble_store_config_num_cccds++;
     }
 
     ble_store_config_cccds[idx] = *value_cccd;
 
-    rc = ble_store_config_persist_cccds();
+    rc = ble_store_config_persist_cccds(idx, idx);
+    if (rc != 0) {
+        return rc;
+    }
+
+    return 0;
+}
+
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+/*****************************************************************************
+ * $gatt cache                                                               *
+ *****************************************************************************/
+
+static int
+ble_store_config_find_gatt_cache(const struct ble_store_key_gatt_cache *key,
+                                 int skip, int *pos)
+{
+    struct ble_store_value_gatt_cache *rec;
+    int i;
+
+    for (; *pos < ble_store_config_num_gatt_cache; (*pos)++) {
+        i = *pos;
+        rec = ble_store_config_gatt_cache + i;
+
+        if (ble_addr_cmp(&key->peer_addr, BLE_ADDR_ANY)) {
+            if (ble_addr_cmp(&rec->peer_addr, &key->peer_addr)) {
+                continue;
+            }
+        }
+
+        if (key->type != 0) {
+            if (rec->type != key->type) {
+                continue;
+            }
+        }
+
+        if (key->handle != 0) {
+            if (rec->handle != key->handle) {
+                continue;
+            }
+        }
+
+        if (skip > 0) {
+            skip--;
+            continue;
+        }
+
+        return i;
+    }
+
+    return -1;
+}
+
+static int
+ble_store_config_delete_gatt_cache(const struct ble_store_key_gatt_cache *key)
+{
+    int idx;
+    int pos;
+    int rc;
+
+    pos = 0;
+    idx = ble_store_config_find_gatt_cache(key, key->idx, &pos);
+    if (idx == -1) {
+        return BLE_HS_ENOENT;
+    }
+
+    rc = ble_store_config_delete_obj(ble_store_config_gatt_cache,
+                                     sizeof *ble_store_config_gatt_cache,
+                                     idx,
+                                     &ble_store_config_num_gatt_cache);
+    if (rc != 0) {
+        return rc;
+    }
+
+    rc = ble_store_config_persist_gatt_cache(idx,
+                                             ble_store_config_num_gatt_cache);
+    if (rc != 0) {
+        return rc;
+    }
+
+    return 0;
+}
+
+static int
+ble_store_config_read_gatt_cache(const struct ble_store_key_gatt_cache *key,
+                                 struct ble_store_value_gatt_cache *value)
+{
+    int idx;
+    int pos;
+
+    pos = 0;
+    idx = ble_store_config_find_gatt_cache(key, key->idx, &pos);
+    if (idx == -1) {
+        return BLE_HS_ENOENT;
+    }
+
+    *value = ble_store_config_gatt_cache[idx];
+    return 0;
+}
+
+static int
+ble_store_config_write_gatt_cache(
+    const struct ble_store_value_gatt_cache *value)
+{
+    struct ble_store_key_gatt_cache key;
+    int idx;
+    int pos;
+    int rc;
+
+    ble_store_key_from_value_gatt_cache(&key, value);
+    pos = 0;
+    idx = ble_store_config_find_gatt_cache(&key, 0, &pos);
+    if (idx == -1) {
+        if (ble_store_config_num_gatt_cache >=
+            MYNEWT_VAL(BLE_STORE_MAX_GATT_CACHE)) {
+
+            BLE_HS_LOG(DEBUG, "error persisting gatt cache; too many entries "
+                              "(%d)\n", ble_store_config_num_gatt_cache);
+            return BLE_HS_ESTORE_CAP;
+        }
+
+        idx = ble_store_config_num_gatt_cache;
+        ble_store_config_num_gatt_cache++;
+    }
+
+    ble_store_config_gatt_cache[idx] = *value;
+
+    rc = ble_store_config_persist_gatt_cache(idx, idx);
     if (rc != 0) {
         return rc;
     }
 
     return 0;
 }
+#endif
 
 /*****************************************************************************
  * $api                                                                      *
@@ -457,6 +862,13 @@ ble_store_config_read(int obj_type, const union ble_store_key *key,
         rc = ble_store_config_read_cccd(&key->cccd, &value->cccd);
         return rc;
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    case BLE_STORE_OBJ_TYPE_GATT_CACHE:
+        rc = ble_store_config_read_gatt_cache(&key->gatt_cache,
+                                              &value->gatt_cache);
+        return rc;
+#endif
+
     default:
         return BLE_HS_ENOTSUP;
     }
@@ -486,9 +898,75 @@ ble_store_config_write(int obj_type, const union ble_store_value *val)
         rc = ble_store_config_write_cccd(&val->cccd);
         return rc;
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    case BLE_STORE_OBJ_TYPE_GATT_CACHE:
+        rc = ble_store_config_write_gatt_cache(&val->gatt_cache);
+        return rc;
+#endif
+
+    default:
+        return BLE_HS_ENOTSUP;
+    }
+}
+
+/**
+ * Reads the next object matching the specified criteria, continuing a walk
+ * of the database.
+ *
+ * @return                      0 if an object was found;
+ *                              BLE_HS_ENOENT if there are no more matches.
+ */
+int
+ble_store_config_read_next(int obj_type, const union ble_store_key *key,
+                           int *cursor, union ble_store_value *value)
+{
+    int idx;
+
+    switch (obj_type) {
+    case BLE_STORE_OBJ_TYPE_PEER_SEC:
+        idx = ble_store_config_find_sec(&key->sec,
+                                        &ble_store_config_peer_sec_idx, 0,
+                                        cursor);
+        if (idx == -1) {
+            return BLE_HS_ENOENT;
+        }
+        value->sec = ble_store_config_peer_secs[idx];
+        break;
+
+    case BLE_STORE_OBJ_TYPE_OUR_SEC:
+        idx = ble_store_config_find_sec(&key->sec,
+                                        &ble_store_config_our_sec_idx, 0,
+                                        cursor);
+        if (idx == -1) {
+            return BLE_HS_ENOENT;
+        }
+        value->sec = ble_store_config_our_secs[idx];
+        break;
+
+    case BLE_STORE_OBJ_TYPE_CCCD:
+        idx = ble_store_config_find_cccd(&key->cccd, 0, cursor);
+        if (idx == -1) {
+            return BLE_HS_ENOENT;
+        }
+        value->cccd = ble_store_config_cccds[idx];
+        break;
+
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    case BLE_STORE_OBJ_TYPE_GATT_CACHE:
+        idx = ble_store_config_find_gatt_cache(&key->gatt_cache, 0, cursor);
+        if (idx == -1) {
+            return BLE_HS_ENOENT;
+        }
+        value->gatt_cache = ble_store_config_gatt_cache[idx];
+        break;
+#endif
+
     default:
         return BLE_HS_ENOTSUP;
     }
+
+    (*cursor)++;
+    return 0;
 }
 
 int
@@ -509,11 +987,23 @@ ble_store_config_delete(int obj_type, const union ble_store_key *key)
         rc = ble_store_config_delete_cccd(&key->cccd);
         return rc;
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    case BLE_STORE_OBJ_TYPE_GATT_CACHE:
+        rc = ble_store_config_delete_gatt_cache(&key->gatt_cache);
+        return rc;
+#endif
+
     default:
         return BLE_HS_ENOTSUP;
     }
 }
 
+int
+ble_store_config_flush(void)
+{
+    return ble_store_config_conf_flush();
+}
+
 void
 ble_store_config_init(void)
 {
@@ -523,11 +1013,15 @@ ble_store_config_init(void)
     ble_hs_cfg.store_read_cb = ble_store_config_read;
     ble_hs_cfg.store_write_cb = ble_store_config_write;
     ble_hs_cfg.store_delete_cb = ble_store_config_delete;
+    ble_hs_cfg.store_read_next_cb = ble_store_config_read_next;
 
     /* Re-initialize BSS values in case of unit tests. */
     ble_store_config_num_our_secs = 0;
     ble_store_config_num_peer_secs = 0;
     ble_store_config_num_cccds = 0;
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    ble_store_config_num_gatt_cache = 0;
+#endif
 
     ble_store_config_conf_init();
 }
@@ -22,6 +22,8 @@
 #if MYNEWT_VAL(BLE_STORE_CONFIG_PERSIST)
 
 #include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "sysinit/sysinit.h"
@@ -34,6 +36,8 @@
 static int
 ble_store_config_conf_set(int argc, char **argv, char *val);
 static int
+ble_store_config_conf_commit(void);
+static int
 ble_store_config_conf_export(void (*func)(char *name, char *val),
                              enum conf_export_tgt tgt);
 
@@ -41,32 +45,148 @@ static struct conf_handler ble_store_config_conf_handler = {
     .ch_name = "ble_hs",
     .ch_get = NULL,
     .ch_set = ble_store_config_conf_set,
-    .ch_commit = NULL,
+    .ch_commit = ble_store_config_conf_commit,
     .ch_export = ble_store_config_conf_export
 };
 
-#define BLE_STORE_CONFIG_SEC_ENCODE_SZ      \
-    BASE64_ENCODE_SIZE(sizeof (struct ble_store_value_sec))
+/**
+ * Each record is saved under its own key, "ble_hs/<set>/<index>", so that a
+ * change to one record only rewrites that record.  Older releases saved each
+ * set as a single blob under "ble_hs/<set>"; such blobs are still accepted
+ * and are converted to the per-record format when loaded.
+ */
+#define BLE_STORE_CONFIG_REC_ENCODE_SZ      \
+    (BASE64_ENCODE_SIZE(sizeof (union ble_store_value)) + 1)
+
+#define BLE_STORE_CONFIG_NAME_MAX_LEN       32
+
+#define BLE_STORE_CONFIG_MAP_WORDS(n)       (((n) + 31) / 32)
+
+#define BLE_STORE_CONFIG_SET_OUR_SEC        0
+#define BLE_STORE_CONFIG_SET_PEER_SEC       1
+#define BLE_STORE_CONFIG_SET_CCCD           2
+#define BLE_STORE_CONFIG_SET_GATT_CACHE     3
+#define BLE_STORE_CONFIG_SET_CNT            4
 
-#define BLE_STORE_CONFIG_SEC_SET_ENCODE_SZ  \
-    (MYNEWT_VAL(BLE_STORE_MAX_BONDS) * BLE_STORE_CONFIG_SEC_ENCODE_SZ + 1)
+struct ble_store_config_set {
+    const char *name;
+    void *objs;
+    int obj_sz;
+    int *num_objs;
+    int max_objs;
 
-#define BLE_STORE_CONFIG_CCCD_ENCODE_SZ     \
-    BASE64_ENCODE_SIZE(sizeof (struct ble_store_value_cccd))
+    /** Records which differ from their persisted copy. */
+    uint32_t *dirty;
 
-#define BLE_STORE_CONFIG_CCCD_SET_ENCODE_SZ \
-    (MYNEWT_VAL(BLE_STORE_MAX_CCCDS) * BLE_STORE_CONFIG_CCCD_ENCODE_SZ + 1)
+    /** Records found while loading; only used until the next commit. */
+    uint32_t *present;
+
+    /** Set was loaded from a blob in the old format. */
+    uint8_t legacy;
+
+    /** Records of the set were seen since the last commit. */
+    uint8_t loaded;
+};
+
+static uint32_t ble_store_config_our_sec_dirty[
+    BLE_STORE_CONFIG_MAP_WORDS(MYNEWT_VAL(BLE_STORE_MAX_BONDS))];
+static uint32_t ble_store_config_our_sec_present[
+    BLE_STORE_CONFIG_MAP_WORDS(MYNEWT_VAL(BLE_STORE_MAX_BONDS))];
+static uint32_t ble_store_config_peer_sec_dirty[
+    BLE_STORE_CONFIG_MAP_WORDS(MYNEWT_VAL(BLE_STORE_MAX_BONDS))];
+static uint32_t ble_store_config_peer_sec_present[
+    BLE_STORE_CONFIG_MAP_WORDS(MYNEWT_VAL(BLE_STORE_MAX_BONDS))];
+static uint32_t ble_store_config_cccd_dirty[
+    BLE_STORE_CONFIG_MAP_WORDS(MYNEWT_VAL(BLE_STORE_MAX_CCCDS))];
+static uint32_t ble_store_config_cccd_present[
+    BLE_STORE_CONFIG_MAP_WORDS(MYNEWT_VAL(BLE_STORE_MAX_CCCDS))];
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+static uint32_t ble_store_config_gatt_cache_dirty[
+    BLE_STORE_CONFIG_MAP_WORDS(MYNEWT_VAL(BLE_STORE_MAX_GATT_CACHE))];
+static uint32_t ble_store_config_gatt_cache_present[
+    BLE_STORE_CONFIG_MAP_WORDS(MYNEWT_VAL(BLE_STORE_MAX_GATT_CACHE))];
+#endif
+
+static struct ble_store_config_set
+    ble_store_config_sets[BLE_STORE_CONFIG_SET_CNT] = {
+    [BLE_STORE_CONFIG_SET_OUR_SEC] = {
+        .name = "our_sec",
+        .objs = ble_store_config_our_secs,
+        .obj_sz = sizeof *ble_store_config_our_secs,
+        .num_objs = &ble_store_config_num_our_secs,
+        .max_objs = MYNEWT_VAL(BLE_STORE_MAX_BONDS),
+        .dirty = ble_store_config_our_sec_dirty,
+        .present = ble_store_config_our_sec_present,
+    },
+    [BLE_STORE_CONFIG_SET_PEER_SEC] = {
+        .name = "peer_sec",
+        .objs = ble_store_config_peer_secs,
+        .obj_sz = sizeof *ble_store_config_peer_secs,
+        .num_objs = &ble_store_config_num_peer_secs,
+        .max_objs = MYNEWT_VAL(BLE_STORE_MAX_BONDS),
+        .dirty = ble_store_config_peer_sec_dirty,
+        .present = ble_store_config_peer_sec_present,
+    },
+    [BLE_STORE_CONFIG_SET_CCCD] = {
+        .name = "cccd",
+        .objs = ble_store_config_cccds,
+        .obj_sz = sizeof *ble_store_config_cccds,
+        .num_objs = &ble_store_config_num_cccds,
+        .max_objs = MYNEWT_VAL(BLE_STORE_MAX_CCCDS),
+        .dirty = ble_store_config_cccd_dirty,
+        .present = ble_store_config_cccd_present,
+    },
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    [BLE_STORE_CONFIG_SET_GATT_CACHE] = {
+        .name = "gatt_cache",
+        .objs = ble_store_config_gatt_cache,
+        .obj_sz = sizeof *ble_store_config_gatt_cache,
+        .num_objs = &ble_store_config_num_gatt_cache,
+        .max_objs = MYNEWT_VAL(BLE_STORE_MAX_GATT_CACHE),
+        .dirty = ble_store_config_gatt_cache_dirty,
+        .present = ble_store_config_gatt_cache_present,
+    },
+#endif
+};
+
+/** Flushes dirty records which are not written through immediately. */
+static struct ble_npl_callout ble_store_config_flush_timer;
+
+/** Event queue the flush timer is bound to. */
+static struct ble_npl_eventq *ble_store_config_flush_evq;
+
+static int
+ble_store_config_map_test(const uint32_t *map, int idx)
+{
+    return (map[idx / 32] >> (idx % 32)) & 1;
+}
+
+static void
+ble_store_config_map_set(uint32_t *map, int idx)
+{
+    map[idx / 32] |= 1UL << (idx % 32);
+}
 
 static void
-ble_store_config_serialize_arr(const void *arr, int obj_sz, int num_objs,
-                               char *out_buf, int buf_sz)
+ble_store_config_map_clear(uint32_t *map, int idx)
 {
-    int arr_size;
+    map[idx / 32] &= ~(1UL << (idx % 32));
+}
 
-    arr_size = obj_sz * num_objs;
-    assert(arr_size <= buf_sz);
+static struct ble_store_config_set *
+ble_store_config_set_find(const char *name)
+{
+    struct ble_store_config_set *set;
+    int i;
+
+    for (i = 0; i < BLE_STORE_CONFIG_SET_CNT; i++) {
+        set = ble_store_config_sets + i;
+        if (set->name != NULL && strcmp(set->name, name) == 0) {
+            return set;
+        }
+    }
 
-    base64_encode(arr, arr_size, out_buf, 1);
+    return NULL;
 }
 
 static int
@@ -86,133 +206,343 @@ ble_store_config_deserialize_arr(const char *enc,
     return 0;
 }
 
+static int
+ble_store_config_deserialize_rec(const char *enc,
+                                 struct ble_store_config_set *set, int idx)
+{
+    uint8_t buf[sizeof (union ble_store_value) + 3];
+    int len;
+
+    if (strlen(enc) != BASE64_ENCODE_SIZE(set->obj_sz)) {
+        return OS_EINVAL;
+    }
+
+    len = base64_decode(enc, buf);
+    if (len != set->obj_sz) {
+        return OS_EINVAL;
+    }
+
+    memcpy((uint8_t *)set->objs + idx * set->obj_sz, buf, set->obj_sz);
+    return 0;
+}
+
 static int
 ble_store_config_conf_set(int argc, char **argv, char *val)
 {
+    struct ble_store_config_set *set;
+    char *endptr;
+    long idx;
     int rc;
+    int i;
+
+    if (argc < 1 || argc > 2) {
+        return OS_ENOENT;
+    }
+
+    set = ble_store_config_set_find(argv[0]);
+    if (set == NULL) {
+        return OS_ENOENT;
+    }
+
+    set->loaded = 1;
+
+    /* Deleted settings are reported with an empty value. */
+    if (val == NULL || val[0] == '\0') {
+        if (argc == 2) {
+            idx = strtol(argv[1], &endptr, 10);
+            if (*endptr == '\0' && idx >= 0 && idx < set->max_objs) {
+                ble_store_config_map_clear(set->present, idx);
+            }
+        }
+        return 0;
+    }
 
     if (argc == 1) {
-        if (strcmp(argv[0], "our_sec") == 0) {
-            rc = ble_store_config_deserialize_arr(
-                    val,
-                    ble_store_config_our_secs,
-                    sizeof *ble_store_config_our_secs,
-                    &ble_store_config_num_our_secs);
-            return rc;
-        } else if (strcmp(argv[0], "peer_sec") == 0) {
-            rc = ble_store_config_deserialize_arr(
-                    val,
-                    ble_store_config_peer_secs,
-                    sizeof *ble_store_config_peer_secs,
-                    &ble_store_config_num_peer_secs);
-            return rc;
-        } else if (strcmp(argv[0], "cccd") == 0) {
-            rc = ble_store_config_deserialize_arr(
-                    val,
-                    ble_store_config_cccds,
-                    sizeof *ble_store_config_cccds,
-                    &ble_store_config_num_cccds);
+        /* Old format; the whole set in one blob. */
+        if (base64_decode_len(val) > set->obj_sz * set->max_objs) {
+            return OS_EINVAL;
+        }
+
+        rc = ble_store_config_deserialize_arr(val, set->objs, set->obj_sz,
+                                              set->num_objs);
+        if (rc != 0) {
             return rc;
         }
+
+        for (i = 0; i < *set->num_objs; i++) {
+            ble_store_config_map_set(set->present, i);
+        }
+        set->legacy = 1;
+        return 0;
     }
-    return OS_ENOENT;
+
+    idx = strtol(argv[1], &endptr, 10);
+    if (*endptr != '\0' || idx < 0 || idx >= set->max_objs) {
+        return OS_EINVAL;
+    }
+
+    rc = ble_store_config_deserialize_rec(val, set, idx);
+    if (rc != 0) {
+        return rc;
+    }
+
+    ble_store_config_map_set(set->present, idx);
+    return 0;
 }
 
 static int
-ble_store_config_conf_export(void (*func)(char *name, char *val),
-                             enum conf_export_tgt tgt)
+ble_store_config_flush_set(struct ble_store_config_set *set)
 {
-    union {
-        char sec[BLE_STORE_CONFIG_SEC_SET_ENCODE_SZ];
-        char cccd[BLE_STORE_CONFIG_CCCD_SET_ENCODE_SZ];
-    } buf;
-
-    ble_store_config_serialize_arr(ble_store_config_our_secs,
-                                   sizeof *ble_store_config_our_secs,
-                                   ble_store_config_num_our_secs,
-                                   buf.sec,
-                                   sizeof buf.sec);
-    func("ble_hs/our_sec", buf.sec);
-
-    ble_store_config_serialize_arr(ble_store_config_peer_secs,
-                                   sizeof *ble_store_config_peer_secs,
-                                   ble_store_config_num_peer_secs,
-                                   buf.sec,
-                                   sizeof buf.sec);
-    func("ble_hs/peer_sec", buf.sec);
-
-    ble_store_config_serialize_arr(ble_store_config_cccds,
-                                   sizeof *ble_store_config_cccds,
-                                   ble_store_config_num_cccds,
-                                   buf.cccd,
-                                   sizeof buf.cccd);
-    func("ble_hs/cccd", buf.cccd);
+    char name[BLE_STORE_CONFIG_NAME_MAX_LEN];
+    char buf[BLE_STORE_CONFIG_REC_ENCODE_SZ];
+    int rc;
+    int i;
+
+    for (i = 0; i < set->max_objs; i++) {
+        if (!ble_store_config_map_test(set->dirty, i)) {
+            continue;
+        }
+
+        snprintf(name, sizeof name, "ble_hs/%s/%d", set->name, i);
+        if (i < *set->num_objs) {
+            base64_encode((uint8_t *)set->objs + i * set->obj_sz,
+                          set->obj_sz, buf, 1);
+            rc = conf_save_one(name, buf);
+        } else {
+            rc = conf_save_one(name, NULL);
+        }
+        if (rc != 0) {
+            return BLE_HS_ESTORE_FAIL;
+        }
+
+        ble_store_config_map_clear(set->dirty, i);
+    }
 
     return 0;
 }
 
-static int
-ble_store_config_persist_sec_set(const char *setting_name,
-                                 const struct ble_store_value_sec *secs,
-                                 int num_secs)
+int
+ble_store_config_conf_flush(void)
 {
-    char buf[BLE_STORE_CONFIG_SEC_SET_ENCODE_SZ];
     int rc;
+    int i;
 
-    ble_store_config_serialize_arr(secs, sizeof *secs, num_secs,
-                                   buf, sizeof buf);
-    rc = conf_save_one(setting_name, buf);
-    if (rc != 0) {
-        return BLE_HS_ESTORE_FAIL;
+    for (i = 0; i < BLE_STORE_CONFIG_SET_CNT; i++) {
+        if (ble_store_config_sets[i].name == NULL) {
+            continue;
+        }
+
+        rc = ble_store_config_flush_set(ble_store_config_sets + i);
+        if (rc != 0) {
+            return rc;
+        }
     }
 
     return 0;
 }
 
-int
-ble_store_config_persist_our_secs(void)
+static void ble_store_config_flush_timer_exp(struct ble_npl_event *ev);
+
+/**
+ * Arms the flush timer on the host event queue, so that flushes never race
+ * with the host changing the store.  The queue is looked up each time since
+ * the application may move the host to another task after initialization.
+ */
+static void
+ble_store_config_flush_sched(void)
+{
+    struct ble_npl_eventq *evq;
+
+    evq = ble_hs_evq_get();
+    if (evq != ble_store_config_flush_evq) {
+        ble_npl_callout_init(&ble_store_config_flush_timer, evq,
+                             ble_store_config_flush_timer_exp, NULL);
+        ble_store_config_flush_evq = evq;
+    }
+
+    ble_npl_callout_reset(&ble_store_config_flush_timer,
+        ble_npl_time_ms_to_ticks32(
+            MYNEWT_VAL(BLE_STORE_CONFIG_FLUSH_DELAY_MS)));
+}
+
+static void
+ble_store_config_flush_timer_exp(struct ble_npl_event *ev)
 {
     int rc;
 
-    rc = ble_store_config_persist_sec_set("ble_hs/our_sec",
-                                          ble_store_config_our_secs,
-                                          ble_store_config_num_our_secs);
+    rc = ble_store_config_conf_flush();
     if (rc != 0) {
-        return rc;
+        /* Try again later; the records remain marked as dirty. */
+        ble_store_config_flush_sched();
+    }
+}
+
+/**
+ * Marks a range of records as dirty and schedules them to be saved.  Indices
+ * beyond the end of the set are removed from persistent storage.
+ */
+static int
+ble_store_config_persist_set(int set_idx, int first_idx, int last_idx,
+                             int write_through)
+{
+    struct ble_store_config_set *set;
+    int i;
+
+    set = ble_store_config_sets + set_idx;
+    for (i = first_idx; i <= last_idx && i < set->max_objs; i++) {
+        ble_store_config_map_set(set->dirty, i);
+    }
+
+    if (write_through || MYNEWT_VAL(BLE_STORE_CONFIG_FLUSH_DELAY_MS) == 0) {
+        return ble_store_config_conf_flush();
+    }
+
+    /* Don't push back a pending flush; this bounds the time a change can
+     * remain unsaved.
+     */
+    if (ble_store_config_flush_evq == NULL ||
+        !ble_npl_callout_is_active(&ble_store_config_flush_timer)) {
+        ble_store_config_flush_sched();
     }
 
     return 0;
 }
 
+/**
+ * Bonding keys are written through immediately; losing them on a reset would
+ * leave the peer with keys we no longer know about.
+ */
 int
-ble_store_config_persist_peer_secs(void)
+ble_store_config_persist_our_secs(int first_idx, int last_idx)
 {
+    return ble_store_config_persist_set(BLE_STORE_CONFIG_SET_OUR_SEC,
+                                        first_idx, last_idx, 1);
+}
+
+int
+ble_store_config_persist_peer_secs(int first_idx, int last_idx)
+{
+    return ble_store_config_persist_set(BLE_STORE_CONFIG_SET_PEER_SEC,
+                                        first_idx, last_idx, 1);
+}
+
+int
+ble_store_config_persist_cccds(int first_idx, int last_idx)
+{
+    return ble_store_config_persist_set(BLE_STORE_CONFIG_SET_CCCD,
+                                        first_idx, last_idx, 0);
+}
+
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+int
+ble_store_config_persist_gatt_cache(int first_idx, int last_idx)
+{
+    return ble_store_config_persist_set(BLE_STORE_CONFIG_SET_GATT_CACHE,
+                                        first_idx, last_idx, 0);
+}
+#endif
+
+/**
+ * Packs the records found while loading to the front of each set.  Gaps are
+ * only left behind if a flush was interrupted.  Sets which weren't loaded
+ * since the last commit are left alone; their records are already packed.
+ */
+static void
+ble_store_config_compact_set(struct ble_store_config_set *set)
+{
+    uint8_t *objs;
+    int num;
+    int i;
+
+    if (!set->loaded) {
+        return;
+    }
+    set->loaded = 0;
+
+    objs = set->objs;
+    num = 0;
+    for (i = 0; i < set->max_objs; i++) {
+        if (!ble_store_config_map_test(set->present, i)) {
+            continue;
+        }
+
+        if (i != num) {
+            memcpy(objs + num * set->obj_sz, objs + i * set->obj_sz,
+                   set->obj_sz);
+            ble_store_config_map_set(set->dirty, num);
+            ble_store_config_map_set(set->dirty, i);
+        }
+        num++;
+    }
+    *set->num_objs = num;
+
+    memset(set->present, 0,
+           BLE_STORE_CONFIG_MAP_WORDS(set->max_objs) * sizeof (uint32_t));
+
+    /* Rewrite a set loaded from the old format in the new one. */
+    if (set->legacy) {
+        for (i = 0; i < set->max_objs; i++) {
+            ble_store_config_map_set(set->dirty, i);
+        }
+    }
+}
+
+static int
+ble_store_config_conf_commit(void)
+{
+    char name[BLE_STORE_CONFIG_NAME_MAX_LEN];
+    struct ble_store_config_set *set;
     int rc;
+    int i;
+
+    for (i = 0; i < BLE_STORE_CONFIG_SET_CNT; i++) {
+        if (ble_store_config_sets[i].name != NULL) {
+            ble_store_config_compact_set(ble_store_config_sets + i);
+        }
+    }
 
-    rc = ble_store_config_persist_sec_set("ble_hs/peer_sec",
-                                          ble_store_config_peer_secs,
-                                          ble_store_config_num_peer_secs);
+    ble_store_config_idx_build();
+
+    rc = ble_store_config_conf_flush();
     if (rc != 0) {
         return rc;
     }
 
+    /* The records are safely saved; drop the old blobs. */
+    for (i = 0; i < BLE_STORE_CONFIG_SET_CNT; i++) {
+        set = ble_store_config_sets + i;
+        if (set->legacy) {
+            snprintf(name, sizeof name, "ble_hs/%s", set->name);
+            conf_save_one(name, NULL);
+            set->legacy = 0;
+        }
+    }
+
     return 0;
 }
 
-int
-ble_store_config_persist_cccds(void)
+static int
+ble_store_config_conf_export(void (*func)(char *name, char *val),
+                             enum conf_export_tgt tgt)
 {
-    char buf[BLE_STORE_CONFIG_CCCD_SET_ENCODE_SZ];
-    int rc;
+    char name[BLE_STORE_CONFIG_NAME_MAX_LEN];
+    char buf[BLE_STORE_CONFIG_REC_ENCODE_SZ];
+    struct ble_store_config_set *set;
+    int i;
+    int j;
+
+    for (i = 0; i < BLE_STORE_CONFIG_SET_CNT; i++) {
+        set = ble_store_config_sets + i;
+        if (set->name == NULL) {
+            continue;
+        }
 
-    ble_store_config_serialize_arr(ble_store_config_cccds,
-                                   sizeof *ble_store_config_cccds,
-                                   ble_store_config_num_cccds,
-                                   buf,
-                                   sizeof buf);
-    rc = conf_save_one("ble_hs/cccd", buf);
-    if (rc != 0) {
-        return BLE_HS_ESTORE_FAIL;
+        for (j = 0; j < *set->num_objs; j++) {
+            snprintf(name, sizeof name, "ble_hs/%s/%d", set->name, j);
+            base64_encode((uint8_t *)set->objs + j * set->obj_sz,
+                          set->obj_sz, buf, 1);
+            func(name, buf);
+        }
     }
 
     return 0;
@@ -223,6 +553,19 @@ ble_store_config_conf_init(void)
 {
     int rc;
 
+    memset(ble_store_config_our_sec_dirty, 0,
+           sizeof ble_store_config_our_sec_dirty);
+    memset(ble_store_config_peer_sec_dirty, 0,
+           sizeof ble_store_config_peer_sec_dirty);
+    memset(ble_store_config_cccd_dirty, 0,
+           sizeof ble_store_config_cccd_dirty);
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    memset(ble_store_config_gatt_cache_dirty, 0,
+           sizeof ble_store_config_gatt_cache_dirty);
+#endif
+
+    ble_store_config_flush_evq = NULL;
+
     rc = conf_register(&ble_store_config_conf_handler);
     SYSINIT_PANIC_ASSERT_MSG(rc == 0,
                              "Failed to register ble_store_config conf");
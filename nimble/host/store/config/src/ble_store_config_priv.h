@@ -36,18 +36,50 @@ extern struct ble_store_value_cccd
     ble_store_config_cccds[MYNEWT_VAL(BLE_STORE_MAX_CCCDS)];
 extern int ble_store_config_num_cccds;
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+extern struct ble_store_value_gatt_cache
+    ble_store_config_gatt_cache[MYNEWT_VAL(BLE_STORE_MAX_GATT_CACHE)];
+extern int ble_store_config_num_gatt_cache;
+#endif
+
+void ble_store_config_idx_build(void);
+
 #if MYNEWT_VAL(BLE_STORE_CONFIG_PERSIST)
 
-int ble_store_config_persist_our_secs(void);
-int ble_store_config_persist_peer_secs(void);
-int ble_store_config_persist_cccds(void);
+int ble_store_config_persist_our_secs(int first_idx, int last_idx);
+int ble_store_config_persist_peer_secs(int first_idx, int last_idx);
+int ble_store_config_persist_cccds(int first_idx, int last_idx);
+int ble_store_config_persist_gatt_cache(int first_idx, int last_idx);
+int ble_store_config_conf_flush(void);
 void ble_store_config_conf_init(void);
 
 #else
 
-static inline int ble_store_config_persist_our_secs(void)   { return 0; }
-static inline int ble_store_config_persist_peer_secs(void)  { return 0; }
-static inline int ble_store_config_persist_cccds(void)      { return 0; }
+static inline int
+ble_store_config_persist_our_secs(int first_idx, int last_idx)
+{
+    return 0;
+}
+
+static inline int
+ble_store_config_persist_peer_secs(int first_idx, int last_idx)
+{
+    return 0;
+}
+
+static inline int
+ble_store_config_persist_cccds(int first_idx, int last_idx)
+{
+    return 0;
+}
+
+static inline int
+ble_store_config_persist_gatt_cache(int first_idx, int last_idx)
+{
+    return 0;
+}
+
+static inline int ble_store_config_conf_flush(void)         { return 0; }
 static inline void ble_store_config_conf_init(void)         { }
 
 #endif /* MYNEWT_VAL(BLE_STORE_CONFIG_PERSIST) */
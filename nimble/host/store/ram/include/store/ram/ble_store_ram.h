@@ -31,6 +31,8 @@ int ble_store_ram_read(int obj_type, const union ble_store_key *key,
                        union ble_store_value *value);
 int ble_store_ram_write(int obj_type, const union ble_store_value *val);
 int ble_store_ram_delete(int obj_type, const union ble_store_key *key);
+int ble_store_ram_read_next(int obj_type, const union ble_store_key *key,
+                            int *cursor, union ble_store_value *value);
 
 #ifdef __cplusplus
 }
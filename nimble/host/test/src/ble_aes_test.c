@@ -0,0 +1,229 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include "testutil/testutil.h"
+#include "nimble/ble.h"
+#include "nimble/ble_aes.h"
+#include "host/ble_hs_test.h"
+#include "ble_hs_test_util.h"
+
+/* SP 800-38B, appendix D.1. */
+static const uint8_t ble_aes_test_cmac_key[16] = {
+    0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+    0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c,
+};
+
+static const uint8_t ble_aes_test_cmac_msg[64] = {
+    0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96,
+    0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+    0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c,
+    0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+    0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11,
+    0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+    0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17,
+    0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10,
+};
+
+static const struct {
+    int len;
+    uint8_t mac[16];
+} ble_aes_test_cmac_vectors[] = {
+    { 0, { 0xbb, 0x1d, 0x69, 0x29, 0xe9, 0x59, 0x37, 0x28,
+           0x7f, 0xa3, 0x7d, 0x12, 0x9b, 0x75, 0x67, 0x46 } },
+    { 16, { 0x07, 0x0a, 0x16, 0xb4, 0x6b, 0x4d, 0x41, 0x44,
+            0xf7, 0x9b, 0xdd, 0x9d, 0xd0, 0x4a, 0x28, 0x7c } },
+    { 40, { 0xdf, 0xa6, 0x67, 0x47, 0xde, 0x9a, 0xe6, 0x30,
+            0x30, 0xca, 0x32, 0x61, 0x14, 0x97, 0xc8, 0x27 } },
+    { 64, { 0x51, 0xf0, 0xbe, 0xbf, 0x7e, 0x3b, 0x9d, 0x92,
+            0xfc, 0x49, 0x74, 0x17, 0x79, 0x36, 0x3c, 0xfe } },
+};
+
+#define BLE_AES_TEST_CMAC_VECTOR_CNT \
+    (sizeof ble_aes_test_cmac_vectors / sizeof ble_aes_test_cmac_vectors[0])
+
+static void
+ble_aes_test_fill(uint8_t *buf, int len, uint32_t *seed)
+{
+    int i;
+
+    for (i = 0; i < len; i++) {
+        *seed = *seed * 1103515245 + 12345;
+        buf[i] = *seed >> 16;
+    }
+}
+
+/**
+ * Selects the specified backend, or returns 0 if it is not available in this
+ * build.
+ */
+static int
+ble_aes_test_select(int backend)
+{
+    if (ble_aes_backend_name(backend) == NULL) {
+        return 0;
+    }
+
+    TEST_ASSERT_FATAL(ble_aes_backend_select(backend) == 0);
+    TEST_ASSERT_FATAL(ble_aes_backend() == backend);
+
+    return 1;
+}
+
+TEST_CASE(ble_aes_test_case_fips197)
+{
+    /* FIPS-197, appendix C.1. */
+    static const uint8_t key[16] = {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+        0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+    };
+    static const uint8_t pt[16] = {
+        0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+        0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff,
+    };
+    static const uint8_t ct[16] = {
+        0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30,
+        0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a,
+    };
+    struct ble_aes_key sched;
+    uint8_t out[16];
+    int backend;
+    int prev;
+
+    prev = ble_aes_backend();
+
+    for (backend = 0; backend < BLE_AES_BACKEND_CNT; backend++) {
+        if (!ble_aes_test_select(backend)) {
+            continue;
+        }
+
+        ble_aes_set_key(&sched, key);
+        ble_aes_encrypt(&sched, pt, out);
+        TEST_ASSERT(memcmp(out, ct, 16) == 0);
+
+        memset(out, 0, sizeof out);
+        ble_aes_encrypt_block(key, pt, out);
+        TEST_ASSERT(memcmp(out, ct, 16) == 0);
+    }
+
+    TEST_ASSERT(ble_aes_backend_select(prev) == 0);
+}
+
+TEST_CASE(ble_aes_test_case_cmac)
+{
+    struct ble_aes_cmac_key key;
+    struct ble_aes_cmac cmac;
+    uint8_t mac[16];
+    int backend;
+    int prev;
+    int len;
+    int i;
+    int j;
+
+    prev = ble_aes_backend();
+
+    for (backend = 0; backend < BLE_AES_BACKEND_CNT; backend++) {
+        if (!ble_aes_test_select(backend)) {
+            continue;
+        }
+
+        ble_aes_cmac_set_key(&key, ble_aes_test_cmac_key);
+
+        for (i = 0; i < BLE_AES_TEST_CMAC_VECTOR_CNT; i++) {
+            len = ble_aes_test_cmac_vectors[i].len;
+
+            ble_aes_cmac(ble_aes_test_cmac_key, ble_aes_test_cmac_msg, len,
+                         mac);
+            TEST_ASSERT(memcmp(mac, ble_aes_test_cmac_vectors[i].mac,
+                               16) == 0);
+
+            /* Feed the message in uneven pieces. */
+            ble_aes_cmac_init(&cmac, &key);
+            for (j = 0; j < len; j += 7) {
+                ble_aes_cmac_update(&cmac, ble_aes_test_cmac_msg + j,
+                                    min(7, len - j));
+            }
+            ble_aes_cmac_final(&cmac, mac);
+            TEST_ASSERT(memcmp(mac, ble_aes_test_cmac_vectors[i].mac,
+                               16) == 0);
+        }
+    }
+
+    TEST_ASSERT(ble_aes_backend_select(prev) == 0);
+}
+
+TEST_CASE(ble_aes_test_case_cross)
+{
+    uint8_t expected[16];
+    uint8_t key[16];
+    uint8_t in[16];
+    uint8_t out[16];
+    uint8_t msg[53];
+    uint32_t seed;
+    int backend;
+    int prev;
+    int i;
+
+    prev = ble_aes_backend();
+
+    /* Every backend must agree with the reference implementation. */
+    for (backend = 1; backend < BLE_AES_BACKEND_CNT; backend++) {
+        if (ble_aes_backend_name(backend) == NULL) {
+            continue;
+        }
+
+        seed = 1;
+        for (i = 0; i < 100; i++) {
+            ble_aes_test_fill(key, sizeof key, &seed);
+            ble_aes_test_fill(in, sizeof in, &seed);
+            ble_aes_test_fill(msg, sizeof msg, &seed);
+
+            TEST_ASSERT_FATAL(
+                ble_aes_test_select(BLE_AES_BACKEND_TINYCRYPT));
+            ble_aes_encrypt_block(key, in, expected);
+            TEST_ASSERT_FATAL(ble_aes_test_select(backend));
+            ble_aes_encrypt_block(key, in, out);
+            TEST_ASSERT(memcmp(out, expected, 16) == 0);
+
+            TEST_ASSERT_FATAL(
+                ble_aes_test_select(BLE_AES_BACKEND_TINYCRYPT));
+            ble_aes_cmac(key, msg, i % sizeof msg, expected);
+            TEST_ASSERT_FATAL(ble_aes_test_select(backend));
+            ble_aes_cmac(key, msg, i % sizeof msg, out);
+            TEST_ASSERT(memcmp(out, expected, 16) == 0);
+        }
+    }
+
+    TEST_ASSERT(ble_aes_backend_select(prev) == 0);
+}
+
+TEST_SUITE(ble_aes_test_suite)
+{
+    ble_aes_test_case_fips197();
+    ble_aes_test_case_cmac();
+    ble_aes_test_case_cross();
+}
+
+int
+ble_aes_test_all(void)
+{
+    ble_aes_test_suite();
+
+    return tu_any_failed;
+}
@@ -0,0 +1,266 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include <errno.h>
+#include "testutil/testutil.h"
+#include "nimble/ble.h"
+#include "host/ble_hs_test.h"
+#include "ble_hs_test_util.h"
+
+#if MYNEWT_VAL(BLE_EATT_CHAN_NUM) > 0
+
+#define BLE_EATT_TEST_PEER_CID      0x0040
+
+static const uint8_t ble_eatt_test_peer_addr[6] = {2,3,4,5,6,7};
+
+/** Source CID of our end of the bearer, as reported in the connect rsp. */
+static uint16_t ble_eatt_test_cid;
+
+static int ble_eatt_test_read_status;
+static uint8_t ble_eatt_test_read_data[8];
+static int ble_eatt_test_read_len;
+
+static void
+ble_eatt_test_init(int encrypted)
+{
+    struct ble_hs_conn *conn;
+
+    ble_hs_test_util_init();
+
+    ble_hs_test_util_create_conn(2, ble_eatt_test_peer_addr, NULL, NULL);
+
+    ble_hs_lock();
+    conn = ble_hs_conn_find(2);
+    TEST_ASSERT_FATAL(conn != NULL);
+    conn->bhc_sec_state.encrypted = encrypted;
+    ble_hs_unlock();
+}
+
+/**
+ * Receives a bearer connect request from the peer and returns the result
+ * code of our response.
+ */
+static uint16_t
+ble_eatt_test_rx_connect_req(void)
+{
+    struct ble_l2cap_sig_le_con_req req = {};
+    struct ble_l2cap_sig_le_con_rsp *rsp;
+    struct os_mbuf *om;
+    int rc;
+
+    req.psm = htole16(BLE_EATT_PSM);
+    req.scid = htole16(BLE_EATT_TEST_PEER_CID);
+    req.mtu = htole16(MYNEWT_VAL(BLE_EATT_MTU));
+    req.mps = htole16(BLE_L2CAP_COC_MTU);
+    req.credits = htole16(10);
+
+    rc = ble_hs_test_util_inject_rx_l2cap_sig(
+        2, BLE_L2CAP_SIG_OP_CREDIT_CONNECT_REQ, 10, &req, sizeof req);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    om = ble_hs_test_util_prev_tx_dequeue_pullup();
+    TEST_ASSERT_FATAL(om != NULL);
+    TEST_ASSERT_FATAL(OS_MBUF_PKTLEN(om) ==
+                      BLE_L2CAP_SIG_HDR_SZ + sizeof *rsp);
+    TEST_ASSERT(om->om_data[0] == BLE_L2CAP_SIG_OP_CREDIT_CONNECT_RSP);
+    TEST_ASSERT(om->om_data[1] == 10);
+
+    rsp = (void *)(om->om_data + BLE_L2CAP_SIG_HDR_SZ);
+    ble_eatt_test_cid = le16toh(rsp->dcid);
+
+    return le16toh(rsp->result);
+}
+
+/**
+ * Receives an ATT PDU from the peer over the enhanced bearer.
+ */
+static void
+ble_eatt_test_rx_att(const void *pdu, uint16_t len)
+{
+    struct os_mbuf *om;
+    uint8_t sdu_len[2];
+    int rc;
+
+    om = ble_hs_mbuf_l2cap_pkt();
+    TEST_ASSERT_FATAL(om != NULL);
+
+    put_le16(sdu_len, len);
+    rc = os_mbuf_append(om, sdu_len, sizeof sdu_len);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_mbuf_append(om, pdu, len);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    ble_hs_test_util_inject_rx_l2cap(2, ble_eatt_test_cid, om);
+}
+
+/**
+ * Verifies that the specified ATT PDU was sent over the enhanced bearer,
+ * i.e., as a single SDU prefixed with its length.
+ */
+static void
+ble_eatt_test_verify_tx_att(const void *pdu, uint16_t len)
+{
+    struct os_mbuf *om;
+
+    om = ble_hs_test_util_prev_tx_dequeue_pullup();
+    TEST_ASSERT_FATAL(om != NULL);
+
+    TEST_ASSERT_FATAL(OS_MBUF_PKTLEN(om) == 2 + len);
+    TEST_ASSERT(get_le16(om->om_data) == len);
+    TEST_ASSERT(memcmp(om->om_data + 2, pdu, len) == 0);
+}
+
+static int
+ble_eatt_test_read_cb(uint16_t conn_handle, const struct ble_gatt_error *error,
+                      struct ble_gatt_attr *attr, void *arg)
+{
+    ble_eatt_test_read_status = error->status;
+    if (error->status == 0) {
+        ble_eatt_test_read_len = OS_MBUF_PKTLEN(attr->om);
+        TEST_ASSERT_FATAL(ble_eatt_test_read_len <=
+                          sizeof ble_eatt_test_read_data);
+        os_mbuf_copydata(attr->om, 0, ble_eatt_test_read_len,
+                         ble_eatt_test_read_data);
+    }
+
+    return 0;
+}
+
+TEST_CASE(ble_eatt_test_case_accept_unencrypted)
+{
+    uint16_t result;
+
+    ble_eatt_test_init(0);
+
+    result = ble_eatt_test_rx_connect_req();
+    TEST_ASSERT(result == BLE_L2CAP_COC_ERR_INSUFFICIENT_ENC);
+}
+
+TEST_CASE(ble_eatt_test_case_svr_rsp)
+{
+    static const uint8_t req[] = { BLE_ATT_OP_READ_REQ, 0x34, 0x12 };
+    static const uint8_t rsp[] = {
+        BLE_ATT_OP_ERROR_RSP, BLE_ATT_OP_READ_REQ, 0x34, 0x12,
+        BLE_ATT_ERR_INVALID_HANDLE,
+    };
+    uint16_t result;
+
+    ble_eatt_test_init(1);
+
+    result = ble_eatt_test_rx_connect_req();
+    TEST_ASSERT_FATAL(result == BLE_L2CAP_COC_ERR_CONNECTION_SUCCESS);
+
+    /* The response goes out over the bearer the request came in on. */
+    ble_eatt_test_rx_att(req, sizeof req);
+    ble_eatt_test_verify_tx_att(rsp, sizeof rsp);
+
+    ble_hs_test_util_conn_disconnect(2);
+}
+
+TEST_CASE(ble_eatt_test_case_clt_read)
+{
+    static const uint8_t req[] = { BLE_ATT_OP_READ_REQ, 0x34, 0x12 };
+    static const uint8_t rsp[] = { BLE_ATT_OP_READ_RSP, 1, 2, 3 };
+    uint16_t result;
+    int rc;
+
+    ble_eatt_test_init(1);
+
+    result = ble_eatt_test_rx_connect_req();
+    TEST_ASSERT_FATAL(result == BLE_L2CAP_COC_ERR_CONNECTION_SUCCESS);
+
+    /* The idle enhanced bearer is preferred over the unenhanced one. */
+    ble_eatt_test_read_status = -1;
+    rc = ble_gattc_read(2, 0x1234, ble_eatt_test_read_cb, NULL);
+    TEST_ASSERT_FATAL(rc == 0);
+    ble_eatt_test_verify_tx_att(req, sizeof req);
+
+    /* A response on the unenhanced bearer does not match the procedure. */
+    ble_hs_test_util_l2cap_rx_payload_flat(2, BLE_L2CAP_CID_ATT, rsp,
+                                           sizeof rsp);
+    TEST_ASSERT(ble_eatt_test_read_status == -1);
+
+    ble_eatt_test_rx_att(rsp, sizeof rsp);
+    TEST_ASSERT(ble_eatt_test_read_status == 0);
+    TEST_ASSERT(ble_eatt_test_read_len == 3);
+    TEST_ASSERT(memcmp(ble_eatt_test_read_data, rsp + 1, 3) == 0);
+
+    ble_hs_test_util_conn_disconnect(2);
+}
+
+TEST_CASE(ble_eatt_test_case_connect_srv_sup_feat)
+{
+    static const uint8_t req[] = {
+        BLE_ATT_OP_READ_TYPE_REQ, 0x01, 0x00, 0xff, 0xff, 0x3a, 0x2b,
+    };
+    uint8_t rsp[] = { BLE_ATT_OP_READ_TYPE_RSP, 3, 0x20, 0x00, 0x00 };
+    struct os_mbuf *om;
+
+    ble_eatt_test_init(1);
+
+    /* The central reads the Server Supported Features of the peer. */
+    ble_hs_test_util_prev_tx_queue_clear();
+    ble_eatt_connect(2);
+    om = ble_hs_test_util_prev_tx_dequeue_pullup();
+    TEST_ASSERT_FATAL(om != NULL);
+    TEST_ASSERT(OS_MBUF_PKTLEN(om) == sizeof req);
+    TEST_ASSERT(memcmp(om->om_data, req, sizeof req) == 0);
+
+    /* No bearer is opened to a peer without EATT support. */
+    ble_hs_test_util_l2cap_rx_payload_flat(2, BLE_L2CAP_CID_ATT, rsp,
+                                           sizeof rsp);
+    TEST_ASSERT(ble_hs_test_util_prev_tx_dequeue_pullup() == NULL);
+
+    ble_eatt_connect(2);
+    om = ble_hs_test_util_prev_tx_dequeue_pullup();
+    TEST_ASSERT_FATAL(om != NULL);
+    TEST_ASSERT(memcmp(om->om_data, req, sizeof req) == 0);
+
+    rsp[4] = BLE_GATT_SRV_SUP_FEAT_EATT;
+    ble_hs_test_util_l2cap_rx_payload_flat(2, BLE_L2CAP_CID_ATT, rsp,
+                                           sizeof rsp);
+    om = ble_hs_test_util_prev_tx_dequeue_pullup();
+    TEST_ASSERT_FATAL(om != NULL);
+    TEST_ASSERT(om->om_data[0] == BLE_L2CAP_SIG_OP_CREDIT_CONNECT_REQ);
+
+    ble_hs_test_util_conn_disconnect(2);
+}
+
+TEST_SUITE(ble_eatt_test_suite)
+{
+    tu_suite_set_post_test_cb(ble_hs_test_util_post_test, NULL);
+
+    ble_eatt_test_case_accept_unencrypted();
+    ble_eatt_test_case_svr_rsp();
+    ble_eatt_test_case_clt_read();
+    ble_eatt_test_case_connect_srv_sup_feat();
+}
+
+#endif
+
+int
+ble_eatt_test_all(void)
+{
+#if MYNEWT_VAL(BLE_EATT_CHAN_NUM) > 0
+    ble_eatt_test_suite();
+#endif
+
+    return tu_any_failed;
+}
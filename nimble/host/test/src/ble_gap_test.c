@@ -22,6 +22,7 @@
 #include "testutil/testutil.h"
 #include "nimble/ble.h"
 #include "nimble/hci_common.h"
+#include "nimble/ble_hci_trans.h"
 #include "host/ble_hs_adv.h"
 #include "host/ble_hs_test.h"
 #include "ble_hs_test_util.h"
@@ -161,6 +162,23 @@ ble_gap_test_util_verify_tx_clear_wl(void)
     TEST_ASSERT(param_len == 0);
 }
 
+static void
+ble_gap_test_util_verify_tx_rmv_wl(ble_addr_t *addr)
+{
+    uint8_t param_len;
+    uint8_t *param;
+    int i;
+
+    param = ble_hs_test_util_hci_verify_tx(BLE_HCI_OGF_LE,
+                                           BLE_HCI_OCF_LE_RMV_WHITE_LIST,
+                                           &param_len);
+    TEST_ASSERT(param_len == 7);
+    TEST_ASSERT(param[0] == addr->type);
+    for (i = 0; i < 6; i++) {
+        TEST_ASSERT(param[1 + i] == addr->val[i]);
+    }
+}
+
 static void
 ble_gap_test_util_verify_tx_add_wl(ble_addr_t *addr)
 {
@@ -496,6 +514,74 @@ TEST_CASE(ble_gap_test_case_wl_good)
     ble_gap_test_util_wl_set(addrs, addrs_count, 0, 0);
 }
 
+TEST_CASE(ble_gap_test_case_wl_update)
+{
+    ble_addr_t addrs[] = {
+        { BLE_ADDR_PUBLIC, { 1, 2, 3, 4, 5, 6 } },
+        { BLE_ADDR_PUBLIC, { 2, 3, 4, 5, 6, 7 } },
+        { BLE_ADDR_PUBLIC, { 3, 4, 5, 6, 7, 8 } },
+        { BLE_ADDR_PUBLIC, { 4, 5, 6, 7, 8, 9 } },
+    };
+    ble_addr_t new_addrs[] = {
+        { BLE_ADDR_PUBLIC, { 3, 4, 5, 6, 7, 8 } },
+        { BLE_ADDR_RANDOM, { 5, 6, 7, 8, 9, 10 } },
+        { BLE_ADDR_PUBLIC, { 1, 2, 3, 4, 5, 6 } },
+    };
+    int addrs_count = sizeof addrs / sizeof addrs[0];
+    int new_addrs_count = sizeof new_addrs / sizeof new_addrs[0];
+    int rc;
+
+    ble_gap_test_util_wl_set(addrs, addrs_count, 0, 0);
+    ble_hs_test_util_hci_out_clear();
+
+    /*** Only the differences get sent to the controller. */
+    ble_hs_test_util_hci_ack_set_seq(((struct ble_hs_test_util_hci_ack[]) {
+        { BLE_HS_TEST_UTIL_LE_OPCODE(BLE_HCI_OCF_LE_RMV_WHITE_LIST), 0 },
+        { BLE_HS_TEST_UTIL_LE_OPCODE(BLE_HCI_OCF_LE_RMV_WHITE_LIST), 0 },
+        { BLE_HS_TEST_UTIL_LE_OPCODE(BLE_HCI_OCF_LE_ADD_WHITE_LIST), 0 },
+        { 0 }
+    }));
+    rc = ble_gap_wl_update(new_addrs, new_addrs_count);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    ble_gap_test_util_verify_tx_rmv_wl(addrs + 1);
+    ble_gap_test_util_verify_tx_rmv_wl(addrs + 3);
+    ble_gap_test_util_verify_tx_add_wl(new_addrs + 1);
+    TEST_ASSERT(ble_hs_test_util_hci_out_first() == NULL);
+
+    /*** Same list again; nothing to send. */
+    rc = ble_gap_wl_update(new_addrs, new_addrs_count);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(ble_hs_test_util_hci_out_first() == NULL);
+
+    /*** Controller failure; the failed entry is retried on the next update. */
+    ble_hs_test_util_hci_ack_set(
+        BLE_HS_TEST_UTIL_LE_OPCODE(BLE_HCI_OCF_LE_RMV_WHITE_LIST),
+        BLE_ERR_UNSPECIFIED);
+    rc = ble_gap_wl_update(new_addrs, 2);
+    TEST_ASSERT(rc == BLE_HS_HCI_ERR(BLE_ERR_UNSPECIFIED));
+    ble_gap_test_util_verify_tx_rmv_wl(new_addrs + 2);
+
+    ble_hs_test_util_hci_ack_set(
+        BLE_HS_TEST_UTIL_LE_OPCODE(BLE_HCI_OCF_LE_RMV_WHITE_LIST), 0);
+    rc = ble_gap_wl_update(new_addrs, 2);
+    TEST_ASSERT_FATAL(rc == 0);
+    ble_gap_test_util_verify_tx_rmv_wl(new_addrs + 2);
+    TEST_ASSERT(ble_hs_test_util_hci_out_first() == NULL);
+
+    /*** Empty list removes everything. */
+    ble_hs_test_util_hci_ack_set_seq(((struct ble_hs_test_util_hci_ack[]) {
+        { BLE_HS_TEST_UTIL_LE_OPCODE(BLE_HCI_OCF_LE_RMV_WHITE_LIST), 0 },
+        { BLE_HS_TEST_UTIL_LE_OPCODE(BLE_HCI_OCF_LE_RMV_WHITE_LIST), 0 },
+        { 0 }
+    }));
+    rc = ble_gap_wl_update(NULL, 0);
+    TEST_ASSERT_FATAL(rc == 0);
+    ble_gap_test_util_verify_tx_rmv_wl(new_addrs + 1);
+    ble_gap_test_util_verify_tx_rmv_wl(new_addrs + 0);
+    TEST_ASSERT(ble_hs_test_util_hci_out_first() == NULL);
+}
+
 TEST_SUITE(ble_gap_test_suite_wl)
 {
     tu_suite_set_post_test_cb(ble_hs_test_util_post_test, NULL);
@@ -503,6 +589,7 @@ TEST_SUITE(ble_gap_test_suite_wl)
     ble_gap_test_case_wl_good();
     ble_gap_test_case_wl_bad_args();
     ble_gap_test_case_wl_ctlr_fail();
+    ble_gap_test_case_wl_update();
 }
 
 /*****************************************************************************
@@ -798,6 +885,271 @@ TEST_CASE(ble_gap_test_case_disc_busy)
     TEST_ASSERT(rc == BLE_HS_EBUSY);
 }
 
+static int ble_gap_test_disc_num_events;
+static int ble_gap_test_disc_num_reports;
+
+static int
+ble_gap_test_util_disc_count_cb(struct ble_gap_event *event, void *arg)
+{
+    int i;
+
+    ble_gap_test_disc_num_events++;
+
+    switch (event->type) {
+    case BLE_GAP_EVENT_DISC:
+        TEST_ASSERT(event->disc.addr.val[0] ==
+                    ble_gap_test_disc_num_reports + 1);
+        ble_gap_test_disc_num_reports++;
+        break;
+
+    case BLE_GAP_EVENT_DISC_BATCH:
+        for (i = 0; i < event->disc_batch.num; i++) {
+            TEST_ASSERT(event->disc_batch.descs[i].addr.val[0] ==
+                        ble_gap_test_disc_num_reports + 1);
+            TEST_ASSERT(event->disc_batch.descs[i].rssi == -40 - i);
+            ble_gap_test_disc_num_reports++;
+        }
+        break;
+
+    default:
+        TEST_ASSERT(0);
+        break;
+    }
+
+    return 0;
+}
+
+/**
+ * Receives an LE Advertising Report event carrying the specified number of
+ * reports from advertisers 1, 2, 3...
+ */
+static void
+ble_gap_test_util_rx_adv_rpts(int num_reports)
+{
+    uint8_t *evbuf;
+    uint8_t *rpt;
+    int rc;
+    int i;
+
+    evbuf = ble_hci_trans_buf_alloc(BLE_HCI_TRANS_BUF_EVT_LO);
+    TEST_ASSERT_FATAL(evbuf != NULL);
+
+    evbuf[0] = BLE_HCI_EVCODE_LE_META;
+    evbuf[1] = 2 + num_reports * (BLE_HCI_LE_ADV_RPT_MIN_LEN - 2);
+    evbuf[2] = BLE_HCI_LE_SUBEV_ADV_RPT;
+    evbuf[3] = num_reports;
+    TEST_ASSERT_FATAL(evbuf[1] + 2 <= MYNEWT_VAL(BLE_HCI_EVT_BUF_SIZE));
+
+    rpt = evbuf + 4;
+    for (i = 0; i < num_reports; i++) {
+        rpt[0] = BLE_HCI_ADV_RPT_EVTYPE_NONCONN_IND;
+        rpt[1] = BLE_ADDR_PUBLIC;
+        memcpy(rpt + 2, ((uint8_t[6]){ i + 1, 2, 3, 4, 5, 6 }), 6);
+        rpt[8] = 0;
+        rpt[9] = (uint8_t)(-40 - i);
+        rpt += BLE_HCI_LE_ADV_RPT_MIN_LEN - 2;
+    }
+
+    rc = ble_hs_hci_evt_process(evbuf);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+TEST_CASE(ble_gap_test_case_disc_batch)
+{
+    struct ble_gap_disc_params disc_params = {
+        .itvl = BLE_GAP_SCAN_SLOW_INTERVAL1,
+        .window = BLE_GAP_SCAN_SLOW_WINDOW1,
+        .filter_policy = BLE_HCI_CONN_FILT_NO_WL,
+        .passive = 1,
+    };
+    int rc;
+
+    /*** Without batching, each report gets its own event. */
+    ble_gap_test_util_init();
+    ble_gap_test_disc_num_events = 0;
+    ble_gap_test_disc_num_reports = 0;
+
+    rc = ble_hs_test_util_disc(BLE_OWN_ADDR_PUBLIC, BLE_HS_FOREVER,
+                               &disc_params, ble_gap_test_util_disc_count_cb,
+                               NULL, -1, 0);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    ble_gap_test_util_rx_adv_rpts(3);
+    TEST_ASSERT(ble_gap_test_disc_num_events == 3);
+    TEST_ASSERT(ble_gap_test_disc_num_reports == 3);
+
+    /*** With batching, the reports of one HCI event arrive together. */
+    ble_gap_test_util_init();
+    ble_gap_test_disc_num_events = 0;
+    ble_gap_test_disc_num_reports = 0;
+
+    disc_params.batch = 1;
+    rc = ble_hs_test_util_disc(BLE_OWN_ADDR_PUBLIC, BLE_HS_FOREVER,
+                               &disc_params, ble_gap_test_util_disc_count_cb,
+                               NULL, -1, 0);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    ble_gap_test_util_rx_adv_rpts(5);
+    TEST_ASSERT(ble_gap_test_disc_num_events == 1);
+    TEST_ASSERT(ble_gap_test_disc_num_reports == 5);
+}
+
+static int
+ble_gap_test_util_disc_load_cb(struct ble_gap_event *event, void *arg)
+{
+    ble_gap_test_disc_num_events++;
+
+    switch (event->type) {
+    case BLE_GAP_EVENT_DISC:
+        ble_gap_test_disc_num_reports++;
+        break;
+
+    case BLE_GAP_EVENT_DISC_BATCH:
+        ble_gap_test_disc_num_reports += event->disc_batch.num;
+        break;
+
+    default:
+        TEST_ASSERT(0);
+        break;
+    }
+
+    return 0;
+}
+
+/**
+ * Runs a synthetic scan load of num_evts HCI events with rpts_per_evt
+ * reports each through the host, and checks the number of GAP events the
+ * application sees.
+ */
+static void
+ble_gap_test_util_disc_load(int batch, int num_evts, int rpts_per_evt,
+                            int exp_gap_events)
+{
+    struct ble_gap_disc_params disc_params = {
+        .itvl = BLE_GAP_SCAN_SLOW_INTERVAL1,
+        .window = BLE_GAP_SCAN_SLOW_WINDOW1,
+        .filter_policy = BLE_HCI_CONN_FILT_NO_WL,
+        .passive = 1,
+        .batch = batch,
+    };
+    int rc;
+    int i;
+
+    ble_gap_test_util_init();
+    ble_gap_test_disc_num_events = 0;
+    ble_gap_test_disc_num_reports = 0;
+
+    rc = ble_hs_test_util_disc(BLE_OWN_ADDR_PUBLIC, BLE_HS_FOREVER,
+                               &disc_params, ble_gap_test_util_disc_load_cb,
+                               NULL, -1, 0);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (i = 0; i < num_evts; i++) {
+        ble_gap_test_util_rx_adv_rpts(rpts_per_evt);
+    }
+
+    TEST_ASSERT(ble_gap_test_disc_num_reports == num_evts * rpts_per_evt);
+    TEST_ASSERT(ble_gap_test_disc_num_events == exp_gap_events);
+}
+
+/**
+ * Reports a batching controller fits in one HCI event: as many as the event
+ * buffer holds, but no more than 25.
+ */
+#define BLE_GAP_TEST_LOAD_RPTS_PER_EVT                                  \
+    min(25, (MYNEWT_VAL(BLE_HCI_EVT_BUF_SIZE) - 4) /                    \
+            (BLE_HCI_LE_ADV_RPT_MIN_LEN - 2))
+
+#define BLE_GAP_TEST_LOAD_EVTS      20
+
+TEST_CASE(ble_gap_test_case_disc_batch_load)
+{
+    int num_rpts;
+
+    num_rpts = BLE_GAP_TEST_LOAD_EVTS * BLE_GAP_TEST_LOAD_RPTS_PER_EVT;
+
+    /* One report per HCI event: the controller does not batch. */
+    ble_gap_test_util_disc_load(0, num_rpts, 1, num_rpts);
+
+    /* The same reports batched by the controller but delivered one by one:
+     * only the HCI event overhead is saved.
+     */
+    ble_gap_test_util_disc_load(0, BLE_GAP_TEST_LOAD_EVTS,
+                                BLE_GAP_TEST_LOAD_RPTS_PER_EVT, num_rpts);
+
+    /* Batched end to end: the host decodes each HCI event in chunks of up
+     * to 8 reports and delivers one GAP event per chunk.
+     */
+    ble_gap_test_util_disc_load(1, BLE_GAP_TEST_LOAD_EVTS,
+                                BLE_GAP_TEST_LOAD_RPTS_PER_EVT,
+                                BLE_GAP_TEST_LOAD_EVTS *
+                                ((BLE_GAP_TEST_LOAD_RPTS_PER_EVT + 7) / 8));
+}
+
+TEST_CASE(ble_gap_test_case_disc_filt)
+{
+    static const uint8_t uuid[2] = { 0x0f, 0x18 };
+    static const ble_addr_t peer_addr = {
+        BLE_ADDR_RANDOM,
+        { 1, 2, 3, 4, 5, 6 }
+    };
+    uint8_t param_len;
+    uint8_t *param;
+    int rc;
+
+    ble_gap_test_util_init();
+
+    /* AD filter; a NULL mask compares all bits. */
+    ble_hs_test_util_hci_ack_set(
+        BLE_HCI_OP(BLE_HCI_OGF_VENDOR, BLE_HCI_OCF_VS_ADD_ADV_FILT), 0);
+    rc = ble_gap_disc_filt_add_ad(BLE_HS_ADV_TYPE_COMP_UUIDS16, uuid, NULL,
+                                  sizeof uuid);
+    TEST_ASSERT(rc == 0);
+
+    param = ble_hs_test_util_hci_verify_tx(BLE_HCI_OGF_VENDOR,
+                                           BLE_HCI_OCF_VS_ADD_ADV_FILT,
+                                           &param_len);
+    TEST_ASSERT_FATAL(param_len == 7);
+    TEST_ASSERT(param[0] == BLE_HCI_VS_ADV_FILT_TYPE_AD);
+    TEST_ASSERT(param[1] == BLE_HS_ADV_TYPE_COMP_UUIDS16);
+    TEST_ASSERT(param[2] == 2);
+    TEST_ASSERT(memcmp(param + 3, uuid, 2) == 0);
+    TEST_ASSERT(param[5] == 0xff && param[6] == 0xff);
+
+    /* Address filter; the controller's table is full. */
+    ble_hs_test_util_hci_ack_set(
+        BLE_HCI_OP(BLE_HCI_OGF_VENDOR, BLE_HCI_OCF_VS_ADD_ADV_FILT),
+        BLE_ERR_MEM_CAPACITY);
+    rc = ble_gap_disc_filt_add_addr(&peer_addr);
+    TEST_ASSERT(rc == BLE_HS_HCI_ERR(BLE_ERR_MEM_CAPACITY));
+
+    param = ble_hs_test_util_hci_verify_tx(BLE_HCI_OGF_VENDOR,
+                                           BLE_HCI_OCF_VS_ADD_ADV_FILT,
+                                           &param_len);
+    TEST_ASSERT_FATAL(param_len == BLE_HCI_VS_ADD_ADV_FILT_ADDR_LEN);
+    TEST_ASSERT(param[0] == BLE_HCI_VS_ADV_FILT_TYPE_ADDR);
+    TEST_ASSERT(param[1] == BLE_ADDR_RANDOM);
+    TEST_ASSERT(memcmp(param + 2, peer_addr.val, 6) == 0);
+
+    /* Enable. */
+    ble_hs_test_util_hci_ack_set(
+        BLE_HCI_OP(BLE_HCI_OGF_VENDOR, BLE_HCI_OCF_VS_SET_ADV_FILT_ENABLE), 0);
+    rc = ble_gap_disc_filt_enable(1, -70);
+    TEST_ASSERT(rc == 0);
+
+    param = ble_hs_test_util_hci_verify_tx(BLE_HCI_OGF_VENDOR,
+                                           BLE_HCI_OCF_VS_SET_ADV_FILT_ENABLE,
+                                           &param_len);
+    TEST_ASSERT_FATAL(param_len == BLE_HCI_VS_SET_ADV_FILT_ENABLE_LEN);
+    TEST_ASSERT(param[0] == 1);
+    TEST_ASSERT((int8_t)param[1] == -70);
+
+    /* Oversized value. */
+    rc = ble_gap_disc_filt_add_ad(BLE_HS_ADV_TYPE_MFG_DATA, uuid, NULL,
+                                  BLE_HCI_VS_ADV_FILT_AD_MAX_LEN + 1);
+    TEST_ASSERT(rc == BLE_HS_EINVAL);
+}
+
 TEST_SUITE(ble_gap_test_suite_disc)
 {
     tu_suite_set_post_test_cb(ble_hs_test_util_post_test, NULL);
@@ -809,6 +1161,9 @@ TEST_SUITE(ble_gap_test_suite_disc)
     ble_gap_test_case_disc_dflts();
     ble_gap_test_case_disc_already();
     ble_gap_test_case_disc_busy();
+    ble_gap_test_case_disc_batch();
+    ble_gap_test_case_disc_batch_load();
+    ble_gap_test_case_disc_filt();
 }
 
 /*****************************************************************************
@@ -1033,6 +1388,160 @@ TEST_CASE(ble_gap_test_case_conn_gen_fail_evt)
                 BLE_HS_HCI_ERR(BLE_ERR_CONN_ESTABLISHMENT));
 }
 
+TEST_CASE(ble_gap_test_case_conn_gen_queue)
+{
+    struct hci_le_conn_complete evt;
+    struct ble_hs_conn *conn;
+    uint8_t param_len;
+    uint8_t *param;
+    int rc;
+
+    ble_addr_t peer_addrs[3] = {
+        { BLE_ADDR_PUBLIC, { 1, 2, 3, 4, 5, 6 }},
+        { BLE_ADDR_PUBLIC, { 2, 3, 4, 5, 6, 7 }},
+        { BLE_ADDR_RANDOM, { 3, 4, 5, 6, 7, 0xc8 }},
+    };
+
+    ble_gap_test_util_init();
+    ble_hs_test_util_hci_out_clear();
+
+    /*** First target starts a white list connect procedure. */
+    ble_hs_test_util_hci_ack_set_seq(((struct ble_hs_test_util_hci_ack[]) {
+        { BLE_HS_TEST_UTIL_LE_OPCODE(BLE_HCI_OCF_LE_ADD_WHITE_LIST), 0 },
+        { BLE_HS_TEST_UTIL_LE_OPCODE(BLE_HCI_OCF_LE_CREATE_CONN), 0 },
+        { 0 }
+    }));
+    rc = ble_gap_connq_add(BLE_OWN_ADDR_PUBLIC, peer_addrs + 0,
+                           BLE_HS_FOREVER, NULL,
+                           ble_gap_test_util_connect_cb, peer_addrs + 0);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    ble_gap_test_util_verify_tx_add_wl(peer_addrs + 0);
+    param = ble_hs_test_util_hci_verify_tx(BLE_HCI_OGF_LE,
+                                           BLE_HCI_OCF_LE_CREATE_CONN,
+                                           &param_len);
+    TEST_ASSERT(param[4] == BLE_HCI_CONN_FILT_USE_WL);
+    TEST_ASSERT(ble_gap_conn_active());
+
+    /* Duplicate targets are rejected. */
+    rc = ble_gap_connq_add(BLE_OWN_ADDR_PUBLIC, peer_addrs + 0,
+                           BLE_HS_FOREVER, NULL,
+                           ble_gap_test_util_connect_cb, NULL);
+    TEST_ASSERT(rc == BLE_HS_EALREADY);
+
+    /*** Second target re-arms the procedure. */
+    ble_hs_test_util_hci_ack_set(
+        BLE_HS_TEST_UTIL_LE_OPCODE(BLE_HCI_OCF_LE_CREATE_CONN_CANCEL), 0);
+    rc = ble_gap_connq_add(BLE_OWN_ADDR_PUBLIC, peer_addrs + 1, 1000, NULL,
+                           ble_gap_test_util_connect_cb, peer_addrs + 1);
+    TEST_ASSERT_FATAL(rc == 0);
+    ble_hs_test_util_hci_verify_tx_create_conn_cancel();
+
+    ble_hs_test_util_hci_ack_set_seq(((struct ble_hs_test_util_hci_ack[]) {
+        { BLE_HS_TEST_UTIL_LE_OPCODE(BLE_HCI_OCF_LE_ADD_WHITE_LIST), 0 },
+        { BLE_HS_TEST_UTIL_LE_OPCODE(BLE_HCI_OCF_LE_CREATE_CONN), 0 },
+        { 0 }
+    }));
+    ble_hs_test_util_hci_rx_conn_cancel_evt();
+    ble_gap_test_util_verify_tx_add_wl(peer_addrs + 1);
+    ble_hs_test_util_hci_verify_tx(BLE_HCI_OGF_LE, BLE_HCI_OCF_LE_CREATE_CONN,
+                                   NULL);
+    TEST_ASSERT(ble_gap_conn_active());
+
+    /* The internal cancellation is not reported to the application. */
+    TEST_ASSERT(ble_gap_test_conn_status == -1);
+
+    /*** Second target connects; procedure continues for the first. */
+    ble_hs_test_util_hci_ack_set_seq(((struct ble_hs_test_util_hci_ack[]) {
+        { BLE_HS_TEST_UTIL_LE_OPCODE(BLE_HCI_OCF_LE_RMV_WHITE_LIST), 0 },
+        { BLE_HS_TEST_UTIL_LE_OPCODE(BLE_HCI_OCF_LE_CREATE_CONN), 0 },
+        { BLE_HS_TEST_UTIL_LE_OPCODE(BLE_HCI_OCF_LE_RD_REM_FEAT), 0 },
+        { 0 }
+    }));
+
+    memset(&evt, 0, sizeof evt);
+    evt.subevent_code = BLE_HCI_LE_SUBEV_CONN_COMPLETE;
+    evt.status = BLE_ERR_SUCCESS;
+    evt.connection_handle = 2;
+    evt.role = BLE_HCI_LE_CONN_COMPLETE_ROLE_MASTER;
+    evt.peer_addr_type = peer_addrs[1].type;
+    memcpy(evt.peer_addr, peer_addrs[1].val, 6);
+    rc = ble_gap_rx_conn_complete(&evt, 0);
+    TEST_ASSERT(rc == 0);
+
+    TEST_ASSERT(ble_gap_test_event.type == BLE_GAP_EVENT_CONNECT);
+    TEST_ASSERT(ble_gap_test_conn_status == 0);
+    TEST_ASSERT(ble_gap_test_conn_desc.conn_handle == 2);
+    TEST_ASSERT(ble_gap_test_conn_arg == peer_addrs + 1);
+
+    ble_hs_lock();
+    conn = ble_hs_conn_find(2);
+    TEST_ASSERT_FATAL(conn != NULL);
+    TEST_ASSERT(conn->bhc_cb == ble_gap_test_util_connect_cb);
+    TEST_ASSERT(conn->bhc_cb_arg == peer_addrs + 1);
+    ble_hs_unlock();
+
+    ble_gap_test_util_verify_tx_rmv_wl(peer_addrs + 1);
+    ble_hs_test_util_hci_verify_tx(BLE_HCI_OGF_LE, BLE_HCI_OCF_LE_CREATE_CONN,
+                                   NULL);
+    ble_hs_test_util_hci_verify_tx(BLE_HCI_OGF_LE, BLE_HCI_OCF_LE_RD_REM_FEAT,
+                                   NULL);
+    TEST_ASSERT(ble_gap_conn_active());
+
+    /*** A target times out on its own. */
+    ble_gap_test_util_reset_cb_info();
+    ble_hs_test_util_hci_ack_set(
+        BLE_HS_TEST_UTIL_LE_OPCODE(BLE_HCI_OCF_LE_CREATE_CONN_CANCEL), 0);
+    rc = ble_gap_connq_add(BLE_OWN_ADDR_PUBLIC, peer_addrs + 2, 1000, NULL,
+                           ble_gap_test_util_connect_cb, peer_addrs + 2);
+    TEST_ASSERT_FATAL(rc == 0);
+    ble_hs_test_util_hci_verify_tx_create_conn_cancel();
+
+    ble_hs_test_util_hci_ack_set_seq(((struct ble_hs_test_util_hci_ack[]) {
+        { BLE_HS_TEST_UTIL_LE_OPCODE(BLE_HCI_OCF_LE_ADD_WHITE_LIST), 0 },
+        { BLE_HS_TEST_UTIL_LE_OPCODE(BLE_HCI_OCF_LE_CREATE_CONN), 0 },
+        { 0 }
+    }));
+    ble_hs_test_util_hci_rx_conn_cancel_evt();
+    ble_gap_test_util_verify_tx_add_wl(peer_addrs + 2);
+    ble_hs_test_util_hci_verify_tx(BLE_HCI_OGF_LE, BLE_HCI_OCF_LE_CREATE_CONN,
+                                   NULL);
+
+    os_time_advance(1 * OS_TICKS_PER_SEC);
+    ble_hs_test_util_hci_ack_set(
+        BLE_HS_TEST_UTIL_LE_OPCODE(BLE_HCI_OCF_LE_CREATE_CONN_CANCEL), 0);
+    ble_gap_timer();
+
+    TEST_ASSERT(ble_gap_test_event.type == BLE_GAP_EVENT_CONNECT);
+    TEST_ASSERT(ble_gap_test_conn_status == BLE_HS_ETIMEOUT);
+    TEST_ASSERT(ble_gap_test_conn_arg == peer_addrs + 2);
+    ble_hs_test_util_hci_verify_tx_create_conn_cancel();
+
+    ble_hs_test_util_hci_ack_set_seq(((struct ble_hs_test_util_hci_ack[]) {
+        { BLE_HS_TEST_UTIL_LE_OPCODE(BLE_HCI_OCF_LE_RMV_WHITE_LIST), 0 },
+        { BLE_HS_TEST_UTIL_LE_OPCODE(BLE_HCI_OCF_LE_CREATE_CONN), 0 },
+        { 0 }
+    }));
+    ble_hs_test_util_hci_rx_conn_cancel_evt();
+    ble_gap_test_util_verify_tx_rmv_wl(peer_addrs + 2);
+    ble_hs_test_util_hci_verify_tx(BLE_HCI_OGF_LE, BLE_HCI_OCF_LE_CREATE_CONN,
+                                   NULL);
+
+    /*** Cancelling the last target stops the procedure. */
+    ble_hs_test_util_hci_ack_set(
+        BLE_HS_TEST_UTIL_LE_OPCODE(BLE_HCI_OCF_LE_CREATE_CONN_CANCEL), 0);
+    rc = ble_gap_connq_cancel(peer_addrs + 0);
+    TEST_ASSERT(rc == 0);
+    ble_hs_test_util_hci_verify_tx_create_conn_cancel();
+
+    ble_hs_test_util_hci_rx_conn_cancel_evt();
+    TEST_ASSERT(!ble_gap_master_in_progress());
+    TEST_ASSERT(ble_hs_test_util_hci_out_first() == NULL);
+
+    rc = ble_gap_connq_cancel(peer_addrs + 0);
+    TEST_ASSERT(rc == BLE_HS_ENOENT);
+}
+
 TEST_SUITE(ble_gap_test_suite_conn_gen)
 {
     tu_suite_set_post_test_cb(ble_hs_test_util_post_test, NULL);
@@ -1044,6 +1553,7 @@ TEST_SUITE(ble_gap_test_suite_conn_gen)
     ble_gap_test_case_conn_gen_done();
     ble_gap_test_case_conn_gen_busy();
     ble_gap_test_case_conn_gen_fail_evt();
+    ble_gap_test_case_conn_gen_queue();
 }
 
 /*****************************************************************************
@@ -3132,6 +3642,677 @@ TEST_SUITE(ble_gap_test_suite_set_cb)
     ble_gap_test_case_set_cb_bad();
 }
 
+#if MYNEWT_VAL(BLE_PERIODIC_ADV)
+
+/*****************************************************************************
+ * $periodic                                                                 *
+ *****************************************************************************/
+
+static int ble_gap_test_periodic_event_cnt;
+static uint8_t ble_gap_test_periodic_rpt_data[BLE_HCI_MAX_ADV_DATA_LEN];
+
+static int
+ble_gap_test_util_periodic_cb(struct ble_gap_event *event, void *arg)
+{
+    ble_gap_test_event = *event;
+    ble_gap_test_periodic_event_cnt++;
+
+    /* Report data is only valid for the duration of the callback. */
+    if (event->type == BLE_GAP_EVENT_PERIODIC_REPORT) {
+        TEST_ASSERT_FATAL(event->periodic_report.data_length <=
+                          sizeof ble_gap_test_periodic_rpt_data);
+        memcpy(ble_gap_test_periodic_rpt_data, event->periodic_report.data,
+               event->periodic_report.data_length);
+    }
+
+    return 0;
+}
+
+static void
+ble_gap_test_util_periodic_init(void)
+{
+    ble_gap_test_util_init();
+    ble_gap_test_periodic_event_cnt = 0;
+}
+
+/**
+ * Configures extended advertising instance 0 with the given properties and
+ * discards the HCI commands this produced.
+ */
+static void
+ble_gap_test_util_periodic_ext_adv(int legacy_pdu, int connectable,
+                                   int anonymous)
+{
+    struct ble_gap_ext_adv_params params;
+    int8_t tx_power;
+    int rc;
+
+    memset(&params, 0, sizeof params);
+    params.legacy_pdu = legacy_pdu;
+    params.connectable = connectable;
+    params.anonymous = anonymous;
+    params.own_addr_type = BLE_OWN_ADDR_PUBLIC;
+    params.primary_phy = BLE_HCI_LE_PHY_1M;
+    params.secondary_phy = BLE_HCI_LE_PHY_1M;
+    params.sid = 3;
+
+    tx_power = 0;
+    ble_hs_test_util_hci_ack_set_params(
+        BLE_HCI_OP(BLE_HCI_OGF_LE, BLE_HCI_OCF_LE_SET_EXT_ADV_PARAM),
+        0, &tx_power, 1);
+    rc = ble_gap_ext_adv_configure(0, &params, NULL,
+                                   ble_gap_test_util_periodic_cb, NULL);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    ble_hs_test_util_hci_out_clear();
+}
+
+static void
+ble_gap_test_util_periodic_configure(
+    const struct ble_gap_periodic_adv_params *params)
+{
+    int rc;
+
+    ble_hs_test_util_hci_ack_set(
+        BLE_HCI_OP(BLE_HCI_OGF_LE, BLE_HCI_OCF_LE_SET_PER_ADV_PARAMS), 0);
+    rc = ble_gap_periodic_adv_configure(0, params);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+static void
+ble_gap_test_util_periodic_verify_tx_params(uint16_t itvl_min,
+                                            uint16_t itvl_max,
+                                            uint16_t props)
+{
+    uint8_t param_len;
+    uint8_t *param;
+
+    param = ble_hs_test_util_hci_verify_tx(BLE_HCI_OGF_LE,
+                                           BLE_HCI_OCF_LE_SET_PER_ADV_PARAMS,
+                                           &param_len);
+    TEST_ASSERT(param_len == BLE_HCI_LE_SET_PER_ADV_PARAMS_LEN);
+    TEST_ASSERT(param[0] == 0);
+    TEST_ASSERT(get_le16(param + 1) == itvl_min);
+    TEST_ASSERT(get_le16(param + 3) == itvl_max);
+    TEST_ASSERT(get_le16(param + 5) == props);
+}
+
+static void
+ble_gap_test_util_periodic_verify_tx_enable(uint8_t enable)
+{
+    uint8_t param_len;
+    uint8_t *param;
+
+    param = ble_hs_test_util_hci_verify_tx(BLE_HCI_OGF_LE,
+                                           BLE_HCI_OCF_LE_SET_PER_ADV_ENABLE,
+                                           &param_len);
+    TEST_ASSERT(param_len == BLE_HCI_LE_SET_PER_ADV_ENABLE_LEN);
+    TEST_ASSERT(param[0] == enable);
+    TEST_ASSERT(param[1] == 0);
+}
+
+static void
+ble_gap_test_util_periodic_verify_tx_data(uint8_t op, const uint8_t *data,
+                                          uint8_t data_len)
+{
+    uint8_t param_len;
+    uint8_t *param;
+
+    param = ble_hs_test_util_hci_verify_tx(BLE_HCI_OGF_LE,
+                                           BLE_HCI_OCF_LE_SET_PER_ADV_DATA,
+                                           &param_len);
+    TEST_ASSERT(param_len == 3 + data_len);
+    TEST_ASSERT(param[0] == 0);
+    TEST_ASSERT(param[1] == op);
+    TEST_ASSERT(param[2] == data_len);
+    TEST_ASSERT(memcmp(param + 3, data, data_len) == 0);
+}
+
+static const ble_addr_t ble_gap_test_periodic_addr = {
+    BLE_ADDR_RANDOM, { 1, 2, 3, 4, 5, 0xc6 }
+};
+
+static const struct ble_gap_periodic_sync_params
+    ble_gap_test_periodic_sync_params = {
+    .skip = 2,
+    .sync_timeout = 0x0200,
+};
+
+static void
+ble_gap_test_util_periodic_sync_create(void)
+{
+    int rc;
+
+    ble_hs_test_util_hci_ack_set(
+        BLE_HCI_OP(BLE_HCI_OGF_LE, BLE_HCI_OCF_LE_PER_ADV_CREATE_SYNC), 0);
+    rc = ble_gap_periodic_adv_sync_create(&ble_gap_test_periodic_addr, 5,
+                                          &ble_gap_test_periodic_sync_params,
+                                          ble_gap_test_util_periodic_cb,
+                                          NULL);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+static void
+ble_gap_test_util_periodic_rx_sync_estab(uint8_t status,
+                                         uint16_t sync_handle)
+{
+    struct hci_le_subev_periodic_adv_sync_estab evt;
+
+    memset(&evt, 0, sizeof evt);
+    evt.status = status;
+    evt.sync_handle = sync_handle;
+    evt.sid = 5;
+    evt.adv_addr_type = ble_gap_test_periodic_addr.type;
+    memcpy(evt.adv_addr, ble_gap_test_periodic_addr.val, BLE_DEV_ADDR_LEN);
+    evt.adv_phy = BLE_HCI_LE_PHY_2M;
+    evt.per_adv_ival = 0x0050;
+    evt.adv_clk_accuracy = 4;
+
+    ble_hs_test_util_hci_rx_periodic_sync_estab_evt(&evt);
+}
+
+static void
+ble_gap_test_util_periodic_rx_rpt(uint16_t sync_handle, uint8_t *data,
+                                  uint8_t data_len)
+{
+    struct hci_le_subev_periodic_adv_rpt evt;
+
+    memset(&evt, 0, sizeof evt);
+    evt.sync_handle = sync_handle;
+    evt.tx_power = -4;
+    evt.rssi = -60;
+    evt.unused = 0xff;
+    evt.data_status = BLE_HCI_PER_ADV_DATA_STATUS_COMPLETE;
+    evt.data_length = data_len;
+    evt.data = data;
+
+    ble_hs_test_util_hci_rx_periodic_rpt_evt(&evt);
+}
+
+TEST_CASE(ble_gap_test_case_periodic_adv_configure)
+{
+    struct ble_gap_periodic_adv_params params;
+    int rc;
+
+    memset(&params, 0, sizeof params);
+
+    /*** Invalid instance or parameters. */
+    ble_gap_test_util_periodic_init();
+    ble_gap_test_util_periodic_ext_adv(0, 0, 0);
+
+    rc = ble_gap_periodic_adv_configure(BLE_ADV_INSTANCES, &params);
+    TEST_ASSERT(rc == BLE_HS_EINVAL);
+    rc = ble_gap_periodic_adv_configure(0, NULL);
+    TEST_ASSERT(rc == BLE_HS_EINVAL);
+
+    params.itvl_min = BLE_HCI_LE_SET_PER_ADV_ITVL_MIN - 1;
+    params.itvl_max = 0x100;
+    rc = ble_gap_periodic_adv_configure(0, &params);
+    TEST_ASSERT(rc == BLE_HS_EINVAL);
+
+    params.itvl_min = 0x101;
+    rc = ble_gap_periodic_adv_configure(0, &params);
+    TEST_ASSERT(rc == BLE_HS_EINVAL);
+
+    TEST_ASSERT(ble_hs_test_util_hci_out_first() == NULL);
+
+    /*** Instance not suitable for periodic advertising. */
+    memset(&params, 0, sizeof params);
+
+    ble_gap_test_util_periodic_init();
+    rc = ble_gap_periodic_adv_configure(0, &params);
+    TEST_ASSERT(rc == BLE_HS_EINVAL);
+
+    ble_gap_test_util_periodic_init();
+    ble_gap_test_util_periodic_ext_adv(1, 0, 0);
+    rc = ble_gap_periodic_adv_configure(0, &params);
+    TEST_ASSERT(rc == BLE_HS_EINVAL);
+
+    ble_gap_test_util_periodic_init();
+    ble_gap_test_util_periodic_ext_adv(0, 1, 0);
+    rc = ble_gap_periodic_adv_configure(0, &params);
+    TEST_ASSERT(rc == BLE_HS_EINVAL);
+
+    ble_gap_test_util_periodic_init();
+    ble_gap_test_util_periodic_ext_adv(0, 0, 1);
+    rc = ble_gap_periodic_adv_configure(0, &params);
+    TEST_ASSERT(rc == BLE_HS_EINVAL);
+
+    TEST_ASSERT(ble_hs_test_util_hci_out_first() == NULL);
+
+    /*** Default interval. */
+    ble_gap_test_util_periodic_init();
+    ble_gap_test_util_periodic_ext_adv(0, 0, 0);
+    ble_gap_test_util_periodic_configure(&params);
+    ble_gap_test_util_periodic_verify_tx_params(BLE_GAP_PERIODIC_ITVL_MS(30),
+                                                BLE_GAP_PERIODIC_ITVL_MS(60),
+                                                0);
+
+    /*** Explicit interval with TX power; reconfiguring is allowed. */
+    params.itvl_min = BLE_HCI_LE_SET_PER_ADV_ITVL_MIN;
+    params.itvl_max = 0x0320;
+    params.include_tx_power = 1;
+    ble_gap_test_util_periodic_configure(&params);
+    ble_gap_test_util_periodic_verify_tx_params(
+        BLE_HCI_LE_SET_PER_ADV_ITVL_MIN, 0x0320,
+        BLE_HCI_LE_SET_PER_ADV_PROP_INC_TX_PWR);
+
+    /*** Controller rejects the parameters. */
+    ble_gap_test_util_periodic_init();
+    ble_gap_test_util_periodic_ext_adv(0, 0, 0);
+    ble_hs_test_util_hci_ack_set(
+        BLE_HCI_OP(BLE_HCI_OGF_LE, BLE_HCI_OCF_LE_SET_PER_ADV_PARAMS),
+        BLE_ERR_INV_HCI_CMD_PARMS);
+    rc = ble_gap_periodic_adv_configure(0, &params);
+    TEST_ASSERT(rc == BLE_HS_HCI_ERR(BLE_ERR_INV_HCI_CMD_PARMS));
+
+    /* Not configured, so it cannot be started. */
+    rc = ble_gap_periodic_adv_start(0);
+    TEST_ASSERT(rc == BLE_HS_EINVAL);
+}
+
+TEST_CASE(ble_gap_test_case_periodic_adv_start_stop)
+{
+    struct ble_gap_periodic_adv_params params;
+    int rc;
+
+    memset(&params, 0, sizeof params);
+
+    ble_gap_test_util_periodic_init();
+    ble_gap_test_util_periodic_ext_adv(0, 0, 0);
+
+    rc = ble_gap_periodic_adv_start(BLE_ADV_INSTANCES);
+    TEST_ASSERT(rc == BLE_HS_EINVAL);
+    rc = ble_gap_periodic_adv_stop(BLE_ADV_INSTANCES);
+    TEST_ASSERT(rc == BLE_HS_EINVAL);
+    rc = ble_gap_periodic_adv_start(0);
+    TEST_ASSERT(rc == BLE_HS_EINVAL);
+    rc = ble_gap_periodic_adv_stop(0);
+    TEST_ASSERT(rc == BLE_HS_EALREADY);
+
+    ble_gap_test_util_periodic_configure(&params);
+    ble_hs_test_util_hci_out_clear();
+
+    /*** Controller failure leaves periodic advertising disabled. */
+    ble_hs_test_util_hci_ack_set(
+        BLE_HCI_OP(BLE_HCI_OGF_LE, BLE_HCI_OCF_LE_SET_PER_ADV_ENABLE),
+        BLE_ERR_CMD_DISALLOWED);
+    rc = ble_gap_periodic_adv_start(0);
+    TEST_ASSERT(rc == BLE_HS_HCI_ERR(BLE_ERR_CMD_DISALLOWED));
+    ble_gap_test_util_periodic_verify_tx_enable(1);
+    rc = ble_gap_periodic_adv_stop(0);
+    TEST_ASSERT(rc == BLE_HS_EALREADY);
+
+    /*** Start. */
+    ble_hs_test_util_hci_ack_set(
+        BLE_HCI_OP(BLE_HCI_OGF_LE, BLE_HCI_OCF_LE_SET_PER_ADV_ENABLE), 0);
+    rc = ble_gap_periodic_adv_start(0);
+    TEST_ASSERT_FATAL(rc == 0);
+    ble_gap_test_util_periodic_verify_tx_enable(1);
+
+    rc = ble_gap_periodic_adv_start(0);
+    TEST_ASSERT(rc == BLE_HS_EALREADY);
+
+    /* Parameters are locked while enabled. */
+    rc = ble_gap_periodic_adv_configure(0, &params);
+    TEST_ASSERT(rc == BLE_HS_EBUSY);
+
+    TEST_ASSERT(ble_hs_test_util_hci_out_first() == NULL);
+
+    /*** Stop. */
+    ble_hs_test_util_hci_ack_set(
+        BLE_HCI_OP(BLE_HCI_OGF_LE, BLE_HCI_OCF_LE_SET_PER_ADV_ENABLE), 0);
+    rc = ble_gap_periodic_adv_stop(0);
+    TEST_ASSERT_FATAL(rc == 0);
+    ble_gap_test_util_periodic_verify_tx_enable(0);
+
+    rc = ble_gap_periodic_adv_stop(0);
+    TEST_ASSERT(rc == BLE_HS_EALREADY);
+}
+
+TEST_CASE(ble_gap_test_case_periodic_adv_data)
+{
+    struct ble_gap_periodic_adv_params params;
+    uint8_t data[MYNEWT_VAL(BLE_EXT_ADV_MAX_SIZE) + 1];
+    struct os_mbuf *om;
+    int rc;
+    int i;
+
+    memset(&params, 0, sizeof params);
+    for (i = 0; i < sizeof data; i++) {
+        data[i] = i;
+    }
+
+    ble_gap_test_util_periodic_init();
+    ble_gap_test_util_periodic_ext_adv(0, 0, 0);
+
+    /* Not configured; the chain is consumed either way. */
+    om = ble_hs_test_util_om_from_flat(data, 10);
+    rc = ble_gap_periodic_adv_set_data(0, om);
+    TEST_ASSERT(rc == BLE_HS_EINVAL);
+
+    ble_gap_test_util_periodic_configure(&params);
+    ble_hs_test_util_hci_out_clear();
+
+    om = ble_hs_test_util_om_from_flat(data, 10);
+    rc = ble_gap_periodic_adv_set_data(BLE_ADV_INSTANCES, om);
+    TEST_ASSERT(rc == BLE_HS_EINVAL);
+
+    om = ble_hs_test_util_om_from_flat(data, sizeof data);
+    rc = ble_gap_periodic_adv_set_data(0, om);
+    TEST_ASSERT(rc == BLE_HS_EINVAL);
+
+    TEST_ASSERT(ble_hs_test_util_hci_out_first() == NULL);
+
+    /*** Fits in a single command. */
+    ble_hs_test_util_hci_ack_set(
+        BLE_HCI_OP(BLE_HCI_OGF_LE, BLE_HCI_OCF_LE_SET_PER_ADV_DATA), 0);
+    om = ble_hs_test_util_om_from_flat(data, 10);
+    rc = ble_gap_periodic_adv_set_data(0, om);
+    TEST_ASSERT_FATAL(rc == 0);
+    ble_gap_test_util_periodic_verify_tx_data(
+        BLE_HCI_LE_SET_EXT_ADV_DATA_OPER_COMPLETE, data, 10);
+
+#if MYNEWT_VAL(BLE_EXT_ADV_MAX_SIZE) > 2 * BLE_HCI_LE_SET_PER_ADV_DATA_MAX_LEN
+    /*** Split into first, intermediate and last fragments. */
+    ble_hs_test_util_hci_ack_set(
+        BLE_HCI_OP(BLE_HCI_OGF_LE, BLE_HCI_OCF_LE_SET_PER_ADV_DATA), 0);
+    ble_hs_test_util_hci_ack_append(
+        BLE_HCI_OP(BLE_HCI_OGF_LE, BLE_HCI_OCF_LE_SET_PER_ADV_DATA), 0);
+    ble_hs_test_util_hci_ack_append(
+        BLE_HCI_OP(BLE_HCI_OGF_LE, BLE_HCI_OCF_LE_SET_PER_ADV_DATA), 0);
+    om = ble_hs_test_util_om_from_flat(data, sizeof data - 1);
+    rc = ble_gap_periodic_adv_set_data(0, om);
+    TEST_ASSERT_FATAL(rc == 0);
+    ble_gap_test_util_periodic_verify_tx_data(
+        BLE_HCI_LE_SET_EXT_ADV_DATA_OPER_FIRST, data,
+        BLE_HCI_LE_SET_PER_ADV_DATA_MAX_LEN);
+    ble_gap_test_util_periodic_verify_tx_data(
+        BLE_HCI_LE_SET_EXT_ADV_DATA_OPER_INT,
+        data + BLE_HCI_LE_SET_PER_ADV_DATA_MAX_LEN,
+        BLE_HCI_LE_SET_PER_ADV_DATA_MAX_LEN);
+    ble_gap_test_util_periodic_verify_tx_data(
+        BLE_HCI_LE_SET_EXT_ADV_DATA_OPER_LAST,
+        data + 2 * BLE_HCI_LE_SET_PER_ADV_DATA_MAX_LEN,
+        sizeof data - 1 - 2 * BLE_HCI_LE_SET_PER_ADV_DATA_MAX_LEN);
+
+    /*** Once enabled, data must fit in a single command. */
+    ble_hs_test_util_hci_ack_set(
+        BLE_HCI_OP(BLE_HCI_OGF_LE, BLE_HCI_OCF_LE_SET_PER_ADV_ENABLE), 0);
+    rc = ble_gap_periodic_adv_start(0);
+    TEST_ASSERT_FATAL(rc == 0);
+    ble_hs_test_util_hci_out_clear();
+
+    om = ble_hs_test_util_om_from_flat(data,
+                                       BLE_HCI_LE_SET_PER_ADV_DATA_MAX_LEN + 1);
+    rc = ble_gap_periodic_adv_set_data(0, om);
+    TEST_ASSERT(rc == BLE_HS_EINVAL);
+    TEST_ASSERT(ble_hs_test_util_hci_out_first() == NULL);
+#endif
+}
+
+TEST_CASE(ble_gap_test_case_periodic_sync_create)
+{
+    struct ble_gap_periodic_sync_params params;
+    ble_addr_t addr;
+    uint8_t param_len;
+    uint8_t *param;
+    int rc;
+
+    ble_gap_test_util_periodic_init();
+
+    /*** Parameter validation. */
+    params = ble_gap_test_periodic_sync_params;
+    addr = ble_gap_test_periodic_addr;
+
+    rc = ble_gap_periodic_adv_sync_create(NULL, 5, &params,
+                                          ble_gap_test_util_periodic_cb, NULL);
+    TEST_ASSERT(rc == BLE_HS_EINVAL);
+    rc = ble_gap_periodic_adv_sync_create(&addr, 5, NULL,
+                                          ble_gap_test_util_periodic_cb, NULL);
+    TEST_ASSERT(rc == BLE_HS_EINVAL);
+
+    addr.type = BLE_ADDR_PUBLIC_ID;
+    rc = ble_gap_periodic_adv_sync_create(&addr, 5, &params,
+                                          ble_gap_test_util_periodic_cb, NULL);
+    TEST_ASSERT(rc == BLE_HS_EINVAL);
+    addr.type = BLE_ADDR_RANDOM;
+
+    rc = ble_gap_periodic_adv_sync_create(&addr, 0x10, &params,
+                                          ble_gap_test_util_periodic_cb, NULL);
+    TEST_ASSERT(rc == BLE_HS_EINVAL);
+
+    params.skip = BLE_HCI_LE_PER_ADV_SKIP_MAX + 1;
+    rc = ble_gap_periodic_adv_sync_create(&addr, 5, &params,
+                                          ble_gap_test_util_periodic_cb, NULL);
+    TEST_ASSERT(rc == BLE_HS_EINVAL);
+    params.skip = 0;
+
+    params.sync_timeout = BLE_HCI_LE_PER_ADV_SYNC_TIMEOUT_MIN - 1;
+    rc = ble_gap_periodic_adv_sync_create(&addr, 5, &params,
+                                          ble_gap_test_util_periodic_cb, NULL);
+    TEST_ASSERT(rc == BLE_HS_EINVAL);
+
+    params.sync_timeout = BLE_HCI_LE_PER_ADV_SYNC_TIMEOUT_MAX + 1;
+    rc = ble_gap_periodic_adv_sync_create(&addr, 5, &params,
+                                          ble_gap_test_util_periodic_cb, NULL);
+    TEST_ASSERT(rc == BLE_HS_EINVAL);
+
+    TEST_ASSERT(ble_hs_test_util_hci_out_first() == NULL);
+
+    /* Nothing pending to cancel. */
+    rc = ble_gap_periodic_adv_sync_create_cancel();
+    TEST_ASSERT(rc == BLE_HS_EBUSY);
+
+    /*** Controller rejects the command; nothing is left pending. */
+    ble_hs_test_util_hci_ack_set(
+        BLE_HCI_OP(BLE_HCI_OGF_LE, BLE_HCI_OCF_LE_PER_ADV_CREATE_SYNC),
+        BLE_ERR_CMD_DISALLOWED);
+    rc = ble_gap_periodic_adv_sync_create(&ble_gap_test_periodic_addr, 5,
+                                          &ble_gap_test_periodic_sync_params,
+                                          ble_gap_test_util_periodic_cb, NULL);
+    TEST_ASSERT(rc == BLE_HS_HCI_ERR(BLE_ERR_CMD_DISALLOWED));
+    rc = ble_gap_periodic_adv_sync_create_cancel();
+    TEST_ASSERT(rc == BLE_HS_EBUSY);
+    ble_hs_test_util_hci_out_clear();
+
+    /*** Success. */
+    ble_gap_test_util_periodic_sync_create();
+
+    param = ble_hs_test_util_hci_verify_tx(BLE_HCI_OGF_LE,
+                                           BLE_HCI_OCF_LE_PER_ADV_CREATE_SYNC,
+                                           &param_len);
+    TEST_ASSERT(param_len == BLE_HCI_LE_PER_ADV_CREATE_SYNC_LEN);
+    TEST_ASSERT(param[0] == 0);
+    TEST_ASSERT(param[1] == 5);
+    TEST_ASSERT(param[2] == BLE_ADDR_RANDOM);
+    TEST_ASSERT(memcmp(param + 3, ble_gap_test_periodic_addr.val, 6) == 0);
+    TEST_ASSERT(get_le16(param + 9) == 2);
+    TEST_ASSERT(get_le16(param + 11) == 0x0200);
+    TEST_ASSERT(param[13] == 0);
+
+    /* Only one sync can be pending. */
+    rc = ble_gap_periodic_adv_sync_create(&ble_gap_test_periodic_addr, 6,
+                                          &ble_gap_test_periodic_sync_params,
+                                          ble_gap_test_util_periodic_cb, NULL);
+    TEST_ASSERT(rc == BLE_HS_EBUSY);
+
+    /*** Cancel; completes with a sync established event. */
+    ble_hs_test_util_hci_ack_set(
+        BLE_HCI_OP(BLE_HCI_OGF_LE, BLE_HCI_OCF_LE_PER_ADV_CREATE_SYNC_CANCEL),
+        0);
+    rc = ble_gap_periodic_adv_sync_create_cancel();
+    TEST_ASSERT_FATAL(rc == 0);
+    ble_hs_test_util_hci_verify_tx(BLE_HCI_OGF_LE,
+                                   BLE_HCI_OCF_LE_PER_ADV_CREATE_SYNC_CANCEL,
+                                   &param_len);
+    TEST_ASSERT(param_len == 0);
+    TEST_ASSERT(ble_gap_test_periodic_event_cnt == 0);
+
+    ble_gap_test_util_periodic_rx_sync_estab(BLE_ERR_OPERATION_CANCELLED, 0);
+    TEST_ASSERT(ble_gap_test_periodic_event_cnt == 1);
+    TEST_ASSERT(ble_gap_test_event.type == BLE_GAP_EVENT_PERIODIC_SYNC);
+    TEST_ASSERT(ble_gap_test_event.periodic_sync.status ==
+                BLE_HS_HCI_ERR(BLE_ERR_OPERATION_CANCELLED));
+
+    /* The procedure is over; a new one can be started. */
+    rc = ble_gap_periodic_adv_sync_create_cancel();
+    TEST_ASSERT(rc == BLE_HS_EBUSY);
+    ble_gap_test_util_periodic_sync_create();
+}
+
+TEST_CASE(ble_gap_test_case_periodic_sync_events)
+{
+    uint8_t data[] = { 2, BLE_HS_ADV_TYPE_FLAGS, 0x06, 3, 0xff, 0x34, 0x12 };
+    int rc;
+
+    ble_gap_test_util_periodic_init();
+
+    /*** Unsolicited sync established event is ignored. */
+    ble_gap_test_util_periodic_rx_sync_estab(0, 0x0010);
+    TEST_ASSERT(ble_gap_test_periodic_event_cnt == 0);
+
+    /*** Failed sync. */
+    ble_gap_test_util_periodic_sync_create();
+    ble_gap_test_util_periodic_rx_sync_estab(BLE_ERR_CONN_ESTABLISHMENT,
+                                             0x0010);
+    TEST_ASSERT(ble_gap_test_periodic_event_cnt == 1);
+    TEST_ASSERT(ble_gap_test_event.type == BLE_GAP_EVENT_PERIODIC_SYNC);
+    TEST_ASSERT(ble_gap_test_event.periodic_sync.status ==
+                BLE_HS_HCI_ERR(BLE_ERR_CONN_ESTABLISHMENT));
+
+    /* No sync was allocated. */
+    ble_gap_test_util_periodic_rx_rpt(0x0010, data, sizeof data);
+    TEST_ASSERT(ble_gap_test_periodic_event_cnt == 1);
+
+    /*** Sync established. */
+    ble_gap_test_util_periodic_sync_create();
+    ble_gap_test_util_periodic_rx_sync_estab(0, 0x0010);
+    TEST_ASSERT(ble_gap_test_periodic_event_cnt == 2);
+    TEST_ASSERT(ble_gap_test_event.type == BLE_GAP_EVENT_PERIODIC_SYNC);
+    TEST_ASSERT(ble_gap_test_event.periodic_sync.status == 0);
+    TEST_ASSERT(ble_gap_test_event.periodic_sync.sync_handle == 0x0010);
+    TEST_ASSERT(ble_gap_test_event.periodic_sync.sid == 5);
+    TEST_ASSERT(ble_addr_cmp(&ble_gap_test_event.periodic_sync.adv_addr,
+                             &ble_gap_test_periodic_addr) == 0);
+    TEST_ASSERT(ble_gap_test_event.periodic_sync.adv_phy == BLE_HCI_LE_PHY_2M);
+    TEST_ASSERT(ble_gap_test_event.periodic_sync.per_adv_ival == 0x0050);
+    TEST_ASSERT(ble_gap_test_event.periodic_sync.adv_clk_accuracy == 4);
+
+#if MYNEWT_VAL(BLE_MAX_PERIODIC_SYNCS) == 1
+    /* No room for another sync. */
+    rc = ble_gap_periodic_adv_sync_create(&ble_gap_test_periodic_addr, 6,
+                                          &ble_gap_test_periodic_sync_params,
+                                          ble_gap_test_util_periodic_cb, NULL);
+    TEST_ASSERT(rc == BLE_HS_ENOMEM);
+#endif
+    ble_hs_test_util_hci_out_clear();
+
+    /*** Reports. */
+    ble_gap_test_util_periodic_rx_rpt(0x0010, data, sizeof data);
+    TEST_ASSERT(ble_gap_test_periodic_event_cnt == 3);
+    TEST_ASSERT(ble_gap_test_event.type == BLE_GAP_EVENT_PERIODIC_REPORT);
+    TEST_ASSERT(ble_gap_test_event.periodic_report.sync_handle == 0x0010);
+    TEST_ASSERT(ble_gap_test_event.periodic_report.tx_power == -4);
+    TEST_ASSERT(ble_gap_test_event.periodic_report.rssi == -60);
+    TEST_ASSERT(ble_gap_test_event.periodic_report.data_status ==
+                BLE_HCI_PER_ADV_DATA_STATUS_COMPLETE);
+    TEST_ASSERT(ble_gap_test_event.periodic_report.data_length ==
+                sizeof data);
+    TEST_ASSERT(memcmp(ble_gap_test_periodic_rpt_data, data,
+                       sizeof data) == 0);
+
+    /* Empty report. */
+    ble_gap_test_util_periodic_rx_rpt(0x0010, NULL, 0);
+    TEST_ASSERT(ble_gap_test_periodic_event_cnt == 4);
+    TEST_ASSERT(ble_gap_test_event.periodic_report.data_length == 0);
+
+    /* Report for an unknown sync. */
+    ble_gap_test_util_periodic_rx_rpt(0x0011, data, sizeof data);
+    TEST_ASSERT(ble_gap_test_periodic_event_cnt == 4);
+
+    /*** Sync lost. */
+    ble_hs_test_util_hci_rx_periodic_sync_lost_evt(0x0011);
+    TEST_ASSERT(ble_gap_test_periodic_event_cnt == 4);
+
+    ble_hs_test_util_hci_rx_periodic_sync_lost_evt(0x0010);
+    TEST_ASSERT(ble_gap_test_periodic_event_cnt == 5);
+    TEST_ASSERT(ble_gap_test_event.type == BLE_GAP_EVENT_PERIODIC_SYNC_LOST);
+    TEST_ASSERT(ble_gap_test_event.periodic_sync_lost.sync_handle == 0x0010);
+    TEST_ASSERT(ble_gap_test_event.periodic_sync_lost.reason ==
+                BLE_HS_ETIMEOUT);
+
+    /* The sync is gone. */
+    ble_gap_test_util_periodic_rx_rpt(0x0010, data, sizeof data);
+    ble_hs_test_util_hci_rx_periodic_sync_lost_evt(0x0010);
+    TEST_ASSERT(ble_gap_test_periodic_event_cnt == 5);
+    TEST_ASSERT(ble_gap_periodic_adv_sync_terminate(0x0010) ==
+                BLE_HS_ENOTCONN);
+}
+
+TEST_CASE(ble_gap_test_case_periodic_sync_terminate)
+{
+    uint8_t param_len;
+    uint8_t *param;
+    int rc;
+
+    ble_gap_test_util_periodic_init();
+
+    rc = ble_gap_periodic_adv_sync_terminate(0x0010);
+    TEST_ASSERT(rc == BLE_HS_ENOTCONN);
+
+    ble_gap_test_util_periodic_sync_create();
+    ble_gap_test_util_periodic_rx_sync_estab(0, 0x0010);
+    TEST_ASSERT(ble_gap_test_periodic_event_cnt == 1);
+    ble_hs_test_util_hci_out_clear();
+
+    /*** Controller failure keeps the sync. */
+    ble_hs_test_util_hci_ack_set(
+        BLE_HCI_OP(BLE_HCI_OGF_LE, BLE_HCI_OCF_LE_PER_ADV_TERM_SYNC),
+        BLE_ERR_UNK_ADV_INDENT);
+    rc = ble_gap_periodic_adv_sync_terminate(0x0010);
+    TEST_ASSERT(rc == BLE_HS_HCI_ERR(BLE_ERR_UNK_ADV_INDENT));
+    TEST_ASSERT(ble_gap_test_periodic_event_cnt == 1);
+    ble_hs_test_util_hci_out_clear();
+
+    /*** Success; reported as a locally terminated sync. */
+    ble_hs_test_util_hci_ack_set(
+        BLE_HCI_OP(BLE_HCI_OGF_LE, BLE_HCI_OCF_LE_PER_ADV_TERM_SYNC), 0);
+    rc = ble_gap_periodic_adv_sync_terminate(0x0010);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    param = ble_hs_test_util_hci_verify_tx(BLE_HCI_OGF_LE,
+                                           BLE_HCI_OCF_LE_PER_ADV_TERM_SYNC,
+                                           &param_len);
+    TEST_ASSERT(param_len == BLE_HCI_LE_PER_ADV_TERM_SYNC_LEN);
+    TEST_ASSERT(get_le16(param) == 0x0010);
+
+    TEST_ASSERT(ble_gap_test_periodic_event_cnt == 2);
+    TEST_ASSERT(ble_gap_test_event.type == BLE_GAP_EVENT_PERIODIC_SYNC_LOST);
+    TEST_ASSERT(ble_gap_test_event.periodic_sync_lost.sync_handle == 0x0010);
+    TEST_ASSERT(ble_gap_test_event.periodic_sync_lost.reason == BLE_HS_EDONE);
+
+    rc = ble_gap_periodic_adv_sync_terminate(0x0010);
+    TEST_ASSERT(rc == BLE_HS_ENOTCONN);
+
+    /* A late sync lost event for the same handle is dropped. */
+    ble_hs_test_util_hci_rx_periodic_sync_lost_evt(0x0010);
+    TEST_ASSERT(ble_gap_test_periodic_event_cnt == 2);
+}
+
+TEST_SUITE(ble_gap_test_suite_periodic)
+{
+    tu_suite_set_post_test_cb(ble_hs_test_util_post_test, NULL);
+
+    ble_gap_test_case_periodic_adv_configure();
+    ble_gap_test_case_periodic_adv_start_stop();
+    ble_gap_test_case_periodic_adv_data();
+    ble_gap_test_case_periodic_sync_create();
+    ble_gap_test_case_periodic_sync_events();
+    ble_gap_test_case_periodic_sync_terminate();
+}
+#endif
+
 /*****************************************************************************
  * $all                                                                      *
  *****************************************************************************/
@@ -3151,6 +4332,9 @@ ble_gap_test_all(void)
     ble_gap_test_suite_timeout();
     ble_gap_test_suite_mtu();
     ble_gap_test_suite_set_cb();
+#if MYNEWT_VAL(BLE_PERIODIC_ADV)
+    ble_gap_test_suite_periodic();
+#endif
 
     return tu_any_failed;
 }
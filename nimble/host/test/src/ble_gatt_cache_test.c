@@ -0,0 +1,400 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include <errno.h>
+#include "testutil/testutil.h"
+#include "nimble/ble.h"
+#include "host/ble_hs_test.h"
+#include "host/ble_uuid.h"
+#include "ble_hs_test_util.h"
+
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+
+#define BLE_GATT_CACHE_TEST_MAX_ATTRS   8
+
+static const uint8_t ble_gatt_cache_test_peer_addr[6] = {2,3,4,5,6,7};
+
+static struct ble_gatt_svc
+    ble_gatt_cache_test_svc_results[BLE_GATT_CACHE_TEST_MAX_ATTRS];
+static int ble_gatt_cache_test_num_svcs;
+static struct ble_gatt_chr
+    ble_gatt_cache_test_chr_results[BLE_GATT_CACHE_TEST_MAX_ATTRS];
+static int ble_gatt_cache_test_num_chrs;
+static int ble_gatt_cache_test_done;
+
+static void
+ble_gatt_cache_test_set_secured(int secured)
+{
+    struct ble_hs_conn *conn;
+
+    ble_hs_lock();
+
+    conn = ble_hs_conn_find(2);
+    TEST_ASSERT_FATAL(conn != NULL);
+    conn->bhc_sec_state.encrypted = secured;
+    conn->bhc_sec_state.bonded = secured;
+
+    ble_hs_unlock();
+}
+
+static void
+ble_gatt_cache_test_init(int bonded)
+{
+    struct ble_store_value_sec value_sec;
+    int rc;
+
+    ble_hs_test_util_init();
+
+    ble_hs_test_util_create_conn(2, ble_gatt_cache_test_peer_addr, NULL,
+                                 NULL);
+
+    if (bonded) {
+        memset(&value_sec, 0, sizeof value_sec);
+        value_sec.peer_addr.type = BLE_ADDR_PUBLIC;
+        memcpy(value_sec.peer_addr.val, ble_gatt_cache_test_peer_addr, 6);
+        value_sec.ltk_present = 1;
+
+        rc = ble_store_write_peer_sec(&value_sec);
+        TEST_ASSERT_FATAL(rc == 0);
+
+        ble_gatt_cache_test_set_secured(1);
+    }
+}
+
+static void
+ble_gatt_cache_test_reset_results(void)
+{
+    ble_gatt_cache_test_num_svcs = 0;
+    ble_gatt_cache_test_num_chrs = 0;
+    ble_gatt_cache_test_done = 0;
+}
+
+static int
+ble_gatt_cache_test_svc_cb(uint16_t conn_handle,
+                           const struct ble_gatt_error *error,
+                           const struct ble_gatt_svc *service, void *arg)
+{
+    TEST_ASSERT(conn_handle == 2);
+    TEST_ASSERT(!ble_gatt_cache_test_done);
+
+    switch (error->status) {
+    case 0:
+        TEST_ASSERT_FATAL(ble_gatt_cache_test_num_svcs <
+                          BLE_GATT_CACHE_TEST_MAX_ATTRS);
+        ble_gatt_cache_test_svc_results[ble_gatt_cache_test_num_svcs++] =
+            *service;
+        break;
+
+    case BLE_HS_EDONE:
+        ble_gatt_cache_test_done = 1;
+        break;
+
+    default:
+        TEST_ASSERT(0);
+        break;
+    }
+
+    return 0;
+}
+
+static int
+ble_gatt_cache_test_chr_cb(uint16_t conn_handle,
+                           const struct ble_gatt_error *error,
+                           const struct ble_gatt_chr *chr, void *arg)
+{
+    TEST_ASSERT(conn_handle == 2);
+    TEST_ASSERT(!ble_gatt_cache_test_done);
+
+    switch (error->status) {
+    case 0:
+        TEST_ASSERT_FATAL(ble_gatt_cache_test_num_chrs <
+                          BLE_GATT_CACHE_TEST_MAX_ATTRS);
+        ble_gatt_cache_test_chr_results[ble_gatt_cache_test_num_chrs++] =
+            *chr;
+        break;
+
+    case BLE_HS_EDONE:
+        ble_gatt_cache_test_done = 1;
+        break;
+
+    default:
+        TEST_ASSERT(0);
+        break;
+    }
+
+    return 0;
+}
+
+/**
+ * Responds to a pending read-by-group-type request with two services: the
+ * GAP service (1-5) and the battery service (6-0xffff).
+ */
+static void
+ble_gatt_cache_test_rx_svcs(void)
+{
+    uint8_t buf[2 + 2 * 6];
+    int rc;
+
+    buf[0] = BLE_ATT_OP_READ_GROUP_TYPE_RSP;
+    buf[1] = 6;
+    put_le16(buf + 2, 1);
+    put_le16(buf + 4, 5);
+    put_le16(buf + 6, 0x1800);
+    put_le16(buf + 8, 6);
+    put_le16(buf + 10, 0xffff);
+    put_le16(buf + 12, 0x180f);
+
+    rc = ble_hs_test_util_l2cap_rx_payload_flat(2, BLE_L2CAP_CID_ATT,
+                                                buf, sizeof buf);
+    TEST_ASSERT(rc == 0);
+}
+
+/**
+ * Responds to a pending read-by-type request with a single Service Changed
+ * characteristic (def handle 7, value handle 8), followed by the end of the
+ * characteristic list.
+ */
+static void
+ble_gatt_cache_test_rx_chrs(void)
+{
+    uint8_t buf[2 + 7];
+    int rc;
+
+    buf[0] = BLE_ATT_OP_READ_TYPE_RSP;
+    buf[1] = 7;
+    put_le16(buf + 2, 7);
+    buf[4] = BLE_GATT_CHR_PROP_INDICATE;
+    put_le16(buf + 5, 8);
+    put_le16(buf + 7, 0x2a05);
+
+    rc = ble_hs_test_util_l2cap_rx_payload_flat(2, BLE_L2CAP_CID_ATT,
+                                                buf, sizeof buf);
+    TEST_ASSERT(rc == 0);
+
+    ble_hs_test_util_rx_att_err_rsp(2, BLE_ATT_OP_READ_TYPE_REQ,
+                                    BLE_ATT_ERR_ATTR_NOT_FOUND, 8);
+}
+
+static void
+ble_gatt_cache_test_rx_indicate(uint16_t attr_handle)
+{
+    uint8_t buf[3];
+    int rc;
+
+    buf[0] = BLE_ATT_OP_INDICATE_REQ;
+    put_le16(buf + 1, attr_handle);
+
+    rc = ble_hs_test_util_l2cap_rx_payload_flat(2, BLE_L2CAP_CID_ATT,
+                                                buf, sizeof buf);
+    TEST_ASSERT(rc == 0);
+}
+
+static void
+ble_gatt_cache_test_verify_svcs(void)
+{
+    TEST_ASSERT_FATAL(ble_gatt_cache_test_num_svcs == 2);
+    TEST_ASSERT(ble_gatt_cache_test_svc_results[0].start_handle == 1);
+    TEST_ASSERT(ble_gatt_cache_test_svc_results[0].end_handle == 5);
+    TEST_ASSERT(ble_uuid_cmp(&ble_gatt_cache_test_svc_results[0].uuid.u,
+                             BLE_UUID16_DECLARE(0x1800)) == 0);
+    TEST_ASSERT(ble_gatt_cache_test_svc_results[1].start_handle == 6);
+    TEST_ASSERT(ble_gatt_cache_test_svc_results[1].end_handle == 0xffff);
+    TEST_ASSERT(ble_uuid_cmp(&ble_gatt_cache_test_svc_results[1].uuid.u,
+                             BLE_UUID16_DECLARE(0x180f)) == 0);
+    TEST_ASSERT(ble_gatt_cache_test_done);
+}
+
+/**
+ * Performs a discover all services procedure which must go over the air.
+ */
+static void
+ble_gatt_cache_test_disc_svcs_air(void)
+{
+    int rc;
+
+    ble_gatt_cache_test_reset_results();
+    ble_hs_test_util_prev_tx_queue_clear();
+
+    rc = ble_gattc_disc_all_svcs(2, ble_gatt_cache_test_svc_cb, NULL);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(ble_hs_test_util_prev_tx_dequeue_pullup() != NULL);
+
+    ble_gatt_cache_test_rx_svcs();
+    ble_gatt_cache_test_verify_svcs();
+}
+
+/**
+ * Performs a discover all services procedure which must be answered from the
+ * cache.
+ */
+static void
+ble_gatt_cache_test_disc_svcs_cached(void)
+{
+    int rc;
+
+    ble_gatt_cache_test_reset_results();
+    ble_hs_test_util_prev_tx_queue_clear();
+
+    rc = ble_gattc_disc_all_svcs(2, ble_gatt_cache_test_svc_cb, NULL);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Results are reported asynchronously. */
+    TEST_ASSERT(ble_gatt_cache_test_num_svcs == 0);
+    ble_gattc_timer();
+
+    TEST_ASSERT(ble_hs_test_util_prev_tx_dequeue_pullup() == NULL);
+    ble_gatt_cache_test_verify_svcs();
+    TEST_ASSERT(!ble_gattc_any_jobs());
+}
+
+TEST_CASE(ble_gatt_cache_test_svcs)
+{
+    ble_gatt_cache_test_init(1);
+
+    ble_gatt_cache_test_disc_svcs_air();
+    ble_gatt_cache_test_disc_svcs_cached();
+}
+
+TEST_CASE(ble_gatt_cache_test_unbonded)
+{
+    ble_gatt_cache_test_init(0);
+
+    /* Discovery results of an unbonded peer are never cached. */
+    ble_gatt_cache_test_disc_svcs_air();
+    ble_gatt_cache_test_disc_svcs_air();
+}
+
+TEST_CASE(ble_gatt_cache_test_unencrypted)
+{
+    ble_gatt_cache_test_init(1);
+
+    ble_gatt_cache_test_disc_svcs_air();
+
+    /* Until the link is encrypted with the bond again, the peer may still
+     * have a Service Changed indication pending; the cache is bypassed.
+     */
+    ble_gatt_cache_test_set_secured(0);
+    ble_gatt_cache_test_disc_svcs_air();
+
+    ble_gatt_cache_test_set_secured(1);
+    ble_gatt_cache_test_disc_svcs_cached();
+}
+
+TEST_CASE(ble_gatt_cache_test_svc_changed)
+{
+    int rc;
+
+    ble_gatt_cache_test_init(1);
+
+    ble_gatt_cache_test_disc_svcs_air();
+
+    /* Discover the characteristics of the second service. */
+    ble_gatt_cache_test_reset_results();
+    rc = ble_gattc_disc_all_chrs(2, 6, 0xffff, ble_gatt_cache_test_chr_cb,
+                                 NULL);
+    TEST_ASSERT_FATAL(rc == 0);
+    ble_gatt_cache_test_rx_chrs();
+    TEST_ASSERT(ble_gatt_cache_test_num_chrs == 1);
+    TEST_ASSERT(ble_gatt_cache_test_done);
+
+    /* Repeat from the cache. */
+    ble_gatt_cache_test_reset_results();
+    ble_hs_test_util_prev_tx_queue_clear();
+    rc = ble_gattc_disc_all_chrs(2, 6, 0xffff, ble_gatt_cache_test_chr_cb,
+                                 NULL);
+    TEST_ASSERT_FATAL(rc == 0);
+    ble_gattc_timer();
+    TEST_ASSERT(ble_hs_test_util_prev_tx_dequeue_pullup() == NULL);
+    TEST_ASSERT_FATAL(ble_gatt_cache_test_num_chrs == 1);
+    TEST_ASSERT(ble_gatt_cache_test_chr_results[0].def_handle == 7);
+    TEST_ASSERT(ble_gatt_cache_test_chr_results[0].val_handle == 8);
+    TEST_ASSERT(ble_gatt_cache_test_chr_results[0].properties ==
+                BLE_GATT_CHR_PROP_INDICATE);
+    TEST_ASSERT(ble_uuid_cmp(&ble_gatt_cache_test_chr_results[0].uuid.u,
+                             BLE_UUID16_DECLARE(0x2a05)) == 0);
+    TEST_ASSERT(ble_gatt_cache_test_done);
+
+    /* An indication of another characteristic leaves the cache intact. */
+    ble_gatt_cache_test_rx_indicate(3);
+    ble_gatt_cache_test_disc_svcs_cached();
+
+    /* A Service Changed indication invalidates the cache. */
+    ble_gatt_cache_test_rx_indicate(8);
+    ble_gatt_cache_test_disc_svcs_air();
+}
+
+TEST_CASE(ble_gatt_cache_test_overflow)
+{
+    struct ble_store_value_gatt_cache value;
+    int rc;
+    int i;
+
+    ble_gatt_cache_test_init(1);
+
+    /* Fill the store with records of another peer, leaving room for only
+     * one of the two services.
+     */
+    memset(&value, 0, sizeof value);
+    value.peer_addr.type = BLE_ADDR_RANDOM;
+    memcpy(value.peer_addr.val, (uint8_t[6]){ 1, 1, 1, 1, 1, 0xc1 }, 6);
+    value.type = BLE_STORE_GATT_CACHE_DSC;
+    for (i = 1; i < MYNEWT_VAL(BLE_STORE_MAX_GATT_CACHE); i++) {
+        value.handle = i;
+        rc = ble_store_write_gatt_cache(&value);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    /* The procedure completes over the air despite the full store, but the
+     * service list is not marked as cached.
+     */
+    ble_gatt_cache_test_disc_svcs_air();
+    TEST_ASSERT(ble_gattc_cache_svcs_cached(2) == BLE_HS_ENOENT);
+    ble_gatt_cache_test_disc_svcs_air();
+
+    /* Once there is room again, the next procedure fills the cache. */
+    rc = ble_gattc_cache_clear(&value.peer_addr);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    ble_gatt_cache_test_disc_svcs_air();
+    ble_gatt_cache_test_disc_svcs_cached();
+}
+
+TEST_SUITE(ble_gatt_cache_test_suite)
+{
+    tu_suite_set_post_test_cb(ble_hs_test_util_post_test, NULL);
+
+    ble_gatt_cache_test_svcs();
+    ble_gatt_cache_test_unbonded();
+    ble_gatt_cache_test_unencrypted();
+    ble_gatt_cache_test_svc_changed();
+    ble_gatt_cache_test_overflow();
+}
+
+#endif
+
+int
+ble_gatt_cache_test_all(void)
+{
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    ble_gatt_cache_test_suite();
+#endif
+
+    return tu_any_failed;
+}
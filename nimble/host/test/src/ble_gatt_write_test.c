@@ -386,6 +386,77 @@ TEST_CASE(ble_gatt_write_test_no_rsp)
     TEST_ASSERT(!ble_gatt_write_test_cb_called);
 }
 
+static int ble_gatt_write_test_tx_ready;
+
+static int
+ble_gatt_write_test_gap_cb(struct ble_gap_event *event, void *arg)
+{
+    if (event->type == BLE_GAP_EVENT_TX_READY) {
+        TEST_ASSERT(event->tx_ready.conn_handle == 2);
+        ble_gatt_write_test_tx_ready++;
+    }
+
+    return 0;
+}
+
+TEST_CASE(ble_gatt_write_test_no_rsp_stream)
+{
+    struct ble_hs_test_util_hci_num_completed_pkts_entry ncpe[2];
+    struct ble_gattc_stream_stats stats;
+    struct os_mbuf *om;
+    int rc;
+    int i;
+
+    ble_gatt_write_test_init();
+    ble_gatt_write_test_tx_ready = 0;
+
+    /* The controller has room for two packets. */
+    rc = ble_hs_hci_set_buf_sz(64, 2);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    ble_hs_test_util_create_conn(2, ((uint8_t[]){2,3,4,5,6,7,8,9}),
+                                 ble_gatt_write_test_gap_cb, NULL);
+
+    /* Two packets go to the controller, the rest is queued in the host. */
+    for (i = 0; i < MYNEWT_VAL(BLE_GATT_WRITE_NO_RSP_MAX_PENDING); i++) {
+        om = ble_hs_mbuf_from_flat(ble_gatt_write_test_attr_value, 10);
+        TEST_ASSERT_FATAL(om != NULL);
+        rc = ble_gattc_write_no_rsp_stream(2, 100, om);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    /* The queue is full; the mbuf is handed back. */
+    om = ble_hs_mbuf_from_flat(ble_gatt_write_test_attr_value, 10);
+    TEST_ASSERT_FATAL(om != NULL);
+    rc = ble_gattc_write_no_rsp_stream(2, 100, om);
+    TEST_ASSERT(rc == BLE_HS_EBUSY);
+
+    /* Nothing to report until a packet completes. */
+    TEST_ASSERT(ble_gatt_write_test_tx_ready == 0);
+
+    memset(ncpe, 0, sizeof ncpe);
+    ncpe[0].handle_id = 2;
+    ncpe[0].num_pkts = 1;
+    ble_hs_test_util_hci_rx_num_completed_pkts_event(ncpe);
+    TEST_ASSERT(ble_gatt_write_test_tx_ready == 1);
+
+    rc = ble_gattc_write_no_rsp_stream(2, 100, om);
+    TEST_ASSERT(rc == 0);
+
+    /* No event if nobody was refused. */
+    ble_hs_test_util_hci_rx_num_completed_pkts_event(ncpe);
+    TEST_ASSERT(ble_gatt_write_test_tx_ready == 1);
+
+    rc = ble_gattc_write_no_rsp_stream_stats(2, &stats);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(stats.pdus == MYNEWT_VAL(BLE_GATT_WRITE_NO_RSP_MAX_PENDING) + 1);
+    TEST_ASSERT(stats.bytes == stats.pdus * 10);
+    TEST_ASSERT(stats.busy == 1);
+
+    ble_hs_test_util_prev_tx_queue_clear();
+    ble_hs_test_util_conn_disconnect(2);
+}
+
 TEST_CASE(ble_gatt_write_test_rsp)
 {
     int attr_len;
@@ -799,6 +870,7 @@ TEST_SUITE(ble_gatt_write_test_suite)
     tu_suite_set_post_test_cb(ble_hs_test_util_post_test, NULL);
 
     ble_gatt_write_test_no_rsp();
+    ble_gatt_write_test_no_rsp_stream();
     ble_gatt_write_test_rsp();
     ble_gatt_write_test_long_good();
     ble_gatt_write_test_long_bad_handle();
@@ -25,6 +25,7 @@
 #include "host/ble_hs_adv.h"
 #include "host/ble_hs_test.h"
 #include "ble_hs_test_util.h"
+#include "ble_hs_adv_priv.h"
 
 #define BLE_ADV_TEST_DATA_OFF   4
 
@@ -1263,6 +1264,122 @@ TEST_CASE(ble_hs_adv_test_case_user_full_payload)
     TEST_ASSERT(rc == BLE_HS_EMSGSIZE);
 }
 
+TEST_CASE(ble_hs_adv_test_case_idx)
+{
+    static const uint8_t data[] = {
+        /* Flags. */
+        0x02, BLE_HS_ADV_TYPE_FLAGS, BLE_HS_ADV_F_DISC_GEN,
+        /* Incomplete list of 16-bit UUIDs: 0x180d, 0x180f. */
+        0x05, BLE_HS_ADV_TYPE_INCOMP_UUIDS16, 0x0d, 0x18, 0x0f, 0x18,
+        /* Complete list of 128-bit UUIDs. */
+        0x11, BLE_HS_ADV_TYPE_COMP_UUIDS128,
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+        0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+        /* Manufacturer data: company 0x0059, payload 0xaa 0xbb. */
+        0x05, BLE_HS_ADV_TYPE_MFG_DATA, 0x59, 0x00, 0xaa, 0xbb,
+        /* Early termination; the rest is padding. */
+        0x00, 0xff, 0xff,
+    };
+    static const ble_uuid128_t uuid128 = BLE_UUID128_INIT(
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+        0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f);
+    const struct ble_hs_adv_field *expected;
+    const struct ble_hs_adv_field *field;
+    struct ble_hs_adv_idx idx;
+    static const uint8_t multi[] = {
+        /* Two manufacturer data and two incomplete UUID16 lists. */
+        0x03, BLE_HS_ADV_TYPE_MFG_DATA, 0x4c, 0x00,
+        0x03, BLE_HS_ADV_TYPE_INCOMP_UUIDS16, 0x0d, 0x18,
+        0x05, BLE_HS_ADV_TYPE_MFG_DATA, 0x59, 0x00, 0xaa, 0xbb,
+        0x03, BLE_HS_ADV_TYPE_COMP_UUIDS16, 0x0f, 0x18,
+        0x03, BLE_HS_ADV_TYPE_INCOMP_UUIDS16, 0x10, 0x18,
+    };
+    uint8_t many[2 * BLE_HS_ADV_IDX_MAX_FIELDS + 4];
+    int type;
+    int rc;
+    int i;
+
+    rc = ble_hs_adv_idx_build(&idx, data, sizeof data);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(idx.num_fields == 4);
+
+    /* Lookups agree with a walk of the data and point into it. */
+    for (type = 0; type <= 0xff; type++) {
+        rc = ble_hs_adv_idx_find(&idx, type, &field);
+        if (ble_hs_adv_find_field(type, data, 33, &expected) == 0) {
+            TEST_ASSERT(rc == 0);
+            TEST_ASSERT(field == expected);
+        } else {
+            TEST_ASSERT(rc == BLE_HS_ENOENT);
+        }
+    }
+
+    TEST_ASSERT(ble_hs_adv_idx_has_uuid(&idx, BLE_UUID16_DECLARE(0x180d)));
+    TEST_ASSERT(ble_hs_adv_idx_has_uuid(&idx, BLE_UUID16_DECLARE(0x180f)));
+    TEST_ASSERT(!ble_hs_adv_idx_has_uuid(&idx, BLE_UUID16_DECLARE(0x1810)));
+    TEST_ASSERT(!ble_hs_adv_idx_has_uuid(&idx,
+                                         BLE_UUID32_DECLARE(0x0000180d)));
+    TEST_ASSERT(ble_hs_adv_idx_has_uuid(&idx, &uuid128.u));
+
+    TEST_ASSERT(ble_hs_adv_idx_mfg_match(&idx, 0x0059, NULL, 0));
+    TEST_ASSERT(ble_hs_adv_idx_mfg_match(&idx, 0x0059,
+                                         ((uint8_t[]){ 0xaa }), 1));
+    TEST_ASSERT(!ble_hs_adv_idx_mfg_match(&idx, 0x0059,
+                                          ((uint8_t[]){ 0xbb }), 1));
+    TEST_ASSERT(!ble_hs_adv_idx_mfg_match(&idx, 0x0059,
+                                          ((uint8_t[]){ 0xaa, 0xbb, 0 }), 3));
+    TEST_ASSERT(!ble_hs_adv_idx_mfg_match(&idx, 0x004c, NULL, 0));
+
+    /* Structure overruns the data. */
+    rc = ble_hs_adv_idx_build(&idx, data, 5);
+    TEST_ASSERT(rc == BLE_HS_EBADDATA);
+
+    /* Lone length byte at the end. */
+    rc = ble_hs_adv_idx_build(&idx, ((uint8_t[]){ 0x02, 0x01, 0x06, 0x05 }),
+                              4);
+    TEST_ASSERT(rc == BLE_HS_EBADDATA);
+
+    /* Every structure of a type is searched, not just the first. */
+    rc = ble_hs_adv_idx_build(&idx, multi, sizeof multi);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(idx.num_fields == 5);
+
+    rc = ble_hs_adv_idx_find(&idx, BLE_HS_ADV_TYPE_MFG_DATA, &field);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(field == (const void *)multi);
+
+    TEST_ASSERT(ble_hs_adv_idx_mfg_match(&idx, 0x004c, NULL, 0));
+    TEST_ASSERT(ble_hs_adv_idx_mfg_match(&idx, 0x0059,
+                                         ((uint8_t[]){ 0xaa }), 1));
+    TEST_ASSERT(ble_hs_adv_idx_has_uuid(&idx, BLE_UUID16_DECLARE(0x180d)));
+    TEST_ASSERT(ble_hs_adv_idx_has_uuid(&idx, BLE_UUID16_DECLARE(0x180f)));
+    TEST_ASSERT(ble_hs_adv_idx_has_uuid(&idx, BLE_UUID16_DECLARE(0x1810)));
+    TEST_ASSERT(!ble_hs_adv_idx_has_uuid(&idx, BLE_UUID16_DECLARE(0x1811)));
+
+    /* Structures past the index capacity are still found. */
+    for (i = 0; i < 2 * BLE_HS_ADV_IDX_MAX_FIELDS; i += 2) {
+        many[i] = 1;
+        many[i + 1] = BLE_HS_ADV_TYPE_URI;
+    }
+    many[i] = 3;
+    many[i + 1] = BLE_HS_ADV_TYPE_MFG_DATA;
+    many[i + 2] = 0x59;
+    many[i + 3] = 0x00;
+
+    rc = ble_hs_adv_idx_build(&idx, many, sizeof many);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(idx.num_fields == BLE_HS_ADV_IDX_MAX_FIELDS);
+    TEST_ASSERT(ble_hs_adv_idx_mfg_match(&idx, 0x0059, NULL, 0));
+
+    rc = ble_hs_adv_idx_find(&idx, BLE_HS_ADV_TYPE_MFG_DATA, &field);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(field == (const void *)(many + i));
+
+    /* An overrun past the index capacity is still detected. */
+    rc = ble_hs_adv_idx_build(&idx, many, sizeof many - 1);
+    TEST_ASSERT(rc == BLE_HS_EBADDATA);
+}
+
 TEST_SUITE(ble_hs_adv_test_suite)
 {
     tu_suite_set_post_test_cb(ble_hs_test_util_post_test, NULL);
@@ -1270,6 +1387,7 @@ TEST_SUITE(ble_hs_adv_test_suite)
     ble_hs_adv_test_case_user();
     ble_hs_adv_test_case_user_rsp();
     ble_hs_adv_test_case_user_full_payload();
+    ble_hs_adv_test_case_idx();
 }
 
 int
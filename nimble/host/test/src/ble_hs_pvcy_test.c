@@ -239,6 +239,53 @@ TEST_CASE(ble_hs_pvcy_test_case_restore_irks)
                                             ble_hs_pvcy_default_irk);
 }
 
+TEST_CASE(ble_hs_pvcy_test_case_restore_irks_diff)
+{
+    struct ble_store_value_sec value_sec1;
+    struct ble_store_value_sec value_sec2;
+    union ble_store_key key;
+    int rc;
+
+    ble_hs_pvcy_test_util_init();
+    ble_hs_pvcy_test_util_start_host(0);
+
+    value_sec1 = (struct ble_store_value_sec) {
+        .peer_addr = { BLE_ADDR_PUBLIC, { 1, 2, 3, 4, 5, 6 } },
+        .key_size = 16,
+        .irk = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 },
+        .irk_present = 1,
+    };
+    ble_hs_pvcy_test_util_restore_irk(&value_sec1);
+
+    value_sec2 = (struct ble_store_value_sec) {
+        .peer_addr = { BLE_ADDR_RANDOM, { 2, 3, 4, 5, 6, 0xc7 } },
+        .key_size = 16,
+        .irk = { 4, 4, 4, 4, 5, 5, 5, 6, 6, 6, 9, 9, 9, 9, 9, 10 },
+        .irk_present = 1,
+    };
+    ble_hs_pvcy_test_util_restore_irk(&value_sec2);
+    ble_hs_test_util_hci_out_clear();
+
+    /*** Restoring while the controller has every entry sends nothing. */
+    rc = ble_hs_misc_restore_irks();
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(ble_hs_test_util_hci_out_first() == NULL);
+
+    /*** Entries of deleted bonds are removed from the controller. */
+    memset(&key, 0, sizeof key);
+    key.sec.peer_addr = value_sec1.peer_addr;
+    rc = ble_store_delete(BLE_STORE_OBJ_TYPE_PEER_SEC, &key);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    ble_hs_test_util_hci_ack_set(
+        BLE_HS_TEST_UTIL_LE_OPCODE(BLE_HCI_OCF_LE_RMV_RESOLV_LIST), 0);
+    rc = ble_hs_misc_restore_irks();
+    TEST_ASSERT_FATAL(rc == 0);
+    ble_hs_test_util_hci_verify_tx(BLE_HCI_OGF_LE,
+                                   BLE_HCI_OCF_LE_RMV_RESOLV_LIST, NULL);
+    TEST_ASSERT(ble_hs_test_util_hci_out_first() == NULL);
+}
+
 /** No active GAP procedures. */
 TEST_CASE(ble_hs_pvcy_test_case_add_irk_idle)
 {
@@ -455,6 +502,7 @@ TEST_SUITE(ble_hs_pvcy_test_suite_irk)
     tu_suite_set_post_test_cb(ble_hs_test_util_post_test, NULL);
 
     ble_hs_pvcy_test_case_restore_irks();
+    ble_hs_pvcy_test_case_restore_irks_diff();
     ble_hs_pvcy_test_case_add_irk_idle();
     ble_hs_pvcy_test_case_add_irk_adv();
     ble_hs_pvcy_test_case_add_irk_disc();
@@ -32,9 +32,11 @@ main(int argc, char **argv)
 {
     sysinit();
 
+    ble_aes_test_all();
     ble_att_clt_test_all();
     ble_att_svr_test_all();
     ble_gap_test_all();
+    ble_gatt_cache_test_all();
     ble_gatt_conn_test_all();
     ble_gatt_disc_c_test_all();
     ble_gatt_disc_d_test_all();
@@ -51,6 +53,8 @@ main(int argc, char **argv)
     ble_hs_id_test_all();
     ble_hs_pvcy_test_all();
     ble_l2cap_test_all();
+    /* Runs after the L2CAP tests, which expect the first CoC CIDs. */
+    ble_eatt_test_all();
     ble_os_test_all();
     ble_sm_test_all();
     ble_store_test_all();
@@ -584,6 +584,63 @@ ble_hs_test_util_hci_rx_conn_cancel_evt(void)
     TEST_ASSERT_FATAL(rc == 0);
 }
 
+void
+ble_hs_test_util_hci_rx_periodic_sync_estab_evt(
+    const struct hci_le_subev_periodic_adv_sync_estab *evt)
+{
+    uint8_t buf[BLE_HCI_EVENT_HDR_LEN + BLE_HCI_LE_SUBEV_PER_ADV_SYNC_ESTAB_LEN];
+
+    buf[0] = BLE_HCI_EVCODE_LE_META;
+    buf[1] = BLE_HCI_LE_SUBEV_PER_ADV_SYNC_ESTAB_LEN;
+    buf[2] = BLE_HCI_LE_SUBEV_PER_ADV_SYNC_ESTAB;
+    buf[3] = evt->status;
+    put_le16(buf + 4, evt->sync_handle);
+    buf[6] = evt->sid;
+    buf[7] = evt->adv_addr_type;
+    memcpy(buf + 8, evt->adv_addr, BLE_DEV_ADDR_LEN);
+    buf[14] = evt->adv_phy;
+    put_le16(buf + 15, evt->per_adv_ival);
+    buf[17] = evt->adv_clk_accuracy;
+
+    ble_hs_test_util_hci_rx_evt(buf);
+}
+
+void
+ble_hs_test_util_hci_rx_periodic_rpt_evt(
+    const struct hci_le_subev_periodic_adv_rpt *evt)
+{
+    uint8_t buf[BLE_HCI_EVENT_HDR_LEN + UINT8_MAX];
+
+    TEST_ASSERT_FATAL(evt->data_length <=
+                      UINT8_MAX - BLE_HCI_LE_SUBEV_PER_ADV_RPT_LEN);
+
+    buf[0] = BLE_HCI_EVCODE_LE_META;
+    buf[1] = BLE_HCI_LE_SUBEV_PER_ADV_RPT_LEN + evt->data_length;
+    buf[2] = BLE_HCI_LE_SUBEV_PER_ADV_RPT;
+    put_le16(buf + 3, evt->sync_handle);
+    buf[5] = evt->tx_power;
+    buf[6] = evt->rssi;
+    buf[7] = evt->unused;
+    buf[8] = evt->data_status;
+    buf[9] = evt->data_length;
+    memcpy(buf + 10, evt->data, evt->data_length);
+
+    ble_hs_test_util_hci_rx_evt(buf);
+}
+
+void
+ble_hs_test_util_hci_rx_periodic_sync_lost_evt(uint16_t sync_handle)
+{
+    uint8_t buf[BLE_HCI_EVENT_HDR_LEN + BLE_HCI_LE_SUBEV_PER_ADV_SYNC_LOST_LEN];
+
+    buf[0] = BLE_HCI_EVCODE_LE_META;
+    buf[1] = BLE_HCI_LE_SUBEV_PER_ADV_SYNC_LOST_LEN;
+    buf[2] = BLE_HCI_LE_SUBEV_PER_ADV_SYNC_LOST;
+    put_le16(buf + 3, sync_handle);
+
+    ble_hs_test_util_hci_rx_evt(buf);
+}
+
 /*****************************************************************************
  * $misc                                                                     *
  *****************************************************************************/
@@ -92,6 +92,11 @@ void ble_hs_test_util_hci_rx_num_completed_pkts_event(
 void ble_hs_test_util_hci_rx_disconn_complete_event(
     struct hci_disconn_complete *evt);
 void ble_hs_test_util_hci_rx_conn_cancel_evt(void);
+void ble_hs_test_util_hci_rx_periodic_sync_estab_evt(
+    const struct hci_le_subev_periodic_adv_sync_estab *evt);
+void ble_hs_test_util_hci_rx_periodic_rpt_evt(
+    const struct hci_le_subev_periodic_adv_rpt *evt);
+void ble_hs_test_util_hci_rx_periodic_sync_lost_evt(uint16_t sync_handle);
 
 /* $misc */
 int ble_hs_test_util_hci_misc_exp_status(int cmd_idx, int fail_idx,
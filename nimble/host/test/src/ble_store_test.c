@@ -345,6 +345,122 @@ TEST_CASE(ble_store_test_overflow)
     ble_store_test_util_overflow_sec(1);
 }
 
+static struct ble_store_value_cccd ble_store_test_iter_cccds[8];
+static int ble_store_test_num_iter_cccds;
+
+static int
+ble_store_test_util_iter_cccd(int obj_type, union ble_store_value *val,
+                              void *cookie)
+{
+    TEST_ASSERT(obj_type == BLE_STORE_OBJ_TYPE_CCCD);
+    TEST_ASSERT_FATAL(ble_store_test_num_iter_cccds <
+                      sizeof ble_store_test_iter_cccds /
+                      sizeof ble_store_test_iter_cccds[0]);
+
+    ble_store_test_iter_cccds[ble_store_test_num_iter_cccds++] = val->cccd;
+    return 0;
+}
+
+/**
+ * Iterates all CCCDs matching the specified peer address and characteristic
+ * handle and returns the number of records visited.
+ */
+static int
+ble_store_test_util_iter_cccds(const ble_addr_t *peer_addr,
+                               uint16_t chr_val_handle)
+{
+    union ble_store_key key;
+    int rc;
+
+    memset(&key, 0, sizeof key);
+    key.cccd.peer_addr = *peer_addr;
+    key.cccd.chr_val_handle = chr_val_handle;
+
+    ble_store_test_num_iter_cccds = 0;
+    rc = ble_store_iterate_key(BLE_STORE_OBJ_TYPE_CCCD, &key,
+                               ble_store_test_util_iter_cccd, NULL);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    return ble_store_test_num_iter_cccds;
+}
+
+TEST_CASE(ble_store_test_iterate_cccd)
+{
+    static const ble_addr_t peers[3] = {
+        { BLE_ADDR_PUBLIC, { 3, 3, 3, 3, 3, 3 } },
+        { BLE_ADDR_PUBLIC, { 1, 1, 1, 1, 1, 1 } },
+        { BLE_ADDR_RANDOM, { 2, 2, 2, 2, 2, 2 } },
+    };
+    struct ble_store_value_cccd value;
+    struct ble_store_key_cccd key;
+    int rc;
+    int i;
+    int j;
+
+    ble_hs_test_util_init();
+
+    /* Write the records out of key order. */
+    for (i = 0; i < 2; i++) {
+        for (j = 0; j < 3; j++) {
+            memset(&value, 0, sizeof value);
+            value.peer_addr = peers[j];
+            value.chr_val_handle = 0x20 - i * 0x10;
+            value.flags = j + 1;
+
+            rc = ble_store_write_cccd(&value);
+            TEST_ASSERT_FATAL(rc == 0);
+        }
+    }
+
+    TEST_ASSERT(ble_store_test_util_iter_cccds(BLE_ADDR_ANY, 0) == 6);
+
+    /* All records of one characteristic. */
+    TEST_ASSERT(ble_store_test_util_iter_cccds(BLE_ADDR_ANY, 0x10) == 3);
+    for (i = 0; i < 3; i++) {
+        TEST_ASSERT(ble_store_test_iter_cccds[i].chr_val_handle == 0x10);
+    }
+
+    /* All records of one peer, in handle order. */
+    TEST_ASSERT_FATAL(ble_store_test_util_iter_cccds(peers + 2, 0) == 2);
+    TEST_ASSERT(ble_store_test_iter_cccds[0].chr_val_handle == 0x10);
+    TEST_ASSERT(ble_store_test_iter_cccds[1].chr_val_handle == 0x20);
+    for (i = 0; i < 2; i++) {
+        TEST_ASSERT(ble_addr_cmp(&ble_store_test_iter_cccds[i].peer_addr,
+                                 peers + 2) == 0);
+        TEST_ASSERT(ble_store_test_iter_cccds[i].flags == 3);
+    }
+
+    /* Rewriting a record in place does not duplicate it. */
+    value.peer_addr = peers[1];
+    value.chr_val_handle = 0x20;
+    value.flags = 7;
+    rc = ble_store_write_cccd(&value);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT_FATAL(ble_store_test_util_iter_cccds(peers + 1, 0x20) == 1);
+    TEST_ASSERT(ble_store_test_iter_cccds[0].flags == 7);
+
+    /* Lookups remain correct after records move down. */
+    memset(&key, 0, sizeof key);
+    key.peer_addr = peers[0];
+    key.chr_val_handle = 0x20;
+    rc = ble_store_delete_cccd(&key);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    TEST_ASSERT(ble_store_test_util_iter_cccds(BLE_ADDR_ANY, 0) == 5);
+    TEST_ASSERT(ble_store_test_util_iter_cccds(peers + 0, 0) == 1);
+    TEST_ASSERT(ble_store_test_util_iter_cccds(peers + 0, 0x20) == 0);
+    for (i = 1; i < 3; i++) {
+        TEST_ASSERT(ble_store_test_util_iter_cccds(peers + i, 0) == 2);
+
+        key.peer_addr = peers[i];
+        key.chr_val_handle = 0x10;
+        key.idx = 0;
+        rc = ble_store_read_cccd(&key, &value);
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT(value.flags == i + 1);
+    }
+}
+
 TEST_CASE(ble_store_test_clear)
 {
     const struct ble_store_value_sec secs[2] = {
@@ -423,6 +539,7 @@ TEST_SUITE(ble_store_suite)
     ble_store_test_delete_peer();
     ble_store_test_count();
     ble_store_test_overflow();
+    ble_store_test_iterate_cccd();
     ble_store_test_clear();
 }
 
@@ -0,0 +1,122 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_BLE_AES_
+#define H_BLE_AES_
+
+/**
+ * AES-128 and AES-CMAC shared by the host (SM, mesh) and the controller.
+ *
+ * The block cipher is provided by one of several backends:
+ *     o tinycrypt       - Byte oriented reference implementation (default).
+ *     o table           - 32-bit T-table implementation (BLE_AES_TABLE).
+ *     o AES-NI          - x86-64 AES instructions, used only if the CPU
+ *                         supports them (BLE_AES_NI).
+ *
+ * The fastest compiled-in backend is selected on first use.  An expanded key
+ * is only valid for the backend that expanded it, so a different backend may
+ * only be selected before any keys are in use (e.g., by tests).
+ *
+ * All keys and blocks are in the byte order of FIPS-197, i.e., the first byte
+ * is the most significant one.
+ */
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BLE_AES_BACKEND_TINYCRYPT       0
+#define BLE_AES_BACKEND_TABLE           1
+#define BLE_AES_BACKEND_NI              2
+#define BLE_AES_BACKEND_CNT             3
+
+/** AES-128 key expanded for the selected backend. */
+struct ble_aes_key {
+    uint32_t rk[44];
+};
+
+/** AES-CMAC key: the expanded key and its two subkeys. */
+struct ble_aes_cmac_key {
+    struct ble_aes_key aes;
+    uint8_t k1[16];
+    uint8_t k2[16];
+};
+
+/** AES-CMAC computation in progress. */
+struct ble_aes_cmac {
+    const struct ble_aes_cmac_key *key;
+    uint8_t x[16];
+    uint8_t buf[16];
+    uint8_t buf_len;
+};
+
+void ble_aes_set_key(struct ble_aes_key *key, const uint8_t k[16]);
+void ble_aes_encrypt(const struct ble_aes_key *key, const uint8_t in[16],
+                     uint8_t out[16]);
+
+/**
+ * Encrypts a single block with a key which is not going to be reused.
+ */
+void ble_aes_encrypt_block(const uint8_t k[16], const uint8_t in[16],
+                           uint8_t out[16]);
+
+void ble_aes_cmac_set_key(struct ble_aes_cmac_key *key, const uint8_t k[16]);
+void ble_aes_cmac_init(struct ble_aes_cmac *cmac,
+                       const struct ble_aes_cmac_key *key);
+void ble_aes_cmac_update(struct ble_aes_cmac *cmac, const void *data,
+                         size_t len);
+void ble_aes_cmac_final(struct ble_aes_cmac *cmac, uint8_t mac[16]);
+
+/**
+ * Calculates the AES-CMAC of a flat buffer with a key which is not going to
+ * be reused.
+ */
+void ble_aes_cmac(const uint8_t k[16], const void *data, size_t len,
+                  uint8_t mac[16]);
+
+/**
+ * Selects the AES backend to use.  Keys expanded before the call must be
+ * expanded again.
+ *
+ * @param backend               One of the BLE_AES_BACKEND_[...] codes.
+ *
+ * @return                      0 on success;
+ *                              BLE_ERR_UNSUPPORTED if the backend is not
+ *                                  compiled in or not supported by the CPU.
+ */
+int ble_aes_backend_select(int backend);
+
+/**
+ * Returns the BLE_AES_BACKEND_[...] code of the backend in use.
+ */
+int ble_aes_backend(void);
+
+/**
+ * Returns the name of the specified backend, or NULL if it is not available.
+ */
+const char *ble_aes_backend_name(int backend);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -87,6 +87,13 @@ extern "C" {
 /* List of OCF for Status parameters commands (OGF = 0x05) */
 #define BLE_HCI_OCF_RD_RSSI                 (0x0005)
 
+/* List of OCF for vendor specific commands (OGF = 0x3F) */
+#define BLE_HCI_OCF_VS_RD_SCHED_STATS       (0x0001)
+#define BLE_HCI_OCF_VS_RD_TRACE             (0x0002)
+#define BLE_HCI_OCF_VS_SET_ADV_FILT_ENABLE  (0x0003)
+#define BLE_HCI_OCF_VS_ADD_ADV_FILT         (0x0004)
+#define BLE_HCI_OCF_VS_CLEAR_ADV_FILT       (0x0005)
+
 /* List of OCF for LE commands (OGF = 0x08) */
 #define BLE_HCI_OCF_LE_SET_EVENT_MASK               (0x0001)
 #define BLE_HCI_OCF_LE_RD_BUF_SIZE                  (0x0002)
@@ -215,6 +222,26 @@ extern "C" {
 #define BLE_HCI_READ_RSSI_LEN               (2)
 #define BLE_HCI_READ_RSSI_ACK_PARAM_LEN     (3)  /* No status byte. */
 
+/* --- Vendor specific: read schedule statistics (OCF 0x0001) */
+#define BLE_HCI_VS_RD_SCHED_STATS_LEN       (2)
+
+/* --- Vendor specific: read trace records (OCF 0x0002) */
+#define BLE_HCI_VS_RD_TRACE_LEN             (0)
+#define BLE_HCI_VS_RD_TRACE_MAX_RECS        (14)
+
+/* --- Vendor specific: set advertising report filter enable (OCF 0x0003) */
+#define BLE_HCI_VS_SET_ADV_FILT_ENABLE_LEN  (2)
+
+/* --- Vendor specific: add advertising report filter (OCF 0x0004) */
+#define BLE_HCI_VS_ADV_FILT_TYPE_AD         (0x00)
+#define BLE_HCI_VS_ADV_FILT_TYPE_ADDR       (0x01)
+#define BLE_HCI_VS_ADD_ADV_FILT_ADDR_LEN    (8)
+#define BLE_HCI_VS_ADD_ADV_FILT_AD_MIN_LEN  (3)
+#define BLE_HCI_VS_ADV_FILT_AD_MAX_LEN      (16)
+
+/* --- Vendor specific: clear advertising report filters (OCF 0x0005) */
+#define BLE_HCI_VS_CLEAR_ADV_FILT_LEN       (0)
+
 /* --- LE set event mask (OCF 0x0001) --- */
 #define BLE_HCI_SET_LE_EVENT_MASK_LEN       (8)
 
@@ -250,6 +277,11 @@ extern "C" {
 #define BLE_HCI_ADV_DATA_STATUS_TRUNCATED   (0x0040)
 #define BLE_HCI_ADV_DATA_STATUS_MASK        (0x0060)
 
+/* Periodic advertising report data status */
+#define BLE_HCI_PER_ADV_DATA_STATUS_COMPLETE    (0x00)
+#define BLE_HCI_PER_ADV_DATA_STATUS_INCOMPLETE  (0x01)
+#define BLE_HCI_PER_ADV_DATA_STATUS_TRUNCATED   (0x02)
+
 /* Own address types */
 #define BLE_HCI_ADV_OWN_ADDR_PUBLIC         (0)
 #define BLE_HCI_ADV_OWN_ADDR_RANDOM         (1)
@@ -313,6 +345,9 @@ extern "C" {
 #define BLE_HCI_ADV_ITVL_NONCONN_MIN        (160)           /* units */
 
 #define BLE_HCI_ADV_ITVL_DEF                (0x800)         /* 1.28 seconds */
+
+/* Periodic advertising interval */
+#define BLE_HCI_PERIODIC_ADV_ITVL           (1250)          /* usecs */
 #define BLE_HCI_ADV_CHANMASK_DEF            (0x7)           /* all channels */
 
 /* Set scan parameters */
@@ -548,9 +583,12 @@ extern "C" {
 
 /* --- LE set periodic advertising parameters (OCF 0x003E) */
 #define BLE_HCI_LE_SET_PER_ADV_PARAMS_LEN           (7)
+#define BLE_HCI_LE_SET_PER_ADV_PROP_INC_TX_PWR      (0x0040)
+#define BLE_HCI_LE_SET_PER_ADV_ITVL_MIN             (0x0006)
 
 /* --- LE set periodic advertising data (OCF 0x003F) */
 #define BLE_HCI_LE_SET_PER_ADV_DATA_LEN             BLE_HCI_VARIABLE_LEN
+#define BLE_HCI_LE_SET_PER_ADV_DATA_MAX_LEN         (252)
 
 /* --- LE periodic advertising enable (OCF 0x0040) */
 #define BLE_HCI_LE_SET_PER_ADV_ENABLE_LEN           (2)
@@ -569,6 +607,10 @@ extern "C" {
 
 /* --- LE periodic advertising create sync (OCF 0x0044) */
 #define BLE_HCI_LE_PER_ADV_CREATE_SYNC_LEN          (14)
+#define BLE_HCI_LE_PER_ADV_CREATE_SYNC_OPT_FILTER   (0x01)
+#define BLE_HCI_LE_PER_ADV_SKIP_MAX                 (0x01F3)
+#define BLE_HCI_LE_PER_ADV_SYNC_TIMEOUT_MIN         (0x000A)
+#define BLE_HCI_LE_PER_ADV_SYNC_TIMEOUT_MAX         (0x4000)
 
 /* --- LE periodic advertising terminate (OCF 0x0046) */
 #define BLE_HCI_LE_PER_ADV_TERM_SYNC_LEN            (2)
@@ -776,6 +818,15 @@ extern "C" {
 /* LE PHY update complete event (sub event 0x0C) */
 #define BLE_HCI_LE_PHY_UPD_LEN              (6)
 
+/* LE Periodic Advertising Sync Established Event (sub event 0x0E) */
+#define BLE_HCI_LE_SUBEV_PER_ADV_SYNC_ESTAB_LEN   (16)
+
+/* LE Periodic Advertising Report Event (sub event 0x0F) */
+#define BLE_HCI_LE_SUBEV_PER_ADV_RPT_LEN   (8)
+
+/* LE Periodic Advertising Sync Lost Event (sub event 0x10) */
+#define BLE_HCI_LE_SUBEV_PER_ADV_SYNC_LOST_LEN   (3)
+
 /* LE Scan Timeout Event (sub event 0x11) */
 #define BLE_HCI_LE_SUBEV_SCAN_TIMEOUT_LEN   (1)
 
@@ -1192,6 +1243,40 @@ struct hci_le_adv_set_terminated
     uint8_t completed_events;
 };
 
+/* LE periodic advertising sync established event (sub event 0x0E) */
+struct hci_le_subev_periodic_adv_sync_estab
+{
+    uint8_t subevent_code;
+    uint8_t status;
+    uint16_t sync_handle;
+    uint8_t sid;
+    uint8_t adv_addr_type;
+    uint8_t adv_addr[BLE_DEV_ADDR_LEN];
+    uint8_t adv_phy;
+    uint16_t per_adv_ival;
+    uint8_t adv_clk_accuracy;
+};
+
+/* LE periodic advertising report event (sub event 0x0F) */
+struct hci_le_subev_periodic_adv_rpt
+{
+    uint8_t subevent_code;
+    uint16_t sync_handle;
+    int8_t tx_power;
+    int8_t rssi;
+    uint8_t unused;
+    uint8_t data_status;
+    uint8_t data_length;
+    uint8_t *data;
+};
+
+/* LE periodic advertising sync lost event (sub event 0x10) */
+struct hci_le_subev_periodic_adv_sync_lost
+{
+    uint8_t subevent_code;
+    uint16_t sync_handle;
+};
+
 #define BLE_HCI_DATA_HDR_SZ                 4
 #define BLE_HCI_DATA_HANDLE(handle_pb_bc)   (((handle_pb_bc) & 0x0fff) >> 0)
 #define BLE_HCI_DATA_PB(handle_pb_bc)       (((handle_pb_bc) & 0x3000) >> 12)
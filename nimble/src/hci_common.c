@@ -97,7 +97,7 @@ const uint8_t g_ble_hci_le_cmd_len[BLE_HCI_NUM_LE_CMDS] =
     BLE_HCI_LE_EXT_CREATE_CONN_LEN,     /* 0x0043: ext. create connection */
     BLE_HCI_LE_PER_ADV_CREATE_SYNC_LEN, /* 0x0044: periodic adv. create sync */
     0,                                  /* 0x0045: periodic adv. create sync cancel */
-    0,                                  /* 0x0046: periodic adv. terminate sync */
+    BLE_HCI_LE_PER_ADV_TERM_SYNC_LEN,   /* 0x0046: periodic adv. terminate sync */
     BLE_HCI_LE_ADD_DEV_TO_PER_ADV_LIST_LEN,  /* 0x0047: add dev to per. adv. list */
     BLE_HCI_LE_REM_DEV_FROM_PER_ADV_LIST_LEN,/* 0x0048: remove dev from per. adv. list */
     0,                                  /* 0x0049: clear periodic adv. list */
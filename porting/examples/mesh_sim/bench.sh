@@ -0,0 +1,79 @@
+#!/bin/sh
+#
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+#
+
+# Runs the regression scenarios and fails if the delivery ratio of any of
+# them drops below its threshold.  Runs are deterministic for a given seed,
+# so a change in the numbers is a change in the stack (or the simulator).
+#
+# usage: bench.sh [MESH_SIM] [SEED]
+
+SIM=${1:-build/mesh_sim}
+SEED=${2:-1}
+
+failed=0
+
+# name, minimum delivery ratio, mesh_sim options
+run() {
+    name=$1
+    min=$2
+    shift 2
+
+    out=$("$SIM" -S "$SEED" "$@")
+    if [ $? -ne 0 ]; then
+        echo "$name: FAIL (mesh_sim $*)"
+        failed=$((failed + 1))
+        return
+    fi
+
+    delivery=$(echo "$out" | sed -n 's/.*delivery=\([0-9.]*\).*/\1/p')
+    p95=$(echo "$out" | sed -n 's/.*latency_ms_p95=\([0-9.]*\).*/\1/p')
+    hw=$(echo "$out" | sed -n 's/^max_hw //p')
+
+    if awk "BEGIN { exit !($delivery >= $min) }"; then
+        result=ok
+    else
+        result=FAIL
+        failed=$((failed + 1))
+    fi
+
+    echo "$name: $result delivery=$delivery (min $min)" \
+         "latency_ms_p95=${p95:-none}"
+    echo "    $hw"
+}
+
+run line10-unicast      1.00 -n 10 -t line
+run line10-group        1.00 -n 10 -t line -g
+run grid25-group        0.99 -n 25 -t grid -g
+run full30-group        0.99 -n 30 -t full -g
+run line10-loss20       0.99 -n 10 -t line -l 20
+run ring16-loss10-slow  0.99 -n 16 -t ring -l 10 -L 2000
+run grid10-rand-src     0.99 -n 10 -t grid -g -s rand
+run grid20-group-burst  0.99 -n 20 -t grid -g -i 100 -m 200
+run line3-segmented     1.00 -n 3 -t line -p 40 -i 2000 -m 20
+run line10-seg-loss10   0.95 -n 10 -t line -p 40 -i 2000 -m 20 -l 10
+run grid25-segmented    0.95 -n 25 -t grid -p 40 -i 2000 -m 20
+run grid100-group       0.99 -n 100 -t grid -g -m 50
+
+if [ $failed -ne 0 ]; then
+    echo "$failed scenario(s) failed"
+    exit 1
+fi
+
+echo "all scenarios passed"
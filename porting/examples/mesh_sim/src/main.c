@@ -0,0 +1,811 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Mesh network simulator.  Runs N NimBLE mesh nodes in one process, on a
+ * simulated radio, in virtual time; sends test messages between them and
+ * reports delivery, latency and the nodes' relay, duplicate and buffer
+ * statistics as key=value lines.
+ */
+
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <errno.h>
+#include <getopt.h>
+#include <libgen.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "sim.h"
+#include "sched.h"
+#include "medium.h"
+
+#define SIM_MS                  1000ULL
+#define SIM_SETUP_TIMEOUT       (30 * 1000 * SIM_MS)
+#define SIM_NODES_MAX           1000
+
+#define SIM_GROUP_ADDR          0xc000
+#define SIM_SRC_RANDOM          (-1)
+
+/* BT_MESH_TRANSMIT(count, 20 ms) */
+#define SIM_TRANSMIT(count)     (((count) & 0x07) | (1 << 3))
+
+struct sim_node {
+    /* Must be first, the medium and the node see the same pointer */
+    struct medium_node radio;
+
+    void *lib;
+    const struct sim_node_api *api;
+    struct sim_node_cfg cfg;
+
+    int ready;
+    int status;
+
+    uint32_t rx;
+    uint32_t rx_dup;
+
+    /* Test messages received, one bit per message */
+    uint8_t *seen;
+};
+
+struct sim_msg {
+    uint64_t sent;
+    uint16_t src;
+    uint8_t send_rc;
+    uint32_t delivered;
+};
+
+enum sim_topo {
+    SIM_TOPO_FULL,
+    SIM_TOPO_LINE,
+    SIM_TOPO_RING,
+    SIM_TOPO_GRID,
+};
+
+static struct {
+    unsigned int nodes;
+    enum sim_topo topo;
+    unsigned int grid_width;
+    const char *topo_name;
+    float loss;
+    uint32_t latency_us;
+    unsigned int msgs;
+    unsigned int interval_ms;
+    unsigned int drain_ms;
+    int src;
+    int dst;
+    int group;
+    unsigned int payload;
+    unsigned int ttl;
+    unsigned int transmit;
+    unsigned int relay_transmit;
+    int relay;
+    int collisions;
+    uint64_t seed;
+    int verbose;
+    const char *lib_path;
+} sim_cfg = {
+    .nodes = 10,
+    .topo = SIM_TOPO_LINE,
+    .topo_name = "line",
+    .latency_us = 10,
+    .msgs = 100,
+    .interval_ms = 500,
+    .drain_ms = 5000,
+    .src = 0,
+    .dst = -1,
+    .payload = 8,
+    .transmit = 2,
+    .relay_transmit = 2,
+    .relay = 1,
+    .collisions = 1,
+    .seed = 1,
+};
+
+static struct sim_node **sim_nodes;
+static struct sim_msg *sim_msgs;
+static unsigned int sim_msgs_sent;
+static struct sim_timer sim_send_timer;
+
+/* Latencies of all deliveries, in microseconds */
+static uint64_t *sim_latency;
+static size_t sim_latency_cnt;
+static size_t sim_latency_size;
+
+/* Hops taken by all deliveries */
+static uint64_t sim_hops_sum;
+static unsigned int sim_hops_max;
+
+static struct sim_node *
+sim_node_from_ctx(void *ctx)
+{
+    return ctx;
+}
+
+static void
+sim_hci_cmd(void *ctx, const uint8_t *cmd)
+{
+    medium_hci_cmd(&sim_node_from_ctx(ctx)->radio, cmd);
+}
+
+static void
+sim_ready(void *ctx, int status)
+{
+    struct sim_node *node = sim_node_from_ctx(ctx);
+
+    node->ready = 1;
+    node->status = status;
+}
+
+static void
+sim_msg_rx(void *ctx, uint16_t src, uint32_t id, uint8_t recv_ttl)
+{
+    struct sim_node *node = sim_node_from_ctx(ctx);
+    struct sim_msg *msg;
+    unsigned int hops;
+
+    if (id >= sim_msgs_sent) {
+        return;
+    }
+
+    msg = &sim_msgs[id];
+    if (node->radio.idx == msg->src) {
+        /* Local loopback of a group message */
+        return;
+    }
+
+    node->rx++;
+    if (node->seen[id / 8] & (1 << (id % 8))) {
+        node->rx_dup++;
+        return;
+    }
+
+    node->seen[id / 8] |= 1 << (id % 8);
+    msg->delivered++;
+
+    hops = sim_cfg.ttl - recv_ttl + 1;
+    sim_hops_sum += hops;
+    if (hops > sim_hops_max) {
+        sim_hops_max = hops;
+    }
+
+    if (sim_latency_cnt == sim_latency_size) {
+        sim_latency_size = sim_latency_size ? sim_latency_size * 2 : 1024;
+        sim_latency = realloc(sim_latency,
+                              sim_latency_size * sizeof(*sim_latency));
+        if (sim_latency == NULL) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+
+    sim_latency[sim_latency_cnt++] = sched_now() - msg->sent;
+}
+
+static const struct sim_ops sim_ops = {
+    .now = sched_now,
+    .task_create = sched_task_create,
+    .task_self = sched_task_self,
+    .sleep = sched_sleep,
+    .wakeup = sched_wakeup,
+    .timer_start = sched_timer_start,
+    .timer_stop = sched_timer_stop,
+    .hci_cmd = sim_hci_cmd,
+    .ready = sim_ready,
+    .msg_rx = sim_msg_rx,
+};
+
+/*
+ * Loads a private copy of the node library.  glibc loads a file only once,
+ * matching both by name and by inode, so each node gets its own file.
+ */
+static void *
+sim_load(const char *dir, unsigned int idx, const void *image, size_t size)
+{
+    char path[PATH_MAX];
+    void *lib;
+    FILE *f;
+
+    if (snprintf(path, sizeof(path), "%s/node_%u.so", dir, idx) >=
+        (int)sizeof(path)) {
+        fprintf(stderr, "%s: path too long\n", dir);
+        return NULL;
+    }
+
+    f = fopen(path, "wb");
+    if (f == NULL) {
+        perror(path);
+        return NULL;
+    }
+
+    if (fwrite(image, 1, size, f) != size) {
+        perror(path);
+        fclose(f);
+        unlink(path);
+        return NULL;
+    }
+    fclose(f);
+
+    lib = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (lib == NULL) {
+        fprintf(stderr, "dlopen: %s\n", dlerror());
+    }
+
+    /* The mapping stays */
+    unlink(path);
+
+    return lib;
+}
+
+static void *
+sim_read_file(const char *path, size_t *size)
+{
+    FILE *f;
+    void *buf;
+    long len;
+
+    f = fopen(path, "rb");
+    if (f == NULL) {
+        perror(path);
+        return NULL;
+    }
+
+    fseek(f, 0, SEEK_END);
+    len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    buf = malloc(len);
+    if (buf == NULL || fread(buf, 1, len, f) != (size_t)len) {
+        fprintf(stderr, "%s: read failed\n", path);
+        free(buf);
+        fclose(f);
+        return NULL;
+    }
+
+    fclose(f);
+    *size = len;
+
+    return buf;
+}
+
+/* Most hops between two nodes */
+static unsigned int
+sim_diameter(void)
+{
+    unsigned int n = sim_cfg.nodes;
+    unsigned int w = sim_cfg.grid_width;
+
+    switch (sim_cfg.topo) {
+    case SIM_TOPO_FULL:
+        return 1;
+    case SIM_TOPO_RING:
+        return n > 2 ? n / 2 : n - 1;
+    case SIM_TOPO_GRID:
+        return (w - 1) + (n - 1) / w;
+    case SIM_TOPO_LINE:
+    default:
+        return n - 1;
+    }
+}
+
+static int
+sim_topology(void)
+{
+    unsigned int n = sim_cfg.nodes;
+    unsigned int w = sim_cfg.grid_width;
+    unsigned int i;
+    unsigned int j;
+    int rc = 0;
+
+#define SIM_LINK(a, b) \
+    medium_link((a), (b), sim_cfg.loss, sim_cfg.latency_us)
+
+    switch (sim_cfg.topo) {
+    case SIM_TOPO_FULL:
+        for (i = 0; i < n && !rc; i++) {
+            for (j = i + 1; j < n && !rc; j++) {
+                rc = SIM_LINK(i, j);
+            }
+        }
+        break;
+    case SIM_TOPO_LINE:
+    case SIM_TOPO_RING:
+        for (i = 0; i + 1 < n && !rc; i++) {
+            rc = SIM_LINK(i, i + 1);
+        }
+        if (sim_cfg.topo == SIM_TOPO_RING && n > 2 && !rc) {
+            rc = SIM_LINK(n - 1, 0);
+        }
+        break;
+    case SIM_TOPO_GRID:
+        for (i = 0; i < n && !rc; i++) {
+            if ((i % w) + 1 < w && i + 1 < n) {
+                rc = SIM_LINK(i, i + 1);
+            }
+            if (i + w < n && !rc) {
+                rc = SIM_LINK(i, i + w);
+            }
+        }
+        break;
+    }
+
+#undef SIM_LINK
+
+    return rc;
+}
+
+static int
+sim_setup(void)
+{
+    struct sim_node *node;
+    char exe[PATH_MAX];
+    char lib_path[PATH_MAX];
+    char dir[PATH_MAX];
+    const char *tmp;
+    const char *path;
+    void *image;
+    size_t size;
+    unsigned int i;
+    ssize_t len;
+    int rc;
+
+    path = sim_cfg.lib_path;
+    if (path == NULL) {
+        len = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+        if (len < 0) {
+            perror("readlink");
+            return -1;
+        }
+        exe[len] = '\0';
+        snprintf(lib_path, sizeof(lib_path), "%s/mesh_node.so", dirname(exe));
+        path = lib_path;
+    }
+
+    image = sim_read_file(path, &size);
+    if (image == NULL) {
+        return -1;
+    }
+
+    tmp = getenv("TMPDIR");
+    snprintf(dir, sizeof(dir), "%s/mesh_sim.XXXXXX", tmp ? tmp : "/tmp");
+    if (mkdtemp(dir) == NULL) {
+        perror(dir);
+        return -1;
+    }
+
+    sim_nodes = calloc(sim_cfg.nodes, sizeof(*sim_nodes));
+    if (sim_nodes == NULL) {
+        return -1;
+    }
+
+    for (i = 0; i < sim_cfg.nodes; i++) {
+        node = calloc(1, sizeof(*node));
+        if (node == NULL) {
+            return -1;
+        }
+        sim_nodes[i] = node;
+
+        node->seen = calloc((sim_cfg.msgs + 7) / 8, 1);
+        node->lib = sim_load(dir, i, image, size);
+        if (node->seen == NULL || node->lib == NULL) {
+            rmdir(dir);
+            return -1;
+        }
+
+        node->api = dlsym(node->lib, SIM_NODE_API_SYM);
+        if (node->api == NULL) {
+            fprintf(stderr, "%s: no %s\n", path, SIM_NODE_API_SYM);
+            return -1;
+        }
+        node->radio.api = node->api;
+    }
+
+    free(image);
+    rmdir(dir);
+
+    rc = medium_init((struct medium_node **)sim_nodes, sim_cfg.nodes,
+                     sim_cfg.collisions);
+    if (rc == 0) {
+        rc = sim_topology();
+    }
+    if (rc) {
+        fprintf(stderr, "medium setup failed: %s\n", strerror(rc));
+        return -1;
+    }
+
+    for (i = 0; i < sim_cfg.nodes; i++) {
+        node = sim_nodes[i];
+
+        memset(node->cfg.net_key, 0x11, sizeof(node->cfg.net_key));
+        memset(node->cfg.app_key, 0x22, sizeof(node->cfg.app_key));
+        memset(node->cfg.dev_key, 0x33, sizeof(node->cfg.dev_key));
+        node->cfg.dev_key[0] = i;
+        node->cfg.dev_key[1] = i >> 8;
+        node->cfg.addr = i + 1;
+        node->cfg.group = sim_cfg.group ? SIM_GROUP_ADDR : 0;
+        node->cfg.relay = sim_cfg.relay;
+        node->cfg.ttl = sim_cfg.ttl;
+        node->cfg.net_transmit = SIM_TRANSMIT(sim_cfg.transmit);
+        node->cfg.relay_retransmit = SIM_TRANSMIT(sim_cfg.relay_transmit);
+
+        rc = node->api->init(&sim_ops, node, &node->cfg);
+        if (rc) {
+            fprintf(stderr, "node %u: init failed: %d\n", i, rc);
+            return -1;
+        }
+    }
+
+    /* Wait for every node to come up, provisioned and configured */
+    for (;;) {
+        for (i = 0; i < sim_cfg.nodes; i++) {
+            node = sim_nodes[i];
+            if (node->ready && node->status) {
+                fprintf(stderr, "node %u: configuration failed: %d\n", i,
+                        node->status);
+                return -1;
+            }
+            if (!node->ready) {
+                break;
+            }
+        }
+
+        if (i == sim_cfg.nodes) {
+            return 0;
+        }
+
+        if (sched_now() >= SIM_SETUP_TIMEOUT) {
+            fprintf(stderr, "node %u: not ready after %llu ms\n", i,
+                    (unsigned long long)(SIM_SETUP_TIMEOUT / SIM_MS));
+            return -1;
+        }
+
+        sched_run(sched_now() + 100 * SIM_MS);
+    }
+}
+
+static void
+sim_send(void *arg)
+{
+    struct sim_msg *msg;
+    uint16_t dst;
+    int src;
+
+    src = sim_cfg.src;
+    if (src == SIM_SRC_RANDOM) {
+        src = sched_rand() % sim_cfg.nodes;
+    }
+
+    if (sim_cfg.group) {
+        dst = SIM_GROUP_ADDR;
+    } else {
+        dst = sim_cfg.dst + 1;
+        if (dst == src + 1) {
+            /* Random source landed on the destination */
+            src = (src + 1) % sim_cfg.nodes;
+        }
+    }
+
+    msg = &sim_msgs[sim_msgs_sent];
+    msg->sent = sched_now();
+    msg->src = src;
+    msg->send_rc = sim_nodes[src]->api->send(dst, sim_msgs_sent,
+                                             sim_cfg.payload) != 0;
+    sim_msgs_sent++;
+
+    if (sim_msgs_sent < sim_cfg.msgs) {
+        sched_timer_start(&sim_send_timer,
+                          sched_now() + sim_cfg.interval_ms * SIM_MS);
+    }
+}
+
+static int
+sim_cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static double
+sim_pct_ms(double pct)
+{
+    size_t idx;
+
+    if (!sim_latency_cnt) {
+        return 0;
+    }
+
+    idx = (size_t)(pct / 100 * (sim_latency_cnt - 1) + 0.5);
+
+    return sim_latency[idx] / 1000.0;
+}
+
+#define SIM_STAT_FIELDS(X) \
+    X(net_rx) X(net_tx) X(net_cache_hit) X(relay) X(relay_fast) \
+    X(relay_no_buf) X(replay) X(seg_retransmit) X(seg_tx_fail) \
+    X(hci_evt_drop) X(send_fail)
+
+#define SIM_HW_FIELDS(X) \
+    X(rpl_hw) X(seg_tx_hw) X(seg_rx_hw) X(frnd_queue_hw) X(adv_buf_hw) \
+    X(relay_buf_hw) X(msys_hw)
+
+static void
+sim_report(void)
+{
+    const struct medium_stats *ms = medium_stats();
+    struct sim_node_stats stats;
+    struct sim_node *node;
+    uint64_t expected;
+    uint64_t delivered = 0;
+    uint64_t dup = 0;
+    uint64_t sum = 0;
+    unsigned int send_fail = 0;
+    unsigned int i;
+#define SIM_DECL(f) uint64_t total_##f = 0;
+    SIM_STAT_FIELDS(SIM_DECL)
+#undef SIM_DECL
+#define SIM_DECL(f) uint32_t max_##f = 0;
+    SIM_HW_FIELDS(SIM_DECL)
+#undef SIM_DECL
+
+    for (i = 0; i < sim_msgs_sent; i++) {
+        delivered += sim_msgs[i].delivered;
+        send_fail += sim_msgs[i].send_rc;
+    }
+    expected = (uint64_t)(sim_msgs_sent - send_fail) *
+               (sim_cfg.group ? sim_cfg.nodes - 1 : 1);
+
+    for (i = 0; i < sim_latency_cnt; i++) {
+        sum += sim_latency[i];
+    }
+    qsort(sim_latency, sim_latency_cnt, sizeof(*sim_latency), sim_cmp_u64);
+
+    printf("nodes=%u topology=%s loss=%.3f latency_us=%u collisions=%d "
+           "ttl=%u seed=%llu\n", sim_cfg.nodes, sim_cfg.topo_name,
+           sim_cfg.loss, sim_cfg.latency_us, sim_cfg.collisions, sim_cfg.ttl,
+           (unsigned long long)sim_cfg.seed);
+    printf("msgs=%u send_fail=%u expected=%llu delivered=%llu "
+           "delivery=%.4f\n", sim_msgs_sent, send_fail,
+           (unsigned long long)expected, (unsigned long long)delivered,
+           expected ? (double)delivered / expected : 0);
+    printf("latency_ms_min=%.3f latency_ms_avg=%.3f latency_ms_p50=%.3f "
+           "latency_ms_p95=%.3f latency_ms_max=%.3f\n",
+           sim_pct_ms(0),
+           sim_latency_cnt ? sum / 1000.0 / sim_latency_cnt : 0,
+           sim_pct_ms(50), sim_pct_ms(95), sim_pct_ms(100));
+    printf("hops_avg=%.2f hops_max=%u\n",
+           sim_latency_cnt ? (double)sim_hops_sum / sim_latency_cnt : 0,
+           sim_hops_max);
+    printf("medium_tx=%llu medium_rx=%llu medium_lost=%llu "
+           "medium_collided=%llu medium_busy=%llu medium_not_scanning=%llu\n",
+           (unsigned long long)ms->tx, (unsigned long long)ms->rx,
+           (unsigned long long)ms->lost, (unsigned long long)ms->collided,
+           (unsigned long long)ms->busy,
+           (unsigned long long)ms->not_scanning);
+
+    for (i = 0; i < sim_cfg.nodes; i++) {
+        node = sim_nodes[i];
+        node->api->stats(&stats);
+        dup += node->rx_dup;
+
+#define SIM_SUM(f) total_##f += stats.f;
+        SIM_STAT_FIELDS(SIM_SUM)
+#undef SIM_SUM
+#define SIM_MAX(f) if (stats.f > max_##f) { max_##f = stats.f; }
+        SIM_HW_FIELDS(SIM_MAX)
+#undef SIM_MAX
+
+        if (sim_cfg.verbose) {
+            printf("node=%u addr=0x%04x rx=%u rx_dup=%u", i, node->cfg.addr,
+                   node->rx, node->rx_dup);
+#define SIM_PRINT(f) printf(" " #f "=%u", stats.f);
+            SIM_STAT_FIELDS(SIM_PRINT)
+            SIM_HW_FIELDS(SIM_PRINT)
+#undef SIM_PRINT
+            printf("\n");
+        }
+    }
+
+    printf("app_dup=%llu", (unsigned long long)dup);
+#define SIM_PRINT(f) printf(" " #f "=%llu", (unsigned long long)total_##f);
+    SIM_STAT_FIELDS(SIM_PRINT)
+#undef SIM_PRINT
+    printf("\n");
+
+    printf("max_hw");
+#define SIM_PRINT(f) printf(" " #f "=%u", max_##f);
+    SIM_HW_FIELDS(SIM_PRINT)
+#undef SIM_PRINT
+    printf("\n");
+}
+
+static void
+sim_usage(const char *name)
+{
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  -n NODES     number of nodes (%u)\n"
+        "  -t TOPO      full, line, ring or grid[:WIDTH] (line)\n"
+        "  -l LOSS      link loss, percent (0)\n"
+        "  -L USECS     link latency (%u)\n"
+        "  -c           no collisions\n"
+        "  -m MSGS      test messages to send (%u)\n"
+        "  -i MSECS     interval between messages (%u)\n"
+        "  -w MSECS     time to wait after the last message (%u)\n"
+        "  -s NODE      sending node, or \"rand\" (0)\n"
+        "  -d NODE      destination node (last)\n"
+        "  -g           send to a group all nodes subscribe to\n"
+        "  -p BYTES     message payload, 4 or more (%u)\n"
+        "  -T TTL       default TTL (network diameter, at least 2)\n"
+        "  -x COUNT     network transmissions - 1 (%u)\n"
+        "  -X COUNT     relay retransmissions - 1 (%u)\n"
+        "  -R           disable relaying\n"
+        "  -S SEED      random seed (%llu)\n"
+        "  -N PATH      node library (mesh_node.so next to the binary)\n"
+        "  -v           per-node statistics\n",
+        name, sim_cfg.nodes, sim_cfg.latency_us, sim_cfg.msgs,
+        sim_cfg.interval_ms, sim_cfg.drain_ms, sim_cfg.payload,
+        sim_cfg.transmit, sim_cfg.relay_transmit,
+        (unsigned long long)sim_cfg.seed);
+}
+
+static int
+sim_parse_topo(const char *arg)
+{
+    sim_cfg.topo_name = arg;
+
+    if (!strcmp(arg, "full")) {
+        sim_cfg.topo = SIM_TOPO_FULL;
+    } else if (!strcmp(arg, "line")) {
+        sim_cfg.topo = SIM_TOPO_LINE;
+    } else if (!strcmp(arg, "ring")) {
+        sim_cfg.topo = SIM_TOPO_RING;
+    } else if (!strncmp(arg, "grid", 4) && (!arg[4] || arg[4] == ':')) {
+        sim_cfg.topo = SIM_TOPO_GRID;
+        sim_cfg.grid_width = arg[4] ? atoi(arg + 5) : 0;
+    } else {
+        return -1;
+    }
+
+    return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:t:l:L:cm:i:w:s:d:gp:T:x:X:RS:N:vh"))
+           != -1) {
+        switch (opt) {
+        case 'n':
+            sim_cfg.nodes = atoi(optarg);
+            break;
+        case 't':
+            if (sim_parse_topo(optarg)) {
+                sim_usage(argv[0]);
+                return 2;
+            }
+            break;
+        case 'l':
+            sim_cfg.loss = atof(optarg) / 100;
+            break;
+        case 'L':
+            sim_cfg.latency_us = atoi(optarg);
+            break;
+        case 'c':
+            sim_cfg.collisions = 0;
+            break;
+        case 'm':
+            sim_cfg.msgs = atoi(optarg);
+            break;
+        case 'i':
+            sim_cfg.interval_ms = atoi(optarg);
+            break;
+        case 'w':
+            sim_cfg.drain_ms = atoi(optarg);
+            break;
+        case 's':
+            sim_cfg.src = strcmp(optarg, "rand") ? atoi(optarg) :
+                                                   SIM_SRC_RANDOM;
+            break;
+        case 'd':
+            sim_cfg.dst = atoi(optarg);
+            break;
+        case 'g':
+            sim_cfg.group = 1;
+            break;
+        case 'p':
+            sim_cfg.payload = atoi(optarg);
+            break;
+        case 'T':
+            sim_cfg.ttl = atoi(optarg);
+            break;
+        case 'x':
+            sim_cfg.transmit = atoi(optarg);
+            break;
+        case 'X':
+            sim_cfg.relay_transmit = atoi(optarg);
+            break;
+        case 'R':
+            sim_cfg.relay = 0;
+            break;
+        case 'S':
+            sim_cfg.seed = strtoull(optarg, NULL, 0);
+            break;
+        case 'N':
+            sim_cfg.lib_path = optarg;
+            break;
+        case 'v':
+            sim_cfg.verbose = 1;
+            break;
+        default:
+            sim_usage(argv[0]);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+
+    if (sim_cfg.dst < 0) {
+        sim_cfg.dst = sim_cfg.nodes - 1;
+    }
+    if (sim_cfg.topo == SIM_TOPO_GRID && !sim_cfg.grid_width) {
+        for (sim_cfg.grid_width = 1;
+             sim_cfg.grid_width * sim_cfg.grid_width < sim_cfg.nodes;
+             sim_cfg.grid_width++) {
+        }
+    }
+    if (!sim_cfg.ttl) {
+        /* TTL 1 doesn't leave the node */
+        sim_cfg.ttl = sim_diameter() > 2 ? sim_diameter() : 2;
+    }
+
+    if (sim_cfg.nodes < 2 || sim_cfg.nodes > SIM_NODES_MAX ||
+        sim_cfg.src >= (int)sim_cfg.nodes || sim_cfg.src < SIM_SRC_RANDOM ||
+        sim_cfg.dst >= (int)sim_cfg.nodes ||
+        (!sim_cfg.group && sim_cfg.src == sim_cfg.dst) ||
+        sim_cfg.payload < 4 || sim_cfg.ttl > 127 || sim_cfg.transmit > 7 ||
+        sim_cfg.relay_transmit > 7 || sim_cfg.loss < 0 || sim_cfg.loss > 1) {
+        sim_usage(argv[0]);
+        return 2;
+    }
+
+    sched_seed(sim_cfg.seed);
+
+    sim_msgs = calloc(sim_cfg.msgs ? sim_cfg.msgs : 1, sizeof(*sim_msgs));
+    if (sim_msgs == NULL || sim_setup()) {
+        return 1;
+    }
+
+    sim_send_timer.fn = sim_send;
+    if (sim_cfg.msgs) {
+        sched_timer_start(&sim_send_timer, sched_now());
+    }
+
+    while (sim_msgs_sent < sim_cfg.msgs) {
+        sched_run(sched_now() + 100 * SIM_MS);
+    }
+    sched_run(sched_now() + sim_cfg.drain_ms * SIM_MS);
+
+    sim_report();
+
+    return 0;
+}
@@ -0,0 +1,387 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sched.h"
+#include "medium.h"
+
+#define MEDIUM_OP(ogf, ocf)             (((ogf) << 10) | (ocf))
+
+#define MEDIUM_OP_RESET                 MEDIUM_OP(0x03, 0x0003)
+#define MEDIUM_OP_RD_LOCAL_VER          MEDIUM_OP(0x04, 0x0001)
+#define MEDIUM_OP_RD_LOC_SUPP_FEAT      MEDIUM_OP(0x04, 0x0003)
+#define MEDIUM_OP_RD_BD_ADDR            MEDIUM_OP(0x04, 0x0009)
+#define MEDIUM_OP_LE_RD_BUF_SIZE        MEDIUM_OP(0x08, 0x0002)
+#define MEDIUM_OP_LE_RD_LOC_SUPP_FEAT   MEDIUM_OP(0x08, 0x0003)
+#define MEDIUM_OP_LE_SET_ADV_PARAMS     MEDIUM_OP(0x08, 0x0006)
+#define MEDIUM_OP_LE_RD_ADV_CHAN_TXPWR  MEDIUM_OP(0x08, 0x0007)
+#define MEDIUM_OP_LE_SET_ADV_DATA       MEDIUM_OP(0x08, 0x0008)
+#define MEDIUM_OP_LE_SET_ADV_ENABLE     MEDIUM_OP(0x08, 0x000A)
+#define MEDIUM_OP_LE_SET_SCAN_ENABLE    MEDIUM_OP(0x08, 0x000C)
+#define MEDIUM_OP_LE_RAND               MEDIUM_OP(0x08, 0x0018)
+
+#define MEDIUM_EVT_CMD_COMPLETE         0x0E
+#define MEDIUM_EVT_LE_META              0x3E
+#define MEDIUM_LE_SUBEV_ADV_RPT         0x02
+#define MEDIUM_ADV_NONCONN_IND          0x03
+
+/* Bluetooth 5.0, so mesh uses its fast advertising interval */
+#define MEDIUM_HCI_VERSION              9
+
+#define MEDIUM_ADV_DELAY_MAX_US         10000
+#define MEDIUM_ADV_ITVL_UNIT_US         625
+#define MEDIUM_RSSI                     (-50)
+
+/* Preamble, access address, header, AdvA and CRC around the data */
+#define MEDIUM_AIRTIME_US(data_len)     ((1 + 4 + 2 + 6 + (data_len) + 3) * 8)
+
+enum medium_rx_err {
+    MEDIUM_RX_OK,
+    MEDIUM_RX_COLLIDED,
+    MEDIUM_RX_BUSY,
+};
+
+/* An HCI event on its way to the host */
+struct medium_evt {
+    struct sim_timer timer;
+    struct medium_node *node;
+    uint8_t buf[2 + 255];
+};
+
+/* An advertising PDU in the air, as seen by one receiver */
+struct medium_rx {
+    struct sim_timer timer;
+    struct medium_node *node;
+    struct medium_node *src;
+    uint64_t start;
+    uint64_t end;
+    enum medium_rx_err err;
+    uint8_t data_len;
+    uint8_t data[MEDIUM_ADV_DATA_MAX];
+    struct medium_rx *next;
+};
+
+static struct medium_node **medium_nodes;
+static uint16_t medium_node_cnt;
+static int medium_collisions;
+static struct medium_stats medium_stat;
+
+static void
+medium_put_le16(uint8_t *buf, uint16_t x)
+{
+    buf[0] = x;
+    buf[1] = x >> 8;
+}
+
+static uint16_t
+medium_get_le16(const uint8_t *buf)
+{
+    return buf[0] | (buf[1] << 8);
+}
+
+static void
+medium_evt_fire(void *arg)
+{
+    struct medium_evt *evt = arg;
+
+    evt->node->api->hci_evt(evt->buf);
+    free(evt);
+}
+
+static void
+medium_cmd_complete(struct medium_node *node, uint16_t opcode,
+                    const uint8_t *params, uint8_t params_len)
+{
+    struct medium_evt *evt;
+
+    evt = calloc(1, sizeof(*evt));
+    assert(evt != NULL);
+
+    evt->node = node;
+    evt->buf[0] = MEDIUM_EVT_CMD_COMPLETE;
+    evt->buf[1] = 4 + params_len;
+    evt->buf[2] = 1;
+    medium_put_le16(evt->buf + 3, opcode);
+    evt->buf[5] = 0;
+    memcpy(evt->buf + 6, params, params_len);
+
+    /* The host gets the response once the sending task sleeps */
+    evt->timer.fn = medium_evt_fire;
+    evt->timer.arg = evt;
+    sched_timer_start(&evt->timer, sched_now());
+}
+
+static void
+medium_rx_done(void *arg)
+{
+    struct medium_rx *rx = arg;
+    struct medium_node *node = rx->node;
+    struct medium_rx **prev;
+    uint8_t evt[2 + 12 + MEDIUM_ADV_DATA_MAX];
+
+    for (prev = &node->rx_list; *prev != rx; prev = &(*prev)->next) {
+    }
+    *prev = rx->next;
+
+    if (rx->err == MEDIUM_RX_COLLIDED) {
+        medium_stat.collided++;
+    } else if (rx->err == MEDIUM_RX_BUSY) {
+        medium_stat.busy++;
+    } else if (!node->scan_enabled) {
+        medium_stat.not_scanning++;
+    } else {
+        medium_stat.rx++;
+
+        evt[0] = MEDIUM_EVT_LE_META;
+        evt[1] = 12 + rx->data_len;
+        evt[2] = MEDIUM_LE_SUBEV_ADV_RPT;
+        evt[3] = 1;
+        evt[4] = MEDIUM_ADV_NONCONN_IND;
+        evt[5] = 0;
+        memcpy(evt + 6, rx->src->addr, 6);
+        evt[12] = rx->data_len;
+        memcpy(evt + 13, rx->data, rx->data_len);
+        evt[13 + rx->data_len] = (uint8_t)MEDIUM_RSSI;
+
+        node->api->hci_evt(evt);
+    }
+
+    free(rx);
+}
+
+static void
+medium_rx_start(struct medium_node *src, const struct medium_link *link,
+                uint32_t airtime)
+{
+    struct medium_node *node = medium_nodes[link->nbr];
+    struct medium_rx *other;
+    struct medium_rx *rx;
+
+    if (link->loss > 0 &&
+        sched_rand() < (uint32_t)(link->loss * (float)UINT32_MAX)) {
+        medium_stat.lost++;
+        return;
+    }
+
+    rx = calloc(1, sizeof(*rx));
+    assert(rx != NULL);
+
+    rx->node = node;
+    rx->src = src;
+    rx->start = sched_now() + link->latency_us;
+    rx->end = rx->start + airtime;
+    rx->data_len = src->adv_data_len;
+    memcpy(rx->data, src->adv_data, src->adv_data_len);
+
+    /* The radio can't receive while it sends */
+    if (node->tx_end > rx->start) {
+        rx->err = MEDIUM_RX_BUSY;
+    }
+
+    if (medium_collisions) {
+        for (other = node->rx_list; other != NULL; other = other->next) {
+            if (other->start < rx->end && rx->start < other->end) {
+                if (other->err == MEDIUM_RX_OK) {
+                    other->err = MEDIUM_RX_COLLIDED;
+                }
+                if (rx->err == MEDIUM_RX_OK) {
+                    rx->err = MEDIUM_RX_COLLIDED;
+                }
+            }
+        }
+    }
+
+    rx->next = node->rx_list;
+    node->rx_list = rx;
+
+    rx->timer.fn = medium_rx_done;
+    rx->timer.arg = rx;
+    sched_timer_start(&rx->timer, rx->end);
+}
+
+static void
+medium_adv_event(void *arg)
+{
+    struct medium_node *node = arg;
+    struct medium_rx *rx;
+    uint32_t airtime;
+    uint64_t now;
+    int i;
+
+    now = sched_now();
+    airtime = MEDIUM_AIRTIME_US(node->adv_data_len);
+    node->tx_end = now + airtime;
+    medium_stat.tx++;
+
+    /* Whatever this node was receiving is lost */
+    for (rx = node->rx_list; rx != NULL; rx = rx->next) {
+        if (rx->start < node->tx_end && now < rx->end &&
+            rx->err == MEDIUM_RX_OK) {
+            rx->err = MEDIUM_RX_BUSY;
+        }
+    }
+
+    for (i = 0; i < node->link_cnt; i++) {
+        medium_rx_start(node, &node->links[i], airtime);
+    }
+
+    sched_timer_start(&node->adv_timer,
+                      now + node->adv_itvl * MEDIUM_ADV_ITVL_UNIT_US +
+                      sched_rand() % (MEDIUM_ADV_DELAY_MAX_US + 1));
+}
+
+void
+medium_hci_cmd(struct medium_node *node, const uint8_t *cmd)
+{
+    const uint8_t *params = cmd + 3;
+    uint8_t rsp[8] = { 0 };
+    uint8_t rsp_len = 0;
+    uint16_t opcode;
+    int i;
+
+    opcode = medium_get_le16(cmd);
+
+    switch (opcode) {
+    case MEDIUM_OP_RESET:
+        sched_timer_stop(&node->adv_timer);
+        node->adv_enabled = 0;
+        node->scan_enabled = 0;
+        break;
+    case MEDIUM_OP_RD_LOCAL_VER:
+        rsp[0] = MEDIUM_HCI_VERSION;
+        rsp[3] = MEDIUM_HCI_VERSION;
+        rsp_len = 8;
+        break;
+    case MEDIUM_OP_RD_LOC_SUPP_FEAT:
+        /* LE Supported (Controller) */
+        rsp[4] = 0x60;
+        rsp_len = 8;
+        break;
+    case MEDIUM_OP_RD_BD_ADDR:
+        memcpy(rsp, node->addr, 6);
+        rsp_len = 6;
+        break;
+    case MEDIUM_OP_LE_RD_BUF_SIZE:
+        medium_put_le16(rsp, 251);
+        rsp[2] = 8;
+        rsp_len = 3;
+        break;
+    case MEDIUM_OP_LE_RD_LOC_SUPP_FEAT:
+        rsp_len = 8;
+        break;
+    case MEDIUM_OP_LE_RD_ADV_CHAN_TXPWR:
+        rsp_len = 1;
+        break;
+    case MEDIUM_OP_LE_SET_ADV_PARAMS:
+        node->adv_itvl = medium_get_le16(params);
+        break;
+    case MEDIUM_OP_LE_SET_ADV_DATA:
+        node->adv_data_len = params[0];
+        if (node->adv_data_len > MEDIUM_ADV_DATA_MAX) {
+            node->adv_data_len = MEDIUM_ADV_DATA_MAX;
+        }
+        memcpy(node->adv_data, params + 1, node->adv_data_len);
+        break;
+    case MEDIUM_OP_LE_SET_ADV_ENABLE:
+        if (params[0] && !node->adv_enabled) {
+            sched_timer_start(&node->adv_timer, sched_now() +
+                              sched_rand() % (MEDIUM_ADV_DELAY_MAX_US + 1));
+        } else if (!params[0]) {
+            sched_timer_stop(&node->adv_timer);
+        }
+        node->adv_enabled = params[0];
+        break;
+    case MEDIUM_OP_LE_SET_SCAN_ENABLE:
+        node->scan_enabled = params[0];
+        break;
+    case MEDIUM_OP_LE_RAND:
+        for (i = 0; i < 8; i += 4) {
+            uint32_t r = sched_rand();
+            memcpy(rsp + i, &r, 4);
+        }
+        rsp_len = 8;
+        break;
+    default:
+        break;
+    }
+
+    medium_cmd_complete(node, opcode, rsp, rsp_len);
+}
+
+int
+medium_link(uint16_t a, uint16_t b, float loss, uint32_t latency_us)
+{
+    struct medium_node *node;
+    struct medium_link *links;
+    uint16_t ends[2] = { a, b };
+    int i;
+
+    if (a >= medium_node_cnt || b >= medium_node_cnt || a == b) {
+        return EINVAL;
+    }
+
+    for (i = 0; i < 2; i++) {
+        node = medium_nodes[ends[i]];
+        links = realloc(node->links, (node->link_cnt + 1) * sizeof(*links));
+        if (links == NULL) {
+            return ENOMEM;
+        }
+
+        links[node->link_cnt].nbr = ends[!i];
+        links[node->link_cnt].loss = loss;
+        links[node->link_cnt].latency_us = latency_us;
+        node->links = links;
+        node->link_cnt++;
+    }
+
+    return 0;
+}
+
+int
+medium_init(struct medium_node **nodes, uint16_t node_cnt, int collisions)
+{
+    struct medium_node *node;
+    int i;
+
+    medium_nodes = nodes;
+    medium_node_cnt = node_cnt;
+    medium_collisions = collisions;
+
+    for (i = 0; i < node_cnt; i++) {
+        node = nodes[i];
+        node->idx = i;
+        node->addr[0] = i;
+        node->addr[1] = i >> 8;
+        node->addr[5] = 0x5a;
+        node->adv_timer.fn = medium_adv_event;
+        node->adv_timer.arg = node;
+    }
+
+    return 0;
+}
+
+const struct medium_stats *
+medium_stats(void)
+{
+    return &medium_stat;
+}
@@ -0,0 +1,108 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_MESH_SIM_MEDIUM_
+#define H_MESH_SIM_MEDIUM_
+
+/*
+ * Simulated controllers and the radio between them.  Each node gets a
+ * minimal HCI controller that answers the host's commands, and advertises
+ * and scans on a shared medium.  The medium carries legacy non-connectable
+ * advertising only:
+ *  - an advertising event is one transmission, sent every advertising
+ *    interval plus a random advDelay of 0-10 ms;
+ *  - scanners listen all the time, on every channel;
+ *  - a transmission reaches the transmitter's link neighbours after the
+ *    link latency, unless lost on the link, overlapping another reception
+ *    (collision) or overlapping the receiver's own transmission (busy).
+ */
+
+#include <stdint.h>
+#include "sim.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MEDIUM_ADV_DATA_MAX     31
+
+struct medium_rx;
+
+/** A link from a node to a neighbour in its radio range. */
+struct medium_link {
+    uint16_t nbr;
+    /** Loss probability, 0 to 1. */
+    float loss;
+    uint32_t latency_us;
+};
+
+/** The controller and radio of one node. */
+struct medium_node {
+    const struct sim_node_api *api;
+    uint16_t idx;
+    uint8_t addr[6];
+
+    /* Advertising */
+    uint8_t adv_enabled;
+    uint16_t adv_itvl;
+    uint8_t adv_data[MEDIUM_ADV_DATA_MAX];
+    uint8_t adv_data_len;
+    struct sim_timer adv_timer;
+
+    uint8_t scan_enabled;
+
+    /* End of the current transmission */
+    uint64_t tx_end;
+
+    /* Receptions in the air */
+    struct medium_rx *rx_list;
+
+    struct medium_link *links;
+    uint16_t link_cnt;
+};
+
+struct medium_stats {
+    /** Advertising events sent. */
+    uint64_t tx;
+    /** Advertising reports delivered to hosts. */
+    uint64_t rx;
+    uint64_t lost;
+    uint64_t collided;
+    uint64_t busy;
+    /** Transmissions that reached a node that wasn't scanning. */
+    uint64_t not_scanning;
+};
+
+/** Creates the medium for node_cnt nodes, with no links. */
+int medium_init(struct medium_node **nodes, uint16_t node_cnt,
+                int collisions);
+
+/** Links two nodes, in both directions. */
+int medium_link(uint16_t a, uint16_t b, float loss, uint32_t latency_us);
+
+/** Handles an HCI command from the node's host. */
+void medium_hci_cmd(struct medium_node *node, const uint8_t *cmd);
+
+const struct medium_stats *medium_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
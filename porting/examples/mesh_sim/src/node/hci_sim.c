@@ -0,0 +1,197 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include "syscfg/syscfg.h"
+#include "sysinit/sysinit.h"
+#include "os/os_mempool.h"
+#include "nimble/ble.h"
+#include "nimble/ble_hci_trans.h"
+#include "nimble/hci_common.h"
+#include "hci_sim.h"
+
+/* Buffers for HCI commands data */
+static uint8_t trans_buf_cmd[BLE_HCI_TRANS_CMD_SZ];
+static uint8_t trans_buf_cmd_allocd;
+
+/* Buffers for HCI events data */
+static uint8_t trans_buf_evt_hi_pool_buf[ OS_MEMPOOL_BYTES(
+                                            MYNEWT_VAL(BLE_HCI_EVT_HI_BUF_COUNT),
+                                            MYNEWT_VAL(BLE_HCI_EVT_BUF_SIZE)) ];
+static struct os_mempool trans_buf_evt_hi_pool;
+static uint8_t trans_buf_evt_lo_pool_buf[ OS_MEMPOOL_BYTES(
+                                            MYNEWT_VAL(BLE_HCI_EVT_LO_BUF_COUNT),
+                                            MYNEWT_VAL(BLE_HCI_EVT_BUF_SIZE)) ];
+static struct os_mempool trans_buf_evt_lo_pool;
+
+/* Host interface */
+static ble_hci_trans_rx_cmd_fn *trans_rx_cmd_cb;
+static void *trans_rx_cmd_arg;
+
+/* Simulated controller */
+static const struct sim_ops *trans_sim_ops;
+static void *trans_sim_ctx;
+
+static uint32_t trans_evt_drops;
+
+int
+ble_hci_trans_reset(void)
+{
+    return 0;
+}
+
+void
+ble_hci_trans_cfg_hs(ble_hci_trans_rx_cmd_fn *cmd_cb, void *cmd_arg,
+                     ble_hci_trans_rx_acl_fn *acl_cb, void *acl_arg)
+{
+    trans_rx_cmd_cb = cmd_cb;
+    trans_rx_cmd_arg = cmd_arg;
+}
+
+uint8_t *
+ble_hci_trans_buf_alloc(int type)
+{
+    uint8_t *buf;
+
+    switch (type) {
+    case BLE_HCI_TRANS_BUF_CMD:
+        assert(!trans_buf_cmd_allocd);
+        trans_buf_cmd_allocd = 1;
+        buf = trans_buf_cmd;
+        break;
+    case BLE_HCI_TRANS_BUF_EVT_HI:
+        buf = os_memblock_get(&trans_buf_evt_hi_pool);
+        if (buf) {
+            break;
+        }
+        /* no break */
+    case BLE_HCI_TRANS_BUF_EVT_LO:
+        buf = os_memblock_get(&trans_buf_evt_lo_pool);
+        break;
+    default:
+        assert(0);
+        buf = NULL;
+    }
+
+    return buf;
+}
+
+void
+ble_hci_trans_buf_free(uint8_t *buf)
+{
+    int rc;
+
+    if (buf == trans_buf_cmd) {
+        assert(trans_buf_cmd_allocd);
+        trans_buf_cmd_allocd = 0;
+    } else if (os_memblock_from(&trans_buf_evt_hi_pool, buf)) {
+        rc = os_memblock_put(&trans_buf_evt_hi_pool, buf);
+        assert(rc == 0);
+    } else {
+        assert(os_memblock_from(&trans_buf_evt_lo_pool, buf));
+        rc = os_memblock_put(&trans_buf_evt_lo_pool, buf);
+        assert(rc == 0);
+    }
+}
+
+int
+ble_hci_trans_hs_cmd_tx(uint8_t *cmd)
+{
+    /* The controller queues its response, so the buffer can go right away */
+    trans_sim_ops->hci_cmd(trans_sim_ctx, cmd);
+    ble_hci_trans_buf_free(cmd);
+
+    return 0;
+}
+
+int
+ble_hci_trans_hs_acl_tx(struct os_mbuf *om)
+{
+    /* Mesh nodes don't connect; the medium only carries advertising */
+    os_mbuf_free_chain(om);
+
+    return BLE_ERR_UNSUPPORTED;
+}
+
+void
+hci_sim_evt(const uint8_t *evt)
+{
+    uint8_t *buf;
+    int rc;
+
+    /* Allocate LE Advertising Report Event from lo pool only */
+    if (evt[0] == BLE_HCI_EVCODE_LE_META &&
+        evt[2] == BLE_HCI_LE_SUBEV_ADV_RPT) {
+        buf = ble_hci_trans_buf_alloc(BLE_HCI_TRANS_BUF_EVT_LO);
+    } else {
+        buf = ble_hci_trans_buf_alloc(BLE_HCI_TRANS_BUF_EVT_HI);
+    }
+
+    if (!buf) {
+        /* Skip the event if we're out of memory, like a controller would */
+        trans_evt_drops++;
+        return;
+    }
+
+    assert(evt[1] + BLE_HCI_EVENT_HDR_LEN <= MYNEWT_VAL(BLE_HCI_EVT_BUF_SIZE));
+    memcpy(buf, evt, evt[1] + BLE_HCI_EVENT_HDR_LEN);
+
+    rc = trans_rx_cmd_cb(buf, trans_rx_cmd_arg);
+    if (rc != 0) {
+        ble_hci_trans_buf_free(buf);
+    }
+}
+
+uint32_t
+hci_sim_evt_drops(void)
+{
+    return trans_evt_drops;
+}
+
+int
+hci_sim_init(const struct sim_ops *ops, void *ctx)
+{
+    int rc;
+
+    trans_sim_ops = ops;
+    trans_sim_ctx = ctx;
+    trans_buf_cmd_allocd = 0;
+
+    rc = os_mempool_init(&trans_buf_evt_hi_pool,
+                         MYNEWT_VAL(BLE_HCI_EVT_HI_BUF_COUNT),
+                         MYNEWT_VAL(BLE_HCI_EVT_BUF_SIZE),
+                         trans_buf_evt_hi_pool_buf,
+                         "sim_hci_evt_hi_pool");
+    if (rc != 0) {
+        return rc;
+    }
+
+    rc = os_mempool_init(&trans_buf_evt_lo_pool,
+                         MYNEWT_VAL(BLE_HCI_EVT_LO_BUF_COUNT),
+                         MYNEWT_VAL(BLE_HCI_EVT_BUF_SIZE),
+                         trans_buf_evt_lo_pool_buf,
+                         "sim_hci_evt_lo_pool");
+    if (rc != 0) {
+        return rc;
+    }
+
+    return 0;
+}
@@ -0,0 +1,43 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_HCI_SIM_
+#define H_HCI_SIM_
+
+#include <stdint.h>
+#include "sim.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Sends the host's HCI commands to the simulated controller */
+int hci_sim_init(const struct sim_ops *ops, void *ctx);
+
+/* Passes an HCI event from the simulated controller to the host */
+void hci_sim_evt(const uint8_t *evt);
+
+/* Advertising reports dropped for lack of event buffers */
+uint32_t hci_sim_evt_drops(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,330 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * One simulated mesh node: the NimBLE host and mesh stacks with a test
+ * model.  The node provisions and configures itself, then sends and
+ * receives test messages on behalf of the simulator.
+ */
+
+#include <assert.h>
+#include <string.h>
+#include "os/os.h"
+#include "nimble/nimble_port.h"
+#include "host/ble_hs.h"
+#include "mesh/mesh.h"
+#include "mesh/glue.h"
+#include "mesh/porting.h"
+#include "mesh_priv.h"
+#include "adv.h"
+#include "net.h"
+#include "transport.h"
+#include "hci_sim.h"
+
+/* Company ID */
+#define CID_VENDOR              0x05C3
+
+#define NODE_MOD_ID             0x0001
+#define NODE_OP_MSG             BT_MESH_MODEL_OP_3(0x01, CID_VENDOR)
+#define NODE_OP_MSG_LEN         3
+
+#define NODE_SEND_QUEUE_LEN     64
+
+struct node_send {
+    uint32_t id;
+    uint16_t dst;
+    uint16_t len;
+};
+
+static const struct sim_ops *node_sim_ops;
+static void *node_sim_ctx;
+static struct sim_node_cfg node_cfg;
+
+static struct ble_npl_sem node_sync_sem;
+
+static struct node_send node_send_queue[NODE_SEND_QUEUE_LEN];
+static unsigned int node_send_head;
+static unsigned int node_send_tail;
+static struct ble_npl_event node_send_ev;
+
+static uint32_t node_send_fail;
+
+static struct bt_mesh_cfg_srv node_cfg_srv = {
+    .beacon = BT_MESH_BEACON_ENABLED,
+#if MYNEWT_VAL(BLE_MESH_FRIEND)
+    .frnd = BT_MESH_FRIEND_ENABLED,
+#else
+    .frnd = BT_MESH_FRIEND_NOT_SUPPORTED,
+#endif
+    .gatt_proxy = BT_MESH_GATT_PROXY_NOT_SUPPORTED,
+};
+
+static struct bt_mesh_cfg_cli node_cfg_cli;
+
+static void node_msg_rx(struct bt_mesh_model *model,
+                        struct bt_mesh_msg_ctx *ctx,
+                        struct os_mbuf *buf);
+
+static const struct bt_mesh_model_op node_vnd_ops[] = {
+    { NODE_OP_MSG, 4, node_msg_rx },
+    BT_MESH_MODEL_OP_END,
+};
+
+static struct bt_mesh_model node_root_models[] = {
+    BT_MESH_MODEL_CFG_SRV(&node_cfg_srv),
+    BT_MESH_MODEL_CFG_CLI(&node_cfg_cli),
+};
+
+static struct bt_mesh_model node_vnd_models[] = {
+    BT_MESH_MODEL_VND(CID_VENDOR, NODE_MOD_ID, node_vnd_ops, NULL, NULL),
+};
+
+static struct bt_mesh_elem node_elements[] = {
+    BT_MESH_ELEM(0, node_root_models, node_vnd_models),
+};
+
+static const struct bt_mesh_comp node_comp = {
+    .cid = CID_VENDOR,
+    .elem = node_elements,
+    .elem_count = ARRAY_SIZE(node_elements),
+};
+
+static void
+node_msg_rx(struct bt_mesh_model *model, struct bt_mesh_msg_ctx *ctx,
+            struct os_mbuf *buf)
+{
+    node_sim_ops->msg_rx(node_sim_ctx, ctx->addr, get_le32(buf->om_data),
+                         ctx->recv_ttl);
+}
+
+static int
+node_send_msg(const struct node_send *req)
+{
+    struct bt_mesh_msg_ctx ctx = {
+        .net_idx = 0,
+        .app_idx = 0,
+        .addr = req->dst,
+        .send_ttl = BT_MESH_TTL_DEFAULT,
+    };
+    struct os_mbuf *msg;
+    uint8_t *data;
+    int rc;
+
+    msg = NET_BUF_SIMPLE(NODE_OP_MSG_LEN + req->len + 4);
+    bt_mesh_model_msg_init(msg, NODE_OP_MSG);
+
+    data = net_buf_simple_add(msg, req->len);
+    memset(data, 0, req->len);
+    put_le32(data, req->id);
+
+    rc = bt_mesh_model_send(&node_vnd_models[0], &ctx, msg, NULL, NULL);
+    os_mbuf_free_chain(msg);
+
+    return rc;
+}
+
+static void
+node_send_ev_cb(struct ble_npl_event *ev)
+{
+    while (node_send_tail != node_send_head) {
+        if (node_send_msg(&node_send_queue[node_send_tail])) {
+            node_send_fail++;
+        }
+
+        node_send_tail = (node_send_tail + 1) % NODE_SEND_QUEUE_LEN;
+    }
+}
+
+static int
+node_configure(void)
+{
+    uint16_t addr = node_cfg.addr;
+    uint8_t status;
+    int rc;
+
+    node_cfg_srv.relay = node_cfg.relay ? BT_MESH_RELAY_ENABLED :
+                                          BT_MESH_RELAY_DISABLED;
+    node_cfg_srv.default_ttl = node_cfg.ttl;
+    node_cfg_srv.net_transmit = node_cfg.net_transmit;
+    node_cfg_srv.relay_retransmit = node_cfg.relay_retransmit;
+
+    rc = bt_mesh_init(BLE_OWN_ADDR_PUBLIC, NULL, &node_comp);
+    if (rc) {
+        return rc;
+    }
+
+    /* Start all nodes from the same sequence number */
+    rc = bt_mesh_provision(node_cfg.net_key, 0, 0, node_cfg.iv_index, 0,
+                           addr, node_cfg.dev_key);
+    if (rc) {
+        return rc;
+    }
+
+    /* The rest goes through the Configuration Server, over loopback */
+    rc = bt_mesh_cfg_app_key_add(0, addr, 0, 0, node_cfg.app_key, &status);
+    if (rc || status) {
+        return rc ? rc : status;
+    }
+
+    rc = bt_mesh_cfg_mod_app_bind_vnd(0, addr, addr, 0, NODE_MOD_ID,
+                                      CID_VENDOR, &status);
+    if (rc || status) {
+        return rc ? rc : status;
+    }
+
+    if (node_cfg.group) {
+        rc = bt_mesh_cfg_mod_sub_add_vnd(0, addr, addr, node_cfg.group,
+                                         NODE_MOD_ID, CID_VENDOR, &status);
+        if (rc || status) {
+            return rc ? rc : status;
+        }
+    }
+
+    return 0;
+}
+
+static void
+node_on_sync(void)
+{
+    ble_npl_sem_release(&node_sync_sem);
+}
+
+static void
+node_host_task(void *arg)
+{
+    nimble_port_run();
+}
+
+static void
+node_adv_task(void *arg)
+{
+    mesh_adv_thread(arg);
+}
+
+static void
+node_app_task(void *arg)
+{
+    ble_npl_sem_pend(&node_sync_sem, BLE_NPL_TIME_FOREVER);
+
+    node_sim_ops->ready(node_sim_ctx, node_configure());
+}
+
+static int
+node_init(const struct sim_ops *ops, void *ctx,
+          const struct sim_node_cfg *cfg)
+{
+    int rc;
+
+    node_sim_ops = ops;
+    node_sim_ctx = ctx;
+    node_cfg = *cfg;
+
+    npl_sim_init(ops);
+
+    rc = hci_sim_init(ops, ctx);
+    if (rc) {
+        return rc;
+    }
+
+    nimble_port_init();
+
+    ble_hs_cfg.sync_cb = node_on_sync;
+
+    ble_npl_sem_init(&node_sync_sem, 0);
+    ble_npl_event_init(&node_send_ev, node_send_ev_cb, NULL);
+
+    ops->task_create(node_host_task, NULL, "host");
+    ops->task_create(node_adv_task, NULL, "mesh_adv");
+    ops->task_create(node_app_task, NULL, "app");
+
+    return 0;
+}
+
+static int
+node_send(uint16_t dst, uint32_t id, uint16_t len)
+{
+    unsigned int head;
+
+    if (len < 4 || len > BT_MESH_TX_SDU_MAX - NODE_OP_MSG_LEN - 4) {
+        return BLE_HS_EINVAL;
+    }
+
+    head = (node_send_head + 1) % NODE_SEND_QUEUE_LEN;
+    if (head == node_send_tail) {
+        node_send_fail++;
+        return BLE_HS_ENOMEM;
+    }
+
+    node_send_queue[node_send_head].id = id;
+    node_send_queue[node_send_head].dst = dst;
+    node_send_queue[node_send_head].len = len;
+    node_send_head = head;
+
+    ble_npl_eventq_put(nimble_port_get_dflt_eventq(), &node_send_ev);
+
+    return 0;
+}
+
+/* Returns the most blocks ever taken from the named pool */
+static uint32_t
+node_pool_hw(const char *name)
+{
+    struct os_mempool_info omi;
+    struct os_mempool *mp;
+
+    mp = NULL;
+    while ((mp = os_mempool_info_get_next(mp, &omi)) != NULL) {
+        if (!strcmp(omi.omi_name, name)) {
+            return omi.omi_num_blocks - omi.omi_min_free;
+        }
+    }
+
+    return 0;
+}
+
+static void
+node_stats(struct sim_node_stats *stats)
+{
+    stats->net_rx = ble_mesh_stats.snet_rx;
+    stats->net_tx = ble_mesh_stats.snet_tx;
+    stats->net_cache_hit = ble_mesh_stats.snet_cache_hit;
+    stats->relay = ble_mesh_stats.srelay;
+    stats->relay_fast = ble_mesh_stats.srelay_fast;
+    stats->relay_no_buf = ble_mesh_stats.srelay_no_buf;
+    stats->replay = ble_mesh_stats.sreplay;
+    stats->seg_retransmit = ble_mesh_stats.sseg_retransmit;
+    stats->seg_tx_fail = ble_mesh_stats.sseg_tx_fail;
+    stats->rpl_hw = ble_mesh_stats.srpl_hw;
+    stats->seg_tx_hw = ble_mesh_stats.sseg_tx_hw;
+    stats->seg_rx_hw = ble_mesh_stats.sseg_rx_hw;
+    stats->frnd_queue_hw = ble_mesh_stats.sfrnd_queue_hw;
+    stats->adv_buf_hw = node_pool_hw("adv_buf_pool");
+    stats->relay_buf_hw = node_pool_hw("relay_buf_pool");
+    stats->msys_hw = node_pool_hw("msys_1");
+    stats->hci_evt_drop = hci_sim_evt_drops();
+    stats->send_fail = node_send_fail;
+}
+
+__attribute__((visibility("default")))
+const struct sim_node_api sim_node_api = {
+    .init = node_init,
+    .hci_evt = hci_sim_evt,
+    .send = node_send,
+    .stats = node_stats,
+};
@@ -0,0 +1,388 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * NPL on top of the simulator's cooperative tasks and virtual time.  Tasks
+ * only switch when they block, so no locking is needed here.
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+#include "nimble/nimble_npl.h"
+
+#define NPL_SIM_USECS_PER_TICK  1000
+
+static const struct sim_ops *npl_sim_ops;
+
+void
+npl_sim_init(const struct sim_ops *ops)
+{
+    npl_sim_ops = ops;
+}
+
+static uint64_t
+npl_sim_timeout(ble_npl_time_t ticks)
+{
+    if (ticks == BLE_NPL_TIME_FOREVER) {
+        return SIM_TIME_FOREVER;
+    }
+
+    return (uint64_t)ticks * NPL_SIM_USECS_PER_TICK;
+}
+
+bool
+ble_npl_os_started(void)
+{
+    return true;
+}
+
+void *
+ble_npl_get_current_task_id(void)
+{
+    return npl_sim_ops->task_self();
+}
+
+void
+ble_npl_eventq_init(struct ble_npl_eventq *evq)
+{
+    TAILQ_INIT(&evq->list);
+}
+
+struct ble_npl_event *
+ble_npl_eventq_get(struct ble_npl_eventq *evq, ble_npl_time_t tmo)
+{
+    struct ble_npl_event *ev;
+
+    /* The event that woke us up may be gone again */
+    ev = TAILQ_FIRST(&evq->list);
+    while (ev == NULL && tmo != 0) {
+        if (npl_sim_ops->sleep(evq, npl_sim_timeout(tmo))) {
+            break;
+        }
+        ev = TAILQ_FIRST(&evq->list);
+    }
+
+    if (ev != NULL) {
+        TAILQ_REMOVE(&evq->list, ev, next);
+        ev->queued = false;
+    }
+
+    return ev;
+}
+
+void
+ble_npl_eventq_put(struct ble_npl_eventq *evq, struct ble_npl_event *ev)
+{
+    if (ev->queued) {
+        return;
+    }
+
+    ev->queued = true;
+    TAILQ_INSERT_TAIL(&evq->list, ev, next);
+    npl_sim_ops->wakeup(evq);
+}
+
+void
+ble_npl_eventq_remove(struct ble_npl_eventq *evq,
+                      struct ble_npl_event *ev)
+{
+    if (!ev->queued) {
+        return;
+    }
+
+    TAILQ_REMOVE(&evq->list, ev, next);
+    ev->queued = false;
+}
+
+bool
+ble_npl_eventq_is_empty(struct ble_npl_eventq *evq)
+{
+    return TAILQ_EMPTY(&evq->list);
+}
+
+void
+ble_npl_event_init(struct ble_npl_event *ev, ble_npl_event_fn *fn,
+                   void *arg)
+{
+    memset(ev, 0, sizeof(*ev));
+    ev->fn = fn;
+    ev->arg = arg;
+}
+
+bool
+ble_npl_event_is_queued(struct ble_npl_event *ev)
+{
+    return ev->queued;
+}
+
+void *
+ble_npl_event_get_arg(struct ble_npl_event *ev)
+{
+    return ev->arg;
+}
+
+void
+ble_npl_event_set_arg(struct ble_npl_event *ev, void *arg)
+{
+    ev->arg = arg;
+}
+
+void
+ble_npl_event_run(struct ble_npl_event *ev)
+{
+    ev->fn(ev);
+}
+
+ble_npl_error_t
+ble_npl_mutex_init(struct ble_npl_mutex *mu)
+{
+    if (!mu) {
+        return BLE_NPL_INVALID_PARAM;
+    }
+
+    mu->owner = NULL;
+    mu->level = 0;
+
+    return BLE_NPL_OK;
+}
+
+ble_npl_error_t
+ble_npl_mutex_pend(struct ble_npl_mutex *mu, ble_npl_time_t timeout)
+{
+    void *self;
+
+    if (!mu) {
+        return BLE_NPL_INVALID_PARAM;
+    }
+
+    self = npl_sim_ops->task_self();
+
+    while (mu->level && mu->owner != self) {
+        if (timeout == 0 ||
+            npl_sim_ops->sleep(mu, npl_sim_timeout(timeout))) {
+            return BLE_NPL_TIMEOUT;
+        }
+    }
+
+    mu->owner = self;
+    mu->level++;
+
+    return BLE_NPL_OK;
+}
+
+ble_npl_error_t
+ble_npl_mutex_release(struct ble_npl_mutex *mu)
+{
+    if (!mu) {
+        return BLE_NPL_INVALID_PARAM;
+    }
+
+    if (!mu->level || mu->owner != npl_sim_ops->task_self()) {
+        return BLE_NPL_BAD_MUTEX;
+    }
+
+    if (--mu->level == 0) {
+        mu->owner = NULL;
+        npl_sim_ops->wakeup(mu);
+    }
+
+    return BLE_NPL_OK;
+}
+
+ble_npl_error_t
+ble_npl_sem_init(struct ble_npl_sem *sem, uint16_t tokens)
+{
+    if (!sem) {
+        return BLE_NPL_INVALID_PARAM;
+    }
+
+    sem->tokens = tokens;
+
+    return BLE_NPL_OK;
+}
+
+ble_npl_error_t
+ble_npl_sem_pend(struct ble_npl_sem *sem, ble_npl_time_t timeout)
+{
+    if (!sem) {
+        return BLE_NPL_INVALID_PARAM;
+    }
+
+    while (!sem->tokens) {
+        if (timeout == 0 ||
+            npl_sim_ops->sleep(sem, npl_sim_timeout(timeout))) {
+            return BLE_NPL_TIMEOUT;
+        }
+    }
+
+    sem->tokens--;
+
+    return BLE_NPL_OK;
+}
+
+ble_npl_error_t
+ble_npl_sem_release(struct ble_npl_sem *sem)
+{
+    if (!sem) {
+        return BLE_NPL_INVALID_PARAM;
+    }
+
+    sem->tokens++;
+    npl_sim_ops->wakeup(sem);
+
+    return BLE_NPL_OK;
+}
+
+uint16_t
+ble_npl_sem_get_count(struct ble_npl_sem *sem)
+{
+    return sem->tokens;
+}
+
+static void
+npl_sim_callout_fire(void *arg)
+{
+    struct ble_npl_callout *co = arg;
+
+    if (co->evq) {
+        ble_npl_eventq_put(co->evq, &co->ev);
+    } else {
+        co->ev.fn(&co->ev);
+    }
+}
+
+void
+ble_npl_callout_init(struct ble_npl_callout *co, struct ble_npl_eventq *evq,
+                     ble_npl_event_fn *ev_cb, void *ev_arg)
+{
+    memset(co, 0, sizeof(*co));
+    co->timer.fn = npl_sim_callout_fire;
+    co->timer.arg = co;
+    co->evq = evq;
+    ble_npl_event_init(&co->ev, ev_cb, ev_arg);
+}
+
+ble_npl_error_t
+ble_npl_callout_reset(struct ble_npl_callout *co, ble_npl_time_t ticks)
+{
+    uint64_t now;
+    uint64_t when;
+
+    /* Like other ports, expire on a tick boundary */
+    now = npl_sim_ops->now();
+    when = (now / NPL_SIM_USECS_PER_TICK + ticks) * NPL_SIM_USECS_PER_TICK;
+    if (when < now) {
+        when = now;
+    }
+
+    npl_sim_ops->timer_start(&co->timer, when);
+
+    return BLE_NPL_OK;
+}
+
+void
+ble_npl_callout_stop(struct ble_npl_callout *co)
+{
+    npl_sim_ops->timer_stop(&co->timer);
+}
+
+bool
+ble_npl_callout_is_active(struct ble_npl_callout *co)
+{
+    return co->timer.active;
+}
+
+ble_npl_time_t
+ble_npl_callout_get_ticks(struct ble_npl_callout *co)
+{
+    return co->timer.when / NPL_SIM_USECS_PER_TICK;
+}
+
+ble_npl_time_t
+ble_npl_callout_remaining_ticks(struct ble_npl_callout *co,
+                                ble_npl_time_t time)
+{
+    ble_npl_time_t exp;
+
+    exp = ble_npl_callout_get_ticks(co);
+    if ((ble_npl_stime_t)(exp - time) > 0) {
+        return exp - time;
+    }
+
+    return 0;
+}
+
+void
+ble_npl_callout_set_arg(struct ble_npl_callout *co, void *arg)
+{
+    co->ev.arg = arg;
+}
+
+ble_npl_time_t
+ble_npl_time_get(void)
+{
+    return npl_sim_ops->now() / NPL_SIM_USECS_PER_TICK;
+}
+
+ble_npl_error_t
+ble_npl_time_ms_to_ticks(uint32_t ms, ble_npl_time_t *out_ticks)
+{
+    *out_ticks = ms;
+
+    return BLE_NPL_OK;
+}
+
+ble_npl_error_t
+ble_npl_time_ticks_to_ms(ble_npl_time_t ticks, uint32_t *out_ms)
+{
+    *out_ms = ticks;
+
+    return BLE_NPL_OK;
+}
+
+ble_npl_time_t
+ble_npl_time_ms_to_ticks32(uint32_t ms)
+{
+    return ms;
+}
+
+uint32_t
+ble_npl_time_ticks_to_ms32(ble_npl_time_t ticks)
+{
+    return ticks;
+}
+
+void
+ble_npl_time_delay(ble_npl_time_t ticks)
+{
+    /* Nothing wakes a task sleeping on itself */
+    npl_sim_ops->sleep(npl_sim_ops->task_self(), npl_sim_timeout(ticks));
+}
+
+uint32_t
+ble_npl_hw_enter_critical(void)
+{
+    return 0;
+}
+
+void
+ble_npl_hw_exit_critical(uint32_t ctx)
+{
+}
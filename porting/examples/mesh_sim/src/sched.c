@@ -0,0 +1,323 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/queue.h>
+#include <ucontext.h>
+#include "sched.h"
+
+#define SCHED_STACK_SIZE        (256 * 1024)
+#define SCHED_SLEEP_BUCKETS     1024
+
+struct sched_task {
+    ucontext_t uc;
+    void (*fn)(void *arg);
+    void *arg;
+    const char *name;
+    void *stack;
+
+    /* Channel slept on, NULL when not sleeping */
+    const void *chan;
+    struct sim_timer timeout;
+    int timed_out;
+    int done;
+
+    TAILQ_ENTRY(sched_task) ready_next;
+    LIST_ENTRY(sched_task) sleep_next;
+};
+
+static TAILQ_HEAD(, sched_task) sched_ready = TAILQ_HEAD_INITIALIZER(sched_ready);
+static LIST_HEAD(sched_list, sched_task) sched_sleeping[SCHED_SLEEP_BUCKETS];
+
+static struct sched_task *sched_cur;
+static ucontext_t sched_uc;
+static uint64_t sched_time;
+
+/* Pending timers, a binary min-heap on (when, seq) */
+static struct sim_timer **sched_timers;
+static uint32_t sched_timers_len;
+static uint32_t sched_timers_size;
+static uint64_t sched_timer_seq;
+
+static uint64_t sched_rand_state = 1;
+
+uint64_t
+sched_now(void)
+{
+    return sched_time;
+}
+
+void
+sched_seed(uint64_t seed)
+{
+    sched_rand_state = seed ? seed : 1;
+}
+
+/* xorshift64* */
+uint32_t
+sched_rand(void)
+{
+    sched_rand_state ^= sched_rand_state >> 12;
+    sched_rand_state ^= sched_rand_state << 25;
+    sched_rand_state ^= sched_rand_state >> 27;
+
+    return (sched_rand_state * 0x2545F4914F6CDD1DULL) >> 32;
+}
+
+static int
+sched_timer_before(const struct sim_timer *a, const struct sim_timer *b)
+{
+    if (a->when != b->when) {
+        return a->when < b->when;
+    }
+
+    return a->seq < b->seq;
+}
+
+static void
+sched_timer_set(uint32_t idx, struct sim_timer *timer)
+{
+    sched_timers[idx] = timer;
+    timer->idx = idx;
+}
+
+static void
+sched_timer_sift_up(uint32_t idx)
+{
+    struct sim_timer *timer;
+    uint32_t parent;
+
+    timer = sched_timers[idx];
+    while (idx > 0) {
+        parent = (idx - 1) / 2;
+        if (!sched_timer_before(timer, sched_timers[parent])) {
+            break;
+        }
+
+        sched_timer_set(idx, sched_timers[parent]);
+        idx = parent;
+    }
+
+    sched_timer_set(idx, timer);
+}
+
+static void
+sched_timer_sift_down(uint32_t idx)
+{
+    struct sim_timer *timer;
+    uint32_t child;
+
+    timer = sched_timers[idx];
+    while ((child = idx * 2 + 1) < sched_timers_len) {
+        if (child + 1 < sched_timers_len &&
+            sched_timer_before(sched_timers[child + 1], sched_timers[child])) {
+            child++;
+        }
+
+        if (!sched_timer_before(sched_timers[child], timer)) {
+            break;
+        }
+
+        sched_timer_set(idx, sched_timers[child]);
+        idx = child;
+    }
+
+    sched_timer_set(idx, timer);
+}
+
+void
+sched_timer_stop(struct sim_timer *timer)
+{
+    struct sim_timer *moved;
+    uint32_t idx;
+
+    if (!timer->active) {
+        return;
+    }
+
+    timer->active = 0;
+    idx = timer->idx;
+    sched_timers_len--;
+    if (idx == sched_timers_len) {
+        return;
+    }
+
+    /* Move the last timer into the hole, then restore the heap order */
+    moved = sched_timers[sched_timers_len];
+    sched_timer_set(idx, moved);
+    sched_timer_sift_up(idx);
+    sched_timer_sift_down(moved->idx);
+}
+
+void
+sched_timer_start(struct sim_timer *timer, uint64_t when)
+{
+    sched_timer_stop(timer);
+
+    if (sched_timers_len == sched_timers_size) {
+        sched_timers_size = sched_timers_size ? sched_timers_size * 2 : 256;
+        sched_timers = realloc(sched_timers,
+                               sched_timers_size * sizeof(*sched_timers));
+        assert(sched_timers != NULL);
+    }
+
+    /* Never go back in time */
+    timer->when = when < sched_time ? sched_time : when;
+    timer->seq = sched_timer_seq++;
+    timer->active = 1;
+    sched_timer_set(sched_timers_len++, timer);
+    sched_timer_sift_up(timer->idx);
+}
+
+static struct sched_list *
+sched_bucket(const void *chan)
+{
+    uintptr_t key = (uintptr_t)chan;
+
+    return &sched_sleeping[(key ^ (key >> 12)) % SCHED_SLEEP_BUCKETS];
+}
+
+static void
+sched_make_ready(struct sched_task *task, int timed_out)
+{
+    LIST_REMOVE(task, sleep_next);
+    task->chan = NULL;
+    task->timed_out = timed_out;
+    TAILQ_INSERT_TAIL(&sched_ready, task, ready_next);
+}
+
+static void
+sched_task_timeout(void *arg)
+{
+    sched_make_ready(arg, 1);
+}
+
+static void
+sched_task_entry(void)
+{
+    struct sched_task *task = sched_cur;
+
+    task->fn(task->arg);
+    task->done = 1;
+}
+
+void
+sched_task_create(void (*fn)(void *), void *arg, const char *name)
+{
+    struct sched_task *task;
+
+    task = calloc(1, sizeof(*task));
+    assert(task != NULL);
+    task->stack = malloc(SCHED_STACK_SIZE);
+    assert(task->stack != NULL);
+
+    task->fn = fn;
+    task->arg = arg;
+    task->name = name;
+    task->timeout.fn = sched_task_timeout;
+    task->timeout.arg = task;
+
+    getcontext(&task->uc);
+    task->uc.uc_stack.ss_sp = task->stack;
+    task->uc.uc_stack.ss_size = SCHED_STACK_SIZE;
+    task->uc.uc_link = &sched_uc;
+    makecontext(&task->uc, sched_task_entry, 0);
+
+    TAILQ_INSERT_TAIL(&sched_ready, task, ready_next);
+}
+
+void *
+sched_task_self(void)
+{
+    return sched_cur;
+}
+
+int
+sched_sleep(const void *chan, uint64_t timeout_us)
+{
+    struct sched_task *task = sched_cur;
+
+    assert(task != NULL);
+
+    task->chan = chan;
+    LIST_INSERT_HEAD(sched_bucket(chan), task, sleep_next);
+    if (timeout_us != SIM_TIME_FOREVER) {
+        sched_timer_start(&task->timeout, sched_time + timeout_us);
+    }
+
+    swapcontext(&task->uc, &sched_uc);
+
+    return task->timed_out;
+}
+
+void
+sched_wakeup(const void *chan)
+{
+    struct sched_task *task;
+    struct sched_task *next;
+
+    for (task = LIST_FIRST(sched_bucket(chan)); task != NULL; task = next) {
+        next = LIST_NEXT(task, sleep_next);
+        if (task->chan == chan) {
+            sched_timer_stop(&task->timeout);
+            sched_make_ready(task, 0);
+        }
+    }
+}
+
+uint64_t
+sched_run(uint64_t until)
+{
+    struct sched_task *task;
+    struct sim_timer *timer;
+    uint64_t fired = 0;
+
+    for (;;) {
+        while ((task = TAILQ_FIRST(&sched_ready)) != NULL) {
+            TAILQ_REMOVE(&sched_ready, task, ready_next);
+            sched_cur = task;
+            swapcontext(&sched_uc, &task->uc);
+            sched_cur = NULL;
+
+            if (task->done) {
+                free(task->stack);
+                free(task);
+            }
+        }
+
+        if (!sched_timers_len || sched_timers[0]->when > until) {
+            break;
+        }
+
+        timer = sched_timers[0];
+        sched_timer_stop(timer);
+        sched_time = timer->when;
+        timer->fn(timer->arg);
+        fired++;
+    }
+
+    if (until != SIM_TIME_FOREVER && sched_time < until) {
+        sched_time = until;
+    }
+
+    return fired;
+}
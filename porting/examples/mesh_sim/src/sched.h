@@ -0,0 +1,59 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_MESH_SIM_SCHED_
+#define H_MESH_SIM_SCHED_
+
+/*
+ * Discrete event scheduler.  Tasks of all nodes are coroutines that run one
+ * at a time until they sleep, so no locking is needed anywhere; time only
+ * advances when every task is asleep.  Timer callbacks run outside of tasks
+ * and must not sleep.
+ */
+
+#include <stdint.h>
+#include "sim.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint64_t sched_now(void);
+void sched_task_create(void (*fn)(void *), void *arg, const char *name);
+void *sched_task_self(void);
+int sched_sleep(const void *chan, uint64_t timeout_us);
+void sched_wakeup(const void *chan);
+void sched_timer_start(struct sim_timer *timer, uint64_t when);
+void sched_timer_stop(struct sim_timer *timer);
+
+/** Seeds the simulation's random numbers; the same seed replays a run. */
+void sched_seed(uint64_t seed);
+uint32_t sched_rand(void);
+
+/**
+ * Runs tasks and timers until virtual time reaches until, or until there is
+ * nothing left to do.  Returns the number of timers fired.
+ */
+uint64_t sched_run(uint64_t until);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,157 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_MESH_SIM_
+#define H_MESH_SIM_
+
+/*
+ * Interface between the simulator and the nodes it runs.
+ *
+ * Each node is a separately loaded copy of mesh_node.so, i.e. of the NimBLE
+ * host and mesh stacks, so every node has its own copy of their global
+ * state.  The simulator owns virtual time, the tasks of all nodes and the
+ * radio medium; the node's NPL port and HCI transport call into it through
+ * struct sim_ops.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SIM_TIME_FOREVER        UINT64_MAX
+
+/**
+ * A one-shot timer in virtual time; embedded by the user.  Timers expiring
+ * at the same time fire in the order they were started.
+ */
+struct sim_timer {
+    uint64_t when;
+    void (*fn)(void *arg);
+    void *arg;
+
+    /* Owned by the scheduler */
+    uint64_t seq;
+    uint32_t idx;
+    uint8_t active;
+};
+
+/** Simulator services, handed to a node when it is created. */
+struct sim_ops {
+    /** Virtual time in microseconds. */
+    uint64_t (*now)(void);
+
+    /** Starts a task; it runs when the node's creator returns. */
+    void (*task_create)(void (*fn)(void *), void *arg, const char *name);
+
+    /** Returns the running task, NULL outside of tasks. */
+    void *(*task_self)(void);
+
+    /**
+     * Blocks the running task until wakeup() is called on chan or until
+     * timeout_us elapse.  Returns 0 when woken, 1 on timeout.
+     */
+    int (*sleep)(const void *chan, uint64_t timeout_us);
+
+    /** Makes every task sleeping on chan runnable. */
+    void (*wakeup)(const void *chan);
+
+    void (*timer_start)(struct sim_timer *timer, uint64_t when);
+    void (*timer_stop)(struct sim_timer *timer);
+
+    /** Passes an HCI command packet to the node's controller. */
+    void (*hci_cmd)(void *ctx, const uint8_t *cmd);
+
+    /** Called once the node is provisioned and configured. */
+    void (*ready)(void *ctx, int status);
+
+    /** Called when the node's test model receives a message. */
+    void (*msg_rx)(void *ctx, uint16_t src, uint32_t id, uint8_t recv_ttl);
+};
+
+/** How a node is provisioned and configured. */
+struct sim_node_cfg {
+    uint8_t net_key[16];
+    uint8_t app_key[16];
+    uint8_t dev_key[16];
+    uint32_t iv_index;
+    uint16_t addr;
+
+    /** Group address the test model subscribes to, 0 for none. */
+    uint16_t group;
+
+    uint8_t relay;
+    uint8_t ttl;
+
+    /** Network and relay retransmissions, in BT_MESH_TRANSMIT() format. */
+    uint8_t net_transmit;
+    uint8_t relay_retransmit;
+};
+
+/** Counters and high-water marks of a node. */
+struct sim_node_stats {
+    uint32_t net_rx;
+    uint32_t net_tx;
+    uint32_t net_cache_hit;
+    uint32_t relay;
+    uint32_t relay_fast;
+    uint32_t relay_no_buf;
+    uint32_t replay;
+    uint32_t seg_retransmit;
+    uint32_t seg_tx_fail;
+    uint32_t rpl_hw;
+    uint32_t seg_tx_hw;
+    uint32_t seg_rx_hw;
+    uint32_t frnd_queue_hw;
+    uint32_t adv_buf_hw;
+    uint32_t relay_buf_hw;
+    uint32_t msys_hw;
+    uint32_t hci_evt_drop;
+    uint32_t send_fail;
+};
+
+/** Entry points of a node, exported by mesh_node.so as "sim_node_api". */
+struct sim_node_api {
+    /**
+     * Initializes the stacks and starts the node's tasks.  ctx is passed
+     * back to every sim_ops callback that takes one.
+     */
+    int (*init)(const struct sim_ops *ops, void *ctx,
+                const struct sim_node_cfg *cfg);
+
+    /** Delivers an HCI event packet from the controller to the host. */
+    void (*hci_evt)(const uint8_t *evt);
+
+    /**
+     * Sends a test message of len bytes (at least 4), carrying id, to dst.
+     * The message is sent from the node's host task.
+     */
+    int (*send)(uint16_t dst, uint32_t id, uint16_t len);
+
+    void (*stats)(struct sim_node_stats *stats);
+};
+
+#define SIM_NODE_API_SYM        "sim_node_api"
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
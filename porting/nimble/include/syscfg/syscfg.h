@@ -377,6 +377,18 @@
 #endif
 
 /*** nimble */
+#ifndef MYNEWT_VAL_BLE_AES
+#define MYNEWT_VAL_BLE_AES (1)
+#endif
+
+#ifndef MYNEWT_VAL_BLE_AES_NI
+#define MYNEWT_VAL_BLE_AES_NI (0)
+#endif
+
+#ifndef MYNEWT_VAL_BLE_AES_TABLE
+#define MYNEWT_VAL_BLE_AES_TABLE (0)
+#endif
+
 #ifndef MYNEWT_VAL_BLE_EXT_ADV
 #define MYNEWT_VAL_BLE_EXT_ADV (0)
 #endif
@@ -389,10 +401,18 @@
 #define MYNEWT_VAL_BLE_MAX_CONNECTIONS (1)
 #endif
 
+#ifndef MYNEWT_VAL_BLE_MAX_PERIODIC_SYNCS
+#define MYNEWT_VAL_BLE_MAX_PERIODIC_SYNCS (1)
+#endif
+
 #ifndef MYNEWT_VAL_BLE_MULTI_ADV_INSTANCES
 #define MYNEWT_VAL_BLE_MULTI_ADV_INSTANCES (0)
 #endif
 
+#ifndef MYNEWT_VAL_BLE_PERIODIC_ADV
+#define MYNEWT_VAL_BLE_PERIODIC_ADV (0)
+#endif
+
 #ifndef MYNEWT_VAL_BLE_ROLE_BROADCASTER
 #define MYNEWT_VAL_BLE_ROLE_BROADCASTER (1)
 #endif
@@ -478,6 +498,26 @@
 #define MYNEWT_VAL_BLE_ATT_SVR_WRITE_NO_RSP (1)
 #endif
 
+#ifndef MYNEWT_VAL_BLE_EATT_CHAN_NUM
+#define MYNEWT_VAL_BLE_EATT_CHAN_NUM (0)
+#endif
+
+#ifndef MYNEWT_VAL_BLE_EATT_MTU
+#define MYNEWT_VAL_BLE_EATT_MTU (128)
+#endif
+
+#ifndef MYNEWT_VAL_BLE_GAP_CONNQ_MAX
+#define MYNEWT_VAL_BLE_GAP_CONNQ_MAX (0)
+#endif
+
+#ifndef MYNEWT_VAL_BLE_GAP_WL_CACHE_SIZE
+#define MYNEWT_VAL_BLE_GAP_WL_CACHE_SIZE (8)
+#endif
+
+#ifndef MYNEWT_VAL_BLE_GATT_CACHE
+#define MYNEWT_VAL_BLE_GATT_CACHE (0)
+#endif
+
 #ifndef MYNEWT_VAL_BLE_GATT_DISC_ALL_CHRS
 #define MYNEWT_VAL_BLE_GATT_DISC_ALL_CHRS (MYNEWT_VAL_BLE_ROLE_CENTRAL)
 #endif
@@ -558,6 +598,10 @@
 #define MYNEWT_VAL_BLE_GATT_WRITE_NO_RSP (MYNEWT_VAL_BLE_ROLE_CENTRAL)
 #endif
 
+#ifndef MYNEWT_VAL_BLE_GATT_WRITE_NO_RSP_MAX_PENDING
+#define MYNEWT_VAL_BLE_GATT_WRITE_NO_RSP_MAX_PENDING (4)
+#endif
+
 #ifndef MYNEWT_VAL_BLE_GATT_WRITE_RELIABLE
 #define MYNEWT_VAL_BLE_GATT_WRITE_RELIABLE (MYNEWT_VAL_BLE_ROLE_CENTRAL)
 #endif
@@ -574,10 +618,18 @@
 #define MYNEWT_VAL_BLE_HS_FLOW_CTRL (0)
 #endif
 
+#ifndef MYNEWT_VAL_BLE_HS_FLOW_CTRL_CONN_BUF_MAX
+#define MYNEWT_VAL_BLE_HS_FLOW_CTRL_CONN_BUF_MAX (0)
+#endif
+
 #ifndef MYNEWT_VAL_BLE_HS_FLOW_CTRL_ITVL
 #define MYNEWT_VAL_BLE_HS_FLOW_CTRL_ITVL (1000)
 #endif
 
+#ifndef MYNEWT_VAL_BLE_HS_FLOW_CTRL_ITVL_MIN
+#define MYNEWT_VAL_BLE_HS_FLOW_CTRL_ITVL_MIN (100)
+#endif
+
 #ifndef MYNEWT_VAL_BLE_HS_FLOW_CTRL_THRESH
 #define MYNEWT_VAL_BLE_HS_FLOW_CTRL_THRESH (2)
 #endif
@@ -706,6 +758,10 @@
 #define MYNEWT_VAL_BLE_STORE_MAX_CCCDS (8)
 #endif
 
+#ifndef MYNEWT_VAL_BLE_STORE_MAX_GATT_CACHE
+#define MYNEWT_VAL_BLE_STORE_MAX_GATT_CACHE (192)
+#endif
+
 /*** nimble/host/services/ans */
 #ifndef MYNEWT_VAL_BLE_SVC_ANS_NEW_ALERT_CAT
 #define MYNEWT_VAL_BLE_SVC_ANS_NEW_ALERT_CAT (0)